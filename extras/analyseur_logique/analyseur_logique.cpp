@@ -0,0 +1,253 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : analyseur_logique.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Outil PC de conversion des captures de l'analyseur logique embarqué (voir src/Analyseur_Logique.h)
+ *
+ *  Compilation : g++ -std=c++11 -O2 -o analyseur_logique analyseur_logique.cpp
+ *
+ *  Utilisation :
+ *      analyseur_logique resume capture.bin             durée, changements par GPIO, pertes, octets par changement
+ *      analyseur_logique vcd    capture.bin sortie.vcd  conversion en fichier VCD (GTKWave, PulseView) : un signal
+ *                                                       par GPIO capturée, plus un signal "perte" à 1 entre le dernier
+ *                                                       changement reçu avant une perte et la synchronisation qui la suit
+ *
+ *  La capture est le flux binaire envoyé par Analyseur_Tache (capturé depuis le port série).
+ * =============================================================================================================================================
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ##########################################################################################################################
+//                                     DEFINE ET TYPES
+// ##########################################################################################################################
+
+// Format du flux (identique à src/Analyseur_Logique.h)
+#define ANALYSEUR_TAILLE_ENTETE 14
+#define BIT_ANALYSEUR_MULTIPLE  7
+#define BIT_ANALYSEUR_NB_DELAI  4
+#define ANALYSEUR_CODE_XOR      0
+#define ANALYSEUR_CODE_SYNCHRO  1
+#define ANALYSEUR_CODE_TEMPS    2
+#define ANALYSEUR_CODE_FIN      3
+
+// Durée d'un cycle CPU (80 MHz) en unités VCD de 100 ps
+#define UNITES_VCD_PAR_CYCLE 125
+
+typedef struct{
+  uint64_t temps;     // ticks depuis le début de la capture
+  uint16_t etat;
+  bool synchro;       // changements perdus avant cet état
+} Changement;
+
+typedef struct{
+  uint8_t mode;
+  uint16_t masque;
+  uint32_t cycles_par_tick;
+  uint16_t etat_initial;
+  std::vector<Changement> changements;
+  uint64_t duree;     // ticks
+  bool fin;           // enregistrement de fin reçu
+  size_t octets;      // taille des enregistrements
+} Capture;
+
+// ##########################################################################################################################
+//                                      FONCTIONS
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Lire_Capture
+  DESCRIPTION   : Charge et décode une capture
+  PARAMETRES    : Chemin du fichier, capture à remplir
+  RETOUR        : false si le fichier est illisible ou mal formé
+===============================================================================*/
+static bool Lire_Capture(const char *chemin, Capture &capture)
+{
+    FILE *fichier = fopen(chemin,"rb");
+    std::vector<uint8_t> flux;
+    uint8_t bloc[4096];
+    size_t lus;
+
+    if (fichier == NULL)
+    {
+        fprintf(stderr,"%s : impossible d'ouvrir le fichier\n",chemin);
+        return false;
+    }
+    while ((lus = fread(bloc,1,sizeof(bloc),fichier)) > 0) flux.insert(flux.end(),bloc,bloc + lus);
+    fclose(fichier);
+
+    // recherche de l'en-tête (le flux série peut contenir du texte avant la capture)
+    size_t i = 0;
+    while (i + ANALYSEUR_TAILLE_ENTETE <= flux.size() && memcmp(&flux[i],"ALG1",4) != 0) i++;
+    if (i + ANALYSEUR_TAILLE_ENTETE > flux.size())
+    {
+        fprintf(stderr,"%s : en-tete ALG1 introuvable\n",chemin);
+        return false;
+    }
+    const uint8_t *e = &flux[i];
+    capture.mode            = e[4];
+    capture.masque          = e[6] | (e[7] << 8);
+    capture.cycles_par_tick = e[8] | (e[9] << 8) | (e[10] << 16) | ((uint32_t)e[11] << 24);
+    capture.etat_initial    = e[12] | (e[13] << 8);
+    capture.changements.clear();
+    capture.duree = 0;
+    capture.fin = false;
+    i += ANALYSEUR_TAILLE_ENTETE;
+    capture.octets = flux.size() - i;
+
+    uint64_t temps = 0;
+    uint16_t etat = capture.etat_initial;
+    while (i < flux.size() && !capture.fin)
+    {
+        uint8_t tete = flux[i++];
+        bool special = (tete >> BIT_ANALYSEUR_MULTIPLE) & 1;
+        uint8_t nb_delai = (tete >> BIT_ANALYSEUR_NB_DELAI) & 0x7;
+        uint8_t code = tete & 0xF;
+        uint8_t nb_valeur = (special && (code == ANALYSEUR_CODE_XOR || code == ANALYSEUR_CODE_SYNCHRO)) ? 2 : 0;
+
+        if (nb_delai > 4 || (special && code > ANALYSEUR_CODE_FIN))
+        {
+            fprintf(stderr,"%s : enregistrement invalide (octet %zu)\n",chemin,i - 1);
+            return false;
+        }
+        if (i + nb_delai + nb_valeur > flux.size())
+        {
+            fprintf(stderr,"%s : capture tronquee\n",chemin);
+            break;
+        }
+
+        uint32_t delai = 0;
+        for (uint8_t n = 0; n < nb_delai; n++) delai |= (uint32_t)flux[i++] << (8 * n);
+        temps += delai;
+        uint16_t valeur = nb_valeur ? (flux[i] | (flux[i + 1] << 8)) : 0;
+        i += nb_valeur;
+
+        Changement changement = {temps,etat,false};
+        if (!special) changement.etat = etat ^ (1 << code);
+        else if (code == ANALYSEUR_CODE_XOR) changement.etat = etat ^ valeur;
+        else if (code == ANALYSEUR_CODE_SYNCHRO) { changement.etat = valeur; changement.synchro = true; }
+        else if (code == ANALYSEUR_CODE_FIN) capture.fin = true;
+
+        if (!special || code == ANALYSEUR_CODE_XOR || code == ANALYSEUR_CODE_SYNCHRO)
+        {
+            etat = changement.etat;
+            capture.changements.push_back(changement);
+        }
+    }
+    capture.duree = temps;
+    if (!capture.fin) fprintf(stderr,"%s : enregistrement de fin absent (capture interrompue)\n",chemin);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Resumer
+  DESCRIPTION   : Affiche le résumé d'une capture
+  PARAMETRES    : Capture
+  RETOUR        : Code de retour du programme
+===============================================================================*/
+static int Resumer(const Capture &capture)
+{
+    uint32_t fronts[16] = {0};
+    uint32_t nb_synchro = 0;
+    uint16_t etat = capture.etat_initial;
+
+    for (size_t i = 0; i < capture.changements.size(); i++)
+    {
+        uint16_t changements = capture.changements[i].etat ^ etat;
+        for (uint8_t gpio = 0; gpio < 16; gpio++) if ((changements >> gpio) & 1) fronts[gpio]++;
+        if (capture.changements[i].synchro) nb_synchro++;
+        etat = capture.changements[i].etat;
+    }
+
+    double duree_us = (double)capture.duree * capture.cycles_par_tick / 80.0;
+    printf("mode %s, %u cycles par tick, duree %.1f us\n",capture.mode ? "fronts" : "periodique",
+           capture.cycles_par_tick,duree_us);
+    printf("%zu changements, %zu octets (%.2f octets par changement), %u synchronisations apres perte\n",
+           capture.changements.size(),capture.octets,
+           capture.changements.empty() ? 0.0 : (double)capture.octets / capture.changements.size(),nb_synchro);
+    for (uint8_t gpio = 0; gpio < 16; gpio++)
+    {
+        if ((capture.masque >> gpio) & 1) printf("  GPIO%-2u : etat initial %u, %u fronts\n",gpio,(capture.etat_initial >> gpio) & 1,fronts[gpio]);
+    }
+    return 0;
+}
+
+/*===============================================================================
+  FONCTION      : Ecrire_VCD
+  DESCRIPTION   : Convertit une capture en fichier VCD
+  PARAMETRES    : Capture, chemin du fichier VCD
+  RETOUR        : Code de retour du programme
+===============================================================================*/
+static int Ecrire_VCD(const Capture &capture, const char *chemin)
+{
+    FILE *fichier = fopen(chemin,"w");
+    uint64_t unites_par_tick = (uint64_t)capture.cycles_par_tick * UNITES_VCD_PAR_CYCLE;
+
+    if (fichier == NULL)
+    {
+        fprintf(stderr,"%s : impossible de creer le fichier\n",chemin);
+        return 2;
+    }
+
+    // Signaux : '!' + n° de la GPIO, '~' pour la perte
+    fprintf(fichier,"$timescale 100 ps $end\n$scope module esp8266 $end\n");
+    for (uint8_t gpio = 0; gpio < 16; gpio++)
+    {
+        if ((capture.masque >> gpio) & 1) fprintf(fichier,"$var wire 1 %c GPIO%u $end\n",'!' + gpio,gpio);
+    }
+    fprintf(fichier,"$var wire 1 ~ perte $end\n$upscope $end\n$enddefinitions $end\n");
+
+    fprintf(fichier,"#0\n$dumpvars\n");
+    for (uint8_t gpio = 0; gpio < 16; gpio++)
+    {
+        if ((capture.masque >> gpio) & 1) fprintf(fichier,"%u%c\n",(capture.etat_initial >> gpio) & 1,'!' + gpio);
+    }
+    bool perte = !capture.changements.empty() && capture.changements[0].synchro;
+    fprintf(fichier,"%u~\n$end\n",perte ? 1 : 0);
+
+    uint16_t etat = capture.etat_initial;
+    for (size_t i = 0; i < capture.changements.size(); i++)
+    {
+        const Changement &changement = capture.changements[i];
+        fprintf(fichier,"#%llu\n",(unsigned long long)(changement.temps * unites_par_tick));
+        for (uint8_t gpio = 0; gpio < 16; gpio++)
+        {
+            if (((changement.etat ^ etat) >> gpio) & 1) fprintf(fichier,"%u%c\n",(changement.etat >> gpio) & 1,'!' + gpio);
+        }
+        // perte à 1 du dernier changement reçu jusqu'à la synchronisation qui suit la perte
+        bool suivant_synchro = (i + 1 < capture.changements.size()) && capture.changements[i + 1].synchro;
+        if (suivant_synchro != perte)
+        {
+            perte = suivant_synchro;
+            fprintf(fichier,"%u~\n",perte ? 1 : 0);
+        }
+        etat = changement.etat;
+    }
+    fprintf(fichier,"#%llu\n",(unsigned long long)(capture.duree * unites_par_tick));
+    fclose(fichier);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    Capture capture;
+
+    if (argc < 3 || (strcmp(argv[1],"resume") != 0 && strcmp(argv[1],"vcd") != 0) ||
+        (strcmp(argv[1],"vcd") == 0 && argc < 4))
+    {
+        fprintf(stderr,"utilisation : %s resume capture.bin\n"
+                       "              %s vcd capture.bin sortie.vcd\n",argv[0],argv[0]);
+        return 2;
+    }
+    if (!Lire_Capture(argv[2],capture)) return 2;
+
+    if (strcmp(argv[1],"resume") == 0) return Resumer(capture);
+    return Ecrire_VCD(capture,argv[3]);
+}
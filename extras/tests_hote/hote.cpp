@@ -0,0 +1,736 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : hote.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Environnement de test sur PC : registres projetés en mémoire, compteur de cycles, interruptions et flash simulés
+ *  (voir hote.h)
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "GPIO_esp8266.h"
+#include "TIMER_esp8266.h"
+#include "UART_esp8266.h"
+#include <stdlib.h>
+#include <sys/mman.h>
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Zones de registres projetées
+#define HOTE_ZONE_PERIPH 0x60000000
+#define HOTE_ZONE_DPORT  0x3FF00000
+#define HOTE_TAILLE_ZONE 0x2000
+
+volatile uint32 hote_cycles = 0;
+uint32 hote_pas_cycles = 0;
+void (*hote_crochet_cycles)(void) = NULL;
+
+volatile uint32 hote_gpio_externe = 0xFFFFFFFF;
+static uint32 hote_gpio_precedent = 0xFFFFFFFF;
+
+volatile bool hote_timer1_arme = false;
+volatile uint32 hote_timer1_echeance = 0;
+
+// Modèle de l'UART0
+#define HOTE_TAILLE_LIGNE_UART (1 << 20)
+
+bool hote_uart0_cts_bloque = false;
+bool hote_uart0_ignorer_rts = false;
+uint32 hote_uart0_debordements = 0;
+
+static struct{
+  bool actif;
+  uint8 rx[UART_TAILLE_FIFO];
+  uint16 rx_lecture;
+  uint16 rx_nb;
+  uint8 tx[UART_TAILLE_FIFO];
+  uint16 tx_lecture;
+  uint16 tx_nb;
+  bool reception;                          // octet en cours de réception
+  uint8 octet_recu;
+  uint32 fin_reception;
+  bool timeout_arme;                       // octet reçu depuis le dernier timeout
+  uint32 dernier_octet;                    // fin du dernier octet reçu (timeout)
+  bool emission;                           // octet en cours d'émission
+  uint8 octet_emis;
+  uint32 fin_emission;
+  bool cts_precedent;
+  uint8 entree[HOTE_TAILLE_LIGNE_UART];    // octets du correspondant à envoyer
+  uint32 entree_lecture;
+  uint32 entree_nb;
+  uint8 sortie[HOTE_TAILLE_LIGNE_UART];    // octets émis par l'UART0
+  uint32 sortie_lecture;
+  uint32 sortie_nb;
+} hote_uart0;
+
+uint32 hote_pas_simulation = 8;
+void (*hote_crochet_simulation)(void) = NULL;
+void (*hote_crochet_ecriture)(__Registre *registre, uint32 valeur) = NULL;
+bool (*hote_crochet_lecture)(__Registre *registre, uint32 *valeur) = NULL;
+
+int_handler_t hote_interruptions[32];
+void *hote_arguments[32];
+volatile uint32 hote_masque_actif = 0;
+volatile uint32 hote_niveau = 0;
+volatile bool hote_dans_interruption = false;
+uint32 hote_erreurs_verrou = 0;
+uint32 hote_latence_timer1 = 0;
+static uint32 hote_graine = 1;
+
+uint8 hote_flash[HOTE_TAILLE_FLASH];
+int32 hote_flash_budget = -1;
+uint32 hote_flash_nb_effacements = 0;
+uint32 hote_flash_nb_ecritures = 0;
+
+uint32 hote_nb_verifications = 0;
+uint32 hote_nb_echecs = 0;
+
+// ##########################################################################################################################
+//                                      FONCTIONS HOTE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Hote_Projeter
+  DESCRIPTION   : Projette une zone de registres à son adresse fixe
+  PARAMETRES    : Adresse de la zone
+  RETOUR        : rien (quitte le programme en cas d'échec)
+===============================================================================*/
+static void Hote_Projeter(uintptr_t adresse)
+{
+    void *zone = mmap((void *)adresse,HOTE_TAILLE_ZONE,PROT_READ | PROT_WRITE,MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+    if (zone == MAP_FAILED)
+    {
+        printf("Impossible de projeter les registres en 0x%08lx\n",(unsigned long)adresse);
+        exit(2);
+    }
+    memset(zone,0,HOTE_TAILLE_ZONE);
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Init
+  DESCRIPTION   : Projette les zones de registres, remet à zéro la simulation
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Init()
+{
+    Hote_Projeter(HOTE_ZONE_PERIPH);
+    Hote_Projeter(HOTE_ZONE_DPORT);
+
+    hote_cycles = 0;
+    hote_pas_cycles = 0;
+    hote_crochet_cycles = NULL;
+    hote_gpio_externe = 0xFFFFFFFF;
+    hote_gpio_precedent = 0xFFFFFFFF;
+    hote_timer1_arme = false;
+    hote_pas_simulation = 8;
+    hote_crochet_simulation = NULL;
+    hote_crochet_ecriture = NULL;
+    hote_crochet_lecture = NULL;
+    memset(hote_interruptions,0,sizeof(hote_interruptions));
+    memset(hote_arguments,0,sizeof(hote_arguments));
+    hote_masque_actif = 0;
+    hote_niveau = 0;
+    hote_dans_interruption = false;
+    hote_erreurs_verrou = 0;
+    hote_latence_timer1 = 0;
+    hote_uart0.actif = false;
+
+    memset(hote_flash,0xFF,sizeof(hote_flash));
+    hote_flash_budget = -1;
+    hote_flash_nb_effacements = 0;
+    hote_flash_nb_ecritures = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Lire_Compteur_Cycles
+  DESCRIPTION   : Remplace la lecture de CCOUNT (voir Lire_Compteur_Cycles)
+  PARAMETRES    : rien
+  RETOUR        : Compteur de cycles simulé
+===============================================================================*/
+uint32 Hote_Lire_Compteur_Cycles()
+{
+    uint32 cycles = hote_cycles;
+    hote_cycles = cycles + hote_pas_cycles;
+    if (hote_crochet_cycles != NULL) hote_crochet_cycles();
+    return cycles;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Avancer_Cycles
+  DESCRIPTION   : Avance le compteur de cycles simulé
+  PARAMETRES    : Nombre de cycles
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Avancer_Cycles(uint32 cycles)
+{
+    hote_cycles = hote_cycles + cycles;
+}
+
+// ##########################################################################################################################
+//                                      MODELE DES PERIPHERIQUES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Hote_GPIO_Niveaux
+  DESCRIPTION   : Niveau des lignes GPIO : une sortie active au niveau bas tire la ligne,
+                  sinon le niveau est celui imposé par l'extérieur
+  PARAMETRES    : rien
+  RETOUR        : Niveaux (bit n : GPIOn)
+===============================================================================*/
+uint32 Hote_GPIO_Niveaux()
+{
+    return hote_gpio_externe & ~(Registre_GPIO->ENABLE & ~Registre_GPIO->OUT);
+}
+
+/*===============================================================================
+  FONCTION      : Hote_GPIO_Evaluer
+  DESCRIPTION   : Met à jour GPIO->IN et positionne GPIO->STATUS selon le type
+                  d'interruption de chaque GPIO (front ou niveau)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Hote_GPIO_Evaluer()
+{
+    uint32 niveaux = Hote_GPIO_Niveaux();
+    uint32 fronts = niveaux ^ hote_gpio_precedent;
+
+    for (uint8 gpio = 0; gpio < sizeof(Registre_GPIO->PIN) / sizeof(__Registre); gpio++)
+    {
+        uint8 type = (Registre_GPIO->PIN[gpio] >> BIT_GPIO_INT_TYPE) & 0x7;
+        bool niveau = READ_BIT(niveaux,gpio);
+        bool front = READ_BIT(fronts,gpio);
+        bool declenche = false;
+
+        switch (type)
+        {
+            case FRONT_MONTANT    : declenche = front && niveau;  break;
+            case FRONT_DESCENDANT : declenche = front && !niveau; break;
+            case FRONT_DOUBLE     : declenche = front;            break;
+            case LOW_LEVEL        : declenche = !niveau;          break;
+            case HIGH_LEVEL       : declenche = niveau;           break;
+            default : break;
+        }
+        if (declenche) SET_BIT(Registre_GPIO->STATUS,gpio);
+    }
+
+    Registre_GPIO->IN = niveaux;
+    hote_gpio_precedent = niveaux;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Cycles_Octet
+  DESCRIPTION   : Durée d'un octet sur la ligne (start, données, parité, stop)
+  PARAMETRES    : rien
+  RETOUR        : Durée (cycles)
+===============================================================================*/
+static uint32 Hote_UART0_Cycles_Octet()
+{
+    uint32 conf0 = Registre_UART0->CONF0;
+    uint32 diviseur = Registre_UART0->CLKDIV & 0xFFFFF;
+    uint32 nb_bits = 1 + 5 + ((conf0 >> BIT_UART_NBDATA) & 0x3) + ((conf0 >> BIT_UART_PARITY_EN) & 0x1)
+                   + ((((conf0 >> BIT_UART_STOPBIT) & 0x3) >= STOP_15) ? 2 : 1);
+
+    return nb_bits * ((diviseur == 0) ? 1 : diviseur);
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_RTS
+  DESCRIPTION   : Etat de la ligne RTS : relâchée lorsque la fifo RX atteint le seuil RX_FLOW_THRHD
+  PARAMETRES    : rien
+  RETOUR        : true si le correspondant est autorisé à envoyer
+===============================================================================*/
+bool Hote_UART0_RTS()
+{
+    uint32 conf1 = Registre_UART0->CONF1;
+
+    if (!READ_BIT(conf1,BIT_UART_RX_FLOW_EN)) return true;
+    return hote_uart0.rx_nb < ((conf1 >> BIT_UART_RX_FLOW_THRHD) & 0x7F);
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Etat
+  DESCRIPTION   : Met à jour STATUS (nombre d'octets des fifos, CTS, RTS), INT_RAW et INT_ST
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Hote_UART0_Etat()
+{
+    UART_Struct *uart = Registre_UART0;
+    uint32 conf1 = uart->CONF1;
+    uint32 status = uart->STATUS & ~((0xFF << BIT_UART_TXFIFO_CNT) | (0xFF << BIT_UART_RXFIFO_CNT)
+                                     | (1 << BIT_UART_LEVEL_CTSN) | (1 << BIT_UART_LEVEL_RTSN));
+
+    status |= ((uint32)hote_uart0.tx_nb << BIT_UART_TXFIFO_CNT) | ((uint32)hote_uart0.rx_nb << BIT_UART_RXFIFO_CNT);
+    if (hote_uart0_cts_bloque) status |= (1 << BIT_UART_LEVEL_CTSN);
+    if (!Hote_UART0_RTS()) status |= (1 << BIT_UART_LEVEL_RTSN);
+    uart->STATUS = status;
+
+    if (hote_uart0.rx_nb >= ((conf1 >> BIT_UART_RXFIFO_FULL_THRHD) & 0x7F)) uart->INT_RAW |= (1 << BIT_UART_INT_RXFIFO_FULL);
+    if (hote_uart0.tx_nb < ((conf1 >> BIT_UART_TXFIFO_EMPTY_THRHD) & 0x7F)) uart->INT_RAW |= (1 << BIT_UART_INT_TXFIFO_EMPTY);
+    if (hote_uart0_cts_bloque != hote_uart0.cts_precedent)
+    {
+        hote_uart0.cts_precedent = hote_uart0_cts_bloque;
+        uart->INT_RAW |= (1 << BIT_UART_INT_CTS_CHG);
+    }
+    // timeout : fifo RX non vide et ligne inactive pendant RX_TOUT_THRHD octets
+    if (READ_BIT(conf1,BIT_UART_RX_TOUT_EN) && hote_uart0.timeout_arme && hote_uart0.rx_nb > 0 && !hote_uart0.reception
+        && hote_cycles - hote_uart0.dernier_octet >= ((conf1 >> BIT_UART_RX_TOUT_THRHD) & 0x7F) * Hote_UART0_Cycles_Octet())
+    {
+        hote_uart0.timeout_arme = false;
+        uart->INT_RAW |= (1 << BIT_UART_INT_RXFIFO_TOUT);
+    }
+    uart->INT_ST = uart->INT_RAW & uart->INT_ENA;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Lire_Fifo
+  DESCRIPTION   : Lecture du registre FIFO : retire un octet de la fifo RX
+  PARAMETRES    : rien
+  RETOUR        : Octet (0 si la fifo est vide)
+===============================================================================*/
+static uint32 Hote_UART0_Lire_Fifo()
+{
+    uint32 octet = 0;
+
+    if (hote_uart0.rx_nb > 0)
+    {
+        octet = hote_uart0.rx[hote_uart0.rx_lecture];
+        hote_uart0.rx_lecture = (hote_uart0.rx_lecture + 1) % UART_TAILLE_FIFO;
+        hote_uart0.rx_nb--;
+    }
+    Hote_UART0_Etat();
+    return octet;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Ecrire
+  DESCRIPTION   : Ecriture d'un registre de l'UART0 : FIFO (fifo TX), INT_CLR (acquittement),
+                  CONF0 (reset des fifos)
+  PARAMETRES    : Registre, valeur
+  RETOUR        : rien
+===============================================================================*/
+static void Hote_UART0_Ecrire(__Registre *Registre, uint32 valeur)
+{
+    UART_Struct *uart = Registre_UART0;
+
+    if (Registre == &uart->FIFO)
+    {
+        if (hote_uart0.tx_nb < UART_TAILLE_FIFO)
+        {
+            hote_uart0.tx[(hote_uart0.tx_lecture + hote_uart0.tx_nb) % UART_TAILLE_FIFO] = valeur & 0xFF;
+            hote_uart0.tx_nb++;
+        }
+    }
+    else if (Registre == &uart->INT_CLR)
+    {
+        uart->INT_RAW &= ~valeur;
+    }
+    else
+    {
+        *(volatile __Registre *)Registre = valeur;
+        if (Registre == &uart->CONF0 && READ_BIT(valeur,BIT_UART_RXFIFO_RST)) hote_uart0.rx_nb = 0;
+        if (Registre == &uart->CONF0 && READ_BIT(valeur,BIT_UART_TXFIFO_RST)) hote_uart0.tx_nb = 0;
+    }
+    Hote_UART0_Etat();
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Simuler
+  DESCRIPTION   : Un pas de simulation de l'UART0 : réception des octets du correspondant
+                  (suspendue par RTS), émission des octets de la fifo TX (suspendue par CTS)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Hote_UART0_Simuler()
+{
+    uint32 cycles_octet = Hote_UART0_Cycles_Octet();
+
+    // Réception
+    if (hote_uart0.reception && (int32)(hote_cycles - hote_uart0.fin_reception) >= 0)
+    {
+        hote_uart0.reception = false;
+        if (hote_uart0.rx_nb == UART_TAILLE_FIFO)
+        {
+            Registre_UART0->INT_RAW |= (1 << BIT_UART_INT_RXFIFO_OVF);
+            hote_uart0_debordements++;
+        }
+        else
+        {
+            hote_uart0.rx[(hote_uart0.rx_lecture + hote_uart0.rx_nb) % UART_TAILLE_FIFO] = hote_uart0.octet_recu;
+            hote_uart0.rx_nb++;
+        }
+        hote_uart0.dernier_octet = hote_uart0.fin_reception;
+        hote_uart0.timeout_arme = true;
+    }
+    if (!hote_uart0.reception && hote_uart0.entree_nb > 0 && (Hote_UART0_RTS() || hote_uart0_ignorer_rts))
+    {
+        hote_uart0.octet_recu = hote_uart0.entree[hote_uart0.entree_lecture];
+        hote_uart0.entree_lecture = (hote_uart0.entree_lecture + 1) % HOTE_TAILLE_LIGNE_UART;
+        hote_uart0.entree_nb--;
+        hote_uart0.reception = true;
+        hote_uart0.fin_reception = hote_cycles + cycles_octet;
+    }
+
+    // Emission
+    if (hote_uart0.emission && (int32)(hote_cycles - hote_uart0.fin_emission) >= 0)
+    {
+        hote_uart0.emission = false;
+        if (hote_uart0.sortie_nb < HOTE_TAILLE_LIGNE_UART)
+        {
+            hote_uart0.sortie[(hote_uart0.sortie_lecture + hote_uart0.sortie_nb) % HOTE_TAILLE_LIGNE_UART] = hote_uart0.octet_emis;
+            hote_uart0.sortie_nb++;
+        }
+    }
+    if (!hote_uart0.emission && hote_uart0.tx_nb > 0
+        && !(READ_BIT(Registre_UART0->CONF0,BIT_UART_TX_FLOW_EN) && hote_uart0_cts_bloque))
+    {
+        hote_uart0.octet_emis = hote_uart0.tx[hote_uart0.tx_lecture];
+        hote_uart0.tx_lecture = (hote_uart0.tx_lecture + 1) % UART_TAILLE_FIFO;
+        hote_uart0.tx_nb--;
+        hote_uart0.emission = true;
+        hote_uart0.fin_emission = hote_cycles + cycles_octet;
+    }
+
+    Hote_UART0_Etat();
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Activer
+  DESCRIPTION   : Active le modèle de l'UART0 (fifos vides, correspondant silencieux)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Hote_UART0_Activer()
+{
+    memset(&hote_uart0,0,sizeof(hote_uart0));
+    hote_uart0_cts_bloque = false;
+    hote_uart0_ignorer_rts = false;
+    hote_uart0_debordements = 0;
+    hote_uart0.actif = true;
+    Hote_UART0_Etat();
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Envoyer
+  DESCRIPTION   : Octets envoyés par le correspondant (reçus au débit de l'UART pendant Hote_Simuler)
+  PARAMETRES    : Données, nombre d'octets
+  RETOUR        : rien
+===============================================================================*/
+void Hote_UART0_Envoyer(const void *donnees, uint32 taille)
+{
+    const uint8 *octets = (const uint8 *)donnees;
+
+    for (uint32 i = 0; i < taille && hote_uart0.entree_nb < HOTE_TAILLE_LIGNE_UART; i++)
+    {
+        hote_uart0.entree[(hote_uart0.entree_lecture + hote_uart0.entree_nb) % HOTE_TAILLE_LIGNE_UART] = octets[i];
+        hote_uart0.entree_nb++;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_A_Envoyer
+  DESCRIPTION   : Nombre d'octets du correspondant pas encore envoyés
+  PARAMETRES    : rien
+  RETOUR        : Nombre d'octets
+===============================================================================*/
+uint32 Hote_UART0_A_Envoyer()
+{
+    return hote_uart0.entree_nb + hote_uart0.reception;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Recevoir
+  DESCRIPTION   : Octets émis par l'UART0 (retirés de la réception du correspondant)
+  PARAMETRES    : Buffer, taille du buffer
+  RETOUR        : Nombre d'octets copiés
+===============================================================================*/
+uint32 Hote_UART0_Recevoir(void *donnees, uint32 taille)
+{
+    uint8 *octets = (uint8 *)donnees;
+    uint32 nb = 0;
+
+    while (nb < taille && hote_uart0.sortie_nb > 0)
+    {
+        octets[nb++] = hote_uart0.sortie[hote_uart0.sortie_lecture];
+        hote_uart0.sortie_lecture = (hote_uart0.sortie_lecture + 1) % HOTE_TAILLE_LIGNE_UART;
+        hote_uart0.sortie_nb--;
+    }
+    return nb;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Lire_Registre
+  DESCRIPTION   : Lecture d'un registre (REGISTRE_LIRE compilé avec ESP8266_HOTE)
+  PARAMETRES    : Registre
+  RETOUR        : Valeur lue
+===============================================================================*/
+uint32 Hote_Lire_Registre(__Registre *Registre)
+{
+    uint32 valeur;
+
+    if (Registre == &Registre_GPIO->IN)
+    {
+        if (hote_crochet_simulation != NULL) hote_crochet_simulation();
+        Hote_GPIO_Evaluer();
+    }
+    if (Registre == &Registre_UART0->FIFO && hote_uart0.actif)
+    {
+        valeur = Hote_UART0_Lire_Fifo();
+    }
+    else
+    {
+        if (Registre >= &Registre_UART0->FIFO && Registre <= &Registre_UART0->ID && hote_uart0.actif) Hote_UART0_Etat();
+        valeur = *(volatile __Registre *)Registre;
+    }
+    if (hote_crochet_lecture != NULL) hote_crochet_lecture(Registre,&valeur);
+    return valeur;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Ecrire_Registre
+  DESCRIPTION   : Ecriture d'un registre (REGISTRE_ECRIRE compilé avec ESP8266_HOTE)
+                  Les registres W1TS / W1TC des GPIO modifient le registre associé
+  PARAMETRES    : Registre, valeur
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Ecrire_Registre(__Registre *Registre, uint32 valeur)
+{
+    GPIO_Struct *gpio = Registre_GPIO;
+
+    if      (Registre == &gpio->OUT_W1TS)    gpio->OUT |= valeur;
+    else if (Registre == &gpio->OUT_W1TC)    gpio->OUT &= ~valeur;
+    else if (Registre == &gpio->ENABLE_W1TS) gpio->ENABLE |= valeur;
+    else if (Registre == &gpio->ENABLE_W1TC) gpio->ENABLE &= ~valeur;
+    else if (Registre == &gpio->STATUS_W1TS) gpio->STATUS |= valeur;
+    else if (Registre == &gpio->STATUS_W1TC) gpio->STATUS &= ~valeur;
+    else if (Registre >= &Registre_UART0->FIFO && Registre <= &Registre_UART0->ID && hote_uart0.actif) Hote_UART0_Ecrire(Registre,valeur);
+    else *(volatile __Registre *)Registre = valeur;
+
+    // TIMER1 : le chargement du compteur programme l'interruption
+    if (Registre == &Registre_TIMER1->LOAD_ADDRESS)
+    {
+        uint32 division = (Registre_TIMER1->CTRL_ADDRESS >> BIT_TIMER_DIV) & 0x3;
+        uint32 prediviseur = (division == 0) ? 1 : ((division == 1) ? 16 : 256);
+        hote_timer1_echeance = hote_cycles + valeur * prediviseur;
+        if (hote_latence_timer1 > 0)
+        {
+            hote_graine = hote_graine * 1103515245 + 12345;
+            hote_timer1_echeance += (hote_graine >> 8) % (hote_latence_timer1 + 1);
+        }
+        hote_timer1_arme = true;
+    }
+
+    if (hote_crochet_ecriture != NULL) hote_crochet_ecriture(Registre,valeur);
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Traiter_Interruptions
+  DESCRIPTION   : Appelle les interruptions GPIO et TIMER1 en attente
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Traiter_Interruptions()
+{
+    if (hote_dans_interruption) return;
+
+    for (uint8 n = 0; n < 8; n++)
+    {
+        bool appel = false;
+
+        Hote_GPIO_Evaluer();
+        if ((Registre_GPIO->STATUS & 0xFFFF) != 0)
+        {
+            appel |= Hote_Declencher(ETS_GPIO_INUM);
+        }
+
+        if (hote_timer1_arme && READ_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN)
+            && (int32)(hote_cycles - hote_timer1_echeance) >= 0
+            && (hote_masque_actif & (1 << ETS_FRC_TIMER1_INUM)) && hote_niveau == 0)
+        {
+            hote_timer1_arme = false; // mode monocoup
+            appel |= Hote_Declencher(ETS_FRC_TIMER1_INUM);
+        }
+
+        if (hote_uart0.actif)
+        {
+            Hote_UART0_Etat();
+            if (Registre_UART0->INT_ST != 0) appel |= Hote_Declencher(ETS_UART_INUM);
+        }
+
+        if (!appel) break;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Simuler
+  DESCRIPTION   : Fait avancer le temps par pas et traite les interruptions
+  PARAMETRES    : Durée simulée (cycles)
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Simuler(uint32 cycles)
+{
+    for (uint32 ecoule = 0; ecoule < cycles; ecoule += hote_pas_simulation)
+    {
+        Hote_Avancer_Cycles(hote_pas_simulation);
+        if (hote_uart0.actif) Hote_UART0_Simuler();
+        if (hote_crochet_simulation != NULL) hote_crochet_simulation();
+        Hote_Traiter_Interruptions();
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Declencher
+  DESCRIPTION   : Appelle la fonction attachée à une interruption
+  PARAMETRES    : N° de l'interruption
+  RETOUR        : false si l'interruption n'a pas été appelée
+===============================================================================*/
+bool Hote_Declencher(uint8 inum)
+{
+    bool imbrication = hote_dans_interruption;
+    uint32 niveau = hote_niveau;
+
+    if (hote_interruptions[inum] == NULL) return false;
+    if ((hote_masque_actif & (1 << inum)) == 0) return false;
+    if (niveau > 0) return false;
+
+    // les interruptions des périphériques sont de niveau 1 : le niveau est rétabli à la sortie
+    hote_dans_interruption = true;
+    hote_niveau = 1;
+    hote_interruptions[inum](hote_arguments[inum]);
+    hote_niveau = niveau;
+    hote_dans_interruption = imbrication;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Verifier
+  DESCRIPTION   : Compte une vérification, affiche un échec
+  PARAMETRES    : Résultat, texte de la condition, fichier, ligne
+  RETOUR        : Résultat
+===============================================================================*/
+bool Hote_Verifier(bool resultat, const char *condition, const char *fichier, int ligne)
+{
+    hote_nb_verifications++;
+    if (!resultat)
+    {
+        hote_nb_echecs++;
+        if (hote_nb_echecs <= 20) printf("  ECHEC %s:%d : %s\n",fichier,ligne,condition);
+    }
+    return resultat;
+}
+
+/*===============================================================================
+  FONCTION      : Hote_Bilan
+  DESCRIPTION   : Affiche le bilan des vérifications
+  PARAMETRES    : Nom du test
+  RETOUR        : Code de sortie (0 : succès)
+===============================================================================*/
+int Hote_Bilan(const char *nom)
+{
+    printf("%s : %u verifications, %u echec(s)\n",nom,hote_nb_verifications,hote_nb_echecs);
+    return (hote_nb_echecs == 0) ? 0 : 1;
+}
+
+// ##########################################################################################################################
+//                                      SDK SIMULE
+// ##########################################################################################################################
+
+void ets_isr_attach(int i, int_handler_t func, void *arg)
+{
+    hote_interruptions[i & 31] = func;
+    hote_arguments[i & 31] = arg;
+}
+
+void ets_isr_mask(unsigned mask)
+{
+    hote_masque_actif &= ~mask;
+}
+
+void ets_isr_unmask(unsigned mask)
+{
+    hote_masque_actif |= mask;
+}
+
+// Sur la cible, ETS_INTR_UNLOCK rétablit le niveau 0 quel que soit l'état précédent :
+// dans une interruption ou sans LOCK préalable, c'est une erreur
+void ets_intr_lock()
+{
+    hote_niveau = 3;
+}
+
+void ets_intr_unlock()
+{
+    if (hote_dans_interruption || hote_niveau != 3) hote_erreurs_verrou++;
+    hote_niveau = 0;
+}
+
+// Section critique imbricable (rsil 15 / wsr ps)
+uint32 Hote_Masquer_Interruptions()
+{
+    uint32 etat = hote_niveau;
+    hote_niveau = 15;
+    return etat;
+}
+
+void Hote_Restaurer_Interruptions(uint32 etat)
+{
+    hote_niveau = etat;
+}
+
+// Flash NOR : l'effacement met les octets à 0xFF, l'écriture ne peut que passer des bits à 0.
+// Quand le budget d'opérations est épuisé, l'opération est interrompue (coupure d'alimentation) :
+// une écriture n'est faite qu'à moitié, un effacement laisse le secteur partiellement effacé
+static bool Hote_Flash_Alimentee()
+{
+    if (hote_flash_budget == 0) return false;
+    if (hote_flash_budget > 0) hote_flash_budget--;
+    return true;
+}
+
+extern "C" {
+
+SpiFlashOpResult spi_flash_erase_sector(uint16_t sec)
+{
+    uint32 adresse = (uint32)sec * SPI_FLASH_SEC_SIZE;
+
+    if (adresse + SPI_FLASH_SEC_SIZE > HOTE_TAILLE_FLASH) return SPI_FLASH_RESULT_ERR;
+    if (!Hote_Flash_Alimentee())
+    {
+        memset(&hote_flash[adresse],0xFF,SPI_FLASH_SEC_SIZE / 2);
+        return SPI_FLASH_RESULT_ERR;
+    }
+    memset(&hote_flash[adresse],0xFF,SPI_FLASH_SEC_SIZE);
+    hote_flash_nb_effacements++;
+    return SPI_FLASH_RESULT_OK;
+}
+
+SpiFlashOpResult spi_flash_write(uint32_t des_addr, uint32_t *src_addr, uint32_t size)
+{
+    const uint8 *source = (const uint8 *)src_addr;
+    uint32 taille = size;
+
+    if ((des_addr & 3) || (size & 3) || des_addr + size > HOTE_TAILLE_FLASH) return SPI_FLASH_RESULT_ERR;
+    if (!Hote_Flash_Alimentee()) taille = (size / 2) & ~3;
+    for (uint32 i = 0; i < taille; i++) hote_flash[des_addr + i] &= source[i];
+    if (taille != size) return SPI_FLASH_RESULT_ERR;
+    hote_flash_nb_ecritures++;
+    return SPI_FLASH_RESULT_OK;
+}
+
+SpiFlashOpResult spi_flash_read(uint32_t src_addr, uint32_t *des_addr, uint32_t size)
+{
+    if (src_addr + size > HOTE_TAILLE_FLASH) return SPI_FLASH_RESULT_ERR;
+    memcpy(des_addr,&hote_flash[src_addr],size);
+    return SPI_FLASH_RESULT_OK;
+}
+
+}
+
+/* fin du fichier */
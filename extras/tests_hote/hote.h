@@ -0,0 +1,206 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : hote.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Environnement de test sur PC (Linux) des fichiers de src/, compilés avec ESP8266_HOTE :
+ *
+ *  - les zones de registres (0x60000000 et 0x3FF00000) sont projetées en mémoire (mmap) : les registres sont de simples variables,
+ *    les accès REGISTRE_LIRE / REGISTRE_ECRIRE passent par un modèle des périphériques :
+ *      GPIO   : registres W1TS / W1TC, niveau des lignes = ET câblé entre les sorties et hote_gpio_externe
+ *               (ligne tirée au niveau haut par défaut), interruptions sur front ou niveau (GPIO->PIN)
+ *      TIMER1 : l'écriture de LOAD programme l'interruption (compteur de cycles + ticks x prédiviseur)
+ *      UART0  : (après Hote_UART0_Activer) fifos RX / TX vidées et remplies au débit programmé (CLKDIV, CONF0),
+ *               interruptions RXFIFO_FULL, RXFIFO_TOUT, RXFIFO_OVF, TXFIFO_EMPTY, CTS_CHG, contrôle de flux RTS / CTS
+ *    les autres registres sont de la mémoire (crochets optionnels pour simuler un périphérique)
+ *  - le compteur de cycles (Lire_Compteur_Cycles) est simulé : hote_cycles, avancé par le test
+ *    (ou automatiquement de hote_pas_cycles à chaque lecture, avec un crochet optionnel pour simuler un périphérique)
+ *  - les fonctions du SDK (ets_*, spi_flash_*) sont simulées : interruptions attachées, masques, niveau d'interruption,
+ *    flash de 4 Mo en RAM avec coupure d'alimentation simulée
+ *  - Hote_Simuler fait avancer le temps par pas (hote_pas_simulation) et déclenche les interruptions TIMER1, GPIO et UART0
+ *
+ *  Chaque test (test_xxx.cpp) indique les fichiers de src/ qu'il utilise sur sa ligne "Sources :"
+ *  (et ses options de compilation éventuelles sur une ligne "Options :", ex. -DCACHE_REGISTRES)
+ *  Lancement de tous les tests : ./lancer_tests.sh
+ * =============================================================================================================================================
+ */
+
+#ifndef __HOTE_H__
+#define __HOTE_H__
+
+#include <stdio.h>
+#include <string.h>
+#include "ets_sys.h"
+#include "spi_flash.h"
+#include "registres_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Taille de la flash simulée
+#define HOTE_TAILLE_FLASH (4 * 1024 * 1024)
+
+// Compteur de cycles simulé
+extern volatile uint32 hote_cycles;
+extern uint32 hote_pas_cycles;             // avance du compteur à chaque lecture (0 : figé)
+extern void (*hote_crochet_cycles)(void);  // appelé à chaque lecture du compteur (NULL : aucun)
+
+// Modèle des GPIO
+extern volatile uint32 hote_gpio_externe;  // niveau imposé par l'extérieur (bit à 0 : ligne tirée au niveau bas)
+
+// Modèle du TIMER1
+extern volatile bool hote_timer1_arme;
+extern volatile uint32 hote_timer1_echeance;
+
+// Modèle de l'UART0 (correspondant : octets envoyés par Hote_UART0_Envoyer, reçus par Hote_UART0_Recevoir)
+extern bool hote_uart0_cts_bloque;         // le correspondant bloque l'émission (CTS)
+extern bool hote_uart0_ignorer_rts;        // le correspondant continue d'envoyer malgré RTS relâché
+extern uint32 hote_uart0_debordements;     // octets perdus (fifo RX pleine)
+
+// Simulation
+extern uint32 hote_pas_simulation;                                       // pas de Hote_Simuler (cycles)
+extern void (*hote_crochet_simulation)(void);                            // appelé à chaque pas et à chaque lecture de GPIO->IN
+extern void (*hote_crochet_ecriture)(__Registre *registre, uint32 valeur); // appelé après chaque écriture de registre
+extern bool (*hote_crochet_lecture)(__Registre *registre, uint32 *valeur); // true : valeur lue remplacée
+
+// Interruptions simulées
+extern int_handler_t hote_interruptions[32];
+extern void *hote_arguments[32];
+extern volatile uint32 hote_masque_actif;  // interruptions démasquées (ets_isr_unmask)
+extern volatile uint32 hote_niveau;        // niveau d'interruption du processeur (PS.INTLEVEL) : 0 hors interruption,
+                                           // 1 dans une interruption, 3 après ETS_INTR_LOCK, 15 après Masquer_Interruptions
+extern volatile bool hote_dans_interruption;
+extern uint32 hote_erreurs_verrou;         // ETS_INTR_UNLOCK dans une interruption ou sans LOCK
+extern uint32 hote_latence_timer1;         // retard aléatoire maximal de l'interruption du TIMER1 (cycles)
+
+// Flash simulée
+extern uint8 hote_flash[HOTE_TAILLE_FLASH];
+extern int32 hote_flash_budget;            // opérations avant coupure d'alimentation (-1 : pas de coupure)
+extern uint32 hote_flash_nb_effacements;
+extern uint32 hote_flash_nb_ecritures;
+
+// Résultat des vérifications
+extern uint32 hote_nb_verifications;
+extern uint32 hote_nb_echecs;
+
+// Vérifie une condition : l'échec est compté et affiché (fichier, ligne, condition)
+#define HOTE_VERIFIER(condition) Hote_Verifier((condition),#condition,__FILE__,__LINE__)
+
+// ##########################################################################################################################
+//                                      FONCTIONS HOTE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Hote_Init
+  DESCRIPTION   : Projette les zones de registres en mémoire (remplies de 0),
+                  remet à zéro le compteur de cycles, les interruptions et la flash (0xFF)
+  PARAMETRES    : rien
+  RETOUR        : rien (quitte le programme si la projection échoue)
+===============================================================================*/
+void Hote_Init();
+
+/*===============================================================================
+  FONCTION      : Hote_Avancer_Cycles
+  DESCRIPTION   : Avance le compteur de cycles simulé
+  PARAMETRES    : Nombre de cycles
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Avancer_Cycles(uint32 cycles);
+
+/*===============================================================================
+  FONCTION      : Hote_GPIO_Niveaux
+  DESCRIPTION   : Niveau des lignes GPIO (sorties actives ET niveau extérieur)
+  PARAMETRES    : rien
+  RETOUR        : Niveaux (bit n : GPIOn)
+===============================================================================*/
+uint32 Hote_GPIO_Niveaux();
+
+/*===============================================================================
+  FONCTION      : Hote_Traiter_Interruptions
+  DESCRIPTION   : Détecte les fronts des GPIO, puis appelle les interruptions GPIO et TIMER1
+                  en attente (si elles sont démasquées et hors verrouillage)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Traiter_Interruptions();
+
+/*===============================================================================
+  FONCTION      : Hote_Simuler
+  DESCRIPTION   : Fait avancer le temps par pas de hote_pas_simulation cycles :
+                  à chaque pas, appelle hote_crochet_simulation puis Hote_Traiter_Interruptions
+  PARAMETRES    : Durée simulée (cycles)
+  RETOUR        : rien
+===============================================================================*/
+void Hote_Simuler(uint32 cycles);
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Activer
+  DESCRIPTION   : Active le modèle de l'UART0 (fifos vides, correspondant silencieux)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Hote_UART0_Activer();
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Envoyer
+  DESCRIPTION   : Octets envoyés par le correspondant (reçus au débit de l'UART pendant Hote_Simuler)
+  PARAMETRES    : Données, nombre d'octets
+  RETOUR        : rien
+===============================================================================*/
+void Hote_UART0_Envoyer(const void *donnees, uint32 taille);
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_A_Envoyer
+  DESCRIPTION   : Nombre d'octets du correspondant pas encore envoyés
+  PARAMETRES    : rien
+  RETOUR        : Nombre d'octets
+===============================================================================*/
+uint32 Hote_UART0_A_Envoyer();
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_Recevoir
+  DESCRIPTION   : Octets émis par l'UART0 (retirés de la réception du correspondant)
+  PARAMETRES    : Buffer, taille du buffer
+  RETOUR        : Nombre d'octets copiés
+===============================================================================*/
+uint32 Hote_UART0_Recevoir(void *donnees, uint32 taille);
+
+/*===============================================================================
+  FONCTION      : Hote_UART0_RTS
+  DESCRIPTION   : Etat de la ligne RTS de l'UART0
+  PARAMETRES    : rien
+  RETOUR        : true si le correspondant est autorisé à envoyer
+===============================================================================*/
+bool Hote_UART0_RTS();
+
+/*===============================================================================
+  FONCTION      : Hote_Declencher
+  DESCRIPTION   : Appelle la fonction attachée à une interruption (comme le ferait le CPU)
+  PARAMETRES    : N° de l'interruption (ETS_xxx_INUM)
+  RETOUR        : false si aucune fonction n'est attachée ou si l'interruption est masquée / verrouillée
+===============================================================================*/
+bool Hote_Declencher(uint8 inum);
+
+/*===============================================================================
+  FONCTION      : Hote_Verifier
+  DESCRIPTION   : Compte une vérification (voir HOTE_VERIFIER)
+  PARAMETRES    : Résultat, texte de la condition, fichier, ligne
+  RETOUR        : Résultat
+===============================================================================*/
+bool Hote_Verifier(bool resultat, const char *condition, const char *fichier, int ligne);
+
+/*===============================================================================
+  FONCTION      : Hote_Bilan
+  DESCRIPTION   : Affiche le bilan des vérifications du test
+  PARAMETRES    : Nom du test
+  RETOUR        : Code de sortie du programme (0 : succès)
+===============================================================================*/
+int Hote_Bilan(const char *nom);
+
+#endif
+
+/* fin du fichier */
@@ -0,0 +1,43 @@
+#!/bin/sh
+# =============================================================================================================================================
+#  Titre    : lancer_tests.sh
+#  Auteur   : Thomas Broussard
+#  Projet   : Industrialisation ESP8266
+#  Création : Octobre 2018
+#  --------------------------------------------------------------------------------------------------------------------------------------------
+#  Description :
+#  1. vérifie que tous les fichiers de src/ compilent (en-têtes du SDK remplacés par sdk/, sans ESP8266_HOTE)
+#  2. compile et lance chaque test_xxx.cpp avec hote.cpp et les fichiers de src/ indiqués sur sa ligne "Sources :"
+#     (options de compilation supplémentaires sur sa ligne "Options :", facultative)
+#
+#  Usage : ./lancer_tests.sh [test_xxx ...]     (tous les tests par défaut)
+# =============================================================================================================================================
+
+cd "$(dirname "$0")" || exit 1
+
+SRC=../../src
+CXX=${CXX:-g++}
+OPTIONS="-std=c++11 -O2 -Wall -Wno-unused-parameter -Wno-unused-function -Wno-unused-variable"
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+resultat=0
+
+for f in "$SRC"/*.cpp; do
+  $CXX -std=c++11 -fsyntax-only -Isdk -I"$SRC" "$f" || { echo "ERREUR compilation $f"; resultat=1; }
+done
+
+if [ $# -gt 0 ]; then tests="$*"; else tests=$(ls test_*.cpp | sed 's/\.cpp$//'); fi
+
+for t in $tests; do
+  t=${t%.cpp}
+  sources=""
+  for s in $(sed -n 's/^ \*  Sources *: *//p' "$t.cpp" | head -1 | tr -d '\r'); do sources="$sources $SRC/$s"; done
+  options=$(sed -n 's/^ \*  Options *: *//p' "$t.cpp" | head -1 | tr -d '\r')
+  if $CXX $OPTIONS $options -DESP8266_HOTE -Isdk -I. -I"$SRC" -o "$TMP/$t" "$t.cpp" hote.cpp $sources -lpthread; then
+    "$TMP/$t" || { echo "ECHEC $t"; resultat=1; }
+  else
+    echo "ERREUR compilation $t"; resultat=1
+  fi
+done
+
+exit $resultat
@@ -0,0 +1,52 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : ets_sys.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  En-tête du SDK remplacé pour les tests sur PC (voir hote.h) : mêmes déclarations que le SDK,
+ *  fonctions simulées dans hote.cpp
+ * =============================================================================================================================================
+ */
+
+#ifndef __ETS_SYS_H__
+#define __ETS_SYS_H__
+
+#include <stdint.h>
+
+#define ICACHE_RAM_ATTR
+#define ICACHE_FLASH_ATTR
+
+typedef void (*int_handler_t)(void *);
+
+void ets_isr_attach(int i, int_handler_t func, void *arg);
+void ets_isr_mask(unsigned mask);
+void ets_isr_unmask(unsigned mask);
+void ets_intr_lock();
+void ets_intr_unlock();
+
+#define ETS_SPI_INUM        2
+#define ETS_GPIO_INUM       4
+#define ETS_UART_INUM       5
+#define ETS_FRC_TIMER1_INUM 9
+
+#define ETS_INTR_LOCK()   ets_intr_lock()
+#define ETS_INTR_UNLOCK() ets_intr_unlock()
+
+#define ETS_INTR_ENABLE(inum)  ets_isr_unmask((1 << inum))
+#define ETS_INTR_DISABLE(inum) ets_isr_mask((1 << inum))
+
+#define ETS_FRC_TIMER1_INTR_ATTACH(func, arg) ets_isr_attach(ETS_FRC_TIMER1_INUM, (int_handler_t)(func), (void *)(arg))
+#define ETS_GPIO_INTR_ATTACH(func, arg)       ets_isr_attach(ETS_GPIO_INUM, (int_handler_t)(func), (void *)(arg))
+#define ETS_UART_INTR_ATTACH(func, arg)       ets_isr_attach(ETS_UART_INUM, (int_handler_t)(func), (void *)(arg))
+
+#define ETS_UART_INTR_ENABLE()  ETS_INTR_ENABLE(ETS_UART_INUM)
+#define ETS_UART_INTR_DISABLE() ETS_INTR_DISABLE(ETS_UART_INUM)
+#define ETS_FRC1_INTR_ENABLE()  ETS_INTR_ENABLE(ETS_FRC_TIMER1_INUM)
+#define ETS_FRC1_INTR_DISABLE() ETS_INTR_DISABLE(ETS_FRC_TIMER1_INUM)
+#define ETS_GPIO_INTR_ENABLE()  ETS_INTR_ENABLE(ETS_GPIO_INUM)
+#define ETS_GPIO_INTR_DISABLE() ETS_INTR_DISABLE(ETS_GPIO_INUM)
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : spi_flash.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  En-tête du SDK remplacé pour les tests sur PC (voir hote.h) : la flash est simulée en RAM par hote.cpp
+ * =============================================================================================================================================
+ */
+
+#ifndef __SPI_FLASH_H__
+#define __SPI_FLASH_H__
+
+#include <stdint.h>
+
+typedef enum {SPI_FLASH_RESULT_OK, SPI_FLASH_RESULT_ERR, SPI_FLASH_RESULT_TIMEOUT} SpiFlashOpResult;
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+extern "C" {
+SpiFlashOpResult spi_flash_erase_sector(uint16_t sec);
+SpiFlashOpResult spi_flash_write(uint32_t des_addr, uint32_t *src_addr, uint32_t size);
+SpiFlashOpResult spi_flash_read(uint32_t src_addr, uint32_t *des_addr, uint32_t size);
+}
+
+#endif
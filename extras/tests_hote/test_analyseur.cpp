@@ -0,0 +1,308 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_analyseur.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Analyseur_Logique.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp GPIO_esp8266.cpp UART_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de l'analyseur logique embarqué (Analyseur_Logique.h) sur PC, signaux simulés sur les GPIO,
+ *  flux reçu de l'UART0 au débit programmé et décodé selon le format de l'en-tête :
+ *  - paramètres invalides refusés, capture déjà en cours refusée
+ *  - mode périodique 100 kHz (UART 9600 bauds, PWM 1 kHz, bouton), interruption du TIMER1 retardée :
+ *    échantillons sautés comptés, chaque changement décodé daté à deux périodes près, état final exact
+ *  - mode fronts, fronts simultanés sur deux GPIO : autant de changements que de fronts, datés au cycle près
+ *    (à la latence de l'interruption près)
+ *  - débordement (liaison 115200 bauds trop lente) : pertes comptées, synchronisation, changements décodés exacts
+ *  - signal immobile 60 s (débordement du compteur de cycles) : avance du temps, front daté exactement
+ *  - débit maximal (recherche du signal carré le plus rapide sans perte, par mode et par débit de l'UART) comparé
+ *    à la limite documentée : environ 2 octets par changement en mode périodique, 3 en mode fronts
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Analyseur_Logique.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#define CYCLES_PAR_MS (ESP8266_CLOCK_FREQ / 1000)
+#define TOLERANCE_FRONTS 64
+#define DUREE_DEBIT_S 1
+
+typedef struct{
+  uint64_t date;               // cycles
+  uint16 etat;                 // état des GPIO capturées après le changement
+} Changement;
+
+// Signaux : fronts (date, GPIO) appliqués sur hote_gpio_externe au fil de la simulation
+typedef struct{
+  uint64_t date;
+  uint8 gpio;
+} Front;
+
+static std::vector<Front> fronts;
+static size_t front_suivant = 0;
+static uint64_t temps = 0;             // date courante sur 64 bits
+static uint32 derniers_cycles = 0;
+static uint16 masque_capture = 0;
+static std::vector<Changement> verite;
+static uint16 etat_depart = 0;        // état des GPIO capturées au démarrage de la capture
+
+static void Signaux()
+{
+    temps += (uint32)(hote_cycles - derniers_cycles);
+    derniers_cycles = hote_cycles;
+    uint32 avant = hote_gpio_externe & masque_capture;
+    while (front_suivant < fronts.size() && fronts[front_suivant].date <= temps)
+    {
+        hote_gpio_externe ^= (1 << fronts[front_suivant].gpio);
+        front_suivant++;
+    }
+    uint32 apres = hote_gpio_externe & masque_capture;
+    if (apres != avant) verite.push_back({temps,(uint16)apres});
+}
+
+static bool Front_Avant(const Front &a, const Front &b)
+{
+    return a.date < b.date;
+}
+
+static void UART(uint8 gpio, uint32 bauds, uint32 charge_pour_mille, uint64_t duree)
+{
+    double bit = (double)ESP8266_CLOCK_FREQ / bauds, t = 1000;
+    while (t < duree)
+    {
+        if ((uint32)(rand() % 1000) < charge_pour_mille)
+        {
+            uint16 trame = 0x200 | ((rand() & 0xFF) << 1);
+            uint8 niveau = 1;
+            for (uint8 b = 0; b < 10; b++)
+            {
+                if (((trame >> b) & 1) != niveau) { fronts.push_back({(uint64_t)(t + b * bit),gpio}); niveau ^= 1; }
+            }
+            if (niveau == 0) fronts.push_back({(uint64_t)(t + 9 * bit),gpio});
+            t += 10 * bit;
+        }
+        else
+        {
+            t += bit * (1 + rand() % 20);
+        }
+    }
+}
+
+static void Carre(uint8 gpio, uint64_t periode, uint32 rapport_pour_cent, uint64_t duree, uint64_t debut)
+{
+    for (uint64_t t = debut; t + periode <= duree; t += periode)
+    {
+        fronts.push_back({t,gpio});
+        fronts.push_back({t + periode * rapport_pour_cent / 100,gpio});
+    }
+}
+
+// Capture : signaux appliqués, Analyseur_Tache toutes les 50us, flux relevé sur l'UART0
+static std::vector<uint8> flux;
+static uint64_t debut_capture = 0;
+static bool Capturer(Analyseur_Mode mode, uint16 masque, uint32 frequence, uint32 bauds, uint64_t duree, uint32 pas_tache)
+{
+    uint8 octets[256];
+    uint32 nb;
+
+    std::sort(fronts.begin(),fronts.end(),Front_Avant);
+    hote_gpio_externe = 0xFFFFFFFF;
+    front_suivant = 0;
+    verite.clear();
+    flux.clear();
+    masque_capture = masque;
+    etat_depart = masque;
+    init_UART(UART0,bauds,DATA_8,NONE,STOP_1);
+    temps += (uint32)(hote_cycles - derniers_cycles);
+    derniers_cycles = hote_cycles;
+    for (size_t i = 0; i < fronts.size(); i++) fronts[i].date += temps;
+
+    debut_capture = temps;
+    if (!Analyseur_Demarrer(mode,masque,frequence,UART0)) return false;
+    hote_crochet_simulation = Signaux;
+    for (uint64_t fin = temps + duree; temps < fin; )
+    {
+        Hote_Simuler(pas_tache);
+        Analyseur_Tache();
+        while ((nb = Hote_UART0_Recevoir(octets,sizeof(octets))) > 0) flux.insert(flux.end(),octets,octets + nb);
+    }
+    hote_crochet_simulation = NULL;
+    Analyseur_Arreter();
+    while (Analyseur_Tache() || (REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_TXFIFO_CNT) & 0xFF)
+    {
+        Hote_Simuler(pas_tache);
+        while ((nb = Hote_UART0_Recevoir(octets,sizeof(octets))) > 0) flux.insert(flux.end(),octets,octets + nb);
+    }
+    Hote_Simuler(CYCLES_PAR_MS);
+    while ((nb = Hote_UART0_Recevoir(octets,sizeof(octets))) > 0) flux.insert(flux.end(),octets,octets + nb);
+    fronts.clear();
+    return true;
+}
+
+// Décodage du flux : changements datés en cycles depuis le début de la capture
+typedef struct{
+  bool fin;
+  uint32 nb_synchros;
+  uint32 nb_temps;
+  uint16 etat_initial;
+} Bilan_Decodage;
+
+static std::vector<Changement> Decoder(Bilan_Decodage *bilan)
+{
+    std::vector<Changement> changements;
+    memset(bilan,0,sizeof(Bilan_Decodage));
+    if (flux.size() < ANALYSEUR_TAILLE_ENTETE || memcmp(&flux[0],"ALG1",4) != 0) return changements;
+
+    uint32 cycles_par_tick = flux[8] | (flux[9] << 8) | (flux[10] << 16) | ((uint32)flux[11] << 24);
+    uint16 etat = bilan->etat_initial = flux[12] | (flux[13] << 8);
+    uint64_t ticks = 0;
+    size_t i = ANALYSEUR_TAILLE_ENTETE;
+    while (i < flux.size() && !bilan->fin)
+    {
+        uint8 tete = flux[i++];
+        uint8 nb_delai = (tete >> BIT_ANALYSEUR_NB_DELAI) & 0x7, code = tete & 0xF;
+        uint32 delai = 0;
+        for (uint8 k = 0; k < nb_delai; k++) delai |= (uint32)flux[i++] << (8 * k);
+        ticks += delai;
+        if (!(tete & (1 << BIT_ANALYSEUR_MULTIPLE))) etat ^= (1 << code);
+        else if (code == ANALYSEUR_CODE_XOR) { etat ^= flux[i] | (flux[i + 1] << 8); i += 2; }
+        else if (code == ANALYSEUR_CODE_SYNCHRO) { etat = flux[i] | (flux[i + 1] << 8); i += 2; bilan->nb_synchros++; }
+        else if (code == ANALYSEUR_CODE_TEMPS) { bilan->nb_temps++; continue; }
+        else { bilan->fin = true; continue; }
+        changements.push_back({ticks * cycles_par_tick,etat});
+    }
+    return changements;
+}
+
+// Chaque changement décodé correspond à un état réel (même état) pris à "tolerance" cycles près de sa date
+static uint32 Changements_Sans_Correspondance(const std::vector<Changement> &decodes, uint64_t tolerance)
+{
+    uint32 nb = 0;
+    for (size_t i = 0; i < decodes.size(); i++)
+    {
+        uint64_t date = debut_capture + decodes[i].date;
+        uint16 etat = etat_depart;
+        bool trouve = false;
+        for (size_t j = 0; j < verite.size() && verite[j].date <= date + tolerance && !trouve; j++)
+        {
+            if (verite[j].date + tolerance < date) etat = verite[j].etat;
+            else trouve = verite[j].etat == decodes[i].etat;
+        }
+        if (!trouve && etat != decodes[i].etat) nb++;
+    }
+    return nb;
+}
+
+// Débit maximal (changements/s) : signal carré soutenu DUREE_DEBIT_S sur la GPIO 14, le plus rapide sans changement perdu
+// (recherche dichotomique à 2% près, mode périodique échantillonné à 200 kHz)
+static uint32 Debit_Maximal(Analyseur_Mode mode, uint32 bauds)
+{
+    const Analyseur_Statistiques *stats = Analyseur_Lire_Statistiques();
+    uint32 bas = bauds / 100, haut = bauds / 5;
+    while (haut - bas > bas / 50)
+    {
+        uint32 debit = (bas + haut) / 2;
+        Carre(14,2ULL * ESP8266_CLOCK_FREQ / debit,50,DUREE_DEBIT_S * ESP8266_CLOCK_FREQ,500);
+        Capturer(mode,(1 << 14),(mode == ANALYSEUR_PERIODIQUE) ? 200000 : 0,bauds,DUREE_DEBIT_S * ESP8266_CLOCK_FREQ,50 * CYCLES_PAR_MS / 1000);
+        if (stats->nb_perdus == 0) bas = debit;
+        else haut = debit;
+    }
+    return bas;
+}
+
+int main()
+{
+    const Analyseur_Statistiques *stats = Analyseur_Lire_Statistiques();
+    Bilan_Decodage bilan;
+    std::vector<Changement> decodes;
+
+    Hote_Init();
+    Hote_UART0_Activer();
+    srand(3);
+
+    // 1. paramètres
+    HOTE_VERIFIER(!Analyseur_Demarrer(ANALYSEUR_FRONTS,0,0,UART0) && !Analyseur_Demarrer(ANALYSEUR_FRONTS,1,0,2));
+    HOTE_VERIFIER(!Analyseur_Demarrer(ANALYSEUR_PERIODIQUE,1,0,UART0) && !Analyseur_Demarrer(ANALYSEUR_PERIODIQUE,1,400000,UART0));
+    HOTE_VERIFIER(Analyseur_Demarrer(ANALYSEUR_FRONTS,1,0,UART0) && !Analyseur_Demarrer(ANALYSEUR_FRONTS,1,0,UART0));
+    Analyseur_Arreter();
+    while (Analyseur_Tache()) Hote_Simuler(CYCLES_PAR_MS);
+    Hote_Simuler(CYCLES_PAR_MS);
+    uint8 vidange[64];
+    while (Hote_UART0_Recevoir(vidange,sizeof(vidange)) > 0) {}
+
+    // 2. périodique 100 kHz, interruption du TIMER1 retardée jusqu'à 1.5 période
+    const uint32 periode = ESP8266_CLOCK_FREQ / 100000;
+    hote_pas_simulation = 40;
+    hote_latence_timer1 = periode * 3 / 2;
+    UART(3,9600,600,199 * CYCLES_PAR_MS);
+    Carre(5,CYCLES_PAR_MS,30,199 * CYCLES_PAR_MS,500);
+    Carre(0,60 * CYCLES_PAR_MS,50,200 * CYCLES_PAR_MS,1000000);
+    HOTE_VERIFIER(Capturer(ANALYSEUR_PERIODIQUE,(1 << 0) | (1 << 3) | (1 << 5),100000,921600,200 * CYCLES_PAR_MS,50 * CYCLES_PAR_MS / 1000));
+    decodes = Decoder(&bilan);
+    HOTE_VERIFIER(bilan.fin && bilan.nb_synchros == 0 && stats->nb_perdus == 0 && stats->octets_envoyes == flux.size());
+    HOTE_VERIFIER(stats->nb_retards > 0 && stats->nb_changements == decodes.size() && decodes.size() > 1000);
+    HOTE_VERIFIER(decodes.size() <= verite.size() && !decodes.empty() && decodes.back().etat == verite.back().etat);
+    HOTE_VERIFIER(Changements_Sans_Correspondance(decodes,2 * periode + hote_latence_timer1) == 0);
+    printf("analyseur : periodique 100 kHz, %u echantillons, %u retards, %u changements, %u octets (%.2f octets par changement)\n",
+           stats->nb_echantillons,stats->nb_retards,stats->nb_changements,stats->octets_envoyes,
+           (double)(stats->octets_envoyes - ANALYSEUR_TAILLE_ENTETE) / stats->nb_changements);
+
+    // 3. fronts, fronts simultanés sur les GPIO 12 et 13
+    hote_pas_simulation = 8;
+    hote_latence_timer1 = 0;
+    UART(3,115200,500,50 * CYCLES_PAR_MS);
+    Carre(5,CYCLES_PAR_MS,30,50 * CYCLES_PAR_MS,500);
+    Carre(12,CYCLES_PAR_MS,50,50 * CYCLES_PAR_MS,700);
+    Carre(13,CYCLES_PAR_MS,50,50 * CYCLES_PAR_MS,700);
+    HOTE_VERIFIER(Capturer(ANALYSEUR_FRONTS,(1 << 3) | (1 << 5) | (1 << 12) | (1 << 13),0,921600,50 * CYCLES_PAR_MS,50 * CYCLES_PAR_MS / 1000));
+    decodes = Decoder(&bilan);
+    HOTE_VERIFIER(bilan.fin && stats->nb_perdus == 0 && decodes.size() == verite.size());
+    HOTE_VERIFIER(Changements_Sans_Correspondance(decodes,TOLERANCE_FRONTS) == 0);
+    printf("analyseur : fronts, %u changements, %.2f octets par changement, buffer max %u octets\n",stats->nb_changements,
+           (double)(stats->octets_envoyes - ANALYSEUR_TAILLE_ENTETE) / stats->nb_changements,stats->remplissage_max);
+
+    // 4. débordement : signal à 50 kHz, liaison 115200 bauds
+    Carre(4,1600,50,100 * CYCLES_PAR_MS,500);
+    UART(3,9600,1000,100 * CYCLES_PAR_MS);
+    HOTE_VERIFIER(Capturer(ANALYSEUR_FRONTS,(1 << 3) | (1 << 4),0,115200,100 * CYCLES_PAR_MS,50 * CYCLES_PAR_MS / 1000));
+    decodes = Decoder(&bilan);
+    HOTE_VERIFIER(bilan.fin && stats->nb_perdus > 0 && bilan.nb_synchros > 0 && stats->remplissage_max <= ANALYSEUR_TAILLE_TAMPON);
+    HOTE_VERIFIER(Changements_Sans_Correspondance(decodes,TOLERANCE_FRONTS) == 0 && !decodes.empty() && decodes.back().etat == verite.back().etat);
+    printf("analyseur : debordement, %u changements, %u perdus, %u synchronisations\n",stats->nb_changements,stats->nb_perdus,bilan.nb_synchros);
+
+    // 5. signal immobile 60 s : le compteur de cycles (53.7 s) déborde, le front est daté exactement
+    hote_pas_simulation = 8000;
+    fronts.push_back({1000,2});
+    fronts.push_back({60ULL * ESP8266_CLOCK_FREQ,2});
+    HOTE_VERIFIER(Capturer(ANALYSEUR_FRONTS,(1 << 2),0,921600,61ULL * ESP8266_CLOCK_FREQ,CYCLES_PAR_MS));
+    decodes = Decoder(&bilan);
+    HOTE_VERIFIER(bilan.fin && bilan.nb_temps >= 4 && decodes.size() == 2 && verite.size() == 2);
+    HOTE_VERIFIER(Changements_Sans_Correspondance(decodes,hote_pas_simulation) == 0);
+
+    // 6. débit maximal : débit de l'UART (10 bits par octet) / octets par changement, une fois le buffer rempli
+    //    (le buffer absorbe ANALYSEUR_TAILLE_TAMPON octets de plus pendant la capture : retranchés)
+    hote_pas_simulation = 40;
+    static const uint32 bauds[2] = {115200,921600};
+    static const Analyseur_Mode modes[2] = {ANALYSEUR_PERIODIQUE,ANALYSEUR_FRONTS};
+    static const uint8 octets_documentes[2] = {2,3};
+    for (uint8 b = 0; b < 2; b++)
+    {
+        for (uint8 m = 0; m < 2; m++)
+        {
+            uint32 debit = Debit_Maximal(modes[m],bauds[b]);
+            uint32 soutenu = debit - ANALYSEUR_TAILLE_TAMPON / (DUREE_DEBIT_S * octets_documentes[m]);
+            uint32 documente = bauds[b] / 10 / octets_documentes[m];
+            HOTE_VERIFIER(soutenu > documente * 9 / 10 && soutenu < documente * 11 / 10);
+            printf("analyseur : %s a %u bauds, %u changements/s sans perte (%u soutenus, limite documentee %u)\n",
+                   (modes[m] == ANALYSEUR_PERIODIQUE) ? "periodique 200 kHz" : "fronts",bauds[b],debit,soutenu,documente);
+        }
+    }
+
+    return Hote_Bilan("test_analyseur");
+}
+
+/* fin du fichier */
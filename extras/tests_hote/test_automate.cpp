@@ -0,0 +1,310 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_automate.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Automate.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test des automates à états hiérarchiques (Automate.h) sur PC, automate d'une porte à deux niveaux :
+ *  - démarrage : entrée du parent puis du sous-état initial
+ *  - ordre des sorties, de l'action et des entrées ; transitions internes et transitions héritées du parent
+ *  - garde refusée : repli sur la transition du parent (auto-transition) ; garde acceptée
+ *  - transition vers le parent : sous-état initial ; évènement sans transition ignoré
+ *  - distribution : file des interruptions avant la file des tâches, file pleine comptée,
+ *    temporisations (échéance exacte, réarmement, annulation), fronts d'une GPIO liée
+ *  - même logique de porte codée en "switch" imbriqué scruté toutes les ms, puis en automate sur évènements épars :
+ *    mêmes ouvertures / fermetures, coût sur PC de chaque version par seconde simulée
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Automate.h"
+#include <string>
+#include <chrono>
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+#define GPIO_BOUTON 4
+#define NB_MS_BANC 3600000   // une heure simulée
+#define TEMPO_MS_BANC 5000
+
+static std::string trace;
+#define ACTION(nom) static void nom(void *contexte) { trace += #nom " "; }
+ACTION(E_Ferme) ACTION(S_Ferme) ACTION(E_Ouvert) ACTION(S_Ouvert) ACTION(E_Attente) ACTION(S_Attente)
+ACTION(E_Bloque) ACTION(S_Bloque) ACTION(Action) ACTION(Interne)
+
+static bool libre = false;
+static bool Obstacle_Libre(void *contexte)
+{
+    return libre;
+}
+
+enum {FERME, OUVERT, ATTENTE, BLOQUE};
+enum {BOUTON, OBSTACLE, TEMPO, COMPTER, RETOUR, NB_EVENEMENTS};
+
+constexpr Automate_Etat Etats_Porte[] = {
+    {AUTOMATE_AUCUN, AUTOMATE_AUCUN, E_Ferme,   S_Ferme},      // FERME
+    {AUTOMATE_AUCUN, ATTENTE,        E_Ouvert,  S_Ouvert},     // OUVERT
+    {OUVERT,         AUTOMATE_AUCUN, E_Attente, S_Attente},    // ATTENTE
+    {OUVERT,         AUTOMATE_AUCUN, E_Bloque,  S_Bloque}};    // BLOQUE
+constexpr Automate_Transition Transitions_Porte[] = {
+    {FERME,   BOUTON,   OUVERT,           NULL,           Action},
+    {ATTENTE, TEMPO,    FERME,            NULL,           Action},
+    {OUVERT,  OBSTACLE, BLOQUE,           NULL,           NULL},      // héritée par les sous-états
+    {BLOQUE,  BOUTON,   ATTENTE,          Obstacle_Libre, NULL},      // garde
+    {OUVERT,  BOUTON,   OUVERT,           NULL,           NULL},      // repli de la garde : auto-transition
+    {OUVERT,  COMPTER,  AUTOMATE_INTERNE, NULL,           Interne},
+    {BLOQUE,  RETOUR,   OUVERT,           NULL,           NULL}};     // vers le parent
+typedef AUTOMATE_DEFINITION(Etats_Porte,Transitions_Porte,NB_EVENEMENTS) Def_Porte;
+
+static Automate<Def_Porte> porte;
+
+// Traite un évènement : trace des sorties / actions / entrées et état feuille atteint
+static bool Traiter(uint8 evenement, const char *attendu, uint8 etat)
+{
+    trace.clear();
+    Automate_Traiter(&porte,evenement);
+    if (trace != attendu) printf("  trace '%s' (attendu '%s')\n",trace.c_str(),attendu);
+    return trace == attendu && porte.etat == etat;
+}
+
+static void Distribuer()
+{
+    while (Automate_Executer()) {}
+}
+
+// ------------------------------------------------------------------------------------------------------------------------
+// Banc de comparaison : porte (bouton, obstacle, fermeture après 5s) scrutée toutes les ms ou pilotée par évènements
+// ------------------------------------------------------------------------------------------------------------------------
+
+enum {ENTREE_BOUTON = 1, ENTREE_OBSTACLE = 2};
+static uint8 entrees[NB_MS_BANC];    // niveaux des entrées à chaque ms (fronts rares)
+static uint32 nb_ouvertures, nb_fermetures;
+
+static uint32 graine = 3;
+static uint32 Aleatoire()
+{
+    graine = graine * 1103515245 + 12345;
+    return graine >> 8;
+}
+
+// Version scrutée : détection des fronts et "switch" imbriqué à chaque ms
+enum {P_FERME, P_OUVERT};
+enum {P_ATTENTE, P_BLOQUE};
+static struct{
+  uint8 etat;
+  uint8 sous_etat;
+  uint32 tempo;
+  uint8 precedent;
+} scrute;
+
+static void Scruter_1ms(uint8 niveaux)
+{
+    bool bouton = (niveaux & ENTREE_BOUTON) && !(scrute.precedent & ENTREE_BOUTON);
+    bool obstacle = (niveaux & ENTREE_OBSTACLE) && !(scrute.precedent & ENTREE_OBSTACLE);
+    bool libre = !(niveaux & ENTREE_OBSTACLE) && (scrute.precedent & ENTREE_OBSTACLE);
+    scrute.precedent = niveaux;
+
+    switch (scrute.etat)
+    {
+        case P_FERME :
+            if (bouton)
+            {
+                nb_ouvertures++;
+                scrute.etat = P_OUVERT;
+                scrute.sous_etat = P_ATTENTE;
+                scrute.tempo = TEMPO_MS_BANC;
+            }
+        break;
+
+        case P_OUVERT :
+            switch (scrute.sous_etat)
+            {
+                case P_ATTENTE :
+                    if (obstacle) scrute.sous_etat = P_BLOQUE;
+                    else if (bouton) scrute.tempo = TEMPO_MS_BANC;
+                    else if (--scrute.tempo == 0)
+                    {
+                        nb_fermetures++;
+                        scrute.etat = P_FERME;
+                    }
+                break;
+
+                case P_BLOQUE :
+                    if (libre || bouton)
+                    {
+                        scrute.sous_etat = P_ATTENTE;
+                        scrute.tempo = TEMPO_MS_BANC;
+                    }
+                break;
+            }
+        break;
+    }
+}
+
+// Version évènements : la même porte en automate hiérarchique, fronts postés comme par l'interruption GPIO
+enum {B_FERME, B_OUVERT, B_ATTENTE, B_BLOQUE};
+enum {B_BOUTON, B_OBSTACLE, B_LIBRE, B_TEMPO, NB_EVENEMENTS_BANC};
+static int8 numero_banc;
+static void Ouvrir(void *contexte)        { nb_ouvertures++; }
+static void Fermer(void *contexte)        { nb_fermetures++; }
+static void Armer_Tempo(void *contexte)   { Automate_Armer(numero_banc,B_TEMPO,TEMPO_MS_BANC); }
+static void Annuler_Tempo(void *contexte) { Automate_Desarmer(numero_banc,B_TEMPO); }
+
+constexpr Automate_Etat Etats_Banc[] = {
+    {AUTOMATE_AUCUN, AUTOMATE_AUCUN, NULL,        NULL},             // B_FERME
+    {AUTOMATE_AUCUN, B_ATTENTE,      NULL,        NULL},             // B_OUVERT
+    {B_OUVERT,       AUTOMATE_AUCUN, Armer_Tempo, Annuler_Tempo},    // B_ATTENTE
+    {B_OUVERT,       AUTOMATE_AUCUN, NULL,        NULL}};            // B_BLOQUE
+constexpr Automate_Transition Transitions_Banc[] = {
+    {B_FERME,   B_BOUTON,   B_OUVERT,  NULL, Ouvrir},
+    {B_ATTENTE, B_TEMPO,    B_FERME,   NULL, Fermer},
+    {B_OUVERT,  B_OBSTACLE, B_BLOQUE,  NULL, NULL},
+    {B_BLOQUE,  B_LIBRE,    B_ATTENTE, NULL, NULL},
+    {B_OUVERT,  B_BOUTON,   B_OUVERT,  NULL, NULL}};     // réarme la temporisation (et débloque)
+typedef AUTOMATE_DEFINITION(Etats_Banc,Transitions_Banc,NB_EVENEMENTS_BANC) Def_Banc;
+
+static Automate<Def_Banc> banc;
+
+// Entrées du banc : un front toutes les 2s en moyenne, jamais à l'instant où la temporisation échoit
+// (l'ordre de traitement de deux évènements simultanés différerait entre les deux versions)
+static void Generer_Entrees()
+{
+    memset(&scrute,0,sizeof(scrute));
+    uint8 niveaux = 0;
+    for (uint32 ms = 0; ms < NB_MS_BANC; ms++)
+    {
+        bool echeance = (scrute.etat == P_OUVERT && scrute.sous_etat == P_ATTENTE && scrute.tempo == 1);
+        if (!echeance && Aleatoire() % 2000 == 0) niveaux ^= (Aleatoire() & 1) ? ENTREE_BOUTON : ENTREE_OBSTACLE;
+        entrees[ms] = niveaux;
+        Scruter_1ms(niveaux);
+    }
+}
+
+// Coût sur PC (ns par seconde simulée) de la version scrutée
+static double Banc_Scrute()
+{
+    memset(&scrute,0,sizeof(scrute));
+    nb_ouvertures = nb_fermetures = 0;
+    auto debut = std::chrono::steady_clock::now();
+    for (uint32 ms = 0; ms < NB_MS_BANC; ms++) Scruter_1ms(entrees[ms]);
+    return std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - debut).count() / (NB_MS_BANC / 1000);
+}
+
+// Coût sur PC (ns par seconde simulée) de la version évènements : temporisations et distribution à chaque ms
+static double Banc_Evenements()
+{
+    Automate_Demarrer(&banc,B_FERME,NULL);
+    numero_banc = Automate_Enregistrer(&banc);
+    nb_ouvertures = nb_fermetures = 0;
+    uint8 precedent = 0;
+    auto debut = std::chrono::steady_clock::now();
+    for (uint32 ms = 0; ms < NB_MS_BANC; ms++)
+    {
+        uint8 fronts = entrees[ms] ^ precedent;
+        if (fronts)
+        {
+            precedent = entrees[ms];
+            if (fronts & precedent & ENTREE_BOUTON) Automate_Poster_Interruption(numero_banc,B_BOUTON);
+            if (fronts & ENTREE_OBSTACLE) Automate_Poster_Interruption(numero_banc,(precedent & ENTREE_OBSTACLE) ? B_OBSTACLE : B_LIBRE);
+        }
+        Automate_Tache_1ms();
+        while (Automate_Executer()) {}
+    }
+    return std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - debut).count() / (NB_MS_BANC / 1000);
+}
+
+int main()
+{
+    const Automate_Statistiques *stats = Automate_Lire_Statistiques();
+
+    Hote_Init();
+
+    // 1. table générée à la compilation
+    HOTE_VERIFIER(Automate<Def_Porte>::Cases::table[ATTENTE * NB_EVENEMENTS + OBSTACLE] == 2);
+    HOTE_VERIFIER(Automate<Def_Porte>::Transitions::repli[3] == 4 && Automate<Def_Porte>::Transitions::domaine[2] == OUVERT);
+
+    // 2. hiérarchie
+    Automate_Demarrer(&porte,FERME,NULL);
+    HOTE_VERIFIER(trace == "E_Ferme " && porte.etat == FERME);
+    HOTE_VERIFIER(Traiter(BOUTON,"S_Ferme Action E_Ouvert E_Attente ",ATTENTE));
+    HOTE_VERIFIER(Traiter(COMPTER,"Interne ",ATTENTE));
+    HOTE_VERIFIER(Traiter(OBSTACLE,"S_Attente E_Bloque ",BLOQUE));
+    libre = false;
+    HOTE_VERIFIER(Traiter(BOUTON,"S_Bloque S_Ouvert E_Ouvert E_Attente ",ATTENTE));
+    HOTE_VERIFIER(Traiter(OBSTACLE,"S_Attente E_Bloque ",BLOQUE));
+    libre = true;
+    HOTE_VERIFIER(Traiter(BOUTON,"S_Bloque E_Attente ",ATTENTE));
+    HOTE_VERIFIER(Traiter(OBSTACLE,"S_Attente E_Bloque ",BLOQUE));
+    HOTE_VERIFIER(Traiter(RETOUR,"S_Bloque E_Attente ",ATTENTE));
+    HOTE_VERIFIER(Traiter(TEMPO,"S_Attente S_Ouvert Action E_Ferme ",FERME));
+    trace.clear();
+    HOTE_VERIFIER(!Automate_Traiter(&porte,TEMPO) && !Automate_Traiter(&porte,NB_EVENEMENTS) && trace.empty());
+    HOTE_VERIFIER(Automate_Dans(&porte,FERME) && !Automate_Dans(&porte,OUVERT));
+
+    // 3. files : interruptions d'abord, évènement ignoré compté, file pleine
+    int8 numero = Automate_Enregistrer(&porte);
+    HOTE_VERIFIER(numero == 0);
+    HOTE_VERIFIER(Automate_Poster(numero,OBSTACLE) && Automate_Poster_Interruption(numero,BOUTON));
+    Distribuer();
+    HOTE_VERIFIER(porte.etat == BLOQUE && stats->nb_evenements == 2 && stats->nb_ignores == 0);
+    HOTE_VERIFIER(Automate_Poster(numero,TEMPO));
+    Distribuer();
+    HOTE_VERIFIER(porte.etat == BLOQUE && stats->nb_ignores == 1);
+    uint32 nb_acceptes = 0;
+    for (uint32 i = 0; i < AUTOMATE_TAILLE_FILE + 4; i++) nb_acceptes += Automate_Poster(numero,COMPTER);
+    HOTE_VERIFIER(nb_acceptes < AUTOMATE_TAILLE_FILE + 4 && stats->nb_perdus == AUTOMATE_TAILLE_FILE + 4 - nb_acceptes);
+    Distribuer();
+    HOTE_VERIFIER(Traiter(RETOUR,"S_Bloque E_Attente ",ATTENTE));
+
+    // 4. temporisations : échéance exacte, réarmement, annulation
+    HOTE_VERIFIER(Automate_Armer(numero,TEMPO,100));
+    for (uint32 ms = 0; ms < 99; ms++) { Automate_Tache_1ms(); Distribuer(); }
+    HOTE_VERIFIER(Automate_Armer(numero,TEMPO,100) && porte.etat == ATTENTE);
+    for (uint32 ms = 0; ms < 99; ms++) { Automate_Tache_1ms(); Distribuer(); }
+    HOTE_VERIFIER(porte.etat == ATTENTE);
+    Automate_Tache_1ms();
+    Distribuer();
+    HOTE_VERIFIER(porte.etat == FERME);
+    HOTE_VERIFIER(Traiter(BOUTON,"S_Ferme Action E_Ouvert E_Attente ",ATTENTE));
+    HOTE_VERIFIER(Automate_Armer(numero,TEMPO,10));
+    Automate_Desarmer(numero,TEMPO);
+    for (uint32 ms = 0; ms < 50; ms++) { Automate_Tache_1ms(); Distribuer(); }
+    HOTE_VERIFIER(porte.etat == ATTENTE);
+    bool toutes = true;
+    for (uint8 i = 0; i < AUTOMATE_NB_TEMPORISATIONS; i++) toutes &= Automate_Armer(numero,i,1000);
+    HOTE_VERIFIER(toutes && !Automate_Armer(numero,AUTOMATE_NB_TEMPORISATIONS,1000));
+    for (uint8 i = 0; i < AUTOMATE_NB_TEMPORISATIONS; i++) Automate_Desarmer(numero,i);
+
+    // 5. GPIO liée : front descendant -> obstacle, front montant -> bouton
+    HOTE_VERIFIER(!Automate_Lier_GPIO(16,numero,BOUTON,OBSTACLE) && !Automate_Lier_GPIO(GPIO_BOUTON,numero + 1,BOUTON,OBSTACLE));
+    HOTE_VERIFIER(!Automate_Lier_GPIO(GPIO_BOUTON,numero,AUTOMATE_AUCUN,AUTOMATE_AUCUN));
+    HOTE_VERIFIER(Automate_Lier_GPIO(GPIO_BOUTON,numero,BOUTON,OBSTACLE));
+    libre = true;
+    hote_gpio_externe &= ~(1 << GPIO_BOUTON);
+    Hote_Simuler(10 * CYCLES_PAR_US);
+    Distribuer();
+    HOTE_VERIFIER(porte.etat == BLOQUE);
+    hote_gpio_externe |= (1 << GPIO_BOUTON);
+    Hote_Simuler(10 * CYCLES_PAR_US);
+    Distribuer();
+    HOTE_VERIFIER(porte.etat == ATTENTE && stats->nb_perdus == AUTOMATE_TAILLE_FILE + 4 - nb_acceptes);
+
+    // 6. même porte scrutée toutes les ms ou pilotée par évènements : mêmes ouvertures / fermetures
+    Generer_Entrees();
+    double ns_scrute = Banc_Scrute();
+    uint32 ouvertures_scrute = nb_ouvertures, fermetures_scrute = nb_fermetures;
+    uint32 evenements_avant = stats->nb_evenements;
+    double ns_evenements = Banc_Evenements();
+    HOTE_VERIFIER(numero_banc == 1 && ouvertures_scrute > 100);
+    HOTE_VERIFIER(nb_ouvertures == ouvertures_scrute && nb_fermetures == fermetures_scrute);
+    HOTE_VERIFIER(banc.etat == (scrute.etat == P_FERME ? B_FERME : (scrute.sous_etat == P_ATTENTE ? B_ATTENTE : B_BLOQUE)));
+    printf("automate : %u ouvertures en %u s simulees, switch scrute 1ms %.0f ns par seconde, automate %.0f ns par seconde "
+           "(%u evenements), rapport %.1f (sur PC)\n",
+           nb_ouvertures,NB_MS_BANC / 1000,ns_scrute,ns_evenements,stats->nb_evenements - evenements_avant,ns_scrute / ns_evenements);
+
+    return Hote_Bilan("test_automate");
+}
+
+/* fin du fichier */
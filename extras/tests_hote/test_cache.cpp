@@ -0,0 +1,128 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_cache.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Cache_Registres.cpp Entrees.cpp GPIO_esp8266.cpp UART_esp8266.cpp registres_esp8266.cpp
+ *  Options  : -DCACHE_REGISTRES
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de la copie en RAM des registres de configuration (Cache_Registres.h) sur PC, compilé avec CACHE_REGISTRES :
+ *  - séquence d'initialisation (GPIO, interruptions, UART0 / UART1, clavier) : lectures matérielles évitées,
+ *    copies identiques aux registres
+ *  - écriture d'une valeur déjà présente omise
+ *  - registres d'état et de données (IN, FIFO) jamais copiés : toujours lus et écrits sur le matériel
+ *  - registre modifié hors des macros : copie périmée, puis Cache_Registres_Synchroniser / Cache_Registres_Invalider
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Cache_Registres.h"
+#include "GPIO_esp8266.h"
+#include "UART_esp8266.h"
+#include "Entrees.h"
+
+// Accès matériels (hors copie)
+static uint32 nb_lectures = 0, nb_ecritures = 0, nb_lectures_in = 0, nb_ecritures_fifo = 0;
+static bool Lecture(__Registre *registre, uint32 *valeur)
+{
+    nb_lectures++;
+    if (registre == &Registre_GPIO->IN) nb_lectures_in++;
+    return false;
+}
+static void Ecriture(__Registre *registre, uint32 valeur)
+{
+    nb_ecritures++;
+    if (registre == &Registre_UART1->FIFO) nb_ecritures_fifo++;
+}
+
+// Les copies valides sont identiques aux registres
+static bool Copies_Conformes()
+{
+    for (uint8 i = 0; i < CACHE_NB_IOMUX_GPIO; i++)
+    {
+        if (Cache_Lecture_Registre(&Registre_IOMUX->GPIO[i]) != Registre_IOMUX->GPIO[i]) return false;
+    }
+    for (uint8 i = 0; i < CACHE_NB_GPIO_PIN; i++)
+    {
+        if (Cache_Lecture_Registre(&Registre_GPIO->PIN[i]) != Registre_GPIO->PIN[i]) return false;
+    }
+    return Cache_Lecture_Registre(&Registre_UART0->CONF0) == Registre_UART0->CONF0 &&
+           Cache_Lecture_Registre(&Registre_UART0->CONF1) == Registre_UART0->CONF1 &&
+           Cache_Lecture_Registre(&Registre_UART1->CONF0) == Registre_UART1->CONF0 &&
+           Cache_Lecture_Registre(&Registre_UART1->CONF1) == Registre_UART1->CONF1;
+}
+
+int main()
+{
+    static const uint8 gpio[8] = {GPIO0, GPIO2, GPIO4, GPIO5, GPIO12, GPIO13, GPIO14, GPIO15};
+    static const uint8 lignes[4] = {GPIO12, GPIO13, GPIO14, GPIO15};
+    static const uint8 colonnes[3] = {GPIO0, GPIO2, GPIO4};
+    const Cache_Registres_Statistiques *stats = Cache_Registres_Lire_Statistiques();
+
+    Hote_Init();
+    hote_crochet_lecture = Lecture;
+    hote_crochet_ecriture = Ecriture;
+
+    // 1. séquence d'initialisation répétée (reconfigurations successives des mêmes broches)
+    for (uint8 n = 0; n < 10; n++)
+    {
+        for (uint8 i = 0; i < 8; i++)
+        {
+            init_GPIO(gpio[i],(i & 1) ? GPIO_OUTPUT : GPIO_INPUT);
+            Set_GPIO_Interrupt(gpio[i],FRONT_DOUBLE);
+            Set_GPIO_Interrupt(gpio[i],INACTIF);
+        }
+        init_UART(UART0,115200,DATA_8,NONE,STOP_1);
+        init_UART(UART1,9600,DATA_7,EVEN,STOP_2);
+    }
+    init_Clavier(lignes,4,colonnes,3);
+
+    // sans la copie, chaque lecture évitée serait une lecture matérielle
+    uint32 lectures_sans_copie = nb_lectures + stats->lectures_evitees;
+    HOTE_VERIFIER(stats->lectures_materiel <= NB_CACHE_REGISTRES && stats->lectures_evitees > 0);
+    HOTE_VERIFIER(nb_lectures * 5 < lectures_sans_copie);
+    printf("cache : initialisation %u lectures materielles (%u sans la copie), %u ecritures dont %u evitees\n",
+           nb_lectures,lectures_sans_copie,nb_ecritures,stats->ecritures_evitees);
+
+    hote_crochet_lecture = NULL;
+    HOTE_VERIFIER(Copies_Conformes());
+    HOTE_VERIFIER(READ_BIT(Registre_GPIO->PIN[GPIO4],BIT_GPIO_DRIVER) && READ_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO14)],BIT_IOMUX_PULLUP));
+    hote_crochet_lecture = Lecture;
+
+    // 2. écriture d'une valeur déjà présente : omise
+    uint32 ecritures = nb_ecritures, evitees = stats->ecritures_evitees;
+    REGISTRE_CONFIG_SET_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO14)],BIT_IOMUX_PULLUP);
+    HOTE_VERIFIER(nb_ecritures == ecritures && stats->ecritures_evitees == evitees + 1);
+
+    // 3. registres d'état et de données : jamais copiés
+    uint32 lectures_in = nb_lectures_in;
+    for (uint8 i = 0; i < 5; i++) GPIO_Read(GPIO12);
+    HOTE_VERIFIER(nb_lectures_in == lectures_in + 5);
+    for (uint8 i = 0; i < 5; i++) UART_send_tx(UART1,'A');
+    HOTE_VERIFIER(nb_ecritures_fifo == 5);
+    hote_gpio_externe = ~(1U << GPIO12);
+    HOTE_VERIFIER(GPIO_Read(GPIO12) == 0);
+    hote_gpio_externe = 0xFFFFFFFF;
+    HOTE_VERIFIER(GPIO_Read(GPIO12) == 1);
+
+    // 4. registre modifié hors des macros : la copie est périmée jusqu'à la synchronisation
+    REGISTRE_ECRIRE(Registre_GPIO->PIN[GPIO5],1UL << BIT_GPIO_DRIVER);
+    HOTE_VERIFIER(Cache_Lecture_Registre(&Registre_GPIO->PIN[GPIO5]) != Registre_GPIO->PIN[GPIO5]);
+    Cache_Registres_Synchroniser(&Registre_GPIO->PIN[GPIO5]);
+    REGISTRE_CONFIG_SET_BIT(Registre_GPIO->PIN[GPIO5],BIT_GPIO_SOURCE);
+    HOTE_VERIFIER(Registre_GPIO->PIN[GPIO5] == ((1UL << BIT_GPIO_DRIVER) | (1UL << BIT_GPIO_SOURCE)));
+
+    Registre_UART0->CONF0 = 0x1C;
+    Registre_IOMUX->GPIO[3] = 0x80;
+    uint32 materiel = stats->lectures_materiel;
+    Cache_Registres_Invalider();
+    HOTE_VERIFIER(Copies_Conformes() && stats->lectures_materiel == materiel + NB_CACHE_REGISTRES);
+
+    hote_crochet_lecture = NULL;
+    hote_crochet_ecriture = NULL;
+    return Hote_Bilan("test_cache");
+}
+
+/* fin du fichier */
@@ -0,0 +1,146 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_carte.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Configuration_Carte.cpp GPIO_esp8266.cpp UART_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de la configuration déclarative d'une carte (Configuration_Carte.h) sur PC, carte de 12 broches :
+ *  - tables invalides refusées à la compilation (doublon, GPIO hors bornes, option inconnue)
+ *  - registres GPIO et IOMUX identiques à ceux obtenus broche par broche (init_GPIO, Choix_fonction_GPIO, ...)
+ *  - nombre d'accès aux registres : image contre chemin broche par broche
+ *  - broches non décrites non modifiées
+ *  - Carte_Verifier : configuration conforme, puis première GPIO modifiée
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Configuration_Carte.h"
+
+static constexpr Carte_Broche Broches[] = {
+    // GPIO   fonction             direction    options                                            interruption
+    {  GPIO0,  CARTE_FONCTION_GPIO, GPIO_INPUT,  CARTE_PULLUP,                                      FRONT_DESCENDANT },
+    {  GPIO2,  CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_PULLUP | CARTE_ETAT_HAUT,                    INACTIF          },
+    {  GPIO4,  CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_PULLUP | CARTE_DRAIN_OUVERT | CARTE_ETAT_HAUT, INACTIF        },
+    {  GPIO5,  CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_PULLUP,                                      INACTIF          },
+    {  GPIO12, CARTE_FONCTION_GPIO, GPIO_INPUT,  0,                                                 FRONT_MONTANT    },
+    {  GPIO13, CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_PULLUP,                                      INACTIF          },
+    {  GPIO14, CARTE_FONCTION_GPIO, GPIO_INPUT,  CARTE_PULLUP,                                      FRONT_DOUBLE     },
+    {  GPIO15, CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_ETAT_HAUT,                                   INACTIF          },
+    {  GPIO1,  CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_PULLUP,                                      INACTIF          },
+    {  GPIO3,  CARTE_FONCTION_GPIO, GPIO_INPUT,  CARTE_PULLUP,                                      LOW_LEVEL        },
+    {  GPIO9,  CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_PULLUP,                                      INACTIF          },
+    {  GPIO10, CARTE_FONCTION_GPIO, GPIO_INPUT,  0,                                                 INACTIF          },
+};
+static_assert(CARTE_TABLE_VALIDE(Broches), "description de carte invalide");
+static constexpr Carte_Image Image = CARTE_IMAGE(Broches);
+
+static constexpr Carte_Broche Doublon[] = {{GPIO4,CARTE_FONCTION_GPIO,GPIO_INPUT,0,INACTIF},{GPIO4,CARTE_FONCTION_GPIO,GPIO_OUTPUT,0,INACTIF}};
+static constexpr Carte_Broche Hors_Bornes[] = {{16,CARTE_FONCTION_GPIO,GPIO_INPUT,0,INACTIF}};
+static constexpr Carte_Broche Option_Inconnue[] = {{GPIO5,CARTE_FONCTION_GPIO,GPIO_INPUT,0x80,INACTIF}};
+static_assert(!CARTE_TABLE_VALIDE(Doublon), "doublon accepté");
+static_assert(!CARTE_TABLE_VALIDE(Hors_Bornes), "GPIO hors bornes acceptée");
+static_assert(!CARTE_TABLE_VALIDE(Option_Inconnue), "option inconnue acceptée");
+
+// Comptage des accès aux registres
+static uint32 nb_lectures = 0, nb_ecritures = 0;
+static void Compter_Ecriture(__Registre *registre, uint32 valeur) { nb_ecritures++; }
+static bool Compter_Lecture(__Registre *registre, uint32 *valeur) { nb_lectures++; return false; }
+
+// Copie des registres GPIO et IOMUX
+typedef struct{
+  GPIO_Struct gpio;
+  IOMUX_Struct iomux;
+} Etat_Registres;
+
+static void Copier(Etat_Registres *etat)
+{
+    memcpy(&etat->gpio,(const void *)Registre_GPIO,sizeof(GPIO_Struct));
+    memcpy(&etat->iomux,(const void *)Registre_IOMUX,sizeof(IOMUX_Struct));
+}
+
+static void Remettre_A_Zero()
+{
+    memset((void *)Registre_GPIO,0,sizeof(GPIO_Struct));
+    memset((void *)Registre_IOMUX,0,sizeof(IOMUX_Struct));
+}
+
+// Configuration broche par broche, avec les fonctions de GPIO_esp8266.h
+static void Configurer_Par_Broche()
+{
+    for (uint8 i = 0; i < CARTE_NB_BROCHES(Broches); i++)
+    {
+        const Carte_Broche *b = &Broches[i];
+        uint8 index = index_iomux(b->gpio);
+
+        init_GPIO(b->gpio,b->direction);
+        if (b->options & CARTE_PULLUP) REGISTRE_SET_BIT(Registre_IOMUX->GPIO[index],BIT_IOMUX_PULLUP);
+        else REGISTRE_CLR_BIT(Registre_IOMUX->GPIO[index],BIT_IOMUX_PULLUP);
+        if (b->options & CARTE_DRAIN_OUVERT) REGISTRE_SET_BIT(Registre_GPIO->PIN[b->gpio],BIT_GPIO_DRIVER);
+        if (b->direction == GPIO_OUTPUT) GPIO_Write(b->gpio,(b->options & CARTE_ETAT_HAUT) != 0);
+        Set_GPIO_Interrupt(b->gpio,(GPIO_Interrupt)b->interruption);
+    }
+}
+
+int main()
+{
+    Etat_Registres par_broche, par_image;
+
+    Hote_Init();
+    hote_crochet_ecriture = Compter_Ecriture;
+    hote_crochet_lecture = Compter_Lecture;
+
+    // 1. image calculée à la compilation
+    HOTE_VERIFIER(Image.masque == 0xF63F && Image.sorties == 0xA236 && Image.etats_hauts == 0x8014);
+    HOTE_VERIFIER(Image.interruptions == 0x5009);
+    HOTE_VERIFIER(Image.iomux[GPIO0] == (IOMUX_FONCTION(GPIO_FONCTION_1) | (1UL << BIT_IOMUX_PULLUP)));
+    HOTE_VERIFIER(Image.iomux[GPIO12] == IOMUX_FONCTION(GPIO_FONCTION_4));
+    HOTE_VERIFIER(Image.pin[GPIO4] == (1UL << BIT_GPIO_DRIVER) && Image.pin[GPIO14] == ((uint32)FRONT_DOUBLE << BIT_GPIO_INT_TYPE));
+    HOTE_VERIFIER(Image.pin[GPIO6] == 0 && Image.iomux[GPIO6] == 0);
+
+    // 2. chemin broche par broche
+    Remettre_A_Zero();
+    nb_lectures = nb_ecritures = 0;
+    Configurer_Par_Broche();
+    uint32 lectures_par_broche = nb_lectures, ecritures_par_broche = nb_ecritures;
+    Copier(&par_broche);
+
+    // 3. image : mêmes registres, moins d'accès
+    Remettre_A_Zero();
+    nb_lectures = nb_ecritures = 0;
+    Carte_Appliquer(&Image);
+    Copier(&par_image);
+    HOTE_VERIFIER(memcmp(&par_broche.gpio,&par_image.gpio,sizeof(GPIO_Struct)) == 0);
+    HOTE_VERIFIER(memcmp(&par_broche.iomux,&par_image.iomux,sizeof(IOMUX_Struct)) == 0);
+    HOTE_VERIFIER((Hote_GPIO_Niveaux() & Image.sorties) == Image.etats_hauts);
+    // PIN et IOMUX : une écriture par broche décrite, plus les registres W1TS / W1TC communs, aucune lecture
+    HOTE_VERIFIER(nb_ecritures <= 2 * CARTE_NB_BROCHES(Broches) + 6);
+    HOTE_VERIFIER(nb_lectures == 0 && lectures_par_broche > 0 && nb_ecritures * 2 < ecritures_par_broche);
+    printf("carte : broche par broche %u lectures / %u ecritures, image %u lectures / %u ecritures\n",
+           lectures_par_broche,ecritures_par_broche,nb_lectures,nb_ecritures);
+
+    // 4. broches non décrites non modifiées
+    Registre_GPIO->PIN[GPIO6] = 0x1234;
+    Registre_IOMUX->GPIO[index_iomux(GPIO6)] = 0x5678;
+    Carte_Appliquer(&Image);
+    HOTE_VERIFIER(Registre_GPIO->PIN[GPIO6] == 0x1234 && Registre_IOMUX->GPIO[index_iomux(GPIO6)] == 0x5678);
+
+    // 5. vérification
+    HOTE_VERIFIER(Carte_Verifier(&Image) == -1);
+    REGISTRE_CLR_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO13)],BIT_IOMUX_PULLUP);
+    HOTE_VERIFIER(Carte_Verifier(&Image) == GPIO13);
+    REGISTRE_SET_BIT(Registre_GPIO->PIN[GPIO5],BIT_GPIO_DRIVER);
+    HOTE_VERIFIER(Carte_Verifier(&Image) == GPIO5);
+    Carte_Appliquer(&Image);
+    HOTE_VERIFIER(Carte_Verifier(&Image) == -1);
+    init_GPIO(GPIO2,GPIO_INPUT);
+    HOTE_VERIFIER(Carte_Verifier(&Image) == GPIO2);
+
+    hote_crochet_ecriture = NULL;
+    hote_crochet_lecture = NULL;
+    return Hote_Bilan("test_carte");
+}
+
+/* fin du fichier */
@@ -0,0 +1,198 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_console.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Console.cpp UART_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de la console (Console.h) sur PC, UART0 simulée à 115200 bauds :
+ *  - table de hachage : 16 commandes sans collision, noms en double et table trop grande refusés
+ *  - arguments : entiers signés / non signés / hexadécimaux, bornes, texte entre guillemets, arguments optionnels
+ *  - erreurs : commande inconnue, argument manquant, invalide, en trop, ligne trop longue
+ *  - écho et effacement (terminal interactif)
+ *  - rafale de 300 lignes sans pause : aucune perte, une commande par appel de Console_Executer
+ *  - envoi : buffer TX plein compté, place libre
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Console.h"
+#include <string>
+#include <time.h>
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+
+static std::string derniere;
+static uint32 nb_appels = 0;
+
+// Commandes : les arguments reçus sont renvoyés sur la console
+static void Commande_Led(const Console_Arguments *arguments)
+{
+    nb_appels++;
+    Console_Ecrire("led ");
+    Console_Ecrire_Nombre(arguments->valeurs[0].non_signe);
+    Console_Ecrire(" ");
+    Console_Ecrire_Nombre(arguments->valeurs[1].non_signe);
+    Console_Ecrire("\n");
+}
+
+static void Commande_Set(const Console_Arguments *arguments)
+{
+    nb_appels++;
+    Console_Ecrire("set ");
+    Console_Ecrire_Entier(arguments->valeurs[0].entier);
+    if (arguments->nb > 1)
+    {
+        Console_Ecrire(" [");
+        Console_Ecrire(arguments->valeurs[1].texte);
+        Console_Ecrire("]");
+    }
+    Console_Ecrire("\n");
+}
+
+static void Commande_Vide(const Console_Arguments *arguments)
+{
+    nb_appels++;
+}
+
+static const Console_Commande Commandes[CONSOLE_NB_COMMANDES_MAX] = {
+    {"led",   "uu",  Commande_Led,  "<gpio> <etat>"},
+    {"set",   "i|s", Commande_Set,  "<valeur> [nom]"},
+    {"aide",  "",    Console_Aide,  "liste des commandes"},
+    {"reset", "",    Commande_Vide, ""},
+    {"wifi",  "ss",  Commande_Vide, "<ssid> <cle>"},
+    {"mqtt",  "s|u", Commande_Vide, "<serveur> [port]"},
+    {"gpio",  "u|u", Commande_Vide, "<gpio> [etat]"},
+    {"pwm",   "uu",  Commande_Vide, "<gpio> <rapport>"},
+    {"temp",  "",    Commande_Vide, ""},
+    {"heure", "|u",  Commande_Vide, "[date]"},
+    {"log",   "|u",  Commande_Vide, "[niveau]"},
+    {"flash", "uu",  Commande_Vide, "<adresse> <taille>"},
+    {"mem",   "",    Commande_Vide, ""},
+    {"stats", "",    Commande_Vide, ""},
+    {"ver",   "",    Commande_Vide, ""},
+    {"sleep", "u",   Commande_Vide, "<ms>"},
+};
+
+// Réception de tout ce qu'émet la console (boucle principale appelée toutes les 100us)
+static void Boucle(uint32 us)
+{
+    char octets[256];
+    for (uint32 t = 0; t < us; t += 100)
+    {
+        Hote_Simuler(100 * CYCLES_PAR_US);
+        Console_Executer();
+        uint32 nb = Hote_UART0_Recevoir(octets,sizeof(octets));
+        derniere.append(octets,nb);
+    }
+}
+
+// Envoie une ligne et renvoie la réponse de la console (complète : 5ms sans octet émis)
+static std::string Dialogue(const char *ligne)
+{
+    uint32 silence = 0;
+
+    derniere.clear();
+    Hote_UART0_Envoyer(ligne,strlen(ligne));
+    while (Hote_UART0_A_Envoyer() > 0 || silence < 5)
+    {
+        size_t taille = derniere.size();
+        Boucle(1000);
+        silence = (derniere.size() == taille) ? silence + 1 : 0;
+    }
+    return derniere;
+}
+
+int main()
+{
+    static const Console_Commande Doublons[] = {{"led","",Commande_Vide,""},{"led","",Commande_Vide,""}};
+
+    Hote_Init();
+    Hote_UART0_Activer();
+
+    // 1. table des commandes
+    HOTE_VERIFIER(!init_Console(115200,Commandes,CONSOLE_NB_COMMANDES_MAX + 1,false));
+    HOTE_VERIFIER(!init_Console(115200,Doublons,2,false));
+    HOTE_VERIFIER(init_Console(115200,Commandes,CONSOLE_NB_COMMANDES_MAX,false));
+
+    // 2. arguments
+    HOTE_VERIFIER(Dialogue("led 5 1\r\n") == "led 5 1\r\n");
+    HOTE_VERIFIER(Dialogue("led 0x1F 0XA\n") == "led 31 10\r\n");
+    HOTE_VERIFIER(Dialogue("led 4294967295 0\n") == "led 4294967295 0\r\n");
+    HOTE_VERIFIER(Dialogue("  set   -42  \"hello  world\"  \n") == "set -42 [hello  world]\r\n");
+    HOTE_VERIFIER(Dialogue("set 0x10\n") == "set 16\r\n");
+    HOTE_VERIFIER(Dialogue("set -2147483648 a\"b\n") == "set -2147483648 [a\"b]\r\n");
+    HOTE_VERIFIER(Dialogue("set \"\"\n").find("argument invalide") != std::string::npos);
+    HOTE_VERIFIER(Dialogue("\n\r\n") == "");
+
+    // 3. erreurs
+    uint32 appels = nb_appels;
+    HOTE_VERIFIER(Dialogue("les 1 2\n") == "erreur : commande inconnue\r\n");
+    HOTE_VERIFIER(Dialogue("led 1\n") == "erreur : argument manquant (led <gpio> <etat>)\r\n");
+    HOTE_VERIFIER(Dialogue("led 1 -1\n") == "erreur : argument invalide (led <gpio> <etat>)\r\n");
+    HOTE_VERIFIER(Dialogue("led 1 4294967296\n").find("argument invalide") != std::string::npos);
+    HOTE_VERIFIER(Dialogue("set 2147483648\n").find("argument invalide") != std::string::npos);
+    HOTE_VERIFIER(Dialogue("set -2147483649\n").find("argument invalide") != std::string::npos);
+    HOTE_VERIFIER(Dialogue("led 1 2 3\n") == "erreur : trop d'arguments (led <gpio> <etat>)\r\n");
+    HOTE_VERIFIER(Dialogue("set 1 2 3 4 5 6 7 8 9 10\n").find("ligne trop longue") != std::string::npos);
+    std::string longue = "set 1 \"" + std::string(200,'x') + "\"\n";
+    HOTE_VERIFIER(Dialogue(longue.c_str()) == "erreur : ligne trop longue\r\n");
+    HOTE_VERIFIER(nb_appels == appels && Console_Lire_Statistiques()->nb_erreurs == 10);
+    HOTE_VERIFIER(Dialogue("led 2 0\n") == "led 2 0\r\n");
+
+    // 4. aide : une ligne par commande
+    std::string aide = Dialogue("aide\n");
+    uint32 nb_lignes = 0;
+    for (size_t i = 0; i < aide.size(); i++) nb_lignes += (aide[i] == '\n');
+    HOTE_VERIFIER(nb_lignes == CONSOLE_NB_COMMANDES_MAX && aide.find("wifi <ssid> <cle>\r\n") != std::string::npos);
+
+    // 5. écho et effacement (le nom de la commande est corrigé : hash recalculé)
+    HOTE_VERIFIER(init_Console(115200,Commandes,CONSOLE_NB_COMMANDES_MAX,true));
+    HOTE_VERIFIER(Dialogue("lex\b\bed 3 \x7f" "4 1\r") == "lex\b \b\b \bed 3 \b \b4 1led 34 1\r\n");
+    HOTE_VERIFIER(init_Console(115200,Commandes,CONSOLE_NB_COMMANDES_MAX,false));
+
+    // 6. rafale : 300 lignes sans pause, boucle principale toutes les 100us
+    std::string rafale, attendu;
+    for (uint32 i = 0; i < 300; i++)
+    {
+        char ligne[32], reponse[32];
+        snprintf(ligne,sizeof(ligne),"set %d \"n%u\"\n",(int)(i * 7919) - 1000000,i);
+        snprintf(reponse,sizeof(reponse),"set %d [n%u]\r\n",(int)(i * 7919) - 1000000,i);
+        rafale += ligne;
+        attendu += reponse;
+    }
+    appels = nb_appels;
+    derniere.clear();
+    Hote_UART0_Envoyer(rafale.data(),rafale.size());
+    Boucle(rafale.size() * 100 + 10000);
+    HOTE_VERIFIER(nb_appels - appels == 300 && derniere == attendu);
+    HOTE_VERIFIER(Console_Lire_Statistiques()->nb_perdus_rx == 0 && hote_uart0_debordements == 0);
+    HOTE_VERIFIER(Console_Lire_Statistiques()->nb_perdus_tx == 0);
+
+    // 7. buffer d'envoi : débordement compté, la place revient après l'émission
+    HOTE_VERIFIER(Console_Place_TX() == CONSOLE_TAILLE_TX);
+    std::string gros(CONSOLE_TAILLE_TX + 50,'a');
+    HOTE_VERIFIER(!Console_Ecrire(gros.c_str()));
+    HOTE_VERIFIER(Console_Lire_Statistiques()->nb_perdus_tx > 0);
+    derniere.clear();
+    Boucle(100000);
+    HOTE_VERIFIER(derniere.size() >= CONSOLE_TAILLE_TX && Console_Place_TX() == CONSOLE_TAILLE_TX);
+
+    // 8. recherche en O(1) : temps par ligne (hors UART)
+    struct timespec debut, fin;
+    init_Console(115200,Commandes,CONSOLE_NB_COMMANDES_MAX,false);
+    clock_gettime(CLOCK_MONOTONIC,&debut);
+    for (uint32 i = 0; i < 200000; i++)
+    {
+        for (const char *c = "sleep 12\n"; *c; c++) Console_Traiter_Octet(*c);
+    }
+    clock_gettime(CLOCK_MONOTONIC,&fin);
+    printf("console : %u commandes, %.1f ns par ligne \"sleep 12\" (PC)\n",Console_Lire_Statistiques()->nb_commandes,
+           ((fin.tv_sec - debut.tv_sec) * 1e9 + (fin.tv_nsec - debut.tv_nsec)) / 200000);
+
+    return Hote_Bilan("test_console");
+}
+
+/* fin du fichier */
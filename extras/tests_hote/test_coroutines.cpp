@@ -0,0 +1,163 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_coroutines.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Coroutines.cpp Scheduler.cpp GPIO_esp8266.cpp UART_esp8266.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test des tâches coopératives (Coroutines.h) sur PC, cadencées par le Scheduler (tâche 1ms) :
+ *  - délais exacts en ms, contexte conservé entre deux attentes
+ *  - attente d'un front sur une GPIO (réveil par l'interruption, ou échéance)
+ *  - attente d'une condition, tâches simultanées, emplacements libérés en fin de tâche
+ *  Mesure la RAM occupée par une tâche et le temps d'une reprise sur PC.
+ * =============================================================================================================================================
+ */
+
+#include <time.h>
+#include "hote.h"
+#include "Coroutines.h"
+
+#define GPIO_ENTREE 5
+#define CYCLES_PAR_MS (ESP8266_CLOCK_FREQ / 1000)
+
+typedef Scheduler_Taches<1000,1000000> Taches;
+
+static void Tache_1ms() {}
+static void Tache_1s() {}
+static const Scheduler_Fonction Fonctions[] = {Tache_1ms,Tache_1s};
+
+// Dates de reprise relevées par les tâches
+static uint32 dates[16];
+static uint8 nb_dates = 0;
+static bool drapeau = false;
+
+// Boucle principale simulée pendant "ms" millisecondes
+static void Executer(uint32 ms)
+{
+    for (uint32 i = 0; i < 4 * ms; i++)
+    {
+        Hote_Simuler(CYCLES_PAR_MS / 4);
+        Scheduler_Executer(Fonctions);
+        Coroutines_Executer();
+    }
+}
+
+// 5 attentes de 15ms, le compteur de boucle est dans le contexte
+typedef struct { uint32 boucle; } Contexte_Delais;
+
+static void Sequence_Delais(Coroutine *co)
+{
+    Contexte_Delais *ctx = CO_CONTEXTE(co,Contexte_Delais);
+
+    CO_DEBUT(co);
+    for (ctx->boucle = 0; ctx->boucle < 5; ctx->boucle++)
+    {
+        CO_ATTENDRE_MS(co,15);
+        dates[nb_dates++] = Scheduler_Millis();
+    }
+    CO_FIN(co);
+}
+
+// Front descendant sur GPIO_ENTREE (50ms au plus), deux fois
+static void Sequence_Front(Coroutine *co)
+{
+    CO_DEBUT(co);
+    CO_ATTENDRE_FRONT(co,GPIO_ENTREE,FRONT_DESCENDANT,50);
+    dates[nb_dates++] = Scheduler_Millis() | (CO_EXPIRE(co) ? 0x80000000 : 0);
+    CO_ATTENDRE_FRONT(co,GPIO_ENTREE,FRONT_DESCENDANT,50);
+    dates[nb_dates++] = Scheduler_Millis() | (CO_EXPIRE(co) ? 0x80000000 : 0);
+    CO_FIN(co);
+}
+
+static void Sequence_Condition(Coroutine *co)
+{
+    CO_DEBUT(co);
+    CO_ATTENDRE_QUE(co,drapeau);
+    dates[nb_dates++] = Scheduler_Millis();
+    CO_FIN(co);
+}
+
+// Tâche qui rend la main à chaque passage (mesure du temps de reprise)
+static uint32 nb_passages = 0;
+static void Sequence_Passer(Coroutine *co)
+{
+    CO_DEBUT(co);
+    for (;;)
+    {
+        nb_passages++;
+        CO_PASSER(co);
+    }
+    CO_FIN(co);
+}
+
+int main()
+{
+    Hote_Init();
+    init_GPIO(GPIO_ENTREE,GPIO_INPUT);
+    init_Coroutines();
+    HOTE_VERIFIER(init_Scheduler<Taches>());
+
+    // 1. délais : reprise exactement 15ms après chaque attente
+    Executer(3);
+    uint32 depart = Scheduler_Millis();
+    int8 numero = Coroutine_Demarrer(Sequence_Delais,NULL,0);
+    HOTE_VERIFIER(numero >= 0);
+    Executer(100);
+    HOTE_VERIFIER(nb_dates == 5 && !Coroutine_Active(numero));
+    for (uint8 i = 0; i < nb_dates; i++) HOTE_VERIFIER(dates[i] == depart + 15 * (i + 1));
+
+    // 2. front : réveil par l'interruption après 20ms, puis échéance de 50ms
+    nb_dates = 0;
+    depart = Scheduler_Millis();
+    numero = Coroutine_Demarrer(Sequence_Front,NULL,0);
+    Executer(20);
+    hote_gpio_externe &= ~(1 << GPIO_ENTREE);
+    Executer(5);
+    hote_gpio_externe |= (1 << GPIO_ENTREE);
+    Executer(100);
+    HOTE_VERIFIER(nb_dates == 2 && !Coroutine_Active(numero));
+    HOTE_VERIFIER(dates[0] >= depart + 20 && dates[0] <= depart + 21);
+    HOTE_VERIFIER(dates[1] & 0x80000000);
+    HOTE_VERIFIER((dates[1] & 0x7FFFFFFF) == dates[0] + 50);
+
+    // 3. condition, avec toutes les tâches occupées
+    nb_dates = 0;
+    drapeau = false;
+    int8 numeros[NB_COROUTINES];
+    for (uint8 i = 0; i < NB_COROUTINES; i++) numeros[i] = Coroutine_Demarrer(Sequence_Condition,NULL,0);
+    for (uint8 i = 0; i < NB_COROUTINES; i++) HOTE_VERIFIER(numeros[i] == i);
+    HOTE_VERIFIER(Coroutine_Demarrer(Sequence_Condition,NULL,0) == -1);
+    Executer(10);
+    HOTE_VERIFIER(nb_dates == 0);
+    drapeau = true;
+    Executer(1);
+    HOTE_VERIFIER(nb_dates == NB_COROUTINES);
+    for (uint8 i = 0; i < NB_COROUTINES; i++) HOTE_VERIFIER(!Coroutine_Active(i));
+
+    // 4. contexte trop grand, arrêt d'une tâche en attente
+    uint32 trop_grand[COROUTINE_TAILLE_CONTEXTE + 1];
+    HOTE_VERIFIER(Coroutine_Demarrer(Sequence_Delais,trop_grand,sizeof(trop_grand)) == -1);
+    numero = Coroutine_Demarrer(Sequence_Front,NULL,0);
+    Executer(1);
+    Coroutine_Arreter(numero);
+    HOTE_VERIFIER(!Coroutine_Active(numero));
+    HOTE_VERIFIER((Registre_GPIO->PIN[GPIO_ENTREE] & (0x7 << BIT_GPIO_INT_TYPE)) == 0);
+
+    // 5. mesures : RAM par tâche, temps d'une reprise (PC)
+    for (uint8 i = 0; i < NB_COROUTINES; i++) Coroutine_Demarrer(Sequence_Passer,NULL,0);
+    struct timespec debut, fin;
+    clock_gettime(CLOCK_MONOTONIC,&debut);
+    for (uint32 i = 0; i < 100000; i++) Coroutines_Executer();
+    clock_gettime(CLOCK_MONOTONIC,&fin);
+    double ns = ((fin.tv_sec - debut.tv_sec) * 1e9 + (fin.tv_nsec - debut.tv_nsec)) / nb_passages;
+    HOTE_VERIFIER(nb_passages == 100000 * NB_COROUTINES);
+
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+    printf("coroutines : %u octets par tache (dont %u de contexte), reprise %.1f ns sur PC\n",
+           (uint32)sizeof(Coroutine),(uint32)sizeof(Coroutines[0].contexte),ns);
+    return Hote_Bilan("test_coroutines");
+}
+
+/* fin du fichier */
@@ -0,0 +1,270 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_ecran.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Ecran.cpp SPI_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de l'écran à buffer (Ecran.h) et du SPI par interruption (SPI_esp8266.h) sur PC, contrôleur d'écran simulé
+ *  derrière le HSPI (octets des paquets décodés selon le niveau D/C) :
+ *  - SSD1306 128 x 64 monochrome : premier envoi complet, compteur + barre de progression (octets envoyés
+ *    comparés à une trame complète), dessin identique sans envoi, dessin pendant l'envoi, rectangles aléatoires
+ *  - aucun transfert démarré avant l'acquittement du précédent
+ *  - RLE : écran complet, zone étendue aux pages, sortie trop petite, aller-retour sur des images aléatoires
+ *  - ST7789 240 x 80 RGB565 : mêmes vérifications de l'écran simulé
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Ecran.h"
+#include <stdlib.h>
+#include <vector>
+
+#define GPIO_DC 5
+#define NB_TRAMES 100
+
+// Contrôleur simulé : SSD1306 (adressage horizontal, commandes 0x21 / 0x22) ou ST7789 (0x2A / 0x2B / 0x2C)
+typedef struct{
+  bool mono;
+  uint16 largeur, hauteur;
+  std::vector<uint8> ram;
+  int16 commande;
+  std::vector<uint8> parametres;
+  uint16 c0, c1, p0, p1, c, p;
+  uint16 x0, x1, y0, y1, x, y;
+  int16 demi;
+} Controleur;
+
+static Controleur ecran;
+static uint32 octets_bus = 0, nb_transferts_non_acquittes = 0;
+static bool interruption = false;
+
+static void Init_Controleur(bool mono, uint16 largeur, uint16 hauteur)
+{
+    ecran.mono = mono;
+    ecran.largeur = largeur;
+    ecran.hauteur = hauteur;
+    ecran.ram.assign(mono ? largeur * hauteur / 8 : largeur * hauteur * 2,0);
+    ecran.commande = ecran.demi = -1;
+}
+
+static void Octet_Controleur(bool dc, uint8 valeur)
+{
+    if (ecran.mono)
+    {
+        if (!dc)
+        {
+            if (ecran.commande < 0) { ecran.commande = valeur; ecran.parametres.clear(); return; }
+            ecran.parametres.push_back(valeur);
+            if (ecran.parametres.size() < 2) return;
+            if (ecran.commande == 0x21) { ecran.c0 = ecran.c = ecran.parametres[0]; ecran.c1 = ecran.parametres[1]; }
+            if (ecran.commande == 0x22) { ecran.p0 = ecran.p = ecran.parametres[0]; ecran.p1 = ecran.parametres[1]; }
+            ecran.commande = -1;
+            return;
+        }
+        ecran.ram[ecran.p * ecran.largeur + ecran.c] = valeur;
+        if (++ecran.c > ecran.c1) { ecran.c = ecran.c0; if (++ecran.p > ecran.p1) ecran.p = ecran.p0; }
+        return;
+    }
+    if (!dc)
+    {
+        ecran.commande = valeur;
+        ecran.parametres.clear();
+        ecran.demi = -1;
+        if (valeur == 0x2C) { ecran.x = ecran.x0; ecran.y = ecran.y0; }
+        return;
+    }
+    if (ecran.commande == 0x2A || ecran.commande == 0x2B)
+    {
+        ecran.parametres.push_back(valeur);
+        if (ecran.parametres.size() < 4) return;
+        uint16 debut = (ecran.parametres[0] << 8) | ecran.parametres[1], fin = (ecran.parametres[2] << 8) | ecran.parametres[3];
+        if (ecran.commande == 0x2A) { ecran.x0 = debut; ecran.x1 = fin; }
+        else { ecran.y0 = debut; ecran.y1 = fin; }
+        return;
+    }
+    if (ecran.commande == 0x2C)
+    {
+        ecran.ram[(ecran.y * ecran.largeur + ecran.x) * 2 + (ecran.demi < 0 ? 0 : 1)] = valeur;
+        if (ecran.demi < 0) { ecran.demi = valeur; return; }
+        ecran.demi = -1;
+        if (++ecran.x > ecran.x1) { ecran.x = ecran.x0; if (++ecran.y > ecran.y1) ecran.y = ecran.y0; }
+    }
+}
+
+// HSPI : le transfert est fait dès l'écriture de CMD, fin de transfert signalée par SLAVE et SPI_INT_STATUS
+static void Ecriture(__Registre *registre, uint32 valeur)
+{
+    if (registre != &Registre_SPI1->CMD || !(valeur & (1 << BIT_SPI_USR))) return;
+    if (Registre_SPI1->SLAVE & (1 << BIT_SPI_TRANS_DONE)) nb_transferts_non_acquittes++;
+
+    uint32 nombre = (((Registre_SPI1->USER1 >> BIT_SPI_USR_MOSI_BITLEN) & 0x1FF) + 1) / 8;
+    bool dc = (Registre_GPIO->OUT >> GPIO_DC) & 1;
+    for (uint32 i = 0; i < nombre; i++) Octet_Controleur(dc,(Registre_SPI1->W[i / 4] >> (8 * (i % 4))) & 0xFF);
+    octets_bus += nombre;
+
+    Registre_SPI1->CMD &= ~(1 << BIT_SPI_USR);
+    Registre_SPI1->SLAVE |= (1 << BIT_SPI_TRANS_DONE);
+    interruption = true;
+}
+
+static bool Lecture(__Registre *registre, uint32 *valeur)
+{
+    if (registre != &Registre_SPI_INT_STATUS) return false;
+    *valeur = (Registre_SPI1->SLAVE & (1 << BIT_SPI_TRANS_DONE)) ? (1 << BIT_SPI_INT_HSPI) : 0;
+    return true;
+}
+
+// Envoi complet ; "pendant" : dessin appelé entre deux paquets
+static void Vider(void (*pendant)(uint32) = NULL)
+{
+    uint32 k = 0;
+    do
+    {
+        Ecran_Tache();
+        while (interruption)
+        {
+            interruption = false;
+            if (pendant != NULL) pendant(k++);
+            Hote_Declencher(ETS_SPI_INUM);
+        }
+    } while (Ecran_Tache() || SPI_Occupe());
+}
+
+static uint32 Mesurer()
+{
+    uint32 avant = octets_bus;
+    Vider();
+    return octets_bus - avant;
+}
+
+static uint8 image[240 * 80 * 2];
+static bool Identique()
+{
+    return memcmp(image,&ecran.ram[0],ECRAN_TAILLE_BUFFER(ecran.mono ? ECRAN_MONO : ECRAN_RGB565,ecran.largeur,ecran.hauteur)) == 0;
+}
+
+// Police 5 x 8 (chiffres)
+static const uint8 Chiffres[10][8] = {
+    {0x70,0x88,0x98,0xA8,0xC8,0x88,0x70,0}, {0x20,0x60,0x20,0x20,0x20,0x20,0x70,0}, {0x70,0x88,0x08,0x10,0x20,0x40,0xF8,0},
+    {0xF8,0x10,0x20,0x10,0x08,0x88,0x70,0}, {0x10,0x30,0x50,0x90,0xF8,0x10,0x10,0}, {0xF8,0x80,0xF0,0x08,0x08,0x88,0x70,0},
+    {0x30,0x40,0x80,0xF0,0x88,0x88,0x70,0}, {0xF8,0x08,0x10,0x20,0x40,0x40,0x40,0}, {0x70,0x88,0x88,0x70,0x88,0x88,0x70,0},
+    {0x70,0x88,0x88,0x78,0x08,0x10,0x60,0}};
+static void Texte(uint16 x, uint16 y, uint32 valeur, uint16 couleur, uint16 fond)
+{
+    char chaine[8];
+    sprintf(chaine,"%05u",valeur % 100000);
+    for (uint8 i = 0; chaine[i]; i++) Ecran_Dessiner_Bitmap(x + 6 * i,y,6,8,Chiffres[chaine[i] - '0'],couleur,fond);
+}
+
+static void Pixels_Pendant_Envoi(uint32 paquet)
+{
+    if (paquet < 30 && (paquet % 3) == 0)
+    {
+        for (uint8 i = 0; i < 20; i++) Ecran_Pixel(rand() % 128,rand() % 64,rand() & 1);
+    }
+}
+
+int main()
+{
+    static uint8 rle[2048], decompresse[2048];
+
+    Hote_Init();
+    srand(1);
+    hote_crochet_ecriture = Ecriture;
+    hote_crochet_lecture = Lecture;
+
+    // 1. SSD1306 128 x 64
+    init_SPI(8000000,SPI_MODE_0,GPIO_DC);
+    Init_Controleur(true,128,64);
+    HOTE_VERIFIER(init_Ecran(ECRAN_MONO,128,64,image));
+    uint32 plein = Mesurer();
+    HOTE_VERIFIER(Identique() && plein >= 1024);
+
+    // compteur + barre de progression : seules les tuiles modifiées sont envoyées
+    uint32 total = 0;
+    for (uint32 t = 0; t < NB_TRAMES; t++)
+    {
+        Texte(40,28,t * 7,ECRAN_BLANC,ECRAN_NOIR);
+        Ecran_Remplir_Rectangle(4,56,t + 1,4,ECRAN_BLANC);
+        total += Mesurer();
+    }
+    HOTE_VERIFIER(Identique() && total / NB_TRAMES < plein / 4);
+    printf("ecran : SSD1306, trame complete %u octets, compteur + barre %u octets par trame\n",plein,total / NB_TRAMES);
+    Texte(40,28,(NB_TRAMES - 1) * 7,ECRAN_BLANC,ECRAN_NOIR);
+    HOTE_VERIFIER(Mesurer() == 0 && Ecran_Nb_Tuiles_A_Envoyer() == 0);
+
+    // dessin pendant l'envoi
+    Ecran_Tout_Envoyer();
+    Ecran_Effacer(ECRAN_BLANC);
+    Vider(Pixels_Pendant_Envoi);
+    HOTE_VERIFIER(Identique());
+
+    // rectangles aléatoires (hors écran compris), envois intercalés
+    bool conforme = true;
+    for (uint32 t = 0; t < 300 && conforme; t++)
+    {
+        uint8 nb = rand() % 4;
+        for (uint8 i = 0; i < nb; i++) Ecran_Remplir_Rectangle(rand() % 140,rand() % 70,rand() % 40,rand() % 30,rand() & 1);
+        if (rand() % 2) { Vider(); conforme = Identique(); }
+    }
+    Vider();
+    HOTE_VERIFIER(conforme && Identique() && nb_transferts_non_acquittes == 0);
+
+    // 2. RLE
+    Ecran_Effacer(ECRAN_NOIR);
+    Texte(10,8,12345,ECRAN_BLANC,ECRAN_NOIR);
+    Ecran_Remplir_Rectangle(0,40,128,3,ECRAN_BLANC);
+    Ecran_Remplir_Rectangle(0,48,60,16,ECRAN_BLANC);
+    Vider();
+    uint16 nb = Ecran_Compresser_RLE(0,0,128,64,rle,sizeof(rle));
+    uint16 nb_decompresses = Ecran_Decompresser_RLE(rle,nb,decompresse,sizeof(decompresse));
+    HOTE_VERIFIER(nb > 0 && nb < 1024 / 4 && nb_decompresses == 1024 && memcmp(decompresse,image,1024) == 0);
+    printf("ecran : RLE de l'ecran complet, 1024 -> %u octets\n",nb);
+    nb = Ecran_Compresser_RLE(40,28,30,8,rle,sizeof(rle));
+    nb_decompresses = Ecran_Decompresser_RLE(rle,nb,decompresse,sizeof(decompresse));
+    bool zone = (nb_decompresses == 60);
+    for (uint8 page = 3; page < 5 && zone; page++) zone = memcmp(decompresse + (page - 3) * 30,image + page * 128 + 40,30) == 0;
+    HOTE_VERIFIER(zone);
+    HOTE_VERIFIER(Ecran_Compresser_RLE(0,0,128,64,rle,10) == 0);
+    conforme = true;
+    for (uint32 k = 0; k < 200 && conforme; k++)
+    {
+        for (uint32 i = 0; i < 1024; i++) image[i] = (rand() % 4) ? (i ? image[i - 1] : 0) : rand();
+        nb = Ecran_Compresser_RLE(0,0,128,64,rle,sizeof(rle));
+        nb_decompresses = Ecran_Decompresser_RLE(rle,nb,decompresse,sizeof(decompresse));
+        conforme = nb > 0 && nb_decompresses == 1024 && memcmp(decompresse,image,1024) == 0;
+    }
+    HOTE_VERIFIER(conforme);
+
+    // 3. ST7789 240 x 80 RGB565
+    init_SPI(40000000,SPI_MODE_3,GPIO_DC);
+    Init_Controleur(false,240,80);
+    HOTE_VERIFIER(init_Ecran(ECRAN_RGB565,240,80,image));
+    Ecran_Effacer(0x001F);
+    plein = Mesurer();
+    HOTE_VERIFIER(Identique() && plein >= 240 * 80 * 2);
+    total = 0;
+    for (uint32 t = 0; t < NB_TRAMES; t++)
+    {
+        Texte(100,36,t * 13,0xFFFF,0x001F);
+        Ecran_Remplir_Rectangle(0,76,t * 2 + 2,4,0xF800);
+        total += Mesurer();
+    }
+    HOTE_VERIFIER(Identique() && total / NB_TRAMES < plein / 4);
+    printf("ecran : ST7789, trame complete %u octets, compteur + barre %u octets par trame\n",plein,total / NB_TRAMES);
+    conforme = true;
+    for (uint32 t = 0; t < 200 && conforme; t++)
+    {
+        for (uint8 i = 0; i < 3; i++) Ecran_Remplir_Rectangle(rand() % 250,rand() % 90,rand() % 60,rand() % 40,rand());
+        Vider();
+        conforme = Identique();
+    }
+    HOTE_VERIFIER(conforme && nb_transferts_non_acquittes == 0);
+
+    return Hote_Bilan("test_ecran");
+}
+
+/* fin du fichier */
@@ -0,0 +1,203 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_entrees.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Entrees.cpp GPIO_esp8266.cpp UART_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test des entrées des panneaux (Entrees.h) sur PC, clavier 4 x 3 et deux codeurs simulés sur les lignes GPIO :
+ *  - paramètres : clavier trop grand, GPIO invalide, nombre de codeurs limité
+ *  - clavier : appui franc validé après ENTREES_ECHANTILLONS_REBOND balayages, rebonds ignorés,
+ *    touches simultanées, un seul accès au registre IN par appel de Entrees_Tache
+ *  - codeurs : crans dans les deux sens, rebonds sur une voie, deux codeurs en même temps
+ *  - file d'évènements pleine : évènements perdus comptés
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Entrees.h"
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+#define NB_LIGNES 4
+#define NB_COLONNES 3
+
+static const uint8 lignes[NB_LIGNES] = {GPIO12, GPIO13, GPIO14, GPIO15};
+static const uint8 colonnes[NB_COLONNES] = {GPIO0, GPIO2, GPIO4};
+
+// Touches appuyées (bit n : colonne x NB_LIGNES + ligne) et niveau des voies des codeurs
+static uint32 touches = 0;
+static uint32 voies = 0xFFFFFFFF;
+
+// Une touche appuyée relie sa ligne à sa colonne : la ligne passe à l'état bas avec la colonne
+static void Simuler_Clavier()
+{
+    uint32 colonnes_basses = Registre_GPIO->ENABLE & ~Registre_GPIO->OUT;
+    uint32 niveaux = voies;
+
+    for (uint8 c = 0; c < NB_COLONNES; c++)
+    {
+        if (!READ_BIT(colonnes_basses,colonnes[c])) continue;
+        for (uint8 l = 0; l < NB_LIGNES; l++)
+        {
+            if (READ_BIT(touches,(c * NB_LIGNES + l))) CLR_BIT(niveaux,lignes[l]);
+        }
+    }
+    hote_gpio_externe = niveaux;
+}
+
+// Lectures du registre IN
+static uint32 nb_lectures_in = 0;
+static bool Lecture(__Registre *registre, uint32 *valeur)
+{
+    if (registre == &Registre_GPIO->IN) nb_lectures_in++;
+    return false;
+}
+
+// Boucle principale : Entrees_Tache toutes les millisecondes
+static void Boucle(uint32 ms)
+{
+    for (uint32 t = 0; t < ms; t++)
+    {
+        Hote_Simuler(1000 * CYCLES_PAR_US);
+        Entrees_Tache();
+    }
+}
+
+// Lit tous les évènements : nombre d'évènements, dernier évènement, somme des crans par codeur
+static uint32 Lire_Evenements(Entree_Evenement *dernier, int32 *crans)
+{
+    Entree_Evenement evenement;
+    uint32 nb = 0;
+
+    while (Entrees_Lire_Evenement(&evenement))
+    {
+        if (evenement.type == ENTREE_CODEUR && crans != NULL) crans[evenement.source] += evenement.valeur;
+        if (dernier != NULL) *dernier = evenement;
+        nb++;
+    }
+    return nb;
+}
+
+// Quadrature : une transition sur la voie A ou B d'un codeur (00 -> 01 -> 11 -> 10 : sens positif)
+static uint8 phase[2] = {2, 2};  // voies au repos à l'état haut (AB = 11)
+static const uint8 sequence[4] = {0, 1, 3, 2};
+static void Transition(const uint8 *gpio, uint8 codeur, int8 sens)
+{
+    phase[codeur] = (phase[codeur] + sens) & 3;
+    uint8 ab = sequence[phase[codeur]];
+    if (ab & 2) SET_BIT(voies,gpio[2 * codeur]); else CLR_BIT(voies,gpio[2 * codeur]);
+    if (ab & 1) SET_BIT(voies,gpio[2 * codeur + 1]); else CLR_BIT(voies,gpio[2 * codeur + 1]);
+}
+
+int main()
+{
+    static const uint8 gpio_codeurs[4] = {GPIO5, GPIO3, GPIO9, GPIO10};  // A0 B0 A1 B1
+    uint8 trop_de_lignes[ENTREES_NB_LIGNES_MAX + 1] = {0};
+    Entree_Evenement evenement;
+    int32 crans[2] = {0, 0};
+
+    Hote_Init();
+    hote_pas_simulation = 80;
+    hote_crochet_simulation = Simuler_Clavier;
+    hote_crochet_lecture = Lecture;
+    Simuler_Clavier();
+
+    // 1. paramètres
+    HOTE_VERIFIER(!init_Clavier(trop_de_lignes,ENTREES_NB_LIGNES_MAX + 1,colonnes,1));
+    HOTE_VERIFIER(!init_Clavier(lignes,ENTREES_NB_LIGNES_MAX,trop_de_lignes,ENTREES_NB_COLONNES_MAX));
+    HOTE_VERIFIER(init_Clavier(lignes,NB_LIGNES,colonnes,NB_COLONNES));
+    HOTE_VERIFIER(Entrees_Ajouter_Codeur(gpio_codeurs[0],gpio_codeurs[1]) == 0);
+    HOTE_VERIFIER(Entrees_Ajouter_Codeur(gpio_codeurs[2],gpio_codeurs[3]) == 1);
+    HOTE_VERIFIER(Entrees_Ajouter_Codeur(16,GPIO1) == -1);
+    HOTE_VERIFIER(Entrees_Ajouter_Codeur(GPIO1,GPIO6) == 2 && Entrees_Ajouter_Codeur(GPIO7,GPIO8) == 3);
+    HOTE_VERIFIER(Entrees_Ajouter_Codeur(GPIO11,GPIO1) == -1);
+    ETS_GPIO_INTR_ENABLE();
+    Boucle(50);
+    HOTE_VERIFIER(Lire_Evenements(NULL,NULL) == 0 && Entrees_Touches() == 0);
+
+    // 2. appui franc sur la touche 6 (colonne 1, ligne 2) : validé après 4 balayages complets (12ms)
+    nb_lectures_in = 0;
+    touches = 1 << 6;
+    uint32 ms = 0;
+    while (Entrees_Touches() == 0 && ms < 100) { Boucle(1); ms++; }
+    HOTE_VERIFIER(ms >= (ENTREES_ECHANTILLONS_REBOND - 1) * NB_COLONNES && ms <= (ENTREES_ECHANTILLONS_REBOND + 1) * NB_COLONNES);
+    HOTE_VERIFIER(nb_lectures_in == ms && Entrees_Touches() == (1 << 6));
+    HOTE_VERIFIER(Lire_Evenements(&evenement,NULL) == 1 && evenement.type == ENTREE_APPUI && evenement.source == 6);
+
+    // 3. rebonds pendant 30ms : aucun évènement, puis relâchement franc
+    for (uint32 t = 0; t < 30; t++)
+    {
+        touches = (t & 1) ? (1 << 6) : 0;
+        Boucle(1);
+    }
+    HOTE_VERIFIER(Lire_Evenements(NULL,NULL) == 0 && Entrees_Touches() == (1 << 6));
+    touches = 0;
+    Boucle(20);
+    HOTE_VERIFIER(Lire_Evenements(&evenement,NULL) == 1 && evenement.type == ENTREE_RELACHEMENT && evenement.source == 6);
+
+    // 4. touches simultanées de trois colonnes
+    touches = (1 << 0) | (1 << 7) | (1 << 11);
+    Boucle(20);
+    HOTE_VERIFIER(Entrees_Touches() == touches && Lire_Evenements(NULL,NULL) == 3);
+    touches = 0;
+    Boucle(20);
+    HOTE_VERIFIER(Entrees_Touches() == 0 && Lire_Evenements(NULL,NULL) == 3);
+
+    // 5. codeur 0 : 25 crans dans le sens positif (une transition toutes les 200us), puis 10 crans en arrière
+    for (uint32 i = 0; i < 25 * ENTREES_TRANSITIONS_PAR_CRAN; i++)
+    {
+        Transition(gpio_codeurs,0,+1);
+        Hote_Simuler(200 * CYCLES_PAR_US);
+        if (i % 5 == 4) Entrees_Tache();
+    }
+    Boucle(2);
+    Lire_Evenements(NULL,crans);
+    HOTE_VERIFIER(crans[0] == 25 && Entrees_Position_Codeur(0) == 25 * ENTREES_TRANSITIONS_PAR_CRAN);
+    for (uint32 i = 0; i < 10 * ENTREES_TRANSITIONS_PAR_CRAN; i++)
+    {
+        Transition(gpio_codeurs,0,-1);
+        Hote_Simuler(200 * CYCLES_PAR_US);
+    }
+    Boucle(2);
+    Lire_Evenements(NULL,crans);
+    HOTE_VERIFIER(crans[0] == 15 && crans[1] == 0);
+
+    // 6. rebonds : chaque transition est suivie d'allers-retours de quelques us, codeurs 0 et 1 en même temps
+    for (uint32 i = 0; i < 8 * ENTREES_TRANSITIONS_PAR_CRAN; i++)
+    {
+        Transition(gpio_codeurs,0,+1);
+        Transition(gpio_codeurs,1,-1);
+        for (uint8 r = 0; r < 3; r++)
+        {
+            Hote_Simuler(3 * CYCLES_PAR_US);
+            Transition(gpio_codeurs,0,-1);
+            Hote_Simuler(3 * CYCLES_PAR_US);
+            Transition(gpio_codeurs,0,+1);
+        }
+        Hote_Simuler(300 * CYCLES_PAR_US);
+        Entrees_Tache();
+    }
+    Boucle(2);
+    Lire_Evenements(NULL,crans);
+    HOTE_VERIFIER(crans[0] == 23 && crans[1] == -8);
+    HOTE_VERIFIER(Entrees_Position_Codeur(1) == -8 * ENTREES_TRANSITIONS_PAR_CRAN);
+
+    // 7. file pleine : 40 appuis / relâchements non lus
+    HOTE_VERIFIER(Entrees_Evenements_Perdus() == 0);
+    for (uint32 i = 0; i < 20; i++)
+    {
+        touches = 1 << (i % (NB_LIGNES * NB_COLONNES));
+        Boucle(20);
+        touches = 0;
+        Boucle(20);
+    }
+    HOTE_VERIFIER(Lire_Evenements(NULL,NULL) == ENTREES_TAILLE_FILE && Entrees_Evenements_Perdus() == 40 - ENTREES_TAILLE_FILE);
+
+    hote_crochet_lecture = NULL;
+    hote_crochet_simulation = NULL;
+    return Hote_Bilan("test_entrees");
+}
+
+/* fin du fichier */
@@ -0,0 +1,246 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_filtres.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  :
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test des filtres en virgule fixe (Filtres.h, en-tête uniquement) sur PC, comparés à un calcul de référence en double
+ *  sur deux signaux ADC 12 bits bruités :
+ *  - médianes de 3, 5, 7 et 9 : principe 0-1 (toutes les entrées binaires) et entrées aléatoires, voies d'une paire
+ *  - EMA et moyenne glissante : écart à la référence inférieur à 1 LSB, voies d'une paire indépendantes
+ *  - biquad passe-bas Q14 : écart à la référence borné, gain statique exact après ajustement de b1
+ *  - hystérésis : version paire identique à deux filtres scalaires
+ *  - durée sur PC (ns par échantillon) de l'EMA, de la moyenne glissante, de la médiane de 5 et du biquad, en virgule fixe,
+ *    en paires (SWAR) et en double (référence), et rapport double / virgule fixe
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Filtres.h"
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+
+#define NB_ECHANTILLONS 200000
+#define NB_PASSES 20
+
+static int16 signal_0[NB_ECHANTILLONS], signal_1[NB_ECHANTILLONS];
+
+// Médiane : réseau de tri comparé au tri complet
+template <uint8 TAILLE> static uint32 Erreurs_Mediane()
+{
+    uint32 erreurs = 0;
+
+    // principe 0-1 : un réseau qui trie toutes les entrées binaires trie toutes les entrées
+    for (uint32 masque = 0; masque < (1UL << TAILLE); masque++)
+    {
+        int16 v[TAILLE];
+        uint8 uns = 0;
+        for (uint8 i = 0; i < TAILLE; i++) { v[i] = (masque >> i) & 1; uns += v[i]; }
+        if (Filtre_Reseau_Mediane<int16,TAILLE>::Calculer(v) != (uns > TAILLE / 2)) erreurs++;
+    }
+    // entrées aléatoires, scalaires et paires
+    for (uint32 k = 0; k < 20000; k++)
+    {
+        int16 v[TAILLE], tri[TAILLE];
+        uint16 a[TAILLE], b[TAILLE];
+        uint32 paires[TAILLE];
+        for (uint8 i = 0; i < TAILLE; i++)
+        {
+            v[i] = tri[i] = (int16)(rand() % 65536 - 32768);
+            a[i] = rand() & FILTRE_PAIRE_VALEUR_MAX;
+            b[i] = rand() & FILTRE_PAIRE_VALEUR_MAX;
+            paires[i] = Filtre_Paire(a[i],b[i]);
+        }
+        int16 mediane = Filtre_Reseau_Mediane<int16,TAILLE>::Calculer(v);
+        uint32 mediane_paire = Filtre_Reseau_Mediane<uint32,TAILLE>::Calculer(paires);
+        std::sort(tri,tri + TAILLE);
+        std::sort(a,a + TAILLE);
+        std::sort(b,b + TAILLE);
+        if (mediane != tri[TAILLE / 2]) erreurs++;
+        if (Filtre_Voie(mediane_paire,0) != a[TAILLE / 2] || Filtre_Voie(mediane_paire,1) != b[TAILLE / 2]) erreurs++;
+    }
+    return erreurs;
+}
+
+// Durée d'un filtre sur PC (ns par appel) : NB_PASSES passes sur le signal 0 (et 1 pour les paires)
+static volatile int32 puits;
+template <typename CALCUL> static double Chronometrer(CALCUL calcul)
+{
+    int32 somme = 0;
+    auto debut = std::chrono::steady_clock::now();
+    for (uint32 passe = 0; passe < NB_PASSES; passe++)
+    {
+        for (uint32 i = 0; i < NB_ECHANTILLONS; i++) somme += calcul(i);
+    }
+    auto fin = std::chrono::steady_clock::now();
+    puits = somme;
+    return std::chrono::duration<double,std::nano>(fin - debut).count() / ((double)NB_PASSES * NB_ECHANTILLONS);
+}
+
+static void Afficher_Durees(const char *nom, double ns_fixe, double ns_paire, double ns_double)
+{
+    printf("filtres : %-10s %5.2f ns par echantillon, paire %5.2f ns par echantillon, double %5.2f ns (x%.1f) (sur PC)\n",
+           nom,ns_fixe,ns_paire / 2,ns_double,ns_double / ns_fixe);
+}
+
+int main()
+{
+    Hote_Init();
+    srand(1);
+    for (uint32 i = 0; i < NB_ECHANTILLONS; i++)
+    {
+        signal_0[i] = (int16)(2048 + 1500 * sin(i * 0.001) + (rand() % 201 - 100));
+        signal_1[i] = (int16)(1000 + 800 * sin(i * 0.0037) + (rand() % 101 - 50));
+    }
+
+    // 1. médianes
+    HOTE_VERIFIER(Erreurs_Mediane<3>() == 0 && Erreurs_Mediane<5>() == 0);
+    HOTE_VERIFIER(Erreurs_Mediane<7>() == 0 && Erreurs_Mediane<9>() == 0);
+    Filtre_Mediane<int16,5> mediane;
+    Filtre_Mediane_Init(&mediane,0);
+    static const int16 pics[8] = {10, 11, 3000, 12, 13, -3000, 14, 15};
+    int16 sortie_mediane = 0;
+    for (uint8 i = 0; i < 8; i++) sortie_mediane = Filtre_Mediane_Ajouter(&mediane,pics[i]);
+    HOTE_VERIFIER(sortie_mediane == 13);
+
+    // 2. EMA (coefficient 1/16) : scalaire arrondie au plus près, paire tronquée
+    Filtre_EMA<4> ema;
+    Filtre_EMA_Paire<4,12> ema_paire;
+    Filtre_EMA_Init(&ema,signal_0[0]);
+    Filtre_EMA_Paire_Init(&ema_paire,Filtre_Paire(signal_0[0],signal_1[0]));
+    double reference_0 = signal_0[0], reference_1 = signal_1[0];
+    double ecart_ema = 0, ecart_ema_paire = 0;
+    for (uint32 i = 0; i < NB_ECHANTILLONS; i++)
+    {
+        reference_0 += (signal_0[i] - reference_0) / 16;
+        reference_1 += (signal_1[i] - reference_1) / 16;
+        int16 y = Filtre_EMA_Ajouter(&ema,signal_0[i]);
+        uint32 paire = Filtre_EMA_Paire_Ajouter(&ema_paire,Filtre_Paire(signal_0[i],signal_1[i]));
+        ecart_ema = fmax(ecart_ema,fabs(y - reference_0));
+        ecart_ema_paire = fmax(ecart_ema_paire,fmax(fabs(Filtre_Voie(paire,0) - reference_0),fabs(Filtre_Voie(paire,1) - reference_1)));
+    }
+    HOTE_VERIFIER(ecart_ema < 0.51 && ecart_ema_paire < 1);
+
+    // 3. moyennes glissantes sur 10 et 16 échantillons
+    Filtre_Moyenne<10> moyenne;
+    Filtre_Moyenne_Paire<16,12> moyenne_paire;
+    Filtre_Moyenne_Paire<10,12> moyenne_paire_10;
+    Filtre_Moyenne_Init(&moyenne,signal_0[0]);
+    Filtre_Moyenne_Paire_Init(&moyenne_paire,Filtre_Paire(signal_0[0],signal_1[0]));
+    Filtre_Moyenne_Paire_Init(&moyenne_paire_10,Filtre_Paire(signal_0[0],signal_1[0]));
+    double ecart_moyenne = 0, ecart_moyenne_paire = 0;
+    for (uint32 i = 0; i < NB_ECHANTILLONS; i++)
+    {
+        int16 y = Filtre_Moyenne_Ajouter(&moyenne,signal_0[i]);
+        uint32 paire = Filtre_Moyenne_Paire_Ajouter(&moyenne_paire,Filtre_Paire(signal_0[i],signal_1[i]));
+        uint32 paire_10 = Filtre_Moyenne_Paire_Ajouter(&moyenne_paire_10,Filtre_Paire(signal_0[i],signal_1[i]));
+        double r0 = 0, r1 = 0, r0_10 = 0, r1_10 = 0;
+        for (uint32 k = 0; k < 16; k++)
+        {
+            uint32 j = (i >= k) ? i - k : 0;
+            r0 += signal_0[j];
+            r1 += signal_1[j];
+            if (k < 10) { r0_10 += signal_0[j]; r1_10 += signal_1[j]; }
+        }
+        ecart_moyenne = fmax(ecart_moyenne,fabs(y - r0_10 / 10));
+        ecart_moyenne_paire = fmax(ecart_moyenne_paire,fmax(fabs(Filtre_Voie(paire,0) - r0 / 16),fabs(Filtre_Voie(paire,1) - r1 / 16)));
+        ecart_moyenne_paire = fmax(ecart_moyenne_paire,fmax(fabs(Filtre_Voie(paire_10,0) - r0_10 / 10),fabs(Filtre_Voie(paire_10,1) - r1_10 / 10)));
+    }
+    HOTE_VERIFIER(ecart_moyenne < 0.51 && ecart_moyenne_paire < 1);
+
+    // 4. biquad passe-bas de Butterworth, fc = fs / 100
+    double w = 2 * M_PI * 0.01, alpha = sin(w) / (2 * sqrt(0.5)), a0 = 1 + alpha;
+    double b0 = (1 - cos(w)) / 2 / a0, b1 = (1 - cos(w)) / a0, b2 = b0, a1 = -2 * cos(w) / a0, a2 = (1 - alpha) / a0;
+    Filtre_Coefficients_Biquad coefficients = {FILTRE_COEF_Q14(b0),FILTRE_COEF_Q14(b1),FILTRE_COEF_Q14(b2),FILTRE_COEF_Q14(a1),FILTRE_COEF_Q14(a2)};
+    coefficients.b1 = 16384 + coefficients.a1 + coefficients.a2 - coefficients.b0 - coefficients.b2;  // gain statique exactement 1
+    double q_b0 = coefficients.b0 / 16384.0, q_b1 = coefficients.b1 / 16384.0, q_b2 = coefficients.b2 / 16384.0;
+    double q_a1 = coefficients.a1 / 16384.0, q_a2 = coefficients.a2 / 16384.0;
+    Filtre_Biquad biquad;
+    Filtre_Biquad_Init(&biquad,&coefficients,signal_0[0]);
+    double x1 = signal_0[0], x2 = signal_0[0], y1 = signal_0[0], y2 = signal_0[0], ecart_biquad = 0;
+    for (uint32 i = 0; i < NB_ECHANTILLONS; i++)
+    {
+        int16 y = Filtre_Biquad_Ajouter(&biquad,signal_0[i]);
+        double r = q_b0 * signal_0[i] + q_b1 * x1 + q_b2 * x2 - q_a1 * y1 - q_a2 * y2;
+        x2 = x1; x1 = signal_0[i]; y2 = y1; y1 = r;
+        ecart_biquad = fmax(ecart_biquad,fabs(y - r));
+    }
+    int16 regime_etabli = 0;
+    for (uint32 i = 0; i < 5000; i++) regime_etabli = Filtre_Biquad_Ajouter(&biquad,1234);
+    HOTE_VERIFIER(ecart_biquad < 6 && regime_etabli == 1234);
+
+    // 5. hystérésis : paire identique à deux filtres scalaires
+    Filtre_Hysteresis hysteresis_0, hysteresis_1;
+    Filtre_Hysteresis_Paire hysteresis_paire;
+    Filtre_Hysteresis_Init(&hysteresis_0,1800,2200,false);
+    Filtre_Hysteresis_Init(&hysteresis_1,900,1100,true);
+    Filtre_Hysteresis_Paire_Init(&hysteresis_paire,Filtre_Paire(1800,900),Filtre_Paire(2200,1100),2);
+    uint32 ecarts_hysteresis = 0, bascules = 0;
+    bool precedent = false;
+    for (uint32 i = 0; i < NB_ECHANTILLONS; i++)
+    {
+        bool etat_0 = Filtre_Hysteresis_Ajouter(&hysteresis_0,signal_0[i]);
+        bool etat_1 = Filtre_Hysteresis_Ajouter(&hysteresis_1,signal_1[i]);
+        uint8 etats = Filtre_Hysteresis_Paire_Ajouter(&hysteresis_paire,Filtre_Paire(signal_0[i],signal_1[i]));
+        if (etats != (etat_0 | (etat_1 << 1))) ecarts_hysteresis++;
+        if (etat_0 != precedent) bascules++;
+        precedent = etat_0;
+    }
+    // une bascule par passage du sinus (période 6283 échantillons), aucune sur le bruit (+/- 100 < 200 LSB d'hystérésis)
+    HOTE_VERIFIER(ecarts_hysteresis == 0 && bascules == 2 * (uint32)(NB_ECHANTILLONS * 0.001 / (2 * M_PI) + 0.5));
+
+    // 6. durées : virgule fixe, paires (deux voies par appel) et référence en double
+    // (le PC calcule les doubles en matériel : sur l'ESP8266, sans FPU, l'écart est bien plus grand)
+    Filtre_EMA_Init(&ema,signal_0[0]);
+    Filtre_EMA_Paire_Init(&ema_paire,Filtre_Paire(signal_0[0],signal_1[0]));
+    double ema_double = signal_0[0];
+    Afficher_Durees("EMA",
+        Chronometrer([&](uint32 i) { return Filtre_EMA_Ajouter(&ema,signal_0[i]); }),
+        Chronometrer([&](uint32 i) { return (int32)Filtre_EMA_Paire_Ajouter(&ema_paire,Filtre_Paire(signal_0[i],signal_1[i])); }),
+        Chronometrer([&](uint32 i) { ema_double += (signal_0[i] - ema_double) / 16; return (int32)ema_double; }));
+
+    double fenetre_double[10] = {0}, somme_double = 0;
+    uint8 position_double = 0;
+    Afficher_Durees("moyenne 10",
+        Chronometrer([&](uint32 i) { return Filtre_Moyenne_Ajouter(&moyenne,signal_0[i]); }),
+        Chronometrer([&](uint32 i) { return (int32)Filtre_Moyenne_Paire_Ajouter(&moyenne_paire_10,Filtre_Paire(signal_0[i],signal_1[i])); }),
+        Chronometrer([&](uint32 i) {
+            somme_double += signal_0[i] - fenetre_double[position_double];
+            fenetre_double[position_double] = signal_0[i];
+            position_double = (position_double + 1) % 10;
+            return (int32)(somme_double / 10); }));
+
+    Filtre_Mediane<uint32,5> mediane_paire;
+    Filtre_Mediane_Init(&mediane_paire,Filtre_Paire(0,0));
+    double fenetre_mediane[5] = {0};
+    Afficher_Durees("mediane 5",
+        Chronometrer([&](uint32 i) { return Filtre_Mediane_Ajouter(&mediane,signal_0[i]); }),
+        Chronometrer([&](uint32 i) { return (int32)Filtre_Mediane_Ajouter(&mediane_paire,Filtre_Paire(signal_0[i],signal_1[i])); }),
+        Chronometrer([&](uint32 i) {
+            double tri[5];
+            fenetre_mediane[i % 5] = signal_0[i];
+            memcpy(tri,fenetre_mediane,sizeof(tri));
+            std::nth_element(tri,tri + 2,tri + 5);
+            return (int32)tri[2]; }));
+
+    // pas de biquad en paires : seulement virgule fixe et double
+    Filtre_Biquad_Init(&biquad,&coefficients,signal_0[0]);
+    x1 = x2 = y1 = y2 = signal_0[0];
+    double ns_biquad = Chronometrer([&](uint32 i) { return Filtre_Biquad_Ajouter(&biquad,signal_0[i]); });
+    double ns_biquad_double = Chronometrer([&](uint32 i) {
+        double r = q_b0 * signal_0[i] + q_b1 * x1 + q_b2 * x2 - q_a1 * y1 - q_a2 * y2;
+        x2 = x1; x1 = signal_0[i]; y2 = y1; y1 = r;
+        return (int32)r; });
+    printf("filtres : %-10s %5.2f ns par echantillon, double %5.2f ns (x%.1f) (sur PC)\n","biquad",ns_biquad,ns_biquad_double,ns_biquad_double / ns_biquad);
+
+    printf("filtres : ecarts max EMA %.2f / %.2f, moyenne %.2f / %.2f, biquad %.2f LSB, %u bascules\n",
+           ecart_ema,ecart_ema_paire,ecart_moyenne,ecart_moyenne_paire,ecart_biquad,bascules);
+
+    return Hote_Bilan("test_filtres");
+}
+
+/* fin du fichier */
@@ -0,0 +1,144 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_flux.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Console.cpp UART_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du contrôle de flux RTS / CTS de l'UART0 (UART_Set_Controle_Flux, Console_Set_Controle_Flux) sur PC, à 921600 bauds :
+ *  - paramètres : UART1 et seuils hors bornes refusés, fonctions U0RTS / U0CTS et registres CONF0 / CONF1
+ *  - correspondant qui envoie sans pause des lignes numérotées, console lente (une commande toutes les 200us,
+ *    pause de 30ms toutes les 250ms) : aucune ligne perdue avec RTS, pauses de réception comptées
+ *  - même flux sans contrôle de flux : octets perdus comptés
+ *  - CTS bloqué par le correspondant : aucune émission pendant le blocage, durée du blocage comptée
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Console.h"
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+#define BAUDS 921600
+
+// Commande "n <numéro>" : continuité des lignes reçues
+static uint32 attendu = 0, nb_recues = 0, nb_ruptures = 0;
+static void Commande_Numero(const Console_Arguments *arguments)
+{
+    if (arguments->valeurs[0].non_signe != attendu) nb_ruptures++;
+    attendu = arguments->valeurs[0].non_signe + 1;
+    nb_recues++;
+}
+
+static const Console_Commande Commandes[] = {
+    {"n", "u", Commande_Numero, "<numero>"},
+};
+
+// Correspondant : lignes numérotées envoyées sans pause (RTS respecté par le modèle de l'UART0)
+static uint32 numero = 0;
+static void Correspondant()
+{
+    char ligne[16];
+    while (Hote_UART0_A_Envoyer() < 32)
+    {
+        Hote_UART0_Envoyer(ligne,sprintf(ligne,"n %u\n",numero++));
+    }
+}
+
+// Consommateur lent : une commande toutes les 200us, pause de 30ms toutes les 250ms
+static void Boucle(uint32 ms)
+{
+    for (uint32 t = 0; t < ms * 5; t++)
+    {
+        Hote_Simuler(200 * CYCLES_PAR_US);
+        if ((t % 1250) >= 150) Console_Executer();
+    }
+}
+
+// Vide le flux (correspondant arrêté) et repart d'un numéro connu
+static void Vider()
+{
+    hote_crochet_simulation = NULL;
+    for (uint32 t = 0; t < 20000 && (Hote_UART0_A_Envoyer() > 0 || (REGISTRE_LIRE(Registre_UART0->STATUS) & 0xFF) > 0); t++)
+    {
+        Hote_Simuler(50 * CYCLES_PAR_US);
+        Console_Executer();
+    }
+    for (uint32 t = 0; t < 100; t++)
+    {
+        Hote_Simuler(50 * CYCLES_PAR_US);
+        Console_Executer();
+    }
+    Hote_UART0_Envoyer("\n",1);
+    Hote_Simuler(100 * CYCLES_PAR_US);
+    Console_Executer();
+    attendu = numero;
+}
+
+int main()
+{
+    const UART_Statistiques_Flux *flux = UART_Lire_Statistiques_Flux(UART0);
+    const Console_Statistiques *console = Console_Lire_Statistiques();
+    char sortie[256];
+    uint32 nb;
+
+    Hote_Init();
+    Hote_UART0_Activer();
+
+    // 1. paramètres
+    HOTE_VERIFIER(init_Console(BAUDS,Commandes,1,false));
+    HOTE_VERIFIER(!UART_Set_Controle_Flux(UART1,true,true,UART_SEUIL_RTS_DEFAUT));
+    HOTE_VERIFIER(!UART_Set_Controle_Flux(UART0,true,true,0) && !UART_Set_Controle_Flux(UART0,true,true,UART_TAILLE_FIFO));
+    Console_Set_Controle_Flux(true);
+    HOTE_VERIFIER((Registre_IOMUX->GPIO[index_iomux(UART_GPIO_RTS)] & IOMUX_FONCTION(0x7)) == IOMUX_FONCTION(GPIO_FONCTION_5));
+    HOTE_VERIFIER((Registre_IOMUX->GPIO[index_iomux(UART_GPIO_CTS)] & IOMUX_FONCTION(0x7)) == IOMUX_FONCTION(GPIO_FONCTION_5));
+    HOTE_VERIFIER(READ_BIT(Registre_UART0->CONF1,BIT_UART_RX_FLOW_EN) && READ_BIT(Registre_UART0->CONF0,BIT_UART_TX_FLOW_EN));
+    HOTE_VERIFIER(((Registre_UART0->CONF1 >> BIT_UART_RX_FLOW_THRHD) & 0x7F) == UART_SEUIL_RTS_DEFAUT);
+
+    // 2. console lente avec RTS : aucune perte
+    hote_crochet_simulation = Correspondant;
+    Boucle(1000);
+    Vider();
+    HOTE_VERIFIER(nb_recues > 1000 && nb_recues == numero && nb_ruptures == 0);
+    HOTE_VERIFIER(hote_uart0_debordements == 0 && console->nb_perdus_rx == 0 && console->nb_erreurs == 0);
+    HOTE_VERIFIER(flux->nb_pauses_rx >= 4 && flux->duree_pauses_rx >= 4 * 30000);
+    printf("flux : %u lignes sans perte, %u pauses de reception (%u us)\n",nb_recues,flux->nb_pauses_rx,flux->duree_pauses_rx);
+
+    // 3. même flux sans contrôle de flux : octets perdus
+    Console_Set_Controle_Flux(false);
+    HOTE_VERIFIER(!READ_BIT(Registre_UART0->CONF1,BIT_UART_RX_FLOW_EN) && !READ_BIT(Registre_UART0->CONF0,BIT_UART_TX_FLOW_EN));
+    nb_ruptures = 0;
+    hote_crochet_simulation = Correspondant;
+    Boucle(300);
+    Vider();
+    HOTE_VERIFIER(console->nb_perdus_rx > 0 && nb_ruptures + console->nb_erreurs > 0);
+    printf("flux : sans controle de flux, %u octets perdus\n",console->nb_perdus_rx);
+
+    // 4. CTS bloqué pendant 10ms : l'émission reprend à la fin du blocage, sans perte
+    //    (messages d'erreur de l'étape 3 vidés au préalable)
+    Console_Set_Controle_Flux(true);
+    for (uint32 silence = 0; silence < 5; )
+    {
+        Hote_Simuler(1000 * CYCLES_PAR_US);
+        silence = (Hote_UART0_Recevoir(sortie,sizeof(sortie)) == 0) ? silence + 1 : 0;
+    }
+    hote_uart0_cts_bloque = true;
+    Hote_Simuler(100 * CYCLES_PAR_US);
+    Console_Ecrire("0123456789abcdefghijklmnopqrstuvwxyz");
+    for (uint32 t = 0; t < 100; t++)
+    {
+        Hote_Simuler(100 * CYCLES_PAR_US);
+        Console_Executer();
+    }
+    HOTE_VERIFIER(Hote_UART0_Recevoir(sortie,sizeof(sortie)) == 0 && flux->nb_blocages_tx == 1 && flux->duree_blocages_tx == 0);
+    hote_uart0_cts_bloque = false;
+    Hote_Simuler(1000 * CYCLES_PAR_US);
+    nb = Hote_UART0_Recevoir(sortie,sizeof(sortie));
+    HOTE_VERIFIER(nb == 36 && memcmp(sortie,"0123456789abcdefghijklmnopqrstuvwxyz",36) == 0);
+    HOTE_VERIFIER(flux->nb_blocages_tx == 1 && flux->duree_blocages_tx >= 10000 && flux->duree_blocages_tx <= 10200);
+
+    return Hote_Bilan("test_flux");
+}
+
+/* fin du fichier */
@@ -0,0 +1,96 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_horloge.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Horloge.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de l'horloge 64 bits (Horloge.h) sur PC :
+ *  - le compteur de cycles simulé avance par pas aléatoires et boucle plus de 50 fois
+ *  - l'interruption du multiplexeur est déclenchée avec un retard aléatoire (jusqu'à 20s après l'échéance)
+ *  - une interruption de recalage est aussi injectée au milieu des lectures (entre la base et le compteur)
+ *  L'horloge doit toujours être égale au temps réel simulé (64 bits)
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Horloge.h"
+
+// Temps réel simulé (64 bits)
+static uint64 temps_reel = 0;
+
+// Injection d'un recalage pendant une lecture de l'horloge
+static bool injection_active = false;
+static uint32 graine = 1;
+static uint32 nb_injections = 0;
+
+static uint32 Aleatoire()
+{
+    graine = graine * 1103515245 + 12345;
+    return graine >> 8;
+}
+
+static void Crochet_Lecture()
+{
+    if (!injection_active || (Aleatoire() % 7) != 0) return;
+    injection_active = false;
+    nb_injections++;
+    hote_dans_interruption = true;
+    Interruption_Horloge(NULL);
+    hote_dans_interruption = false;
+    injection_active = true;
+}
+
+int main()
+{
+    uint64 precedent = 0;
+    uint32 retard_isr = 0;
+    uint32 nb_isr = 0;
+
+    Hote_Init();
+    hote_cycles = 0xFFFF0000; // boucle du compteur juste après le démarrage
+    HOTE_VERIFIER(init_Horloge());
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+    HOTE_VERIFIER((REGISTRE_LIRE(Registre_TIMER1->CTRL_ADDRESS) & BIT_TIMER_EN) != 0);
+
+    uint64 debut = temps_reel;
+    hote_crochet_cycles = Crochet_Lecture;
+
+    for (uint32 i = 0; i < 2000000; i++)
+    {
+        uint32 pas = Aleatoire() % 400000;
+
+        temps_reel += pas;
+        Hote_Avancer_Cycles(pas);
+
+        // interruption du TIMER1 : déclenchée avec retard une fois l'échéance passée
+        if (retard_isr == 0 && (Aleatoire() % 3000) == 0) retard_isr = Aleatoire() % 4000;
+        if (retard_isr > 0 && --retard_isr == 0)
+        {
+            injection_active = false;
+            if (Hote_Declencher(ETS_FRC_TIMER1_INUM)) nb_isr++;
+        }
+
+        injection_active = true;
+        uint64 lu = Horloge_Lire_Cycles();
+        injection_active = false;
+
+        if (!HOTE_VERIFIER(lu == temps_reel - debut)) break;
+        HOTE_VERIFIER(lu >= precedent);
+        precedent = lu;
+    }
+
+    hote_crochet_cycles = NULL;
+    HOTE_VERIFIER(Horloge_Lire_us() == Horloge_Cycles_Vers_us(temps_reel - debut));
+    HOTE_VERIFIER((temps_reel >> 32) > 50);
+    HOTE_VERIFIER(nb_injections > 1000);
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+
+    printf("horloge : %llu boucles du compteur, %u interruptions, %u recalages injectes\n",
+           (unsigned long long)(temps_reel >> 32),nb_isr,nb_injections);
+    return Hote_Bilan("test_horloge");
+}
+
+/* fin du fichier */
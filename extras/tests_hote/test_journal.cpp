@@ -0,0 +1,192 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_journal.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Journal_Donnees.cpp Flash_esp8266.cpp Pool_Memoire.cpp UART_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du journal de mesures (Journal_Donnees.h) sur PC, flash simulée (anneau de 16 secteurs), 4 voies échantillonnées
+ *  toutes les secondes pendant 24h :
+ *  - paramètres invalides refusés
+ *  - aucun échantillon perdu, relecture exacte (pages en RAM comprises) des mesures les plus récentes gardées par l'anneau
+ *  - compression et nombre d'écritures / d'effacements de la flash comparés à une écriture par échantillon
+ *  - relecture à partir d'une date, export "date;v1;v2..." sur l'UART (valeurs négatives)
+ *  - remontage après redémarrage, période irrégulière
+ *  - coupure d'alimentation pendant l'écriture d'une page : page ignorée au remontage, journal cohérent, écriture reprise
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Journal_Donnees.h"
+#include <math.h>
+#include <string>
+#include <vector>
+
+#define PREMIER_SECTEUR 0x200
+#define NB_SECTEURS 16
+#define NB_VOIES 4
+
+typedef struct{
+  uint32 date;
+  int32 valeurs[NB_VOIES];
+} Echantillon;
+
+static std::vector<Echantillon> reference;
+static Journal_Lecteur lecteur;
+
+// Capteurs : température, humidité, écart de pression (négatif), compteur
+static Echantillon Capteurs(uint32 date)
+{
+    Echantillon e;
+    e.date = date;
+    e.valeurs[0] = (int32)(2150 + 300 * sin(date / 3600.0) + (rand() % 5 - 2));
+    e.valeurs[1] = (int32)(5500 + 1000 * sin(date / 7000.0) + (rand() % 21 - 10));
+    e.valeurs[2] = (int32)(200 * sin(date / 20000.0)) + (rand() % 7 - 3);
+    e.valeurs[3] = (int32)(date / 10);
+    return e;
+}
+
+// Un échantillon par seconde, Journal_Tache sur le temps libre de chaque seconde
+static uint32 date = 1000000;
+static uint32 nb_refus = 0;
+static void Echantillonner(uint32 nb, uint32 periode)
+{
+    for (uint32 i = 0; i < nb; i++, date += periode)
+    {
+        Echantillon e = Capteurs(date);
+        if (Journal_Ajouter(date,e.valeurs)) reference.push_back(e);
+        else nb_refus++;
+        Journal_Tache();
+    }
+}
+
+// Relecture complète : suite exacte des derniers échantillons de la référence
+static bool Relecture_Conforme(uint32 *nb_relus)
+{
+    std::vector<Echantillon> relus;
+    Echantillon e;
+    uint8 nb_voies;
+
+    Journal_Lecture_Debut(&lecteur,0);
+    while (Journal_Lecture_Suivant(&lecteur,&e.date,e.valeurs,&nb_voies))
+    {
+        if (nb_voies != NB_VOIES) return false;
+        relus.push_back(e);
+    }
+    *nb_relus = relus.size();
+    if (relus.empty() || relus.size() > reference.size()) return false;
+    size_t debut = reference.size() - relus.size();
+    return memcmp(&relus[0],&reference[debut],relus.size() * sizeof(Echantillon)) == 0;
+}
+
+// Export sur l'UART0 : octets écrits dans la fifo TX
+static std::string sortie;
+static void Ecriture(__Registre *registre, uint32 valeur)
+{
+    if (registre == &Registre_UART0->FIFO) sortie += (char)(valeur & 0xFF);
+}
+
+int main()
+{
+    const Journal_Statistiques *stats = Journal_Lire_Statistiques();
+    uint32 nb_relus = 0;
+
+    Hote_Init();
+    srand(1);
+
+    // 1. paramètres
+    HOTE_VERIFIER(!init_Journal(PREMIER_SECTEUR,1,NB_VOIES) && !init_Journal(PREMIER_SECTEUR,JOURNAL_NB_SECTEURS_MAX + 1,NB_VOIES));
+    HOTE_VERIFIER(!init_Journal(PREMIER_SECTEUR,NB_SECTEURS,0) && !init_Journal(PREMIER_SECTEUR,NB_SECTEURS,JOURNAL_NB_VOIES_MAX + 1));
+    HOTE_VERIFIER(init_Journal(PREMIER_SECTEUR,NB_SECTEURS,NB_VOIES));
+
+    // 2. première heure : relecture exacte, pages en RAM comprises
+    Echantillonner(3600,1);
+    HOTE_VERIFIER(Relecture_Conforme(&nb_relus) && nb_relus == 3600);
+
+    // 3. 24h : anneau plein, mesures les plus récentes gardées
+    uint32 ecritures = hote_flash_nb_ecritures, effacements = hote_flash_nb_effacements;
+    Echantillonner(23 * 3600,1);
+    ecritures = hote_flash_nb_ecritures - ecritures;
+    effacements = hote_flash_nb_effacements - effacements;
+    HOTE_VERIFIER(nb_refus == 0 && stats->nb_perdus == 0 && stats->nb_erreurs_flash == 0 && stats->nb_echantillons == 24 * 3600);
+    HOTE_VERIFIER(Relecture_Conforme(&nb_relus) && nb_relus > (NB_SECTEURS - 1) * JOURNAL_PAGES_PAR_SECTEUR * 90);
+    HOTE_VERIFIER(reference.size() > nb_relus);
+    // compression d'au moins 3 (20 octets bruts par échantillon), moins d'une écriture de page par minute
+    HOTE_VERIFIER(stats->octets_bruts > 3 * stats->octets_ecrits && ecritures < 23 * 60 && effacements < ecritures / 4);
+    printf("journal : %u echantillons, %u relus, compression %.2f, %u ecritures et %u effacements en 23h (%u ecritures en direct)\n",
+           stats->nb_echantillons,nb_relus,(double)stats->octets_bruts / stats->octets_ecrits,ecritures,effacements,23 * 3600);
+
+    // 4. relecture à partir d'une date
+    Echantillon e;
+    uint32 depuis = reference.back().date - 100, nb_depuis = 0;
+    Journal_Lecture_Debut(&lecteur,depuis);
+    bool dates_conformes = true;
+    while (Journal_Lecture_Suivant(&lecteur,&e.date,e.valeurs,NULL))
+    {
+        dates_conformes &= (e.date >= depuis);
+        nb_depuis++;
+    }
+    HOTE_VERIFIER(dates_conformes && nb_depuis == 101);
+
+    // 5. export des 3 derniers échantillons
+    hote_crochet_ecriture = Ecriture;
+    HOTE_VERIFIER(Journal_Exporter(UART0,reference.back().date - 2) == 3);
+    hote_crochet_ecriture = NULL;
+    std::string attendu;
+    for (size_t i = reference.size() - 3; i < reference.size(); i++)
+    {
+        attendu += std::to_string(reference[i].date);
+        for (uint8 v = 0; v < NB_VOIES; v++) attendu += ";" + std::to_string(reference[i].valeurs[v]);
+        attendu += "\r\n";
+    }
+    HOTE_VERIFIER(sortie == attendu && attendu.find(";-") != std::string::npos);
+
+    // 6. redémarrage après Journal_Vider, puis période irrégulière
+    Journal_Vider();
+    while (Journal_Tache()) {}
+    HOTE_VERIFIER(init_Journal(PREMIER_SECTEUR,NB_SECTEURS,NB_VOIES) && stats->nb_pages_invalides == 0);
+    HOTE_VERIFIER(Relecture_Conforme(&nb_relus));
+    Echantillonner(500,7);
+    Echantillonner(500,1);
+    date += 86400;
+    Echantillonner(500,3);
+    HOTE_VERIFIER(Relecture_Conforme(&nb_relus) && nb_refus == 0);
+
+    // 7. coupure d'alimentation pendant l'écriture d'une page (effacement du secteur suivant déjà fait)
+    Echantillonner(300,1);
+    Journal_Vider();
+    uint32 nb_coupures = 0;
+    for (uint32 essai = 0; essai < 20 && nb_coupures == 0; essai++)
+    {
+        hote_flash_budget = 0;
+        uint32 ecritures_avant = hote_flash_nb_ecritures, effacements_avant = hote_flash_nb_effacements;
+        bool en_attente = Journal_Tache();
+        hote_flash_budget = -1;
+        if (hote_flash_nb_ecritures == ecritures_avant && hote_flash_nb_effacements == effacements_avant && stats->nb_erreurs_flash > 0) nb_coupures++;
+        if (!en_attente) break;
+    }
+    HOTE_VERIFIER(nb_coupures == 1);
+    HOTE_VERIFIER(init_Journal(PREMIER_SECTEUR,NB_SECTEURS,NB_VOIES) && stats->nb_pages_invalides == 1);
+    // échantillons de la page interrompue perdus : retirés de la référence
+    uint32 derniere_date = 0;
+    Journal_Lecture_Debut(&lecteur,0);
+    while (Journal_Lecture_Suivant(&lecteur,&e.date,e.valeurs,NULL)) derniere_date = e.date;
+    uint32 nb_perdus_coupure = 0;
+    while (!reference.empty() && reference.back().date > derniere_date) { reference.pop_back(); nb_perdus_coupure++; }
+    HOTE_VERIFIER(nb_perdus_coupure > 0 && Relecture_Conforme(&nb_relus));
+
+    // écriture reprise après la page interrompue
+    Echantillonner(2000,1);
+    Journal_Vider();
+    while (Journal_Tache()) {}
+    HOTE_VERIFIER(Relecture_Conforme(&nb_relus) && stats->nb_erreurs_flash == 0);
+    HOTE_VERIFIER(init_Journal(PREMIER_SECTEUR,NB_SECTEURS,NB_VOIES) && Relecture_Conforme(&nb_relus));
+    printf("journal : coupure d'alimentation, %u echantillons perdus, %u pages invalides au remontage\n",
+           nb_perdus_coupure,stats->nb_pages_invalides);
+
+    return Hote_Bilan("test_journal");
+}
+
+/* fin du fichier */
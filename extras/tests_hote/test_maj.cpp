@@ -0,0 +1,278 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_maj.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Mise_A_Jour.cpp Flash_esp8266.cpp UART_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de la mise à jour par l'UART0 (Mise_A_Jour.h) sur PC, flash simulée, outil de la passerelle simulé
+ *  (trames passées par MAJ_Traiter_Octet, réponses relevées dans la fifo TX) :
+ *  - zones invalides refusées (taille, chevauchement avec le programme en cours ou l'emplacement de réception)
+ *  - transfert avec des coupures d'alimentation aléatoires : reprise au premier secteur incomplet,
+ *    image reçue exacte, programme en cours jamais modifié
+ *  - MAJ_FIN : commande eboot (ACTION_COPY_RAW) valide en mémoire RTC, recalculée comme eboot ; coupure avant le
+ *    redémarrage (mémoire RTC perdue) puis nouvelle commande déposée sans renvoyer l'image
+ *  - recopie simulée par eboot : le nouveau programme est au début de la flash
+ *  - écriture de la note d'un secteur en échec : bloc refusé (MAJ_ERREUR_FLASH), offset inchangé, bloc renvoyé
+ *  - CRC de l'image faux : MAJ_ERREUR_IMAGE, aucune commande déposée
+ *  - image "delta" (MAJ_COPIE) : seuls les blocs modifiés sont envoyés
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Mise_A_Jour.h"
+#include <string>
+#include <vector>
+
+#define NB_SECTEURS 64
+#define SECTEUR_RECEPTION 0x40
+#define SECTEUR_SUIVI 0x80
+#define TAILLE_ANCIEN 200000
+#define TAILLE_IMAGE 150001
+#define TAILLE_REPONSE 14
+
+static const MAJ_Zones zones = {SECTEUR_RECEPTION,NB_SECTEURS,SECTEUR_SUIVI};
+static const MAJ_Statistiques *stats = MAJ_Lire_Statistiques();
+
+// Réponses : octets écrits dans la fifo TX de l'UART0
+static std::string sortie;
+static void Ecriture(__Registre *registre, uint32 valeur)
+{
+    if (registre == &Registre_UART0->FIFO) sortie += (char)(valeur & 0xFF);
+}
+
+static uint32 Lire_Mot(const uint8 *buffer)
+{
+    return (uint32)buffer[0] | ((uint32)buffer[1] << 8) | ((uint32)buffer[2] << 16) | ((uint32)buffer[3] << 24);
+}
+
+static void Ajouter_Mot(std::vector<uint8> &buffer, uint32 valeur)
+{
+    for (uint8 i = 0; i < 4; i++) buffer.push_back((valeur >> (8 * i)) & 0xFF);
+}
+
+// Echange d'une trame : envoi, MAJ_Tache jusqu'à la réponse ; renvoie le statut et l'offset attendu
+static uint32 nb_reponses_fausses = 0;
+static MAJ_Statut Echanger(uint8 commande, uint32 offset, const uint8 *donnees, uint16 longueur, uint32 *offset_attendu)
+{
+    std::vector<uint8> trame;
+
+    trame.push_back(commande);
+    trame.push_back(longueur & 0xFF);
+    trame.push_back(longueur >> 8);
+    Ajouter_Mot(trame,offset);
+    trame.insert(trame.end(),donnees,donnees + longueur);
+    uint32 crc = ~Flash_CRC32(FLASH_CRC32_INIT,&trame[0],trame.size());
+    Ajouter_Mot(trame,crc);
+
+    sortie.clear();
+    MAJ_Traiter_Octet(MAJ_SYNC_1);
+    MAJ_Traiter_Octet(MAJ_SYNC_2);
+    for (size_t i = 0; i < trame.size(); i++) MAJ_Traiter_Octet(trame[i]);
+    for (uint32 t = 0; t < 100 && sortie.size() < TAILLE_REPONSE; t++) MAJ_Tache();
+
+    const uint8 *reponse = (const uint8 *)sortie.data();
+    if (sortie.size() != TAILLE_REPONSE || reponse[0] != MAJ_SYNC_1 || reponse[1] != MAJ_SYNC_2 ||
+        reponse[2] != (commande | MAJ_REPONSE) || reponse[3] != 1 || reponse[4] != 0 ||
+        Lire_Mot(&reponse[10]) != ~Flash_CRC32(FLASH_CRC32_INIT,&reponse[2],8))
+    {
+        nb_reponses_fausses++;
+        return MAJ_ERREUR_TRAME;
+    }
+    *offset_attendu = Lire_Mot(&reponse[5]);
+    return (MAJ_Statut)reponse[9];
+}
+
+// Commande eboot relue comme eboot : CRC bit à bit, poids fort en premier, sur les champs qui précèdent le CRC
+static uint32 CRC_Eboot(const uint32 *mots)
+{
+    const uint8 *octets = (const uint8 *)mots;
+    uint32 crc = 0xFFFFFFFF;
+
+    for (uint32 n = 0; n < 31 * 4; n++)
+    {
+        for (uint32 i = 0x80; i > 0; i >>= 1)
+        {
+            bool bit = crc & 0x80000000;
+            if (octets[n] & i) bit = !bit;
+            crc <<= 1;
+            if (bit) crc ^= 0x04C11DB7;
+        }
+    }
+    return crc;
+}
+
+static volatile uint32 *Memoire_RTC()
+{
+    return (volatile uint32 *)ADDR_RTCU;
+}
+
+// Coupure d'alimentation : mémoire RTC perdue, redémarrage de l'ancien programme
+static void Coupure()
+{
+    hote_flash_budget = -1;
+    for (uint8 i = 0; i < 32; i++) Memoire_RTC()[i] = 0;
+    init_Mise_A_Jour(115200,&zones);
+}
+
+// Démarrage par eboot : commande valide exécutée (recopie au début de la flash) puis effacée
+static bool Demarrage_Eboot()
+{
+    uint32 commande[32];
+
+    for (uint8 i = 0; i < 32; i++) commande[i] = Memoire_RTC()[i];
+    if (commande[0] != 0xEB001000 || commande[31] != CRC_Eboot(commande) || commande[1] != 1) return false;
+    memmove(&hote_flash[commande[3]],&hote_flash[commande[2]],commande[4]);
+    for (uint8 i = 0; i < 32; i++) Memoire_RTC()[i] = 0;
+    return true;
+}
+
+// Outil de la passerelle : envoie l'image à partir de l'offset de reprise, blocs identiques au programme en cours
+// recopiés (delta) ; s'arrête à la coupure d'alimentation (budget épuisé)
+static uint32 nb_offsets_reprise = 0;
+static MAJ_Statut Transferer(const std::vector<uint8> &image, uint32 crc_image, bool delta)
+{
+    uint8 debut[8];
+    uint32 offset = 0, taille = image.size();
+
+    for (uint8 i = 0; i < 4; i++) { debut[i] = (taille >> (8 * i)) & 0xFF; debut[4 + i] = (crc_image >> (8 * i)) & 0xFF; }
+    MAJ_Statut statut = Echanger(MAJ_DEBUT,0,debut,8,&offset);
+    if (statut != MAJ_OK) return statut;
+    if (offset > 0) nb_offsets_reprise++;
+
+    for (uint32 essai = 0; essai < 10000 && hote_flash_budget != 0; essai++)
+    {
+        if (offset >= taille) return Echanger(MAJ_FIN,offset,NULL,0,&offset);
+
+        uint32 fin = (offset / FLASH_TAILLE_SECTEUR + 1) * FLASH_TAILLE_SECTEUR;
+        if (fin > offset + MAJ_TAILLE_BLOC) fin = offset + MAJ_TAILLE_BLOC;
+        if (fin > taille) fin = taille;
+        if (delta && memcmp(&image[offset],&hote_flash[offset],fin - offset) == 0)
+        {
+            uint8 copie[8];
+            for (uint8 i = 0; i < 4; i++) { copie[i] = (offset >> (8 * i)) & 0xFF; copie[4 + i] = ((fin - offset) >> (8 * i)) & 0xFF; }
+            Echanger(MAJ_COPIE,offset,copie,8,&offset);
+        }
+        else
+        {
+            Echanger(MAJ_DONNEES,offset,&image[offset],fin - offset,&offset);
+        }
+    }
+    return MAJ_ERREUR_FLASH;
+}
+
+static std::vector<uint8> Image(uint32 taille)
+{
+    std::vector<uint8> image(taille);
+    for (uint32 i = 0; i < taille; i++) image[i] = rand() & 0xFF;
+    return image;
+}
+
+static uint32 CRC_Image(const std::vector<uint8> &image)
+{
+    return ~Flash_CRC32(FLASH_CRC32_INIT,&image[0],image.size());
+}
+
+int main()
+{
+    MAJ_Commande_Eboot commande;
+    uint32 offset = 0;
+
+    Hote_Init();
+    srand(1);
+    hote_crochet_ecriture = Ecriture;
+
+    // Programme en cours au début de la flash
+    std::vector<uint8> ancien = Image(TAILLE_ANCIEN);
+    memcpy(hote_flash,&ancien[0],TAILLE_ANCIEN);
+
+    // 1. zones
+    MAJ_Zones invalides[4] = {{SECTEUR_RECEPTION,0,SECTEUR_SUIVI},{SECTEUR_RECEPTION,MAJ_NB_SECTEURS_MAX + 1,SECTEUR_SUIVI},
+                              {NB_SECTEURS - 1,NB_SECTEURS,SECTEUR_SUIVI},{SECTEUR_RECEPTION,NB_SECTEURS,SECTEUR_RECEPTION + 3}};
+    bool refusees = true;
+    for (uint8 i = 0; i < 4; i++) refusees &= !init_Mise_A_Jour(115200,&invalides[i]);
+    MAJ_Zones suivi_programme = {SECTEUR_RECEPTION,NB_SECTEURS,5};
+    HOTE_VERIFIER(refusees && !init_Mise_A_Jour(115200,&suivi_programme));
+    HOTE_VERIFIER(init_Mise_A_Jour(115200,&zones) && MAJ_Lire_Etat() == MAJ_ETAT_INACTIF && !MAJ_Lire_Commande_Eboot(&commande));
+
+    // 2. transfert avec des coupures d'alimentation aléatoires
+    std::vector<uint8> image = Image(TAILLE_IMAGE);
+    uint32 crc_image = CRC_Image(image);
+    uint32 nb_coupures = 0, nb_reprises = 0;
+    MAJ_Statut statut = MAJ_ERREUR_FLASH;
+    while (statut != MAJ_OK && nb_coupures < 200)
+    {
+        hote_flash_budget = (nb_coupures < 30) ? 1 + rand() % 40 : -1;
+        statut = Transferer(image,crc_image,false);
+        if (statut != MAJ_OK)
+        {
+            nb_reprises += stats->nb_reprises;
+            nb_coupures++;
+            Coupure();
+        }
+    }
+    nb_reprises += stats->nb_reprises;
+    HOTE_VERIFIER(statut == MAJ_OK && nb_coupures == 30 && nb_reponses_fausses == 0);
+    HOTE_VERIFIER(nb_reprises > 0 && nb_offsets_reprise > 0);
+    HOTE_VERIFIER(memcmp(&hote_flash[SECTEUR_RECEPTION * FLASH_TAILLE_SECTEUR],&image[0],TAILLE_IMAGE) == 0);
+    HOTE_VERIFIER(memcmp(hote_flash,&ancien[0],TAILLE_ANCIEN) == 0);
+    printf("maj : %u coupures d'alimentation, %u reprises\n",nb_coupures,nb_reprises);
+
+    // 3. commande eboot déposée
+    HOTE_VERIFIER(MAJ_Lire_Etat() == MAJ_ETAT_TERMINEE && MAJ_Lire_Commande_Eboot(&commande));
+    HOTE_VERIFIER(commande.magique == MAJ_EBOOT_MAGIQUE && commande.action == MAJ_EBOOT_COPIE_BRUTE &&
+                  commande.arguments[0] == SECTEUR_RECEPTION * FLASH_TAILLE_SECTEUR && commande.arguments[1] == 0 &&
+                  commande.arguments[2] == TAILLE_IMAGE && commande.crc == CRC_Eboot((const uint32 *)&commande));
+    HOTE_VERIFIER(Transferer(image,crc_image,false) == MAJ_ERREUR_ETAT);
+
+    // coupure avant le redémarrage : commande perdue, déposée à nouveau sans renvoyer l'image
+    Coupure();
+    HOTE_VERIFIER(!MAJ_Lire_Commande_Eboot(&commande));
+    uint32 ecritures = hote_flash_nb_ecritures;
+    HOTE_VERIFIER(Transferer(image,crc_image,false) == MAJ_OK && hote_flash_nb_ecritures == ecritures);
+    HOTE_VERIFIER(MAJ_Lire_Etat() == MAJ_ETAT_TERMINEE && MAJ_Lire_Commande_Eboot(&commande));
+
+    // 4. redémarrage : recopie par eboot
+    HOTE_VERIFIER(Demarrage_Eboot() && memcmp(hote_flash,&image[0],TAILLE_IMAGE) == 0);
+    Coupure();
+
+    // 5. note du secteur en échec : bloc refusé et renvoyé
+    std::vector<uint8> image_2 = Image(TAILLE_IMAGE);
+    uint8 debut[8];
+    uint32 crc_2 = CRC_Image(image_2);
+    for (uint8 i = 0; i < 4; i++) { debut[i] = (TAILLE_IMAGE >> (8 * i)) & 0xFF; debut[4 + i] = (crc_2 >> (8 * i)) & 0xFF; }
+    HOTE_VERIFIER(Echanger(MAJ_DEBUT,0,debut,8,&offset) == MAJ_OK && offset == 0);
+    for (offset = 0; offset < FLASH_TAILLE_SECTEUR - MAJ_TAILLE_BLOC; )
+    {
+        if (Echanger(MAJ_DONNEES,offset,&image_2[offset],MAJ_TAILLE_BLOC,&offset) != MAJ_OK) break;
+    }
+    uint32 erreurs_flash = stats->nb_erreurs_flash;
+    hote_flash_budget = 1;   // écriture du bloc faite, note du secteur en échec
+    HOTE_VERIFIER(Echanger(MAJ_DONNEES,offset,&image_2[offset],MAJ_TAILLE_BLOC,&offset) == MAJ_ERREUR_FLASH &&
+                  offset == FLASH_TAILLE_SECTEUR - MAJ_TAILLE_BLOC && stats->nb_erreurs_flash == erreurs_flash + 1);
+    hote_flash_budget = -1;
+    HOTE_VERIFIER(Echanger(MAJ_DONNEES,offset,&image_2[offset],MAJ_TAILLE_BLOC,&offset) == MAJ_OK && offset == FLASH_TAILLE_SECTEUR);
+    HOTE_VERIFIER(Echanger(MAJ_ABANDON,offset,NULL,0,&offset) == MAJ_OK && MAJ_Lire_Etat() == MAJ_ETAT_INACTIF);
+
+    // 6. CRC de l'image faux : refusée, aucune commande déposée
+    HOTE_VERIFIER(Transferer(image_2,crc_2 ^ 1,false) == MAJ_ERREUR_IMAGE);
+    HOTE_VERIFIER(MAJ_Lire_Etat() == MAJ_ETAT_INACTIF && !MAJ_Lire_Commande_Eboot(&commande));
+    HOTE_VERIFIER(memcmp(hote_flash,&image[0],TAILLE_IMAGE) == 0);
+
+    // 7. image delta : quelques blocs modifiés du programme en cours
+    Coupure();
+    image_2 = image;
+    for (uint32 i = 0; i < 5; i++) image_2[(rand() % TAILLE_IMAGE)] ^= 0x5A;
+    image_2.resize(TAILLE_IMAGE + 3000,0x42);
+    crc_2 = CRC_Image(image_2);
+    HOTE_VERIFIER(Transferer(image_2,crc_2,true) == MAJ_OK && MAJ_Lire_Commande_Eboot(&commande));
+    HOTE_VERIFIER(stats->octets_recus < 20 * MAJ_TAILLE_BLOC && stats->octets_recus + stats->octets_copies == image_2.size());
+    HOTE_VERIFIER(Demarrage_Eboot() && memcmp(hote_flash,&image_2[0],image_2.size()) == 0);
+    printf("maj : image delta, %u octets envoyes, %u recopies\n",stats->octets_recus,stats->octets_copies);
+
+    return Hote_Bilan("test_maj");
+}
+
+/* fin du fichier */
@@ -0,0 +1,192 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_moteur.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Moteur_Pas.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp GPIO_esp8266.cpp UART_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test des moteurs pas à pas (Moteur_Pas.h) sur PC, 4 moteurs simultanés, impulsions relevées sur les registres GPIO :
+ *  - nombre de pas et position exacts, sens positionné avant le premier pas, largeur des impulsions
+ *  - profil trapézoïdal : vitesse de chaque pas comparée au profil idéal, durée du déplacement
+ *  - profil en S : vitesse maximale atteinte, durée comparée au profil idéal
+ *  - pas simultanés de plusieurs moteurs émis en une seule écriture
+ *  - arrêt progressif (distance de freinage), retour à une position absolue, arrêt d'urgence
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Moteur_Pas.h"
+#include <math.h>
+#include <vector>
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+#define CYCLES_PAR_S  ESP8266_CLOCK_FREQ
+
+static const uint8 gpio_pas[NB_MOTEURS] = {GPIO4, GPIO5, GPIO12, GPIO13};
+static const uint8 gpio_dir[NB_MOTEURS] = {GPIO14, GPIO15, GPIO2, GPIO0};
+
+// Relevé des impulsions
+static std::vector<uint32> pas[NB_MOTEURS];   // instant de chaque front montant de STEP
+static uint32 dernier_dir[NB_MOTEURS];         // dernière écriture de DIR
+static bool impulsion[NB_MOTEURS];             // STEP à l'état haut
+static uint32 dernier_front = 0;
+static uint32 nb_ecritures_pas = 0, nb_ecritures_groupees = 0;
+static uint32 nb_dir_tardifs = 0, nb_impulsions_courtes = 0;
+
+static void Ecriture_GPIO(__Registre *registre, uint32 valeur)
+{
+    if (registre != &Registre_GPIO->OUT_W1TS && registre != &Registre_GPIO->OUT_W1TC) return;
+
+    uint8 nb_fronts = 0;
+    for (uint8 m = 0; m < NB_MOTEURS; m++)
+    {
+        if (READ_BIT(valeur,gpio_dir[m])) dernier_dir[m] = hote_cycles;
+        if (!READ_BIT(valeur,gpio_pas[m])) continue;
+
+        if (registre == &Registre_GPIO->OUT_W1TS)
+        {
+            if (pas[m].empty() && (uint32)(hote_cycles - dernier_dir[m]) < MOTEUR_DELAI_DIR) nb_dir_tardifs++;
+            pas[m].push_back((uint32)hote_cycles);
+            impulsion[m] = true;
+            nb_fronts++;
+        }
+        else if (impulsion[m])
+        {
+            if ((uint32)(hote_cycles - dernier_front) < MOTEUR_LARGEUR_IMPULSION) nb_impulsions_courtes++;
+            impulsion[m] = false;
+        }
+    }
+    if (nb_fronts > 0)
+    {
+        dernier_front = hote_cycles;
+        nb_ecritures_pas++;
+        if (nb_fronts > 1) nb_ecritures_groupees++;
+    }
+}
+
+static void Effacer_Releves()
+{
+    for (uint8 m = 0; m < NB_MOTEURS; m++) pas[m].clear();
+}
+
+// Attend la fin des déplacements (durée maximale en ms)
+static bool Attendre(uint32 ms)
+{
+    for (uint32 t = 0; t < ms; t++)
+    {
+        bool actif = false;
+        for (uint8 m = 0; m < NB_MOTEURS; m++) actif |= Moteur_En_Mouvement(m);
+        if (!actif) return true;
+        Hote_Simuler(1000 * CYCLES_PAR_US);
+    }
+    return false;
+}
+
+// Vitesse mesurée au pas n (pas/s)
+static double Vitesse(uint8 m, uint32 n)
+{
+    return (double)CYCLES_PAR_S / (uint32)(pas[m][n] - pas[m][n - 1]);
+}
+
+// Ecart relatif maximal entre la vitesse mesurée et le profil trapézoïdal idéal (hors 20 premiers et derniers pas)
+static double Ecart_Trapeze(uint8 m, uint32 nb_pas, double vitesse_max, double acceleration)
+{
+    double ecart = 0;
+    for (uint32 n = 20; n + 20 < nb_pas; n++)
+    {
+        double ideale = fmin(fmin(sqrt(2 * acceleration * n),sqrt(2 * acceleration * (nb_pas - n))),vitesse_max);
+        ecart = fmax(ecart,fabs(Vitesse(m,n) - ideale) / ideale);
+    }
+    return ecart;
+}
+
+// Durée mesurée d'un déplacement (s)
+static double Duree(uint8 m)
+{
+    return (double)(uint32)(pas[m].back() - pas[m].front()) / CYCLES_PAR_S;
+}
+
+int main()
+{
+    Hote_Init();
+    hote_pas_simulation = 16;
+    hote_pas_cycles = 4;      // attente active de la largeur d'impulsion
+    hote_latence_timer1 = CYCLES_PAR_US;
+    hote_crochet_ecriture = Ecriture_GPIO;
+
+    // 1. initialisation
+    HOTE_VERIFIER(!init_Moteur(NB_MOTEURS,GPIO4,GPIO5,false));
+    for (uint8 m = 0; m < NB_MOTEURS; m++) HOTE_VERIFIER(init_Moteur(m,gpio_pas[m],gpio_dir[m],m == 1));
+    HOTE_VERIFIER(!Moteur_En_Mouvement(0) && Moteur_Position(0) == 0);
+
+    // 2. quatre moteurs démarrés ensemble : trapèze long, trapèze court (sens inversé), profil en S, déplacement bref
+    Moteur_Set_Profil(0,5000,20000,0);
+    Moteur_Set_Profil(1,2000,4000,0);
+    Moteur_Set_Profil(2,8000,40000,400000);
+    Moteur_Set_Profil(3,20000,1000000,0);
+    HOTE_VERIFIER(Moteur_Preparer(0,10000) && Moteur_Preparer(1,-300) && Moteur_Preparer(2,20000) && Moteur_Preparer(3,100));
+    Moteurs_Demarrer(0xF);
+    HOTE_VERIFIER(!Moteur_Preparer(0,10) && !Moteur_Deplacer(2,10));
+    HOTE_VERIFIER(Attendre(4000));
+
+    HOTE_VERIFIER(Moteur_Position(0) == 10000 && Moteur_Position(1) == -300);
+    HOTE_VERIFIER(Moteur_Position(2) == 20000 && Moteur_Position(3) == 100);
+    HOTE_VERIFIER(pas[0].size() == 10000 && pas[1].size() == 300 && pas[2].size() == 20000 && pas[3].size() == 100);
+    HOTE_VERIFIER(nb_dir_tardifs == 0 && nb_impulsions_courtes == 0);
+    // moteur 1 inversé : déplacement négatif = DIR à l'état haut
+    HOTE_VERIFIER(READ_BIT(Hote_GPIO_Niveaux(),gpio_dir[1]) && READ_BIT(Hote_GPIO_Niveaux(),gpio_dir[0]));
+
+    // trapèzes : durée idéale = pas / vitesse + vitesse / accélération (vitesse crête sqrt(a.n) si elle n'est pas atteinte)
+    double ecart_0 = Ecart_Trapeze(0,10000,5000,20000);
+    double ecart_1 = Ecart_Trapeze(1,300,sqrt(4000.0 * 300),4000);
+    HOTE_VERIFIER(ecart_0 < 0.05 && ecart_1 < 0.05);
+    HOTE_VERIFIER(fabs(Duree(0) - 2.25) < 0.03 * 2.25);
+    HOTE_VERIFIER(fabs(Duree(1) - 2 * sqrt(300 / 4000.0)) < 0.06 * 2 * sqrt(300 / 4000.0));
+
+    // profil en S : 0.3s d'accélération (dont 2 x 0.1s de jerk), 1200 pas ; palier de 17600 pas à 8000 pas/s : 2.8s
+    double vitesse_max_2 = 0;
+    for (uint32 n = 1; n < pas[2].size(); n++) vitesse_max_2 = fmax(vitesse_max_2,Vitesse(2,n));
+    HOTE_VERIFIER(fabs(Vitesse(2,10000) - 8000) < 0.03 * 8000 && vitesse_max_2 < 1.05 * 8000);
+    HOTE_VERIFIER(fabs(Duree(2) - 2.8) < 0.03 * 2.8);
+    // démarrage en douceur : vitesse encore faible après 0.1s (jerk seul : 2000 pas/s)
+    uint32 n_01s = 0;
+    while (pas[2][n_01s] - pas[2][0] < CYCLES_PAR_S / 10) n_01s++;
+    HOTE_VERIFIER(Vitesse(2,n_01s) > 1500 && Vitesse(2,n_01s) < 2500);
+
+    // pas simultanés regroupés
+    HOTE_VERIFIER(nb_ecritures_groupees > 0);
+    printf("moteurs : trapeze ecart %.1f%% / %.1f%%, durees %.3fs %.3fs %.3fs, %u ecritures STEP dont %u groupees\n",
+           ecart_0 * 100,ecart_1 * 100,Duree(0),Duree(1),Duree(2),nb_ecritures_pas,nb_ecritures_groupees);
+
+    // 3. arrêt progressif à 5000 pas/s : distance de freinage v² / 2a = 625 pas
+    Effacer_Releves();
+    Moteur_Set_Profil(0,5000,20000,0);
+    HOTE_VERIFIER(Moteur_Deplacer(0,100000));
+    Hote_Simuler(1000000 * CYCLES_PAR_US);
+    int32 position_arret = Moteur_Position(0);
+    Moteur_Arreter(0);
+    HOTE_VERIFIER(Attendre(1000));
+    int32 freinage = Moteur_Position(0) - position_arret;
+    HOTE_VERIFIER(freinage >= 600 && freinage <= 650);
+
+    // 4. retour à l'origine
+    HOTE_VERIFIER(Moteur_Aller_A(0,0) && Attendre(8000) && Moteur_Position(0) == 0);
+    Moteur_Set_Position(0,1234);
+    HOTE_VERIFIER(Moteur_Position(0) == 1234);
+
+    // 5. arrêt d'urgence : plus aucun pas
+    HOTE_VERIFIER(Moteur_Deplacer(1,100000));
+    Hote_Simuler(100000 * CYCLES_PAR_US);
+    Moteur_Arret_Urgence(1);
+    size_t nb_pas = pas[1].size();
+    Hote_Simuler(100000 * CYCLES_PAR_US);
+    HOTE_VERIFIER(!Moteur_En_Mouvement(1) && pas[1].size() == nb_pas && nb_pas > 0);
+    HOTE_VERIFIER(Moteur_Position(1) == -300 + (int32)nb_pas);
+
+    hote_crochet_ecriture = NULL;
+    return Hote_Bilan("test_moteur");
+}
+
+/* fin du fichier */
@@ -0,0 +1,410 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_mqtt.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : MQTT.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du codage / décodage MQTT (MQTT.h) sur PC :
+ *  - paquet CONNECT comparé octet par octet à la norme
+ *  - paquets PUBLISH aléatoires codés (buffer linéaire ou circulaire) puis analysés par blocs de taille aléatoire
+ *  - paquets PUBLISH mal formés (longueur du topic plus grande que le corps, jusqu'à 0xFFFF)
+ *  - filtres d'abonnement (+, #, $SYS) et topics / filtres de 65535 octets
+ *  - échange avec un broker minimal sur un flux d'octets rebouclé : CONNECT / CONNACK, SUBSCRIBE / SUBACK, PUBLISH relayés
+ *    au client selon ses abonnements, paquets reçus octet par octet
+ *  - débit sur PC (paquets par seconde) du codage, de l'analyse et de la recherche des abonnements
+ * =============================================================================================================================================
+ */
+
+#include <stdlib.h>
+#include "hote.h"
+#include "MQTT.h"
+#include <chrono>
+
+#define TAILLE_FLUX 4096    // puissance de 2 : écrit directement par un écrivain circulaire
+#define NB_MESURES 192000  // multiple de 64 (paquets du flux analysé) et de 6 (topics)
+
+static uint32 graine = 5;
+
+static uint32 Aleatoire()
+{
+    graine = graine * 1103515245 + 12345;
+    return graine >> 8;
+}
+
+static MQTT_Vue Vue(const char *chaine)
+{
+    MQTT_Vue vue = {(const uint8*)chaine,(uint16)strlen(chaine)};
+    return vue;
+}
+
+// Paquets PUBLISH codés puis analysés (buffer circulaire : le paquet est recopié à plat avant l'analyse)
+static void Tester_Publish(bool circulaire)
+{
+    static uint8 buffer[1024], flux[4096], reception[600];
+    char topic[80];
+    uint8 message[300];
+    MQTT_Analyseur analyseur;
+
+    init_MQTT_Analyseur(&analyseur,reception,sizeof(reception));
+
+    for (uint16 essai = 0; essai < 2000; essai++)
+    {
+        // topic et message aléatoires
+        uint8 taille_topic = 1 + Aleatoire() % 60;
+        for (uint8 i = 0; i < taille_topic; i++) topic[i] = (Aleatoire() % 5 == 0) ? '/' : 'a' + Aleatoire() % 26;
+        topic[taille_topic] = 0;
+        uint16 taille_message = Aleatoire() % 300;
+        for (uint16 i = 0; i < taille_message; i++) message[i] = Aleatoire();
+        uint8 qos = Aleatoire() % 3;
+        bool retain = Aleatoire() & 1;
+        uint16 id = 1 + Aleatoire() % 65535;
+
+        MQTT_Ecrivain ecrivain;
+        uint16 debut = circulaire ? Aleatoire() % sizeof(buffer) : 0;
+        init_MQTT_Ecrivain(&ecrivain,buffer,sizeof(buffer),debut,circulaire);
+        uint16 taille = MQTT_Encoder_Publish(&ecrivain,topic,message,taille_message,qos,retain,id);
+        if (!HOTE_VERIFIER(taille > 0 && taille == ecrivain.longueur && !ecrivain.erreur)) return;
+        for (uint16 i = 0; i < taille; i++) flux[i] = buffer[(debut + i) % sizeof(buffer)];
+
+        // analyse par blocs de taille aléatoire
+        MQTT_Paquet paquet;
+        MQTT_Statut statut = MQTT_INCOMPLET;
+        uint16 position = 0;
+        while (position < taille && statut == MQTT_INCOMPLET)
+        {
+            uint16 bloc = 1 + Aleatoire() % (taille - position);
+            position += MQTT_Analyser_Buffer(&analyseur,&flux[position],bloc,&paquet,&statut);
+        }
+        HOTE_VERIFIER(statut == MQTT_PAQUET_PRET && position == taille);
+        HOTE_VERIFIER(paquet.type == MQTT_PUBLISH && paquet.qos == qos && paquet.retain == retain);
+        HOTE_VERIFIER(paquet.id == (qos ? id : 0));
+        HOTE_VERIFIER(paquet.topic.taille == taille_topic && memcmp(paquet.topic.donnees,topic,taille_topic) == 0);
+        HOTE_VERIFIER(paquet.payload.taille == taille_message && memcmp(paquet.payload.donnees,message,taille_message) == 0);
+    }
+
+    // buffer trop petit
+    MQTT_Ecrivain ecrivain;
+    init_MQTT_Ecrivain(&ecrivain,buffer,16,0,false);
+    HOTE_VERIFIER(MQTT_Encoder_Publish(&ecrivain,"capteurs/temperature",message,10,0,false,0) == 0 && ecrivain.erreur);
+}
+
+// PUBLISH mal formés : refusés, et les vues restent toujours dans le corps reçu
+static void Tester_Malformes()
+{
+    static uint8 corps[512];
+    MQTT_Paquet paquet;
+
+    const uint8 topic_trop_long[2] = {0xFF,0xFF};
+    HOTE_VERIFIER(!MQTT_Interpreter(0x30,topic_trop_long,2,&paquet));
+
+    const uint8 topic_tronque[3] = {0x00,0x05,'a'};
+    HOTE_VERIFIER(!MQTT_Interpreter(0x30,topic_tronque,3,&paquet));
+
+    const uint8 sans_id[4] = {0x00,0x02,'a','b'}; // QoS 1 sans identifiant
+    HOTE_VERIFIER(!MQTT_Interpreter(0x32,sans_id,4,&paquet));
+    HOTE_VERIFIER(MQTT_Interpreter(0x30,sans_id,4,&paquet) && paquet.payload.taille == 0);
+
+    for (uint32 essai = 0; essai < 100000; essai++)
+    {
+        uint16 taille = Aleatoire() % sizeof(corps);
+        for (uint16 i = 0; i < taille; i++) corps[i] = Aleatoire();
+        if (taille >= 2 && (Aleatoire() & 1)) corps[0] = 0xFF; // longueurs proches de 0xFFFF
+        uint8 entete = 0x30 | (Aleatoire() & 0x0F);
+
+        if (!MQTT_Interpreter(entete,corps,taille,&paquet)) continue;
+        HOTE_VERIFIER(paquet.topic.donnees >= corps && paquet.topic.donnees + paquet.topic.taille <= corps + taille);
+        HOTE_VERIFIER(paquet.payload.donnees >= corps && paquet.payload.donnees + paquet.payload.taille == corps + taille);
+    }
+}
+
+// Filtres d'abonnement
+static void Tester_Abonnements()
+{
+    MQTT_Table_Abonnements table;
+    init_MQTT_Table_Abonnements(&table);
+
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"a/+/c",NULL) == 0);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"a/#",NULL) == 1);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"#",NULL) == 2);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"+/b/c",NULL) == 3);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"$SYS/#",NULL) == 4);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"a/b/c",NULL) == 5);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"+",NULL) == 6);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"a/b#",NULL) == -1);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"a/#/c",NULL) == -1);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,"a/b+/c",NULL) == -1);
+
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,Vue("a/b/c")) == 0x2F);
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,Vue("a/x/c")) == 0x07);
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,Vue("a")) == 0x46);
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,Vue("x/b/c")) == 0x0C);
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,Vue("$SYS/charge")) == 0x10);
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,Vue("a/b/cd")) == 0x06);
+
+    // 65535 octets : filtre refusé (niveau de plus de 255 caractères), topics découpés jusqu'au bout
+    static char long_texte[65536];
+    memset(long_texte,'a',65535);
+    long_texte[65535] = 0;
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,long_texte,NULL) == -1);
+
+    MQTT_Vue topic = {(const uint8*)long_texte,65535};
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,topic) == 0x44);
+
+    memset(long_texte,'/',65535);
+    HOTE_VERIFIER(MQTT_Ajouter_Abonnement(&table,long_texte,NULL) == -1);
+    HOTE_VERIFIER(MQTT_Rechercher_Abonnements(&table,topic) == 0x04); // 65536 niveaux vides : seulement "#"
+}
+
+// Un sens de la connexion rebouclée
+typedef struct {
+  uint8 donnees[TAILLE_FLUX];
+  uint16 ecriture;
+  uint16 lecture;
+} Flux;
+
+static MQTT_Ecrivain *Ecrivain(Flux *flux)
+{
+    static MQTT_Ecrivain ecrivain;
+    init_MQTT_Ecrivain(&ecrivain,flux->donnees,TAILLE_FLUX,flux->ecriture,true);
+    return &ecrivain;
+}
+
+static void Valider(Flux *flux, uint16 taille)
+{
+    flux->ecriture = (flux->ecriture + taille) & (TAILLE_FLUX - 1);
+}
+
+static void Ecrire_Octets(Flux *flux, const uint8 *octets, uint16 taille)
+{
+    for (uint16 i = 0; i < taille; i++) flux->donnees[(flux->ecriture + i) & (TAILLE_FLUX - 1)] = octets[i];
+    Valider(flux,taille);
+}
+
+// Analyse octet par octet jusqu'au prochain paquet complet
+static bool Lire_Paquet(Flux *flux, MQTT_Analyseur *analyseur, MQTT_Paquet *paquet)
+{
+    while (flux->lecture != flux->ecriture)
+    {
+        uint8 octet = flux->donnees[flux->lecture];
+        flux->lecture = (flux->lecture + 1) & (TAILLE_FLUX - 1);
+        MQTT_Statut statut = MQTT_Analyser_Octet(analyseur,octet,paquet);
+        if (statut == MQTT_PAQUET_PRET) return true;
+        if (statut != MQTT_INCOMPLET)
+        {
+            HOTE_VERIFIER(statut == MQTT_INCOMPLET);
+            return false;
+        }
+    }
+    return false;
+}
+
+// Broker minimal : une connexion, abonnements en QoS 0, PUBLISH relayés au client s'il est abonné
+static struct {
+  MQTT_Analyseur analyseur;
+  uint8 reception[600];
+  MQTT_Table_Abonnements table;
+  char filtres[MQTT_NB_ABONNEMENTS_MAX][64];
+  bool connecte;
+  uint32 nb_relayes;
+} broker;
+
+static void Broker_Traiter(Flux *entree, Flux *sortie)
+{
+    MQTT_Paquet paquet;
+    while (Lire_Paquet(entree,&broker.analyseur,&paquet))
+    {
+        const uint8 *corps = paquet.payload.donnees;
+        uint16 taille = paquet.payload.taille;
+
+        switch (paquet.type)
+        {
+            case MQTT_CONNECT :
+            {
+                // protocole "MQTT" niveau 4 (3.1.1), sinon code retour 1
+                broker.connecte = (taille >= 10 && memcmp(&corps[2],"MQTT",4) == 0 && corps[6] == 4);
+                const uint8 connack[4] = {0x20,0x02,0x00,(uint8)(broker.connecte ? 0x00 : 0x01)};
+                Ecrire_Octets(sortie,connack,sizeof(connack));
+            }
+            break;
+
+            case MQTT_SUBSCRIBE :
+            {
+                // identifiant, puis (longueur, filtre, QoS) : QoS 0 accordé, 0x80 si le filtre est refusé
+                uint8 suback[4 + MQTT_NB_ABONNEMENTS_MAX] = {0x90,0x02,corps[0],corps[1]};
+                uint16 position = 2;
+                while (position + 3 <= taille && suback[1] < 2 + MQTT_NB_ABONNEMENTS_MAX)
+                {
+                    uint16 longueur = (corps[position] << 8) | corps[position + 1];
+                    char *filtre = broker.filtres[broker.table.nb];
+                    bool accepte = (longueur < sizeof(broker.filtres[0]) && position + 3 + longueur <= taille);
+                    if (accepte)
+                    {
+                        memcpy(filtre,&corps[position + 2],longueur);
+                        filtre[longueur] = 0;
+                        accepte = (MQTT_Ajouter_Abonnement(&broker.table,filtre,NULL) >= 0);
+                    }
+                    suback[2 + suback[1]++] = accepte ? 0x00 : 0x80;
+                    position += 3 + longueur;
+                }
+                Ecrire_Octets(sortie,suback,2 + suback[1]);
+            }
+            break;
+
+            case MQTT_PUBLISH :
+                if (broker.connecte && MQTT_Rechercher_Abonnements(&broker.table,paquet.topic) != 0)
+                {
+                    char topic[128];
+                    memcpy(topic,paquet.topic.donnees,paquet.topic.taille);
+                    topic[paquet.topic.taille] = 0;
+                    Valider(sortie,MQTT_Encoder_Publish(Ecrivain(sortie),topic,paquet.payload.donnees,paquet.payload.taille,0,false,0));
+                    broker.nb_relayes++;
+                }
+            break;
+        }
+    }
+}
+
+// Client : messages reçus par abonnement
+static uint32 nb_recus[3];
+static uint32 somme_recue;
+static void Recevoir(const MQTT_Paquet *paquet, uint8 n)
+{
+    nb_recus[n]++;
+    if (paquet->payload.taille == 4) somme_recue += paquet->payload.donnees[0] | (paquet->payload.donnees[1] << 8);
+}
+static void Recevoir_Temperature(const MQTT_Paquet *paquet) { Recevoir(paquet,0); }
+static void Recevoir_Actionneur(const MQTT_Paquet *paquet)  { Recevoir(paquet,1); }
+static void Recevoir_Etat(const MQTT_Paquet *paquet)        { Recevoir(paquet,2); }
+
+static const char * const filtres_client[3] = {"capteurs/+/temperature","actionneurs/#","etat"};
+static const char * const topics_client[6] = {"capteurs/salon/temperature","capteurs/salon/humidite","actionneurs/vanne/1",
+                                              "etat","etat/detail","capteurs/cuisine/temperature"};
+static const int8 abonnement_topic[6] = {0,-1,1,2,-1,0};
+
+// Connexion au broker rebouclé, abonnements, puis messages relayés ; débits mesurés sur PC
+static void Tester_Broker()
+{
+    static Flux vers_broker, vers_client;
+    static uint8 reception[600];
+    MQTT_Analyseur analyseur;
+    MQTT_Paquet paquet;
+
+    init_MQTT_Analyseur(&analyseur,reception,sizeof(reception));
+    init_MQTT_Analyseur(&broker.analyseur,broker.reception,sizeof(broker.reception));
+    init_MQTT_Table_Abonnements(&broker.table);
+
+    // CONNECT / CONNACK
+    MQTT_Options_Connexion options;
+    memset(&options,0,sizeof(options));
+    options.client_id = "capteur-1";
+    options.clean_session = true;
+    options.keep_alive = 60;
+    Valider(&vers_broker,MQTT_Encoder_Connect(Ecrivain(&vers_broker),&options));
+    Broker_Traiter(&vers_broker,&vers_client);
+    HOTE_VERIFIER(Lire_Paquet(&vers_client,&analyseur,&paquet) && paquet.type == MQTT_CONNACK && paquet.code_retour == 0);
+
+    // SUBSCRIBE / SUBACK
+    MQTT_Table_Abonnements table;
+    init_MQTT_Table_Abonnements(&table);
+    MQTT_Ajouter_Abonnement(&table,filtres_client[0],Recevoir_Temperature);
+    MQTT_Ajouter_Abonnement(&table,filtres_client[1],Recevoir_Actionneur);
+    MQTT_Ajouter_Abonnement(&table,filtres_client[2],Recevoir_Etat);
+    const uint8 qos[3] = {0,0,0};
+    Valider(&vers_broker,MQTT_Encoder_Subscribe(Ecrivain(&vers_broker),0x1234,filtres_client,qos,3));
+    Broker_Traiter(&vers_broker,&vers_client);
+    HOTE_VERIFIER(Lire_Paquet(&vers_client,&analyseur,&paquet) && paquet.type == MQTT_SUBACK && paquet.id == 0x1234);
+    HOTE_VERIFIER(paquet.payload.taille == 3 && paquet.payload.donnees[0] == 0 && paquet.payload.donnees[2] == 0);
+
+    // PUBLISH par paquets de 10 : seuls les topics abonnés reviennent au client
+    uint32 attendus[3] = {0,0,0}, somme_attendue = 0;
+    for (uint32 i = 0; i < 3000; i++)
+    {
+        uint8 n = i % 6;
+        const uint8 message[4] = {(uint8)i,(uint8)(i >> 8),(uint8)(i >> 16),(uint8)(i >> 24)};
+        Valider(&vers_broker,MQTT_Encoder_Publish(Ecrivain(&vers_broker),topics_client[n],message,4,0,false,0));
+        if (abonnement_topic[n] >= 0)
+        {
+            attendus[abonnement_topic[n]]++;
+            somme_attendue += i & 0xFFFF;
+        }
+        if (i % 10 != 9) continue;
+
+        Broker_Traiter(&vers_broker,&vers_client);
+        while (Lire_Paquet(&vers_client,&analyseur,&paquet))
+        {
+            HOTE_VERIFIER(paquet.type == MQTT_PUBLISH && MQTT_Distribuer(&table,&paquet) == 1);
+        }
+    }
+    HOTE_VERIFIER(broker.nb_relayes == 2000 && somme_recue == somme_attendue);
+    HOTE_VERIFIER(nb_recus[0] == attendus[0] && nb_recus[1] == attendus[1] && nb_recus[2] == attendus[2]);
+
+    // Débits : codage (dans le flux rebouclé), analyse octet par octet, recherche des abonnements du broker
+    const uint8 message[16] = {0};
+    auto debut = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < NB_MESURES; i++)
+    {
+        Valider(&vers_broker,MQTT_Encoder_Publish(Ecrivain(&vers_broker),topics_client[i % 6],message,sizeof(message),0,false,0));
+        vers_broker.lecture = vers_broker.ecriture;
+    }
+    double ns_codage = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - debut).count() / NB_MESURES;
+
+    static uint8 flux[64 * 64];
+    MQTT_Ecrivain ecrivain;
+    uint16 taille_flux = 0;
+    for (uint8 i = 0; i < 64; i++)
+    {
+        init_MQTT_Ecrivain(&ecrivain,&flux[taille_flux],sizeof(flux) - taille_flux,0,false);
+        taille_flux += MQTT_Encoder_Publish(&ecrivain,topics_client[i % 6],message,sizeof(message),0,false,0);
+    }
+    uint32 nb_paquets = 0;
+    debut = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < NB_MESURES / 64; i++)
+    {
+        for (uint16 j = 0; j < taille_flux; j++) nb_paquets += (MQTT_Analyser_Octet(&broker.analyseur,flux[j],&paquet) == MQTT_PAQUET_PRET);
+    }
+    double ns_analyse = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - debut).count() / nb_paquets;
+    HOTE_VERIFIER(nb_paquets == NB_MESURES);
+
+    MQTT_Vue topics[6];
+    for (uint8 n = 0; n < 6; n++) topics[n] = Vue(topics_client[n]);
+    uint32 nb_correspondances = 0;
+    debut = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < NB_MESURES; i++) nb_correspondances += (MQTT_Rechercher_Abonnements(&broker.table,topics[i % 6]) != 0);
+    double ns_recherche = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - debut).count() / NB_MESURES;
+    HOTE_VERIFIER(nb_correspondances == (NB_MESURES / 6) * 4);
+
+    printf("mqtt : broker reboucle, %u PUBLISH relayes ; codage %.0f paquets/s, analyse octet par octet %.0f paquets/s (%.1f ns par octet), "
+           "recherche des abonnements %.0f topics/s (sur PC)\n",
+           broker.nb_relayes,1e9 / ns_codage,1e9 / ns_analyse,ns_analyse * nb_paquets / ((NB_MESURES / 64) * taille_flux),1e9 / ns_recherche);
+}
+
+int main()
+{
+    Hote_Init();
+
+    // CONNECT : client "abc", session propre, keep alive 60s
+    static const uint8 connect_attendu[] = {0x10,0x0F,0x00,0x04,'M','Q','T','T',0x04,0x02,0x00,0x3C,0x00,0x03,'a','b','c'};
+    uint8 buffer[64];
+    MQTT_Ecrivain ecrivain;
+    MQTT_Options_Connexion options;
+    memset(&options,0,sizeof(options));
+    options.client_id = "abc";
+    options.clean_session = true;
+    options.keep_alive = 60;
+    init_MQTT_Ecrivain(&ecrivain,buffer,sizeof(buffer),0,false);
+    HOTE_VERIFIER(MQTT_Encoder_Connect(&ecrivain,&options) == sizeof(connect_attendu));
+    HOTE_VERIFIER(memcmp(buffer,connect_attendu,sizeof(connect_attendu)) == 0);
+
+    Tester_Publish(false);
+    Tester_Publish(true);
+    Tester_Malformes();
+    Tester_Abonnements();
+    Tester_Broker();
+
+    return Hote_Bilan("test_mqtt");
+}
+
+/* fin du fichier */
@@ -0,0 +1,186 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_multiplexeur.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du multiplexeur du TIMER1 (Multiplexeur_TIMER1.h) sur PC :
+ *  - emplacements : 8 clients au maximum, fonction nulle refusée
+ *  - 6 clients périodiques (périodes premières entre elles) pendant 200ms, latence aléatoire de l'interruption :
+ *    aucun appel en avance, aucune période perdue (sans dérive), appels dans l'ordre des échéances
+ *  - annulation et déplacement d'une échéance, échéance dans le passé traitée immédiatement
+ *  - client qui se reprogramme dans le passé : au plus TIMER1_MUX_APPELS_MAX appels par interruption
+ *  - statistiques : latence maximale bornée par la latence simulée, TIMER1 arrêté quand la file est vide
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Multiplexeur_TIMER1.h"
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+#define NB_PERIODIQUES 6
+
+typedef struct{
+  int8 numero;
+  uint32 periode;
+  uint32 echeance;
+  uint32 nb_appels;
+  uint32 nb_avances;
+  bool periodique;
+} Client_Test;
+
+static Client_Test clients[TIMER1_MUX_NB_CLIENTS];
+
+// Ordre des appels
+static uint32 derniere_echeance = 0;
+static bool premier_appel = true;
+static uint32 nb_desordres = 0;
+
+static void Client(void *argument)
+{
+    Client_Test *client = (Client_Test *)argument;
+
+    client->nb_appels++;
+    if ((int32)(hote_cycles - client->echeance) <= -TIMER1_MUX_DELAI_MIN) client->nb_avances++;
+    if (!premier_appel && (int32)(client->echeance - derniere_echeance) < 0) nb_desordres++;
+    derniere_echeance = client->echeance;
+    premier_appel = false;
+
+    // durée du client
+    Hote_Avancer_Cycles(40 + (client->periode % 7) * 10);
+
+    if (client->periodique)
+    {
+        client->echeance += client->periode;
+        TIMER1_Mux_Programmer(client->numero,client->echeance);
+    }
+}
+
+// Client qui se reprogramme dans le passé (tant que boucle_active)
+static uint32 nb_appels_boucle = 0;
+static bool boucle_active = true;
+static void Client_Boucle(void *argument)
+{
+    nb_appels_boucle++;
+    Hote_Avancer_Cycles(20);
+    if (boucle_active) TIMER1_Mux_Programmer(*(int8 *)argument,hote_cycles - 1000);
+}
+
+int main()
+{
+    static const uint32 periodes[NB_PERIODIQUES] = {797, 1511, 2003, 5009, 12007, 40009}; // cycles
+    int8 numeros[TIMER1_MUX_NB_CLIENTS];
+
+    Hote_Init();
+    hote_pas_simulation = 4;
+
+    // 1. emplacements
+    HOTE_VERIFIER(TIMER1_Mux_Ajouter_Client(NULL,NULL) == -1);
+    for (uint8 i = 0; i < TIMER1_MUX_NB_CLIENTS - 1; i++)
+    {
+        clients[i].numero = numeros[i] = TIMER1_Mux_Ajouter_Client(Client,&clients[i]);
+        HOTE_VERIFIER(numeros[i] == i);
+    }
+    numeros[TIMER1_MUX_NB_CLIENTS - 1] = TIMER1_Mux_Ajouter_Client(Client_Boucle,&numeros[TIMER1_MUX_NB_CLIENTS - 1]);
+    HOTE_VERIFIER(numeros[TIMER1_MUX_NB_CLIENTS - 1] == TIMER1_MUX_NB_CLIENTS - 1);
+    HOTE_VERIFIER(TIMER1_Mux_Ajouter_Client(Client,NULL) == -1);
+    HOTE_VERIFIER(!READ_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN));
+
+    // 2. clients périodiques, latence de l'interruption jusqu'à 2us
+    hote_latence_timer1 = 2 * CYCLES_PAR_US;
+    uint32 depart = hote_cycles + 100;
+    uint32 etat = Masquer_Interruptions();
+    for (uint8 i = 0; i < NB_PERIODIQUES; i++)
+    {
+        clients[i].periode = periodes[i];
+        clients[i].periodique = true;
+        clients[i].echeance = depart + periodes[i];
+        TIMER1_Mux_Programmer(clients[i].numero,clients[i].echeance);
+    }
+    Restaurer_Interruptions(etat);
+    HOTE_VERIFIER(READ_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN));
+
+    const uint32 duree = 200000 * CYCLES_PAR_US;
+    Hote_Simuler(duree);
+    uint32 ecoule = hote_cycles - depart;
+    uint32 nb_appels_total = 0, nb_avances = 0;
+    bool sans_derive = true;
+    for (uint8 i = 0; i < NB_PERIODIQUES; i++)
+    {
+        uint32 attendus = ecoule / periodes[i];
+        sans_derive &= (clients[i].nb_appels + 1 >= attendus && clients[i].nb_appels <= attendus);
+        nb_appels_total += clients[i].nb_appels;
+        nb_avances += clients[i].nb_avances;
+    }
+    const TIMER1_Mux_Statistiques *stats = TIMER1_Mux_Lire_Statistiques();
+    HOTE_VERIFIER(sans_derive && nb_avances == 0 && nb_desordres == 0);
+    HOTE_VERIFIER(stats->nb_appels == nb_appels_total && stats->nb_interruptions <= nb_appels_total);
+    HOTE_VERIFIER(stats->latence_max > 0);
+    // latence simulée + pas de simulation + durée des clients traités avant dans la même interruption
+    HOTE_VERIFIER(stats->latence_max <= hote_latence_timer1 + TIMER1_MUX_CYCLES_PAR_TICK + NB_PERIODIQUES * 120);
+    printf("multiplexeur : %u appels, %u interruptions, latence max %u cycles, duree max %u cycles\n",
+           stats->nb_appels,stats->nb_interruptions,stats->latence_max,stats->duree_max);
+
+    // 3. annulation de tous les clients : TIMER1 arrêté
+    etat = Masquer_Interruptions();
+    for (uint8 i = 0; i < NB_PERIODIQUES; i++)
+    {
+        TIMER1_Mux_Annuler(clients[i].numero);
+        clients[i].periodique = false;
+        clients[i].nb_appels = 0;
+    }
+    Restaurer_Interruptions(etat);
+    HOTE_VERIFIER(!READ_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN));
+    Hote_Simuler(1000 * CYCLES_PAR_US);
+    HOTE_VERIFIER(clients[0].nb_appels == 0);
+
+    // 4. déplacement : l'échéance la plus proche est reportée derrière une autre
+    hote_latence_timer1 = 0;
+    premier_appel = true;
+    etat = Masquer_Interruptions();
+    clients[0].echeance = hote_cycles + 1000;
+    clients[1].echeance = hote_cycles + 2000;
+    TIMER1_Mux_Programmer(numeros[0],clients[0].echeance);
+    TIMER1_Mux_Programmer(numeros[1],clients[1].echeance);
+    clients[0].echeance = hote_cycles + 3000;
+    TIMER1_Mux_Programmer(numeros[0],clients[0].echeance);
+    Restaurer_Interruptions(etat);
+    Hote_Simuler(1500);
+    HOTE_VERIFIER(clients[0].nb_appels == 0 && clients[1].nb_appels == 0);
+    Hote_Simuler(1000);
+    HOTE_VERIFIER(clients[0].nb_appels == 0 && clients[1].nb_appels == 1);
+    Hote_Simuler(1000);
+    HOTE_VERIFIER(clients[0].nb_appels == 1 && nb_desordres == 0);
+
+    // 5. échéance dans le passé : appel à la prochaine interruption (délai minimal)
+    etat = Masquer_Interruptions();
+    clients[2].echeance = hote_cycles - 5000;
+    TIMER1_Mux_Programmer(numeros[2],clients[2].echeance);
+    Restaurer_Interruptions(etat);
+    Hote_Simuler(TIMER1_MUX_DELAI_MIN + 2 * TIMER1_MUX_CYCLES_PAR_TICK);
+    HOTE_VERIFIER(clients[2].nb_appels == 1);
+
+    // 6. client qui se reprogramme dans le passé : l'interruption rend la main après TIMER1_MUX_APPELS_MAX appels,
+    //    les autres clients sont toujours servis
+    TIMER1_Mux_RAZ_Statistiques();
+    etat = Masquer_Interruptions();
+    clients[3].echeance = hote_cycles + 500;
+    TIMER1_Mux_Programmer(numeros[3],clients[3].echeance);
+    TIMER1_Mux_Programmer(numeros[7],hote_cycles);
+    Restaurer_Interruptions(etat);
+    HOTE_VERIFIER(Hote_Declencher(ETS_FRC_TIMER1_INUM));
+    HOTE_VERIFIER(nb_appels_boucle == TIMER1_MUX_APPELS_MAX && stats->nb_interruptions == 1);
+    Hote_Simuler(1000);
+    HOTE_VERIFIER(clients[3].nb_appels == 1 && nb_appels_boucle > TIMER1_MUX_APPELS_MAX);
+    HOTE_VERIFIER(stats->nb_appels <= stats->nb_interruptions * TIMER1_MUX_APPELS_MAX);
+    boucle_active = false;
+    Hote_Simuler(1000);
+    HOTE_VERIFIER(!READ_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN));
+
+    return Hote_Bilan("test_multiplexeur");
+}
+
+/* fin du fichier */
@@ -0,0 +1,444 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_onewire.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : OneWire_esp8266.cpp SoftUART_esp8266.cpp GPIO_esp8266.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du bus 1-Wire / DHT (OneWire_esp8266.h) sur PC, avec un modèle des périphériques branché sur la GPIO2 :
+ *  - le modèle suit les fronts imposés par le maître et vérifie les durées des slots (spécification 1-Wire)
+ *  - périphériques 1-Wire : présence, SEARCH ROM, MATCH ROM + lecture du scratchpad (0xBE)
+ *  - capteur DHT22 : réponse et 40 bits
+ *  L'interruption du TIMER1 est retardée aléatoirement (jusqu'à 4us) : aucun slot hors spécification, aucun abandon.
+ *  Des interruptions masquées jusqu'à 70us au milieu des échanges (interruption longue d'un autre module) : les données
+ *  doivent toujours être justes ou l'échange abandonné avec ONEWIRE_ERREUR_DEPASSEMENT. Une ROM transmise avec un bit
+ *  faux pendant une recherche doit donner ONEWIRE_ERREUR_CRC sans faire sauter de périphérique à la recherche suivante.
+ *  Les interruptions ne sont jamais masquées par le bus : deux UART logicielles (57600 et 9600 bauds, rebouclées)
+ *  reçoivent sans erreur pendant les échanges 1-Wire.
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "OneWire_esp8266.h"
+#include "SoftUART_esp8266.h"
+
+#define GPIO_BUS 2
+#define NB_PERIPHERIQUES_MAX 8
+#define T(us) ((uint32)(us) * ONEWIRE_CYCLES_PAR_US)
+
+// Etat des périphériques 1-Wire (tous dans le même état, chacun actif ou non)
+typedef enum {ATTENTE,COMMANDE,RECHERCHE,LECTURE_ROM,SELECTION,FONCTION,ENVOI} Etat_Modele;
+
+static struct{
+  uint8 nb;
+  uint8 rom[NB_PERIPHERIQUES_MAX][8];
+  uint8 scratchpad[NB_PERIPHERIQUES_MAX][9];
+  bool actif[NB_PERIPHERIQUES_MAX];
+  Etat_Modele etat;
+  uint16 bit;
+  uint8 octet;
+
+  bool maitre_bas;
+  uint32 chute;
+  bool slot_emission;        // slot de lecture (un périphérique émet)
+  bool emission_zero;
+  uint32 emission_fin;
+  uint32 presence_debut;
+  uint32 presence_fin;
+  bool presence;
+
+  int8 corruption_peripherique; // ROM émise avec un bit faux (-1 : aucune)
+  uint8 corruption_bit;
+  uint32 nb_violations;         // slots hors spécification
+
+  bool dht;
+  uint32 dht_depart;
+  uint8 dht_donnees[5];
+} modele;
+
+static uint32 graine = 3;
+
+static uint32 Aleatoire()
+{
+    graine = graine * 1103515245 + 12345;
+    return graine >> 8;
+}
+
+// ##########################################################################################################################
+//                                     MODELE DES PERIPHERIQUES
+// ##########################################################################################################################
+
+static uint8 Bit_ROM(uint8 p, uint8 n)
+{
+    uint8 bit = (modele.rom[p][n / 8] >> (n % 8)) & 1;
+
+    // Bit faux émis par un périphérique resté seul sur le bus (la ROM lue par le maître est fausse)
+    if (p == modele.corruption_peripherique && n == modele.corruption_bit)
+    {
+        uint8 nb_actifs = 0;
+        for (uint8 i = 0; i < modele.nb; i++) nb_actifs += modele.actif[i];
+        if (nb_actifs == 1 && modele.actif[p]) bit ^= 1;
+    }
+    return bit;
+}
+
+// Bit émis par les périphériques actifs (ET câblé)
+static uint8 Bit_Emis()
+{
+    uint8 niveau = 1;
+    for (uint8 p = 0; p < modele.nb; p++)
+    {
+        if (!modele.actif[p]) continue;
+        switch (modele.etat)
+        {
+            case RECHERCHE   : niveau &= ((modele.bit % 3) == 0) ? Bit_ROM(p,modele.bit / 3) : !Bit_ROM(p,modele.bit / 3); break;
+            case LECTURE_ROM : niveau &= Bit_ROM(p,modele.bit); break;
+            case ENVOI       : niveau &= (modele.scratchpad[p][modele.bit / 8] >> (modele.bit % 8)) & 1; break;
+            default : break;
+        }
+    }
+    return niveau;
+}
+
+static bool Etat_Emission()
+{
+    return modele.etat == LECTURE_ROM || modele.etat == ENVOI || (modele.etat == RECHERCHE && (modele.bit % 3) != 2);
+}
+
+// Bit écrit par le maître
+static void Recevoir(uint8 valeur)
+{
+    switch (modele.etat)
+    {
+        case COMMANDE :
+        case FONCTION :
+            modele.octet |= valeur << modele.bit;
+            if (++modele.bit < 8) return;
+            modele.bit = 0;
+            if (modele.etat == FONCTION)
+            {
+                modele.etat = (modele.octet == 0xBE) ? ENVOI : ATTENTE;
+                return;
+            }
+            switch (modele.octet)
+            {
+                case ONEWIRE_CMD_SEARCH_ROM : modele.etat = RECHERCHE;   break;
+                case ONEWIRE_CMD_READ_ROM   : modele.etat = LECTURE_ROM; break;
+                case ONEWIRE_CMD_MATCH_ROM  : modele.etat = SELECTION;   break;
+                case ONEWIRE_CMD_SKIP_ROM   : modele.etat = FONCTION; modele.octet = 0; break;
+                default                     : modele.etat = ATTENTE;     break;
+            }
+        break;
+
+        case RECHERCHE :
+            for (uint8 p = 0; p < modele.nb; p++) if (Bit_ROM(p,modele.bit / 3) != valeur) modele.actif[p] = false;
+            if (++modele.bit == 3 * 64) modele.etat = ATTENTE;
+        break;
+
+        case SELECTION :
+            for (uint8 p = 0; p < modele.nb; p++) if (Bit_ROM(p,modele.bit) != valeur) modele.actif[p] = false;
+            if (++modele.bit == 64)
+            {
+                modele.etat = FONCTION;
+                modele.bit = 0;
+                modele.octet = 0;
+            }
+        break;
+
+        default : break;
+    }
+}
+
+static void Chute_Maitre()
+{
+    modele.chute = hote_cycles;
+    modele.slot_emission = Etat_Emission();
+    if (modele.slot_emission)
+    {
+        modele.emission_zero = (Bit_Emis() == 0);
+        modele.emission_fin = hote_cycles + T(30);
+    }
+}
+
+static void Montee_Maitre()
+{
+    uint32 duree = hote_cycles - modele.chute;
+
+    if (modele.dht)
+    {
+        if (duree >= T(1000)) modele.dht_depart = hote_cycles;
+        return;
+    }
+
+    // Reset : présence 30us après la fin du reset, pendant 120us
+    if (duree >= T(480))
+    {
+        modele.etat = COMMANDE;
+        modele.bit = 0;
+        modele.octet = 0;
+        for (uint8 p = 0; p < modele.nb; p++) modele.actif[p] = true;
+        modele.presence = (modele.nb > 0);
+        modele.presence_debut = hote_cycles + T(30);
+        modele.presence_fin = hote_cycles + T(150);
+        return;
+    }
+    if (modele.etat == ATTENTE) return;
+
+    if (modele.slot_emission)
+    {
+        // slot de lecture : ligne basse 1 à 15us
+        if (duree < T(1) || duree >= T(15)) modele.nb_violations++;
+        modele.bit++;
+        if (modele.etat == LECTURE_ROM && modele.bit == 64) modele.etat = ATTENTE;
+        if (modele.etat == ENVOI && modele.bit == 72) modele.etat = ATTENTE;
+        return;
+    }
+
+    // slot d'écriture : '1' si la ligne est relâchée avant 15us, '0' si elle reste basse 60 à 120us
+    if (duree < T(15)) Recevoir(1);
+    else
+    {
+        if (duree < T(60) || duree > T(120)) modele.nb_violations++;
+        Recevoir(0);
+    }
+}
+
+// Ecriture d'un registre : suivi de la ligne commandée par le maître
+static void Ecriture_Registre(__Registre *registre, uint32 valeur)
+{
+    bool bas = READ_BIT(Registre_GPIO->ENABLE,GPIO_BUS) && !READ_BIT(Registre_GPIO->OUT,GPIO_BUS);
+
+    if (bas == modele.maitre_bas) return;
+    modele.maitre_bas = bas;
+    if (bas) Chute_Maitre();
+    else     Montee_Maitre();
+}
+
+// Niveau imposé par les périphériques
+static void Lignes()
+{
+    uint32 maintenant = hote_cycles;
+    bool bas = false;
+
+    if (modele.presence && (int32)(maintenant - modele.presence_debut) >= 0 && (int32)(maintenant - modele.presence_fin) < 0) bas = true;
+    if (modele.slot_emission && modele.emission_zero && (int32)(maintenant - modele.emission_fin) < 0) bas = true;
+
+    if (modele.dht && modele.dht_depart != 0)
+    {
+        uint32 t = (maintenant - modele.dht_depart) / ONEWIRE_CYCLES_PAR_US;
+        if (t >= 30 && t < 110) bas = true;
+        else if (t >= 190)
+        {
+            t -= 190;
+            for (uint8 i = 0; i < 40; i++)
+            {
+                uint32 duree = 50 + (((modele.dht_donnees[i / 8] >> (7 - i % 8)) & 1) ? 70 : 26);
+                if (t < duree) { bas = (t < 50); t = 0xFFFFFFFF; break; }
+                t -= duree;
+            }
+            if (t != 0xFFFFFFFF && t < 50) bas = true;
+        }
+    }
+
+    if (bas) hote_gpio_externe &= ~(1 << GPIO_BUS);
+    else     hote_gpio_externe |= (1 << GPIO_BUS);
+}
+
+// Lignes du bus et UART logicielles rebouclées (GPIO4 -> GPIO5, GPIO12 -> GPIO13)
+static void Lignes_UART()
+{
+    Lignes();
+    uint32 niveaux = Hote_GPIO_Niveaux();
+    uint32 externe = hote_gpio_externe;
+    externe = (externe & ~(1 << 5)) | (READ_BIT(niveaux,4) << 5);
+    externe = (externe & ~(1 << 13)) | (READ_BIT(niveaux,12) << 13);
+    hote_gpio_externe = externe;
+}
+
+// ##########################################################################################################################
+//                                     TESTS
+// ##########################################################################################################################
+
+static OneWire_Statut Attendre()
+{
+    for (uint32 i = 0; i < 200 && OneWire_Etat(0) == ONEWIRE_EN_COURS; i++) Hote_Simuler(T(1000));
+    return OneWire_Etat(0);
+}
+
+static void Creer_Peripheriques(uint8 nb)
+{
+    modele.nb = nb;
+    for (uint8 p = 0; p < nb; p++)
+    {
+        modele.rom[p][0] = 0x28; // famille DS18B20
+        for (uint8 i = 1; i < 7; i++) modele.rom[p][i] = Aleatoire();
+        modele.rom[p][7] = OneWire_CRC8(modele.rom[p],7);
+        for (uint8 i = 0; i < 8; i++) modele.scratchpad[p][i] = Aleatoire();
+        modele.scratchpad[p][8] = OneWire_CRC8(modele.scratchpad[p],8);
+    }
+}
+
+// Recherche complète : chaque périphérique doit être trouvé une fois (les recherches en erreur CRC sont relancées)
+static bool Rechercher_Tous(uint32 *nb_erreurs_crc)
+{
+    uint8 trouve[NB_PERIPHERIQUES_MAX] = {0};
+    uint8 rom[8];
+    bool nouvelle = true;
+    bool dernier = false;
+
+    for (uint8 essai = 0; essai < 3 * NB_PERIPHERIQUES_MAX && !dernier; essai++)
+    {
+        if (!OneWire_Rechercher_ROM(0,nouvelle,NULL)) return false;
+        nouvelle = false;
+        OneWire_Statut statut = Attendre();
+        if (statut == ONEWIRE_ERREUR_CRC)
+        {
+            (*nb_erreurs_crc)++;
+            modele.corruption_peripherique = -1; // erreur passagère
+            continue;
+        }
+        if (statut != ONEWIRE_TERMINE) return false;
+
+        dernier = OneWire_Lire_ROM(0,rom);
+        for (uint8 p = 0; p < modele.nb; p++) if (memcmp(rom,modele.rom[p],8) == 0) trouve[p]++;
+    }
+
+    for (uint8 p = 0; p < modele.nb; p++) if (trouve[p] != 1) return false;
+    return dernier;
+}
+
+int main()
+{
+    Hote_Init();
+    hote_pas_cycles = 8; // les attentes actives sur le compteur de cycles progressent
+    hote_crochet_simulation = Lignes;
+    hote_crochet_ecriture = Ecriture_Registre;
+    modele.corruption_peripherique = -1;
+
+    init_OneWire(0,GPIO_BUS);
+    Hote_Simuler(T(100));
+
+    // 1. pas de périphérique : erreur de présence
+    HOTE_VERIFIER(OneWire_Transaction(0,true,NULL,0,0,NULL));
+    HOTE_VERIFIER(Attendre() == ONEWIRE_ERREUR_PRESENCE);
+
+    // 2. recherche et lecture des scratchpads, interruption du TIMER1 retardée jusqu'à 4us
+    hote_latence_timer1 = T(4);
+    uint32 nb_recherches = 0, nb_erreurs_crc = 0, nb_lectures = 0;
+    for (uint8 essai = 0; essai < 20; essai++)
+    {
+        Creer_Peripheriques(1 + essai % NB_PERIPHERIQUES_MAX);
+        nb_recherches++;
+        HOTE_VERIFIER(Rechercher_Tous(&nb_erreurs_crc));
+
+        for (uint8 p = 0; p < modele.nb; p++)
+        {
+            uint8 tx[10], rx[9];
+            tx[0] = ONEWIRE_CMD_MATCH_ROM;
+            memcpy(&tx[1],modele.rom[p],8);
+            tx[9] = 0xBE;
+            HOTE_VERIFIER(OneWire_Transaction(0,true,tx,10,9,NULL));
+            HOTE_VERIFIER(Attendre() == ONEWIRE_TERMINE);
+            HOTE_VERIFIER(OneWire_Lire_Reception(0,rx,9) == 9 && memcmp(rx,modele.scratchpad[p],9) == 0);
+            nb_lectures++;
+        }
+    }
+    HOTE_VERIFIER(modele.nb_violations == 0 && nb_erreurs_crc == 0);
+
+    // 3. ROM transmise avec un bit faux pendant une recherche : erreur CRC, puis aucun périphérique sauté
+    uint32 nb_corruptions = 0;
+    for (uint16 essai = 0; essai < 200; essai++)
+    {
+        Creer_Peripheriques(2 + essai % (NB_PERIPHERIQUES_MAX - 1));
+        modele.corruption_peripherique = Aleatoire() % modele.nb;
+        modele.corruption_bit = 56 + Aleatoire() % 8;
+        uint32 avant = nb_erreurs_crc;
+        HOTE_VERIFIER(Rechercher_Tous(&nb_erreurs_crc));
+        nb_corruptions += (nb_erreurs_crc != avant);
+        modele.corruption_peripherique = -1;
+    }
+    HOTE_VERIFIER(nb_corruptions > 100);
+
+    // 4. interruptions masquées jusqu'à 70us pendant l'échange : un slot trop long abandonne l'échange,
+    //    les données lues sont justes
+    Creer_Peripheriques(1);
+    uint32 nb_depassements = 0, nb_justes = 0;
+    for (uint16 essai = 0; essai < 100; essai++)
+    {
+        uint8 tx[2] = {ONEWIRE_CMD_SKIP_ROM,0xBE}, rx[9];
+        HOTE_VERIFIER(OneWire_Transaction(0,true,tx,2,9,NULL));
+        Hote_Simuler(T(500 + Aleatoire() % 5000));
+        ETS_INTR_LOCK();
+        Hote_Simuler(T(Aleatoire() % 70));
+        ETS_INTR_UNLOCK();
+        OneWire_Statut statut = Attendre();
+        if (statut == ONEWIRE_ERREUR_DEPASSEMENT) nb_depassements++;
+        else if (HOTE_VERIFIER(statut == ONEWIRE_TERMINE))
+        {
+            nb_justes += HOTE_VERIFIER(OneWire_Lire_Reception(0,rx,9) == 9 && memcmp(rx,modele.scratchpad[0],9) == 0);
+        }
+        Hote_Simuler(T(1000)); // le périphérique abandonné revient au repos
+    }
+    HOTE_VERIFIER(nb_depassements > 0 && nb_justes > 0);
+
+    // 5. capteur DHT22 : -12.3°C, 65.2%
+    Creer_Peripheriques(0);
+    modele.dht = true;
+    modele.dht_donnees[0] = 0x02; modele.dht_donnees[1] = 0x8C;
+    modele.dht_donnees[2] = 0x80; modele.dht_donnees[3] = 0x7B;
+    modele.dht_donnees[4] = modele.dht_donnees[0] + modele.dht_donnees[1] + modele.dht_donnees[2] + modele.dht_donnees[3];
+    HOTE_VERIFIER(OneWire_Lire_DHT(0,DHT22,NULL));
+    HOTE_VERIFIER(Attendre() == ONEWIRE_TERMINE);
+    HOTE_VERIFIER(DHT_Temperature(0) == -123);
+    HOTE_VERIFIER(DHT_Humidite(0) == 652);
+
+    // 6. UART logicielles actives pendant les échanges 1-Wire : aucune interruption masquée par le bus
+    modele.dht = false;
+    Creer_Peripheriques(3);
+    // pas de latence ajoutée : seuls les autres clients du multiplexeur (1-Wire, UART) retardent les échéances
+    hote_latence_timer1 = 0;
+    modele.nb_violations = 0;
+    TIMER1_Mux_RAZ_Statistiques();
+    hote_crochet_simulation = Lignes_UART;
+    init_SoftUART(0,5,4,57600,DATA_8,NONE,STOP_1);
+    init_SoftUART(1,13,12,9600,DATA_8,NONE,STOP_1);
+    Hote_Simuler(T(1000));
+    uint32 nb_octets = 0, nb_octets_justes = 0, nb_lectures_uart = 0;
+    for (uint8 paquet = 0; paquet < 10; paquet++)
+    {
+        uint8 attendu0[50], attendu1[8];
+        for (uint8 i = 0; i < sizeof(attendu0); i++) { attendu0[i] = Aleatoire(); SoftUART_send_tx(0,attendu0[i]); }
+        for (uint8 i = 0; i < sizeof(attendu1); i++) { attendu1[i] = Aleatoire(); SoftUART_send_tx(1,attendu1[i]); }
+
+        // 9ms à 57600 bauds, 9ms à 9600 bauds : trois lectures de scratchpad (environ 7ms chacune) en même temps
+        for (uint8 p = 0; p < modele.nb; p++)
+        {
+            uint8 tx[10], rx[9];
+            tx[0] = ONEWIRE_CMD_MATCH_ROM;
+            memcpy(&tx[1],modele.rom[p],8);
+            tx[9] = 0xBE;
+            HOTE_VERIFIER(OneWire_Transaction(0,true,tx,10,9,NULL));
+            HOTE_VERIFIER(Attendre() == ONEWIRE_TERMINE);
+            nb_lectures_uart += HOTE_VERIFIER(OneWire_Lire_Reception(0,rx,9) == 9 && memcmp(rx,modele.scratchpad[p],9) == 0);
+        }
+        Hote_Simuler(T(2000));
+
+        HOTE_VERIFIER(SoftUART_Available(0) == sizeof(attendu0) && SoftUART_Available(1) == sizeof(attendu1));
+        for (uint8 i = 0; i < sizeof(attendu0); i++) nb_octets_justes += (SoftUART_ReadChar(0) == attendu0[i]);
+        for (uint8 i = 0; i < sizeof(attendu1); i++) nb_octets_justes += (SoftUART_ReadChar(1) == attendu1[i]);
+        nb_octets += sizeof(attendu0) + sizeof(attendu1);
+    }
+    HOTE_VERIFIER(nb_octets_justes == nb_octets && SoftUART[0].erreurs_trame == 0 && SoftUART[1].erreurs_trame == 0);
+    HOTE_VERIFIER(modele.nb_violations == 0);
+
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+    printf("onewire : %u recherches, %u scratchpads lus, %u erreurs CRC relancees, interruptions masquees 70us : %u justes / %u abandons\n",
+           nb_recherches,nb_lectures,nb_erreurs_crc,nb_justes,nb_depassements);
+    printf("onewire : %u scratchpads lus et %u octets recus par les UART logicielles en meme temps, latence max du TIMER1 %u cycles\n",
+           nb_lectures_uart,nb_octets,TIMER1_Mux_Lire_Statistiques()->latence_max);
+    return Hote_Bilan("test_onewire");
+}
+
+/* fin du fichier */
@@ -0,0 +1,238 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_pool.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Pool_Memoire.cpp Journal_Donnees.cpp Flash_esp8266.cpp UART_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test des allocateurs (Pool_Memoire.h) sur PC :
+ *  - pool : épuisement, adresses distinctes et alignées, libérations refusées (adresse étrangère, double libération)
+ *  - endurance : allocations / libérations aléatoires, aucun bloc rendu deux fois ni écrasé
+ *  - sections critiques : appel depuis une interruption et sous Masquer_Interruptions sans rétablir les interruptions
+ *  - arène : marques, débordement
+ *  - journal (Journal_Donnees.h) : pages en RAM prises dans le pool, relecture complète, pool vide = échantillons perdus
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Pool_Memoire.h"
+#include "Journal_Donnees.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NB_BLOCS 40
+#define TAILLE_BLOC 22
+
+POOL_DECLARER(Pool_Test,TAILLE_BLOC,NB_BLOCS);
+ARENE_DECLARER(Arene_Test,100);
+
+// Interruption : alloue puis libère un bloc, le niveau d'interruption doit rester celui de l'interruption
+static uint32 nb_niveaux_faux = 0;
+static void Interruption_Test(void *arg)
+{
+    void *bloc = Pool_Allouer(&Pool_Test);
+    if (hote_niveau != 1) nb_niveaux_faux++;
+    if (bloc == NULL || !Pool_Liberer(&Pool_Test,bloc)) nb_niveaux_faux++;
+    if (hote_niveau != 1) nb_niveaux_faux++;
+    if (Arene_Allouer(&Arene_Test,4) == NULL) nb_niveaux_faux++;
+    Arene_Restaurer(&Arene_Test,0);
+    if (hote_niveau != 1) nb_niveaux_faux++;
+}
+
+static void Test_Pool()
+{
+    void *blocs[NB_BLOCS];
+    int32 local;
+
+    init_Pool(&Pool_Test);
+    HOTE_VERIFIER(Pool_Disponibles(&Pool_Test) == NB_BLOCS);
+    HOTE_VERIFIER(Pool_Test.taille_bloc == POOL_TAILLE_BLOC(TAILLE_BLOC));
+
+    // épuisement
+    for (uint16 i = 0; i < NB_BLOCS; i++)
+    {
+        blocs[i] = Pool_Allouer(&Pool_Test);
+        HOTE_VERIFIER(blocs[i] != NULL && ((uintptr_t)blocs[i] % POOL_ALIGNEMENT) == 0);
+        for (uint16 j = 0; j < i; j++) HOTE_VERIFIER(blocs[j] != blocs[i]);
+    }
+    HOTE_VERIFIER(Pool_Allouer(&Pool_Test) == NULL);
+    HOTE_VERIFIER(Pool_Test.nb_echecs == 1 && Pool_Test.max_utilises == NB_BLOCS);
+
+    // adresses refusées
+    HOTE_VERIFIER(!Pool_Liberer(&Pool_Test,NULL));
+    HOTE_VERIFIER(!Pool_Liberer(&Pool_Test,&local));
+    HOTE_VERIFIER(!Pool_Liberer(&Pool_Test,(uint8 *)blocs[3] + 1));
+    HOTE_VERIFIER(!Pool_Liberer(&Pool_Test,Pool_Test.memoire + NB_BLOCS * Pool_Test.taille_bloc));
+    HOTE_VERIFIER(Pool_Test.nb_erreurs == 4 && Pool_Test.nb_utilises == NB_BLOCS);
+
+    // double libération : le bloc n'est chaîné qu'une fois
+    HOTE_VERIFIER(Pool_Liberer(&Pool_Test,blocs[7]));
+    HOTE_VERIFIER(!Pool_Liberer(&Pool_Test,blocs[7]));
+    HOTE_VERIFIER(Pool_Test.nb_erreurs == 5 && Pool_Test.nb_utilises == NB_BLOCS - 1);
+    HOTE_VERIFIER(Pool_Allouer(&Pool_Test) == blocs[7]);
+    HOTE_VERIFIER(Pool_Allouer(&Pool_Test) == NULL);
+
+    for (uint16 i = 0; i < NB_BLOCS; i++) HOTE_VERIFIER(Pool_Liberer(&Pool_Test,blocs[i]));
+    HOTE_VERIFIER(Pool_Disponibles(&Pool_Test) == NB_BLOCS);
+
+    // init_Pool rend aussi les blocs encore alloués
+    blocs[0] = Pool_Allouer(&Pool_Test);
+    init_Pool(&Pool_Test);
+    HOTE_VERIFIER(!Pool_Liberer(&Pool_Test,blocs[0]) && Pool_Test.nb_erreurs == 1);
+}
+
+static void Test_Endurance()
+{
+    void *blocs[NB_BLOCS] = {NULL};
+    uint32 graine = 12345;
+    uint32 nb_operations = 2000000;
+    struct timespec debut, fin;
+
+    init_Pool(&Pool_Test);
+    clock_gettime(CLOCK_MONOTONIC,&debut);
+    for (uint32 n = 0; n < nb_operations; n++)
+    {
+        graine = graine * 1103515245 + 12345;
+        uint16 i = (graine >> 16) % NB_BLOCS;
+        if (blocs[i] == NULL)
+        {
+            blocs[i] = Pool_Allouer(&Pool_Test);
+            if (!HOTE_VERIFIER(blocs[i] != NULL)) break;
+            memset(blocs[i],i,TAILLE_BLOC);
+        }
+        else
+        {
+            // contenu intact : aucun autre propriétaire n'a reçu ce bloc
+            uint8 *octets = (uint8 *)blocs[i];
+            bool intact = true;
+            for (uint16 k = 0; k < TAILLE_BLOC; k++) intact &= (octets[k] == i);
+            if (!HOTE_VERIFIER(intact && Pool_Liberer(&Pool_Test,blocs[i]))) break;
+            blocs[i] = NULL;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC,&fin);
+
+    uint16 nb_alloues = 0;
+    for (uint16 i = 0; i < NB_BLOCS; i++) nb_alloues += (blocs[i] != NULL);
+    HOTE_VERIFIER(Pool_Test.nb_utilises == nb_alloues && Pool_Test.nb_echecs == 0 && Pool_Test.nb_erreurs == 0);
+
+    double ns = ((fin.tv_sec - debut.tv_sec) * 1e9 + (fin.tv_nsec - debut.tv_nsec)) / nb_operations;
+    printf("  endurance : %u operations, %.1f ns par operation (PC)\n",nb_operations,ns);
+}
+
+static void Test_Sections_Critiques()
+{
+    init_Pool(&Pool_Test);
+    init_Arene(&Arene_Test);
+    hote_erreurs_verrou = 0;
+
+    // depuis une interruption
+    ets_isr_attach(ETS_GPIO_INUM,Interruption_Test,NULL);
+    ets_isr_unmask(1 << ETS_GPIO_INUM);
+    for (uint16 i = 0; i < 10; i++) HOTE_VERIFIER(Hote_Declencher(ETS_GPIO_INUM));
+    HOTE_VERIFIER(nb_niveaux_faux == 0 && hote_niveau == 0);
+
+    // dans une section critique de l'appelant
+    uint32 etat = Masquer_Interruptions();
+    void *bloc = Pool_Allouer(&Pool_Test);
+    HOTE_VERIFIER(hote_niveau == 15);
+    Pool_Liberer(&Pool_Test,bloc);
+    Arene_Allouer(&Arene_Test,8);
+    Arene_Vider(&Arene_Test);
+    HOTE_VERIFIER(hote_niveau == 15);
+    Restaurer_Interruptions(etat);
+
+    HOTE_VERIFIER(hote_niveau == 0 && hote_erreurs_verrou == 0);
+}
+
+static void Test_Arene()
+{
+    init_Arene(&Arene_Test);
+    void *a = Arene_Allouer(&Arene_Test,10);
+    uint32 marque = Arene_Marque(&Arene_Test);
+    void *b = Arene_Allouer(&Arene_Test,1);
+    HOTE_VERIFIER(a == Arene_Test.memoire && (uint8 *)b == (uint8 *)a + POOL_TAILLE_BLOC(10));
+    HOTE_VERIFIER(Arene_Allouer(&Arene_Test,100) == NULL && Arene_Test.nb_echecs == 1);
+    Arene_Restaurer(&Arene_Test,marque);
+    HOTE_VERIFIER(Arene_Allouer(&Arene_Test,1) == b);
+    Arene_Vider(&Arene_Test);
+    HOTE_VERIFIER(Arene_Test.position == 0 && Arene_Test.max_position == marque + POOL_TAILLE_BLOC(1));
+}
+
+static void Test_Journal()
+{
+    Journal_Lecteur lecteur;
+    int32 valeurs[2], lues[2];
+    uint32 date;
+    uint8 nb_voies;
+    uint32 nb_ajoutes = 0, nb_lus = 0;
+    bool ordre = true;
+
+    HOTE_VERIFIER(init_Journal(0x300,4,2));
+    HOTE_VERIFIER(Pool_Pages_Journal.nb_utilises == 0 && Pool_Pages_Journal.nb_blocs == JOURNAL_NB_PAGES_RAM);
+
+    // 3000 échantillons, pages écrites au fil de l'eau
+    for (uint32 n = 0; n < 3000; n++)
+    {
+        valeurs[0] = 2000 + (int32)(n % 50);
+        valeurs[1] = -(int32)n;
+        nb_ajoutes += Journal_Ajouter(1000 + 10 * n,valeurs);
+        HOTE_VERIFIER(Pool_Pages_Journal.nb_utilises <= JOURNAL_NB_PAGES_RAM);
+        if (n % 7 == 0) while (Journal_Tache()) {}
+    }
+    HOTE_VERIFIER(nb_ajoutes == 3000 && Journal_Lire_Statistiques()->nb_perdus == 0);
+    HOTE_VERIFIER(Pool_Pages_Journal.nb_utilises == 1 && Pool_Pages_Journal.nb_erreurs == 0);
+
+    // relecture : flash puis page en remplissage
+    Journal_Lecture_Debut(&lecteur,0);
+    while (Journal_Lecture_Suivant(&lecteur,&date,lues,&nb_voies))
+    {
+        ordre &= (date == 1000 + 10 * nb_lus && lues[0] == 2000 + (int32)(nb_lus % 50) && lues[1] == -(int32)nb_lus);
+        nb_lus++;
+    }
+    HOTE_VERIFIER(ordre && nb_lus == 3000);
+
+    // sans Journal_Tache : le pool se vide, les échantillons suivants sont perdus
+    Journal_Vider();
+    uint32 perdus = 0;
+    for (uint32 n = 3000; n < 6000; n++)
+    {
+        valeurs[0] = valeurs[1] = 0;
+        perdus += !Journal_Ajouter(1000 + 10 * n,valeurs);
+    }
+    HOTE_VERIFIER(perdus > 0 && Journal_Lire_Statistiques()->nb_perdus == perdus);
+    HOTE_VERIFIER(Pool_Pages_Journal.nb_utilises == JOURNAL_NB_PAGES_RAM && Pool_Pages_Journal.nb_echecs == perdus);
+
+    // écriture des pages : elles reviennent au pool
+    while (Journal_Tache()) {}
+    HOTE_VERIFIER(Pool_Pages_Journal.nb_utilises == 0 && Pool_Pages_Journal.nb_erreurs == 0);
+    HOTE_VERIFIER(Journal_Ajouter(1000 + 10 * 6000,valeurs) && Pool_Pages_Journal.nb_utilises == 1);
+
+    // remontage : pages en RAM abandonnées, pages en flash retrouvées
+    Journal_Vider();
+    while (Journal_Tache()) {}
+    HOTE_VERIFIER(init_Journal(0x300,4,2) && Pool_Pages_Journal.nb_utilises == 0);
+    Journal_Lecture_Debut(&lecteur,1000 + 10 * 2999);
+    nb_lus = 0;
+    while (Journal_Lecture_Suivant(&lecteur,&date,lues,&nb_voies)) nb_lus++;
+    HOTE_VERIFIER(nb_lus == 1 + (6001 - 3000 - perdus));
+}
+
+int main()
+{
+    Hote_Init();
+
+    Test_Pool();
+    Test_Endurance();
+    Test_Sections_Critiques();
+    Test_Arene();
+    Test_Journal();
+
+    return Hote_Bilan("test_pool");
+}
+
+/* fin du fichier */
@@ -0,0 +1,230 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_rs485.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : RS485.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp GPIO_esp8266.cpp UART_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du maître RS-485 (RS485.h) sur PC, UART0 simulée à 115200 bauds, 4 esclaves simulés sur la ligne :
+ *  - paramètres : nombre d'esclaves limité, table d'interrogation invalide refusée
+ *  - direction (DE) : à l'état haut avant le premier octet, relâchée au plus tôt à la fin du bit de stop du dernier octet
+ *    et au plus tard une durée de bit après (aucune trame tronquée, aucune collision avec un esclave)
+ *  - réponses transmises intactes, latence de retournement mesurée par le maître égale à celle de l'esclave
+ *  - esclave muet : timeout respecté, compté
+ *  - table de priorité : un esclave interrogé trois fois plus souvent
+ *  - silence minimal entre la fin d'une réponse et la requête suivante
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "RS485.h"
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+#define BAUDS 115200
+#define CYCLES_BIT (ESP8266_CLOCK_FREQ / BAUDS)
+#define CYCLES_OCTET (RS485_BITS_OCTET * CYCLES_BIT)
+#define GPIO_DE GPIO5
+#define LONGUEUR_REQUETE 8
+#define NB_ESCLAVES 4
+#define TIMEOUT_US 2000
+
+// Esclaves simulés : adresse, retournement (us, 0 : muet), longueur de la réponse
+typedef struct{
+  uint8 adresse;
+  uint32 retournement;
+  uint8 longueur;
+} Esclave_Test;
+
+static const Esclave_Test esclaves[NB_ESCLAVES] = {{0x11,150,6}, {0x22,400,20}, {0x33,0,0}, {0x44,80,100}};
+
+// Ligne vue par les esclaves
+static uint8 requete[RS485_TAILLE_TRAME];
+static uint32 longueur_requete = 0;
+static bool de = false;
+static uint32 fin_dernier_octet = 0;      // fin du bit de stop du dernier octet émis par le maître
+static uint32 relachement = 0;            // dernier relâchement de DE
+static int8 esclave_muet = -1;            // esclave muet interrogé lors du dernier échange
+static int32 reponse_esclave = -1;        // esclave qui doit répondre
+static uint32 debut_reponse = 0, fin_reponse = 0;
+static uint32 nb_tronques = 0, nb_collisions = 0, nb_requetes_invalides = 0, nb_silences_courts = 0, nb_timeouts_courts = 0;
+static uint32 retard_max = 0;
+static int32 avance_max = 0;              // relâchement avant la fin du dernier octet (cycles)
+
+static int8 Esclave_Adresse(uint8 adresse)
+{
+    for (uint8 i = 0; i < NB_ESCLAVES; i++)
+    {
+        if (esclaves[i].adresse == adresse) return i;
+    }
+    return -1;
+}
+
+static void Simuler_Ligne()
+{
+    bool niveau = READ_BIT(Registre_GPIO->OUT,GPIO_DE);
+    uint8 octets[RS485_TAILLE_TRAME];
+    uint32 nb = Hote_UART0_Recevoir(octets,sizeof(octets));
+
+    // octets du maître : ligne tenue pendant toute l'émission
+    if (nb > 0)
+    {
+        if (!niveau) nb_tronques += nb;
+        for (uint32 i = 0; i < nb && longueur_requete < RS485_TAILLE_TRAME; i++) requete[longueur_requete++] = octets[i];
+        fin_dernier_octet = hote_cycles;
+    }
+    if (niveau && ((REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_TXFIFO_CNT) & 0xFF) == 0 && longueur_requete == 0
+        && (int32)(hote_cycles - fin_reponse) < 0) nb_collisions++;
+
+    // prise de la ligne : silence depuis la fin de la réponse, timeout de l'esclave muet écoulé
+    if (niveau && !de)
+    {
+        if ((int32)(hote_cycles - fin_reponse) < 0) nb_collisions++;
+        if ((uint32)(hote_cycles - fin_reponse) < RS485_SILENCE_OCTETS * CYCLES_OCTET) nb_silences_courts++;
+        if (esclave_muet >= 0 && (uint32)(hote_cycles - relachement) < TIMEOUT_US * CYCLES_PAR_US) nb_timeouts_courts++;
+        esclave_muet = -1;
+    }
+
+    // relâchement : la requête est complète, l'esclave adressé prépare sa réponse
+    if (!niveau && de)
+    {
+        int32 retard = (int32)(hote_cycles - fin_dernier_octet);
+        if (((REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_TXFIFO_CNT) & 0xFF) != 0 || longueur_requete == 0) nb_tronques++;
+        if (-retard > avance_max) avance_max = -retard;
+        if (retard > 0 && (uint32)retard > retard_max) retard_max = retard;
+        relachement = hote_cycles;
+
+        int8 esclave = (longueur_requete == LONGUEUR_REQUETE) ? Esclave_Adresse(requete[0]) : -1;
+        if (esclave < 0) nb_requetes_invalides++;
+        else
+        {
+            for (uint8 i = 2; i < LONGUEUR_REQUETE; i++)
+            {
+                if (requete[i] != (uint8)(requete[1] + i)) { nb_requetes_invalides++; break; }
+            }
+            if (esclaves[esclave].retournement == 0) esclave_muet = esclave;
+            else
+            {
+                reponse_esclave = esclave;
+                debut_reponse = hote_cycles + esclaves[esclave].retournement * CYCLES_PAR_US;
+                fin_reponse = debut_reponse + esclaves[esclave].longueur * CYCLES_OCTET;
+            }
+        }
+        longueur_requete = 0;
+    }
+    de = niveau;
+
+    // réponse de l'esclave : adresse, numéro de la requête, données
+    if (reponse_esclave >= 0 && (int32)(hote_cycles - debut_reponse) >= 0)
+    {
+        uint8 reponse[RS485_TAILLE_TRAME];
+        const Esclave_Test *esclave = &esclaves[reponse_esclave];
+        reponse[0] = esclave->adresse;
+        reponse[1] = requete[1];
+        for (uint8 i = 2; i < esclave->longueur; i++) reponse[i] = (uint8)(esclave->adresse ^ i);
+        if (niveau) nb_collisions++;
+        Hote_UART0_Envoyer(reponse,esclave->longueur);
+        reponse_esclave = -1;
+    }
+}
+
+// Application du maître
+static uint8 numero_requete = 0;
+static uint8 numero_attendu[NB_ESCLAVES];
+static uint32 nb_reponses[NB_ESCLAVES], nb_timeouts[NB_ESCLAVES], nb_reponses_invalides = 0;
+
+static uint8 Requete(uint8 esclave, uint8 adresse, uint8 *trame)
+{
+    trame[0] = adresse;
+    trame[1] = ++numero_requete;
+    for (uint8 i = 2; i < LONGUEUR_REQUETE; i++) trame[i] = (uint8)(numero_requete + i);
+    numero_attendu[esclave] = numero_requete;
+    return LONGUEUR_REQUETE;
+}
+
+static void Reponse(uint8 esclave, const uint8 *trame, uint8 longueur, uint8 statut)
+{
+    if (statut == RS485_TIMEOUT)
+    {
+        nb_timeouts[esclave]++;
+        if (longueur != 0) nb_reponses_invalides++;
+        return;
+    }
+    nb_reponses[esclave]++;
+    bool valide = (statut == RS485_OK && longueur == esclaves[esclave].longueur
+                   && trame[0] == esclaves[esclave].adresse && trame[1] == numero_attendu[esclave]);
+    for (uint8 i = 2; valide && i < longueur; i++) valide = (trame[i] == (uint8)(esclaves[esclave].adresse ^ i));
+    if (!valide) nb_reponses_invalides++;
+}
+
+// Boucle principale : RS485_Tache toutes les 20us
+static void Boucle(uint32 ms)
+{
+    for (uint32 t = 0; t < ms * 50; t++)
+    {
+        Hote_Simuler(20 * CYCLES_PAR_US);
+        RS485_Tache();
+    }
+}
+
+int main()
+{
+    static const uint8 table_invalide[3] = {0, 1, NB_ESCLAVES};
+    static const uint8 table_priorite[6] = {0, 1, 0, 2, 0, 3};
+
+    Hote_Init();
+    hote_latence_timer1 = CYCLES_PAR_US;
+    Hote_UART0_Activer();
+
+    // 1. paramètres
+    HOTE_VERIFIER(init_RS485(BAUDS,GPIO_DE,Requete,Reponse));
+    for (uint8 i = 0; i < RS485_NB_ESCLAVES; i++) HOTE_VERIFIER(RS485_Ajouter_Esclave(i + 1,TIMEOUT_US) == i);
+    HOTE_VERIFIER(RS485_Ajouter_Esclave(0x40,TIMEOUT_US) == -1);
+    HOTE_VERIFIER(init_RS485(BAUDS,GPIO_DE,Requete,Reponse));
+    for (uint8 i = 0; i < NB_ESCLAVES; i++) HOTE_VERIFIER(RS485_Ajouter_Esclave(esclaves[i].adresse,TIMEOUT_US) == i);
+    HOTE_VERIFIER(!RS485_Set_Table(table_invalide,3) && RS485_Lire_Statistiques(NB_ESCLAVES) == NULL);
+    HOTE_VERIFIER(!READ_BIT(Registre_GPIO->OUT,GPIO_DE));
+    hote_crochet_simulation = Simuler_Ligne;
+
+    // 2. tourniquet sur les 4 esclaves pendant 300ms
+    Boucle(300);
+    uint32 nb_echanges = 0;
+    for (uint8 i = 0; i < NB_ESCLAVES; i++)
+    {
+        const RS485_Statistiques *stats = RS485_Lire_Statistiques(i);
+        nb_echanges += nb_reponses[i] + nb_timeouts[i];
+        HOTE_VERIFIER(stats->nb_erreurs == 0 && stats->nb_reponses == nb_reponses[i] && stats->nb_timeouts == nb_timeouts[i]);
+        if (esclaves[i].retournement != 0)
+        {
+            // latence mesurée au pas de la boucle près (premier octet daté sous interruption)
+            HOTE_VERIFIER(nb_reponses[i] > 10 && nb_timeouts[i] == 0);
+            HOTE_VERIFIER(stats->latence_derniere + 2 >= esclaves[i].retournement && stats->latence_max <= esclaves[i].retournement + 5);
+        }
+    }
+    HOTE_VERIFIER(nb_reponses[2] == 0 && nb_timeouts[2] > 10);
+    HOTE_VERIFIER(RS485_Lire_Statistiques_Maitre()->nb_echanges == nb_echanges && nb_reponses_invalides == 0);
+
+    // 3. direction : jamais d'octet tronqué ni de collision, relâchement au plus une durée de bit après le bit de stop
+    HOTE_VERIFIER(nb_tronques == 0 && nb_collisions == 0 && nb_requetes_invalides == 0 && avance_max <= 0);
+    HOTE_VERIFIER(retard_max <= CYCLES_BIT && RS485_Lire_Statistiques_Maitre()->retard_direction_max <= CYCLES_BIT);
+    HOTE_VERIFIER(nb_silences_courts == 0 && nb_timeouts_courts == 0);
+    printf("rs485 : %u echanges, DE relache %u cycles apres le bit de stop (bit : %u cycles), latences %u / %u / %u us\n",
+           nb_echanges,retard_max,CYCLES_BIT,RS485_Lire_Statistiques(0)->latence_max,
+           RS485_Lire_Statistiques(1)->latence_max,RS485_Lire_Statistiques(3)->latence_max);
+
+    // 4. table de priorité : l'esclave 0 interrogé une fois sur deux
+    uint32 requetes[NB_ESCLAVES];
+    for (uint8 i = 0; i < NB_ESCLAVES; i++) requetes[i] = RS485_Lire_Statistiques(i)->nb_requetes;
+    HOTE_VERIFIER(RS485_Set_Table(table_priorite,6));
+    Boucle(300);
+    for (uint8 i = 0; i < NB_ESCLAVES; i++) requetes[i] = RS485_Lire_Statistiques(i)->nb_requetes - requetes[i];
+    HOTE_VERIFIER(requetes[0] + 3 >= 3 * requetes[1] && requetes[0] <= 3 * requetes[1] + 3);
+    HOTE_VERIFIER(requetes[1] + 1 >= requetes[2] && requetes[2] + 1 >= requetes[3] && requetes[3] > 0);
+    HOTE_VERIFIER(nb_tronques == 0 && nb_collisions == 0 && nb_reponses_invalides == 0 && nb_timeouts_courts == 0);
+
+    hote_crochet_simulation = NULL;
+    return Hote_Bilan("test_rs485");
+}
+
+/* fin du fichier */
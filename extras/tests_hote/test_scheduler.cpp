@@ -0,0 +1,123 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_scheduler.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Scheduler.cpp UART_esp8266.cpp GPIO_esp8266.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du Scheduler (Scheduler.h) sur PC, configuration standard 10us, 1ms, 1s :
+ *  - boucle principale normale : aucune période perdue, Scheduler_Millis exact
+ *  - boucle principale bloquée 2ms puis 15ms : ticks perdus comptés, famine seulement au-delà de SCHEDULER_FAMINE_US
+ *  - interruptions masquées 5ms : les ticks sautés par l'interruption sont crédités, Scheduler_Millis reste exact
+ *  - watchdog rafraîchi uniquement sans défaut des tâches critiques
+ *  - compatibilité : constantes FREQ_SCHEDULER / TICK_xxx_VALUE / PREDIV_SCHEDULER, compteurs virtuels globaux et init_Compteurs_Virtuels()
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Scheduler.h"
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+
+static uint32 nb_10us = 0, nb_1ms = 0, nb_1s = 0, nb_watchdog = 0;
+
+static void Tache_10us() { nb_10us++; }
+static void Tache_1ms()  { nb_1ms++; }
+static void Tache_1s()   { nb_1s++; }
+static void Watchdog()   { nb_watchdog++; }
+
+// Boucle principale : Scheduler appelé toutes les 5us pendant "us" microsecondes
+static void Boucle(uint32 us)
+{
+    for (uint32 i = 0; i < us / 5; i++)
+    {
+        Hote_Simuler(5 * CYCLES_PAR_US);
+        Scheduler(Tache_10us,Tache_1ms,Tache_1s);
+    }
+}
+
+// Temps simulé depuis le démarrage du Scheduler (ms)
+static uint32 depart;
+static uint32 Millis_Simule()
+{
+    return (hote_cycles - depart) / (1000 * CYCLES_PAR_US);
+}
+
+int main()
+{
+    Hote_Init();
+    hote_pas_simulation = 40;
+
+    depart = hote_cycles;
+    init_TIMER1_Scheduler();
+    Scheduler_Set_Watchdog(Watchdog,MASQUE_TACHE_10US | MASQUE_TACHE_1MS);
+
+    // 1. boucle normale
+    Boucle(100000);
+    const Scheduler_Statistiques *stats_10us = Scheduler_Statistiques_Tache(TACHE_10US);
+    const Scheduler_Statistiques *stats_1ms = Scheduler_Statistiques_Tache(TACHE_1MS);
+    HOTE_VERIFIER(nb_10us >= 9990 && nb_10us <= 10000);
+    HOTE_VERIFIER(nb_1ms >= 99 && nb_1ms <= 100);
+    HOTE_VERIFIER(stats_10us->nb_ticks_manques == 0 && stats_1ms->nb_ticks_manques == 0);
+    HOTE_VERIFIER(Scheduler_Dernier_Defaut()->nb_defauts == 0);
+    HOTE_VERIFIER(Scheduler_Millis() + 1 >= Millis_Simule() && Scheduler_Millis() <= Millis_Simule());
+    HOTE_VERIFIER(nb_watchdog >= 99);
+
+    // 2. boucle bloquée 2ms : 199 ticks perdus pour la tâche 10us, pas de famine (seuil : 1000 ticks)
+    Hote_Simuler(2000 * CYCLES_PAR_US);
+    Boucle(1000);
+    HOTE_VERIFIER(stats_10us->nb_ticks_manques >= 199 && stats_10us->nb_ticks_manques <= 200);
+    HOTE_VERIFIER(stats_10us->nb_famines == 0 && stats_1ms->nb_famines == 0);
+    HOTE_VERIFIER(Scheduler_Dernier_Defaut()->nb_defauts == 0);
+
+    // 3. boucle bloquée 15ms : famine des tâches 10us (1499 ticks) et 1ms (14 ticks), watchdog non rafraîchi
+    uint32 watchdog_avant = nb_watchdog;
+    Hote_Simuler(15000 * CYCLES_PAR_US);
+    Scheduler(Tache_10us,Tache_1ms,Tache_1s);
+    HOTE_VERIFIER(nb_watchdog == watchdog_avant);
+    HOTE_VERIFIER(stats_10us->nb_famines == 1 && stats_1ms->nb_famines == 1);
+    HOTE_VERIFIER(Scheduler_Dernier_Defaut()->type == DEFAUT_FAMINE);
+    Boucle(2000);
+    HOTE_VERIFIER(nb_watchdog > watchdog_avant);
+
+    // 4. interruptions masquées 5ms : l'interruption du tick arrive en retard, les ticks sautés sont crédités
+    uint32 manques_avant = stats_10us->nb_ticks_manques;
+    uint32 execution_1ms = nb_1ms;
+    uint32 ecart_avant = Millis_Simule() - Scheduler_Millis();
+    ETS_INTR_LOCK();
+    Hote_Simuler(5000 * CYCLES_PAR_US);
+    ETS_INTR_UNLOCK();
+    Boucle(1000);
+    HOTE_VERIFIER(stats_10us->nb_ticks_manques - manques_avant >= 499 && stats_10us->nb_ticks_manques - manques_avant <= 500);
+    HOTE_VERIFIER(nb_1ms - execution_1ms == 2); // 5 périodes en attente comptées en une exécution, puis 1
+    HOTE_VERIFIER(Millis_Simule() - Scheduler_Millis() == ecart_avant);
+
+    // 5. tâche 1s, phase conservée
+    Boucle(1000000 - 1000 * Millis_Simule() + 1000);
+    HOTE_VERIFIER(nb_1s == 1);
+    HOTE_VERIFIER(Scheduler_Statistiques_Tache(TACHE_1S)->nb_ticks_manques == 0);
+    HOTE_VERIFIER(Millis_Simule() - Scheduler_Millis() <= 1);
+
+    // 6. compatibilité avec les applications de la configuration fixe
+    HOTE_VERIFIER(FREQ_SCHEDULER == 100000 && TICK_MS_VALUE == 100 && TICK_S_VALUE == 100000);
+    HOTE_VERIFIER(PREDIV_SCHEDULER == DIV16 && VAL_PREDIV_SCHEDULER == 16);
+    memset(Compteur_virtuel_ms,0xA5,sizeof(Compteur_virtuel_ms));
+    memset(Compteur_virtuel_s,0xA5,sizeof(Compteur_virtuel_s));
+    init_Compteurs_Virtuels();
+    bool initialises = true;
+    for (uint16 i = 0; i < NB_COMPTEUR_US; i++) initialises &= Compteur_virtuel_us[i].valeur == 1 && !Compteur_virtuel_us[i].delay;
+    for (uint16 i = 0; i < NB_COMPTEUR_MS; i++) initialises &= Compteur_virtuel_ms[i].valeur == 1 && !Compteur_virtuel_ms[i].delay;
+    for (uint16 i = 0; i < NB_COMPTEUR_S; i++)  initialises &= Compteur_virtuel_s[i].valeur == 1 && !Compteur_virtuel_s[i].delay;
+    HOTE_VERIFIER(initialises);
+    Attente(&Compteur_virtuel_ms[NB_COMPTEUR_MS - 1],250);
+    HOTE_VERIFIER(Compteur_virtuel_ms[NB_COMPTEUR_MS - 1].valeur == 250 && Compteur_virtuel_ms[NB_COMPTEUR_MS - 1].delay);
+
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+    printf("scheduler : %u executions 10us (%u ticks perdus, %u famines), %u executions 1ms, %u watchdog\n",
+           nb_10us,stats_10us->nb_ticks_manques,stats_10us->nb_famines,nb_1ms,nb_watchdog);
+    return Hote_Bilan("test_scheduler");
+}
+
+/* fin du fichier */
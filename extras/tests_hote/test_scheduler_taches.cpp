@@ -0,0 +1,121 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_scheduler_taches.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Scheduler.cpp UART_esp8266.cpp GPIO_esp8266.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test de la configuration du Scheduler à la compilation (Scheduler_Taches) sur PC, tâches 1ms, 20ms, 1s :
+ *  - tick (PGCD des périodes), sources et rapports de division des prédiviseurs calculés à la compilation
+ *  - une interruption par ms seulement, nombre d'exécutions de chaque tâche exact, Scheduler_Millis exact
+ *  - une seule configuration par application : démarrage avec une autre configuration refusé
+ *  - boucle principale bloquée 50ms : ticks perdus comptés pour chaque tâche, phase conservée
+ *  - coût de l'interruption sur PC (ns par tick et temps CPU par seconde simulée), configuration standard comparée
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Scheduler.h"
+#include <chrono>
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+#define NB_APPELS_MESURE 1000000
+
+typedef Scheduler_Taches<1000,20000,1000000> Taches;
+typedef Scheduler_Taches<1500,2000,5000> Taches_Tick_500us;   // tick 500us, 5ms cadencée par le tick
+typedef Scheduler_Taches<1000,1000> Taches_Egales;
+typedef Scheduler_Taches<20000,1000> Taches_Decroissantes;
+enum {TACHE_1MS_APP, TACHE_20MS_APP, TACHE_1S_APP};
+
+static uint32 nb_executions[Taches::nb_taches];
+static void Tache_1ms()  { nb_executions[TACHE_1MS_APP]++; }
+static void Tache_20ms() { nb_executions[TACHE_20MS_APP]++; }
+static void Tache_1s()   { nb_executions[TACHE_1S_APP]++; }
+static const Scheduler_Fonction Fonctions[] = {Tache_1ms,Tache_20ms,Tache_1s};
+
+// Interruptions du TIMER1 comptées avant d'appeler celle du multiplexeur
+static int_handler_t Interruption_TIMER1 = NULL;
+static uint32 nb_interruptions = 0;
+static void Compter_Interruption(void *argument)
+{
+    nb_interruptions++;
+    Interruption_TIMER1(argument);
+}
+
+// Boucle principale : Scheduler_Executer appelé toutes les 100us pendant "us" microsecondes
+static void Boucle(uint32 us)
+{
+    for (uint32 i = 0; i < us / 100; i++)
+    {
+        Hote_Simuler(100 * CYCLES_PAR_US);
+        Scheduler_Executer(Fonctions);
+    }
+}
+
+static uint32 depart;
+static uint32 Millis_Simule()
+{
+    return (hote_cycles - depart) / (1000 * CYCLES_PAR_US);
+}
+
+// Coût de l'interruption d'une configuration sur PC (ns par tick)
+template <typename TACHES> static double Mesurer_Interruption()
+{
+    auto debut = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < NB_APPELS_MESURE; i++) Interruption_SCHEDULER<TACHES>(NULL);
+    auto fin = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::nano>(fin - debut).count() / NB_APPELS_MESURE;
+}
+
+int main()
+{
+    Hote_Init();
+    hote_pas_simulation = 40;
+
+    // 1. configuration générée à la compilation
+    HOTE_VERIFIER(Taches::Tick(0) == 1000 && Scheduler_Configuration<Taches>::cycles_par_tick == 1000 * CYCLES_PAR_US);
+    HOTE_VERIFIER(Taches::Source(TACHE_1MS_APP) == SCHEDULER_AUCUNE && Taches::Division(TACHE_1MS_APP) == 1);
+    HOTE_VERIFIER(Taches::Source(TACHE_20MS_APP) == TACHE_1MS_APP && Taches::Division(TACHE_20MS_APP) == 20);
+    HOTE_VERIFIER(Taches::Source(TACHE_1S_APP) == TACHE_20MS_APP && Taches::Division(TACHE_1S_APP) == 50);
+    HOTE_VERIFIER(Taches_Tick_500us::Tick(0) == 500 && Taches_Tick_500us::Source(2) == SCHEDULER_AUCUNE);
+    HOTE_VERIFIER(Taches_Tick_500us::Division(2) == 10 && Scheduler_Standard::Division(TACHE_1S) == 1000);
+    HOTE_VERIFIER(!Taches_Egales::Croissantes(0) && !Taches_Decroissantes::Croissantes(0));
+
+    // 2. une interruption par ms
+    depart = hote_cycles;
+    HOTE_VERIFIER(init_Scheduler<Taches>());
+    Interruption_TIMER1 = hote_interruptions[ETS_FRC_TIMER1_INUM];
+    hote_interruptions[ETS_FRC_TIMER1_INUM] = Compter_Interruption;
+    Boucle(2000000);
+    HOTE_VERIFIER(nb_interruptions == 2000);
+    HOTE_VERIFIER(nb_executions[TACHE_1MS_APP] == 2000 && nb_executions[TACHE_20MS_APP] == 100 && nb_executions[TACHE_1S_APP] == 2);
+    HOTE_VERIFIER(Scheduler_Millis() == Millis_Simule());
+    HOTE_VERIFIER(Scheduler_Dernier_Defaut()->nb_defauts == 0);
+
+    // 3. une seule configuration par application
+    HOTE_VERIFIER(!init_Scheduler<Scheduler_Standard>());
+
+    // 4. boucle bloquée 50ms : 49 ticks perdus pour la tâche 1ms, 1 pour la tâche 20ms
+    const Scheduler_Statistiques *stats_1ms = Scheduler_Statistiques_Tache(TACHE_1MS_APP);
+    const Scheduler_Statistiques *stats_20ms = Scheduler_Statistiques_Tache(TACHE_20MS_APP);
+    Hote_Simuler(50000 * CYCLES_PAR_US);
+    Boucle(900000);
+    HOTE_VERIFIER(stats_1ms->nb_ticks_manques == 49 && stats_20ms->nb_ticks_manques == 1 && stats_1ms->nb_famines == 1);
+    HOTE_VERIFIER(nb_executions[TACHE_1S_APP] == 2 && Scheduler_Statistiques_Tache(TACHE_1S_APP)->nb_ticks_manques == 0);
+    Boucle(100000);
+    HOTE_VERIFIER(nb_executions[TACHE_1S_APP] == 3 && nb_interruptions == 3050);
+    HOTE_VERIFIER(Scheduler_Millis() == Millis_Simule());
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+
+    // 5. coût de l'interruption (appels directs, programmation du multiplexeur comprise : échéance toujours future)
+    double ns_taches = Mesurer_Interruption<Taches>();
+    double ns_standard = Mesurer_Interruption<Scheduler_Standard>();
+    printf("scheduler_taches : interruption %.1f ns par tick (standard %.1f ns), soit %.1f us par seconde (standard %.1f us)\n",
+           ns_taches,ns_standard,ns_taches * 1000000 / Taches::Tick(0) / 1000,ns_standard * 1000000 / Scheduler_Standard::Tick(0) / 1000);
+
+    return Hote_Bilan("test_scheduler_taches");
+}
+
+/* fin du fichier */
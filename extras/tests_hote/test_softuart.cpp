@@ -0,0 +1,250 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_softuart.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : SoftUART_esp8266.cpp GPIO_esp8266.cpp Multiplexeur_TIMER1.cpp TIMER_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test des UART logicielles (SoftUART_esp8266.h) sur PC :
+ *  - UART 0 : 57600 bauds 8N1, GPIO4 (TX) rebouclée sur GPIO5 (RX)
+ *  - UART 1 : 9600 bauds 7E2, GPIO12 (TX) rebouclée sur GPIO13 (RX), en même temps que l'UART 0
+ *  - UART 2 : 57600 bauds 8O1 en réception seule sur GPIO14, trames générées par le test avec un débit décalé de 2%,
+ *             une erreur de parité et un parasite plus court qu'un demi-bit
+ *  - UART 0 et 1 : fronts émis comparés à la grille idéale des bits (depuis le front du bit de start de chaque trame), écart borné par SOFTUART_DELAI_MIN
+ *  - UART 0 et 1 seules : nombre d'interruptions par octet et charge CPU (durée des interruptions sur PC / temps simulé)
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "SoftUART_esp8266.h"
+#include <chrono>
+
+// Générateur de trames sur la GPIO14 (débit choisi par le test)
+#define GPIO_GENERATEUR 14
+
+static struct{
+  bool actif;
+  uint32 debut;
+  uint32 duree_bit;
+  uint32 trame;     // bits émis, bit de poids faible en premier
+  uint8 nb_bits;
+} generateur;
+
+static uint32 graine = 7;
+
+static uint32 Aleatoire()
+{
+    graine = graine * 1103515245 + 12345;
+    return graine >> 8;
+}
+
+// Lignes rebouclées + générateur
+static void Lignes()
+{
+    uint32 niveaux = Hote_GPIO_Niveaux();
+    uint32 externe = hote_gpio_externe;
+
+    externe = (externe & ~(1 << 5)) | (READ_BIT(niveaux,4) << 5);
+    externe = (externe & ~(1 << 13)) | (READ_BIT(niveaux,12) << 13);
+
+    uint32 niveau = 1;
+    if (generateur.actif)
+    {
+        uint32 bit = (hote_cycles - generateur.debut) / generateur.duree_bit;
+        if (bit < generateur.nb_bits) niveau = (generateur.trame >> bit) & 1;
+        else generateur.actif = false;
+    }
+    externe = (externe & ~(1 << GPIO_GENERATEUR)) | (niveau << GPIO_GENERATEUR);
+
+    hote_gpio_externe = externe;
+}
+
+// Fronts émis sur une GPIO TX, comparés à la grille idéale des bits de la trame en cours
+typedef struct{
+  uint8 gpio;
+  uint8 nb_bits;        // bits par trame (start, données, parité, stop)
+  double duree_bit;     // cycles CPU au débit exact
+  uint8 niveau;
+  bool en_trame;
+  uint32 debut;         // front du bit de start
+  uint32 nb_fronts;
+  double erreur_max;    // cycles CPU
+} Fronts_TX;
+
+static Fronts_TX fronts[2] = {
+  {4,10,(double)ESP8266_CLOCK_FREQ / 57600,1,false,0,0,0},
+  {12,11,(double)ESP8266_CLOCK_FREQ / 9600,1,false,0,0,0}
+};
+
+static void Relever_Fronts(__Registre *registre, uint32 valeur)
+{
+    uint32 niveaux = Hote_GPIO_Niveaux();
+    for (uint8 n = 0; n < 2; n++)
+    {
+        Fronts_TX *f = &fronts[n];
+        uint8 niveau = READ_BIT(niveaux,f->gpio);
+        if (niveau == f->niveau) continue;
+        f->niveau = niveau;
+
+        // Un front descendant après la fin de la trame en cours est le bit de start de la suivante
+        double position = (hote_cycles - f->debut) / f->duree_bit;
+        if (!f->en_trame || (niveau == 0 && position > f->nb_bits - 0.5))
+        {
+            f->en_trame = true;
+            f->debut = hote_cycles;
+            continue;
+        }
+        double erreur = (position - (uint32)(position + 0.5)) * f->duree_bit;
+        if (erreur < 0) erreur = -erreur;
+        if (erreur > f->erreur_max) f->erreur_max = erreur;
+        f->nb_fronts++;
+    }
+}
+
+// Interruptions TIMER1 et GPIO comptées et chronométrées (sur PC)
+static int_handler_t Interruption_TIMER1_Mux = NULL;
+static int_handler_t Interruption_GPIO_Module = NULL;
+static uint32 nb_interruptions = 0;
+static double ns_interruptions = 0;
+
+static void Chronometrer(int_handler_t interruption, void *argument)
+{
+    auto debut = std::chrono::steady_clock::now();
+    interruption(argument);
+    ns_interruptions += std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now() - debut).count();
+    nb_interruptions++;
+}
+static void Chronometrer_TIMER1(void *argument) { Chronometrer(Interruption_TIMER1_Mux,argument); }
+static void Chronometrer_GPIO(void *argument)   { Chronometrer(Interruption_GPIO_Module,argument); }
+
+// Génère une trame 8 bits, parité impaire (fausse si demandé), 1 stop, puis attend la fin de la trame
+static void Generer(uint8 donnee, bool parite_fausse, uint32 duree_bit)
+{
+    uint8 parite = 1;
+    for (uint8 i = 0; i < 8; i++) parite ^= (donnee >> i) & 1;
+    if (parite_fausse) parite ^= 1;
+
+    generateur.trame = ((uint32)donnee << 1) | ((uint32)parite << 9) | (1 << 10);
+    generateur.nb_bits = 11;
+    generateur.duree_bit = duree_bit;
+    generateur.debut = hote_cycles;
+    generateur.actif = true;
+    Hote_Simuler(12 * duree_bit);
+}
+
+int main()
+{
+    uint8 attendu0[64], attendu1[64];
+    uint32 recus0 = 0, recus1 = 0, nb_attendus0 = 0, nb_attendus1 = 0;
+
+    Hote_Init();
+    hote_crochet_simulation = Lignes;
+    Lignes();
+
+    init_SoftUART(0,5,4,57600,DATA_8,NONE,STOP_1);
+    init_SoftUART(1,13,12,9600,DATA_7,EVEN,STOP_2);
+    init_SoftUART(2,GPIO_GENERATEUR,SOFTUART_AUCUNE_GPIO,57600,DATA_8,ODD,STOP_1);
+    Hote_Simuler(10000);
+    hote_crochet_ecriture = Relever_Fronts;
+
+    // 1. deux UART en même temps (les buffers TX de 64 octets sont remplis par paquets)
+    for (uint8 paquet = 0; paquet < 20; paquet++)
+    {
+        nb_attendus0 = 40 + Aleatoire() % 20;
+        nb_attendus1 = 5 + Aleatoire() % 5;
+        for (uint32 i = 0; i < nb_attendus0; i++) attendu0[i] = Aleatoire();
+        for (uint32 i = 0; i < nb_attendus1; i++) attendu1[i] = Aleatoire() & 0x7F;
+        for (uint32 i = 0; i < nb_attendus0; i++) SoftUART_send_tx(0,attendu0[i]);
+        for (uint32 i = 0; i < nb_attendus1; i++) SoftUART_send_tx(1,attendu1[i]);
+
+        // 15ms : 60 octets à 57600 bauds (10 bits), 10 octets à 9600 bauds (11 bits)
+        Hote_Simuler(15 * (ESP8266_CLOCK_FREQ / 1000));
+
+        HOTE_VERIFIER(SoftUART_Available(0) == nb_attendus0);
+        HOTE_VERIFIER(SoftUART_Available(1) == nb_attendus1);
+        for (uint32 i = 0; i < nb_attendus0; i++) recus0 += HOTE_VERIFIER(SoftUART_ReadChar(0) == attendu0[i]);
+        for (uint32 i = 0; i < nb_attendus1; i++) recus1 += HOTE_VERIFIER(SoftUART_ReadChar(1) == attendu1[i]);
+        HOTE_VERIFIER(!SoftUART[0].tx_en_cours && !SoftUART[1].tx_en_cours);
+    }
+    HOTE_VERIFIER(SoftUART[0].erreurs_trame == 0 && SoftUART[1].erreurs_trame == 0);
+    HOTE_VERIFIER(SoftUART[0].debordements == 0 && SoftUART[1].debordements == 0);
+
+    // Fronts émis : au plus SOFTUART_DELAI_MIN d'avance (échéances regroupées), plus le débit arrondi au cycle et le pas de simulation
+    hote_crochet_ecriture = NULL;
+    for (uint8 n = 0; n < 2; n++)
+    {
+        HOTE_VERIFIER(fronts[n].nb_fronts > 500 && fronts[n].erreur_max <= SOFTUART_DELAI_MIN + 16);
+    }
+
+    // 2. débit de l'émetteur décalé de +2% et -2%
+    uint32 duree_bit = ESP8266_CLOCK_FREQ / 57600;
+    for (uint16 i = 0; i < 256; i++)
+    {
+        Generer(i,false,(i & 1) ? (duree_bit * 98) / 100 : (duree_bit * 102) / 100);
+        HOTE_VERIFIER(SoftUART_Available(2) == 1 && SoftUART_ReadChar(2) == i);
+    }
+    HOTE_VERIFIER(SoftUART[2].erreurs_trame == 0);
+
+    // 3. erreur de parité : trame rejetée et comptée
+    Generer(0x5A,true,duree_bit);
+    HOTE_VERIFIER(SoftUART_Available(2) == 0);
+    HOTE_VERIFIER(SoftUART[2].erreurs_trame == 1);
+
+    // 4. parasite d'un tiers de bit : ignoré
+    generateur.trame = 0x6;
+    generateur.nb_bits = 3;
+    generateur.duree_bit = duree_bit / 3;
+    generateur.debut = hote_cycles;
+    generateur.actif = true;
+    Hote_Simuler(12 * duree_bit);
+    HOTE_VERIFIER(SoftUART_Available(2) == 0);
+    HOTE_VERIFIER(SoftUART[2].erreurs_trame == 1);
+
+    // 5. l'UART reste utilisable après le parasite
+    Generer(0xA5,false,duree_bit);
+    HOTE_VERIFIER(SoftUART_Available(2) == 1 && SoftUART_ReadChar(2) == 0xA5);
+
+    // 6. charge CPU de chaque UART seule : 40 octets rebouclés (émission + réception)
+    Interruption_TIMER1_Mux = hote_interruptions[ETS_FRC_TIMER1_INUM];
+    Interruption_GPIO_Module = hote_interruptions[ETS_GPIO_INUM];
+    hote_interruptions[ETS_FRC_TIMER1_INUM] = Chronometrer_TIMER1;
+    hote_interruptions[ETS_GPIO_INUM] = Chronometrer_GPIO;
+    double charge[2], ns_par_interruption[2];
+    uint32 interruptions_par_octet[2];
+    for (uint8 n = 0; n < 2; n++)
+    {
+        uint32 depart = hote_cycles;
+        nb_interruptions = 0;
+        ns_interruptions = 0;
+        for (uint8 i = 0; i < 40; i++) SoftUART_send_tx(n,i);
+        while (SoftUART[n].tx_en_cours || SoftUART[n].rx_en_cours) Hote_Simuler(1000);
+        uint32 duree = hote_cycles - depart;
+
+        HOTE_VERIFIER(SoftUART_Available(n) == 40);
+        while (SoftUART_Available(n)) SoftUART_ReadChar(n);
+
+        // par bit : un changement de niveau en émission, un échantillon en réception, plus le front du bit de start
+        interruptions_par_octet[n] = nb_interruptions / 40;
+        HOTE_VERIFIER(nb_interruptions <= 40u * (2 * fronts[n].nb_bits + 2));
+        ns_par_interruption[n] = ns_interruptions / nb_interruptions;
+        charge[n] = 100.0 * ns_interruptions / (duree * (1000.0 / (ESP8266_CLOCK_FREQ / 1000000)));
+    }
+    hote_interruptions[ETS_FRC_TIMER1_INUM] = Interruption_TIMER1_Mux;
+    hote_interruptions[ETS_GPIO_INUM] = Interruption_GPIO_Module;
+
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+    printf("softuart : fronts TX a %.1f / %.1f cycles de la grille ideale au plus (57600 / 9600 bauds, sur %.0f / %.0f)\n",
+           fronts[0].erreur_max,fronts[1].erreur_max,fronts[0].duree_bit,fronts[1].duree_bit);
+    for (uint8 n = 0; n < 2; n++)
+    {
+        printf("softuart : UART %u seule, %u interruptions par octet, %.0f ns par interruption, charge CPU sur PC %.2f%%\n",
+               n,interruptions_par_octet[n],ns_par_interruption[n],charge[n]);
+    }
+    printf("softuart : %u octets a 57600 bauds, %u octets a 9600 bauds, latence max du TIMER1 %u cycles\n",
+           recus0,recus1,TIMER1_Mux_Lire_Statistiques()->latence_max);
+    return Hote_Bilan("test_softuart");
+}
+
+/* fin du fichier */
@@ -0,0 +1,157 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_stockage.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Stockage_Flash.cpp Flash_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du stockage clé / valeur (Stockage_Flash.h) sur PC, flash simulée (4 secteurs) :
+ *  - paramètres et clés invalides, valeur identique non réécrite, lecture tronquée
+ *  - endurance : 200000 écritures / suppressions aléatoires comparées à un modèle, puis remontage
+ *  - coupures d'alimentation pendant une écriture ou le ramasse-miettes : après remontage chaque clé a
+ *    son ancienne ou sa nouvelle valeur, une écriture confirmée n'est jamais perdue
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Stockage_Flash.h"
+#include <stdlib.h>
+
+#define PREMIER_SECTEUR 0x200
+#define NB_SECTEURS 4
+#define NB_CLES_TEST 40
+
+static uint8 modele[NB_CLES_TEST];
+static bool present[NB_CLES_TEST];
+
+static uint16 Taille(uint16 cle)
+{
+    return 20 + cle % 40;
+}
+
+// Compare toutes les clés au modèle (valeur remplie de l'octet "modele[cle]")
+static bool Conforme()
+{
+    for (uint16 cle = 0; cle < NB_CLES_TEST; cle++)
+    {
+        uint8 buffer[64];
+        int16 taille = Stockage_Lire(cle,buffer,sizeof(buffer));
+
+        if (present[cle] != (taille >= 0) || present[cle] != Stockage_Existe(cle)) return false;
+        if (taille < 0) continue;
+        if (taille != Taille(cle)) return false;
+        for (int16 i = 0; i < taille; i++) if (buffer[i] != modele[cle]) return false;
+    }
+    return true;
+}
+
+// Ecrit une clé (octets "valeur"), le ramasse-miettes est appelé si la flash est pleine
+static bool Ecrire(uint16 cle, uint8 valeur)
+{
+    uint8 buffer[64];
+    memset(buffer,valeur,sizeof(buffer));
+    if (!Stockage_Ecrire(cle,buffer,Taille(cle)))
+    {
+        while (Stockage_Tache()) {}
+        if (!Stockage_Ecrire(cle,buffer,Taille(cle))) return false;
+    }
+    modele[cle] = valeur;
+    present[cle] = true;
+    return true;
+}
+
+// Supprime une clé, le ramasse-miettes est appelé si la flash est pleine
+static bool Supprimer(uint16 cle)
+{
+    if (!Stockage_Supprimer(cle))
+    {
+        while (Stockage_Tache()) {}
+        if (!Stockage_Supprimer(cle)) return false;
+    }
+    present[cle] = false;
+    return true;
+}
+
+int main()
+{
+    uint8 buffer[STOCKAGE_TAILLE_MAX + 1];
+
+    Hote_Init();
+    srand(1);
+
+    // 1. paramètres
+    HOTE_VERIFIER(!init_Stockage(PREMIER_SECTEUR,2));
+    HOTE_VERIFIER(!init_Stockage(PREMIER_SECTEUR,STOCKAGE_NB_SECTEURS_MAX + 1));
+    HOTE_VERIFIER(init_Stockage(PREMIER_SECTEUR,NB_SECTEURS));
+    HOTE_VERIFIER(!Stockage_Ecrire(STOCKAGE_NB_CLES,buffer,4));
+    HOTE_VERIFIER(!Stockage_Ecrire(0,buffer,STOCKAGE_TAILLE_MAX + 1));
+    HOTE_VERIFIER(Stockage_Lire(STOCKAGE_NB_CLES,buffer,4) == -1 && Stockage_Lire(0,buffer,4) == -1);
+
+    // 2. valeur identique, lecture tronquée, suppression
+    memset(buffer,0x5A,sizeof(buffer));
+    HOTE_VERIFIER(Stockage_Ecrire(7,buffer,STOCKAGE_TAILLE_MAX));
+    uint32 ecrits = Stockage_Lire_Statistiques()->octets_ecrits;
+    HOTE_VERIFIER(Stockage_Ecrire(7,buffer,STOCKAGE_TAILLE_MAX));
+    HOTE_VERIFIER(Stockage_Lire_Statistiques()->octets_ecrits == ecrits && Stockage_Lire_Statistiques()->nb_ecritures_evitees == 1);
+    memset(buffer,0,sizeof(buffer));
+    HOTE_VERIFIER(Stockage_Lire(7,buffer,10) == STOCKAGE_TAILLE_MAX && buffer[9] == 0x5A && buffer[10] == 0);
+    HOTE_VERIFIER(Stockage_Ecrire(8,buffer,0) && Stockage_Lire(8,buffer,4) == 0);
+    HOTE_VERIFIER(Stockage_Supprimer(7) && !Stockage_Existe(7) && Stockage_Lire(7,buffer,4) == -1);
+    HOTE_VERIFIER(Stockage_Supprimer(8));
+    while (Stockage_Tache()) {}
+
+    // 3. endurance
+    bool ecritures = true;
+    for (uint32 n = 0; n < 200000; n++)
+    {
+        uint16 cle = rand() % NB_CLES_TEST;
+        uint8 valeur = rand() % 5;
+        uint8 action = rand() % 10;
+
+        if (action < 7) ecritures &= Ecrire(cle,valeur);
+        else if (action < 8)
+        {
+            ecritures &= Supprimer(cle);
+        }
+        else Stockage_Tache();
+    }
+    HOTE_VERIFIER(ecritures && Conforme());
+    HOTE_VERIFIER(init_Stockage(PREMIER_SECTEUR,NB_SECTEURS) && Conforme());
+
+    // 4. coupures d'alimentation
+    uint32 nb_incoherences = 0, nb_perdues = 0, nb_coupures = 0;
+    for (uint32 essai = 0; essai < 3000; essai++)
+    {
+        uint16 cle = rand() % NB_CLES_TEST;
+        uint8 valeur = rand() % 5;
+        memset(buffer,valeur,sizeof(buffer));
+
+        hote_flash_budget = rand() % 6;
+        for (uint8 j = 0; j < 3; j++) Stockage_Tache();
+        bool confirme = Stockage_Ecrire(cle,buffer,Taille(cle));
+        nb_coupures += (hote_flash_budget == 0);
+        hote_flash_budget = -1;
+
+        HOTE_VERIFIER(init_Stockage(PREMIER_SECTEUR,NB_SECTEURS));
+        int16 taille = Stockage_Lire(cle,buffer,sizeof(buffer));
+        bool nouvelle = (taille == Taille(cle) && buffer[0] == valeur);
+        if (nouvelle)
+        {
+            modele[cle] = valeur;
+            present[cle] = true;
+        }
+        else if (confirme) nb_perdues++;
+        if (!Conforme()) nb_incoherences++;
+        while (Stockage_Tache()) {}
+    }
+    HOTE_VERIFIER(nb_coupures > 500 && nb_incoherences == 0 && nb_perdues == 0);
+
+    printf("stockage : %u essais sur 3000 interrompus par une coupure, %u effacements de secteur\n",
+           nb_coupures,hote_flash_nb_effacements);
+
+    return Hote_Bilan("test_stockage");
+}
+
+/* fin du fichier */
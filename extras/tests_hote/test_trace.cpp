@@ -0,0 +1,104 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_trace.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : Trace_Registres.cpp UART_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du traçage des registres (Trace_Registres.h) sur PC :
+ *  - entrées : décalage, zone DPORT, sens de l'accès, valeur, délai en us
+ *  - accès tracés depuis une interruption et dans une section critique : le niveau d'interruption est conservé
+ *  - trace pleine : accès perdus comptés
+ *  - envoi sur l'UART : en-tête "TRG1" puis entrées
+ * =============================================================================================================================================
+ */
+
+#include "hote.h"
+#include "Trace_Registres.h"
+#include "TIMER_esp8266.h"
+#include "UART_esp8266.h"
+#include <string.h>
+
+#define CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+
+// Interruption : deux accès tracés, le niveau d'interruption doit rester celui de l'interruption
+static uint32 nb_niveaux_faux = 0;
+static void Interruption_Test(void *arg)
+{
+    Trace_Ecriture_Registre(&Registre_TIMER1->LOAD_ADDRESS,0x1234);
+    if (hote_niveau != 1) nb_niveaux_faux++;
+    Trace_Lecture_Registre(&Registre_TIMER1->LOAD_ADDRESS);
+    if (hote_niveau != 1) nb_niveaux_faux++;
+}
+
+// Octets émis sur l'UART0
+static uint8 emis[sizeof(Trace_Entree) * NB_TRACE_REGISTRES + 64];
+static uint32 nb_emis = 0;
+static void Ecriture_UART(__Registre *registre, uint32 valeur)
+{
+    if (registre == &Registre_UART0->FIFO && nb_emis < sizeof(emis)) emis[nb_emis++] = valeur & 0xFF;
+}
+
+int main()
+{
+    Hote_Init();
+    hote_pas_cycles = 0;
+
+    // 1. entrées
+    Trace_Registres_Demarrer();
+    Hote_Avancer_Cycles(25 * CYCLES_PAR_US);
+    Trace_Ecriture_Registre(&Registre_TIMER1->LOAD_ADDRESS,0xCAFE);
+    Hote_Avancer_Cycles(3 * CYCLES_PAR_US);
+    HOTE_VERIFIER(Trace_Lecture_Registre(&Registre_TIMER1->LOAD_ADDRESS) == 0xCAFE);
+    Hote_Avancer_Cycles(100000 * CYCLES_PAR_US);
+    Trace_Lecture_Registre((__Registre *)(uintptr_t)(TRACE_ZONE_DPORT + 0x10));
+
+    const Trace_Entree *e0 = Trace_Registres_Entree(0), *e1 = Trace_Registres_Entree(1), *e2 = Trace_Registres_Entree(2);
+    HOTE_VERIFIER(Trace_Registres_Nombre() == 3 && Trace_Registres_Entree(3) == NULL);
+    HOTE_VERIFIER(e0->registre == (((uint32)(uintptr_t)&Registre_TIMER1->LOAD_ADDRESS & TRACE_MASQUE_DECALAGE) | (1 << BIT_TRACE_ECRITURE)));
+    HOTE_VERIFIER(e0->delai == 25 && e0->valeur == 0xCAFE);
+    HOTE_VERIFIER(e1->registre == (e0->registre & ~(1 << BIT_TRACE_ECRITURE)) && e1->delai == 3 && e1->valeur == 0xCAFE);
+    HOTE_VERIFIER(e2->registre == (0x10 | (1 << BIT_TRACE_DPORT)) && e2->delai == 0xFFFF);
+
+    // 2. interruptions et sections critiques
+    hote_erreurs_verrou = 0;
+    ets_isr_attach(ETS_FRC_TIMER1_INUM,Interruption_Test,NULL);
+    ets_isr_unmask(1 << ETS_FRC_TIMER1_INUM);
+    for (uint16 i = 0; i < 10; i++) HOTE_VERIFIER(Hote_Declencher(ETS_FRC_TIMER1_INUM));
+    HOTE_VERIFIER(nb_niveaux_faux == 0 && hote_niveau == 0 && Trace_Registres_Nombre() == 23);
+
+    uint32 etat = Masquer_Interruptions();
+    Trace_Ecriture_Registre(&Registre_TIMER1->LOAD_ADDRESS,1);
+    HOTE_VERIFIER(hote_niveau == 15);
+    Restaurer_Interruptions(etat);
+    HOTE_VERIFIER(hote_niveau == 0 && hote_erreurs_verrou == 0);
+
+    // 3. trace pleine
+    Trace_Registres_Demarrer();
+    for (uint32 i = 0; i < NB_TRACE_REGISTRES + 10; i++) Trace_Ecriture_Registre(&Registre_TIMER1->LOAD_ADDRESS,i);
+    HOTE_VERIFIER(Trace_Registres_Nombre() == NB_TRACE_REGISTRES);
+    HOTE_VERIFIER(Trace_Registres_Entree(NB_TRACE_REGISTRES - 1)->valeur == NB_TRACE_REGISTRES - 1);
+
+    // 4. envoi : accès à l'UART non tracés
+    hote_crochet_ecriture = Ecriture_UART;
+    Trace_Registres_Envoyer(UART0);
+    hote_crochet_ecriture = NULL;
+    uint16 nb_entrees;
+    uint32 nb_perdues;
+    memcpy(&nb_entrees,&emis[4],2);
+    memcpy(&nb_perdues,&emis[8],4);
+    HOTE_VERIFIER(nb_emis == 12 + sizeof(Trace_Entree) * NB_TRACE_REGISTRES && memcmp(emis,"TRG1",4) == 0);
+    HOTE_VERIFIER(nb_entrees == NB_TRACE_REGISTRES && nb_perdues == 10);
+    HOTE_VERIFIER(memcmp(&emis[12],Trace_Registres_Entree(0),sizeof(Trace_Entree) * NB_TRACE_REGISTRES) == 0);
+    HOTE_VERIFIER(Trace_Registres_Nombre() == NB_TRACE_REGISTRES);
+
+    Trace_Registres_Arreter();
+    Trace_Ecriture_Registre(&Registre_TIMER1->LOAD_ADDRESS,0);
+    HOTE_VERIFIER(Trace_Registres_Nombre() == NB_TRACE_REGISTRES);
+
+    return Hote_Bilan("test_trace");
+}
+
+/* fin du fichier */
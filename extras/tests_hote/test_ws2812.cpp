@@ -0,0 +1,219 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : test_ws2812.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  Sources  : WS2812_esp8266.cpp UART_esp8266.cpp GPIO_esp8266.cpp registres_esp8266.cpp
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Test du pilote WS2812 (WS2812_esp8266.h) sur PC, avec un modèle de l'UART1 :
+ *  - fifo TX de 128 octets vidée au débit programmé (CLKDIV), interruption "fifo TX vide" sous le seuil (CONF1),
+ *    servie avec un retard aléatoire (jusqu'à 50us)
+ *  - les octets émis sont reconvertis en signal (start + 6 bits + stop, sortie inversée), puis décodés
+ *    en bits WS2812 (1.25us : '0' = 312ns haut, '1' = 937ns haut) et en pixels (vert, rouge, bleu)
+ *  Vérifie les pixels décodés (gamma 2.8, luminosité), l'absence de trou dans le signal pendant une trame
+ *  et le temps de reset avant la trame suivante.
+ * =============================================================================================================================================
+ */
+
+#include <math.h>
+#include <vector>
+#include "hote.h"
+#include "WS2812_esp8266.h"
+
+#define NB_LEDS 300
+#define LATENCE_MAX (50 * (ESP8266_CLOCK_FREQ / 1000000))
+
+// Modèle de l'UART1
+static struct{
+  uint8 fifo[UART_TAILLE_FIFO];
+  uint16 lecture;
+  uint16 nb;
+  uint32 debordements;
+  uint32 fin_octet;          // fin de l'octet en cours d'émission (cycles)
+  bool emission;
+  uint32 declenchement;      // interruption en attente, servie à cet instant
+  bool en_attente;
+  uint32 nb_interruptions;
+  std::vector<uint8> emis;   // octets émis depuis le début de la trame
+  uint32 nb_trous;           // fifo vide au milieu d'une trame
+  uint32 fin_emission;       // fin du dernier octet émis
+} uart;
+
+static uint32 graine = 11;
+
+static uint32 Aleatoire()
+{
+    graine = graine * 1103515245 + 12345;
+    return graine >> 8;
+}
+
+static uint32 Cycles_Par_Octet()
+{
+    return 8 * (Registre_UART1->CLKDIV & 0xFFFFF); // start + 6 bits + stop
+}
+
+// Etat des interruptions : "fifo TX vide" active tant que la fifo est sous le seuil
+static void Mettre_A_Jour()
+{
+    uint32 seuil = (Registre_UART1->CONF1 >> BIT_UART_TXFIFO_EMPTY_THRHD) & 0x7F;
+
+    Registre_UART1->STATUS = (Registre_UART1->STATUS & ~(0xFF << BIT_UART_TXFIFO_CNT)) | ((uint32)uart.nb << BIT_UART_TXFIFO_CNT);
+    if (uart.nb < seuil) Registre_UART1->INT_RAW |= (1 << BIT_UART_INT_TXFIFO_EMPTY);
+    Registre_UART1->INT_ST = Registre_UART1->INT_RAW & Registre_UART1->INT_ENA;
+
+    if (Registre_UART1->INT_ST != 0 && !uart.en_attente)
+    {
+        uart.en_attente = true;
+        uart.declenchement = hote_cycles + Aleatoire() % LATENCE_MAX;
+    }
+}
+
+static void Ecriture_Registre(__Registre *registre, uint32 valeur)
+{
+    if (registre == &Registre_UART1->FIFO)
+    {
+        if (uart.nb == UART_TAILLE_FIFO) uart.debordements++;
+        else uart.fifo[(uart.lecture + uart.nb++) % UART_TAILLE_FIFO] = valeur;
+    }
+    else if (registre == &Registre_UART1->INT_CLR)
+    {
+        Registre_UART1->INT_RAW &= ~valeur;
+        Registre_UART1->INT_CLR = 0;
+    }
+    else if (registre != &Registre_UART1->INT_ENA && registre != &Registre_UART1->CONF1) return;
+    Mettre_A_Jour();
+}
+
+// Emission des octets de la fifo au débit de l'UART
+static void Simulation()
+{
+    if (uart.emission && (int32)(hote_cycles - uart.fin_octet) >= 0)
+    {
+        uart.emission = false;
+        uart.fin_emission = uart.fin_octet;
+    }
+    if (!uart.emission && uart.nb > 0)
+    {
+        // l'octet suivant doit suivre immédiatement le précédent pendant une trame
+        if (!uart.emis.empty() && hote_cycles - uart.fin_emission > hote_pas_simulation) uart.nb_trous++;
+        uart.emis.push_back(uart.fifo[uart.lecture]);
+        uart.lecture = (uart.lecture + 1) % UART_TAILLE_FIFO;
+        uart.nb--;
+        uart.emission = true;
+        uart.fin_octet = hote_cycles + Cycles_Par_Octet();
+    }
+    Mettre_A_Jour();
+
+    if (uart.en_attente && (int32)(hote_cycles - uart.declenchement) >= 0)
+    {
+        uart.en_attente = false;
+        uart.nb_interruptions++;
+        Hote_Declencher(ETS_UART_INUM);
+        Mettre_A_Jour();
+    }
+}
+
+// Décodage du signal : 8 bits UART par octet (start, 6 bits poids faible en premier, stop), sortie inversée,
+// puis 4 bits UART par bit WS2812. Retourne false si un motif n'est pas un '0' ou un '1' valide.
+static bool Decoder(std::vector<uint8> &octets, std::vector<uint8> &pixels)
+{
+    std::vector<uint8> signal;
+    for (size_t i = 0; i < octets.size(); i++)
+    {
+        uint16 trame = ((uint16)(octets[i] & 0x3F) << 1) | (1 << 7); // start à 0, stop à 1
+        for (uint8 b = 0; b < 8; b++) signal.push_back(!((trame >> b) & 1));
+    }
+
+    uint32 octet = 0;
+    uint8 nb_bits = 0;
+    for (size_t i = 0; i + 4 <= signal.size(); i += 4)
+    {
+        uint8 motif = (signal[i] << 3) | (signal[i + 1] << 2) | (signal[i + 2] << 1) | signal[i + 3];
+        if (motif != 0x8 && motif != 0xE) return false;
+        octet = (octet << 1) | (motif == 0xE);
+        if (++nb_bits == 8)
+        {
+            pixels.push_back(octet);
+            octet = 0;
+            nb_bits = 0;
+        }
+    }
+    return nb_bits == 0;
+}
+
+// Envoie l'image et vérifie les composantes reçues (vert, rouge, bleu)
+static bool Envoyer(const uint8 *attendu, uint32 *duree_reset)
+{
+    uart.emis.clear();
+    if (!HOTE_VERIFIER(WS2812_Afficher())) return false;
+    HOTE_VERIFIER(!WS2812_Afficher()); // trame en cours
+
+    // attente de la fin de la trame et du reset
+    uint32 debut = hote_cycles;
+    while (!WS2812_Pret() && hote_cycles - debut < 20 * ESP8266_CLOCK_FREQ / 1000) Hote_Simuler(hote_pas_simulation);
+    HOTE_VERIFIER(uart.nb == 0 && !uart.emission);
+    *duree_reset = (hote_cycles - uart.fin_emission) / (ESP8266_CLOCK_FREQ / 1000000);
+
+    std::vector<uint8> pixels;
+    if (!HOTE_VERIFIER(Decoder(uart.emis,pixels))) return false;
+    if (!HOTE_VERIFIER(pixels.size() == 3 * NB_LEDS)) return false;
+    return HOTE_VERIFIER(memcmp(&pixels[0],attendu,3 * NB_LEDS) == 0);
+}
+
+int main()
+{
+    static uint8 rouge[NB_LEDS], vert[NB_LEDS], bleu[NB_LEDS], attendu[3 * NB_LEDS];
+    uint32 duree_reset, reset_min = 0xFFFFFFFF, reset_max = 0;
+
+    Hote_Init();
+    hote_crochet_ecriture = Ecriture_Registre;
+    hote_crochet_simulation = Simulation;
+
+    init_WS2812(NB_LEDS);
+    HOTE_VERIFIER(Cycles_Par_Octet() == WS2812_CYCLES_PAR_OCTET_UART);
+    HOTE_VERIFIER(READ_BIT(Registre_UART1->CONF0,BIT_UART_TXD_INV));
+    HOTE_VERIFIER(WS2812_Pret());
+
+    for (uint8 essai = 0; essai < 12; essai++)
+    {
+        bool gamma = (essai % 3) != 0;
+        uint8 luminosite = (essai % 4 == 0) ? 255 : Aleatoire();
+        WS2812_Set_Gamma(gamma);
+        WS2812_Set_Luminosite(luminosite);
+
+        for (uint16 i = 0; i < NB_LEDS; i++)
+        {
+            rouge[i] = Aleatoire(); vert[i] = Aleatoire(); bleu[i] = Aleatoire();
+            WS2812_Set_Pixel(i,rouge[i],vert[i],bleu[i]);
+        }
+        WS2812_Set_Pixel(NB_LEDS,1,2,3); // hors du ruban : ignoré
+
+        // correction attendue : gamma 2.8 arrondi, puis luminosité
+        for (uint16 i = 0; i < 3 * NB_LEDS; i++)
+        {
+            uint8 brut = (i % 3 == 0) ? vert[i / 3] : (i % 3 == 1) ? rouge[i / 3] : bleu[i / 3];
+            uint16 valeur = gamma ? (uint16)(pow(brut / 255.0,2.8) * 255 + 0.5) : brut;
+            attendu[i] = (valeur * (luminosite + 1)) >> 8;
+        }
+
+        Envoyer(attendu,&duree_reset);
+        if (duree_reset < reset_min) reset_min = duree_reset;
+        if (duree_reset > reset_max) reset_max = duree_reset;
+    }
+
+    // ruban éteint
+    WS2812_Remplir(0,0,0);
+    memset(attendu,0,sizeof(attendu));
+    Envoyer(attendu,&duree_reset);
+
+    HOTE_VERIFIER(uart.nb_trous == 0);
+    HOTE_VERIFIER(uart.debordements == 0);
+    HOTE_VERIFIER(reset_min >= WS2812_T_RESET && reset_max < WS2812_T_RESET + 100);
+    HOTE_VERIFIER(hote_erreurs_verrou == 0);
+    printf("ws2812 : 13 trames de %u LED, %u interruptions UART, reset %u a %u us\n",NB_LEDS,uart.nb_interruptions,reset_min,reset_max);
+    return Hote_Bilan("test_ws2812");
+}
+
+/* fin du fichier */
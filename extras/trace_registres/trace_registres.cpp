@@ -0,0 +1,390 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : trace_registres.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Outil PC d'analyse des traces d'accès aux registres (voir src/Trace_Registres.h)
+ *
+ *  Compilation : g++ -std=c++11 -O2 -o trace_registres trace_registres.cpp
+ *
+ *  Utilisation :
+ *      trace_registres resume  trace.bin               registres les plus utilisés, écritures redondantes,
+ *                                                      lectures de registres en écriture seule
+ *      trace_registres rejouer trace.bin [reference]   rejoue la trace sur le modèle des registres et affiche
+ *                                                      l'état final ; avec une référence, compare les écritures
+ *                                                      et l'état final (code de retour 1 si différents)
+ *
+ *  La trace est le flux binaire envoyé par Trace_Registres_Envoyer (capturé depuis le port série).
+ * =============================================================================================================================================
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// ##########################################################################################################################
+//                                     DEFINE ET TYPES
+// ##########################################################################################################################
+
+// Format de la trace (identique à src/Trace_Registres.h)
+#define TRACE_ZONE_PERIPH     0x60000000u
+#define TRACE_ZONE_DPORT      0x3FF00000u
+#define TRACE_MASQUE_DECALAGE 0x1FFF
+#define BIT_TRACE_DPORT       13
+#define BIT_TRACE_ECRITURE    15
+
+typedef struct{
+  uint32_t adresse;
+  bool ecriture;
+  uint32_t delai;     // us
+  uint32_t valeur;
+} Acces;
+
+typedef struct{
+  std::vector<Acces> acces;
+  uint32_t nb_perdues;
+} Trace;
+
+// Comportement d'un registre dans le modèle
+typedef enum {
+  REG_NORMAL,     // mémorise la valeur écrite
+  REG_VOLATILE,   // modifié par le matériel (entrées, statuts, compteurs, fifo)
+  REG_W1TS,       // écriture seule : met à 1 les bits d'un autre registre
+  REG_W1TC        // écriture seule : met à 0 les bits d'un autre registre
+} Type_Registre;
+
+typedef struct{
+  uint32_t adresse;
+  const char *nom;
+  Type_Registre type;
+  uint32_t cible;   // registre modifié (REG_W1TS / REG_W1TC)
+} Description_Registre;
+
+// Registres connus (les autres sont traités comme REG_NORMAL)
+static const Description_Registre Registres[] = {
+  {0x60000300, "GPIO.OUT",          REG_NORMAL,   0},
+  {0x60000304, "GPIO.OUT_W1TS",     REG_W1TS,     0x60000300},
+  {0x60000308, "GPIO.OUT_W1TC",     REG_W1TC,     0x60000300},
+  {0x6000030C, "GPIO.ENABLE",       REG_NORMAL,   0},
+  {0x60000310, "GPIO.ENABLE_W1TS",  REG_W1TS,     0x6000030C},
+  {0x60000314, "GPIO.ENABLE_W1TC",  REG_W1TC,     0x6000030C},
+  {0x60000318, "GPIO.IN",           REG_VOLATILE, 0},
+  {0x6000031C, "GPIO.STATUS",       REG_VOLATILE, 0},
+  {0x60000320, "GPIO.STATUS_W1TS",  REG_W1TS,     0x6000031C},
+  {0x60000324, "GPIO.STATUS_W1TC",  REG_W1TC,     0x6000031C},
+  {0x60000600, "TIMER1.LOAD",       REG_NORMAL,   0},
+  {0x60000604, "TIMER1.COUNT",      REG_VOLATILE, 0},
+  {0x60000608, "TIMER1.CTRL",       REG_NORMAL,   0},
+  {0x6000060C, "TIMER1.INT",        REG_NORMAL,   0},
+  {0x60000620, "TIMER2.LOAD",       REG_NORMAL,   0},
+  {0x60000624, "TIMER2.COUNT",      REG_VOLATILE, 0},
+  {0x60000628, "TIMER2.CTRL",       REG_NORMAL,   0},
+  {0x6000062C, "TIMER2.INT",        REG_NORMAL,   0},
+  {0x60000630, "TIMER2.ALARM",      REG_NORMAL,   0},
+  {0x60000000, "UART0.FIFO",        REG_VOLATILE, 0},
+  {0x60000004, "UART0.INT_RAW",     REG_VOLATILE, 0},
+  {0x60000008, "UART0.INT_ST",      REG_VOLATILE, 0},
+  {0x6000000C, "UART0.INT_ENA",     REG_NORMAL,   0},
+  {0x60000010, "UART0.INT_CLR",     REG_W1TC,     0x60000008},
+  {0x60000014, "UART0.CLKDIV",      REG_NORMAL,   0},
+  {0x6000001C, "UART0.STATUS",      REG_VOLATILE, 0},
+  {0x60000020, "UART0.CONF0",       REG_NORMAL,   0},
+  {0x60000024, "UART0.CONF1",       REG_NORMAL,   0},
+  {0x60000F00, "UART1.FIFO",        REG_VOLATILE, 0},
+  {0x60000F04, "UART1.INT_RAW",     REG_VOLATILE, 0},
+  {0x60000F08, "UART1.INT_ST",      REG_VOLATILE, 0},
+  {0x60000F0C, "UART1.INT_ENA",     REG_NORMAL,   0},
+  {0x60000F10, "UART1.INT_CLR",     REG_W1TC,     0x60000F08},
+  {0x60000F14, "UART1.CLKDIV",      REG_NORMAL,   0},
+  {0x60000F1C, "UART1.STATUS",      REG_VOLATILE, 0},
+  {0x60000F20, "UART1.CONF0",       REG_NORMAL,   0},
+  {0x60000F24, "UART1.CONF1",       REG_NORMAL,   0},
+};
+
+// ##########################################################################################################################
+//                                      FONCTIONS
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Decrire_Registre
+  DESCRIPTION   : Recherche la description d'un registre
+  PARAMETRES    : Adresse du registre
+  RETOUR        : Description, NULL si le registre n'est pas connu
+===============================================================================*/
+static const Description_Registre *Decrire_Registre(uint32_t adresse)
+{
+    for (size_t i = 0; i < sizeof(Registres) / sizeof(Registres[0]); i++)
+    {
+        if (Registres[i].adresse == adresse) return &Registres[i];
+    }
+    return NULL;
+}
+
+/*===============================================================================
+  FONCTION      : Nom_Registre
+  DESCRIPTION   : Nom lisible d'un registre (nom connu ou adresse)
+  PARAMETRES    : Adresse du registre
+  RETOUR        : Nom
+===============================================================================*/
+static std::string Nom_Registre(uint32_t adresse)
+{
+    const Description_Registre *description = Decrire_Registre(adresse);
+    char texte[32];
+
+    if (description != NULL) return description->nom;
+
+    // Registres de configuration des GPIO et de l'IOMUX
+    if (adresse >= 0x60000328 && adresse < 0x60000364) snprintf(texte,sizeof(texte),"GPIO.PIN[%u]",(adresse - 0x60000328) / 4);
+    else if (adresse >= 0x60000804 && adresse < 0x60000844) snprintf(texte,sizeof(texte),"IOMUX.GPIO[%u]",(adresse - 0x60000804) / 4);
+    else snprintf(texte,sizeof(texte),"0x%08X",adresse);
+    return texte;
+}
+
+/*===============================================================================
+  FONCTION      : Lire_Trace
+  DESCRIPTION   : Charge une trace binaire
+  PARAMETRES    : Chemin du fichier, trace à remplir
+  RETOUR        : false si le fichier est illisible ou mal formé
+===============================================================================*/
+static bool Lire_Trace(const char *chemin, Trace &trace)
+{
+    FILE *fichier = fopen(chemin,"rb");
+    uint8_t entete[12];
+
+    if (fichier == NULL)
+    {
+        fprintf(stderr,"%s : impossible d'ouvrir le fichier\n",chemin);
+        return false;
+    }
+
+    // recherche de l'en-tête (le flux série peut contenir du texte avant la trace)
+    size_t lus = fread(entete,1,4,fichier);
+    while (lus == 4 && memcmp(entete,"TRG1",4) != 0)
+    {
+        memmove(entete,entete + 1,3);
+        lus = 3 + fread(entete + 3,1,1,fichier);
+    }
+    if (lus != 4 || fread(entete + 4,1,8,fichier) != 8)
+    {
+        fprintf(stderr,"%s : en-tete TRG1 introuvable\n",chemin);
+        fclose(fichier);
+        return false;
+    }
+
+    uint32_t nb_entrees = entete[4] | (entete[5] << 8);
+    trace.nb_perdues = entete[8] | (entete[9] << 8) | (entete[10] << 16) | ((uint32_t)entete[11] << 24);
+    trace.acces.clear();
+
+    for (uint32_t i = 0; i < nb_entrees; i++)
+    {
+        uint8_t e[8];
+        if (fread(e,1,8,fichier) != 8)
+        {
+            fprintf(stderr,"%s : trace tronquee (%u entrees sur %u)\n",chemin,i,nb_entrees);
+            break;
+        }
+        uint16_t registre = e[0] | (e[1] << 8);
+        Acces acces;
+        acces.adresse  = ((registre >> BIT_TRACE_DPORT) & 1 ? TRACE_ZONE_DPORT : TRACE_ZONE_PERIPH) | (registre & TRACE_MASQUE_DECALAGE);
+        acces.ecriture = (registre >> BIT_TRACE_ECRITURE) & 1;
+        acces.delai    = e[2] | (e[3] << 8);
+        acces.valeur   = e[4] | (e[5] << 8) | (e[6] << 16) | ((uint32_t)e[7] << 24);
+        trace.acces.push_back(acces);
+    }
+    fclose(fichier);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Appliquer_Acces
+  DESCRIPTION   : Applique un accès au modèle des registres
+  PARAMETRES    : Modèle (adresse -> valeur), accès
+  RETOUR        : true si l'écriture ne modifie pas le modèle (écriture redondante)
+===============================================================================*/
+static bool Appliquer_Acces(std::map<uint32_t,uint32_t> &modele, const Acces &acces)
+{
+    const Description_Registre *description = Decrire_Registre(acces.adresse);
+    Type_Registre type = description ? description->type : REG_NORMAL;
+
+    if (!acces.ecriture)
+    {
+        // une lecture donne la valeur actuelle du registre
+        if (type != REG_W1TS && type != REG_W1TC) modele[acces.adresse] = acces.valeur;
+        return false;
+    }
+
+    switch (type)
+    {
+        case REG_W1TS :
+        {
+            bool connu = modele.count(description->cible) != 0;
+            uint32_t avant = modele[description->cible];
+            modele[description->cible] = avant | acces.valeur;
+            return connu && (avant | acces.valeur) == avant;
+        }
+        case REG_W1TC :
+        {
+            bool connu = modele.count(description->cible) != 0;
+            uint32_t avant = modele[description->cible];
+            modele[description->cible] = avant & ~acces.valeur;
+            return connu && (avant & ~acces.valeur) == avant;
+        }
+        case REG_VOLATILE :
+            modele[acces.adresse] = acces.valeur;
+            return false;
+        default :
+        {
+            bool redondante = modele.count(acces.adresse) != 0 && modele[acces.adresse] == acces.valeur;
+            modele[acces.adresse] = acces.valeur;
+            return redondante;
+        }
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Resumer
+  DESCRIPTION   : Affiche les statistiques d'une trace
+  PARAMETRES    : Trace
+  RETOUR        : 0
+===============================================================================*/
+static int Resumer(const Trace &trace)
+{
+    struct Statistiques { uint32_t lectures, ecritures, redondantes; };
+    std::map<uint32_t,Statistiques> stats;
+    std::map<uint32_t,uint32_t> modele;
+    uint64_t duree = 0;
+    uint32_t total_redondantes = 0, lectures_ecriture_seule = 0;
+
+    for (size_t i = 0; i < trace.acces.size(); i++)
+    {
+        const Acces &acces = trace.acces[i];
+        const Description_Registre *description = Decrire_Registre(acces.adresse);
+        Statistiques &s = stats[acces.adresse];
+
+        duree += acces.delai;
+        if (acces.ecriture) s.ecritures++;
+        else
+        {
+            s.lectures++;
+            // lecture d'un registre W1TS/W1TC : en général un SET_BIT sur un registre en écriture seule
+            if (description && (description->type == REG_W1TS || description->type == REG_W1TC)) lectures_ecriture_seule++;
+        }
+        if (Appliquer_Acces(modele,acces))
+        {
+            s.redondantes++;
+            total_redondantes++;
+        }
+    }
+
+    printf("acces : %zu (perdus : %u), duree : %llu us\n",trace.acces.size(),trace.nb_perdues,(unsigned long long)duree);
+    printf("ecritures redondantes : %u, lectures de registres en ecriture seule : %u\n\n",total_redondantes,lectures_ecriture_seule);
+
+    // tri par nombre d'accès décroissant
+    std::vector<std::pair<uint32_t,Statistiques> > classement(stats.begin(),stats.end());
+    std::sort(classement.begin(),classement.end(),
+              [](const std::pair<uint32_t,Statistiques> &a, const std::pair<uint32_t,Statistiques> &b)
+              { return a.second.lectures + a.second.ecritures > b.second.lectures + b.second.ecritures; });
+
+    printf("%-20s %10s %10s %12s\n","registre","lectures","ecritures","redondantes");
+    for (size_t i = 0; i < classement.size(); i++)
+    {
+        printf("%-20s %10u %10u %12u\n",Nom_Registre(classement[i].first).c_str(),
+               classement[i].second.lectures,classement[i].second.ecritures,classement[i].second.redondantes);
+    }
+    return 0;
+}
+
+/*===============================================================================
+  FONCTION      : Rejouer
+  DESCRIPTION   : Rejoue une trace sur le modèle des registres, et la compare
+                  éventuellement à une trace de référence
+  PARAMETRES    : Trace, trace de référence (ou NULL)
+  RETOUR        : 0 si identiques (ou sans référence), 1 sinon
+===============================================================================*/
+static int Rejouer(const Trace &trace, const Trace *reference)
+{
+    std::map<uint32_t,uint32_t> modele, modele_reference;
+    std::vector<Acces> ecritures, ecritures_reference;
+    int resultat = 0;
+
+    for (size_t i = 0; i < trace.acces.size(); i++)
+    {
+        Appliquer_Acces(modele,trace.acces[i]);
+        if (trace.acces[i].ecriture) ecritures.push_back(trace.acces[i]);
+    }
+
+    printf("etat final des registres :\n");
+    for (std::map<uint32_t,uint32_t>::const_iterator it = modele.begin(); it != modele.end(); ++it)
+    {
+        const Description_Registre *description = Decrire_Registre(it->first);
+        if (description && description->type != REG_NORMAL) continue;
+        printf("  %-20s 0x%08X\n",Nom_Registre(it->first).c_str(),it->second);
+    }
+    if (reference == NULL) return 0;
+
+    for (size_t i = 0; i < reference->acces.size(); i++)
+    {
+        Appliquer_Acces(modele_reference,reference->acces[i]);
+        if (reference->acces[i].ecriture) ecritures_reference.push_back(reference->acces[i]);
+    }
+
+    // séquence des écritures
+    size_t nb = std::min(ecritures.size(),ecritures_reference.size());
+    for (size_t i = 0; i < nb; i++)
+    {
+        if (ecritures[i].adresse != ecritures_reference[i].adresse || ecritures[i].valeur != ecritures_reference[i].valeur)
+        {
+            printf("ecriture %zu differente : %s = 0x%08X (reference : %s = 0x%08X)\n",i,
+                   Nom_Registre(ecritures[i].adresse).c_str(),ecritures[i].valeur,
+                   Nom_Registre(ecritures_reference[i].adresse).c_str(),ecritures_reference[i].valeur);
+            resultat = 1;
+            break;
+        }
+    }
+    if (ecritures.size() != ecritures_reference.size())
+    {
+        printf("nombre d'ecritures : %zu (reference : %zu)\n",ecritures.size(),ecritures_reference.size());
+        resultat = 1;
+    }
+
+    // état final des registres de configuration
+    for (std::map<uint32_t,uint32_t>::const_iterator it = modele_reference.begin(); it != modele_reference.end(); ++it)
+    {
+        const Description_Registre *description = Decrire_Registre(it->first);
+        if (description && description->type != REG_NORMAL) continue;
+        if (modele.count(it->first) == 0 || modele[it->first] != it->second)
+        {
+            printf("etat final different : %s = 0x%08X (reference : 0x%08X)\n",Nom_Registre(it->first).c_str(),
+                   modele.count(it->first) ? modele[it->first] : 0,it->second);
+            resultat = 1;
+        }
+    }
+
+    printf(resultat ? "traces differentes\n" : "traces identiques\n");
+    return resultat;
+}
+
+int main(int argc, char **argv)
+{
+    Trace trace, reference;
+
+    if (argc < 3 || (strcmp(argv[1],"resume") != 0 && strcmp(argv[1],"rejouer") != 0))
+    {
+        fprintf(stderr,"utilisation : %s resume trace.bin\n"
+                       "              %s rejouer trace.bin [reference.bin]\n",argv[0],argv[0]);
+        return 2;
+    }
+    if (!Lire_Trace(argv[2],trace)) return 2;
+
+    if (strcmp(argv[1],"resume") == 0) return Resumer(trace);
+
+    if (argc > 3 && !Lire_Trace(argv[3],reference)) return 2;
+    return Rejouer(trace,argc > 3 ? &reference : NULL);
+}
@@ -0,0 +1,356 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Analyseur_Logique.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Analyseur logique embarqué : capture des GPIO et envoi de la trace compressée par UART
+ *  (voir Analyseur_Logique.h)
+ * =============================================================================================================================================
+ */
+
+#include "Analyseur_Logique.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Buffer circulaire : écrit sous interruption, vidé par Analyseur_Tache
+uint8 Tampon_Analyseur[ANALYSEUR_TAILLE_TAMPON];
+volatile uint32 analyseur_ecriture = 0;
+volatile uint32 analyseur_lecture = 0;
+
+// Capture en cours
+volatile bool analyseur_actif = false;
+Analyseur_Mode analyseur_mode = ANALYSEUR_PERIODIQUE;
+uint16 analyseur_masque = 0;
+uint8 analyseur_uart = UART0;
+
+// Etat lu en dernier, état et date du dernier enregistrement écrit
+uint16 analyseur_etat = 0;
+uint16 analyseur_etat_ecrit = 0;
+uint32 analyseur_temps_ecrit = 0;
+bool analyseur_perte = false;
+
+// Mode périodique : client du TIMER1, période (cycles), prochaine échéance, n° de l'échantillon suivant
+int8 client_timer_analyseur = -1;
+uint32 analyseur_periode = 0;
+uint32 analyseur_echeance = 0;
+volatile uint32 analyseur_echantillon = 0;
+
+volatile Analyseur_Statistiques Statistiques_Analyseur;
+
+// Accès aux registres selon le N° de l'UART
+#define REGISTRE_UART(n) (((n) == UART0) ? Registre_UART0 : Registre_UART1)
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Lire_Temps
+  DESCRIPTION   : Date courante de la capture
+  PARAMETRES    : rien
+  RETOUR        : Ticks (échantillons en mode périodique, cycles CPU en mode fronts)
+===============================================================================*/
+static inline uint32 ICACHE_RAM_ATTR Lire_Temps()
+{
+    return (analyseur_mode == ANALYSEUR_PERIODIQUE) ? analyseur_echantillon : Lire_Compteur_Cycles();
+}
+
+/*===============================================================================
+  FONCTION      : Ajouter_Enregistrement
+  DESCRIPTION   : Code un enregistrement dans le buffer circulaire
+  PARAMETRES    : - Date (ticks)
+                  - Enregistrement spécial (M = 1)
+                  - N° de la GPIO ou code de l'enregistrement spécial
+                  - Masque ou état (ANALYSEUR_CODE_XOR / ANALYSEUR_CODE_SYNCHRO)
+                  - Octets laissés libres (réserve pour l'enregistrement de fin)
+  RETOUR        : false si le buffer est plein
+===============================================================================*/
+static bool ICACHE_RAM_ATTR Ajouter_Enregistrement(uint32 temps, bool special, uint8 code, uint16 valeur, uint8 reserve)
+{
+    uint8 enregistrement[ANALYSEUR_TAILLE_MAX_ENREGISTREMENT];
+    uint8 taille = 1;
+    uint8 nb_delai = 0;
+
+    // Délai : octets de poids faible en premier, octets nuls de poids fort omis
+    for (uint32 delai = temps - analyseur_temps_ecrit; delai != 0; delai >>= 8)
+    {
+        enregistrement[taille++] = (uint8)delai;
+        nb_delai++;
+    }
+    enregistrement[0] = ((uint8)special << BIT_ANALYSEUR_MULTIPLE) | (nb_delai << BIT_ANALYSEUR_NB_DELAI) | code;
+    if (special && (code == ANALYSEUR_CODE_XOR || code == ANALYSEUR_CODE_SYNCHRO))
+    {
+        enregistrement[taille++] = (uint8)valeur;
+        enregistrement[taille++] = (uint8)(valeur >> 8);
+    }
+
+    uint32 remplissage = analyseur_ecriture - analyseur_lecture;
+    if (remplissage + taille + reserve > ANALYSEUR_TAILLE_TAMPON) return false;
+
+    for (uint8 i = 0; i < taille; i++)
+    {
+        Tampon_Analyseur[(analyseur_ecriture + i) & ANALYSEUR_MASQUE_TAMPON] = enregistrement[i];
+    }
+    analyseur_ecriture += taille;
+    analyseur_temps_ecrit = temps;
+
+    if (remplissage + taille > Statistiques_Analyseur.remplissage_max)
+    {
+        Statistiques_Analyseur.remplissage_max = remplissage + taille;
+    }
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Enregistrer_Etat
+  DESCRIPTION   : Enregistre l'état des GPIO s'il a changé depuis la lecture précédente
+  PARAMETRES    : Date (ticks), état des GPIO capturées
+  RETOUR        : rien
+===============================================================================*/
+static inline void ICACHE_RAM_ATTR Enregistrer_Etat(uint32 temps, uint16 etat)
+{
+    bool ecrit;
+
+    if (etat == analyseur_etat) return;
+    analyseur_etat = etat;
+
+    if (analyseur_perte)
+    {
+        // Des changements ont été perdus : état complet
+        ecrit = Ajouter_Enregistrement(temps,true,ANALYSEUR_CODE_SYNCHRO,etat,ANALYSEUR_TAILLE_RESERVE);
+    }
+    else
+    {
+        uint16 changements = etat ^ analyseur_etat_ecrit;
+        if ((changements & (changements - 1)) == 0)
+        {
+            uint8 gpio = 0;
+            while (!(changements & (1 << gpio))) gpio++;
+            ecrit = Ajouter_Enregistrement(temps,false,gpio,0,ANALYSEUR_TAILLE_RESERVE);
+        }
+        else
+        {
+            ecrit = Ajouter_Enregistrement(temps,true,ANALYSEUR_CODE_XOR,changements,ANALYSEUR_TAILLE_RESERVE);
+        }
+    }
+
+    if (ecrit)
+    {
+        analyseur_etat_ecrit = etat;
+        analyseur_perte = false;
+        Statistiques_Analyseur.nb_changements++;
+    }
+    else
+    {
+        analyseur_perte = true;
+        Statistiques_Analyseur.nb_perdus++;
+    }
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS ANALYSEUR LOGIQUE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Analyseur_Demarrer
+  DESCRIPTION   : Démarre une capture (l'en-tête du flux est placé dans le buffer)
+  PARAMETRES    : - Mode de capture
+                  - Masque des GPIO capturées (bit n : GPIOn, GPIO 0 à 15 configurées en entrée)
+                  - Fréquence d'échantillonnage (Hz, mode périodique uniquement)
+                  - N° de l'UART d'envoi (initialisée par l'application)
+  RETOUR        : false si une capture est en cours ou en cours d'envoi, ou si les paramètres sont invalides
+===============================================================================*/
+bool Analyseur_Demarrer(Analyseur_Mode mode, uint16 masque, uint32 frequence, uint8 UART)
+{
+    uint32 cycles_par_tick = 1;
+
+    if (analyseur_actif || analyseur_lecture != analyseur_ecriture) return false;
+    if (masque == 0 || (UART != UART0 && UART != UART1)) return false;
+
+    if (mode == ANALYSEUR_PERIODIQUE)
+    {
+        if (frequence == 0 || ESP8266_CLOCK_FREQ / frequence < ANALYSEUR_PERIODE_MIN) return false;
+        cycles_par_tick = ESP8266_CLOCK_FREQ / frequence;
+
+        if (client_timer_analyseur < 0)
+        {
+            init_Multiplexeur_TIMER1();
+            client_timer_analyseur = TIMER1_Mux_Ajouter_Client(Interruption_Analyseur_Timer,NULL);
+            if (client_timer_analyseur < 0) return false;
+        }
+    }
+
+    // Etape 1 : état initial
+    analyseur_mode = mode;
+    analyseur_masque = masque;
+    analyseur_uart = UART;
+    analyseur_periode = cycles_par_tick;
+    analyseur_echantillon = 0;
+    analyseur_perte = false;
+    analyseur_etat = REGISTRE_LIRE(Registre_GPIO->IN) & masque;
+    analyseur_etat_ecrit = analyseur_etat;
+    analyseur_temps_ecrit = Lire_Temps();
+
+    Statistiques_Analyseur.nb_echantillons = 0;
+    Statistiques_Analyseur.nb_changements = 0;
+    Statistiques_Analyseur.nb_perdus = 0;
+    Statistiques_Analyseur.nb_retards = 0;
+    Statistiques_Analyseur.octets_envoyes = 0;
+    Statistiques_Analyseur.remplissage_max = ANALYSEUR_TAILLE_ENTETE;
+
+    // Etape 2 : en-tête du flux
+    uint8 entete[ANALYSEUR_TAILLE_ENTETE] = {'A','L','G','1',(uint8)mode,0,(uint8)masque,(uint8)(masque >> 8),
+                                             (uint8)cycles_par_tick,(uint8)(cycles_par_tick >> 8),
+                                             (uint8)(cycles_par_tick >> 16),(uint8)(cycles_par_tick >> 24),
+                                             (uint8)analyseur_etat,(uint8)(analyseur_etat >> 8)};
+    analyseur_lecture = analyseur_ecriture = 0;
+    for (uint8 i = 0; i < ANALYSEUR_TAILLE_ENTETE; i++) Tampon_Analyseur[i] = entete[i];
+    analyseur_ecriture = ANALYSEUR_TAILLE_ENTETE;
+
+    // Etape 3 : démarrage de la source (échantillonnage ou interruptions des GPIO)
+    analyseur_actif = true;
+    if (mode == ANALYSEUR_PERIODIQUE)
+    {
+        analyseur_echeance = Lire_Compteur_Cycles() + analyseur_periode;
+        TIMER1_Mux_Programmer(client_timer_analyseur,analyseur_echeance);
+    }
+    else
+    {
+        for (uint8 gpio = 0; gpio < NB_GPIO_INTERRUPTION; gpio++)
+        {
+            if (masque & (1 << gpio)) GPIO_Attacher_Interruption(gpio,FRONT_DOUBLE,Interruption_Analyseur_GPIO);
+        }
+    }
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Analyseur_Arreter
+  DESCRIPTION   : Arrête la capture (l'enregistrement de fin est placé dans le buffer,
+                  Analyseur_Tache termine l'envoi)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Analyseur_Arreter()
+{
+    if (!analyseur_actif) return;
+
+    if (analyseur_mode == ANALYSEUR_PERIODIQUE)
+    {
+        TIMER1_Mux_Annuler(client_timer_analyseur);
+    }
+    else
+    {
+        for (uint8 gpio = 0; gpio < NB_GPIO_INTERRUPTION; gpio++)
+        {
+            if (analyseur_masque & (1 << gpio)) GPIO_Detacher_Interruption(gpio);
+        }
+    }
+
+    // La réserve laissée par les interruptions garantit la place de la synchronisation (état final inconnu
+    // du décodeur si les derniers changements ont été perdus) et de l'enregistrement de fin
+    ETS_INTR_LOCK();
+    analyseur_actif = false;
+    uint32 temps = Lire_Temps();
+    if (analyseur_perte)
+    {
+        Ajouter_Enregistrement(temps,true,ANALYSEUR_CODE_SYNCHRO,analyseur_etat,ANALYSEUR_TAILLE_MAX_ENREGISTREMENT);
+        analyseur_perte = false;
+    }
+    Ajouter_Enregistrement(temps,true,ANALYSEUR_CODE_FIN,0,0);
+    ETS_INTR_UNLOCK();
+}
+
+/*===============================================================================
+  FONCTION      : Analyseur_Tache
+  DESCRIPTION   : Envoie le contenu du buffer dans la fifo TX de l'UART (sans attente)
+                  (tâche de fond : Scheduler_Set_Tache_Fond, ou boucle principale)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des octets à envoyer ou si une capture est en cours
+===============================================================================*/
+bool Analyseur_Tache()
+{
+    UART_Struct *uart = REGISTRE_UART(analyseur_uart);
+
+    if (analyseur_lecture != analyseur_ecriture)
+    {
+        uint8 nb_fifo = (REGISTRE_LIRE(uart->STATUS) >> BIT_UART_TXFIFO_CNT) & 0xFF;
+        while (nb_fifo < UART_TAILLE_FIFO && analyseur_lecture != analyseur_ecriture)
+        {
+            REGISTRE_ECRIRE(uart->FIFO,Tampon_Analyseur[analyseur_lecture & ANALYSEUR_MASQUE_TAMPON]);
+            analyseur_lecture++;
+            nb_fifo++;
+            Statistiques_Analyseur.octets_envoyes++;
+        }
+    }
+
+    // Signal immobile : avance du temps avant que le délai ne déborde
+    if (analyseur_actif)
+    {
+        ETS_INTR_LOCK();
+        uint32 temps = Lire_Temps();
+        if (analyseur_actif && temps - analyseur_temps_ecrit >= ANALYSEUR_TICKS_SANS_CHANGEMENT)
+        {
+            Ajouter_Enregistrement(temps,true,ANALYSEUR_CODE_TEMPS,0,ANALYSEUR_TAILLE_RESERVE);
+        }
+        ETS_INTR_UNLOCK();
+    }
+
+    return analyseur_actif || analyseur_lecture != analyseur_ecriture;
+}
+
+/*===============================================================================
+  FONCTION      : Analyseur_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la capture en cours (ou de la dernière)
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Analyseur_Statistiques *Analyseur_Lire_Statistiques()
+{
+    return (const Analyseur_Statistiques *)&Statistiques_Analyseur;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Analyseur_Timer
+  DESCRIPTION   : Mode périodique : lit un échantillon et programme le suivant
+  PARAMETRES    : argument (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Analyseur_Timer(void *argument)
+{
+    if (!analyseur_actif) return;
+
+    Enregistrer_Etat(analyseur_echantillon,REGISTRE_LIRE(Registre_GPIO->IN) & analyseur_masque);
+    Statistiques_Analyseur.nb_echantillons++;
+    analyseur_echantillon++;
+    analyseur_echeance += analyseur_periode;
+
+    // Interruption retardée : les échantillons manqués sont sautés, les dates restent exactes
+    int32 retard = (int32)(Lire_Compteur_Cycles() - analyseur_echeance);
+    if (retard >= 0)
+    {
+        uint32 manques = (uint32)retard / analyseur_periode + 1;
+        analyseur_echantillon += manques;
+        analyseur_echeance += manques * analyseur_periode;
+        Statistiques_Analyseur.nb_retards += manques;
+    }
+    TIMER1_Mux_Programmer(client_timer_analyseur,analyseur_echeance);
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Analyseur_GPIO
+  DESCRIPTION   : Mode fronts : enregistre l'état des GPIO lu par l'interruption
+  PARAMETRES    : N° de la GPIO, état lu
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Analyseur_GPIO(uint8 GPIO, uint8 etat)
+{
+    if (!analyseur_actif) return;
+
+    Enregistrer_Etat(Lire_Compteur_Cycles(),GPIO_Etats_Interruption() & analyseur_masque);
+}
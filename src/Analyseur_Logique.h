@@ -0,0 +1,161 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Analyseur_Logique.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Analyseur logique embarqué : capture des GPIO 0 à 15 (registre IN) et envoi de la trace compressée par UART
+ *
+ *  Deux modes de capture :
+ *    - ANALYSEUR_PERIODIQUE : le registre IN est échantillonné à fréquence fixe (client du Multiplexeur_TIMER1),
+ *                             le temps est compté en échantillons
+ *    - ANALYSEUR_FRONTS     : interruption sur les deux fronts des GPIO capturées, datée par le compteur
+ *                             de cycles du CPU (80 MHz, le TIMER2 du SDK n'est pas utilisé)
+ *
+ *  Seuls les changements d'état sont enregistrés (codage par plages) : un signal immobile ne coûte rien,
+ *  quelle que soit la fréquence d'échantillonnage. Les enregistrements sont écrits sous interruption dans
+ *  un buffer circulaire, que Analyseur_Tache vide dans la fifo TX de l'UART (l'UART doit être initialisée
+ *  par l'application, à la vitesse la plus élevée possible).
+ *
+ *  Si le buffer est plein, les changements sont perdus : l'enregistrement suivant est une synchronisation
+ *  (état complet, également écrite en fin de capture), les dates restent exactes. En mode périodique, un échantillon manqué (interruption retardée)
+ *  est compté dans nb_retards, sans décaler les dates suivantes.
+ *
+ *  Débit maximal : chaque changement coûte 1 à 7 octets (2 octets pour un front isolé à moins de 256 ticks
+ *  du précédent). Le débit moyen des changements ne doit pas dépasser le débit de l'UART (92 ko/s à 921600 bauds),
+ *  le buffer absorbe les rafales :
+ *    - mode périodique : environ 2 octets par changement (délais courts comptés en échantillons)
+ *    - mode fronts     : environ 3 octets par changement (délais en cycles), soit 30000 changements/s à 921600 bauds
+ *  La fréquence d'échantillonnage est limitée par le coût de l'interruption du TIMER1 : surveiller nb_retards.
+ *
+ *  Format du flux (little endian) :
+ *      en-tête (14 octets) : "ALG1", uint8 mode, uint8 réservé (0), uint16 masque des GPIO,
+ *                            uint32 cycles CPU par tick (1 en mode fronts), uint16 état initial
+ *      enregistrements     : octet de tête [M][D D D][G G G G], puis D octets de délai (ticks depuis
+ *                            l'enregistrement précédent), puis :
+ *          M = 0 : une seule GPIO (G) a changé d'état
+ *          M = 1 : G = ANALYSEUR_CODE_XOR      uint16 masque des GPIO qui ont changé
+ *                  G = ANALYSEUR_CODE_SYNCHRO  uint16 état complet (des changements ont été perdus avant)
+ *                  G = ANALYSEUR_CODE_TEMPS    rien (avance du temps seule, évite le débordement des délais)
+ *                  G = ANALYSEUR_CODE_FIN      rien (fin de la capture)
+ *
+ *  L'outil extras/analyseur_logique (à compiler sur PC) convertit le flux capturé en fichier VCD (GTKWave, PulseView).
+ * =============================================================================================================================================
+ */
+
+#ifndef __ANALYSEUR_LOGIQUE_H__
+#define __ANALYSEUR_LOGIQUE_H__
+
+// Dépendance(s)
+#include "GPIO_esp8266.h"
+#include "UART_esp8266.h"
+#include "Multiplexeur_TIMER1.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Taille du buffer circulaire (octets, puissance de 2)
+#ifndef ANALYSEUR_TAILLE_TAMPON
+  #define ANALYSEUR_TAILLE_TAMPON 4096
+#endif
+#define ANALYSEUR_MASQUE_TAMPON (ANALYSEUR_TAILLE_TAMPON - 1)
+
+// Période minimale d'échantillonnage (cycles CPU : 200 kHz)
+#define ANALYSEUR_PERIODE_MIN 400
+
+// Un enregistrement "temps" est ajouté lorsqu'aucun changement n'a eu lieu depuis ce nombre de ticks
+#define ANALYSEUR_TICKS_SANS_CHANGEMENT 0x40000000
+
+// Octet de tête d'un enregistrement
+#define BIT_ANALYSEUR_MULTIPLE 7 // [7] changement multiple ou enregistrement spécial
+#define BIT_ANALYSEUR_NB_DELAI 4 // [6:4] nombre d'octets du délai (0 à 4)
+#define BIT_ANALYSEUR_GPIO     0 // [3:0] GPIO qui a changé, ou code de l'enregistrement spécial
+
+// Codes des enregistrements spéciaux
+#define ANALYSEUR_CODE_XOR     0
+#define ANALYSEUR_CODE_SYNCHRO 1
+#define ANALYSEUR_CODE_TEMPS   2
+#define ANALYSEUR_CODE_FIN     3
+
+// Taille de l'en-tête du flux et d'un enregistrement
+#define ANALYSEUR_TAILLE_ENTETE 14
+#define ANALYSEUR_TAILLE_MAX_ENREGISTREMENT 7
+
+// Réserve laissée libre par les interruptions : synchronisation et enregistrement de fin de Analyseur_Arreter
+#define ANALYSEUR_TAILLE_RESERVE (2 * ANALYSEUR_TAILLE_MAX_ENREGISTREMENT)
+
+// Modes de capture
+typedef enum {ANALYSEUR_PERIODIQUE,ANALYSEUR_FRONTS} Analyseur_Mode;
+
+// Statistiques
+typedef struct{
+  uint32 nb_echantillons;      // mode périodique : échantillons lus
+  uint32 nb_changements;       // changements d'état enregistrés
+  uint32 nb_perdus;            // changements perdus (buffer plein)
+  uint32 nb_retards;           // mode périodique : échantillons manqués (interruption retardée)
+  uint32 octets_envoyes;
+  uint16 remplissage_max;      // remplissage maximal du buffer (octets)
+} Analyseur_Statistiques;
+
+// ##########################################################################################################################
+//                                      FONCTIONS ANALYSEUR LOGIQUE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Analyseur_Demarrer
+  DESCRIPTION   : Démarre une capture (l'en-tête du flux est placé dans le buffer)
+  PARAMETRES    : - Mode de capture
+                  - Masque des GPIO capturées (bit n : GPIOn, GPIO 0 à 15 configurées en entrée)
+                  - Fréquence d'échantillonnage (Hz, mode périodique uniquement)
+                  - N° de l'UART d'envoi (initialisée par l'application)
+  RETOUR        : false si une capture est en cours ou en cours d'envoi, ou si les paramètres sont invalides
+===============================================================================*/
+bool Analyseur_Demarrer(Analyseur_Mode mode, uint16 masque, uint32 frequence, uint8 UART);
+
+/*===============================================================================
+  FONCTION      : Analyseur_Arreter
+  DESCRIPTION   : Arrête la capture (l'enregistrement de fin est placé dans le buffer,
+                  Analyseur_Tache termine l'envoi)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Analyseur_Arreter();
+
+/*===============================================================================
+  FONCTION      : Analyseur_Tache
+  DESCRIPTION   : Envoie le contenu du buffer dans la fifo TX de l'UART (sans attente)
+                  (tâche de fond : Scheduler_Set_Tache_Fond, ou boucle principale)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des octets à envoyer ou si une capture est en cours
+===============================================================================*/
+bool Analyseur_Tache();
+
+/*===============================================================================
+  FONCTION      : Analyseur_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la capture en cours (ou de la dernière)
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Analyseur_Statistiques *Analyseur_Lire_Statistiques();
+
+/*===============================================================================
+  FONCTION      : Interruption_Analyseur_Timer
+  DESCRIPTION   : Mode périodique : lit un échantillon et programme le suivant
+  PARAMETRES    : argument (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Analyseur_Timer(void *argument);
+
+/*===============================================================================
+  FONCTION      : Interruption_Analyseur_GPIO
+  DESCRIPTION   : Mode fronts : enregistre l'état des GPIO lu par l'interruption
+  PARAMETRES    : N° de la GPIO, état lu
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Analyseur_GPIO(uint8 GPIO, uint8 etat);
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,308 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Automate.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Automates à états hiérarchiques : distribution des évènements (files, GPIO, temporisations)
+ *  (voir Automate.h)
+ * =============================================================================================================================================
+ */
+
+#include "Automate.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Evènement en file
+typedef struct{
+  uint8 automate;
+  uint8 evenement;
+} Automate_Evenement;
+
+// File à un seul producteur
+typedef struct{
+  Automate_Evenement evenements[AUTOMATE_TAILLE_FILE];
+  volatile uint8 ecriture;
+  volatile uint8 lecture;
+} Automate_File;
+
+// Liaison d'une GPIO
+typedef struct{
+  uint8 automate;
+  uint8 evenement[2];          // [etat lu] : front descendant, front montant
+} Automate_GPIO;
+
+// Temporisation
+typedef struct{
+  uint32 echeance;
+  uint8 automate;
+  uint8 evenement;
+  bool armee;
+} Automate_Temporisation;
+
+// Automates enregistrés
+Automate_Distribution Distributions_Automates[AUTOMATE_NB_MAX];
+void *Automates[AUTOMATE_NB_MAX];
+uint8 nb_automates = 0;
+
+// Files : alimentée sous interruption / hors interruption
+Automate_File File_Interruptions;
+Automate_File File_Taches;
+
+Automate_GPIO GPIO_Automates[NB_GPIO_INTERRUPTION];
+
+// Temporisations (prochaine_echeance n'a de sens que si nb_temporisations > 0)
+Automate_Temporisation Temporisations[AUTOMATE_NB_TEMPORISATIONS];
+uint8 nb_temporisations = 0;
+uint32 automate_millis = 0;
+uint32 prochaine_echeance = 0;
+
+volatile Automate_Statistiques Statistiques_Automates;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Ajouter_File / Retirer_File
+  DESCRIPTION   : Ajoute / retire un évènement d'une file (un producteur, un consommateur)
+  PARAMETRES    : File, évènement
+  RETOUR        : false si la file est pleine / vide
+===============================================================================*/
+static inline bool ICACHE_RAM_ATTR Ajouter_File(Automate_File *file, uint8 automate, uint8 evenement)
+{
+    if ((uint8)(file->ecriture - file->lecture) >= AUTOMATE_TAILLE_FILE)
+    {
+        Statistiques_Automates.nb_perdus++;
+        return false;
+    }
+    file->evenements[file->ecriture & AUTOMATE_MASQUE_FILE].automate = automate;
+    file->evenements[file->ecriture & AUTOMATE_MASQUE_FILE].evenement = evenement;
+    file->ecriture++;
+    return true;
+}
+
+static inline bool Retirer_File(Automate_File *file, Automate_Evenement *evenement)
+{
+    if (file->lecture == file->ecriture) return false;
+    *evenement = file->evenements[file->lecture & AUTOMATE_MASQUE_FILE];
+    file->lecture++;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Calculer_Echeance
+  DESCRIPTION   : Recalcule la prochaine échéance des temporisations armées
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Calculer_Echeance()
+{
+    bool premiere = true;
+
+    for (uint8 i = 0; i < AUTOMATE_NB_TEMPORISATIONS; i++)
+    {
+        if (!Temporisations[i].armee) continue;
+        if (premiere || (int32)(Temporisations[i].echeance - prochaine_echeance) < 0)
+        {
+            prochaine_echeance = Temporisations[i].echeance;
+            premiere = false;
+        }
+    }
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS DISTRIBUTION DES EVENEMENTS
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Automate_Enregistrer
+  DESCRIPTION   : Enregistre un automate auprès de la distribution d'évènements
+  PARAMETRES    : Fonction de distribution, automate
+  RETOUR        : N° de l'automate (évènements, GPIO, temporisations), -1 si la table est pleine
+===============================================================================*/
+int8 Automate_Enregistrer(Automate_Distribution distribution, void *automate)
+{
+    if (nb_automates >= AUTOMATE_NB_MAX) return -1;
+
+    Distributions_Automates[nb_automates] = distribution;
+    Automates[nb_automates] = automate;
+    return nb_automates++;
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Poster
+  DESCRIPTION   : Ajoute un évènement à la file (hors interruption : boucle principale, tâches, actions)
+  PARAMETRES    : N° de l'automate, évènement
+  RETOUR        : false si la file est pleine (évènement perdu)
+===============================================================================*/
+bool Automate_Poster(uint8 automate, uint8 evenement)
+{
+    return Ajouter_File(&File_Taches,automate,evenement);
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Poster_Interruption
+  DESCRIPTION   : Ajoute un évènement à la file des interruptions (GPIO, UART, TIMER ;
+                  pas depuis une interruption NMI)
+  PARAMETRES    : N° de l'automate, évènement
+  RETOUR        : false si la file est pleine (évènement perdu)
+===============================================================================*/
+bool ICACHE_RAM_ATTR Automate_Poster_Interruption(uint8 automate, uint8 evenement)
+{
+    return Ajouter_File(&File_Interruptions,automate,evenement);
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Lier_GPIO
+  DESCRIPTION   : Poste un évènement à chaque front d'une GPIO (interruption sur le ou les fronts utiles)
+  PARAMETRES    : N° de la GPIO (0 à 15), N° de l'automate,
+                  évènements des fronts montant et descendant (AUTOMATE_AUCUN : front ignoré)
+  RETOUR        : false si les paramètres sont invalides
+===============================================================================*/
+bool Automate_Lier_GPIO(uint8 gpio, uint8 automate, uint8 evenement_montant, uint8 evenement_descendant)
+{
+    if (gpio >= NB_GPIO_INTERRUPTION || automate >= nb_automates) return false;
+    if (evenement_montant == AUTOMATE_AUCUN && evenement_descendant == AUTOMATE_AUCUN) return false;
+
+    GPIO_Automates[gpio].automate = automate;
+    GPIO_Automates[gpio].evenement[0] = evenement_descendant;
+    GPIO_Automates[gpio].evenement[1] = evenement_montant;
+
+    GPIO_Interrupt type = (evenement_descendant == AUTOMATE_AUCUN) ? FRONT_MONTANT :
+                          (evenement_montant == AUTOMATE_AUCUN) ? FRONT_DESCENDANT : FRONT_DOUBLE;
+    GPIO_Attacher_Interruption(gpio,type,Interruption_Automate_GPIO);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Armer
+  DESCRIPTION   : Poste un évènement après un délai (réarme la temporisation si elle existe déjà)
+  PARAMETRES    : N° de l'automate, évènement, délai (ms)
+  RETOUR        : false si toutes les temporisations sont utilisées
+===============================================================================*/
+bool Automate_Armer(uint8 automate, uint8 evenement, uint32 delai_ms)
+{
+    int8 libre = -1;
+
+    for (uint8 i = 0; i < AUTOMATE_NB_TEMPORISATIONS; i++)
+    {
+        Automate_Temporisation *tempo = &Temporisations[i];
+        if (tempo->armee && tempo->automate == automate && tempo->evenement == evenement)
+        {
+            libre = i;
+            break;
+        }
+        if (!tempo->armee && libre < 0) libre = i;
+    }
+    if (libre < 0) return false;
+
+    Automate_Temporisation *tempo = &Temporisations[libre];
+    if (!tempo->armee) nb_temporisations++;
+    tempo->automate = automate;
+    tempo->evenement = evenement;
+    tempo->echeance = automate_millis + delai_ms;
+    tempo->armee = true;
+    Calculer_Echeance();
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Desarmer
+  DESCRIPTION   : Annule une temporisation (sans effet si elle n'est pas armée)
+  PARAMETRES    : N° de l'automate, évènement
+  RETOUR        : rien
+===============================================================================*/
+void Automate_Desarmer(uint8 automate, uint8 evenement)
+{
+    for (uint8 i = 0; i < AUTOMATE_NB_TEMPORISATIONS; i++)
+    {
+        Automate_Temporisation *tempo = &Temporisations[i];
+        if (tempo->armee && tempo->automate == automate && tempo->evenement == evenement)
+        {
+            tempo->armee = false;
+            nb_temporisations--;
+            Calculer_Echeance();
+            return;
+        }
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Tache_1ms
+  DESCRIPTION   : Poste les évènements des temporisations échues
+                  (une comparaison lorsqu'aucune n'est échue)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Automate_Tache_1ms()
+{
+    automate_millis++;
+    if (nb_temporisations == 0 || (int32)(automate_millis - prochaine_echeance) < 0) return;
+
+    for (uint8 i = 0; i < AUTOMATE_NB_TEMPORISATIONS; i++)
+    {
+        Automate_Temporisation *tempo = &Temporisations[i];
+        if (tempo->armee && (int32)(automate_millis - tempo->echeance) >= 0)
+        {
+            tempo->armee = false;
+            nb_temporisations--;
+            Ajouter_File(&File_Taches,tempo->automate,tempo->evenement);
+        }
+    }
+    Calculer_Echeance();
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Executer
+  DESCRIPTION   : Distribue un évènement en attente (file des interruptions en premier)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des évènements en attente
+===============================================================================*/
+bool Automate_Executer()
+{
+    Automate_Evenement evenement;
+
+    if (Retirer_File(&File_Interruptions,&evenement) || Retirer_File(&File_Taches,&evenement))
+    {
+        if (evenement.automate < nb_automates)
+        {
+            Statistiques_Automates.nb_evenements++;
+            if (!Distributions_Automates[evenement.automate](Automates[evenement.automate],evenement.evenement))
+            {
+                Statistiques_Automates.nb_ignores++;
+            }
+        }
+    }
+    return File_Interruptions.lecture != File_Interruptions.ecriture || File_Taches.lecture != File_Taches.ecriture;
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la distribution des évènements
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Automate_Statistiques *Automate_Lire_Statistiques()
+{
+    return (const Automate_Statistiques *)&Statistiques_Automates;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Automate_GPIO
+  DESCRIPTION   : Interruption d'une GPIO liée : poste l'évènement du front
+  PARAMETRES    : N° de la GPIO, état lu
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Automate_GPIO(uint8 GPIO, uint8 etat)
+{
+    uint8 evenement = GPIO_Automates[GPIO].evenement[etat ? 1 : 0];
+    if (evenement != AUTOMATE_AUCUN)
+    {
+        Automate_Poster_Interruption(GPIO_Automates[GPIO].automate,evenement);
+    }
+}
@@ -0,0 +1,467 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Automate.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Automates à états hiérarchiques, pilotés par évènements
+ *
+ *  Au lieu de réévaluer un "switch" imbriqué toutes les millisecondes, l'automate ne s'exécute que lorsqu'un
+ *  évènement arrive (front d'une GPIO, trame UART, temporisation échue...) :
+ *  - les états et les transitions sont décrits par deux tableaux constants (constexpr) ;
+ *    un état peut avoir un parent (hiérarchie) et un sous-état initial, une fonction d'entrée et de sortie
+ *  - à la compilation, les tableaux sont vérifiés (static_assert) et transformés en une table
+ *    [état][évènement] -> transition, héritage des transitions des parents compris : la recherche
+ *    de la transition est une simple lecture de table, quelle que soit la profondeur de l'état
+ *  - transition "externe" : sortie des états jusqu'à l'ancêtre commun (précalculé), action, entrée
+ *    des états jusqu'à la cible puis de ses sous-états initiaux ; cible AUTOMATE_INTERNE : action seule
+ *  - une garde refusée passe à la transition suivante du même état pour cet évènement, puis à celle du parent
+ *    (chaîne précalculée)
+ *  - aucune allocation : l'automate en RAM tient en un état courant et un pointeur de contexte
+ *
+ *  Distribution des évènements (Automate.cpp) :
+ *  - deux files : une alimentée sous interruption (Automate_Poster_Interruption, GPIO liées par Automate_Lier_GPIO,
+ *    fonctions d'interruption UART), une alimentée hors interruption (Automate_Poster, actions des automates)
+ *    -> chaque file n'a qu'un producteur : aucun masquage des interruptions
+ *  - temporisations : Automate_Armer poste un évènement après un délai ; Automate_Tache_1ms (Fonction_Task_1ms)
+ *    ne compare qu'une échéance lorsque rien n'est échu
+ *  - Automate_Executer (boucle principale ou Scheduler_Set_Tache_Fond) distribue un évènement par appel
+ *
+ *  Exemple :
+ *      enum {PORTE_FERMEE, PORTE_OUVERTE, OUVERTE_ATTENTE, OUVERTE_BLOQUEE};   // états
+ *      enum {EVT_BOUTON, EVT_OBSTACLE, EVT_TEMPO, NB_EVT_PORTE};               // évènements
+ *      constexpr Automate_Etat Etats_Porte[] = {
+ *          {AUTOMATE_AUCUN, AUTOMATE_AUCUN,  Fermer, NULL},                       // PORTE_FERMEE
+ *          {AUTOMATE_AUCUN, OUVERTE_ATTENTE, Ouvrir, NULL},                       // PORTE_OUVERTE
+ *          {PORTE_OUVERTE,  AUTOMATE_AUCUN,  Armer_Tempo, NULL},                  // OUVERTE_ATTENTE
+ *          {PORTE_OUVERTE,  AUTOMATE_AUCUN,  NULL, NULL}};                        // OUVERTE_BLOQUEE
+ *      constexpr Automate_Transition Transitions_Porte[] = {
+ *          {PORTE_FERMEE,    EVT_BOUTON,   PORTE_OUVERTE,   NULL, NULL},
+ *          {OUVERTE_ATTENTE, EVT_TEMPO,    PORTE_FERMEE,    NULL, NULL},
+ *          {PORTE_OUVERTE,   EVT_OBSTACLE, OUVERTE_BLOQUEE, NULL, NULL},          // hérité par les sous-états
+ *          {OUVERTE_BLOQUEE, EVT_BOUTON,   OUVERTE_ATTENTE, Obstacle_Libre, NULL}};
+ *      typedef AUTOMATE_DEFINITION(Etats_Porte,Transitions_Porte,NB_EVT_PORTE) Def_Porte;
+ *      Automate<Def_Porte> porte;
+ *      Automate_Demarrer(&porte,PORTE_FERMEE,&contexte);
+ *      int8 n = Automate_Enregistrer(&porte);  Automate_Lier_GPIO(GPIO4,n,EVT_BOUTON,AUTOMATE_AUCUN);
+ *
+ *  /!\ un parent doit être déclaré avant ses enfants (vérifié à la compilation)
+ * =============================================================================================================================================
+ */
+
+#ifndef __AUTOMATE_H__
+#define __AUTOMATE_H__
+
+// Dépendance(s)
+#include "GPIO_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Etat, évènement ou transition absent (pas de parent, pas de sous-état initial, pas de transition)
+#define AUTOMATE_AUCUN 0xFF
+
+// Cible d'une transition interne (action seule : ni sortie, ni entrée)
+#define AUTOMATE_INTERNE 0xFE
+
+// Profondeur maximale de la hiérarchie
+#define AUTOMATE_PROFONDEUR_MAX 8
+
+// Taille maximale de la table [état][évènement] (générée à la compilation)
+#define AUTOMATE_NB_CASES_MAX 512
+
+// Nombre d'automates enregistrés
+#define AUTOMATE_NB_MAX 8
+
+// Files d'évènements (puissances de 2)
+#define AUTOMATE_TAILLE_FILE 32
+#define AUTOMATE_MASQUE_FILE (AUTOMATE_TAILLE_FILE - 1)
+
+// Nombre de temporisations armées simultanément
+#define AUTOMATE_NB_TEMPORISATIONS 8
+
+// Nombre d'éléments d'un tableau constant
+#define AUTOMATE_NB(tableau) ((uint8)(sizeof(tableau) / sizeof((tableau)[0])))
+
+// Fonctions de l'application (contexte donné à Automate_Demarrer)
+typedef void (*Automate_Action)(void *contexte);
+typedef bool (*Automate_Garde)(void *contexte);
+
+// Description d'un état (indice dans le tableau des états = numéro de l'état)
+typedef struct{
+  uint8 parent;                // AUTOMATE_AUCUN : état de premier niveau
+  uint8 initial;               // sous-état entré après l'état (AUTOMATE_AUCUN : état feuille)
+  Automate_Action entree;      // NULL si aucune
+  Automate_Action sortie;
+} Automate_Etat;
+
+// Description d'une transition (les transitions d'un même état et d'un même évènement sont essayées dans l'ordre)
+typedef struct{
+  uint8 source;
+  uint8 evenement;
+  uint8 cible;                 // AUTOMATE_INTERNE : transition interne
+  Automate_Garde garde;        // NULL : toujours franchie
+  Automate_Action action;
+} Automate_Transition;
+
+// Distribution d'un évènement à un automate enregistré
+typedef bool (*Automate_Distribution)(void *automate, uint8 evenement);
+
+// Statistiques
+typedef struct{
+  uint32 nb_evenements;        // évènements distribués
+  uint32 nb_ignores;           // évènements sans transition dans l'état courant
+  uint32 nb_perdus;            // évènements perdus (file pleine)
+} Automate_Statistiques;
+
+// ##########################################################################################################################
+//                                      TABLES GENEREES A LA COMPILATION
+// ##########################################################################################################################
+
+// Suite d'indices 0..N-1 (expansion des tables)
+template <uint16... I> struct Automate_Indices{};
+template <uint16 N, uint16... I> struct Automate_Suite : Automate_Suite<N - 1, N - 1, I...>{};
+template <uint16... I> struct Automate_Suite<0, I...>{ typedef Automate_Indices<I...> type; };
+
+// Définition d'un automate : fonctions évaluées à la compilation sur les tableaux d'états et de transitions
+template <const Automate_Etat *ETATS, uint8 NB_ETATS, const Automate_Transition *TRANSITIONS, uint8 NB_TRANSITIONS, uint8 NB_EVENEMENTS>
+struct Automate_Definition{
+  static const uint8 nb_etats = NB_ETATS;
+  static const uint8 nb_transitions = NB_TRANSITIONS;
+  static const uint8 nb_evenements = NB_EVENEMENTS;
+
+  static constexpr const Automate_Etat *Etats() { return ETATS; }
+  static constexpr const Automate_Transition *Transitions() { return TRANSITIONS; }
+
+  // "ancetre" est l'état "etat" ou l'un de ses parents
+  static constexpr bool Ancetre(uint8 ancetre, uint8 etat)
+  {
+    return etat != AUTOMATE_AUCUN && (etat == ancetre || Ancetre(ancetre,ETATS[etat].parent));
+  }
+
+  // Plus proche ancêtre commun (AUTOMATE_AUCUN : racine)
+  static constexpr uint8 Commun(uint8 a, uint8 b)
+  {
+    return (a == AUTOMATE_AUCUN || Ancetre(a,b)) ? a : Commun(ETATS[a].parent,b);
+  }
+
+  static constexpr uint8 Profondeur(uint8 etat)
+  {
+    return (etat == AUTOMATE_AUCUN) ? 0 : 1 + Profondeur(ETATS[etat].parent);
+  }
+
+  // Première transition de "source" pour "evenement", à partir de la transition "debut"
+  static constexpr uint8 Chercher_Local(uint8 source, uint8 evenement, uint8 debut)
+  {
+    return (debut >= NB_TRANSITIONS) ? AUTOMATE_AUCUN :
+           (TRANSITIONS[debut].source == source && TRANSITIONS[debut].evenement == evenement) ? debut :
+           Chercher_Local(source,evenement,debut + 1);
+  }
+
+  // Transition d'un état pour un évènement, héritée des parents
+  static constexpr uint8 Chercher(uint8 etat, uint8 evenement)
+  {
+    return (etat == AUTOMATE_AUCUN) ? AUTOMATE_AUCUN :
+           (Chercher_Local(etat,evenement,0) != AUTOMATE_AUCUN) ? Chercher_Local(etat,evenement,0) :
+           Chercher(ETATS[etat].parent,evenement);
+  }
+
+  // Case de la table [état][évènement]
+  static constexpr uint8 Case(uint16 index)
+  {
+    return Chercher(index / NB_EVENEMENTS,index % NB_EVENEMENTS);
+  }
+
+  // Transition essayée lorsque la garde de "transition" est refusée
+  static constexpr uint8 Repli(uint8 transition)
+  {
+    return (Chercher_Local(TRANSITIONS[transition].source,TRANSITIONS[transition].evenement,transition + 1) != AUTOMATE_AUCUN) ?
+           Chercher_Local(TRANSITIONS[transition].source,TRANSITIONS[transition].evenement,transition + 1) :
+           Chercher(ETATS[TRANSITIONS[transition].source].parent,TRANSITIONS[transition].evenement);
+  }
+
+  // Etat conservé par une transition externe (sorties et entrées s'arrêtent à lui) :
+  // ancêtre commun de la source et de la cible, parent de la source pour une transition vers elle-même
+  static constexpr uint8 Domaine(uint8 transition)
+  {
+    return (TRANSITIONS[transition].cible == AUTOMATE_INTERNE) ? AUTOMATE_AUCUN :
+           (TRANSITIONS[transition].source == TRANSITIONS[transition].cible) ? ETATS[TRANSITIONS[transition].source].parent :
+           Commun(TRANSITIONS[transition].source,TRANSITIONS[transition].cible);
+  }
+
+  // Vérifications : parent déclaré avant l'enfant, sous-état initial enfant direct, profondeur bornée
+  static constexpr bool Etats_Valides(uint8 etat)
+  {
+    return etat >= NB_ETATS ||
+           ((ETATS[etat].parent == AUTOMATE_AUCUN || ETATS[etat].parent < etat) &&
+            (ETATS[etat].initial == AUTOMATE_AUCUN ||
+             (ETATS[etat].initial < NB_ETATS && ETATS[etat].initial > etat && ETATS[ETATS[etat].initial].parent == etat)) &&
+            Profondeur(etat) <= AUTOMATE_PROFONDEUR_MAX &&
+            Etats_Valides(etat + 1));
+  }
+
+  static constexpr bool Transitions_Valides(uint8 transition)
+  {
+    return transition >= NB_TRANSITIONS ||
+           (TRANSITIONS[transition].source < NB_ETATS && TRANSITIONS[transition].evenement < NB_EVENEMENTS &&
+            (TRANSITIONS[transition].cible < NB_ETATS || TRANSITIONS[transition].cible == AUTOMATE_INTERNE) &&
+            Transitions_Valides(transition + 1));
+  }
+};
+
+// Définition d'un automate à partir de ses tableaux
+#define AUTOMATE_DEFINITION(etats,transitions,nb_evenements) \
+  Automate_Definition<etats,AUTOMATE_NB(etats),transitions,AUTOMATE_NB(transitions),nb_evenements>
+
+// Table [état][évènement] -> transition
+template <typename DEFINITION, typename INDICES> struct Automate_Table_Cases;
+template <typename DEFINITION, uint16... I> struct Automate_Table_Cases<DEFINITION,Automate_Indices<I...> >{
+  static constexpr uint8 table[sizeof...(I)] = {DEFINITION::Case(I)...};
+};
+template <typename DEFINITION, uint16... I>
+constexpr uint8 Automate_Table_Cases<DEFINITION,Automate_Indices<I...> >::table[sizeof...(I)];
+
+// Tables par transition : repli de garde et domaine
+template <typename DEFINITION, typename INDICES> struct Automate_Table_Transitions;
+template <typename DEFINITION, uint16... I> struct Automate_Table_Transitions<DEFINITION,Automate_Indices<I...> >{
+  static constexpr uint8 repli[sizeof...(I)] = {DEFINITION::Repli(I)...};
+  static constexpr uint8 domaine[sizeof...(I)] = {DEFINITION::Domaine(I)...};
+};
+template <typename DEFINITION, uint16... I>
+constexpr uint8 Automate_Table_Transitions<DEFINITION,Automate_Indices<I...> >::repli[sizeof...(I)];
+template <typename DEFINITION, uint16... I>
+constexpr uint8 Automate_Table_Transitions<DEFINITION,Automate_Indices<I...> >::domaine[sizeof...(I)];
+
+// Automate en RAM
+template <typename DEFINITION> struct Automate{
+  static_assert(DEFINITION::nb_etats >= 1 && DEFINITION::nb_etats < AUTOMATE_INTERNE, "nombre d'états : 1 à 253");
+  static_assert(DEFINITION::nb_transitions >= 1, "au moins une transition");
+  static_assert(DEFINITION::nb_evenements >= 1 && DEFINITION::nb_evenements < AUTOMATE_AUCUN, "nombre d'évènements : 1 à 254");
+  static_assert((uint16)DEFINITION::nb_etats * DEFINITION::nb_evenements <= AUTOMATE_NB_CASES_MAX,
+                "table [état][évènement] : AUTOMATE_NB_CASES_MAX cases au maximum");
+  static_assert(DEFINITION::Etats_Valides(0),
+                "états : parent déclaré avant l'enfant, sous-état initial enfant direct, AUTOMATE_PROFONDEUR_MAX niveaux");
+  static_assert(DEFINITION::Transitions_Valides(0), "transitions : source, évènement ou cible hors des tableaux");
+
+  typedef Automate_Table_Cases<DEFINITION,typename Automate_Suite<DEFINITION::nb_etats * DEFINITION::nb_evenements>::type> Cases;
+  typedef Automate_Table_Transitions<DEFINITION,typename Automate_Suite<DEFINITION::nb_transitions>::type> Transitions;
+
+  uint8 etat;                  // état feuille courant
+  void *contexte;              // donné aux actions et aux gardes
+};
+
+// ##########################################################################################################################
+//                                      FONCTIONS AUTOMATE (TEMPLATES)
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Automate_Entrer
+  DESCRIPTION   : Entre dans les états du domaine (exclu) jusqu'à la cible, puis dans ses sous-états initiaux
+  PARAMETRES    : Automate, domaine, état cible
+  RETOUR        : Etat feuille atteint
+===============================================================================*/
+template <typename DEFINITION>
+inline uint8 Automate_Entrer(Automate<DEFINITION> *automate, uint8 domaine, uint8 cible)
+{
+    const Automate_Etat *etats = DEFINITION::Etats();
+    uint8 chemin[AUTOMATE_PROFONDEUR_MAX];
+    uint8 nb = 0;
+
+    for (uint8 etat = cible; etat != domaine; etat = etats[etat].parent) chemin[nb++] = etat;
+    while (nb > 0)
+    {
+        const Automate_Etat *etat = &etats[chemin[--nb]];
+        if (etat->entree != NULL) etat->entree(automate->contexte);
+    }
+
+    while (etats[cible].initial != AUTOMATE_AUCUN)
+    {
+        cible = etats[cible].initial;
+        if (etats[cible].entree != NULL) etats[cible].entree(automate->contexte);
+    }
+    return cible;
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Demarrer
+  DESCRIPTION   : Entre dans l'état initial (et ses parents, puis ses sous-états initiaux)
+  PARAMETRES    : Automate, état initial, contexte des actions et des gardes
+  RETOUR        : rien
+===============================================================================*/
+template <typename DEFINITION>
+inline void Automate_Demarrer(Automate<DEFINITION> *automate, uint8 etat_initial, void *contexte)
+{
+    automate->contexte = contexte;
+    automate->etat = Automate_Entrer(automate,AUTOMATE_AUCUN,etat_initial);
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Traiter
+  DESCRIPTION   : Traite un évènement : transition lue dans la table [état][évènement],
+                  gardes, sorties, action, entrées
+  PARAMETRES    : Automate, évènement
+  RETOUR        : false si aucune transition n'est franchie
+===============================================================================*/
+template <typename DEFINITION>
+inline bool Automate_Traiter(Automate<DEFINITION> *automate, uint8 evenement)
+{
+    typedef Automate<DEFINITION> Type;
+    const Automate_Etat *etats = DEFINITION::Etats();
+    const Automate_Transition *transitions = DEFINITION::Transitions();
+
+    if (evenement >= DEFINITION::nb_evenements) return false;
+    uint8 index = Type::Cases::table[automate->etat * DEFINITION::nb_evenements + evenement];
+
+    // Gardes refusées : transition suivante du même état, puis des parents
+    while (index != AUTOMATE_AUCUN && transitions[index].garde != NULL && !transitions[index].garde(automate->contexte))
+    {
+        index = Type::Transitions::repli[index];
+    }
+    if (index == AUTOMATE_AUCUN) return false;
+
+    const Automate_Transition *transition = &transitions[index];
+    if (transition->cible == AUTOMATE_INTERNE)
+    {
+        if (transition->action != NULL) transition->action(automate->contexte);
+        return true;
+    }
+
+    // Sorties de l'état feuille jusqu'au domaine (exclu), action, entrées jusqu'à la cible
+    uint8 domaine = Type::Transitions::domaine[index];
+    for (uint8 etat = automate->etat; etat != domaine; etat = etats[etat].parent)
+    {
+        if (etats[etat].sortie != NULL) etats[etat].sortie(automate->contexte);
+    }
+    if (transition->action != NULL) transition->action(automate->contexte);
+    automate->etat = Automate_Entrer(automate,domaine,transition->cible);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Dans
+  DESCRIPTION   : Indique si l'automate est dans un état (l'état feuille ou l'un de ses parents)
+  PARAMETRES    : Automate, état
+  RETOUR        : true si l'état est actif
+===============================================================================*/
+template <typename DEFINITION>
+inline bool Automate_Dans(const Automate<DEFINITION> *automate, uint8 etat)
+{
+    const Automate_Etat *etats = DEFINITION::Etats();
+    for (uint8 actif = automate->etat; actif != AUTOMATE_AUCUN; actif = etats[actif].parent)
+    {
+        if (actif == etat) return true;
+    }
+    return false;
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Distribuer
+  DESCRIPTION   : Fonction de distribution d'un automate enregistré (Automate_Distribution)
+  PARAMETRES    : Automate, évènement
+  RETOUR        : false si aucune transition n'est franchie
+===============================================================================*/
+template <typename DEFINITION>
+bool Automate_Distribuer(void *automate, uint8 evenement)
+{
+    return Automate_Traiter((Automate<DEFINITION> *)automate,evenement);
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS DISTRIBUTION DES EVENEMENTS
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Automate_Enregistrer
+  DESCRIPTION   : Enregistre un automate auprès de la distribution d'évènements
+  PARAMETRES    : Fonction de distribution, automate
+  RETOUR        : N° de l'automate (évènements, GPIO, temporisations), -1 si la table est pleine
+===============================================================================*/
+int8 Automate_Enregistrer(Automate_Distribution distribution, void *automate);
+
+template <typename DEFINITION>
+inline int8 Automate_Enregistrer(Automate<DEFINITION> *automate)
+{
+    return Automate_Enregistrer(Automate_Distribuer<DEFINITION>,automate);
+}
+
+/*===============================================================================
+  FONCTION      : Automate_Poster
+  DESCRIPTION   : Ajoute un évènement à la file (hors interruption : boucle principale, tâches, actions)
+  PARAMETRES    : N° de l'automate, évènement
+  RETOUR        : false si la file est pleine (évènement perdu)
+===============================================================================*/
+bool Automate_Poster(uint8 automate, uint8 evenement);
+
+/*===============================================================================
+  FONCTION      : Automate_Poster_Interruption
+  DESCRIPTION   : Ajoute un évènement à la file des interruptions (GPIO, UART, TIMER ;
+                  pas depuis une interruption NMI)
+  PARAMETRES    : N° de l'automate, évènement
+  RETOUR        : false si la file est pleine (évènement perdu)
+===============================================================================*/
+bool ICACHE_RAM_ATTR Automate_Poster_Interruption(uint8 automate, uint8 evenement);
+
+/*===============================================================================
+  FONCTION      : Automate_Lier_GPIO
+  DESCRIPTION   : Poste un évènement à chaque front d'une GPIO (interruption sur le ou les fronts utiles)
+  PARAMETRES    : N° de la GPIO (0 à 15), N° de l'automate,
+                  évènements des fronts montant et descendant (AUTOMATE_AUCUN : front ignoré)
+  RETOUR        : false si les paramètres sont invalides
+===============================================================================*/
+bool Automate_Lier_GPIO(uint8 gpio, uint8 automate, uint8 evenement_montant, uint8 evenement_descendant);
+
+/*===============================================================================
+  FONCTION      : Automate_Armer
+  DESCRIPTION   : Poste un évènement après un délai (réarme la temporisation si elle existe déjà)
+  PARAMETRES    : N° de l'automate, évènement, délai (ms)
+  RETOUR        : false si toutes les temporisations sont utilisées
+===============================================================================*/
+bool Automate_Armer(uint8 automate, uint8 evenement, uint32 delai_ms);
+
+/*===============================================================================
+  FONCTION      : Automate_Desarmer
+  DESCRIPTION   : Annule une temporisation (sans effet si elle n'est pas armée)
+  PARAMETRES    : N° de l'automate, évènement
+  RETOUR        : rien
+===============================================================================*/
+void Automate_Desarmer(uint8 automate, uint8 evenement);
+
+/*===============================================================================
+  FONCTION      : Automate_Tache_1ms
+  DESCRIPTION   : Poste les évènements des temporisations échues
+                  (une comparaison lorsqu'aucune n'est échue)
+  A appeler toutes les millisecondes (Fonction_Task_1ms du Scheduler)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Automate_Tache_1ms();
+
+/*===============================================================================
+  FONCTION      : Automate_Executer
+  DESCRIPTION   : Distribue un évènement en attente (file des interruptions en premier)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des évènements en attente
+===============================================================================*/
+bool Automate_Executer();
+
+/*===============================================================================
+  FONCTION      : Automate_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la distribution des évènements
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Automate_Statistiques *Automate_Lire_Statistiques();
+
+/*===============================================================================
+  FONCTION      : Interruption_Automate_GPIO
+  DESCRIPTION   : Interruption d'une GPIO liée : poste l'évènement du front
+  PARAMETRES    : N° de la GPIO, état lu
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Automate_GPIO(uint8 GPIO, uint8 etat);
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,149 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Cache_Registres.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Copie en RAM des registres de configuration, pour éviter les lectures matérielles des modifications de bits
+ *  (voir Cache_Registres.h)
+ * =============================================================================================================================================
+ */
+
+#include "Cache_Registres.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Copies des registres et validité de chaque copie
+uint32 Copie_Registres[NB_CACHE_REGISTRES];
+volatile bool Copie_Valide[NB_CACHE_REGISTRES];
+
+Cache_Registres_Statistiques Statistiques_Cache;
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Cache_Index
+  DESCRIPTION   : Emplacement de la copie d'un registre
+  PARAMETRES    : Registre ciblé
+  RETOUR        : N° de la copie, -1 si le registre n'est pas copié
+===============================================================================*/
+static int8 ICACHE_RAM_ATTR Cache_Index(__Registre *Registre)
+{
+    uint32 adresse = (uint32)(uintptr_t)Registre;
+
+    if (adresse - CACHE_ADDR_IOMUX_GPIO < CACHE_NB_IOMUX_GPIO * 4) return (adresse - CACHE_ADDR_IOMUX_GPIO) >> 2;
+    if (adresse - CACHE_ADDR_GPIO_PIN < CACHE_NB_GPIO_PIN * 4) return CACHE_INDEX_GPIO_PIN + ((adresse - CACHE_ADDR_GPIO_PIN) >> 2);
+
+    switch (adresse)
+    {
+        case ADDR_UART0 + CACHE_DECALAGE_CONF0 : return CACHE_INDEX_UART;
+        case ADDR_UART0 + CACHE_DECALAGE_CONF1 : return CACHE_INDEX_UART + 1;
+        case ADDR_UART1 + CACHE_DECALAGE_CONF0 : return CACHE_INDEX_UART + 2;
+        case ADDR_UART1 + CACHE_DECALAGE_CONF1 : return CACHE_INDEX_UART + 3;
+        default : return -1;
+    }
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS CACHE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Cache_Lecture_Registre
+  DESCRIPTION   : Lit un registre de configuration dans sa copie en RAM
+  (utilisée par REGISTRE_CONFIG_LIRE lorsque CACHE_REGISTRES est défini ;
+  lecture matérielle si le registre n'est pas copié ou si la copie est invalide)
+  PARAMETRES    : Registre ciblé
+  RETOUR        : Valeur du registre
+===============================================================================*/
+uint32 ICACHE_RAM_ATTR Cache_Lecture_Registre(__Registre *Registre)
+{
+    int8 index = Cache_Index(Registre);
+
+    if (index < 0) return REGISTRE_LIRE(*Registre);
+
+    if (Copie_Valide[index])
+    {
+        Statistiques_Cache.lectures_evitees++;
+        return Copie_Registres[index];
+    }
+
+    Copie_Registres[index] = REGISTRE_LIRE(*Registre);
+    Copie_Valide[index] = true;
+    Statistiques_Cache.lectures_materiel++;
+    return Copie_Registres[index];
+}
+
+/*===============================================================================
+  FONCTION      : Cache_Ecriture_Registre
+  DESCRIPTION   : Ecrit un registre de configuration et met à jour sa copie en RAM
+  (utilisée par REGISTRE_CONFIG_ECRIRE lorsque CACHE_REGISTRES est défini ;
+  l'écriture est omise si la copie contient déjà la valeur)
+  PARAMETRES    : Registre ciblé, valeur à écrire
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Cache_Ecriture_Registre(__Registre *Registre, uint32 valeur)
+{
+    int8 index = Cache_Index(Registre);
+
+    if (index >= 0)
+    {
+        if (Copie_Valide[index] && Copie_Registres[index] == valeur)
+        {
+            Statistiques_Cache.ecritures_evitees++;
+            return;
+        }
+        Copie_Registres[index] = valeur;
+        Copie_Valide[index] = true;
+    }
+    REGISTRE_ECRIRE(*Registre,valeur);
+}
+
+/*===============================================================================
+  FONCTION      : Cache_Registres_Synchroniser
+  DESCRIPTION   : Relit un registre copié sur le matériel (après une modification
+                  faite en dehors des macros REGISTRE_CONFIG_xxx)
+  PARAMETRES    : Registre ciblé
+  RETOUR        : rien
+===============================================================================*/
+void Cache_Registres_Synchroniser(__Registre *Registre)
+{
+    int8 index = Cache_Index(Registre);
+    if (index < 0) return;
+
+    ETS_INTR_LOCK();
+    Copie_Registres[index] = REGISTRE_LIRE(*Registre);
+    Copie_Valide[index] = true;
+    ETS_INTR_UNLOCK();
+}
+
+/*===============================================================================
+  FONCTION      : Cache_Registres_Invalider
+  DESCRIPTION   : Invalide toutes les copies (relues à leur prochain accès)
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void Cache_Registres_Invalider()
+{
+    for (uint8 i = 0; i < NB_CACHE_REGISTRES; i++)
+    {
+        Copie_Valide[i] = false;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Cache_Registres_Lire_Statistiques
+  DESCRIPTION   : Statistiques d'utilisation de la copie
+  PARAMETRES    : aucun
+  RETOUR        : Statistiques
+===============================================================================*/
+const Cache_Registres_Statistiques *Cache_Registres_Lire_Statistiques()
+{
+    return &Statistiques_Cache;
+}
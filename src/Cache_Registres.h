@@ -0,0 +1,89 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Cache_Registres.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Copie en RAM des registres de configuration, pour éviter les lectures matérielles des modifications de bits
+ *
+ *  Une lecture sur le bus des périphériques est bien plus lente qu'une lecture en RAM, et chaque REGISTRE_SET_BIT
+ *  relit le registre avant de l'écrire. Avec l'option de compilation CACHE_REGISTRES (-DCACHE_REGISTRES, pour toute
+ *  la librairie), les macros REGISTRE_CONFIG_xxx (et Set_buffer_to_Registre) travaillent sur une copie en RAM des
+ *  registres de configuration et n'écrivent le registre matériel qu'une fois :
+ *    - IOMUX->GPIO[0..14]
+ *    - GPIO->PIN[0..15]
+ *    - UART0 / UART1 : CONF0 et CONF1
+ *  La copie d'un registre est remplie à sa première lecture. Les registres d'état et de données (IN, STATUS, FIFO...)
+ *  ne sont jamais copiés : ils sont toujours lus sur le matériel.
+ *
+ *  Si un registre copié est modifié en dehors de ces macros (fonctions du SDK ou de la ROM, REGISTRE_ECRIRE direct),
+ *  appeler Cache_Registres_Synchroniser (relecture du registre) ou Cache_Registres_Invalider (tous les registres).
+ *  Sans l'option, les macros REGISTRE_CONFIG_xxx sont des accès directs et ce module n'est pas utilisé.
+ *
+ *  Le gain se mesure avec TRACE_REGISTRES (voir Trace_Registres.h) : comparer les lectures d'une même séquence
+ *  d'initialisation compilée avec et sans CACHE_REGISTRES.
+ * =============================================================================================================================================
+ */
+
+#ifndef __CACHE_REGISTRES_H__
+#define __CACHE_REGISTRES_H__
+
+// Dépendance(s)
+#include "registres_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Registres copiés
+#define CACHE_ADDR_IOMUX_GPIO (ADDR_IOMUX + 0x04)  // IOMUX->GPIO[0]
+#define CACHE_NB_IOMUX_GPIO   15
+#define CACHE_ADDR_GPIO_PIN   (ADDR_GPIO + 0x28)   // GPIO->PIN[0]
+#define CACHE_NB_GPIO_PIN     16
+#define CACHE_DECALAGE_CONF0  0x20                 // UART->CONF0
+#define CACHE_DECALAGE_CONF1  0x24                 // UART->CONF1
+
+#define CACHE_INDEX_GPIO_PIN  CACHE_NB_IOMUX_GPIO
+#define CACHE_INDEX_UART      (CACHE_INDEX_GPIO_PIN + CACHE_NB_GPIO_PIN)
+#define NB_CACHE_REGISTRES    (CACHE_INDEX_UART + 4)
+
+// Statistiques d'utilisation
+typedef struct{
+  uint32 lectures_evitees;     // lectures servies par la copie
+  uint32 lectures_materiel;    // remplissages de la copie (première lecture, copie invalidée)
+  uint32 ecritures_evitees;    // écritures omises (valeur déjà présente)
+} Cache_Registres_Statistiques;
+
+// ##########################################################################################################################
+//                                      FONCTIONS CACHE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Cache_Registres_Synchroniser
+  DESCRIPTION   : Relit un registre copié sur le matériel (après une modification
+                  faite en dehors des macros REGISTRE_CONFIG_xxx)
+  PARAMETRES    : Registre ciblé
+  RETOUR        : rien
+===============================================================================*/
+void Cache_Registres_Synchroniser(__Registre *Registre);
+
+/*===============================================================================
+  FONCTION      : Cache_Registres_Invalider
+  DESCRIPTION   : Invalide toutes les copies (relues à leur prochain accès)
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void Cache_Registres_Invalider();
+
+/*===============================================================================
+  FONCTION      : Cache_Registres_Lire_Statistiques
+  DESCRIPTION   : Statistiques d'utilisation de la copie
+  PARAMETRES    : aucun
+  RETOUR        : Statistiques
+===============================================================================*/
+const Cache_Registres_Statistiques *Cache_Registres_Lire_Statistiques();
+
+/* fin du fichier */
+#endif
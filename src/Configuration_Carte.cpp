@@ -0,0 +1,78 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Configuration_Carte.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Configuration de toutes les broches d'une carte à partir d'une description déclarative
+ *  (voir Configuration_Carte.h)
+ * =============================================================================================================================================
+ */
+
+#include "Configuration_Carte.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Bits des registres fixés par l'image (comparés par Carte_Verifier)
+#define CARTE_MASQUE_PIN   ((0x7 << BIT_GPIO_INT_TYPE) | (1 << BIT_GPIO_DRIVER) | (1 << BIT_GPIO_SOURCE))
+#define CARTE_MASQUE_IOMUX (IOMUX_FONCTION(0x7) | (1 << BIT_IOMUX_PULLUP))
+
+// ##########################################################################################################################
+//                                      FONCTIONS CARTE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Carte_Appliquer
+  DESCRIPTION   : Applique l'image des registres d'une carte
+                  (une écriture par registre, sorties positionnées avant d'être activées)
+  PARAMETRES    : Image de la carte (CARTE_IMAGE)
+  RETOUR        : rien
+===============================================================================*/
+void Carte_Appliquer(const Carte_Image *image)
+{
+    // Etape 1 : état initial des sorties (avant leur activation : pas d'impulsion parasite)
+    REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,image->etats_hauts);
+    REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,image->sorties & ~image->etats_hauts);
+
+    // Etape 2 : registres de chaque broche décrite
+    for (uint8 gpio = 0; gpio < CARTE_NB_GPIO; gpio++)
+    {
+        if (!READ_BIT(image->masque,gpio)) continue;
+
+        REGISTRE_CONFIG_ECRIRE(Registre_GPIO->PIN[gpio],image->pin[gpio]);
+        REGISTRE_CONFIG_ECRIRE(Registre_IOMUX->GPIO[Carte_Index_IOMUX(gpio)],image->iomux[gpio]);
+    }
+
+    // Etape 3 : acquittement des interruptions déclenchées pendant la configuration
+    REGISTRE_ECRIRE(Registre_GPIO->STATUS_W1TC,image->interruptions);
+
+    // Etape 4 : direction des broches
+    REGISTRE_ECRIRE(Registre_GPIO->ENABLE_W1TS,image->sorties);
+    REGISTRE_ECRIRE(Registre_GPIO->ENABLE_W1TC,image->masque & ~image->sorties);
+}
+
+/*===============================================================================
+  FONCTION      : Carte_Verifier
+  DESCRIPTION   : Compare les registres de la puce à l'image d'une carte
+  PARAMETRES    : Image de la carte
+  RETOUR        : -1 si la configuration est conforme,
+                  N° de la première GPIO différente sinon
+===============================================================================*/
+int8 Carte_Verifier(const Carte_Image *image)
+{
+    uint32 enable = REGISTRE_LIRE(Registre_GPIO->ENABLE);
+
+    for (uint8 gpio = 0; gpio < CARTE_NB_GPIO; gpio++)
+    {
+        if (!READ_BIT(image->masque,gpio)) continue;
+
+        if (READ_BIT(enable,gpio) != READ_BIT(image->sorties,gpio)) return gpio;
+        if ((REGISTRE_LIRE(Registre_GPIO->PIN[gpio]) & CARTE_MASQUE_PIN) != (image->pin[gpio] & CARTE_MASQUE_PIN)) return gpio;
+        if ((REGISTRE_LIRE(Registre_IOMUX->GPIO[Carte_Index_IOMUX(gpio)]) & CARTE_MASQUE_IOMUX) != (image->iomux[gpio] & CARTE_MASQUE_IOMUX)) return gpio;
+    }
+    return -1;
+}
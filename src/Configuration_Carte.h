@@ -0,0 +1,208 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Configuration_Carte.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Configuration de toutes les broches d'une carte à partir d'une description déclarative
+ *
+ *  La carte est décrite par un tableau constant (une ligne par broche : fonction, direction, options, interruption).
+ *  Le compilateur en déduit une "image" des registres GPIO et IOMUX (CARTE_IMAGE) : aucun calcul au démarrage.
+ *  Carte_Appliquer écrit chaque registre une seule fois (au lieu des lectures-modifications-écritures
+ *  bit à bit de init_GPIO / Choix_fonction_GPIO), puis Carte_Verifier relit les registres.
+ *
+ *  - Les registres PIN et IOMUX des broches décrites sont entièrement réécrits
+ *  - Les broches non décrites ne sont pas modifiées
+ *  - Les fonctions d'interruption sont associées ensuite (GPIO_Attacher_Interruption)
+ *
+ *  Exemple :
+ *      static constexpr Carte_Broche Broches[] = {
+ *          // GPIO  fonction             direction    options                            interruption
+ *          {  D1,   CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_PULLUP,                      INACTIF          },
+ *          {  D5,   CARTE_FONCTION_GPIO, GPIO_INPUT,  CARTE_PULLUP,                      FRONT_DESCENDANT },
+ *          {  D6,   CARTE_FONCTION_GPIO, GPIO_OUTPUT, CARTE_DRAIN_OUVERT | CARTE_ETAT_HAUT, INACTIF       },
+ *      };
+ *      static_assert(CARTE_TABLE_VALIDE(Broches), "description de carte invalide");
+ *      static constexpr Carte_Image Image = CARTE_IMAGE(Broches);
+ *      setup : Carte_Appliquer(&Image);
+ * =============================================================================================================================================
+ */
+
+#ifndef __CONFIGURATION_CARTE_H__
+#define __CONFIGURATION_CARTE_H__
+
+// Dépendance(s)
+#include "GPIO_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre de broches configurables (GPIO0 à GPIO15)
+#define CARTE_NB_GPIO 16
+
+// Fonction "GPIO" de la broche (fonction 1 pour GPIO0/2/4/5, fonction 4 pour les autres, comme init_GPIO)
+#define CARTE_FONCTION_GPIO 0xFF
+
+// Options d'une broche (combinables)
+#define CARTE_PULLUP       0x01 // résistance de tirage
+#define CARTE_DRAIN_OUVERT 0x02 // sortie en drain ouvert
+#define CARTE_ETAT_HAUT    0x04 // état initial d'une sortie (état bas par défaut)
+
+// Description d'une broche
+typedef struct{
+  uint8 gpio;           // N° de la GPIO (0 à 15)
+  uint8 fonction;       // GPIO_FONCTION_x ou CARTE_FONCTION_GPIO
+  uint8 direction;      // GPIO_INPUT ou GPIO_OUTPUT
+  uint8 options;        // CARTE_PULLUP | CARTE_DRAIN_OUVERT | CARTE_ETAT_HAUT
+  uint8 interruption;   // GPIO_Interrupt
+} Carte_Broche;
+
+// Image des registres d'une carte
+typedef struct{
+  uint32 masque;                  // GPIO décrites
+  uint32 sorties;                 // GPIO en sortie
+  uint32 etats_hauts;             // sorties initialisées à l'état haut
+  uint32 interruptions;           // GPIO dont l'interruption est active
+  uint32 pin[CARTE_NB_GPIO];      // valeur de GPIO->PIN[n]
+  uint32 iomux[CARTE_NB_GPIO];    // valeur du registre IOMUX de la GPIO n
+} Carte_Image;
+
+// ##########################################################################################################################
+//                                      CALCUL DE L'IMAGE (COMPILATION)
+// ##########################################################################################################################
+// Fonctions "constexpr" (C++11 : une seule expression, récursivité) évaluées par le compilateur
+
+/*===============================================================================
+  FONCTION      : Carte_Index_IOMUX
+  DESCRIPTION   : Index du registre IOMUX d'une GPIO (équivalent constant de index_iomux)
+  PARAMETRES    : N° de la GPIO
+  RETOUR        : Index dans Registre_IOMUX->GPIO
+===============================================================================*/
+constexpr uint8 Carte_Index_IOMUX(uint8 gpio)
+{
+    return (gpio == 0) ? 12 : (gpio == 1) ? 5 : (gpio == 2) ? 13 : (gpio == 3) ? 4 :
+           (gpio == 4) ? 14 : (gpio == 5) ? 15 : (gpio >= 12) ? gpio - 12 : gpio;
+}
+
+/*===============================================================================
+  FONCTION      : Carte_Fonction
+  DESCRIPTION   : Fonction IOMUX effective d'une broche
+  PARAMETRES    : Description de la broche
+  RETOUR        : GPIO_FONCTION_x
+===============================================================================*/
+constexpr uint8 Carte_Fonction(const Carte_Broche &b)
+{
+    return (b.fonction != CARTE_FONCTION_GPIO) ? b.fonction :
+           (b.gpio == 0 || b.gpio == 2 || b.gpio == 4 || b.gpio == 5) ? GPIO_FONCTION_1 : GPIO_FONCTION_4;
+}
+
+/*===============================================================================
+  FONCTION      : Carte_Masque_Tout / _Sorties / _Options / _Interruptions
+  DESCRIPTION   : Masque des GPIO d'une table (toutes, en sortie, avec une option, avec interruption)
+  PARAMETRES    : Table, nombre de broches (, option)
+  RETOUR        : Masque (bit n : GPIO n)
+===============================================================================*/
+constexpr uint32 Carte_Masque_Tout(const Carte_Broche *t, uint8 n)
+{
+    return (n == 0) ? 0 : (1UL << t[0].gpio) | Carte_Masque_Tout(t + 1, n - 1);
+}
+constexpr uint32 Carte_Masque_Sorties(const Carte_Broche *t, uint8 n)
+{
+    return (n == 0) ? 0 : ((t[0].direction == GPIO_OUTPUT) ? (1UL << t[0].gpio) : 0) | Carte_Masque_Sorties(t + 1, n - 1);
+}
+constexpr uint32 Carte_Masque_Options(const Carte_Broche *t, uint8 n, uint8 option)
+{
+    return (n == 0) ? 0 : ((t[0].options & option) ? (1UL << t[0].gpio) : 0) | Carte_Masque_Options(t + 1, n - 1, option);
+}
+constexpr uint32 Carte_Masque_Interruptions(const Carte_Broche *t, uint8 n)
+{
+    return (n == 0) ? 0 : ((t[0].interruption != INACTIF) ? (1UL << t[0].gpio) : 0) | Carte_Masque_Interruptions(t + 1, n - 1);
+}
+
+/*===============================================================================
+  FONCTION      : Carte_PIN / Carte_IOMUX
+  DESCRIPTION   : Valeur des registres GPIO->PIN et IOMUX d'une GPIO
+  PARAMETRES    : Table, nombre de broches, N° de la GPIO
+  RETOUR        : Valeur du registre (0 si la GPIO n'est pas décrite)
+===============================================================================*/
+constexpr uint32 Carte_PIN(const Carte_Broche *t, uint8 n, uint8 gpio)
+{
+    return (n == 0) ? 0 : (t[0].gpio != gpio) ? Carte_PIN(t + 1, n - 1, gpio) :
+           ((uint32)t[0].interruption << BIT_GPIO_INT_TYPE) |
+           ((t[0].options & CARTE_DRAIN_OUVERT) ? (1UL << BIT_GPIO_DRIVER) : 0);
+}
+constexpr uint32 Carte_IOMUX(const Carte_Broche *t, uint8 n, uint8 gpio)
+{
+    return (n == 0) ? 0 : (t[0].gpio != gpio) ? Carte_IOMUX(t + 1, n - 1, gpio) :
+           IOMUX_FONCTION(Carte_Fonction(t[0])) |
+           ((t[0].options & CARTE_PULLUP) ? (1UL << BIT_IOMUX_PULLUP) : 0);
+}
+
+/*===============================================================================
+  FONCTION      : Carte_Table_Valide
+  DESCRIPTION   : Vérifie une table (GPIO 0 à 15 sans doublon, paramètres dans leurs bornes)
+  PARAMETRES    : Table, nombre de broches
+  RETOUR        : true si la table est valide
+===============================================================================*/
+constexpr bool Carte_Broche_Valide(const Carte_Broche &b)
+{
+    return b.gpio < CARTE_NB_GPIO && b.direction <= GPIO_OUTPUT && b.interruption <= HIGH_LEVEL &&
+           (b.fonction == CARTE_FONCTION_GPIO || b.fonction <= GPIO_FONCTION_5) &&
+           (b.options & ~(CARTE_PULLUP | CARTE_DRAIN_OUVERT | CARTE_ETAT_HAUT)) == 0;
+}
+constexpr bool Carte_Table_Valide(const Carte_Broche *t, uint8 n, uint32 deja_vues)
+{
+    return (n == 0) ? true :
+           Carte_Broche_Valide(t[0]) && !(deja_vues & (1UL << t[0].gpio)) &&
+           Carte_Table_Valide(t + 1, n - 1, deja_vues | (1UL << t[0].gpio));
+}
+
+// Nombre de broches d'une table
+#define CARTE_NB_BROCHES(table) ((uint8)(sizeof(table) / sizeof((table)[0])))
+
+// Validité d'une table (à utiliser avec static_assert)
+#define CARTE_TABLE_VALIDE(table) Carte_Table_Valide(table,CARTE_NB_BROCHES(table),0)
+
+// Image des registres d'une table (initialiseur d'une constante Carte_Image)
+#define CARTE_PIN_IOMUX_4(f,table,g) \
+    f(table,CARTE_NB_BROCHES(table),g),     f(table,CARTE_NB_BROCHES(table),g + 1), \
+    f(table,CARTE_NB_BROCHES(table),g + 2), f(table,CARTE_NB_BROCHES(table),g + 3)
+#define CARTE_PIN_IOMUX_16(f,table) \
+    CARTE_PIN_IOMUX_4(f,table,0), CARTE_PIN_IOMUX_4(f,table,4), CARTE_PIN_IOMUX_4(f,table,8), CARTE_PIN_IOMUX_4(f,table,12)
+
+#define CARTE_IMAGE(table) {                                                    \
+    Carte_Masque_Tout(table,CARTE_NB_BROCHES(table)),                           \
+    Carte_Masque_Sorties(table,CARTE_NB_BROCHES(table)),                        \
+    Carte_Masque_Options(table,CARTE_NB_BROCHES(table),CARTE_ETAT_HAUT) &       \
+        Carte_Masque_Sorties(table,CARTE_NB_BROCHES(table)),                    \
+    Carte_Masque_Interruptions(table,CARTE_NB_BROCHES(table)),                  \
+    { CARTE_PIN_IOMUX_16(Carte_PIN,table) },                                    \
+    { CARTE_PIN_IOMUX_16(Carte_IOMUX,table) } }
+
+// ##########################################################################################################################
+//                                      FONCTIONS CARTE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Carte_Appliquer
+  DESCRIPTION   : Applique l'image des registres d'une carte
+                  (une écriture par registre, sorties positionnées avant d'être activées)
+  PARAMETRES    : Image de la carte (CARTE_IMAGE)
+  RETOUR        : rien
+===============================================================================*/
+void Carte_Appliquer(const Carte_Image *image);
+
+/*===============================================================================
+  FONCTION      : Carte_Verifier
+  DESCRIPTION   : Compare les registres de la puce à l'image d'une carte
+  PARAMETRES    : Image de la carte
+  RETOUR        : -1 si la configuration est conforme,
+                  N° de la première GPIO différente sinon
+===============================================================================*/
+int8 Carte_Verifier(const Carte_Image *image);
+
+/* fin du fichier */
+#endif
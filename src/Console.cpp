@@ -0,0 +1,700 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Console.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Console de commandes sur l'UART0 (maintenance, pilotage par script depuis la passerelle)
+ *  (voir Console.h)
+ * =============================================================================================================================================
+ */
+
+#include "Console.h"
+#include <string.h>
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Hachage FNV-1a 32 bits
+#define CONSOLE_FNV_BASE     2166136261u
+#define CONSOLE_FNV_PREMIER  16777619u
+
+// Emplacement libre de la table de hachage
+#define CONSOLE_AUCUNE 0xFF
+
+// Masques des buffers circulaires
+#define CONSOLE_MASQUE_RX (CONSOLE_TAILLE_RX - 1)
+#define CONSOLE_MASQUE_TX (CONSOLE_TAILLE_TX - 1)
+
+// Interruptions de réception
+#define CONSOLE_INT_RX ((1 << BIT_UART_INT_RXFIFO_FULL) | (1 << BIT_UART_INT_RXFIFO_TOUT) | (1 << BIT_UART_INT_RXFIFO_OVF))
+
+// Table des commandes
+const Console_Commande *Console_Commandes = NULL;
+uint8 Console_Nb_Commandes = 0;
+uint8 Console_Table[1 << CONSOLE_BITS_TABLE];   // hash -> n° de commande
+uint32 Console_Multiplicateur = 0;
+
+// Buffers circulaires (index libres, masqués à l'utilisation)
+uint8 Console_RX[CONSOLE_TAILLE_RX];
+volatile uint16 console_rx_ecriture = 0;
+volatile uint16 console_rx_lecture = 0;
+volatile bool console_rx_suspendu = false; // contrôle de flux : la fifo RX n'est plus vidée
+
+uint8 Console_TX[CONSOLE_TAILLE_TX];
+volatile uint16 console_tx_ecriture = 0;
+volatile uint16 console_tx_lecture = 0;
+
+// Ligne en cours de réception
+char Console_Ligne[CONSOLE_TAILLE_LIGNE];
+uint8 console_longueur = 0;
+uint8 console_nb_mots = 0;
+uint8 Console_Debut_Mot[CONSOLE_NB_ARGUMENTS_MAX + 1];
+bool console_dans_mot = false;
+bool console_guillemets = false;
+bool console_debordement = false;
+bool console_echo = false;
+uint32 console_hash = CONSOLE_FNV_BASE;
+
+Console_Statistiques Statistiques_Console;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Console_Index
+  DESCRIPTION   : Emplacement d'un hash dans la table des commandes
+  PARAMETRES    : Hash du nom, multiplicateur
+  RETOUR        : Index (0 à 2^CONSOLE_BITS_TABLE - 1)
+===============================================================================*/
+static inline uint8 Console_Index(uint32 hash, uint32 multiplicateur)
+{
+    return (hash * multiplicateur) >> (32 - CONSOLE_BITS_TABLE);
+}
+
+/*===============================================================================
+  FONCTION      : Console_Hash
+  DESCRIPTION   : Hash FNV-1a d'une chaîne de caractères
+  PARAMETRES    : Chaîne
+  RETOUR        : Hash
+===============================================================================*/
+static uint32 Console_Hash(const char *texte)
+{
+    uint32 hash = CONSOLE_FNV_BASE;
+    while (*texte)
+    {
+        hash = (hash ^ (uint8)*texte++) * CONSOLE_FNV_PREMIER;
+    }
+    return hash;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Construire_Table
+  DESCRIPTION   : Cherche un multiplicateur donnant une table sans collision
+  PARAMETRES    : rien
+  RETOUR        : false si aucun multiplicateur ne convient
+===============================================================================*/
+static bool Console_Construire_Table()
+{
+    uint32 hash[CONSOLE_NB_COMMANDES_MAX];
+    uint32 multiplicateur = 0x9E3779B1; // nombre d'or (hachage de Fibonacci)
+
+    for (uint8 i = 0; i < Console_Nb_Commandes; i++)
+    {
+        hash[i] = Console_Hash(Console_Commandes[i].nom);
+    }
+
+    for (uint16 essai = 0; essai < CONSOLE_ESSAIS_HACHAGE; essai++)
+    {
+        bool collision = false;
+
+        for (uint8 i = 0; i < (1 << CONSOLE_BITS_TABLE); i++) Console_Table[i] = CONSOLE_AUCUNE;
+
+        for (uint8 i = 0; i < Console_Nb_Commandes && !collision; i++)
+        {
+            uint8 index = Console_Index(hash[i],multiplicateur);
+            if (Console_Table[index] != CONSOLE_AUCUNE) collision = true;
+            Console_Table[index] = i;
+        }
+        if (!collision)
+        {
+            Console_Multiplicateur = multiplicateur;
+            return true;
+        }
+        multiplicateur += 0x6A09E668; // multiplicateur suivant (reste impair)
+    }
+    return false;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Ajouter_TX
+  DESCRIPTION   : Ajoute un octet au buffer d'envoi
+  PARAMETRES    : Octet
+  RETOUR        : false si le buffer est plein
+===============================================================================*/
+static bool Console_Ajouter_TX(uint8 octet)
+{
+    if ((uint16)(console_tx_ecriture - console_tx_lecture) >= CONSOLE_TAILLE_TX)
+    {
+        Statistiques_Console.nb_perdus_tx++;
+        return false;
+    }
+    Console_TX[console_tx_ecriture & CONSOLE_MASQUE_TX] = octet;
+    console_tx_ecriture++;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Demarrer_TX
+  DESCRIPTION   : Active l'interruption "fifo TX vide" pour vider le buffer d'envoi
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Console_Demarrer_TX()
+{
+    ETS_UART_INTR_DISABLE();
+    UART_Activer_Interruption(CONSOLE_UART,(1 << BIT_UART_INT_TXFIFO_EMPTY));
+    ETS_UART_INTR_ENABLE();
+}
+
+/*===============================================================================
+  FONCTION      : Console_Lire_Entier
+  DESCRIPTION   : Convertit un mot en entier (décimal ou hexadécimal 0x...)
+  PARAMETRES    : Mot, valeur convertie, true si le signe '-' est accepté
+  RETOUR        : false si le mot n'est pas un entier
+===============================================================================*/
+static bool Console_Lire_Entier(const char *mot, uint32 *valeur, bool signe)
+{
+    bool negatif = false;
+    uint8 base = 10;
+    uint32 resultat = 0;
+
+    if (signe && *mot == '-')
+    {
+        negatif = true;
+        mot++;
+    }
+    if (mot[0] == '0' && (mot[1] == 'x' || mot[1] == 'X'))
+    {
+        base = 16;
+        mot += 2;
+    }
+    if (*mot == 0) return false;
+
+    for (; *mot; mot++)
+    {
+        uint8 chiffre;
+        if (*mot >= '0' && *mot <= '9') chiffre = *mot - '0';
+        else if (base == 16 && *mot >= 'a' && *mot <= 'f') chiffre = *mot - 'a' + 10;
+        else if (base == 16 && *mot >= 'A' && *mot <= 'F') chiffre = *mot - 'A' + 10;
+        else return false;
+
+        if (resultat > (0xFFFFFFFF - chiffre) / base) return false; // dépassement
+        resultat = resultat * base + chiffre;
+    }
+
+    if (signe && resultat > (negatif ? 0x80000000 : 0x7FFFFFFF)) return false;
+    *valeur = negatif ? 0 - resultat : resultat;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Erreur
+  DESCRIPTION   : Signale une erreur sur la console
+  PARAMETRES    : Message, commande concernée (ou NULL)
+  RETOUR        : rien
+===============================================================================*/
+static void Console_Erreur(const char *message, const Console_Commande *commande)
+{
+    Statistiques_Console.nb_erreurs++;
+    Console_Ecrire("erreur : ");
+    Console_Ecrire(message);
+    if (commande != NULL)
+    {
+        Console_Ecrire(" (");
+        Console_Ecrire(commande->nom);
+        Console_Ecrire(" ");
+        Console_Ecrire(commande->aide);
+        Console_Ecrire(")");
+    }
+    Console_Ecrire("\n");
+}
+
+/*===============================================================================
+  FONCTION      : Console_Executer_Ligne
+  DESCRIPTION   : Recherche la commande de la ligne reçue, convertit ses arguments
+                  et l'exécute
+  PARAMETRES    : rien
+  RETOUR        : true si la commande a été exécutée
+===============================================================================*/
+static bool Console_Executer_Ligne()
+{
+    const Console_Commande *commande;
+    Console_Arguments arguments;
+    uint8 numero;
+    bool optionnel = false;
+
+    // Recherche en O(1) : un seul nom à comparer
+    numero = Console_Table[Console_Index(console_hash,Console_Multiplicateur)];
+    if (numero == CONSOLE_AUCUNE || strcmp(Console_Commandes[numero].nom,Console_Ligne) != 0)
+    {
+        Console_Erreur("commande inconnue",NULL);
+        return false;
+    }
+    commande = &Console_Commandes[numero];
+
+    // Conversion des arguments selon le format
+    arguments.nb = 0;
+    for (const char *type = commande->format; *type; type++)
+    {
+        if (*type == '|')
+        {
+            optionnel = true;
+            continue;
+        }
+        if (arguments.nb + 1 >= console_nb_mots)
+        {
+            if (optionnel) break;
+            Console_Erreur("argument manquant",commande);
+            return false;
+        }
+
+        const char *mot = &Console_Ligne[Console_Debut_Mot[arguments.nb + 1]];
+        Console_Valeur *valeur = &arguments.valeurs[arguments.nb];
+        bool valide = true;
+
+        switch (*type)
+        {
+            case 'i' : valide = Console_Lire_Entier(mot,&valeur->non_signe,true);  break;
+            case 'u' : valide = Console_Lire_Entier(mot,&valeur->non_signe,false); break;
+            default  : valeur->texte = mot;                                        break;
+        }
+        if (!valide)
+        {
+            Console_Erreur("argument invalide",commande);
+            return false;
+        }
+        arguments.nb++;
+    }
+    if (arguments.nb + 1 < console_nb_mots)
+    {
+        Console_Erreur("trop d'arguments",commande);
+        return false;
+    }
+
+    Statistiques_Console.nb_commandes++;
+    commande->fonction(&arguments);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Nouvelle_Ligne
+  DESCRIPTION   : Prépare la réception d'une nouvelle ligne
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Console_Nouvelle_Ligne()
+{
+    console_longueur = 0;
+    console_nb_mots = 0;
+    console_dans_mot = false;
+    console_guillemets = false;
+    console_debordement = false;
+    console_hash = CONSOLE_FNV_BASE;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Terminer_Mot
+  DESCRIPTION   : Termine le mot en cours (la place du '\0' est toujours réservée)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Console_Terminer_Mot()
+{
+    Console_Ligne[console_longueur++] = 0;
+    console_dans_mot = false;
+    console_guillemets = false;
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS CONSOLE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Console
+  DESCRIPTION   : initialise l'UART0 (8N1) et la table des commandes
+  PARAMETRES    : Vitesse de communication (Bauds)
+                  Table des commandes (conservée par la console : constante ou globale)
+                  Nombre de commandes (CONSOLE_NB_COMMANDES_MAX au maximum)
+                  true pour renvoyer les caractères reçus (terminal interactif)
+  RETOUR        : false si la table est trop grande ou si deux commandes ont le même nom
+===============================================================================*/
+bool init_Console(uint32 Bauds, const Console_Commande *commandes, uint8 nb_commandes, bool echo)
+{
+    if (nb_commandes > CONSOLE_NB_COMMANDES_MAX) return false;
+
+    Console_Commandes = commandes;
+    Console_Nb_Commandes = nb_commandes;
+    console_echo = echo;
+    if (!Console_Construire_Table()) return false;
+
+    Console_Nouvelle_Ligne();
+    console_rx_ecriture = console_rx_lecture = 0;
+    console_rx_suspendu = false;
+    console_tx_ecriture = console_tx_lecture = 0;
+    Statistiques_Console.nb_commandes = 0;
+    Statistiques_Console.nb_erreurs = 0;
+    Statistiques_Console.nb_perdus_rx = 0;
+    Statistiques_Console.nb_perdus_tx = 0;
+
+    // Etape 1 : UART0 en 8N1, fifos vidées
+    init_UART(CONSOLE_UART,Bauds,DATA_8,NONE,STOP_1);
+    REGISTRE_CONFIG_OU(Registre_UART0->CONF0,(1 << BIT_UART_RXFIFO_RST) | (1 << BIT_UART_TXFIFO_RST));
+    REGISTRE_CONFIG_ET(Registre_UART0->CONF0,~((1 << BIT_UART_RXFIFO_RST) | (1 << BIT_UART_TXFIFO_RST)));
+
+    // Etape 2 : seuils des interruptions
+    Set_buffer_to_Registre(&Registre_UART0->CONF1,BIT_UART_RXFIFO_FULL_THRHD,CONSOLE_SEUIL_RX,7);
+    Set_buffer_to_Registre(&Registre_UART0->CONF1,BIT_UART_TXFIFO_EMPTY_THRHD,CONSOLE_SEUIL_TX,7);
+    Set_buffer_to_Registre(&Registre_UART0->CONF1,BIT_UART_RX_TOUT_THRHD,CONSOLE_TIMEOUT_RX,7);
+    REGISTRE_CONFIG_SET_BIT(Registre_UART0->CONF1,BIT_UART_RX_TOUT_EN);
+
+    // Etape 3 : interruptions de réception (l'envoi est activé à la demande)
+    UART_Desactiver_Interruption(CONSOLE_UART,0x1FF);
+    UART_Attacher_Interruption(CONSOLE_UART,Interruption_Console);
+    ETS_UART_INTR_DISABLE();
+    UART_Activer_Interruption(CONSOLE_UART,CONSOLE_INT_RX);
+    ETS_UART_INTR_ENABLE();
+
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Executer
+  DESCRIPTION   : Traite les octets reçus et exécute au plus une commande
+  A appeler dans la boucle principale
+  PARAMETRES    : rien
+  RETOUR        : true si une commande a été exécutée
+===============================================================================*/
+bool Console_Executer()
+{
+    bool execution = false;
+
+    while (!execution && console_rx_lecture != console_rx_ecriture)
+    {
+        uint8 octet = Console_RX[console_rx_lecture & CONSOLE_MASQUE_RX];
+        console_rx_lecture++;
+        execution = Console_Traiter_Octet(octet);
+    }
+
+    // Contrôle de flux : la lecture de la fifo RX reprend lorsque le buffer s'est vidé de moitié
+    // (la fifo est vidée immédiatement : l'interruption timeout a pu être perdue pendant la suspension)
+    if (console_rx_suspendu && (uint16)(CONSOLE_TAILLE_RX - (console_rx_ecriture - console_rx_lecture)) >= CONSOLE_REPRISE_RX)
+    {
+        ETS_UART_INTR_DISABLE();
+        console_rx_suspendu = false;
+        UART_Pause_Reception(CONSOLE_UART,false);
+        UART_Activer_Interruption(CONSOLE_UART,CONSOLE_INT_RX);
+        Interruption_Console(CONSOLE_UART,(1 << BIT_UART_INT_RXFIFO_FULL));
+        ETS_UART_INTR_ENABLE();
+    }
+    return execution;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Traiter_Octet
+  DESCRIPTION   : Ajoute un octet à la ligne en cours, exécute la commande en fin de ligne
+  (utilisée par Console_Executer, utilisable pour une autre source d'octets)
+  PARAMETRES    : Octet reçu
+  RETOUR        : true si une commande a été exécutée
+===============================================================================*/
+bool Console_Traiter_Octet(uint8 octet)
+{
+    bool execution = false;
+
+    if (console_echo && octet != '\r')
+    {
+        char texte[2] = {(char)octet, 0};
+        Console_Ecrire((octet == 0x08 || octet == 0x7F) ? "\b \b" : texte);
+    }
+
+    switch (octet)
+    {
+        // Fin de ligne
+        case '\r' :
+        case '\n' :
+            if (console_dans_mot) Console_Terminer_Mot();
+            if (console_debordement)
+            {
+                Console_Erreur("ligne trop longue",NULL);
+            }
+            else if (console_nb_mots > 0)
+            {
+                execution = Console_Executer_Ligne();
+            }
+            Console_Nouvelle_Ligne();
+            break;
+
+        // Effacement du dernier caractère (terminal interactif)
+        case 0x08 :
+        case 0x7F :
+            if (console_longueur == 0 || console_debordement) break;
+            if (!console_dans_mot)
+            {
+                // on rouvre le mot précédent
+                console_longueur--;
+                console_dans_mot = true;
+                break;
+            }
+            console_longueur--;
+            if (console_longueur == Console_Debut_Mot[console_nb_mots - 1])
+            {
+                console_nb_mots--;
+                console_dans_mot = false;
+            }
+            if (console_nb_mots <= 1)
+            {
+                // le nom de la commande a changé : hash recalculé
+                Console_Ligne[console_longueur] = 0;
+                console_hash = Console_Hash(Console_Ligne);
+            }
+            break;
+
+        // Séparateurs
+        case ' '  :
+        case '\t' :
+            if (console_dans_mot && !console_guillemets) Console_Terminer_Mot();
+            else if (console_guillemets) goto caractere;
+            break;
+
+        // Texte entre guillemets
+        case '"' :
+            if (!console_dans_mot)
+            {
+                if (console_debordement) break;
+                if (console_nb_mots > CONSOLE_NB_ARGUMENTS_MAX || console_longueur + 1 >= CONSOLE_TAILLE_LIGNE)
+                {
+                    console_debordement = true;
+                    break;
+                }
+                Console_Debut_Mot[console_nb_mots++] = console_longueur;
+                console_dans_mot = true;
+                console_guillemets = true;
+                break;
+            }
+            if (console_guillemets)
+            {
+                Console_Terminer_Mot();
+                break;
+            }
+            goto caractere;
+
+        // Caractère d'un mot
+        default :
+        caractere :
+            if (octet < ' ' || console_debordement) break;
+            if (!console_dans_mot)
+            {
+                if (console_nb_mots > CONSOLE_NB_ARGUMENTS_MAX)
+                {
+                    console_debordement = true;
+                    break;
+                }
+                Console_Debut_Mot[console_nb_mots++] = console_longueur;
+                console_dans_mot = true;
+            }
+            // un octet pour le caractère, un pour la fin du mot
+            if (console_longueur + 2 > CONSOLE_TAILLE_LIGNE)
+            {
+                console_debordement = true;
+                break;
+            }
+            Console_Ligne[console_longueur++] = octet;
+            if (console_nb_mots == 1) console_hash = (console_hash ^ octet) * CONSOLE_FNV_PREMIER;
+            break;
+    }
+    return execution;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Ecrire
+  DESCRIPTION   : Envoie une chaîne de caractères sans attendre ('\n' devient "\r\n")
+  PARAMETRES    : Chaîne de caractères
+  RETOUR        : false si des caractères ont été perdus (buffer TX plein)
+===============================================================================*/
+bool Console_Ecrire(const char *texte)
+{
+    bool complet = true;
+
+    while (*texte)
+    {
+        if (*texte == '\n') complet &= Console_Ajouter_TX('\r');
+        complet &= Console_Ajouter_TX(*texte++);
+    }
+    Console_Demarrer_TX();
+    return complet;
+}
+
+/*===============================================================================
+  FONCTION      : Console_Ecrire_Nombre
+  DESCRIPTION   : Envoie un entier non signé, en décimal, sans attendre
+  PARAMETRES    : Nombre
+  RETOUR        : false si des caractères ont été perdus (buffer TX plein)
+===============================================================================*/
+bool Console_Ecrire_Nombre(uint32 nombre)
+{
+    char texte[11];
+    uint8 position = sizeof(texte) - 1;
+
+    texte[position] = 0;
+    do
+    {
+        texte[--position] = '0' + (nombre % 10);
+        nombre /= 10;
+    } while (nombre != 0);
+
+    return Console_Ecrire(&texte[position]);
+}
+
+/*===============================================================================
+  FONCTION      : Console_Ecrire_Entier
+  DESCRIPTION   : Envoie un entier signé, en décimal, sans attendre
+  PARAMETRES    : Nombre
+  RETOUR        : false si des caractères ont été perdus (buffer TX plein)
+===============================================================================*/
+bool Console_Ecrire_Entier(int32 nombre)
+{
+    bool complet = true;
+
+    if (nombre < 0)
+    {
+        complet = Console_Ecrire("-");
+        return Console_Ecrire_Nombre(0 - (uint32)nombre) && complet;
+    }
+    return Console_Ecrire_Nombre(nombre);
+}
+
+/*===============================================================================
+  FONCTION      : Console_Place_TX
+  DESCRIPTION   : Place libre dans le buffer d'envoi
+  PARAMETRES    : rien
+  RETOUR        : Nombre d'octets pouvant être écrits sans perte
+===============================================================================*/
+uint16 Console_Place_TX()
+{
+    return CONSOLE_TAILLE_TX - (uint16)(console_tx_ecriture - console_tx_lecture);
+}
+
+/*===============================================================================
+  FONCTION      : Console_Aide
+  DESCRIPTION   : Commande listant les commandes disponibles (à placer dans la table)
+  PARAMETRES    : Arguments (non utilisés)
+  RETOUR        : rien
+===============================================================================*/
+void Console_Aide(const Console_Arguments *arguments)
+{
+    for (uint8 i = 0; i < Console_Nb_Commandes; i++)
+    {
+        Console_Ecrire(Console_Commandes[i].nom);
+        Console_Ecrire(" ");
+        Console_Ecrire(Console_Commandes[i].aide);
+        Console_Ecrire("\n");
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Console_Set_Controle_Flux
+  DESCRIPTION   : Active ou désactive le contrôle de flux RTS / CTS de la console
+  PARAMETRES    : true pour activer
+  RETOUR        : rien
+===============================================================================*/
+void Console_Set_Controle_Flux(bool actif)
+{
+    UART_Set_Controle_Flux(CONSOLE_UART,actif,actif,UART_SEUIL_RTS_DEFAUT);
+
+    // Sans contrôle de flux, une réception suspendue reprend (les octets en trop seront perdus)
+    if (!actif && console_rx_suspendu)
+    {
+        ETS_UART_INTR_DISABLE();
+        console_rx_suspendu = false;
+        UART_Pause_Reception(CONSOLE_UART,false);
+        UART_Activer_Interruption(CONSOLE_UART,CONSOLE_INT_RX);
+        ETS_UART_INTR_ENABLE();
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Console_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la console
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Console_Statistiques *Console_Lire_Statistiques()
+{
+    return &Statistiques_Console;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Console
+  DESCRIPTION   : Interruption UART0 : vide la fifo RX et remplit la fifo TX
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Console(uint8 UART, uint32 statut)
+{
+    // Réception : la fifo RX est vidée dans le buffer circulaire
+    if (READ_BIT(statut,BIT_UART_INT_RXFIFO_OVF))
+    {
+        Statistiques_Console.nb_perdus_rx++;
+    }
+    if ((statut & CONSOLE_INT_RX) && !console_rx_suspendu)
+    {
+        uint8 nb_fifo = (REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_RXFIFO_CNT) & 0xFF;
+
+        // Contrôle de flux : les octets sans place restent dans la fifo, qui relâchera RTS au seuil
+        if (UART_Controle_Flux_Actif(CONSOLE_UART))
+        {
+            uint16 place = CONSOLE_TAILLE_RX - (uint16)(console_rx_ecriture - console_rx_lecture);
+            if (nb_fifo >= place)
+            {
+                nb_fifo = place;
+                console_rx_suspendu = true;
+                UART_Desactiver_Interruption(CONSOLE_UART,(1 << BIT_UART_INT_RXFIFO_FULL) | (1 << BIT_UART_INT_RXFIFO_TOUT));
+                UART_Pause_Reception(CONSOLE_UART,true);
+            }
+        }
+
+        while (nb_fifo--)
+        {
+            uint8 octet = REGISTRE_LIRE(Registre_UART0->FIFO) & 0xFF;
+            if ((uint16)(console_rx_ecriture - console_rx_lecture) < CONSOLE_TAILLE_RX)
+            {
+                Console_RX[console_rx_ecriture & CONSOLE_MASQUE_RX] = octet;
+                console_rx_ecriture++;
+            }
+            else
+            {
+                Statistiques_Console.nb_perdus_rx++;
+            }
+        }
+    }
+
+    // Envoi : la fifo TX est complétée depuis le buffer circulaire
+    if (READ_BIT(statut,BIT_UART_INT_TXFIFO_EMPTY))
+    {
+        uint8 nb_fifo = (REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_TXFIFO_CNT) & 0xFF;
+        while (nb_fifo < UART_TAILLE_FIFO && console_tx_lecture != console_tx_ecriture)
+        {
+            REGISTRE_ECRIRE(Registre_UART0->FIFO,Console_TX[console_tx_lecture & CONSOLE_MASQUE_TX]);
+            console_tx_lecture++;
+            nb_fifo++;
+        }
+        if (console_tx_lecture == console_tx_ecriture)
+        {
+            UART_Desactiver_Interruption(CONSOLE_UART,(1 << BIT_UART_INT_TXFIFO_EMPTY));
+        }
+    }
+}
@@ -0,0 +1,204 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Console.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Console de commandes sur l'UART0 (maintenance, pilotage par script depuis la passerelle)
+ *
+ *  - Réception sous interruption (fifo RX) dans un buffer circulaire
+ *  - Découpage de la ligne au fil des octets reçus : mots séparés par des espaces, texte entre guillemets,
+ *    le hash du nom de la commande est calculé pendant la réception
+ *  - Recherche de la commande en O(1) : table de hachage parfaite (sans collision) construite
+ *    une seule fois à l'initialisation à partir de la table constante des commandes
+ *  - Arguments typés convertis avant l'appel de la commande, sans allocation dynamique
+ *  - Envoi non bloquant : buffer circulaire vidé par l'interruption "fifo TX vide"
+ *  - Contrôle de flux RTS / CTS optionnel (Console_Set_Controle_Flux) : lorsque le buffer de réception
+ *    est plein, la fifo RX n'est plus vidée, l'UART relâche RTS et l'émetteur s'arrête sans perte
+ *
+ *  Exemple :
+ *      void Commande_Led(const Console_Arguments *arguments)
+ *      {
+ *          GPIO_Write(arguments->valeurs[0].non_signe,arguments->valeurs[1].non_signe);
+ *      }
+ *      const Console_Commande Commandes[] = {
+ *          {"led",  "uu", Commande_Led, "<gpio> <etat>"},
+ *          {"aide", "",   Console_Aide, "liste des commandes"},
+ *      };
+ *      setup : init_Console(115200,Commandes,2,false);
+ *      loop  : Console_Executer();
+ *
+ *  /!\ La console prend l'interruption de l'UART0 : ne pas utiliser UART_WriteString(UART0,...) en parallèle
+ * =============================================================================================================================================
+ */
+
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+// Dépendance(s)
+#include "registres_esp8266.h"
+#include "UART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// UART utilisée
+#define CONSOLE_UART UART0
+
+// Taille maximale d'une ligne de commande (octets)
+#define CONSOLE_TAILLE_LIGNE 128
+
+// Nombre maximal d'arguments d'une commande
+#define CONSOLE_NB_ARGUMENTS_MAX 8
+
+// Buffers circulaires (puissances de 2)
+#define CONSOLE_TAILLE_RX 256
+#define CONSOLE_TAILLE_TX 512
+
+// Seuils des interruptions de l'UART
+#define CONSOLE_SEUIL_RX      16 // octets dans la fifo RX
+#define CONSOLE_TIMEOUT_RX    2  // durée d'un octet sans réception
+#define CONSOLE_SEUIL_TX      16 // octets restants dans la fifo TX
+
+// Contrôle de flux : reprise de la lecture de la fifo RX lorsque le buffer a au moins cette place libre
+#define CONSOLE_REPRISE_RX    (CONSOLE_TAILLE_RX / 2)
+
+// Table de hachage des commandes (2^CONSOLE_BITS_TABLE emplacements)
+#define CONSOLE_BITS_TABLE    6
+#define CONSOLE_NB_COMMANDES_MAX 16
+#define CONSOLE_ESSAIS_HACHAGE 2000 // nombre de multiplicateurs essayés pour obtenir une table sans collision
+
+// Valeur d'un argument (selon son type)
+typedef union {
+  int32 entier;          // 'i' : entier signé (décimal ou 0x...)
+  uint32 non_signe;      // 'u' : entier non signé (décimal ou 0x...)
+  const char *texte;     // 's' : texte (mot ou texte entre guillemets)
+} Console_Valeur;
+
+// Arguments d'une commande
+typedef struct{
+  uint8 nb;
+  Console_Valeur valeurs[CONSOLE_NB_ARGUMENTS_MAX];
+} Console_Arguments;
+
+// Fonction d'une commande
+typedef void (*Console_Fonction)(const Console_Arguments *arguments);
+
+// Description d'une commande
+typedef struct{
+  const char *nom;
+  const char *format;          // types des arguments ('i','u','s'), '|' : les suivants sont optionnels
+  Console_Fonction fonction;
+  const char *aide;            // texte affiché par Console_Aide et en cas d'erreur
+} Console_Commande;
+
+// Statistiques de la console
+typedef struct{
+  uint32 nb_commandes;         // commandes exécutées
+  uint32 nb_erreurs;           // commandes inconnues, arguments invalides, lignes trop longues
+  uint32 nb_perdus_rx;         // octets perdus (buffer RX plein sans contrôle de flux, débordement de la fifo RX)
+  uint32 nb_perdus_tx;         // octets perdus (buffer TX plein)
+} Console_Statistiques;
+
+// ##########################################################################################################################
+//                                      FONCTIONS CONSOLE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Console
+  DESCRIPTION   : initialise l'UART0 (8N1) et la table des commandes
+  PARAMETRES    : Vitesse de communication (Bauds)
+                  Table des commandes (conservée par la console : constante ou globale)
+                  Nombre de commandes (CONSOLE_NB_COMMANDES_MAX au maximum)
+                  true pour renvoyer les caractères reçus (terminal interactif)
+  RETOUR        : false si la table est trop grande ou si deux commandes ont le même nom
+===============================================================================*/
+bool init_Console(uint32 Bauds, const Console_Commande *commandes, uint8 nb_commandes, bool echo);
+
+/*===============================================================================
+  FONCTION      : Console_Executer
+  DESCRIPTION   : Traite les octets reçus et exécute au plus une commande
+  A appeler dans la boucle principale
+  PARAMETRES    : rien
+  RETOUR        : true si une commande a été exécutée
+===============================================================================*/
+bool Console_Executer();
+
+/*===============================================================================
+  FONCTION      : Console_Traiter_Octet
+  DESCRIPTION   : Ajoute un octet à la ligne en cours, exécute la commande en fin de ligne
+  (utilisée par Console_Executer, utilisable pour une autre source d'octets)
+  PARAMETRES    : Octet reçu
+  RETOUR        : true si une commande a été exécutée
+===============================================================================*/
+bool Console_Traiter_Octet(uint8 octet);
+
+/*===============================================================================
+  FONCTION      : Console_Ecrire
+  DESCRIPTION   : Envoie une chaîne de caractères sans attendre ('\n' devient "\r\n")
+  PARAMETRES    : Chaîne de caractères
+  RETOUR        : false si des caractères ont été perdus (buffer TX plein)
+===============================================================================*/
+bool Console_Ecrire(const char *texte);
+
+/*===============================================================================
+  FONCTION      : Console_Ecrire_Nombre
+  DESCRIPTION   : Envoie un entier non signé, en décimal, sans attendre
+  PARAMETRES    : Nombre
+  RETOUR        : false si des caractères ont été perdus (buffer TX plein)
+===============================================================================*/
+bool Console_Ecrire_Nombre(uint32 nombre);
+
+/*===============================================================================
+  FONCTION      : Console_Ecrire_Entier
+  DESCRIPTION   : Envoie un entier signé, en décimal, sans attendre
+  PARAMETRES    : Nombre
+  RETOUR        : false si des caractères ont été perdus (buffer TX plein)
+===============================================================================*/
+bool Console_Ecrire_Entier(int32 nombre);
+
+/*===============================================================================
+  FONCTION      : Console_Place_TX
+  DESCRIPTION   : Place libre dans le buffer d'envoi
+  PARAMETRES    : rien
+  RETOUR        : Nombre d'octets pouvant être écrits sans perte
+===============================================================================*/
+uint16 Console_Place_TX();
+
+/*===============================================================================
+  FONCTION      : Console_Set_Controle_Flux
+  DESCRIPTION   : Active ou désactive le contrôle de flux RTS / CTS de la console
+                  (à appeler après init_Console ; temps de blocage : UART_Lire_Statistiques_Flux)
+  PARAMETRES    : true pour activer
+  RETOUR        : rien
+===============================================================================*/
+void Console_Set_Controle_Flux(bool actif);
+
+/*===============================================================================
+  FONCTION      : Console_Aide
+  DESCRIPTION   : Commande listant les commandes disponibles (à placer dans la table)
+  PARAMETRES    : Arguments (non utilisés)
+  RETOUR        : rien
+===============================================================================*/
+void Console_Aide(const Console_Arguments *arguments);
+
+/*===============================================================================
+  FONCTION      : Console_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la console
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Console_Statistiques *Console_Lire_Statistiques();
+
+/*===============================================================================
+  FONCTION      : Interruption_Console
+  DESCRIPTION   : Interruption UART0 : vide la fifo RX et remplit la fifo TX
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Console(uint8 UART, uint32 statut);
+
+#endif
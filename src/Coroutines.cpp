@@ -0,0 +1,206 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Coroutines.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Tâches coopératives sans pile (type "protothreads") intégrées au scheduler
+ *  Une séquence en plusieurs étapes s'écrit comme une fonction linéaire : elle s'interrompt sur une attente
+ *  (délai, front sur une GPIO, données reçues, condition) et reprend à cet endroit lorsque l'attente est satisfaite.
+ * =============================================================================================================================================
+ */
+
+#include "Coroutines.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+Coroutine Coroutines[NB_COROUTINES];
+
+// ##########################################################################################################################
+//                                      FONCTIONS COROUTINES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Coroutines
+  DESCRIPTION   : Libère toutes les tâches
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void init_Coroutines()
+{
+    for (uint8 i = 0; i < NB_COROUTINES; i++)
+    {
+        Coroutines[i].fonction = NULL;
+        Coroutines[i].ligne = COROUTINE_TERMINEE;
+        Coroutines[i].attente = ATTENTE_AUCUNE;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Coroutine_Demarrer
+  DESCRIPTION   : Démarre une tâche dans un emplacement libre
+  PARAMETRES    : Corps de la tâche
+                  Contexte initial (ou NULL), taille du contexte (octets)
+  RETOUR        : N° de la tâche, -1 si aucun emplacement n'est libre
+                  ou si le contexte est trop grand
+===============================================================================*/
+int8 Coroutine_Demarrer(Coroutine_Fonction fonction, const void *contexte, uint16 taille)
+{
+    if (fonction == NULL || taille > sizeof(Coroutines[0].contexte)) return -1;
+
+    for (uint8 i = 0; i < NB_COROUTINES; i++)
+    {
+        Coroutine *co = &Coroutines[i];
+        if (co->fonction != NULL) continue;
+
+        co->ligne = 0;
+        co->attente = ATTENTE_AUCUNE;
+        co->delai_actif = false;
+        co->expire = false;
+        co->evenement = false;
+        for (uint8 j = 0; j < COROUTINE_TAILLE_CONTEXTE; j++) co->contexte[j] = 0;
+        for (uint16 j = 0; contexte != NULL && j < taille; j++)
+        {
+            ((uint8 *)co->contexte)[j] = ((const uint8 *)contexte)[j];
+        }
+        co->fonction = fonction;
+        return i;
+    }
+    return -1;
+}
+
+/*===============================================================================
+  FONCTION      : Coroutine_Arreter
+  DESCRIPTION   : Arrête une tâche et libère son emplacement
+  PARAMETRES    : N° de la tâche
+  RETOUR        : rien
+===============================================================================*/
+void Coroutine_Arreter(int8 numero)
+{
+    if (numero < 0 || numero >= NB_COROUTINES) return;
+
+    Coroutine *co = &Coroutines[numero];
+    if (co->attente == ATTENTE_FRONT) GPIO_Detacher_Interruption(co->gpio);
+    co->attente = ATTENTE_AUCUNE;
+    co->ligne = COROUTINE_TERMINEE;
+    co->fonction = NULL;
+}
+
+/*===============================================================================
+  FONCTION      : Coroutine_Active
+  DESCRIPTION   : Indique si une tâche est toujours en cours
+  PARAMETRES    : N° de la tâche
+  RETOUR        : true si la tâche n'est pas terminée
+===============================================================================*/
+bool Coroutine_Active(int8 numero)
+{
+    if (numero < 0 || numero >= NB_COROUTINES) return false;
+    return Coroutines[numero].fonction != NULL;
+}
+
+/*===============================================================================
+  FONCTION      : Coroutines_Executer
+  DESCRIPTION   : Reprend toutes les tâches dont l'attente est satisfaite
+  A appeler dans la boucle principale, après Scheduler()
+  PARAMETRES    : rien
+  RETOUR        : Nombre de tâches reprises
+===============================================================================*/
+uint8 Coroutines_Executer()
+{
+    uint32 maintenant = Scheduler_Millis();
+    uint8 nb_reprises = 0;
+
+    for (uint8 i = 0; i < NB_COROUTINES; i++)
+    {
+        Coroutine *co = &Coroutines[i];
+        if (co->fonction == NULL) continue;
+
+        bool echeance_atteinte = co->delai_actif && (int32)(maintenant - co->echeance) >= 0;
+        bool prete;
+
+        switch (co->attente)
+        {
+            case ATTENTE_DELAI     : prete = echeance_atteinte;                  break;
+            case ATTENTE_FRONT     : prete = co->evenement || echeance_atteinte; break;
+            case ATTENTE_CONDITION : // la condition est réévaluée par la tâche elle-même
+            default                : prete = true;                               break;
+        }
+        if (!prete) continue;
+
+        // Fin de l'attente
+        if (co->attente == ATTENTE_FRONT)
+        {
+            co->expire = !co->evenement;
+            if (co->expire) GPIO_Detacher_Interruption(co->gpio);
+        }
+        else if (co->attente == ATTENTE_DELAI)
+        {
+            co->expire = true;
+        }
+        if (co->attente != ATTENTE_CONDITION)
+        {
+            co->attente = ATTENTE_AUCUNE;
+            co->delai_actif = false;
+        }
+
+        co->fonction(co);
+        nb_reprises++;
+
+        // Tâche terminée : l'emplacement est libéré
+        if (co->ligne == COROUTINE_TERMINEE) Coroutine_Arreter(i);
+    }
+    return nb_reprises;
+}
+
+/*===============================================================================
+  FONCTION      : Coroutine_Preparer_Attente
+  DESCRIPTION   : Enregistre une attente (utilisée par les macros CO_*)
+  PARAMETRES    : Tâche, type d'attente, délai (ms, 0 : pas d'échéance)
+  RETOUR        : rien
+===============================================================================*/
+void Coroutine_Preparer_Attente(Coroutine *co, Coroutine_Attente attente, uint32 delai_ms)
+{
+    co->attente = attente;
+    co->expire = false;
+    co->delai_actif = (attente == ATTENTE_DELAI) || (delai_ms > 0);
+    co->echeance = Scheduler_Millis() + delai_ms;
+}
+
+/*===============================================================================
+  FONCTION      : Coroutine_Attendre_Front
+  DESCRIPTION   : Enregistre l'attente d'un front sur une GPIO (utilisée par CO_ATTENDRE_FRONT)
+  /!\ la fonction d'interruption de la GPIO est remplacée pendant l'attente
+  PARAMETRES    : Tâche, GPIO, type de front, délai maximal (ms, 0 : pas de limite)
+  RETOUR        : rien
+===============================================================================*/
+void Coroutine_Attendre_Front(Coroutine *co, uint8 gpio, GPIO_Interrupt type, uint32 timeout_ms)
+{
+    Coroutine_Preparer_Attente(co,ATTENTE_FRONT,timeout_ms);
+    co->gpio = gpio;
+    co->evenement = false;
+    GPIO_Attacher_Interruption(gpio,type,Interruption_Coroutines_GPIO);
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Coroutines_GPIO
+  DESCRIPTION   : Interruption GPIO : réveille les tâches qui attendent ce front
+  L'interruption de la GPIO est désactivée jusqu'à la prochaine attente
+  PARAMETRES    : N° de la GPIO, état logique de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Coroutines_GPIO(uint8 GPIO, uint8 etat)
+{
+    REGISTRE_CONFIG_ET(Registre_GPIO->PIN[GPIO],~(0x7 << BIT_GPIO_INT_TYPE));
+
+    for (uint8 i = 0; i < NB_COROUTINES; i++)
+    {
+        if (Coroutines[i].attente == ATTENTE_FRONT && Coroutines[i].gpio == GPIO)
+        {
+            Coroutines[i].evenement = true;
+        }
+    }
+}
@@ -0,0 +1,190 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Coroutines.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Tâches coopératives sans pile (type "protothreads") intégrées au scheduler
+ *  Une séquence en plusieurs étapes s'écrit comme une fonction linéaire : elle s'interrompt sur une attente
+ *  (délai, front sur une GPIO, données reçues, condition) et reprend à cet endroit lorsque l'attente est satisfaite.
+ *  Remplace les machines d'état écrites à la main autour de Attente() / Compteur_Virtuel.
+ *
+ *  - Aucune allocation dynamique : les tâches et leur contexte sont pris dans un tableau statique
+ *  - Les variables locales ne sont PAS conservées entre deux attentes : utiliser le contexte (CO_CONTEXTE)
+ *  - Un "switch" ne peut pas englober une macro d'attente (la reprise utilise elle-même un switch)
+ *  - Une seule macro d'attente par ligne (le point de reprise est le numéro de ligne)
+ *
+ *  Exemple :
+ *      void Sequence_Volet(Coroutine *co)
+ *      {
+ *          CO_DEBUT(co);
+ *          GPIO_Write(D1,ETAT_HAUT);
+ *          CO_ATTENDRE_MS(co,1500);
+ *          GPIO_Write(D1,ETAT_BAS);
+ *          CO_ATTENDRE_FRONT(co,D5,FRONT_DESCENDANT,5000);
+ *          if (CO_EXPIRE(co)) UART_WriteString(UART0,"fin de course absente\n");
+ *          CO_FIN(co);
+ *      }
+ *      setup : Coroutine_Demarrer(Sequence_Volet,NULL,0);
+ *      loop  : Scheduler(...); Coroutines_Executer();
+ *
+ *  Lien utile : http://dunkels.com/adam/pt/
+ * =============================================================================================================================================
+ */
+
+#ifndef __COROUTINES_H__
+#define __COROUTINES_H__
+
+// Dépendance(s)
+#include "Scheduler.h"
+#include "GPIO_esp8266.h"
+#include "SoftUART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre de tâches pouvant exister en même temps
+#define NB_COROUTINES 8
+
+// Taille du contexte (variables conservées entre deux attentes) de chaque tâche, en mots de 32 bits
+#define COROUTINE_TAILLE_CONTEXTE 8
+
+// Point de reprise d'une tâche terminée
+#define COROUTINE_TERMINEE 0xFFFF
+
+// Types d'attente
+typedef enum {ATTENTE_AUCUNE,ATTENTE_DELAI,ATTENTE_FRONT,ATTENTE_CONDITION} Coroutine_Attente;
+
+typedef struct Coroutine Coroutine;
+
+// Corps d'une tâche
+typedef void (*Coroutine_Fonction)(Coroutine *co);
+
+// Etat d'une tâche
+struct Coroutine {
+  Coroutine_Fonction fonction;   // NULL : emplacement libre
+  uint16 ligne;                  // point de reprise (0 : début)
+  uint8 attente;                 // type d'attente en cours
+  uint8 gpio;                    // GPIO attendue (ATTENTE_FRONT)
+  bool delai_actif;              // une échéance est associée à l'attente
+  bool expire;                   // la dernière attente s'est terminée par son échéance
+  volatile bool evenement;       // le front attendu est arrivé
+  uint32 echeance;               // échéance (ms, voir Scheduler_Millis)
+  uint32 contexte[COROUTINE_TAILLE_CONTEXTE];
+};
+
+extern Coroutine Coroutines[NB_COROUTINES];
+
+// ##########################################################################################################################
+//                                      MACROS DES TACHES
+// ##########################################################################################################################
+
+// Début et fin du corps d'une tâche
+#define CO_DEBUT(co)            switch ((co)->ligne) { case 0:
+#define CO_FIN(co)              } (co)->ligne = COROUTINE_TERMINEE; return
+
+// Point de reprise (usage interne)
+#define CO_REPRISE(co)          (co)->ligne = __LINE__; return; case __LINE__:
+
+// Rend la main une fois (la tâche reprend au prochain passage de Coroutines_Executer)
+#define CO_PASSER(co)           do { Coroutine_Preparer_Attente((co),ATTENTE_CONDITION,0); CO_REPRISE(co); } while (0)
+
+// Attend tant que la condition est fausse (condition réévaluée à chaque passage)
+#define CO_ATTENDRE_QUE(co,condition) \
+    do { Coroutine_Preparer_Attente((co),ATTENTE_CONDITION,0); CO_REPRISE(co); if (!(condition)) return; (co)->attente = ATTENTE_AUCUNE; } while (0)
+
+// Attend un délai (ms)
+#define CO_ATTENDRE_MS(co,ms)   do { Coroutine_Preparer_Attente((co),ATTENTE_DELAI,(ms)); CO_REPRISE(co); } while (0)
+
+// Attend un front sur une GPIO, au plus "timeout_ms" millisecondes (0 : pas de limite)
+#define CO_ATTENDRE_FRONT(co,gpio,type,timeout_ms) \
+    do { Coroutine_Attendre_Front((co),(gpio),(type),(timeout_ms)); CO_REPRISE(co); } while (0)
+
+// Attend des données sur une UART logicielle (voir SoftUART_Available)
+#define CO_ATTENDRE_SOFTUART(co,n) CO_ATTENDRE_QUE(co,SoftUART_Available(n) > 0)
+
+// Indique si la dernière attente s'est terminée par son échéance
+#define CO_EXPIRE(co)           ((co)->expire)
+
+// Termine la tâche immédiatement
+#define CO_QUITTER(co)          do { (co)->ligne = COROUTINE_TERMINEE; return; } while (0)
+
+// Accès au contexte de la tâche (structure de COROUTINE_TAILLE_CONTEXTE mots au maximum)
+#define CO_CONTEXTE(co,type)    ((type *)(void *)(co)->contexte)
+
+// ##########################################################################################################################
+//                                      FONCTIONS COROUTINES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Coroutines
+  DESCRIPTION   : Libère toutes les tâches
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void init_Coroutines();
+
+/*===============================================================================
+  FONCTION      : Coroutine_Demarrer
+  DESCRIPTION   : Démarre une tâche dans un emplacement libre
+  PARAMETRES    : Corps de la tâche
+                  Contexte initial (ou NULL), taille du contexte (octets)
+  RETOUR        : N° de la tâche, -1 si aucun emplacement n'est libre
+                  ou si le contexte est trop grand
+===============================================================================*/
+int8 Coroutine_Demarrer(Coroutine_Fonction fonction, const void *contexte, uint16 taille);
+
+/*===============================================================================
+  FONCTION      : Coroutine_Arreter
+  DESCRIPTION   : Arrête une tâche et libère son emplacement
+  PARAMETRES    : N° de la tâche
+  RETOUR        : rien
+===============================================================================*/
+void Coroutine_Arreter(int8 numero);
+
+/*===============================================================================
+  FONCTION      : Coroutine_Active
+  DESCRIPTION   : Indique si une tâche est toujours en cours
+  PARAMETRES    : N° de la tâche
+  RETOUR        : true si la tâche n'est pas terminée
+===============================================================================*/
+bool Coroutine_Active(int8 numero);
+
+/*===============================================================================
+  FONCTION      : Coroutines_Executer
+  DESCRIPTION   : Reprend toutes les tâches dont l'attente est satisfaite
+  A appeler dans la boucle principale, après Scheduler()
+  PARAMETRES    : rien
+  RETOUR        : Nombre de tâches reprises
+===============================================================================*/
+uint8 Coroutines_Executer();
+
+/*===============================================================================
+  FONCTION      : Coroutine_Preparer_Attente
+  DESCRIPTION   : Enregistre une attente (utilisée par les macros CO_*)
+  PARAMETRES    : Tâche, type d'attente, délai (ms, 0 : pas d'échéance)
+  RETOUR        : rien
+===============================================================================*/
+void Coroutine_Preparer_Attente(Coroutine *co, Coroutine_Attente attente, uint32 delai_ms);
+
+/*===============================================================================
+  FONCTION      : Coroutine_Attendre_Front
+  DESCRIPTION   : Enregistre l'attente d'un front sur une GPIO (utilisée par CO_ATTENDRE_FRONT)
+  /!\ la fonction d'interruption de la GPIO est remplacée pendant l'attente
+  PARAMETRES    : Tâche, GPIO, type de front, délai maximal (ms, 0 : pas de limite)
+  RETOUR        : rien
+===============================================================================*/
+void Coroutine_Attendre_Front(Coroutine *co, uint8 gpio, GPIO_Interrupt type, uint32 timeout_ms);
+
+/*===============================================================================
+  FONCTION      : Interruption_Coroutines_GPIO
+  DESCRIPTION   : Interruption GPIO : réveille les tâches qui attendent ce front
+  PARAMETRES    : N° de la GPIO, état logique de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Coroutines_GPIO(uint8 GPIO, uint8 etat);
+
+#endif
@@ -0,0 +1,473 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Ecran.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Image en RAM d'un écran SPI avec suivi des zones modifiées et rafraîchissement incrémental
+ *  (voir Ecran.h)
+ * =============================================================================================================================================
+ */
+
+#include "Ecran.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+Ecran_Format ecran_format = ECRAN_MONO;
+uint16 ecran_largeur = 0;
+uint16 ecran_hauteur = 0;
+uint8 *ecran_buffer = NULL;
+
+// Tuiles : taille = 1 << decalage pixels, nombre par rangée et de rangées
+uint8 ecran_decalage = 3;
+uint8 nb_tuiles_x = 0;
+uint8 nb_tuiles_y = 0;
+
+// Tuiles à envoyer : un bit par tuile, un mot par rangée
+uint32 Tuiles_A_Envoyer[ECRAN_NB_TUILES_MAX];
+
+Ecran_Statistiques Statistiques_Ecran;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Ecrire_Pixel
+  DESCRIPTION   : Ecrit un pixel dans l'image (position déjà vérifiée)
+                  et marque sa tuile si la valeur change
+  PARAMETRES    : Position, couleur
+  RETOUR        : rien
+===============================================================================*/
+static inline void Ecrire_Pixel(uint16 x, uint16 y, uint16 couleur)
+{
+    if (ecran_format == ECRAN_MONO)
+    {
+        uint8 *octet = &ecran_buffer[(uint32)(y >> 3) * ecran_largeur + x];
+        uint8 masque = 1 << (y & 7);
+        uint8 valeur = couleur ? (*octet | masque) : (*octet & ~masque);
+        if (valeur != *octet)
+        {
+            *octet = valeur;
+            Tuiles_A_Envoyer[y >> 3] |= (1UL << (x >> 3));
+        }
+    }
+    else
+    {
+        uint8 *pixel = &ecran_buffer[((uint32)y * ecran_largeur + x) * 2];
+        if (pixel[0] != (uint8)(couleur >> 8) || pixel[1] != (uint8)couleur)
+        {
+            pixel[0] = (uint8)(couleur >> 8);
+            pixel[1] = (uint8)couleur;
+            Tuiles_A_Envoyer[y >> 4] |= (1UL << (x >> 4));
+        }
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Zone_Octets
+  DESCRIPTION   : Zone du buffer correspondant à un rectangle de pixels (ordre d'envoi au contrôleur)
+  PARAMETRES    : Rectangle (pixels, dans l'écran), début, octets par ligne, nombre de lignes
+  RETOUR        : rien
+===============================================================================*/
+static void Zone_Octets(uint16 x0, uint16 y0, uint16 x1, uint16 y1, uint8 **debut, uint16 *largeur, uint16 *nb_lignes)
+{
+    if (ecran_format == ECRAN_MONO)
+    {
+        *debut = &ecran_buffer[(uint32)(y0 >> 3) * ecran_largeur + x0];
+        *largeur = x1 - x0 + 1;
+        *nb_lignes = (y1 >> 3) - (y0 >> 3) + 1;
+    }
+    else
+    {
+        *debut = &ecran_buffer[((uint32)y0 * ecran_largeur + x0) * 2];
+        *largeur = (x1 - x0 + 1) * 2;
+        *nb_lignes = y1 - y0 + 1;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Rectangle_Suivant
+  DESCRIPTION   : Regroupe les tuiles à envoyer en rectangle : première suite de tuiles voisines
+                  de la première rangée marquée, étendue aux rangées suivantes qui la contiennent
+  PARAMETRES    : Tuiles du rectangle (colonnes et rangées, bornes incluses)
+  RETOUR        : false si aucune tuile n'est à envoyer
+===============================================================================*/
+static bool Rectangle_Suivant(uint8 *tx0, uint8 *tx1, uint8 *ty0, uint8 *ty1)
+{
+    for (uint8 ty = 0; ty < nb_tuiles_y; ty++)
+    {
+        uint32 tuiles = Tuiles_A_Envoyer[ty];
+        if (tuiles == 0) continue;
+
+        uint8 debut = 0;
+        while (!(tuiles & (1UL << debut))) debut++;
+        uint8 fin = debut;
+        while (fin + 1 < nb_tuiles_x && (tuiles & (1UL << (fin + 1)))) fin++;
+
+        uint32 masque = (fin - debut == 31) ? 0xFFFFFFFF : (((1UL << (fin - debut + 1)) - 1) << debut);
+        uint8 derniere = ty;
+        while (derniere + 1 < nb_tuiles_y && (Tuiles_A_Envoyer[derniere + 1] & masque) == masque) derniere++;
+
+        *tx0 = debut;
+        *tx1 = fin;
+        *ty0 = ty;
+        *ty1 = derniere;
+        return true;
+    }
+    return false;
+}
+
+/*===============================================================================
+  FONCTION      : Envoyer_Rectangle
+  DESCRIPTION   : Place dans la file SPI la fenêtre d'écriture puis les pixels d'un rectangle de tuiles
+                  (la file doit avoir la place nécessaire)
+  PARAMETRES    : Tuiles du rectangle (bornes incluses)
+  RETOUR        : rien
+===============================================================================*/
+static void Envoyer_Rectangle(uint8 tx0, uint8 tx1, uint8 ty0, uint8 ty1)
+{
+    uint16 x0 = (uint16)tx0 << ecran_decalage;
+    uint16 y0 = (uint16)ty0 << ecran_decalage;
+    uint16 x1 = ((uint16)(tx1 + 1) << ecran_decalage) - 1;
+    uint16 y1 = ((uint16)(ty1 + 1) << ecran_decalage) - 1;
+    if (x1 >= ecran_largeur) x1 = ecran_largeur - 1;
+    if (y1 >= ecran_hauteur) y1 = ecran_hauteur - 1;
+
+    uint8 *debut;
+    uint16 largeur, nb_lignes;
+    Zone_Octets(x0,y0,x1,y1,&debut,&largeur,&nb_lignes);
+
+    if (ecran_format == ECRAN_MONO)
+    {
+        // Adressage horizontal : colonnes puis pages, dans l'ordre des lignes du buffer
+        uint8 fenetre[6] = {SSD1306_COLONNES,(uint8)x0,(uint8)x1,SSD1306_PAGES,(uint8)(y0 >> 3),(uint8)(y1 >> 3)};
+        SPI_Ajouter_Commande(0,fenetre,sizeof(fenetre));
+        SPI_Ajouter_Bloc(1,debut,largeur,ecran_largeur,nb_lignes);
+    }
+    else
+    {
+        uint8 commande;
+        uint8 colonnes[4] = {(uint8)(x0 >> 8),(uint8)x0,(uint8)(x1 >> 8),(uint8)x1};
+        uint8 lignes[4] = {(uint8)(y0 >> 8),(uint8)y0,(uint8)(y1 >> 8),(uint8)y1};
+
+        commande = ST7789_CASET;
+        SPI_Ajouter_Commande(0,&commande,1);
+        SPI_Ajouter_Commande(1,colonnes,sizeof(colonnes));
+        commande = ST7789_RASET;
+        SPI_Ajouter_Commande(0,&commande,1);
+        SPI_Ajouter_Commande(1,lignes,sizeof(lignes));
+        commande = ST7789_RAMWR;
+        SPI_Ajouter_Commande(0,&commande,1);
+        SPI_Ajouter_Bloc(1,debut,largeur,ecran_largeur * 2,nb_lignes);
+    }
+
+    Statistiques_Ecran.nb_rectangles++;
+    Statistiques_Ecran.nb_tuiles += (uint32)(tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+    Statistiques_Ecran.octets_pixels += (uint32)largeur * nb_lignes;
+}
+
+// ##########################################################################################################################
+//                                              FONCTIONS ECRAN
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Ecran
+  DESCRIPTION   : Initialise l'image de l'écran (le SPI et le contrôleur doivent déjà être initialisés)
+                  L'image est effacée et entièrement marquée à envoyer
+  PARAMETRES    : Format, largeur, hauteur (pixels), buffer (ECRAN_TAILLE_BUFFER octets)
+  RETOUR        : false si l'écran dépasse ECRAN_NB_TUILES_MAX tuiles en largeur ou en hauteur
+===============================================================================*/
+bool init_Ecran(Ecran_Format format, uint16 largeur, uint16 hauteur, uint8 *buffer)
+{
+    uint8 decalage = (format == ECRAN_MONO) ? 3 : 4;
+    uint16 tuile = (1 << decalage);
+
+    if (buffer == NULL || largeur == 0 || hauteur == 0) return false;
+    if ((largeur + tuile - 1) / tuile > ECRAN_NB_TUILES_MAX || (hauteur + tuile - 1) / tuile > ECRAN_NB_TUILES_MAX) return false;
+
+    ecran_format = format;
+    ecran_largeur = largeur;
+    ecran_hauteur = hauteur;
+    ecran_buffer = buffer;
+    ecran_decalage = decalage;
+    nb_tuiles_x = (largeur + tuile - 1) / tuile;
+    nb_tuiles_y = (hauteur + tuile - 1) / tuile;
+
+    for (uint32 i = 0; i < ECRAN_TAILLE_BUFFER(format,largeur,hauteur); i++) ecran_buffer[i] = 0;
+    Ecran_Tout_Envoyer();
+
+    Statistiques_Ecran.nb_rectangles = 0;
+    Statistiques_Ecran.nb_tuiles = 0;
+    Statistiques_Ecran.octets_pixels = 0;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Pixel
+  DESCRIPTION   : Ecrit un pixel (ignoré hors de l'écran)
+  PARAMETRES    : Position, couleur (ECRAN_NOIR / ECRAN_BLANC ou RGB565)
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Pixel(uint16 x, uint16 y, uint16 couleur)
+{
+    if (x >= ecran_largeur || y >= ecran_hauteur) return;
+    Ecrire_Pixel(x,y,couleur);
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Lire_Pixel
+  DESCRIPTION   : Lit un pixel de l'image
+  PARAMETRES    : Position
+  RETOUR        : Couleur (0 hors de l'écran)
+===============================================================================*/
+uint16 Ecran_Lire_Pixel(uint16 x, uint16 y)
+{
+    if (x >= ecran_largeur || y >= ecran_hauteur) return 0;
+
+    if (ecran_format == ECRAN_MONO)
+    {
+        return (ecran_buffer[(uint32)(y >> 3) * ecran_largeur + x] >> (y & 7)) & 1;
+    }
+    const uint8 *pixel = &ecran_buffer[((uint32)y * ecran_largeur + x) * 2];
+    return ((uint16)pixel[0] << 8) | pixel[1];
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Remplir_Rectangle
+  DESCRIPTION   : Remplit un rectangle (découpé aux bords de l'écran)
+  PARAMETRES    : Coin haut gauche, largeur, hauteur, couleur
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Remplir_Rectangle(uint16 x, uint16 y, uint16 largeur, uint16 hauteur, uint16 couleur)
+{
+    if (x >= ecran_largeur || y >= ecran_hauteur || largeur == 0 || hauteur == 0) return;
+    uint16 x1 = (largeur > ecran_largeur - x) ? ecran_largeur - 1 : x + largeur - 1;
+    uint16 y1 = (hauteur > ecran_hauteur - y) ? ecran_hauteur - 1 : y + hauteur - 1;
+
+    if (ecran_format == ECRAN_MONO)
+    {
+        // Un octet par colonne et par page : les 8 pixels verticaux d'un octet sont écrits ensemble
+        for (uint16 page = y >> 3; page <= (y1 >> 3); page++)
+        {
+            uint8 haut = (page == (y >> 3)) ? (y & 7) : 0;
+            uint8 bas = (page == (y1 >> 3)) ? (y1 & 7) : 7;
+            uint8 masque = (uint8)((0xFF << haut) & (0xFF >> (7 - bas)));
+            uint8 *octet = &ecran_buffer[(uint32)page * ecran_largeur + x];
+
+            for (uint16 colonne = x; colonne <= x1; colonne++, octet++)
+            {
+                uint8 valeur = couleur ? (*octet | masque) : (*octet & ~masque);
+                if (valeur != *octet)
+                {
+                    *octet = valeur;
+                    Tuiles_A_Envoyer[page] |= (1UL << (colonne >> 3));
+                }
+            }
+        }
+    }
+    else
+    {
+        for (uint16 ligne = y; ligne <= y1; ligne++)
+        {
+            for (uint16 colonne = x; colonne <= x1; colonne++) Ecrire_Pixel(colonne,ligne,couleur);
+        }
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Effacer
+  DESCRIPTION   : Remplit tout l'écran
+  PARAMETRES    : Couleur
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Effacer(uint16 couleur)
+{
+    Ecran_Remplir_Rectangle(0,0,ecran_largeur,ecran_hauteur,couleur);
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Dessiner_Bitmap
+  DESCRIPTION   : Dessine une image 1 bit par pixel (icône, caractère) : lignes de (largeur + 7) / 8 octets,
+                  bit de poids fort à gauche
+  PARAMETRES    : Coin haut gauche, largeur, hauteur, image, couleurs des bits à 1 et à 0
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Dessiner_Bitmap(uint16 x, uint16 y, uint16 largeur, uint16 hauteur, const uint8 *bitmap,
+                           uint16 couleur, uint16 fond)
+{
+    uint16 octets_ligne = (largeur + 7) / 8;
+
+    for (uint16 ligne = 0; ligne < hauteur && y + ligne < ecran_hauteur; ligne++)
+    {
+        const uint8 *source = bitmap + (uint32)ligne * octets_ligne;
+        for (uint16 colonne = 0; colonne < largeur && x + colonne < ecran_largeur; colonne++)
+        {
+            bool allume = (source[colonne >> 3] >> (7 - (colonne & 7))) & 1;
+            Ecrire_Pixel(x + colonne,y + ligne,allume ? couleur : fond);
+        }
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Tout_Envoyer
+  DESCRIPTION   : Marque tout l'écran à envoyer (après un reset du contrôleur par exemple)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Tout_Envoyer()
+{
+    uint32 rangee = (nb_tuiles_x == 32) ? 0xFFFFFFFF : ((1UL << nb_tuiles_x) - 1);
+
+    for (uint8 ty = 0; ty < ECRAN_NB_TUILES_MAX; ty++)
+    {
+        Tuiles_A_Envoyer[ty] = (ty < nb_tuiles_y) ? rangee : 0;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Nb_Tuiles_A_Envoyer
+  DESCRIPTION   : Nombre de tuiles modifiées non encore placées dans la file SPI
+  PARAMETRES    : rien
+  RETOUR        : Nombre de tuiles
+===============================================================================*/
+uint16 Ecran_Nb_Tuiles_A_Envoyer()
+{
+    uint16 nombre = 0;
+
+    for (uint8 ty = 0; ty < nb_tuiles_y; ty++)
+    {
+        for (uint32 tuiles = Tuiles_A_Envoyer[ty]; tuiles != 0; tuiles &= tuiles - 1) nombre++;
+    }
+    return nombre;
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Tache
+  DESCRIPTION   : Place dans la file SPI les rectangles modifiés, tant qu'elle a de la place
+                  (tâche de fond : Scheduler_Set_Tache_Fond, ou boucle principale)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des tuiles à envoyer
+===============================================================================*/
+bool Ecran_Tache()
+{
+    uint8 envois = (ecran_format == ECRAN_MONO) ? ECRAN_ENVOIS_MONO : ECRAN_ENVOIS_RGB565;
+    uint8 tx0, tx1, ty0, ty1;
+
+    while (Rectangle_Suivant(&tx0,&tx1,&ty0,&ty1))
+    {
+        if (SPI_Place_File() < envois) return true;
+
+        // Tuiles effacées avant l'envoi : une modification pendant l'envoi les marque de nouveau
+        uint32 masque = (tx1 - tx0 == 31) ? 0xFFFFFFFF : (((1UL << (tx1 - tx0 + 1)) - 1) << tx0);
+        for (uint8 ty = ty0; ty <= ty1; ty++) Tuiles_A_Envoyer[ty] &= ~masque;
+
+        Envoyer_Rectangle(tx0,tx1,ty0,ty1);
+    }
+    return false;
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Compresser_RLE
+  DESCRIPTION   : Compresse (PackBits) les octets d'une zone de l'image, dans l'ordre d'envoi au contrôleur :
+                  octet n de 0 à 127 : n + 1 octets recopiés, octet n de 129 à 255 : octet suivant répété 257 - n fois
+                  En monochrome, la zone est étendue aux pages entières (8 lignes)
+  PARAMETRES    : Zone (pixels), sortie, taille de la sortie
+  RETOUR        : Octets écrits, 0 si la sortie est trop petite
+===============================================================================*/
+uint16 Ecran_Compresser_RLE(uint16 x, uint16 y, uint16 largeur, uint16 hauteur, uint8 *sortie, uint16 taille)
+{
+    if (x >= ecran_largeur || y >= ecran_hauteur || largeur == 0 || hauteur == 0) return 0;
+    uint16 x1 = (largeur > ecran_largeur - x) ? ecran_largeur - 1 : x + largeur - 1;
+    uint16 y1 = (hauteur > ecran_hauteur - y) ? ecran_hauteur - 1 : y + hauteur - 1;
+
+    uint8 *debut;
+    uint16 octets_ligne, nb_lignes;
+    uint16 pas = (ecran_format == ECRAN_MONO) ? ecran_largeur : ecran_largeur * 2;
+    Zone_Octets(x,y,x1,y1,&debut,&octets_ligne,&nb_lignes);
+
+    // Les lignes de la zone sont lues comme une suite continue d'octets
+    uint32 total = (uint32)octets_ligne * nb_lignes;
+    #define OCTET_ZONE(i) (debut[((i) / octets_ligne) * pas + ((i) % octets_ligne)])
+
+    uint32 i = 0;
+    uint16 ecrits = 0;
+    while (i < total)
+    {
+        uint8 valeur = OCTET_ZONE(i);
+        uint16 repetition = 1;
+        while (i + repetition < total && repetition < 128 && OCTET_ZONE(i + repetition) == valeur) repetition++;
+
+        if (repetition >= 3)
+        {
+            if (ecrits + 2 > taille) return 0;
+            sortie[ecrits++] = (uint8)(257 - repetition);
+            sortie[ecrits++] = valeur;
+            i += repetition;
+        }
+        else
+        {
+            // Octets recopiés jusqu'à la prochaine répétition d'au moins 3 octets
+            uint16 nombre = 0;
+            uint16 entete = ecrits++;
+            while (i < total && nombre < 128)
+            {
+                if (i + 2 < total && OCTET_ZONE(i) == OCTET_ZONE(i + 1) && OCTET_ZONE(i) == OCTET_ZONE(i + 2) && nombre > 0) break;
+                if (ecrits >= taille) return 0;
+                sortie[ecrits++] = OCTET_ZONE(i);
+                i++;
+                nombre++;
+            }
+            if (entete >= taille) return 0;
+            sortie[entete] = (uint8)(nombre - 1);
+        }
+    }
+    #undef OCTET_ZONE
+    return ecrits;
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Decompresser_RLE
+  DESCRIPTION   : Décompresse des données PackBits (côté afficheur recopié)
+  PARAMETRES    : Données compressées, taille, sortie, taille de la sortie
+  RETOUR        : Octets écrits, 0 si les données sont invalides ou la sortie trop petite
+===============================================================================*/
+uint16 Ecran_Decompresser_RLE(const uint8 *donnees, uint16 taille, uint8 *sortie, uint16 taille_sortie)
+{
+    uint16 i = 0;
+    uint16 ecrits = 0;
+
+    while (i < taille)
+    {
+        uint8 entete = donnees[i++];
+        if (entete < 128)
+        {
+            uint16 nombre = entete + 1;
+            if (i + nombre > taille || ecrits + nombre > taille_sortie) return 0;
+            while (nombre--) sortie[ecrits++] = donnees[i++];
+        }
+        else if (entete > 128)
+        {
+            uint16 nombre = 257 - entete;
+            if (i >= taille || ecrits + nombre > taille_sortie) return 0;
+            while (nombre--) sortie[ecrits++] = donnees[i];
+            i++;
+        }
+    }
+    return ecrits;
+}
+
+/*===============================================================================
+  FONCTION      : Ecran_Lire_Statistiques
+  DESCRIPTION   : Compteurs des envois
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Ecran_Statistiques *Ecran_Lire_Statistiques()
+{
+    return &Statistiques_Ecran;
+}
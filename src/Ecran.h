@@ -0,0 +1,189 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Ecran.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Image en RAM d'un écran SPI avec suivi des zones modifiées et rafraîchissement incrémental
+ *
+ *  L'écran est découpé en tuiles. Les fonctions de dessin travaillent dans l'image en RAM et ne marquent une tuile
+ *  "à envoyer" que si un pixel change réellement de valeur : redessiner une valeur identique ne coûte aucun envoi.
+ *  Ecran_Tache regroupe les tuiles marquées en rectangles (suites de tuiles voisines sur une rangée, étendues aux
+ *  rangées suivantes qui les contiennent), place pour chacun la fenêtre d'écriture et le bloc de pixels dans la file
+ *  du SPI (voir SPI_esp8266.h) et rend la main : l'envoi se fait sous interruption, sans copie de l'image.
+ *
+ *  Formats :
+ *    - ECRAN_MONO   : 1 bit par pixel, organisation en pages de l'SSD1306 (un octet = 8 pixels verticaux),
+ *                     tuiles de 8 x 8 pixels (8 octets)
+ *    - ECRAN_RGB565 : 16 bits par pixel (ST7789, ILI9341...), octet de poids fort en premier,
+ *                     tuiles de 16 x 16 pixels (512 octets)
+ *
+ *  Le buffer de l'image est fourni par l'application (ECRAN_TAILLE_BUFFER) : 1 Ko pour un SSD1306 128 x 64,
+ *  mais 115 Ko pour un ST7789 240 x 240 en RGB565, qui ne tient pas en RAM : réduire la zone gérée
+ *  (ex : bandeau de 240 x 80) ou passer en monochrome.
+ *
+ *  Une tuile modifiée pendant son envoi est marquée de nouveau et repart au rafraîchissement suivant :
+ *  l'écran finit toujours identique à l'image en RAM.
+ *
+ *  Compression RLE (PackBits) : Ecran_Compresser_RLE exporte une zone de l'image pour la recopier sur un autre
+ *  afficheur par une liaison lente (RS485, MQTT...). Les contrôleurs SSD1306 / ST7789 n'acceptent pas de données
+ *  compressées : l'envoi SPI reste en clair.
+ * =============================================================================================================================================
+ */
+
+#ifndef __ECRAN_H__
+#define __ECRAN_H__
+
+// Dépendances
+#include "SPI_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Format des pixels
+typedef enum {ECRAN_MONO,ECRAN_RGB565} Ecran_Format;
+
+// Taille des tuiles (pixels)
+#define ECRAN_TUILE_MONO   8
+#define ECRAN_TUILE_RGB565 16
+
+// Nombre maximal de tuiles par rangée (un mot de 32 bits par rangée) et de rangées
+#define ECRAN_NB_TUILES_MAX 32
+
+// Taille du buffer de l'image (octets)
+#define ECRAN_TAILLE_BUFFER(format,largeur,hauteur) \
+  (((format) == ECRAN_MONO) ? ((uint32)(largeur) * (((hauteur) + 7) / 8)) : ((uint32)(largeur) * (hauteur) * 2))
+
+// Entrées de file SPI nécessaires à l'envoi d'un rectangle (fenêtre + pixels)
+#define ECRAN_ENVOIS_MONO   2
+#define ECRAN_ENVOIS_RGB565 6
+
+// Commandes des contrôleurs
+#define SSD1306_COLONNES 0x21
+#define SSD1306_PAGES    0x22
+#define ST7789_CASET     0x2A
+#define ST7789_RASET     0x2B
+#define ST7789_RAMWR     0x2C
+
+// Couleurs monochromes
+#define ECRAN_NOIR  0
+#define ECRAN_BLANC 1
+
+// Statistiques
+typedef struct{
+  uint32 nb_rectangles;        // rectangles envoyés
+  uint32 nb_tuiles;            // tuiles envoyées
+  uint32 octets_pixels;        // octets de pixels envoyés (hors commandes de fenêtre)
+} Ecran_Statistiques;
+
+// ##########################################################################################################################
+//                                              FONCTIONS ECRAN
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Ecran
+  DESCRIPTION   : Initialise l'image de l'écran (le SPI et le contrôleur doivent déjà être initialisés)
+                  L'image est effacée et entièrement marquée à envoyer
+  PARAMETRES    : Format, largeur, hauteur (pixels), buffer (ECRAN_TAILLE_BUFFER octets)
+  RETOUR        : false si l'écran dépasse ECRAN_NB_TUILES_MAX tuiles en largeur ou en hauteur
+===============================================================================*/
+bool init_Ecran(Ecran_Format format, uint16 largeur, uint16 hauteur, uint8 *buffer);
+
+/*===============================================================================
+  FONCTION      : Ecran_Pixel
+  DESCRIPTION   : Ecrit un pixel (ignoré hors de l'écran)
+  PARAMETRES    : Position, couleur (ECRAN_NOIR / ECRAN_BLANC ou RGB565)
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Pixel(uint16 x, uint16 y, uint16 couleur);
+
+/*===============================================================================
+  FONCTION      : Ecran_Lire_Pixel
+  DESCRIPTION   : Lit un pixel de l'image
+  PARAMETRES    : Position
+  RETOUR        : Couleur (0 hors de l'écran)
+===============================================================================*/
+uint16 Ecran_Lire_Pixel(uint16 x, uint16 y);
+
+/*===============================================================================
+  FONCTION      : Ecran_Remplir_Rectangle
+  DESCRIPTION   : Remplit un rectangle (découpé aux bords de l'écran)
+  PARAMETRES    : Coin haut gauche, largeur, hauteur, couleur
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Remplir_Rectangle(uint16 x, uint16 y, uint16 largeur, uint16 hauteur, uint16 couleur);
+
+/*===============================================================================
+  FONCTION      : Ecran_Effacer
+  DESCRIPTION   : Remplit tout l'écran
+  PARAMETRES    : Couleur
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Effacer(uint16 couleur);
+
+/*===============================================================================
+  FONCTION      : Ecran_Dessiner_Bitmap
+  DESCRIPTION   : Dessine une image 1 bit par pixel (icône, caractère) : lignes de (largeur + 7) / 8 octets,
+                  bit de poids fort à gauche
+  PARAMETRES    : Coin haut gauche, largeur, hauteur, image, couleurs des bits à 1 et à 0
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Dessiner_Bitmap(uint16 x, uint16 y, uint16 largeur, uint16 hauteur, const uint8 *bitmap,
+                           uint16 couleur, uint16 fond);
+
+/*===============================================================================
+  FONCTION      : Ecran_Tout_Envoyer
+  DESCRIPTION   : Marque tout l'écran à envoyer (après un reset du contrôleur par exemple)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Ecran_Tout_Envoyer();
+
+/*===============================================================================
+  FONCTION      : Ecran_Nb_Tuiles_A_Envoyer
+  DESCRIPTION   : Nombre de tuiles modifiées non encore placées dans la file SPI
+  PARAMETRES    : rien
+  RETOUR        : Nombre de tuiles
+===============================================================================*/
+uint16 Ecran_Nb_Tuiles_A_Envoyer();
+
+/*===============================================================================
+  FONCTION      : Ecran_Tache
+  DESCRIPTION   : Place dans la file SPI les rectangles modifiés, tant qu'elle a de la place
+                  (tâche de fond : Scheduler_Set_Tache_Fond, ou boucle principale)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des tuiles à envoyer
+===============================================================================*/
+bool Ecran_Tache();
+
+/*===============================================================================
+  FONCTION      : Ecran_Compresser_RLE
+  DESCRIPTION   : Compresse (PackBits) les octets d'une zone de l'image, dans l'ordre d'envoi au contrôleur :
+                  octet n de 0 à 127 : n + 1 octets recopiés, octet n de 129 à 255 : octet suivant répété 257 - n fois
+                  En monochrome, la zone est étendue aux pages entières (8 lignes)
+  PARAMETRES    : Zone (pixels), sortie, taille de la sortie
+  RETOUR        : Octets écrits, 0 si la sortie est trop petite
+===============================================================================*/
+uint16 Ecran_Compresser_RLE(uint16 x, uint16 y, uint16 largeur, uint16 hauteur, uint8 *sortie, uint16 taille);
+
+/*===============================================================================
+  FONCTION      : Ecran_Decompresser_RLE
+  DESCRIPTION   : Décompresse des données PackBits (côté afficheur recopié)
+  PARAMETRES    : Données compressées, taille, sortie, taille de la sortie
+  RETOUR        : Octets écrits, 0 si les données sont invalides ou la sortie trop petite
+===============================================================================*/
+uint16 Ecran_Decompresser_RLE(const uint8 *donnees, uint16 taille, uint8 *sortie, uint16 taille_sortie);
+
+/*===============================================================================
+  FONCTION      : Ecran_Lire_Statistiques
+  DESCRIPTION   : Compteurs des envois
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Ecran_Statistiques *Ecran_Lire_Statistiques();
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,342 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Entrees.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Scrutation des entrées des panneaux de commande : codeurs rotatifs en quadrature et claviers matriciels
+ *  (voir Entrees.h)
+ * =============================================================================================================================================
+ */
+
+#include "Entrees.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Décodage de la quadrature : index = (ancien AB << 2) | nouvel AB
+// 00 -> 01 -> 11 -> 10 -> 00 : +1 ; sens inverse : -1 ; pas de changement ou double changement : 0
+static const int8 Table_Quadrature[16] = {
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0
+};
+
+// Codeurs
+typedef struct{
+  uint8 gpio_a;
+  uint8 gpio_b;
+  uint8 etat;                 // ancien état AB
+  volatile int32 position;    // transitions (modifié sous interruption)
+  int32 position_signalee;    // position du dernier évènement
+} Entrees_Codeur;
+
+Entrees_Codeur Codeur[ENTREES_NB_CODEURS];
+uint8 nb_codeurs = 0;
+
+// Codeur associé à chaque GPIO (0xFF : aucun)
+uint8 codeur_GPIO[NB_GPIO_INTERRUPTION] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+
+// Clavier
+uint8 clavier_lignes[ENTREES_NB_LIGNES_MAX];
+uint8 clavier_nb_lignes = 0;
+uint8 clavier_nb_colonnes = 0;
+uint32 clavier_masque_colonnes = 0;      // GPIO de toutes les colonnes
+uint32 clavier_colonne_gpio[ENTREES_NB_COLONNES_MAX];
+uint8 clavier_colonne = 0;              // colonne à l'état bas
+
+// Anti-rebond (bit n : touche n)
+uint32 touches_brutes = 0;              // balayage en cours
+uint32 touches_stables = 0;
+uint32 rebond_compteur_0 = 0;           // compteurs verticaux : bit de poids faible...
+uint32 rebond_compteur_1 = 0;           // ... et bit de poids fort de chaque touche
+
+// File d'évènements
+Entree_Evenement File_Entrees[ENTREES_TAILLE_FILE];
+volatile uint16 file_entrees_ecriture = 0;
+volatile uint16 file_entrees_lecture = 0;
+uint32 evenements_perdus = 0;
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Entrees_Ajouter_Evenement
+  DESCRIPTION   : Place un évènement dans la file (perdu si la file est pleine)
+  PARAMETRES    : Type, source, valeur
+  RETOUR        : rien
+===============================================================================*/
+static void Entrees_Ajouter_Evenement(uint8 type, uint8 source, int16 valeur)
+{
+    if ((uint16)(file_entrees_ecriture - file_entrees_lecture) >= ENTREES_TAILLE_FILE)
+    {
+        evenements_perdus++;
+        return;
+    }
+
+    Entree_Evenement *evenement = &File_Entrees[file_entrees_ecriture & ENTREES_MASQUE_FILE];
+    evenement->type = type;
+    evenement->source = source;
+    evenement->valeur = valeur;
+    file_entrees_ecriture++;
+}
+
+/*===============================================================================
+  FONCTION      : Clavier_Lire_Colonne
+  DESCRIPTION   : Extrait les touches appuyées de la colonne à l'état bas
+  PARAMETRES    : Registre IN
+  RETOUR        : Touches de la colonne (bit n : ligne n)
+===============================================================================*/
+static uint32 Clavier_Lire_Colonne(uint32 etats)
+{
+    uint32 touches = 0;
+
+    // ligne à l'état bas : touche appuyée
+    etats = ~etats;
+    for (uint8 ligne = 0; ligne < clavier_nb_lignes; ligne++)
+    {
+        touches |= ((etats >> clavier_lignes[ligne]) & 1) << ligne;
+    }
+    return touches;
+}
+
+/*===============================================================================
+  FONCTION      : Clavier_Anti_Rebond
+  DESCRIPTION   : Anti-rebond de toutes les touches à la fois (compteurs verticaux) :
+                  le compteur d'une touche avance tant que son état brut diffère de son
+                  état stable, et revient à 0 dès qu'ils sont égaux
+  PARAMETRES    : Etat brut de toutes les touches
+  RETOUR        : Touches ayant changé d'état
+===============================================================================*/
+static uint32 Clavier_Anti_Rebond(uint32 brutes)
+{
+    uint32 difference = brutes ^ touches_stables;
+    uint32 changement;
+
+    // compteur 2 bits : 0 -> 3 -> 2 -> 1 -> 0 (débordement : état validé)
+    rebond_compteur_1 = (rebond_compteur_1 ^ rebond_compteur_0) & difference;
+    rebond_compteur_0 = ~rebond_compteur_0 & difference;
+
+    changement = difference & ~(rebond_compteur_0 | rebond_compteur_1);
+    touches_stables ^= changement;
+    return changement;
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS ENTREES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Entrees_Ajouter_Codeur
+  DESCRIPTION   : Déclare un codeur en quadrature (voies A et B en entrée avec pull-up,
+                  interruption sur les deux fronts)
+  PARAMETRES    : GPIO de la voie A, GPIO de la voie B
+  RETOUR        : N° du codeur, -1 si tous les codeurs sont utilisés
+===============================================================================*/
+int8 Entrees_Ajouter_Codeur(uint8 gpio_a, uint8 gpio_b)
+{
+    if (nb_codeurs >= ENTREES_NB_CODEURS || gpio_a >= NB_GPIO_INTERRUPTION || gpio_b >= NB_GPIO_INTERRUPTION) return -1;
+
+    uint8 codeur = nb_codeurs;
+    uint32 etats;
+
+    // Etape 1 : voies en entrée avec pull-up
+    init_GPIO(gpio_a,GPIO_INPUT);
+    init_GPIO(gpio_b,GPIO_INPUT);
+    REGISTRE_CONFIG_SET_BIT(Registre_IOMUX->GPIO[index_iomux(gpio_a)],BIT_IOMUX_PULLUP);
+    REGISTRE_CONFIG_SET_BIT(Registre_IOMUX->GPIO[index_iomux(gpio_b)],BIT_IOMUX_PULLUP);
+
+    // Etape 2 : état initial
+    etats = REGISTRE_LIRE(Registre_GPIO->IN);
+    Codeur[codeur].gpio_a = gpio_a;
+    Codeur[codeur].gpio_b = gpio_b;
+    Codeur[codeur].etat = (((etats >> gpio_a) & 1) << 1) | ((etats >> gpio_b) & 1);
+    Codeur[codeur].position = 0;
+    Codeur[codeur].position_signalee = 0;
+    codeur_GPIO[gpio_a] = codeur;
+    codeur_GPIO[gpio_b] = codeur;
+    nb_codeurs++;
+
+    // Etape 3 : interruptions
+    GPIO_Attacher_Interruption(gpio_a,FRONT_DOUBLE,Interruption_Codeur);
+    GPIO_Attacher_Interruption(gpio_b,FRONT_DOUBLE,Interruption_Codeur);
+    return codeur;
+}
+
+/*===============================================================================
+  FONCTION      : init_Clavier
+  DESCRIPTION   : Déclare un clavier matriciel
+                  (lignes en entrée avec pull-up, colonnes en sortie drain ouvert)
+  PARAMETRES    : GPIO des lignes, nombre de lignes, GPIO des colonnes, nombre de colonnes
+  RETOUR        : false si le clavier est trop grand
+===============================================================================*/
+bool init_Clavier(const uint8 *gpio_lignes, uint8 nb_lignes, const uint8 *gpio_colonnes, uint8 nb_colonnes)
+{
+    if (nb_lignes > ENTREES_NB_LIGNES_MAX || nb_colonnes > ENTREES_NB_COLONNES_MAX) return false;
+    if ((uint16)nb_lignes * nb_colonnes > ENTREES_NB_TOUCHES_MAX) return false;
+
+    // Etape 1 : lignes en entrée avec pull-up
+    for (uint8 i = 0; i < nb_lignes; i++)
+    {
+        clavier_lignes[i] = gpio_lignes[i];
+        init_GPIO(gpio_lignes[i],GPIO_INPUT);
+        REGISTRE_CONFIG_SET_BIT(Registre_IOMUX->GPIO[index_iomux(gpio_lignes[i])],BIT_IOMUX_PULLUP);
+    }
+
+    // Etape 2 : colonnes en drain ouvert (relâchées), deux touches de colonnes différentes
+    // ne peuvent pas court-circuiter deux sorties
+    clavier_masque_colonnes = 0;
+    for (uint8 i = 0; i < nb_colonnes; i++)
+    {
+        init_GPIO(gpio_colonnes[i],GPIO_OUTPUT);
+        REGISTRE_CONFIG_SET_BIT(Registre_GPIO->PIN[gpio_colonnes[i]],BIT_GPIO_DRIVER);
+        clavier_colonne_gpio[i] = 1UL << gpio_colonnes[i];
+        clavier_masque_colonnes |= clavier_colonne_gpio[i];
+    }
+
+    // Etape 3 : première colonne à l'état bas (lue au prochain appel de Entrees_Tache)
+    touches_brutes = 0;
+    touches_stables = 0;
+    rebond_compteur_0 = 0;
+    rebond_compteur_1 = 0;
+    clavier_colonne = 0;
+    clavier_nb_lignes = nb_lignes;
+    clavier_nb_colonnes = nb_colonnes;
+
+    if (nb_colonnes > 0)
+    {
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,clavier_masque_colonnes & ~clavier_colonne_gpio[0]);
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,clavier_colonne_gpio[0]);
+    }
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Entrees_Tache
+  DESCRIPTION   : Balaye une colonne du clavier, applique l'anti-rebond
+                  et produit les évènements (à appeler toutes les millisecondes)
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void Entrees_Tache()
+{
+    // -------------------------
+    // Clavier : lecture de la colonne à l'état bas (un seul accès au registre IN)
+    // -------------------------
+    if (clavier_nb_colonnes > 0)
+    {
+        uint32 etats = REGISTRE_LIRE(Registre_GPIO->IN);
+
+        touches_brutes |= Clavier_Lire_Colonne(etats) << (clavier_colonne * clavier_nb_lignes);
+
+        // colonne suivante
+        clavier_colonne++;
+        if (clavier_colonne >= clavier_nb_colonnes) clavier_colonne = 0;
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,clavier_masque_colonnes & ~clavier_colonne_gpio[clavier_colonne]);
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,clavier_colonne_gpio[clavier_colonne]);
+
+        // balayage complet : anti-rebond et évènements
+        if (clavier_colonne == 0)
+        {
+            uint32 changement = Clavier_Anti_Rebond(touches_brutes);
+            touches_brutes = 0;
+
+            for (uint8 touche = 0; changement != 0; touche++)
+            {
+                if (!READ_BIT(changement,touche)) continue;
+
+                CLR_BIT(changement,touche);
+                Entrees_Ajouter_Evenement(READ_BIT(touches_stables,touche) ? ENTREE_APPUI : ENTREE_RELACHEMENT,touche,0);
+            }
+        }
+    }
+
+    // -------------------------
+    // Codeurs : un évènement par groupe de crans parcourus depuis le dernier évènement
+    // -------------------------
+    for (uint8 codeur = 0; codeur < nb_codeurs; codeur++)
+    {
+        int32 ecart = Codeur[codeur].position - Codeur[codeur].position_signalee;
+        int32 crans = ecart / ENTREES_TRANSITIONS_PAR_CRAN;
+
+        if (crans == 0) continue;
+        if (crans > 0x7FFF) crans = 0x7FFF;
+        if (crans < -0x7FFF) crans = -0x7FFF;
+
+        Codeur[codeur].position_signalee += crans * ENTREES_TRANSITIONS_PAR_CRAN;
+        Entrees_Ajouter_Evenement(ENTREE_CODEUR,codeur,(int16)crans);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Entrees_Lire_Evenement
+  DESCRIPTION   : Retire le plus ancien évènement de la file
+  PARAMETRES    : Evènement (rempli si la file n'est pas vide)
+  RETOUR        : false si la file est vide
+===============================================================================*/
+bool Entrees_Lire_Evenement(Entree_Evenement *evenement)
+{
+    if (file_entrees_lecture == file_entrees_ecriture) return false;
+
+    *evenement = File_Entrees[file_entrees_lecture & ENTREES_MASQUE_FILE];
+    file_entrees_lecture++;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Entrees_Evenements_Perdus
+  DESCRIPTION   : Nombre d'évènements perdus (file pleine) depuis le démarrage
+  PARAMETRES    : aucun
+  RETOUR        : Nombre d'évènements
+===============================================================================*/
+uint32 Entrees_Evenements_Perdus()
+{
+    return evenements_perdus;
+}
+
+/*===============================================================================
+  FONCTION      : Entrees_Touches
+  DESCRIPTION   : Etat stable (après anti-rebond) de toutes les touches
+  PARAMETRES    : aucun
+  RETOUR        : bit n à 1 : touche n appuyée
+===============================================================================*/
+uint32 Entrees_Touches()
+{
+    return touches_stables;
+}
+
+/*===============================================================================
+  FONCTION      : Entrees_Position_Codeur
+  DESCRIPTION   : Position absolue d'un codeur
+  PARAMETRES    : N° du codeur
+  RETOUR        : Position (transitions de quadrature)
+===============================================================================*/
+int32 Entrees_Position_Codeur(uint8 codeur)
+{
+    return (codeur < nb_codeurs) ? Codeur[codeur].position : 0;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Codeur
+  DESCRIPTION   : Fonction d'interruption des voies A et B des codeurs
+                  (les deux voies sont lues dans le registre IN de l'interruption en cours)
+  PARAMETRES    : N° de la GPIO, état de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Codeur(uint8 GPIO, uint8 etat)
+{
+    uint8 codeur = codeur_GPIO[GPIO];
+    if (codeur >= nb_codeurs) return;
+
+    Entrees_Codeur *c = &Codeur[codeur];
+    uint32 etats = GPIO_Etats_Interruption();
+    uint8 nouvel_etat = (((etats >> c->gpio_a) & 1) << 1) | ((etats >> c->gpio_b) & 1);
+
+    c->position += Table_Quadrature[(c->etat << 2) | nouvel_etat];
+    c->etat = nouvel_etat;
+}
@@ -0,0 +1,135 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Entrees.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Scrutation des entrées des panneaux de commande : codeurs rotatifs en quadrature et claviers matriciels
+ *
+ *  - Codeurs : interruption sur les deux fronts des voies A et B. L'état des deux voies est pris dans le registre IN
+ *    déjà lu par la routine d'interruption GPIO (GPIO_Etats_Interruption), puis décodé par une table de 16 cases
+ *    (ancien état AB, nouvel état AB) -> -1, 0, +1 : les transitions invalides (rebonds) sont ignorées.
+ *  - Clavier : une colonne est mise à l'état bas à chaque appel de Entrees_Tache (sorties en drain ouvert),
+ *    les lignes (entrées avec pull-up) sont lues à l'appel suivant : le registre IN n'est lu qu'une fois par appel
+ *    et les lignes ont une milliseconde pour se stabiliser.
+ *    L'anti-rebond est fait pour toutes les touches à la fois (compteurs verticaux de 2 bits sur des mots de 32 bits) :
+ *    une touche change d'état après ENTREES_ECHANTILLONS_REBOND balayages complets identiques.
+ *  - Les appuis, relâchements et crans des codeurs sont placés dans une file d'évènements lue par l'application.
+ *
+ *  Entrees_Tache est à appeler toutes les millisecondes (Fonction_Task_1ms du Scheduler)
+ * =============================================================================================================================================
+ */
+
+#ifndef __ENTREES_H__
+#define __ENTREES_H__
+
+// Dépendance(s)
+#include "GPIO_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre maximal de codeurs
+#define ENTREES_NB_CODEURS 4
+
+// Nombre de transitions de quadrature par cran du codeur
+#define ENTREES_TRANSITIONS_PAR_CRAN 4
+
+// Taille maximale du clavier (lignes x colonnes <= 32 touches)
+#define ENTREES_NB_LIGNES_MAX   8
+#define ENTREES_NB_COLONNES_MAX 8
+#define ENTREES_NB_TOUCHES_MAX  32
+
+// Nombre de balayages identiques pour valider un changement d'état (compteurs de 2 bits)
+#define ENTREES_ECHANTILLONS_REBOND 4
+
+// File d'évènements (puissance de 2)
+#define ENTREES_TAILLE_FILE 32
+#define ENTREES_MASQUE_FILE (ENTREES_TAILLE_FILE - 1)
+
+// Types d'évènements
+typedef enum {ENTREE_APPUI,ENTREE_RELACHEMENT,ENTREE_CODEUR} Entree_Type;
+
+// Evènement transmis à l'application
+typedef struct{
+  uint8 type;      // Entree_Type
+  uint8 source;    // N° de la touche (colonne x nb_lignes + ligne) ou du codeur
+  int16 valeur;    // Codeur : nombre de crans (signé)
+} Entree_Evenement;
+
+// ##########################################################################################################################
+//                                      FONCTIONS ENTREES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Entrees_Ajouter_Codeur
+  DESCRIPTION   : Déclare un codeur en quadrature (voies A et B en entrée avec pull-up,
+                  interruption sur les deux fronts)
+  PARAMETRES    : GPIO de la voie A, GPIO de la voie B
+  RETOUR        : N° du codeur, -1 si tous les codeurs sont utilisés
+===============================================================================*/
+int8 Entrees_Ajouter_Codeur(uint8 gpio_a, uint8 gpio_b);
+
+/*===============================================================================
+  FONCTION      : init_Clavier
+  DESCRIPTION   : Déclare un clavier matriciel
+                  (lignes en entrée avec pull-up, colonnes en sortie drain ouvert)
+  PARAMETRES    : GPIO des lignes, nombre de lignes, GPIO des colonnes, nombre de colonnes
+  RETOUR        : false si le clavier est trop grand
+===============================================================================*/
+bool init_Clavier(const uint8 *gpio_lignes, uint8 nb_lignes, const uint8 *gpio_colonnes, uint8 nb_colonnes);
+
+/*===============================================================================
+  FONCTION      : Entrees_Tache
+  DESCRIPTION   : Balaye une colonne du clavier, applique l'anti-rebond
+                  et produit les évènements (à appeler toutes les millisecondes)
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void Entrees_Tache();
+
+/*===============================================================================
+  FONCTION      : Entrees_Lire_Evenement
+  DESCRIPTION   : Retire le plus ancien évènement de la file
+  PARAMETRES    : Evènement (rempli si la file n'est pas vide)
+  RETOUR        : false si la file est vide
+===============================================================================*/
+bool Entrees_Lire_Evenement(Entree_Evenement *evenement);
+
+/*===============================================================================
+  FONCTION      : Entrees_Evenements_Perdus
+  DESCRIPTION   : Nombre d'évènements perdus (file pleine) depuis le démarrage
+  PARAMETRES    : aucun
+  RETOUR        : Nombre d'évènements
+===============================================================================*/
+uint32 Entrees_Evenements_Perdus();
+
+/*===============================================================================
+  FONCTION      : Entrees_Touches
+  DESCRIPTION   : Etat stable (après anti-rebond) de toutes les touches
+  PARAMETRES    : aucun
+  RETOUR        : bit n à 1 : touche n appuyée
+===============================================================================*/
+uint32 Entrees_Touches();
+
+/*===============================================================================
+  FONCTION      : Entrees_Position_Codeur
+  DESCRIPTION   : Position absolue d'un codeur
+  PARAMETRES    : N° du codeur
+  RETOUR        : Position (transitions de quadrature)
+===============================================================================*/
+int32 Entrees_Position_Codeur(uint8 codeur);
+
+/*===============================================================================
+  FONCTION      : Interruption_Codeur
+  DESCRIPTION   : Fonction d'interruption des voies A et B des codeurs
+  PARAMETRES    : N° de la GPIO, état de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Codeur(uint8 GPIO, uint8 etat);
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,515 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Filtres.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Filtres de capteurs en virgule fixe (l'ESP8266 n'a pas d'unité flottante : un calcul en float coûte
+ *  plusieurs centaines de cycles). Fichier d'en-tête uniquement : tout est "inline", les tailles de fenêtre
+ *  et les coefficients de lissage sont des paramètres de template connus à la compilation
+ *  (divisions remplacées par des décalages ou des multiplications, boucles déroulées).
+ *
+ *  - Moyenne exponentielle (EMA)        : coefficient 2^-DECALAGE, état en virgule fixe
+ *  - Moyenne glissante                  : somme courante, une addition et une soustraction par échantillon
+ *  - Médiane de 3, 5, 7 ou 9            : réseaux de tri optimaux (nombre minimal de comparaisons)
+ *  - Biquad IIR                         : forme directe I, coefficients Q14, réinjection de l'erreur d'arrondi
+ *  - Seuils à hystérésis
+ *
+ *  Versions "Paire" (SWAR : deux voies de 16 bits dans un mot de 32 bits, une opération pour deux capteurs)
+ *  pour l'EMA, la moyenne glissante, la médiane et l'hystérésis. Les valeurs d'une paire sont non signées
+ *  et limitées à 15 bits (le bit 15 de chaque voie sert de garde), voir Filtre_Paire.
+ *  Le biquad n'a pas de version paire : la multiplication 32 bits ne sépare pas les voies.
+ *
+ *  Exemple :
+ *      Filtre_Moyenne<8> moyenne;           Filtre_Moyenne_Init(&moyenne,0);
+ *      Filtre_Mediane<int16,5> mediane;     Filtre_Mediane_Init(&mediane,0);
+ *      Filtre_EMA_Paire<3,12> ema;          Filtre_EMA_Paire_Init(&ema,Filtre_Paire(0,0));
+ *      tâche 1ms : uint32 paire = Filtre_EMA_Paire_Ajouter(&ema,Filtre_Paire(adc_a,adc_b));
+ *                  uint16 a = Filtre_Voie(paire,0), b = Filtre_Voie(paire,1);
+ * =============================================================================================================================================
+ */
+
+#ifndef __FILTRES_H__
+#define __FILTRES_H__
+
+// Dépendance(s)
+#include "registres_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Virgule fixe de l'état de l'EMA (bits après la virgule)
+#define FILTRE_Q_EMA 14
+
+// Virgule fixe des coefficients du biquad
+#define FILTRE_Q_BIQUAD 14
+
+// Conversion d'un coefficient réel en Q14 (constantes uniquement : évaluée à la compilation)
+#define FILTRE_COEF_Q14(x) ((int16)((x) * 16384.0 + (((x) < 0) ? -0.5 : 0.5)))
+
+// Paires SWAR : bit de garde et bit de poids faible de chaque voie
+#define FILTRE_PAIRE_GARDES 0x80008000UL
+#define FILTRE_PAIRE_UNITES 0x00010001UL
+#define FILTRE_PAIRE_VALEUR_MAX 0x7FFF
+
+// Coefficients d'un biquad : H(z) = (b0 + b1.z^-1 + b2.z^-2) / (1 + a1.z^-1 + a2.z^-2), en Q14 (-2 à +2)
+// L'arrondi des coefficients modifie le gain statique des passe-bas très sélectifs (1.6% à fs/100) :
+// b1 = 16384 + a1 + a2 - b0 - b2 le rend exactement unitaire
+typedef struct{
+  int16 b0;
+  int16 b1;
+  int16 b2;
+  int16 a1;
+  int16 a2;
+} Filtre_Coefficients_Biquad;
+
+// Etat d'un biquad
+typedef struct{
+  const Filtre_Coefficients_Biquad *coef;
+  int16 x1, x2;                // entrées précédentes
+  int16 y1, y2;                // sorties précédentes
+  int32 erreur;                // partie fractionnaire perdue au pas précédent (Q14)
+} Filtre_Biquad;
+
+// Seuils à hystérésis
+typedef struct{
+  int16 seuil_bas;             // retour à l'état bas lorsque la valeur est inférieure ou égale
+  int16 seuil_haut;            // passage à l'état haut lorsque la valeur est supérieure ou égale
+  bool etat;
+} Filtre_Hysteresis;
+
+// Seuils à hystérésis de deux voies (paires de 15 bits, états : 0xFFFF par voie à l'état haut)
+typedef struct{
+  uint32 seuils_bas;
+  uint32 seuils_haut;
+  uint32 etats;
+} Filtre_Hysteresis_Paire;
+
+// Moyenne exponentielle : y += (x - y) / 2^DECALAGE
+template <uint8 DECALAGE> struct Filtre_EMA{
+  static_assert(DECALAGE >= 1 && DECALAGE <= FILTRE_Q_EMA, "DECALAGE : 1 à FILTRE_Q_EMA");
+  int32 etat;                  // Q(FILTRE_Q_EMA)
+};
+
+// Moyenne exponentielle de deux voies de BITS bits : état de chaque voie en Q(16 - BITS)
+template <uint8 DECALAGE, uint8 BITS> struct Filtre_EMA_Paire{
+  static_assert(BITS >= 1 && BITS <= 15, "BITS : 1 à 15");
+  static_assert(DECALAGE >= 1 && DECALAGE <= 16 - BITS, "DECALAGE : 1 à 16 - BITS");
+  uint32 etat;
+};
+
+// Moyenne glissante sur TAILLE échantillons
+template <uint8 TAILLE> struct Filtre_Moyenne{
+  static_assert(TAILLE >= 2, "TAILLE : 2 au minimum");
+  int16 echantillons[TAILLE];
+  int32 somme;
+  uint8 index;
+};
+
+// Moyenne glissante de deux voies de BITS bits (la somme de chaque voie doit tenir sur 16 bits)
+template <uint8 TAILLE, uint8 BITS> struct Filtre_Moyenne_Paire{
+  static_assert(TAILLE >= 2, "TAILLE : 2 au minimum");
+  static_assert(BITS <= 15 && ((uint32)TAILLE << BITS) <= 0x10000UL, "TAILLE x 2^BITS : 65536 au maximum");
+  uint32 echantillons[TAILLE];
+  uint32 somme;
+  uint8 index;
+};
+
+// Médiane glissante sur TAILLE échantillons (3, 5, 7 ou 9) : T = int16, ou uint32 pour une paire
+template <typename T, uint8 TAILLE> struct Filtre_Mediane{
+  static_assert(TAILLE == 3 || TAILLE == 5 || TAILLE == 7 || TAILLE == 9, "TAILLE : 3, 5, 7 ou 9");
+  T echantillons[TAILLE];
+  uint8 index;
+};
+
+// ##########################################################################################################################
+//                                      FONCTIONS PAIRES (SWAR)
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Filtre_Paire
+  DESCRIPTION   : Regroupe deux valeurs de 15 bits au plus dans un mot de 32 bits
+  PARAMETRES    : valeur de la voie 0, valeur de la voie 1 (0 à FILTRE_PAIRE_VALEUR_MAX)
+  RETOUR        : Paire
+===============================================================================*/
+static inline uint32 Filtre_Paire(uint16 voie0, uint16 voie1)
+{
+    return (uint32)voie0 | ((uint32)voie1 << 16);
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Voie
+  DESCRIPTION   : Extrait une voie d'une paire
+  PARAMETRES    : Paire, N° de la voie (0 ou 1)
+  RETOUR        : Valeur de la voie
+===============================================================================*/
+static inline uint16 Filtre_Voie(uint32 paire, uint8 voie)
+{
+    return (uint16)(paire >> (voie << 4));
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Paire_Superieur_Ou_Egal
+  DESCRIPTION   : Comparaison voie par voie, sans branchement
+  (a + 0x8000 - b ne déborde jamais d'une voie : le bit de garde indique a >= b)
+  PARAMETRES    : Paires a et b (voies de 15 bits)
+  RETOUR        : 0xFFFF dans chaque voie où a >= b, 0 sinon
+===============================================================================*/
+static inline uint32 Filtre_Paire_Superieur_Ou_Egal(uint32 a, uint32 b)
+{
+    uint32 gardes = ((a | FILTRE_PAIRE_GARDES) - b) & FILTRE_PAIRE_GARDES;
+    return gardes | (gardes - (gardes >> 15));
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS MEDIANE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Filtre_Trier_2
+  DESCRIPTION   : Elément d'un réseau de tri : a reçoit le minimum, b le maximum
+                  (voie par voie pour une paire)
+  PARAMETRES    : Valeurs a et b
+  RETOUR        : rien
+===============================================================================*/
+static inline void Filtre_Trier_2(int16 &a, int16 &b)
+{
+    int16 min = (a < b) ? a : b;
+    b = (a < b) ? b : a;
+    a = min;
+}
+static inline void Filtre_Trier_2(uint32 &a, uint32 &b)
+{
+    uint32 echange = (a ^ b) & Filtre_Paire_Superieur_Ou_Egal(a,b);
+    a ^= echange;
+    b ^= echange;
+}
+
+// Réseaux de médiane : seules les comparaisons utiles à l'élément central sont faites
+// (3, 7, 13 et 19 comparaisons, d'après "Fast median search", N. Devillard)
+template <typename T, uint8 TAILLE> struct Filtre_Reseau_Mediane;
+
+// Type des échantillons déduit du filtre seul (Filtre_Mediane_Ajouter(&mediane,0) accepté)
+template <typename T> struct Filtre_Type{ typedef T type; };
+
+template <typename T> struct Filtre_Reseau_Mediane<T,3>{
+    static inline T Calculer(T *v)
+    {
+        Filtre_Trier_2(v[0],v[1]); Filtre_Trier_2(v[1],v[2]); Filtre_Trier_2(v[0],v[1]);
+        return v[1];
+    }
+};
+
+template <typename T> struct Filtre_Reseau_Mediane<T,5>{
+    static inline T Calculer(T *v)
+    {
+        Filtre_Trier_2(v[0],v[1]); Filtre_Trier_2(v[3],v[4]); Filtre_Trier_2(v[0],v[3]);
+        Filtre_Trier_2(v[1],v[4]); Filtre_Trier_2(v[1],v[2]); Filtre_Trier_2(v[2],v[3]);
+        Filtre_Trier_2(v[1],v[2]);
+        return v[2];
+    }
+};
+
+template <typename T> struct Filtre_Reseau_Mediane<T,7>{
+    static inline T Calculer(T *v)
+    {
+        Filtre_Trier_2(v[0],v[5]); Filtre_Trier_2(v[0],v[3]); Filtre_Trier_2(v[1],v[6]);
+        Filtre_Trier_2(v[2],v[4]); Filtre_Trier_2(v[0],v[1]); Filtre_Trier_2(v[3],v[5]);
+        Filtre_Trier_2(v[2],v[6]); Filtre_Trier_2(v[2],v[3]); Filtre_Trier_2(v[3],v[6]);
+        Filtre_Trier_2(v[4],v[5]); Filtre_Trier_2(v[1],v[4]); Filtre_Trier_2(v[1],v[3]);
+        Filtre_Trier_2(v[3],v[4]);
+        return v[3];
+    }
+};
+
+template <typename T> struct Filtre_Reseau_Mediane<T,9>{
+    static inline T Calculer(T *v)
+    {
+        Filtre_Trier_2(v[1],v[2]); Filtre_Trier_2(v[4],v[5]); Filtre_Trier_2(v[7],v[8]);
+        Filtre_Trier_2(v[0],v[1]); Filtre_Trier_2(v[3],v[4]); Filtre_Trier_2(v[6],v[7]);
+        Filtre_Trier_2(v[1],v[2]); Filtre_Trier_2(v[4],v[5]); Filtre_Trier_2(v[7],v[8]);
+        Filtre_Trier_2(v[0],v[3]); Filtre_Trier_2(v[5],v[8]); Filtre_Trier_2(v[4],v[7]);
+        Filtre_Trier_2(v[3],v[6]); Filtre_Trier_2(v[1],v[4]); Filtre_Trier_2(v[2],v[5]);
+        Filtre_Trier_2(v[4],v[7]); Filtre_Trier_2(v[4],v[2]); Filtre_Trier_2(v[6],v[4]);
+        Filtre_Trier_2(v[4],v[2]);
+        return v[4];
+    }
+};
+
+/*===============================================================================
+  FONCTION      : Filtre_Mediane_Init
+  DESCRIPTION   : Remplit la fenêtre avec une valeur initiale
+  PARAMETRES    : Filtre, valeur initiale (int16, ou paire)
+  RETOUR        : rien
+===============================================================================*/
+template <typename T, uint8 TAILLE>
+static inline void Filtre_Mediane_Init(Filtre_Mediane<T,TAILLE> *filtre, typename Filtre_Type<T>::type valeur)
+{
+    for (uint8 i = 0; i < TAILLE; i++) filtre->echantillons[i] = valeur;
+    filtre->index = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Mediane_Ajouter
+  DESCRIPTION   : Ajoute un échantillon (remplace le plus ancien) et calcule la médiane
+                  de la fenêtre (réseau de tri appliqué à une copie)
+  PARAMETRES    : Filtre, échantillon (int16, ou paire)
+  RETOUR        : Médiane (voie par voie pour une paire)
+===============================================================================*/
+template <typename T, uint8 TAILLE>
+static inline T Filtre_Mediane_Ajouter(Filtre_Mediane<T,TAILLE> *filtre, typename Filtre_Type<T>::type echantillon)
+{
+    T copie[TAILLE];
+
+    filtre->echantillons[filtre->index] = echantillon;
+    filtre->index = (filtre->index + 1 == TAILLE) ? 0 : filtre->index + 1;
+
+    for (uint8 i = 0; i < TAILLE; i++) copie[i] = filtre->echantillons[i];
+    return Filtre_Reseau_Mediane<T,TAILLE>::Calculer(copie);
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS MOYENNES
+// ##########################################################################################################################
+
+// log2 d'une puissance de 2 (0 sinon) : la division de la moyenne glissante devient un décalage
+constexpr uint8 Filtre_Log2(uint32 n, uint8 log = 0)
+{
+    return (n == 1) ? log : (n & 1) ? 0 : Filtre_Log2(n >> 1, log + 1);
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_EMA_Init
+  DESCRIPTION   : Initialise une moyenne exponentielle
+  PARAMETRES    : Filtre, valeur initiale
+  RETOUR        : rien
+===============================================================================*/
+template <uint8 DECALAGE>
+static inline void Filtre_EMA_Init(Filtre_EMA<DECALAGE> *filtre, int16 valeur)
+{
+    filtre->etat = (int32)valeur << FILTRE_Q_EMA;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_EMA_Ajouter
+  DESCRIPTION   : Ajoute un échantillon : y += (x - y) / 2^DECALAGE
+  PARAMETRES    : Filtre, échantillon
+  RETOUR        : Valeur filtrée (arrondie)
+===============================================================================*/
+template <uint8 DECALAGE>
+static inline int16 Filtre_EMA_Ajouter(Filtre_EMA<DECALAGE> *filtre, int16 echantillon)
+{
+    filtre->etat += (((int32)echantillon << FILTRE_Q_EMA) - filtre->etat) >> DECALAGE;
+    return (int16)((filtre->etat + (1L << (FILTRE_Q_EMA - 1))) >> FILTRE_Q_EMA);
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_EMA_Paire_Init
+  DESCRIPTION   : Initialise une moyenne exponentielle de deux voies
+  PARAMETRES    : Filtre, paire initiale (voies de BITS bits)
+  RETOUR        : rien
+===============================================================================*/
+template <uint8 DECALAGE, uint8 BITS>
+static inline void Filtre_EMA_Paire_Init(Filtre_EMA_Paire<DECALAGE,BITS> *filtre, uint32 paire)
+{
+    filtre->etat = paire << (16 - BITS);
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_EMA_Paire_Ajouter
+  DESCRIPTION   : Ajoute une paire d'échantillons : y = y - y / 2^DECALAGE + x / 2^DECALAGE
+  (chaque terme reste positif et dans sa voie : aucune retenue ne passe d'une voie à l'autre ;
+  la troncature de y / 2^DECALAGE laisse l'état au-dessus de x d'au plus 2^DECALAGE - 1,
+  moins d'une unité après la virgule : la sortie tronquée retrouve exactement x)
+  PARAMETRES    : Filtre, paire d'échantillons (voies de BITS bits)
+  RETOUR        : Paire filtrée
+===============================================================================*/
+template <uint8 DECALAGE, uint8 BITS>
+static inline uint32 Filtre_EMA_Paire_Ajouter(Filtre_EMA_Paire<DECALAGE,BITS> *filtre, uint32 paire)
+{
+    const uint32 masque_decalage = (0xFFFFUL >> DECALAGE) * FILTRE_PAIRE_UNITES;
+    const uint32 masque_sortie = (0xFFFFUL >> (16 - BITS)) * FILTRE_PAIRE_UNITES;
+
+    filtre->etat = filtre->etat - ((filtre->etat >> DECALAGE) & masque_decalage) + (paire << (16 - BITS - DECALAGE));
+    return (filtre->etat >> (16 - BITS)) & masque_sortie;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Moyenne_Init
+  DESCRIPTION   : Remplit la fenêtre d'une moyenne glissante avec une valeur initiale
+  PARAMETRES    : Filtre, valeur initiale
+  RETOUR        : rien
+===============================================================================*/
+template <uint8 TAILLE>
+static inline void Filtre_Moyenne_Init(Filtre_Moyenne<TAILLE> *filtre, int16 valeur)
+{
+    for (uint8 i = 0; i < TAILLE; i++) filtre->echantillons[i] = valeur;
+    filtre->somme = (int32)valeur * TAILLE;
+    filtre->index = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Moyenne_Ajouter
+  DESCRIPTION   : Ajoute un échantillon (remplace le plus ancien dans la somme courante)
+  PARAMETRES    : Filtre, échantillon
+  RETOUR        : Moyenne de la fenêtre (arrondie, division par une constante)
+===============================================================================*/
+template <uint8 TAILLE>
+static inline int16 Filtre_Moyenne_Ajouter(Filtre_Moyenne<TAILLE> *filtre, int16 echantillon)
+{
+    filtre->somme += echantillon - filtre->echantillons[filtre->index];
+    filtre->echantillons[filtre->index] = echantillon;
+    filtre->index = (filtre->index + 1 == TAILLE) ? 0 : filtre->index + 1;
+
+    // Arrondi au plus proche (somme décalée pour rester positive : division entière vers le bas)
+    return (int16)((filtre->somme + (32768L * TAILLE) + TAILLE / 2) / TAILLE - 32768L);
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Moyenne_Paire_Init
+  DESCRIPTION   : Remplit la fenêtre d'une moyenne glissante de deux voies
+  PARAMETRES    : Filtre, paire initiale (voies de BITS bits)
+  RETOUR        : rien
+===============================================================================*/
+template <uint8 TAILLE, uint8 BITS>
+static inline void Filtre_Moyenne_Paire_Init(Filtre_Moyenne_Paire<TAILLE,BITS> *filtre, uint32 paire)
+{
+    for (uint8 i = 0; i < TAILLE; i++) filtre->echantillons[i] = paire;
+    filtre->somme = paire * TAILLE;
+    filtre->index = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Moyenne_Paire_Ajouter
+  DESCRIPTION   : Ajoute une paire d'échantillons
+  (la soustraction de l'ancien échantillon précède l'addition : aucune voie ne passe
+  sous 0 ni au-dessus de TAILLE x 2^BITS, les deux sommes avancent en une opération)
+  PARAMETRES    : Filtre, paire d'échantillons (voies de BITS bits)
+  RETOUR        : Paire des moyennes (tronquées)
+===============================================================================*/
+template <uint8 TAILLE, uint8 BITS>
+static inline uint32 Filtre_Moyenne_Paire_Ajouter(Filtre_Moyenne_Paire<TAILLE,BITS> *filtre, uint32 paire)
+{
+    filtre->somme = filtre->somme - filtre->echantillons[filtre->index] + paire;
+    filtre->echantillons[filtre->index] = paire;
+    filtre->index = (filtre->index + 1 == TAILLE) ? 0 : filtre->index + 1;
+
+    // Taille puissance de 2 : un décalage pour les deux voies, sinon une division par voie
+    if (Filtre_Log2(TAILLE) != 0)
+    {
+        return (filtre->somme >> Filtre_Log2(TAILLE)) & ((0xFFFFUL >> Filtre_Log2(TAILLE)) * FILTRE_PAIRE_UNITES);
+    }
+    return Filtre_Paire((uint16)(filtre->somme & 0xFFFF) / TAILLE, (uint16)(filtre->somme >> 16) / TAILLE);
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS BIQUAD
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Filtre_Biquad_Init
+  DESCRIPTION   : Initialise un biquad en régime établi sur une valeur
+                  (exact pour un filtre de gain statique unitaire : passe-bas)
+  PARAMETRES    : Filtre, coefficients (conservés par pointeur), valeur initiale
+  RETOUR        : rien
+===============================================================================*/
+static inline void Filtre_Biquad_Init(Filtre_Biquad *filtre, const Filtre_Coefficients_Biquad *coef, int16 valeur)
+{
+    filtre->coef = coef;
+    filtre->x1 = filtre->x2 = valeur;
+    filtre->y1 = filtre->y2 = valeur;
+    filtre->erreur = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Biquad_Ajouter
+  DESCRIPTION   : Ajoute un échantillon (forme directe I, 5 multiplications 16 x 16 bits)
+  La somme est faite modulo 2^32 : les dépassements intermédiaires se compensent, seul le
+  résultat final doit tenir sur 32 bits. La partie fractionnaire perdue est réinjectée
+  au pas suivant (pas de biais ni de cycle limite en régime établi)
+  PARAMETRES    : Filtre, échantillon
+  RETOUR        : Valeur filtrée (saturée sur 16 bits)
+===============================================================================*/
+static inline int16 Filtre_Biquad_Ajouter(Filtre_Biquad *filtre, int16 echantillon)
+{
+    const Filtre_Coefficients_Biquad *c = filtre->coef;
+    uint32 somme = (uint32)filtre->erreur
+                 + (uint32)((int32)c->b0 * echantillon)
+                 + (uint32)((int32)c->b1 * filtre->x1)
+                 + (uint32)((int32)c->b2 * filtre->x2)
+                 - (uint32)((int32)c->a1 * filtre->y1)
+                 - (uint32)((int32)c->a2 * filtre->y2);
+    int32 resultat = (int32)somme >> FILTRE_Q_BIQUAD;
+
+    filtre->erreur = (int32)(somme & ((1UL << FILTRE_Q_BIQUAD) - 1));
+    if (resultat > 32767) resultat = 32767;
+    if (resultat < -32768) resultat = -32768;
+
+    filtre->x2 = filtre->x1;
+    filtre->x1 = echantillon;
+    filtre->y2 = filtre->y1;
+    filtre->y1 = (int16)resultat;
+    return (int16)resultat;
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS HYSTERESIS
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Filtre_Hysteresis_Init
+  DESCRIPTION   : Initialise des seuils à hystérésis
+  PARAMETRES    : Filtre, seuil bas, seuil haut, état initial
+  RETOUR        : rien
+===============================================================================*/
+static inline void Filtre_Hysteresis_Init(Filtre_Hysteresis *filtre, int16 seuil_bas, int16 seuil_haut, bool etat)
+{
+    filtre->seuil_bas = seuil_bas;
+    filtre->seuil_haut = seuil_haut;
+    filtre->etat = etat;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Hysteresis_Ajouter
+  DESCRIPTION   : Compare une valeur aux seuils
+  PARAMETRES    : Filtre, valeur
+  RETOUR        : Etat (true : haut)
+===============================================================================*/
+static inline bool Filtre_Hysteresis_Ajouter(Filtre_Hysteresis *filtre, int16 valeur)
+{
+    if (valeur >= filtre->seuil_haut) filtre->etat = true;
+    else if (valeur <= filtre->seuil_bas) filtre->etat = false;
+    return filtre->etat;
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Hysteresis_Paire_Init
+  DESCRIPTION   : Initialise des seuils à hystérésis pour deux voies
+  PARAMETRES    : Filtre, paires des seuils bas et haut, états initiaux (bit n : voie n)
+  RETOUR        : rien
+===============================================================================*/
+static inline void Filtre_Hysteresis_Paire_Init(Filtre_Hysteresis_Paire *filtre, uint32 seuils_bas, uint32 seuils_haut, uint8 etats)
+{
+    filtre->seuils_bas = seuils_bas;
+    filtre->seuils_haut = seuils_haut;
+    filtre->etats = Filtre_Paire((etats & 1) ? 0xFFFF : 0, (etats & 2) ? 0xFFFF : 0);
+}
+
+/*===============================================================================
+  FONCTION      : Filtre_Hysteresis_Paire_Ajouter
+  DESCRIPTION   : Compare une paire de valeurs aux seuils (deux comparaisons SWAR)
+  PARAMETRES    : Filtre, paire de valeurs
+  RETOUR        : Etats (bit n : voie n à l'état haut)
+===============================================================================*/
+static inline uint8 Filtre_Hysteresis_Paire_Ajouter(Filtre_Hysteresis_Paire *filtre, uint32 paire)
+{
+    filtre->etats = (filtre->etats & ~Filtre_Paire_Superieur_Ou_Egal(filtre->seuils_bas,paire)) |
+                    Filtre_Paire_Superieur_Ou_Egal(paire,filtre->seuils_haut);
+    return (uint8)((filtre->etats & 1) | ((filtre->etats >> 15) & 2));
+}
+
+/* fin du fichier */
+#endif
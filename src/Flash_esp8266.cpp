@@ -0,0 +1,81 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Flash_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Accès à la mémoire flash SPI de l'ESP8266 (lecture, écriture, effacement de secteurs)
+ * =============================================================================================================================================
+ */
+
+#include "Flash_esp8266.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// CRC 32 bits calculé par quartet (table de 16 valeurs)
+const uint32 Table_CRC32[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// ##########################################################################################################################
+//                                      FONCTIONS FLASH
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Flash_Lire
+  DESCRIPTION   : Lit une zone de la flash
+  PARAMETRES    : Adresse (alignée), buffer (aligné), taille (multiple de 4)
+  RETOUR        : false en cas d'erreur
+===============================================================================*/
+bool Flash_Lire(uint32 adresse, void *buffer, uint32 taille)
+{
+    return spi_flash_read(adresse,(uint32 *)buffer,taille) == SPI_FLASH_RESULT_OK;
+}
+
+/*===============================================================================
+  FONCTION      : Flash_Ecrire
+  DESCRIPTION   : Ecrit une zone de la flash (préalablement effacée)
+  PARAMETRES    : Adresse (alignée), buffer (aligné), taille (multiple de 4)
+  RETOUR        : false en cas d'erreur
+===============================================================================*/
+bool Flash_Ecrire(uint32 adresse, const void *buffer, uint32 taille)
+{
+    return spi_flash_write(adresse,(uint32 *)buffer,taille) == SPI_FLASH_RESULT_OK;
+}
+
+/*===============================================================================
+  FONCTION      : Flash_Effacer_Secteur
+  DESCRIPTION   : Efface un secteur (tous les octets à 0xFF)
+  /!\ bloquant : plusieurs dizaines de ms
+  PARAMETRES    : N° du secteur (adresse / FLASH_TAILLE_SECTEUR)
+  RETOUR        : false en cas d'erreur
+===============================================================================*/
+bool Flash_Effacer_Secteur(uint16 secteur)
+{
+    return spi_flash_erase_sector(secteur) == SPI_FLASH_RESULT_OK;
+}
+
+/*===============================================================================
+  FONCTION      : Flash_CRC32
+  DESCRIPTION   : Calcule (ou poursuit) un CRC 32 bits (polynôme 0xEDB88320, celui de zlib)
+  Usage : crc = FLASH_CRC32_INIT ; crc = Flash_CRC32(crc,...) ... ; resultat = ~crc
+  PARAMETRES    : CRC en cours, données, nombre d'octets
+  RETOUR        : CRC en cours (à inverser en fin de calcul)
+===============================================================================*/
+uint32 Flash_CRC32(uint32 crc, const void *donnees, uint32 taille)
+{
+    const uint8 *octets = (const uint8 *)donnees;
+
+    while (taille--)
+    {
+        crc ^= *octets++;
+        crc = (crc >> 4) ^ Table_CRC32[crc & 0x0F];
+        crc = (crc >> 4) ^ Table_CRC32[crc & 0x0F];
+    }
+    return crc;
+}
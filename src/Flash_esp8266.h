@@ -0,0 +1,80 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Flash_esp8266.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Accès à la mémoire flash SPI de l'ESP8266 (lecture, écriture, effacement de secteurs)
+ *
+ *  Le contrôleur flash (ADDR_SPIO0) est aussi celui qui alimente le cache d'instructions :
+ *  le programmer directement planterait le processeur dès qu'une instruction hors IRAM est exécutée.
+ *  Les accès passent donc par les routines de la ROM / du SDK, qui suspendent le cache pendant l'opération.
+ *
+ *  Rappels sur la flash :
+ *  - une écriture ne peut que passer des bits de 1 à 0 : il faut effacer (tout à 1) avant de réécrire
+ *  - l'effacement se fait par secteur de 4 Ko et dure plusieurs dizaines de ms
+ *  - adresses, tailles et buffers doivent être alignés sur 4 octets
+ * =============================================================================================================================================
+ */
+
+#ifndef __FLASH_ESP8266_H__
+#define __FLASH_ESP8266_H__
+
+// Dépendances
+#include "registres_esp8266.h"
+#include "spi_flash.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Taille d'un secteur (octets)
+#define FLASH_TAILLE_SECTEUR 4096
+
+// Valeur initiale du CRC 32 bits
+#define FLASH_CRC32_INIT 0xFFFFFFFF
+
+// Arrondi d'une taille à l'alignement de la flash
+#define FLASH_ALIGNER(taille) (((taille) + 3) & ~3)
+
+// ##########################################################################################################################
+//                                      FONCTIONS FLASH
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Flash_Lire
+  DESCRIPTION   : Lit une zone de la flash
+  PARAMETRES    : Adresse (alignée), buffer (aligné), taille (multiple de 4)
+  RETOUR        : false en cas d'erreur
+===============================================================================*/
+bool Flash_Lire(uint32 adresse, void *buffer, uint32 taille);
+
+/*===============================================================================
+  FONCTION      : Flash_Ecrire
+  DESCRIPTION   : Ecrit une zone de la flash (préalablement effacée)
+  PARAMETRES    : Adresse (alignée), buffer (aligné), taille (multiple de 4)
+  RETOUR        : false en cas d'erreur
+===============================================================================*/
+bool Flash_Ecrire(uint32 adresse, const void *buffer, uint32 taille);
+
+/*===============================================================================
+  FONCTION      : Flash_Effacer_Secteur
+  DESCRIPTION   : Efface un secteur (tous les octets à 0xFF)
+  /!\ bloquant : plusieurs dizaines de ms
+  PARAMETRES    : N° du secteur (adresse / FLASH_TAILLE_SECTEUR)
+  RETOUR        : false en cas d'erreur
+===============================================================================*/
+bool Flash_Effacer_Secteur(uint16 secteur);
+
+/*===============================================================================
+  FONCTION      : Flash_CRC32
+  DESCRIPTION   : Calcule (ou poursuit) un CRC 32 bits (polynôme 0xEDB88320, celui de zlib)
+  Usage : crc = FLASH_CRC32_INIT ; crc = Flash_CRC32(crc,...) ... ; resultat = ~crc
+  PARAMETRES    : CRC en cours, données, nombre d'octets
+  RETOUR        : CRC en cours (à inverser en fin de calcul)
+===============================================================================*/
+uint32 Flash_CRC32(uint32 crc, const void *donnees, uint32 taille);
+
+#endif
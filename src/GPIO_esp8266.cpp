@@ -1,133 +1,238 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : GPIO_esp8266.cpp
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Ensemble des définitions nécessaires pour manipuler les GPIO des ESP8266
- * 
- *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
- * =============================================================================================================================================
- */
-
-// Librairies
-#include "GPIO_esp8266.h"
-#include "registres_esp8266.h"
-
-/*===============================================================================
-  FONCTION      : Choix_fonction_GPIO
-  DESCRIPTION   : Permet de choisir la fonction à appliquer à une GPIO
-                  (Voir fichier ESP8266_Pin_List.xlsx pour plus de détails)
-  PARAMETRES    : N° de la GPIO concernée, numéro de fonction voulue
-  RETOUR        : rien   
-===============================================================================*/
-void Choix_fonction_GPIO(uint8 GPIO, uint8 fonction)
-{
-    if (fonction >= GPIO_FONCTION_1 && fonction <= GPIO_FONCTION_5)
-    {
-        Set_buffer_to_Registre(&Registre_IOMUX->GPIO[index_iomux(GPIO)],BIT_IOMUX_FUNCTION,fonction,3);
-    }
-}
-
-
-
-/*===============================================================================
-  FONCTION      : init_GPIO
-  DESCRIPTION   : Initialise une GPIO en entrée ou sortie numérique
-  PARAMETRES    : N° de la GPIO concernée, type voulu (entrée ou sortie)
-  RETOUR        : rien   
-===============================================================================*/
-void init_GPIO(uint8 GPIO, uint8 type_GPIO)
-{
-    // Etape 1 : on choisi la fonction GPIO (voir document ESP8266_Pin_List.xlsx)
-    if (GPIO == 0 || GPIO == 2 || GPIO == 4 || GPIO == 5)
-    {
-        Choix_fonction_GPIO(GPIO,GPIO_FONCTION_1);
-    }
-    else
-    {
-        Choix_fonction_GPIO(GPIO,GPIO_FONCTION_4);
-    }
-    
-    // Etape 2 : On détermine le type de la GPIO (entrée ou sortie)
-    switch (type_GPIO)
-    {
-        // Entrée numérique
-        case GPIO_INPUT :
-            SET_BIT(Registre_GPIO->ENABLE_W1TC,GPIO);
-        break;
-
-        // Sortie numérique
-        case GPIO_OUTPUT :
-            CLR_BIT(Registre_GPIO->PIN[GPIO],BIT_GPIO_DRIVER); // On ferme le drain
-            SET_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO)] ,BIT_IOMUX_PULLUP); // on active le pull-up
-            SET_BIT(Registre_GPIO->ENABLE_W1TS,GPIO); // on active la gpio en sortie
-            SET_BIT(Registre_GPIO->OUT_W1TC,GPIO); // Valeur par défaut de la sortie
-        break;
-
-        // Par défaut, la GPIO est une entrée
-        default : 
-            CLR_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO)],BIT_IOMUX_PULLUP); // on désactive le pull-up
-            SET_BIT(Registre_GPIO->ENABLE_W1TC,GPIO); // on désactive la gpio en sortie
-        break;
-    }
-}
-
-/*===============================================================================
-  FONCTION      : GPIO_Write
-  DESCRIPTION   : Affecte un état logique à une sortie numérique
-  PARAMETRES    : N° de la GPIO concernée, etat logique voulu
-  RETOUR        : rien   
-===============================================================================*/
-void GPIO_Write(uint8 GPIO, bool etat)
-{
-    
-    SET_BIT(Registre_GPIO->ENABLE_W1TS,GPIO);
-    
-    if (etat == ETAT_HAUT)
-    {
-		SET_BIT(Registre_GPIO->OUT_W1TS,GPIO);
-	}
-    else
-    {
-		SET_BIT(Registre_GPIO->OUT_W1TC,GPIO);
-	}
-}
-
-/*===============================================================================
-  FONCTION      : GPIO_Toggle
-  DESCRIPTION   : Inverse l'état logique d'une sortie numérique
-  PARAMETRES    : N° de la GPIO concerné
-  RETOUR        : rien
-===============================================================================*/
-void GPIO_Toggle(uint8 GPIO)
-{
-    GPIO_Write(GPIO, 1 - READ_BIT(Registre_GPIO->IN,GPIO));
-}
-
-
-/*===============================================================================
-  FONCTION      : GPIO_Read
-  DESCRIPTION   : Lit l'état logique d'une GPIO
-  PARAMETRES    : N° de la GPIO concerné
-  RETOUR        : Etat logique de la GPIO
-===============================================================================*/
-uint8 GPIO_Read(uint8 GPIO)
-{
-    return READ_BIT(Registre_GPIO->IN,GPIO);
-}
-
-
-/*===============================================================================
-  FONCTION      : Set_GPIO_Interrupt
-  DESCRIPTION   : Permet de définir une interruption sur une GPIO
-  PARAMETRES    : N° de la GPIO concerné, type d'interruption voulue
-  (Aucune, Front montant, Front descendant , Double front, 'Low level', 'High level')
-  RETOUR        : rien
-===============================================================================*/
-void Set_GPIO_Interrupt(uint8 GPIO, GPIO_Interrupt type_interruption)
-{
-    Set_buffer_to_Registre(&Registre_GPIO->PIN[GPIO],BIT_GPIO_INT_TYPE,type_interruption,3);
-}
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : GPIO_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Ensemble des définitions nécessaires pour manipuler les GPIO des ESP8266
+ * 
+ *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
+ * =============================================================================================================================================
+ */
+
+// Librairies
+#include "GPIO_esp8266.h"
+#include "registres_esp8266.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Fonctions associées aux interruptions des GPIO
+GPIO_Callback Callback_GPIO[NB_GPIO_INTERRUPTION];
+
+// Indique si la routine d'interruption commune a déjà été attachée
+bool flag_interruption_GPIO = false;
+
+// Registre IN lu par la dernière interruption GPIO
+volatile uint32 etats_interruption_GPIO = 0;
+
+/*===============================================================================
+  FONCTION      : Choix_fonction_GPIO
+  DESCRIPTION   : Permet de choisir la fonction à appliquer à une GPIO
+                  (Voir fichier ESP8266_Pin_List.xlsx pour plus de détails)
+  PARAMETRES    : N° de la GPIO concernée, numéro de fonction voulue
+  RETOUR        : rien   
+===============================================================================*/
+void Choix_fonction_GPIO(uint8 GPIO, uint8 fonction)
+{
+    if (fonction >= GPIO_FONCTION_1 && fonction <= GPIO_FONCTION_5)
+    {
+        // Le numéro de fonction n'est pas contigu dans le registre : bits [5:4] et [8]
+        uint32 valeur = REGISTRE_CONFIG_LIRE(Registre_IOMUX->GPIO[index_iomux(GPIO)]);
+        valeur &= ~IOMUX_FONCTION(0x7);
+        REGISTRE_CONFIG_ECRIRE(Registre_IOMUX->GPIO[index_iomux(GPIO)],valeur | IOMUX_FONCTION(fonction));
+    }
+}
+
+
+
+/*===============================================================================
+  FONCTION      : init_GPIO
+  DESCRIPTION   : Initialise une GPIO en entrée ou sortie numérique
+  PARAMETRES    : N° de la GPIO concernée, type voulu (entrée ou sortie)
+  RETOUR        : rien   
+===============================================================================*/
+void init_GPIO(uint8 GPIO, uint8 type_GPIO)
+{
+    // Etape 1 : on choisi la fonction GPIO (voir document ESP8266_Pin_List.xlsx)
+    if (GPIO == 0 || GPIO == 2 || GPIO == 4 || GPIO == 5)
+    {
+        Choix_fonction_GPIO(GPIO,GPIO_FONCTION_1);
+    }
+    else
+    {
+        Choix_fonction_GPIO(GPIO,GPIO_FONCTION_4);
+    }
+    
+    // Etape 2 : On détermine le type de la GPIO (entrée ou sortie)
+    switch (type_GPIO)
+    {
+        // Entrée numérique
+        case GPIO_INPUT :
+            REGISTRE_ECRIRE(Registre_GPIO->ENABLE_W1TC,(1 << GPIO));
+        break;
+
+        // Sortie numérique
+        case GPIO_OUTPUT :
+            REGISTRE_CONFIG_CLR_BIT(Registre_GPIO->PIN[GPIO],BIT_GPIO_DRIVER); // On ferme le drain
+            REGISTRE_CONFIG_SET_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO)] ,BIT_IOMUX_PULLUP); // on active le pull-up
+            REGISTRE_ECRIRE(Registre_GPIO->ENABLE_W1TS,(1 << GPIO)); // on active la gpio en sortie
+            REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,(1 << GPIO)); // Valeur par défaut de la sortie
+        break;
+
+        // Par défaut, la GPIO est une entrée
+        default : 
+            REGISTRE_CONFIG_CLR_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO)],BIT_IOMUX_PULLUP); // on désactive le pull-up
+            REGISTRE_ECRIRE(Registre_GPIO->ENABLE_W1TC,(1 << GPIO)); // on désactive la gpio en sortie
+        break;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : GPIO_Write
+  DESCRIPTION   : Affecte un état logique à une sortie numérique
+  PARAMETRES    : N° de la GPIO concernée, etat logique voulu
+  RETOUR        : rien   
+===============================================================================*/
+void GPIO_Write(uint8 GPIO, bool etat)
+{
+    
+    REGISTRE_ECRIRE(Registre_GPIO->ENABLE_W1TS,(1 << GPIO));
+    
+    if (etat == ETAT_HAUT)
+    {
+		REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,(1 << GPIO));
+	}
+    else
+    {
+		REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,(1 << GPIO));
+	}
+}
+
+/*===============================================================================
+  FONCTION      : GPIO_Toggle
+  DESCRIPTION   : Inverse l'état logique d'une sortie numérique
+  PARAMETRES    : N° de la GPIO concerné
+  RETOUR        : rien
+===============================================================================*/
+void GPIO_Toggle(uint8 GPIO)
+{
+    GPIO_Write(GPIO, 1 - REGISTRE_READ_BIT(Registre_GPIO->IN,GPIO));
+}
+
+
+/*===============================================================================
+  FONCTION      : GPIO_Read
+  DESCRIPTION   : Lit l'état logique d'une GPIO
+  PARAMETRES    : N° de la GPIO concerné
+  RETOUR        : Etat logique de la GPIO
+===============================================================================*/
+uint8 GPIO_Read(uint8 GPIO)
+{
+    return REGISTRE_READ_BIT(Registre_GPIO->IN,GPIO);
+}
+
+
+/*===============================================================================
+  FONCTION      : Set_GPIO_Interrupt
+  DESCRIPTION   : Permet de définir une interruption sur une GPIO
+  PARAMETRES    : N° de la GPIO concerné, type d'interruption voulue
+  (Aucune, Front montant, Front descendant , Double front, 'Low level', 'High level')
+  RETOUR        : rien
+===============================================================================*/
+void Set_GPIO_Interrupt(uint8 GPIO, GPIO_Interrupt type_interruption)
+{
+    Set_buffer_to_Registre(&Registre_GPIO->PIN[GPIO],BIT_GPIO_INT_TYPE,type_interruption,3);
+}
+
+
+/*===============================================================================
+  FONCTION      : GPIO_Attacher_Interruption
+  DESCRIPTION   : Associe une fonction à l'interruption d'une GPIO
+  (la routine d'interruption GPIO est commune à toutes les GPIO : 
+  elle acquitte les interruptions et appelle la fonction de chaque GPIO concernée)
+  PARAMETRES    : N° de la GPIO concernée, type d'interruption voulue,
+                  fonction à appeler (exécutée sous interruption : ICACHE_RAM_ATTR)
+  RETOUR        : rien
+===============================================================================*/
+void GPIO_Attacher_Interruption(uint8 GPIO, GPIO_Interrupt type_interruption, GPIO_Callback fonction)
+{
+    if (GPIO >= NB_GPIO_INTERRUPTION) return;
+
+    ETS_GPIO_INTR_DISABLE();
+
+    // La routine commune n'est attachée qu'une seule fois
+    if (!flag_interruption_GPIO)
+    {
+        ETS_GPIO_INTR_ATTACH(Interruption_GPIO,NULL);
+        flag_interruption_GPIO = true;
+    }
+
+    Callback_GPIO[GPIO] = fonction;
+    REGISTRE_ECRIRE(Registre_GPIO->STATUS_W1TC,(1 << GPIO)); // on acquitte une éventuelle interruption en attente
+    Set_GPIO_Interrupt(GPIO,type_interruption);
+
+    ETS_GPIO_INTR_ENABLE();
+}
+
+/*===============================================================================
+  FONCTION      : GPIO_Detacher_Interruption
+  DESCRIPTION   : Désactive l'interruption d'une GPIO et retire la fonction associée
+  PARAMETRES    : N° de la GPIO concernée
+  RETOUR        : rien
+===============================================================================*/
+void GPIO_Detacher_Interruption(uint8 GPIO)
+{
+    if (GPIO >= NB_GPIO_INTERRUPTION) return;
+
+    ETS_GPIO_INTR_DISABLE();
+    Set_GPIO_Interrupt(GPIO,INACTIF);
+    Callback_GPIO[GPIO] = NULL;
+    ETS_GPIO_INTR_ENABLE();
+}
+
+/*===============================================================================
+  FONCTION      : GPIO_Etats_Interruption
+  DESCRIPTION   : Etat de toutes les GPIO lu par la routine d'interruption en cours
+                  (permet à une fonction d'interruption de lire d'autres GPIO
+                  sans relire le registre IN)
+  PARAMETRES    : aucun
+  RETOUR        : Registre IN (bit n : GPIOn)
+===============================================================================*/
+uint32 ICACHE_RAM_ATTR GPIO_Etats_Interruption()
+{
+    return etats_interruption_GPIO;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_GPIO
+  DESCRIPTION   : Routine d'interruption commune à toutes les GPIO
+  Le registre STATUS et le registre IN ne sont lus qu'une seule fois par interruption
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_GPIO()
+{
+    uint32 statut = REGISTRE_LIRE(Registre_GPIO->STATUS);
+    uint32 etats  = REGISTRE_LIRE(Registre_GPIO->IN);
+
+    etats_interruption_GPIO = etats;
+
+    // acquittement de toutes les interruptions traitées (écriture directe)
+    REGISTRE_ECRIRE(Registre_GPIO->STATUS_W1TC,statut);
+
+    for (uint8 gpio = 0; statut != 0 && gpio < NB_GPIO_INTERRUPTION; gpio++)
+    {
+        if (READ_BIT(statut,gpio))
+        {
+            CLR_BIT(statut,gpio);
+            if (Callback_GPIO[gpio] != NULL)
+            {
+                Callback_GPIO[gpio](gpio, READ_BIT(etats,gpio));
+            }
+        }
+    }
+}
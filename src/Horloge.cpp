@@ -0,0 +1,128 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Horloge.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Horloge monotone 64 bits (cycles à 80 MHz, microsecondes) construite sur le compteur de cycles du CPU
+ *  (voir Horloge.h)
+ * =============================================================================================================================================
+ */
+
+#include "Horloge.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Deux exemplaires de la base : l'exemplaire courant est Bases_Horloge[generation & 1]
+volatile Horloge_Base Bases_Horloge[2];
+volatile uint32 horloge_generation = 0;
+
+// Client du multiplexeur TIMER1 (recalage)
+int8 client_horloge = -1;
+
+// Empêche le compilateur de déplacer la lecture du compteur de cycles autour de la base
+#define HORLOGE_BARRIERE() __asm__ __volatile__("" ::: "memory")
+
+// ##########################################################################################################################
+//                                      FONCTIONS HORLOGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Horloge
+  DESCRIPTION   : Démarre l'horloge et son recalage (client du multiplexeur TIMER1) :
+                  l'horloge repart de 0
+  PARAMETRES    : rien
+  RETOUR        : false si aucun client du multiplexeur n'est libre
+===============================================================================*/
+bool init_Horloge()
+{
+    uint32 compteur;
+
+    // enregistrement auprès du multiplexeur du TIMER1 (une seule fois)
+    if (client_horloge < 0) client_horloge = TIMER1_Mux_Ajouter_Client(Interruption_Horloge,NULL);
+    if (client_horloge < 0) return false;
+
+    ETS_INTR_LOCK();
+    compteur = Lire_Compteur_Cycles();
+    for (uint8 i = 0; i < 2; i++)
+    {
+        Bases_Horloge[i].cycles = 0;
+        Bases_Horloge[i].compteur = compteur;
+    }
+    horloge_generation = 0;
+
+    // premier recalage
+    TIMER1_Mux_Programmer(client_horloge,compteur + HORLOGE_INTERVALLE_RECALAGE);
+    ETS_INTR_UNLOCK();
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Horloge_Lire_Cycles
+  DESCRIPTION   : Temps écoulé depuis init_Horloge, en cycles (12.5ns)
+  (sans masquage des interruptions, utilisable depuis une interruption)
+  PARAMETRES    : rien
+  RETOUR        : Nombre de cycles (64 bits, ne boucle pas)
+===============================================================================*/
+uint64 ICACHE_RAM_ATTR Horloge_Lire_Cycles()
+{
+    uint32 generation;
+    uint64 cycles;
+    uint32 compteur_base;
+    uint32 compteur;
+
+    // Le compteur est lu APRES la base : s'il y a eu un recalage entre les deux, la génération
+    // a changé et la lecture recommence (sinon "compteur - compteur_base" serait négatif)
+    do
+    {
+        generation = horloge_generation;
+        cycles = Bases_Horloge[generation & 1].cycles;
+        compteur_base = Bases_Horloge[generation & 1].compteur;
+        HORLOGE_BARRIERE();
+        compteur = Lire_Compteur_Cycles();
+        HORLOGE_BARRIERE();
+    } while (generation != horloge_generation);
+
+    return cycles + (uint32)(compteur - compteur_base);
+}
+
+/*===============================================================================
+  FONCTION      : Horloge_Lire_us
+  DESCRIPTION   : Temps écoulé depuis init_Horloge, en microsecondes
+  PARAMETRES    : rien
+  RETOUR        : Nombre de microsecondes (64 bits)
+===============================================================================*/
+uint64 ICACHE_RAM_ATTR Horloge_Lire_us()
+{
+    return Horloge_Cycles_Vers_us(Horloge_Lire_Cycles());
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Horloge
+  DESCRIPTION   : Recale la base de l'horloge (client du multiplexeur TIMER1)
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Horloge(void *argument)
+{
+    uint32 generation = horloge_generation;
+    volatile Horloge_Base *actuelle = &Bases_Horloge[generation & 1];
+    volatile Horloge_Base *suivante = &Bases_Horloge[(generation + 1) & 1];
+    uint32 compteur;
+
+    HORLOGE_BARRIERE();
+    compteur = Lire_Compteur_Cycles();
+    HORLOGE_BARRIERE();
+
+    // L'exemplaire inactif est complété avant d'être publié :
+    // une lecture qui interrompt cette fonction utilise toujours l'exemplaire courant
+    suivante->cycles = actuelle->cycles + (uint32)(compteur - actuelle->compteur);
+    suivante->compteur = compteur;
+    horloge_generation = generation + 1;
+
+    TIMER1_Mux_Programmer(client_horloge,compteur + HORLOGE_INTERVALLE_RECALAGE);
+}
@@ -0,0 +1,119 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Horloge.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Horloge monotone 64 bits (cycles à 80 MHz, microsecondes) construite sur le compteur de cycles du CPU
+ *
+ *  Le compteur de cycles (CCOUNT, résolution 12.5ns) boucle toutes les 53.7s. Un client du multiplexeur
+ *  du TIMER1 recale toutes les 13.4s une "base" 64 bits : temps = base + (compteur - compteur de la base),
+ *  valable tant que moins de 2^32 cycles séparent la lecture de la base (le recalage peut donc être
+ *  retardé de 40s sans erreur).
+ *
+ *  La base est doublée : l'interruption écrit l'exemplaire inactif puis change d'exemplaire.
+ *  La lecture ne masque jamais les interruptions et peut être faite depuis une interruption
+ *  (elle recommence seulement si l'interruption de l'horloge s'est exécutée pendant la lecture).
+ *
+ *  Le TIMER2 n'est pas utilisé : il reste au SDK (os_timer, WiFi, micros()).
+ * =============================================================================================================================================
+ */
+
+#ifndef __HORLOGE_H__
+#define __HORLOGE_H__
+
+// Dépendance(s)
+#include "Multiplexeur_TIMER1.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Fréquence de comptage de l'horloge (compteur de cycles du CPU)
+#define HORLOGE_CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+
+// Intervalle entre deux recalages de la base (cycles : quart de période du compteur,
+// les échéances du multiplexeur doivent être à moins de 2^31 cycles)
+#define HORLOGE_INTERVALLE_RECALAGE 0x40000000
+
+// Base de l'horloge : valeur 64 bits correspondant à une valeur du compteur de cycles
+typedef struct{
+  uint64 cycles;     // temps à l'instant du recalage
+  uint32 compteur;   // valeur du compteur de cycles au même instant
+} Horloge_Base;
+
+// ##########################################################################################################################
+//                                      FONCTIONS HORLOGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Horloge
+  DESCRIPTION   : Démarre l'horloge et son recalage (client du multiplexeur TIMER1) :
+                  l'horloge repart de 0
+  PARAMETRES    : rien
+  RETOUR        : false si aucun client du multiplexeur n'est libre
+===============================================================================*/
+bool init_Horloge();
+
+/*===============================================================================
+  FONCTION      : Horloge_Lire_Cycles
+  DESCRIPTION   : Temps écoulé depuis init_Horloge, en cycles (12.5ns)
+  (sans masquage des interruptions, utilisable depuis une interruption)
+  PARAMETRES    : rien
+  RETOUR        : Nombre de cycles (64 bits, ne boucle pas)
+===============================================================================*/
+uint64 ICACHE_RAM_ATTR Horloge_Lire_Cycles();
+
+/*===============================================================================
+  FONCTION      : Horloge_Lire_us
+  DESCRIPTION   : Temps écoulé depuis init_Horloge, en microsecondes
+  PARAMETRES    : rien
+  RETOUR        : Nombre de microsecondes (64 bits)
+===============================================================================*/
+uint64 ICACHE_RAM_ATTR Horloge_Lire_us();
+
+/*===============================================================================
+  FONCTION      : Horloge_Cycles_Vers_us
+  DESCRIPTION   : Conversion cycles -> microsecondes (arrondi inférieur)
+  PARAMETRES    : Nombre de cycles
+  RETOUR        : Nombre de microsecondes
+===============================================================================*/
+static inline uint64 Horloge_Cycles_Vers_us(uint64 cycles)
+{
+    return cycles / HORLOGE_CYCLES_PAR_US;
+}
+
+/*===============================================================================
+  FONCTION      : Horloge_us_Vers_Cycles
+  DESCRIPTION   : Conversion microsecondes -> cycles
+  PARAMETRES    : Nombre de microsecondes
+  RETOUR        : Nombre de cycles
+===============================================================================*/
+static inline uint64 Horloge_us_Vers_Cycles(uint64 us)
+{
+    return us * HORLOGE_CYCLES_PAR_US;
+}
+
+/*===============================================================================
+  FONCTION      : Horloge_Cycles_Vers_ns
+  DESCRIPTION   : Conversion cycles -> nanosecondes
+  PARAMETRES    : Nombre de cycles
+  RETOUR        : Nombre de nanosecondes
+===============================================================================*/
+static inline uint64 Horloge_Cycles_Vers_ns(uint64 cycles)
+{
+    return (cycles * 1000) / HORLOGE_CYCLES_PAR_US;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Horloge
+  DESCRIPTION   : Recale la base de l'horloge (client du multiplexeur TIMER1)
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Horloge(void *argument);
+
+/* fin du fichier */
+#endif
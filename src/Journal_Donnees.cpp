@@ -0,0 +1,609 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Journal_Donnees.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Journal de mesures en flash (séries temporelles), compressé et écrit par pages
+ *  (voir Journal_Donnees.h)
+ * =============================================================================================================================================
+ */
+
+#include "Journal_Donnees.h"
+#include <string.h>
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Taille maximale d'un échantillon compressé (entier de longueur variable : 5 octets au plus)
+#define JOURNAL_OCTETS_VARINT_MAX 5
+#define JOURNAL_TAILLE_ECHANTILLON_MAX (JOURNAL_OCTETS_VARINT_MAX * (1 + JOURNAL_NB_VOIES_MAX))
+
+// Taille des données d'une page
+#define JOURNAL_TAILLE_DONNEES (JOURNAL_TAILLE_PAGE - sizeof(Journal_Entete))
+
+// Champ d'un en-tête jamais écrit
+#define JOURNAL_VIDE 0xFFFFFFFF
+
+// Zone de flash
+uint16 journal_premier_secteur = 0;
+uint8 journal_nb_secteurs = 0;
+uint16 journal_nb_slots = 0;             // emplacements de page de l'anneau
+uint8 journal_nb_voies = 0;
+
+// Ecriture dans l'anneau
+uint16 journal_tete = 0;                 // emplacement de la prochaine page écrite
+bool journal_secteur_pret = false;       // secteur de la tête effacé
+uint32 journal_sequence = 0;             // séquence de la prochaine page ouverte
+
+// Pages en RAM, blocs du pool Pool_Pages_Journal : "nb_pages_pleines" pages en attente d'écriture
+// dans Pages_Pleines à partir de "page_premiere_pleine", puis la page en remplissage
+// (allouée au premier échantillon, rendue au pool une fois écrite en flash)
+POOL_DECLARER(Pool_Pages_Journal,sizeof(Journal_Page),JOURNAL_NB_PAGES_RAM);
+Journal_Page *Pages_Pleines[JOURNAL_NB_PAGES_RAM];
+Journal_Page *Page_Courante = NULL;
+uint8 page_premiere_pleine = 0;
+uint8 nb_pages_pleines = 0;
+
+// Compression : dernier échantillon de la page en remplissage
+uint32 journal_date_precedente = 0;
+int32 journal_ecart_precedent = 0;
+int32 Valeurs_Precedentes[JOURNAL_NB_VOIES_MAX];
+
+// Lecteur utilisé par Journal_Exporter
+Journal_Lecteur Lecteur_Export;
+
+Journal_Statistiques Statistiques_Journal;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Adresse_Slot
+  DESCRIPTION   : Adresse en flash d'un emplacement de page de l'anneau
+  PARAMETRES    : N° de l'emplacement
+  RETOUR        : Adresse
+===============================================================================*/
+static inline uint32 Adresse_Slot(uint16 slot)
+{
+    return (uint32)(journal_premier_secteur + slot / JOURNAL_PAGES_PAR_SECTEUR) * FLASH_TAILLE_SECTEUR +
+           (uint32)(slot % JOURNAL_PAGES_PAR_SECTEUR) * JOURNAL_TAILLE_PAGE;
+}
+
+/*===============================================================================
+  FONCTION      : Zigzag / Dezigzag
+  DESCRIPTION   : Entier signé <-> non signé (0, -1, 1, -2... -> 0, 1, 2, 3...) :
+                  les petits écarts, positifs ou négatifs, donnent de petits nombres
+  PARAMETRES    : Valeur
+  RETOUR        : Valeur convertie
+===============================================================================*/
+static inline uint32 Zigzag(int32 valeur)
+{
+    return ((uint32)valeur << 1) ^ (uint32)(valeur >> 31);
+}
+static inline int32 Dezigzag(uint32 valeur)
+{
+    return (int32)((valeur >> 1) ^ (0 - (valeur & 1)));
+}
+
+/*===============================================================================
+  FONCTION      : Ecrire_Varint
+  DESCRIPTION   : Code un entier en longueur variable (7 bits par octet, bit 7 : octet suivant)
+  PARAMETRES    : Destination, valeur
+  RETOUR        : Nombre d'octets écrits (1 à 5)
+===============================================================================*/
+static uint8 Ecrire_Varint(uint8 *destination, uint32 valeur)
+{
+    uint8 n = 0;
+
+    while (valeur >= 0x80)
+    {
+        destination[n++] = (uint8)(valeur | 0x80);
+        valeur >>= 7;
+    }
+    destination[n++] = (uint8)valeur;
+    return n;
+}
+
+/*===============================================================================
+  FONCTION      : Lire_Varint
+  DESCRIPTION   : Décode un entier de longueur variable
+  PARAMETRES    : Données, taille des données, position (avancée), valeur lue
+  RETOUR        : false si les données sont tronquées ou invalides
+===============================================================================*/
+static bool Lire_Varint(const uint8 *donnees, uint16 taille, uint16 *position, uint32 *valeur)
+{
+    uint32 resultat = 0;
+
+    for (uint8 n = 0; n < JOURNAL_OCTETS_VARINT_MAX; n++)
+    {
+        if (*position >= taille) return false;
+        uint8 octet = donnees[(*position)++];
+        resultat |= (uint32)(octet & 0x7F) << (7 * n);
+        if ((octet & 0x80) == 0)
+        {
+            *valeur = resultat;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*===============================================================================
+  FONCTION      : CRC_Page
+  DESCRIPTION   : CRC 32 d'une page (en-tête après le champ crc, puis données)
+  PARAMETRES    : Page
+  RETOUR        : CRC
+===============================================================================*/
+static uint32 CRC_Page(const Journal_Page *page)
+{
+    return ~Flash_CRC32(FLASH_CRC32_INIT,&page->entete.sequence,sizeof(Journal_Entete) - 8 + page->entete.taille);
+}
+
+/*===============================================================================
+  FONCTION      : Entete_Valide
+  DESCRIPTION   : Vérifie la cohérence d'un en-tête de page
+  PARAMETRES    : En-tête
+  RETOUR        : true si l'en-tête peut être celui d'une page du journal
+===============================================================================*/
+static bool Entete_Valide(const Journal_Entete *entete)
+{
+    return entete->magique == JOURNAL_MAGIQUE && entete->taille <= JOURNAL_TAILLE_DONNEES &&
+           entete->nb_voies >= 1 && entete->nb_voies <= JOURNAL_NB_VOIES_MAX && entete->nb_echantillons > 0;
+}
+
+/*===============================================================================
+  FONCTION      : Lire_Page
+  DESCRIPTION   : Relit une page de l'anneau et vérifie son CRC
+  PARAMETRES    : N° de l'emplacement, page lue
+  RETOUR        : true si la page est valide
+===============================================================================*/
+static bool Lire_Page(uint16 slot, Journal_Page *page)
+{
+    uint32 adresse = Adresse_Slot(slot);
+
+    if (!Flash_Lire(adresse,&page->entete,sizeof(Journal_Entete))) return false;
+    if (!Entete_Valide(&page->entete)) return false;
+    if (!Flash_Lire(adresse + sizeof(Journal_Entete),page->donnees,FLASH_ALIGNER(page->entete.taille))) return false;
+    return CRC_Page(page) == page->entete.crc;
+}
+
+/*===============================================================================
+  FONCTION      : Slot_Vierge
+  DESCRIPTION   : Vérifie qu'un emplacement n'a jamais été écrit depuis l'effacement de son secteur
+  PARAMETRES    : N° de l'emplacement, buffer de travail (une page)
+  RETOUR        : true si tous les octets sont à 0xFF
+===============================================================================*/
+static bool Slot_Vierge(uint16 slot, Journal_Page *travail)
+{
+    const uint32 *mots = (const uint32 *)travail;
+
+    if (!Flash_Lire(Adresse_Slot(slot),travail,JOURNAL_TAILLE_PAGE)) return false;
+    for (uint16 i = 0; i < JOURNAL_TAILLE_PAGE / 4; i++)
+    {
+        if (mots[i] != JOURNAL_VIDE) return false;
+    }
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Page_RAM
+  DESCRIPTION   : Page en RAM, de la plus ancienne à la plus récente
+  PARAMETRES    : Rang (0 à nb_pages_pleines : pages en attente, puis page en remplissage)
+  RETOUR        : Page, NULL si elle n'existe pas
+===============================================================================*/
+static Journal_Page *Page_RAM(uint8 rang)
+{
+    if (rang < nb_pages_pleines) return Pages_Pleines[(page_premiere_pleine + rang) % JOURNAL_NB_PAGES_RAM];
+    if (rang == nb_pages_pleines) return Page_Courante;
+    return NULL;
+}
+
+/*===============================================================================
+  FONCTION      : Fermer_Page
+  DESCRIPTION   : Termine la page en remplissage : elle passe en attente d'écriture
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Fermer_Page()
+{
+    Page_Courante->entete.crc = CRC_Page(Page_Courante);
+    Pages_Pleines[(page_premiere_pleine + nb_pages_pleines) % JOURNAL_NB_PAGES_RAM] = Page_Courante;
+    nb_pages_pleines++;
+    Page_Courante = NULL;
+}
+
+/*===============================================================================
+  FONCTION      : Charger_Page_Suivante
+  DESCRIPTION   : Charge dans le lecteur la page qui suit la dernière page lue :
+                  emplacements de l'anneau dans l'ordre d'écriture, puis pages en RAM
+  PARAMETRES    : Lecteur
+  RETOUR        : false s'il n'y a plus de page
+===============================================================================*/
+static bool Charger_Page_Suivante(Journal_Lecteur *lecteur)
+{
+    uint32 sequence_min = lecteur->debut ? 0 : lecteur->derniere_sequence + 1;
+    Journal_Page *trouvee = NULL;
+
+    // Flash : à partir de la tête, les pages sont rangées de la plus ancienne à la plus récente
+    for (uint16 n = 0; n < journal_nb_slots && trouvee == NULL; n++)
+    {
+        uint16 slot = lecteur->slot;
+        lecteur->slot = (slot + 1 == journal_nb_slots) ? 0 : slot + 1;
+
+        if (!Flash_Lire(Adresse_Slot(slot),&lecteur->page.entete,sizeof(Journal_Entete))) continue;
+        if (!Entete_Valide(&lecteur->page.entete) || lecteur->page.entete.sequence < sequence_min) continue;
+        if (Lire_Page(slot,&lecteur->page)) trouvee = &lecteur->page;
+    }
+
+    // RAM : pages en attente d'écriture et page en remplissage (plus récentes que toute la flash)
+    if (trouvee == NULL)
+    {
+        for (uint8 i = 0; i <= nb_pages_pleines; i++)
+        {
+            Journal_Page *page = Page_RAM(i);
+            if (page == NULL || page->entete.nb_echantillons == 0 || page->entete.sequence < sequence_min) continue;
+            if (trouvee == NULL || page->entete.sequence < trouvee->entete.sequence) trouvee = page;
+        }
+        if (trouvee == NULL) return false;
+        memcpy(&lecteur->page,trouvee,sizeof(Journal_Page));
+    }
+
+    lecteur->debut = false;
+    lecteur->derniere_sequence = lecteur->page.entete.sequence;
+    lecteur->position = 0;
+    lecteur->echantillon = 0;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Rafraichir_Page_RAM
+  DESCRIPTION   : Recopie la page en cours de lecture si elle est encore en RAM et a grandi
+                  (les données sont ajoutées à la suite : le décodage continue à la même position)
+  PARAMETRES    : Lecteur
+  RETOUR        : true si de nouveaux échantillons sont disponibles
+===============================================================================*/
+static bool Rafraichir_Page_RAM(Journal_Lecteur *lecteur)
+{
+    for (uint8 i = 0; i <= nb_pages_pleines; i++)
+    {
+        Journal_Page *page = Page_RAM(i);
+        if (page != NULL && page->entete.nb_echantillons > lecteur->echantillon && page->entete.sequence == lecteur->derniere_sequence)
+        {
+            memcpy(&lecteur->page,page,sizeof(Journal_Page));
+            return true;
+        }
+    }
+    return false;
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS JOURNAL
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Journal
+  DESCRIPTION   : Monte le journal sur une zone de la flash : retrouve la page la plus récente
+                  (les nouvelles pages sont écrites à sa suite)
+  PARAMETRES    : N° du premier secteur, nombre de secteurs (2 à JOURNAL_NB_SECTEURS_MAX),
+                  nombre de voies des échantillons (1 à JOURNAL_NB_VOIES_MAX)
+  RETOUR        : false si les paramètres sont invalides
+===============================================================================*/
+bool init_Journal(uint16 premier_secteur, uint8 nb_secteurs, uint8 nb_voies)
+{
+    Journal_Page *travail;
+    bool trouvee = false;
+
+    if (nb_secteurs < 2 || nb_secteurs > JOURNAL_NB_SECTEURS_MAX) return false;
+    if (nb_voies < 1 || nb_voies > JOURNAL_NB_VOIES_MAX) return false;
+
+    // Toutes les pages en RAM sont rendues au pool, l'une d'elles sert de tampon pour la recherche
+    init_Pool(&Pool_Pages_Journal);
+    travail = (Journal_Page *)Pool_Allouer(&Pool_Pages_Journal);
+
+    journal_premier_secteur = premier_secteur;
+    journal_nb_secteurs = nb_secteurs;
+    journal_nb_slots = (uint16)nb_secteurs * JOURNAL_PAGES_PAR_SECTEUR;
+    journal_nb_voies = nb_voies;
+    memset(&Statistiques_Journal,0,sizeof(Statistiques_Journal));
+
+    // Etape 1 : page la plus récente (séquence maximale)
+    journal_tete = 0;
+    journal_sequence = 0;
+    for (uint16 slot = 0; slot < journal_nb_slots; slot++)
+    {
+        if (Lire_Page(slot,travail))
+        {
+            if (!trouvee || travail->entete.sequence >= journal_sequence)
+            {
+                journal_sequence = travail->entete.sequence + 1;
+                journal_tete = (slot + 1 == journal_nb_slots) ? 0 : slot + 1;
+            }
+            trouvee = true;
+        }
+        else if (travail->entete.magique == JOURNAL_MAGIQUE)
+        {
+            Statistiques_Journal.nb_pages_invalides++;
+        }
+    }
+
+    // Etape 2 : un emplacement déjà écrit (page interrompue) ne peut pas être réécrit sans effacement :
+    // l'écriture reprend au secteur suivant
+    journal_secteur_pret = (journal_tete % JOURNAL_PAGES_PAR_SECTEUR) != 0;
+    if (journal_secteur_pret && !Slot_Vierge(journal_tete,travail))
+    {
+        journal_tete = (journal_tete / JOURNAL_PAGES_PAR_SECTEUR + 1) * JOURNAL_PAGES_PAR_SECTEUR;
+        if (journal_tete >= journal_nb_slots) journal_tete = 0;
+        journal_secteur_pret = false;
+    }
+
+    // Etape 3 : pages en RAM libres
+    Pool_Liberer(&Pool_Pages_Journal,travail);
+    Page_Courante = NULL;
+    page_premiere_pleine = 0;
+    nb_pages_pleines = 0;
+
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Journal_Ajouter
+  DESCRIPTION   : Ajoute un échantillon à la page en RAM (aucun accès à la flash)
+  PARAMETRES    : Date (s, croissante), valeurs des voies
+  RETOUR        : false si l'échantillon est perdu (pages en attente d'écriture)
+===============================================================================*/
+bool Journal_Ajouter(uint32 date, const int32 *valeurs)
+{
+    uint8 tampon[JOURNAL_TAILLE_ECHANTILLON_MAX];
+    Journal_Page *page;
+    uint8 taille;
+
+    if (journal_nb_slots == 0) return false;
+
+    for (;;)
+    {
+        // Nouvelle page : prise dans le pool (vide : toutes les pages attendent leur écriture)
+        if (Page_Courante == NULL)
+        {
+            Page_Courante = (Journal_Page *)Pool_Allouer(&Pool_Pages_Journal);
+            if (Page_Courante == NULL)
+            {
+                Statistiques_Journal.nb_perdus++;
+                return false;
+            }
+            Page_Courante->entete.nb_echantillons = 0;
+        }
+        page = Page_Courante;
+
+        // Nouvelle page : le premier échantillon est codé par rapport à 0, sa date est dans l'en-tête
+        if (page->entete.nb_echantillons == 0)
+        {
+            page->entete.magique = JOURNAL_MAGIQUE;
+            page->entete.sequence = journal_sequence++;
+            page->entete.date = date;
+            page->entete.taille = 0;
+            page->entete.nb_voies = journal_nb_voies;
+            page->entete.reserve[0] = page->entete.reserve[1] = page->entete.reserve[2] = 0;
+            journal_date_precedente = date;
+            journal_ecart_precedent = 0;
+            memset(Valeurs_Precedentes,0,sizeof(Valeurs_Precedentes));
+        }
+
+        // Compression : écart d'écart de la date, écart de chaque valeur
+        taille = 0;
+        int32 ecart = (int32)(date - journal_date_precedente);
+        if (page->entete.nb_echantillons > 0)
+        {
+            taille += Ecrire_Varint(&tampon[taille],Zigzag(ecart - journal_ecart_precedent));
+        }
+        for (uint8 v = 0; v < journal_nb_voies; v++)
+        {
+            taille += Ecrire_Varint(&tampon[taille],Zigzag((int32)((uint32)valeurs[v] - (uint32)Valeurs_Precedentes[v])));
+        }
+
+        // Page pleine : fermée, l'échantillon est codé à nouveau au début de la suivante
+        if (page->entete.taille + taille <= JOURNAL_TAILLE_DONNEES) break;
+        Fermer_Page();
+    }
+
+    memcpy(&page->donnees[page->entete.taille],tampon,taille);
+    page->entete.taille += taille;
+    page->entete.nb_echantillons++;
+
+    journal_ecart_precedent = (int32)(date - journal_date_precedente);
+    journal_date_precedente = date;
+    memcpy(Valeurs_Precedentes,valeurs,journal_nb_voies * sizeof(int32));
+
+    Statistiques_Journal.nb_echantillons++;
+    Statistiques_Journal.octets_bruts += 4 * (1 + journal_nb_voies);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Journal_Vider
+  DESCRIPTION   : Termine la page en cours (écrite au prochain Journal_Tache)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Journal_Vider()
+{
+    if (Page_Courante != NULL && Page_Courante->entete.nb_echantillons > 0)
+    {
+        Fermer_Page();
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Journal_Tache
+  DESCRIPTION   : Ecrit en flash une page en attente (ou efface le secteur qui la recevra)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des pages à écrire
+===============================================================================*/
+bool Journal_Tache()
+{
+    if (nb_pages_pleines == 0) return false;
+
+    // Etape 1 : premier emplacement d'un secteur -> effacement (les pages les plus anciennes disparaissent)
+    if (!journal_secteur_pret)
+    {
+        if (Flash_Effacer_Secteur(journal_premier_secteur + journal_tete / JOURNAL_PAGES_PAR_SECTEUR))
+        {
+            journal_secteur_pret = true;
+            Statistiques_Journal.nb_effacements++;
+        }
+        else
+        {
+            Statistiques_Journal.nb_erreurs_flash++;
+        }
+        return true;
+    }
+
+    // Etape 2 : écriture de la page la plus ancienne (partie utile uniquement)
+    Journal_Page *page = Pages_Pleines[page_premiere_pleine];
+    uint32 taille = FLASH_ALIGNER(sizeof(Journal_Entete) + page->entete.taille);
+    bool ecrite = Flash_Ecrire(Adresse_Slot(journal_tete),page,taille);
+
+    // Emplacement suivant (en cas d'erreur, la page est réessayée à l'emplacement suivant)
+    journal_tete = (journal_tete + 1 == journal_nb_slots) ? 0 : journal_tete + 1;
+    journal_secteur_pret = (journal_tete % JOURNAL_PAGES_PAR_SECTEUR) != 0;
+
+    if (!ecrite)
+    {
+        Statistiques_Journal.nb_erreurs_flash++;
+        return true;
+    }
+    Statistiques_Journal.nb_pages_ecrites++;
+    Statistiques_Journal.octets_ecrits += taille;
+
+    Pool_Liberer(&Pool_Pages_Journal,page);
+    page_premiere_pleine = (page_premiere_pleine + 1) % JOURNAL_NB_PAGES_RAM;
+    nb_pages_pleines--;
+
+    return nb_pages_pleines > 0;
+}
+
+/*===============================================================================
+  FONCTION      : Journal_Lecture_Debut
+  DESCRIPTION   : Prépare la relecture du journal, de la page la plus ancienne à la plus récente
+  PARAMETRES    : Lecteur, date minimale des échantillons rendus (0 : tout le journal)
+  RETOUR        : rien
+===============================================================================*/
+void Journal_Lecture_Debut(Journal_Lecteur *lecteur, uint32 depuis)
+{
+    lecteur->slot = journal_tete;
+    lecteur->debut = true;
+    lecteur->derniere_sequence = 0;
+    lecteur->position = 0;
+    lecteur->echantillon = 0;
+    lecteur->depuis = depuis;
+}
+
+/*===============================================================================
+  FONCTION      : Journal_Lecture_Suivant
+  DESCRIPTION   : Décode l'échantillon suivant
+  PARAMETRES    : Lecteur, date de l'échantillon, valeurs (JOURNAL_NB_VOIES_MAX au plus),
+                  nombre de voies (peut être NULL)
+  RETOUR        : false à la fin du journal
+===============================================================================*/
+bool Journal_Lecture_Suivant(Journal_Lecteur *lecteur, uint32 *date, int32 *valeurs, uint8 *nb_voies)
+{
+    Journal_Entete *entete = &lecteur->page.entete;
+
+    if (journal_nb_slots == 0) return false;
+
+    for (;;)
+    {
+        // Page terminée : nouveaux échantillons de la page en RAM, sinon page suivante
+        if (lecteur->debut || lecteur->echantillon >= entete->nb_echantillons)
+        {
+            if (!lecteur->debut && Rafraichir_Page_RAM(lecteur)) continue;
+            if (!Charger_Page_Suivante(lecteur)) return false;
+        }
+
+        // Décodage (opérations inverses de Journal_Ajouter)
+        bool valide = true;
+        uint32 mot = 0;
+        if (lecteur->echantillon == 0)
+        {
+            lecteur->date = entete->date;
+            lecteur->ecart_date = 0;
+            memset(lecteur->valeurs,0,sizeof(lecteur->valeurs));
+        }
+        else
+        {
+            valide = Lire_Varint(lecteur->page.donnees,entete->taille,&lecteur->position,&mot);
+            lecteur->ecart_date += Dezigzag(mot);
+            lecteur->date += lecteur->ecart_date;
+        }
+        for (uint8 v = 0; v < entete->nb_voies && valide; v++)
+        {
+            valide = Lire_Varint(lecteur->page.donnees,entete->taille,&lecteur->position,&mot);
+            lecteur->valeurs[v] = (int32)((uint32)lecteur->valeurs[v] + (uint32)Dezigzag(mot));
+        }
+
+        // Données incohérentes : le reste de la page est abandonné
+        if (!valide)
+        {
+            lecteur->echantillon = entete->nb_echantillons;
+            continue;
+        }
+        lecteur->echantillon++;
+
+        if (lecteur->date < lecteur->depuis) continue;
+        *date = lecteur->date;
+        memcpy(valeurs,lecteur->valeurs,entete->nb_voies * sizeof(int32));
+        if (nb_voies != NULL) *nb_voies = entete->nb_voies;
+        return true;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Journal_Exporter
+  DESCRIPTION   : Envoie le journal sur une UART, une ligne "date;v1;v2..." par échantillon
+  PARAMETRES    : N° de l'UART, date minimale des échantillons envoyés (0 : tout le journal)
+  RETOUR        : Nombre d'échantillons envoyés
+===============================================================================*/
+uint32 Journal_Exporter(uint8 UART, uint32 depuis)
+{
+    int32 valeurs[JOURNAL_NB_VOIES_MAX];
+    uint32 date;
+    uint8 nb_voies;
+    uint32 nb = 0;
+
+    Journal_Lecture_Debut(&Lecteur_Export,depuis);
+    while (Journal_Lecture_Suivant(&Lecteur_Export,&date,valeurs,&nb_voies))
+    {
+        UART_WriteNombre(UART,date);
+        for (uint8 v = 0; v < nb_voies; v++)
+        {
+            UART_WriteChar(UART,';');
+            if (valeurs[v] < 0)
+            {
+                UART_WriteChar(UART,'-');
+                UART_WriteNombre(UART,0 - (uint32)valeurs[v]);
+            }
+            else
+            {
+                UART_WriteNombre(UART,(uint32)valeurs[v]);
+            }
+        }
+        UART_WriteChar(UART,'\n');
+        nb++;
+    }
+    return nb;
+}
+
+/*===============================================================================
+  FONCTION      : Journal_Lire_Statistiques
+  DESCRIPTION   : Compteurs du journal (taux de compression : octets_bruts / octets_ecrits)
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Journal_Statistiques *Journal_Lire_Statistiques()
+{
+    return &Statistiques_Journal;
+}
@@ -0,0 +1,182 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Journal_Donnees.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Journal de mesures en flash (séries temporelles), compressé et écrit par pages
+ *
+ *  Au lieu d'écrire chaque mesure en flash (une écriture, et tôt ou tard un effacement, par échantillon) :
+ *  - les échantillons (date + jusqu'à JOURNAL_NB_VOIES_MAX valeurs entières) sont compressés au fil de l'eau
+ *    dans une page en RAM : écart à l'échantillon précédent de chaque voie, date en écart d'écart
+ *    (0 pour une période régulière), codés en "zigzag" puis en entier de longueur variable (1 octet de 0 à 63)
+ *  - une page pleine est écrite en une fois dans un anneau de secteurs par Journal_Tache, appelée sur le temps
+ *    libre du scheduler (Scheduler_Set_Tache_Fond) : l'effacement du secteur suivant et l'écriture d'une page
+ *    sont faits à deux appels différents
+ *  - chaque page est autonome (en-tête : séquence, date du premier échantillon, CRC 32) : la relecture démarre
+ *    à n'importe quelle page, une page incomplète (coupure d'alimentation) est ignorée
+ *  - lorsque l'anneau est plein, le secteur le plus ancien est effacé : le journal garde les mesures les plus récentes
+ *
+ *  Relecture : Journal_Lecture_Debut / Journal_Lecture_Suivant parcourent les pages en flash puis en RAM,
+ *  du plus ancien au plus récent ; Journal_Exporter envoie le journal sur une UART (une ligne "date;v1;v2..." par échantillon)
+ *
+ *  /!\ La zone de flash utilisée ne doit contenir ni le programme, ni le système de fichiers, ni le stockage clé / valeur
+ * =============================================================================================================================================
+ */
+
+#ifndef __JOURNAL_DONNEES_H__
+#define __JOURNAL_DONNEES_H__
+
+// Dépendance(s)
+#include "Flash_esp8266.h"
+#include "UART_esp8266.h"
+#include "Pool_Memoire.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Taille d'une page (diviseur de FLASH_TAILLE_SECTEUR)
+#define JOURNAL_TAILLE_PAGE 512
+#define JOURNAL_PAGES_PAR_SECTEUR (FLASH_TAILLE_SECTEUR / JOURNAL_TAILLE_PAGE)
+
+// Pages en RAM (une en remplissage, les autres en attente d'écriture)
+#define JOURNAL_NB_PAGES_RAM 2
+
+// Nombre maximal de voies d'un échantillon
+#define JOURNAL_NB_VOIES_MAX 8
+
+// Nombre maximal de secteurs de l'anneau
+#define JOURNAL_NB_SECTEURS_MAX 64
+
+// Identification d'une page du journal
+#define JOURNAL_MAGIQUE 0x314C4A44 // "DJL1"
+
+// En-tête d'une page (le CRC couvre la suite de l'en-tête et les données)
+typedef struct{
+  uint32 magique;
+  uint32 crc;
+  uint32 sequence;             // numéro d'ordre de la page (croissant)
+  uint32 date;                 // date du premier échantillon
+  uint16 nb_echantillons;
+  uint16 taille;               // octets de données compressées
+  uint8 nb_voies;
+  uint8 reserve[3];
+} Journal_Entete;
+
+// Page (en RAM, ou relue depuis la flash)
+typedef struct{
+  Journal_Entete entete;
+  uint8 donnees[JOURNAL_TAILLE_PAGE - sizeof(Journal_Entete)];
+} Journal_Page;
+
+// Lecteur du journal (relecture d'une page complète à la fois)
+typedef struct{
+  Journal_Page page;
+  uint32 derniere_sequence;    // séquence de la page en cours de lecture
+  uint16 slot;                 // prochain emplacement de l'anneau examiné
+  uint16 position;             // position dans les données de la page
+  uint16 echantillon;          // échantillons lus dans la page
+  bool debut;                  // aucune page lue
+  uint32 depuis;               // date minimale des échantillons rendus
+  uint32 date;                 // décodage : dernier échantillon
+  int32 ecart_date;
+  int32 valeurs[JOURNAL_NB_VOIES_MAX];
+} Journal_Lecteur;
+
+// Statistiques
+typedef struct{
+  uint32 nb_echantillons;      // échantillons ajoutés
+  uint32 nb_perdus;            // échantillons perdus (pages RAM toutes en attente d'écriture)
+  uint32 octets_bruts;         // taille non compressée (date et valeurs sur 4 octets)
+  uint32 octets_ecrits;        // octets écrits en flash (en-têtes compris)
+  uint32 nb_pages_ecrites;
+  uint32 nb_effacements;
+  uint32 nb_erreurs_flash;
+  uint32 nb_pages_invalides;   // pages ignorées au démarrage (CRC faux)
+} Journal_Statistiques;
+
+// Pool des pages en RAM (occupation : Pool_Rapport(0,"journal",&Pool_Pages_Journal))
+extern Pool_Memoire Pool_Pages_Journal;
+
+// ##########################################################################################################################
+//                                      FONCTIONS JOURNAL
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Journal
+  DESCRIPTION   : Monte le journal sur une zone de la flash : retrouve la page la plus récente
+                  (les nouvelles pages sont écrites à sa suite)
+  PARAMETRES    : N° du premier secteur, nombre de secteurs (2 à JOURNAL_NB_SECTEURS_MAX),
+                  nombre de voies des échantillons (1 à JOURNAL_NB_VOIES_MAX)
+  RETOUR        : false si les paramètres sont invalides
+===============================================================================*/
+bool init_Journal(uint16 premier_secteur, uint8 nb_secteurs, uint8 nb_voies);
+
+/*===============================================================================
+  FONCTION      : Journal_Ajouter
+  DESCRIPTION   : Ajoute un échantillon à la page en RAM (aucun accès à la flash)
+  PARAMETRES    : Date (s, croissante), valeurs des voies
+  RETOUR        : false si l'échantillon est perdu (pages en attente d'écriture)
+===============================================================================*/
+bool Journal_Ajouter(uint32 date, const int32 *valeurs);
+
+/*===============================================================================
+  FONCTION      : Journal_Vider
+  DESCRIPTION   : Termine la page en cours (écrite au prochain Journal_Tache),
+                  par exemple avant une mise en veille
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Journal_Vider();
+
+/*===============================================================================
+  FONCTION      : Journal_Tache
+  DESCRIPTION   : Ecrit en flash une page en attente (ou efface le secteur qui la recevra)
+  /!\ un effacement bloque plusieurs dizaines de ms, une écriture environ 1 ms :
+      appeler sur le temps libre (Scheduler_Set_Tache_Fond) ou depuis la boucle principale
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste des pages à écrire
+===============================================================================*/
+bool Journal_Tache();
+
+/*===============================================================================
+  FONCTION      : Journal_Lecture_Debut
+  DESCRIPTION   : Prépare la relecture du journal, de la page la plus ancienne à la plus récente
+  PARAMETRES    : Lecteur, date minimale des échantillons rendus (0 : tout le journal)
+  RETOUR        : rien
+===============================================================================*/
+void Journal_Lecture_Debut(Journal_Lecteur *lecteur, uint32 depuis);
+
+/*===============================================================================
+  FONCTION      : Journal_Lecture_Suivant
+  DESCRIPTION   : Décode l'échantillon suivant
+  (les pages écrites pendant la relecture sont lues à leur tour ; une page effacée
+  par l'anneau avant d'avoir été lue est sautée)
+  PARAMETRES    : Lecteur, date de l'échantillon, valeurs (JOURNAL_NB_VOIES_MAX au plus),
+                  nombre de voies (peut être NULL)
+  RETOUR        : false à la fin du journal
+===============================================================================*/
+bool Journal_Lecture_Suivant(Journal_Lecteur *lecteur, uint32 *date, int32 *valeurs, uint8 *nb_voies);
+
+/*===============================================================================
+  FONCTION      : Journal_Exporter
+  DESCRIPTION   : Envoie le journal sur une UART, une ligne "date;v1;v2..." par échantillon
+  /!\ bloquant (attente de la fifo TX) : réservé à la maintenance
+  PARAMETRES    : N° de l'UART, date minimale des échantillons envoyés (0 : tout le journal)
+  RETOUR        : Nombre d'échantillons envoyés
+===============================================================================*/
+uint32 Journal_Exporter(uint8 UART, uint32 depuis);
+
+/*===============================================================================
+  FONCTION      : Journal_Lire_Statistiques
+  DESCRIPTION   : Compteurs du journal (taux de compression : octets_bruts / octets_ecrits)
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Journal_Statistiques *Journal_Lire_Statistiques();
+
+/* fin du fichier */
+#endif
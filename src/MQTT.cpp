@@ -0,0 +1,726 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : MQTT.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Codage / décodage des paquets MQTT 3.1.1 sans allocation dynamique ni copie
+ *  - Les paquets sont construits directement dans un buffer fourni par l'appelant (linéaire ou circulaire)
+ *  - Les paquets reçus sont analysés sur place : topic et payload sont des "vues" sur le buffer de réception
+ *  - L'analyse peut se faire octet par octet (UART, socket) ou par blocs
+ *  - Les filtres d'abonnement (+ et #) sont précompilés pour accélérer la recherche des abonnements d'un topic
+ * =============================================================================================================================================
+ */
+
+#include <string.h>
+#include "MQTT.h"
+
+// ##########################################################################################################################
+//                                     DEFINE INTERNES
+// ##########################################################################################################################
+
+// Longueur restante maximale d'un paquet (4 octets de codage)
+#define MQTT_LONGUEUR_MAX 268435455
+
+// Etats de l'analyseur
+#define ETAT_ENTETE   0
+#define ETAT_LONGUEUR 1
+#define ETAT_CORPS    2
+#define ETAT_IGNORER  3
+
+// Types de niveaux d'un filtre
+#define NIVEAU_TEXTE  0
+#define NIVEAU_PLUS   1
+#define NIVEAU_DIESE  2
+
+// Empreinte FNV-1a 32 bits
+#define FNV_DEPART    2166136261UL
+#define FNV_PREMIER   16777619UL
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : MQTT_Taille_Longueur
+  DESCRIPTION   : Nombre d'octets nécessaires au codage d'une longueur restante
+  PARAMETRES    : longueur
+  RETOUR        : 1 à 4
+===============================================================================*/
+static uint8 MQTT_Taille_Longueur(uint32 longueur)
+{
+    if (longueur < 128)     return 1;
+    if (longueur < 16384)   return 2;
+    if (longueur < 2097152) return 3;
+    return 4;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Ecrire_Octet
+  DESCRIPTION   : Ecrit un octet à la suite du paquet en cours
+  PARAMETRES    : écrivain, octet
+  RETOUR        : rien
+===============================================================================*/
+static void MQTT_Ecrire_Octet(MQTT_Ecrivain *ecrivain, uint8 octet)
+{
+    uint16 position = ecrivain->longueur;
+    if (ecrivain->circulaire)
+    {
+        position = (ecrivain->debut + ecrivain->longueur) & (ecrivain->taille - 1);
+    }
+    ecrivain->buffer[position] = octet;
+    ecrivain->longueur++;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Ecrire_Octets
+  DESCRIPTION   : Ecrit une suite d'octets à la suite du paquet en cours
+  PARAMETRES    : écrivain, octets, nombre d'octets
+  RETOUR        : rien
+===============================================================================*/
+static void MQTT_Ecrire_Octets(MQTT_Ecrivain *ecrivain, const uint8 *octets, uint16 len)
+{
+    if (!ecrivain->circulaire)
+    {
+        memcpy(&ecrivain->buffer[ecrivain->longueur],octets,len);
+        ecrivain->longueur += len;
+        return;
+    }
+    for (uint16 i = 0; i < len; i++) MQTT_Ecrire_Octet(ecrivain,octets[i]);
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Ecrire_Mot
+  DESCRIPTION   : Ecrit un entier 16 bits (poids fort en premier)
+  PARAMETRES    : écrivain, valeur
+  RETOUR        : rien
+===============================================================================*/
+static void MQTT_Ecrire_Mot(MQTT_Ecrivain *ecrivain, uint16 valeur)
+{
+    MQTT_Ecrire_Octet(ecrivain,valeur >> 8);
+    MQTT_Ecrire_Octet(ecrivain,valeur & 0xFF);
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Ecrire_Chaine
+  DESCRIPTION   : Ecrit une chaîne MQTT (longueur sur 16 bits puis caractères)
+  PARAMETRES    : écrivain, données, longueur
+  RETOUR        : rien
+===============================================================================*/
+static void MQTT_Ecrire_Chaine(MQTT_Ecrivain *ecrivain, const uint8 *donnees, uint16 len)
+{
+    MQTT_Ecrire_Mot(ecrivain,len);
+    MQTT_Ecrire_Octets(ecrivain,donnees,len);
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Ecrire_Entete
+  DESCRIPTION   : Vérifie la place disponible puis écrit l'en-tête fixe
+  PARAMETRES    : écrivain, premier octet de l'en-tête, longueur restante
+  RETOUR        : true si le paquet complet tient dans le buffer
+===============================================================================*/
+static bool MQTT_Ecrire_Entete(MQTT_Ecrivain *ecrivain, uint8 entete, uint32 longueur)
+{
+    uint32 total = 1 + MQTT_Taille_Longueur(longueur) + longueur;
+
+    ecrivain->erreur = (longueur > MQTT_LONGUEUR_MAX) || (ecrivain->longueur + total > ecrivain->taille);
+    if (ecrivain->erreur) return false;
+
+    MQTT_Ecrire_Octet(ecrivain,entete);
+    do
+    {
+        uint8 octet = longueur & 0x7F;
+        longueur >>= 7;
+        if (longueur > 0) octet |= 0x80;
+        MQTT_Ecrire_Octet(ecrivain,octet);
+    } while (longueur > 0);
+
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Taille_Chaine
+  DESCRIPTION   : Taille d'une chaîne C (0 si NULL)
+  PARAMETRES    : chaîne
+  RETOUR        : longueur
+===============================================================================*/
+static uint16 MQTT_Taille_Chaine(const char *chaine)
+{
+    return (chaine == NULL) ? 0 : strlen(chaine);
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Lire_Mot
+  DESCRIPTION   : Lit un entier 16 bits (poids fort en premier)
+  PARAMETRES    : données
+  RETOUR        : valeur
+===============================================================================*/
+static inline uint16 MQTT_Lire_Mot(const uint8 *donnees)
+{
+    return (donnees[0] << 8) | donnees[1];
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS CODAGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_MQTT_Ecrivain
+  DESCRIPTION   : Prépare l'écriture d'un paquet dans un buffer
+  PARAMETRES    : Ecrivain à initialiser
+                  Buffer, taille du buffer
+                  Position de départ (mode circulaire uniquement)
+                  true pour un buffer circulaire (taille = puissance de 2)
+  RETOUR        : rien
+===============================================================================*/
+void init_MQTT_Ecrivain(MQTT_Ecrivain *ecrivain, uint8 *buffer, uint16 taille, uint16 debut, bool circulaire)
+{
+    ecrivain->buffer = buffer;
+    ecrivain->taille = taille;
+    ecrivain->debut = circulaire ? (debut & (taille - 1)) : 0;
+    ecrivain->longueur = 0;
+    ecrivain->circulaire = circulaire;
+    ecrivain->erreur = false;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Connect
+  DESCRIPTION   : Ajoute un paquet CONNECT
+  PARAMETRES    : Ecrivain, options de connexion
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Connect(MQTT_Ecrivain *ecrivain, const MQTT_Options_Connexion *options)
+{
+    static const uint8 protocole[6] = {0x00, 0x04, 'M', 'Q', 'T', 'T'};
+    uint16 depart = ecrivain->longueur;
+    uint16 taille_id = MQTT_Taille_Chaine(options->client_id);
+    uint16 taille_will = MQTT_Taille_Chaine(options->will_topic);
+    uint16 taille_utilisateur = MQTT_Taille_Chaine(options->utilisateur);
+    uint16 taille_mdp = MQTT_Taille_Chaine(options->mot_de_passe);
+    uint8 drapeaux = 0;
+
+    // Longueur restante : en-tête variable (10 octets) + payload
+    uint32 longueur = 10 + 2 + taille_id;
+    if (options->will_topic != NULL)
+    {
+        longueur += 2 + taille_will + 2 + options->will_message.taille;
+        drapeaux |= 0x04 | ((options->will_qos & 0x3) << 3);
+        if (options->will_retain) drapeaux |= 0x20;
+    }
+    if (options->utilisateur != NULL)
+    {
+        longueur += 2 + taille_utilisateur;
+        drapeaux |= 0x80;
+    }
+    if (options->mot_de_passe != NULL)
+    {
+        longueur += 2 + taille_mdp;
+        drapeaux |= 0x40;
+    }
+    if (options->clean_session) drapeaux |= 0x02;
+
+    if (!MQTT_Ecrire_Entete(ecrivain,MQTT_CONNECT << 4,longueur)) return 0;
+
+    // En-tête variable : nom et niveau du protocole, drapeaux, keep alive
+    MQTT_Ecrire_Octets(ecrivain,protocole,6);
+    MQTT_Ecrire_Octet(ecrivain,4);
+    MQTT_Ecrire_Octet(ecrivain,drapeaux);
+    MQTT_Ecrire_Mot(ecrivain,options->keep_alive);
+
+    // Payload
+    MQTT_Ecrire_Chaine(ecrivain,(const uint8*)options->client_id,taille_id);
+    if (options->will_topic != NULL)
+    {
+        MQTT_Ecrire_Chaine(ecrivain,(const uint8*)options->will_topic,taille_will);
+        MQTT_Ecrire_Chaine(ecrivain,options->will_message.donnees,options->will_message.taille);
+    }
+    if (options->utilisateur != NULL)  MQTT_Ecrire_Chaine(ecrivain,(const uint8*)options->utilisateur,taille_utilisateur);
+    if (options->mot_de_passe != NULL) MQTT_Ecrire_Chaine(ecrivain,(const uint8*)options->mot_de_passe,taille_mdp);
+
+    return ecrivain->longueur - depart;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Publish
+  DESCRIPTION   : Ajoute un paquet PUBLISH
+  PARAMETRES    : Ecrivain, topic, message, taille du message,
+                  QoS (0,1,2), retain, identifiant de paquet (ignoré en QoS 0)
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Publish(MQTT_Ecrivain *ecrivain, const char *topic, const uint8 *message, uint16 taille_message, uint8 qos, bool retain, uint16 id)
+{
+    uint16 depart = ecrivain->longueur;
+    uint16 taille_topic = MQTT_Taille_Chaine(topic);
+    uint8 entete = (MQTT_PUBLISH << 4) | ((qos & 0x3) << 1) | (retain ? 1 : 0);
+    uint32 longueur = 2 + taille_topic + taille_message + (qos ? 2 : 0);
+
+    if (!MQTT_Ecrire_Entete(ecrivain,entete,longueur)) return 0;
+
+    MQTT_Ecrire_Chaine(ecrivain,(const uint8*)topic,taille_topic);
+    if (qos) MQTT_Ecrire_Mot(ecrivain,id);
+    MQTT_Ecrire_Octets(ecrivain,message,taille_message);
+
+    return ecrivain->longueur - depart;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Subscribe
+  DESCRIPTION   : Ajoute un paquet SUBSCRIBE
+  PARAMETRES    : Ecrivain, identifiant de paquet,
+                  filtres, QoS demandés, nombre de filtres
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Subscribe(MQTT_Ecrivain *ecrivain, uint16 id, const char * const *filtres, const uint8 *qos, uint8 nb_filtres)
+{
+    uint16 depart = ecrivain->longueur;
+    uint32 longueur = 2;
+
+    for (uint8 i = 0; i < nb_filtres; i++) longueur += 2 + MQTT_Taille_Chaine(filtres[i]) + 1;
+
+    if (!MQTT_Ecrire_Entete(ecrivain,(MQTT_SUBSCRIBE << 4) | 0x02,longueur)) return 0;
+
+    MQTT_Ecrire_Mot(ecrivain,id);
+    for (uint8 i = 0; i < nb_filtres; i++)
+    {
+        MQTT_Ecrire_Chaine(ecrivain,(const uint8*)filtres[i],MQTT_Taille_Chaine(filtres[i]));
+        MQTT_Ecrire_Octet(ecrivain,qos[i] & 0x3);
+    }
+
+    return ecrivain->longueur - depart;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Unsubscribe
+  DESCRIPTION   : Ajoute un paquet UNSUBSCRIBE
+  PARAMETRES    : Ecrivain, identifiant de paquet, filtres, nombre de filtres
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Unsubscribe(MQTT_Ecrivain *ecrivain, uint16 id, const char * const *filtres, uint8 nb_filtres)
+{
+    uint16 depart = ecrivain->longueur;
+    uint32 longueur = 2;
+
+    for (uint8 i = 0; i < nb_filtres; i++) longueur += 2 + MQTT_Taille_Chaine(filtres[i]);
+
+    if (!MQTT_Ecrire_Entete(ecrivain,(MQTT_UNSUBSCRIBE << 4) | 0x02,longueur)) return 0;
+
+    MQTT_Ecrire_Mot(ecrivain,id);
+    for (uint8 i = 0; i < nb_filtres; i++)
+    {
+        MQTT_Ecrire_Chaine(ecrivain,(const uint8*)filtres[i],MQTT_Taille_Chaine(filtres[i]));
+    }
+
+    return ecrivain->longueur - depart;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Ack
+  DESCRIPTION   : Ajoute un acquittement (PUBACK, PUBREC, PUBREL, PUBCOMP)
+  PARAMETRES    : Ecrivain, type de paquet, identifiant de paquet
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Ack(MQTT_Ecrivain *ecrivain, uint8 type, uint16 id)
+{
+    // PUBREL est le seul acquittement dont les drapeaux sont imposés (0b0010)
+    uint8 entete = (type << 4) | ((type == MQTT_PUBREL) ? 0x02 : 0x00);
+
+    if (!MQTT_Ecrire_Entete(ecrivain,entete,2)) return 0;
+    MQTT_Ecrire_Mot(ecrivain,id);
+
+    return 4;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Simple
+  DESCRIPTION   : Ajoute un paquet sans contenu (PINGREQ, DISCONNECT)
+  PARAMETRES    : Ecrivain, type de paquet
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Simple(MQTT_Ecrivain *ecrivain, uint8 type)
+{
+    if (!MQTT_Ecrire_Entete(ecrivain,type << 4,0)) return 0;
+    return 2;
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS DECODAGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_MQTT_Analyseur
+  DESCRIPTION   : Prépare l'analyse d'un flux de paquets
+  PARAMETRES    : Analyseur, buffer de réception, taille du buffer
+                  (taille maximale d'un paquet reçu, en-tête fixe exclu)
+  RETOUR        : rien
+===============================================================================*/
+void init_MQTT_Analyseur(MQTT_Analyseur *analyseur, uint8 *buffer, uint16 taille)
+{
+    analyseur->buffer = buffer;
+    analyseur->taille = taille;
+    analyseur->etat = ETAT_ENTETE;
+    analyseur->entete = 0;
+    analyseur->longueur = 0;
+    analyseur->decalage = 0;
+    analyseur->recus = 0;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Analyser_Octet
+  DESCRIPTION   : Fournit un octet reçu à l'analyseur
+  PARAMETRES    : Analyseur, octet reçu, paquet complété si MQTT_PAQUET_PRET
+                  (les vues restent valides jusqu'au prochain octet)
+  RETOUR        : Statut de l'analyse
+===============================================================================*/
+MQTT_Statut MQTT_Analyser_Octet(MQTT_Analyseur *analyseur, uint8 octet, MQTT_Paquet *paquet)
+{
+    switch (analyseur->etat)
+    {
+        case ETAT_ENTETE :
+            analyseur->entete = octet;
+            analyseur->longueur = 0;
+            analyseur->decalage = 0;
+            analyseur->recus = 0;
+            analyseur->etat = ETAT_LONGUEUR;
+            return MQTT_INCOMPLET;
+
+        case ETAT_LONGUEUR :
+            analyseur->longueur |= (uint32)(octet & 0x7F) << analyseur->decalage;
+            analyseur->decalage += 7;
+            if (octet & 0x80)
+            {
+                // La longueur est codée sur 4 octets au maximum
+                if (analyseur->decalage >= 28)
+                {
+                    analyseur->etat = ETAT_ENTETE;
+                    return MQTT_ERREUR_FORMAT;
+                }
+                return MQTT_INCOMPLET;
+            }
+            if (analyseur->longueur == 0)
+            {
+                analyseur->etat = ETAT_ENTETE;
+                return MQTT_Interpreter(analyseur->entete,analyseur->buffer,0,paquet) ? MQTT_PAQUET_PRET : MQTT_ERREUR_FORMAT;
+            }
+            analyseur->etat = (analyseur->longueur > analyseur->taille) ? ETAT_IGNORER : ETAT_CORPS;
+            return MQTT_INCOMPLET;
+
+        case ETAT_CORPS :
+            analyseur->buffer[analyseur->recus++] = octet;
+            if (analyseur->recus < analyseur->longueur) return MQTT_INCOMPLET;
+            analyseur->etat = ETAT_ENTETE;
+            return MQTT_Interpreter(analyseur->entete,analyseur->buffer,analyseur->longueur,paquet) ? MQTT_PAQUET_PRET : MQTT_ERREUR_FORMAT;
+
+        case ETAT_IGNORER :
+        default :
+            // Paquet trop grand pour le buffer : il est ignoré
+            if (++analyseur->recus < analyseur->longueur) return MQTT_INCOMPLET;
+            analyseur->etat = ETAT_ENTETE;
+            return MQTT_ERREUR_TAILLE;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Analyser_Buffer
+  DESCRIPTION   : Fournit un bloc d'octets reçus à l'analyseur
+  L'analyse s'arrête à la fin du premier paquet complet : l'appelant traite
+  le paquet puis rappelle la fonction avec les octets restants.
+  Un paquet entièrement contenu dans le bloc est analysé sur place (sans copie).
+  PARAMETRES    : Analyseur, octets reçus, nombre d'octets,
+                  paquet complété, statut de l'analyse
+  RETOUR        : Nombre d'octets consommés
+===============================================================================*/
+uint16 MQTT_Analyser_Buffer(MQTT_Analyseur *analyseur, const uint8 *donnees, uint16 len, MQTT_Paquet *paquet, MQTT_Statut *statut)
+{
+    *statut = MQTT_INCOMPLET;
+
+    // Chemin rapide : paquet complet dans le bloc, analysé sans copie
+    if (analyseur->etat == ETAT_ENTETE && len >= 2)
+    {
+        uint32 longueur = 0;
+        uint8 i = 1;
+        uint8 decalage = 0;
+        bool complete = false;
+
+        while (i < len && i <= 4)
+        {
+            longueur |= (uint32)(donnees[i] & 0x7F) << decalage;
+            decalage += 7;
+            if ((donnees[i++] & 0x80) == 0)
+            {
+                complete = true;
+                break;
+            }
+        }
+
+        if (complete && (uint32)i + longueur <= len)
+        {
+            *statut = MQTT_Interpreter(donnees[0],&donnees[i],longueur,paquet) ? MQTT_PAQUET_PRET : MQTT_ERREUR_FORMAT;
+            return i + longueur;
+        }
+    }
+
+    // Sinon : analyse octet par octet (copie dans le buffer de l'analyseur)
+    for (uint16 i = 0; i < len; i++)
+    {
+        *statut = MQTT_Analyser_Octet(analyseur,donnees[i],paquet);
+        if (*statut != MQTT_INCOMPLET) return i + 1;
+    }
+    return len;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Interpreter
+  DESCRIPTION   : Décode sur place le corps d'un paquet (après l'en-tête fixe)
+  PARAMETRES    : Premier octet de l'en-tête, corps, taille du corps, paquet
+  RETOUR        : true si le paquet est correctement formé
+===============================================================================*/
+bool MQTT_Interpreter(uint8 entete, const uint8 *corps, uint16 taille, MQTT_Paquet *paquet)
+{
+    uint16 position;
+
+    paquet->type = entete >> 4;
+    paquet->drapeaux = entete & 0x0F;
+    paquet->qos = (entete >> 1) & 0x3;
+    paquet->retain = entete & 0x01;
+    paquet->dup = (entete >> 3) & 0x01;
+    paquet->id = 0;
+    paquet->code_retour = 0;
+    paquet->session_presente = false;
+    paquet->topic.donnees = corps;
+    paquet->topic.taille = 0;
+    paquet->payload.donnees = corps;
+    paquet->payload.taille = taille;
+
+    switch (paquet->type)
+    {
+        case MQTT_CONNACK :
+            if (taille != 2) return false;
+            paquet->session_presente = corps[0] & 0x01;
+            paquet->code_retour = corps[1];
+            paquet->payload.taille = 0;
+        break;
+
+        case MQTT_PUBLISH :
+            if (taille < 2 || paquet->qos == 3) return false;
+            paquet->topic.taille = MQTT_Lire_Mot(corps);
+            paquet->topic.donnees = &corps[2];
+            // Longueur annoncée plus grande que le corps (2 + taille dépasserait aussi 16 bits)
+            if (paquet->topic.taille > taille - 2) return false;
+            position = 2 + paquet->topic.taille;
+            if (paquet->qos)
+            {
+                if (position + 2 > taille) return false;
+                paquet->id = MQTT_Lire_Mot(&corps[position]);
+                position += 2;
+            }
+            if (position > taille) return false;
+            paquet->payload.donnees = &corps[position];
+            paquet->payload.taille = taille - position;
+        break;
+
+        case MQTT_PUBACK :
+        case MQTT_PUBREC :
+        case MQTT_PUBREL :
+        case MQTT_PUBCOMP :
+        case MQTT_UNSUBACK :
+            if (taille != 2) return false;
+            paquet->id = MQTT_Lire_Mot(corps);
+            paquet->payload.taille = 0;
+        break;
+
+        case MQTT_SUBACK :
+            if (taille < 3) return false;
+            paquet->id = MQTT_Lire_Mot(corps);
+            paquet->payload.donnees = &corps[2];
+            paquet->payload.taille = taille - 2;
+        break;
+
+        case MQTT_PINGREQ :
+        case MQTT_PINGRESP :
+        case MQTT_DISCONNECT :
+            if (taille != 0) return false;
+        break;
+
+        default :
+            // Autres paquets : corps brut dans payload
+        break;
+    }
+    return true;
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS ABONNEMENTS
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_MQTT_Table_Abonnements
+  DESCRIPTION   : Vide une table d'abonnements
+  PARAMETRES    : Table
+  RETOUR        : rien
+===============================================================================*/
+void init_MQTT_Table_Abonnements(MQTT_Table_Abonnements *table)
+{
+    table->nb = 0;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Ajouter_Abonnement
+  DESCRIPTION   : Précompile un filtre et l'ajoute à la table
+  - chaque niveau texte est réduit à son empreinte et sa longueur
+  - '+' doit occuper un niveau entier, '#' doit être le dernier niveau
+  PARAMETRES    : Table, filtre (conservé par l'appelant), fonction associée (ou NULL)
+  RETOUR        : N° de l'abonnement, -1 si la table est pleine ou le filtre invalide
+===============================================================================*/
+int8 MQTT_Ajouter_Abonnement(MQTT_Table_Abonnements *table, const char *filtre, MQTT_Callback fonction)
+{
+    if (table->nb >= MQTT_NB_ABONNEMENTS_MAX || filtre == NULL) return -1;
+
+    MQTT_Abonnement *abonnement = &table->abonnements[table->nb];
+    uint32 taille = strlen(filtre);
+    uint32 debut = 0;
+    uint8 nb = 0;
+    uint32 empreinte = FNV_DEPART;
+
+    // Index sur 32 bits : "i <= taille" resterait toujours vrai pour un filtre de 65535 caractères
+    for (uint32 i = 0; i <= taille; i++)
+    {
+        if (i < taille && filtre[i] != '/')
+        {
+            empreinte = (empreinte ^ (uint8)filtre[i]) * FNV_PREMIER;
+            continue;
+        }
+
+        // Fin d'un niveau
+        if (nb >= MQTT_NB_NIVEAUX_MAX || (i - debut) > 0xFF) return -1;
+
+        MQTT_Niveau *niveau = &abonnement->niveaux[nb];
+        niveau->debut = debut;
+        niveau->longueur = i - debut;
+        niveau->empreinte = empreinte;
+        niveau->type = NIVEAU_TEXTE;
+
+        for (uint32 j = debut; j < i; j++)
+        {
+            if (filtre[j] == '+' || filtre[j] == '#')
+            {
+                if (niveau->longueur != 1) return -1;
+                niveau->type = (filtre[j] == '+') ? NIVEAU_PLUS : NIVEAU_DIESE;
+            }
+        }
+        if (niveau->type == NIVEAU_DIESE && i != taille) return -1;
+
+        nb++;
+        debut = i + 1;
+        empreinte = FNV_DEPART;
+    }
+
+    abonnement->filtre = filtre;
+    abonnement->nb_niveaux = nb;
+    abonnement->fonction = fonction;
+
+    return table->nb++;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Rechercher_Abonnements
+  DESCRIPTION   : Recherche les abonnements correspondant à un topic
+  (le topic n'est parcouru qu'une seule fois, puis seules les empreintes sont comparées)
+  PARAMETRES    : Table, topic
+  RETOUR        : Masque des abonnements correspondants (bit n = abonnement n)
+===============================================================================*/
+uint32 MQTT_Rechercher_Abonnements(const MQTT_Table_Abonnements *table, MQTT_Vue topic)
+{
+    MQTT_Niveau niveaux[MQTT_NB_NIVEAUX_MAX];
+    uint32 nb_niveaux = 0;
+    uint32 debut = 0;
+    uint32 empreinte = FNV_DEPART;
+    uint32 resultat = 0;
+
+    // Etape 1 : découpage du topic (au-delà de MQTT_NB_NIVEAUX_MAX, les niveaux sont seulement comptés)
+    // Index sur 32 bits : "i <= topic.taille" resterait toujours vrai pour un topic de 65535 octets
+    for (uint32 i = 0; i <= topic.taille; i++)
+    {
+        if (i < topic.taille && topic.donnees[i] != '/')
+        {
+            empreinte = (empreinte ^ topic.donnees[i]) * FNV_PREMIER;
+            continue;
+        }
+        if (nb_niveaux < MQTT_NB_NIVEAUX_MAX)
+        {
+            niveaux[nb_niveaux].debut = debut;
+            niveaux[nb_niveaux].longueur = i - debut;
+            niveaux[nb_niveaux].empreinte = empreinte;
+        }
+        nb_niveaux++;
+        debut = i + 1;
+        empreinte = FNV_DEPART;
+    }
+
+    // Les topics réservés ($SYS/...) ne correspondent pas aux filtres commençant par un joker
+    bool reserve = (topic.taille > 0 && topic.donnees[0] == '$');
+
+    // Etape 2 : comparaison avec chaque filtre précompilé
+    for (uint8 n = 0; n < table->nb; n++)
+    {
+        const MQTT_Abonnement *abonnement = &table->abonnements[n];
+        bool correspond = true;
+        bool diese = false;
+
+        for (uint8 k = 0; k < abonnement->nb_niveaux && correspond; k++)
+        {
+            const MQTT_Niveau *filtre = &abonnement->niveaux[k];
+
+            if (filtre->type != NIVEAU_TEXTE && k == 0 && reserve)
+            {
+                correspond = false;
+            }
+            else if (filtre->type == NIVEAU_DIESE)
+            {
+                diese = true;
+                break;
+            }
+            else if (k >= nb_niveaux)
+            {
+                correspond = false;
+            }
+            else if (filtre->type == NIVEAU_TEXTE)
+            {
+                correspond = (filtre->empreinte == niveaux[k].empreinte)
+                          && (filtre->longueur == niveaux[k].longueur)
+                          && (memcmp(&abonnement->filtre[filtre->debut],&topic.donnees[niveaux[k].debut],filtre->longueur) == 0);
+            }
+        }
+
+        if (correspond && (diese || nb_niveaux == abonnement->nb_niveaux))
+        {
+            resultat |= (1UL << n);
+        }
+    }
+
+    return resultat;
+}
+
+/*===============================================================================
+  FONCTION      : MQTT_Distribuer
+  DESCRIPTION   : Appelle la fonction de chaque abonnement correspondant
+                  au topic d'un paquet PUBLISH
+  PARAMETRES    : Table, paquet reçu
+  RETOUR        : Nombre d'abonnements correspondants
+===============================================================================*/
+uint8 MQTT_Distribuer(const MQTT_Table_Abonnements *table, const MQTT_Paquet *paquet)
+{
+    if (paquet->type != MQTT_PUBLISH) return 0;
+
+    uint32 masque = MQTT_Rechercher_Abonnements(table,paquet->topic);
+    uint8 nb = 0;
+
+    for (uint8 n = 0; masque != 0; n++, masque >>= 1)
+    {
+        if ((masque & 1) == 0) continue;
+        nb++;
+        if (table->abonnements[n].fonction != NULL) table->abonnements[n].fonction(paquet);
+    }
+    return nb;
+}
@@ -0,0 +1,279 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : MQTT.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Codage / décodage des paquets MQTT 3.1.1 sans allocation dynamique ni copie
+ *  - Les paquets sont construits directement dans un buffer fourni par l'appelant (linéaire ou circulaire)
+ *  - Les paquets reçus sont analysés sur place : topic et payload sont des "vues" sur le buffer de réception
+ *  - L'analyse peut se faire octet par octet (UART, socket) ou par blocs
+ *  - Les filtres d'abonnement (+ et #) sont précompilés pour accélérer la recherche des abonnements d'un topic
+ *
+ *  Lien utile : http://docs.oasis-open.org/mqtt/mqtt/v3.1.1/mqtt-v3.1.1.html
+ * =============================================================================================================================================
+ */
+
+#ifndef __MQTT_H__
+#define __MQTT_H__
+
+// Dépendance(s)
+#include "registres_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Types de paquets MQTT
+#define MQTT_CONNECT     1
+#define MQTT_CONNACK     2
+#define MQTT_PUBLISH     3
+#define MQTT_PUBACK      4
+#define MQTT_PUBREC      5
+#define MQTT_PUBREL      6
+#define MQTT_PUBCOMP     7
+#define MQTT_SUBSCRIBE   8
+#define MQTT_SUBACK      9
+#define MQTT_UNSUBSCRIBE 10
+#define MQTT_UNSUBACK    11
+#define MQTT_PINGREQ     12
+#define MQTT_PINGRESP    13
+#define MQTT_DISCONNECT  14
+
+// Nombre maximal de niveaux d'un filtre d'abonnement ("a/b/c" : 3 niveaux)
+#define MQTT_NB_NIVEAUX_MAX 8
+
+// Nombre maximal d'abonnements dans une table (32 au maximum : résultat sous forme de masque)
+#define MQTT_NB_ABONNEMENTS_MAX 16
+
+// Vue sur une zone mémoire (aucune copie : les données restent dans le buffer d'origine)
+typedef struct {
+  const uint8 *donnees;
+  uint16 taille;
+} MQTT_Vue;
+
+// Buffer d'écriture des paquets
+// En mode circulaire, la taille doit être une puissance de 2 et les octets sont écrits à partir de "debut"
+typedef struct {
+  uint8 *buffer;
+  uint16 taille;
+  uint16 debut;
+  uint16 longueur;     // nombre d'octets écrits depuis "debut"
+  bool circulaire;
+  bool erreur;         // le buffer est trop petit
+} MQTT_Ecrivain;
+
+// Options de connexion (les champs NULL sont omis)
+typedef struct {
+  const char *client_id;
+  const char *utilisateur;
+  const char *mot_de_passe;
+  const char *will_topic;
+  MQTT_Vue will_message;
+  uint8 will_qos;
+  bool will_retain;
+  bool clean_session;
+  uint16 keep_alive;   // secondes
+} MQTT_Options_Connexion;
+
+// Paquet reçu (les vues pointent sur le buffer de réception)
+typedef struct {
+  uint8 type;
+  uint8 drapeaux;      // 4 bits de poids faible de l'en-tête
+  uint8 qos;
+  bool retain;
+  bool dup;
+  uint16 id;           // identifiant de paquet (si présent)
+  uint8 code_retour;   // CONNACK
+  bool session_presente;
+  MQTT_Vue topic;      // PUBLISH
+  MQTT_Vue payload;    // PUBLISH : message / SUBACK : codes retour / autres : corps brut
+} MQTT_Paquet;
+
+// Résultat de l'analyse
+typedef enum {MQTT_INCOMPLET,MQTT_PAQUET_PRET,MQTT_ERREUR_FORMAT,MQTT_ERREUR_TAILLE} MQTT_Statut;
+
+// Analyseur de flux (un par connexion)
+typedef struct {
+  uint8 *buffer;       // buffer de réception fourni par l'appelant
+  uint16 taille;
+  uint8 etat;
+  uint8 entete;
+  uint32 longueur;     // longueur restante annoncée
+  uint8 decalage;      // décalage courant du codage de la longueur
+  uint32 recus;        // octets du corps reçus
+} MQTT_Analyseur;
+
+// Niveau précompilé d'un filtre d'abonnement
+typedef struct {
+  uint32 empreinte;    // empreinte FNV-1a du niveau
+  uint16 debut;        // position du niveau dans le filtre
+  uint8 longueur;
+  uint8 type;          // texte, '+' ou '#'
+} MQTT_Niveau;
+
+// Fonction appelée pour un message correspondant à un abonnement
+typedef void (*MQTT_Callback)(const MQTT_Paquet *paquet);
+
+// Abonnement précompilé
+typedef struct {
+  const char *filtre;  // chaîne conservée par l'appelant
+  uint8 nb_niveaux;
+  MQTT_Niveau niveaux[MQTT_NB_NIVEAUX_MAX];
+  MQTT_Callback fonction;
+} MQTT_Abonnement;
+
+// Table des abonnements
+typedef struct {
+  MQTT_Abonnement abonnements[MQTT_NB_ABONNEMENTS_MAX];
+  uint8 nb;
+} MQTT_Table_Abonnements;
+
+// ##########################################################################################################################
+//                                      FONCTIONS CODAGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_MQTT_Ecrivain
+  DESCRIPTION   : Prépare l'écriture d'un paquet dans un buffer
+  PARAMETRES    : Ecrivain à initialiser
+                  Buffer, taille du buffer
+                  Position de départ (mode circulaire uniquement)
+                  true pour un buffer circulaire (taille = puissance de 2)
+  RETOUR        : rien
+===============================================================================*/
+void init_MQTT_Ecrivain(MQTT_Ecrivain *ecrivain, uint8 *buffer, uint16 taille, uint16 debut, bool circulaire);
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Connect
+  DESCRIPTION   : Ajoute un paquet CONNECT
+  PARAMETRES    : Ecrivain, options de connexion
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Connect(MQTT_Ecrivain *ecrivain, const MQTT_Options_Connexion *options);
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Publish
+  DESCRIPTION   : Ajoute un paquet PUBLISH
+  PARAMETRES    : Ecrivain, topic, message, taille du message,
+                  QoS (0,1,2), retain, identifiant de paquet (ignoré en QoS 0)
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Publish(MQTT_Ecrivain *ecrivain, const char *topic, const uint8 *message, uint16 taille_message, uint8 qos, bool retain, uint16 id);
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Subscribe
+  DESCRIPTION   : Ajoute un paquet SUBSCRIBE
+  PARAMETRES    : Ecrivain, identifiant de paquet,
+                  filtres, QoS demandés, nombre de filtres
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Subscribe(MQTT_Ecrivain *ecrivain, uint16 id, const char * const *filtres, const uint8 *qos, uint8 nb_filtres);
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Unsubscribe
+  DESCRIPTION   : Ajoute un paquet UNSUBSCRIBE
+  PARAMETRES    : Ecrivain, identifiant de paquet, filtres, nombre de filtres
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Unsubscribe(MQTT_Ecrivain *ecrivain, uint16 id, const char * const *filtres, uint8 nb_filtres);
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Ack
+  DESCRIPTION   : Ajoute un acquittement (PUBACK, PUBREC, PUBREL, PUBCOMP)
+  PARAMETRES    : Ecrivain, type de paquet, identifiant de paquet
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Ack(MQTT_Ecrivain *ecrivain, uint8 type, uint16 id);
+
+/*===============================================================================
+  FONCTION      : MQTT_Encoder_Simple
+  DESCRIPTION   : Ajoute un paquet sans contenu (PINGREQ, DISCONNECT)
+  PARAMETRES    : Ecrivain, type de paquet
+  RETOUR        : Taille du paquet (0 si le buffer est trop petit)
+===============================================================================*/
+uint16 MQTT_Encoder_Simple(MQTT_Ecrivain *ecrivain, uint8 type);
+
+// ##########################################################################################################################
+//                                      FONCTIONS DECODAGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_MQTT_Analyseur
+  DESCRIPTION   : Prépare l'analyse d'un flux de paquets
+  PARAMETRES    : Analyseur, buffer de réception, taille du buffer
+                  (taille maximale d'un paquet reçu, en-tête fixe exclu)
+  RETOUR        : rien
+===============================================================================*/
+void init_MQTT_Analyseur(MQTT_Analyseur *analyseur, uint8 *buffer, uint16 taille);
+
+/*===============================================================================
+  FONCTION      : MQTT_Analyser_Octet
+  DESCRIPTION   : Fournit un octet reçu à l'analyseur
+  PARAMETRES    : Analyseur, octet reçu, paquet complété si MQTT_PAQUET_PRET
+                  (les vues restent valides jusqu'au prochain octet)
+  RETOUR        : Statut de l'analyse
+===============================================================================*/
+MQTT_Statut MQTT_Analyser_Octet(MQTT_Analyseur *analyseur, uint8 octet, MQTT_Paquet *paquet);
+
+/*===============================================================================
+  FONCTION      : MQTT_Analyser_Buffer
+  DESCRIPTION   : Fournit un bloc d'octets reçus à l'analyseur
+  L'analyse s'arrête à la fin du premier paquet complet : l'appelant traite
+  le paquet puis rappelle la fonction avec les octets restants.
+  Un paquet entièrement contenu dans le bloc est analysé sur place (sans copie).
+  PARAMETRES    : Analyseur, octets reçus, nombre d'octets,
+                  paquet complété, statut de l'analyse
+  RETOUR        : Nombre d'octets consommés
+===============================================================================*/
+uint16 MQTT_Analyser_Buffer(MQTT_Analyseur *analyseur, const uint8 *donnees, uint16 len, MQTT_Paquet *paquet, MQTT_Statut *statut);
+
+/*===============================================================================
+  FONCTION      : MQTT_Interpreter
+  DESCRIPTION   : Décode sur place le corps d'un paquet (après l'en-tête fixe)
+  PARAMETRES    : Premier octet de l'en-tête, corps, taille du corps, paquet
+  RETOUR        : true si le paquet est correctement formé
+===============================================================================*/
+bool MQTT_Interpreter(uint8 entete, const uint8 *corps, uint16 taille, MQTT_Paquet *paquet);
+
+// ##########################################################################################################################
+//                                      FONCTIONS ABONNEMENTS
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_MQTT_Table_Abonnements
+  DESCRIPTION   : Vide une table d'abonnements
+  PARAMETRES    : Table
+  RETOUR        : rien
+===============================================================================*/
+void init_MQTT_Table_Abonnements(MQTT_Table_Abonnements *table);
+
+/*===============================================================================
+  FONCTION      : MQTT_Ajouter_Abonnement
+  DESCRIPTION   : Précompile un filtre et l'ajoute à la table
+  PARAMETRES    : Table, filtre (conservé par l'appelant), fonction associée (ou NULL)
+  RETOUR        : N° de l'abonnement, -1 si la table est pleine ou le filtre invalide
+===============================================================================*/
+int8 MQTT_Ajouter_Abonnement(MQTT_Table_Abonnements *table, const char *filtre, MQTT_Callback fonction);
+
+/*===============================================================================
+  FONCTION      : MQTT_Rechercher_Abonnements
+  DESCRIPTION   : Recherche les abonnements correspondant à un topic
+  (le topic n'est parcouru qu'une seule fois, puis seules les empreintes sont comparées)
+  PARAMETRES    : Table, topic
+  RETOUR        : Masque des abonnements correspondants (bit n = abonnement n)
+===============================================================================*/
+uint32 MQTT_Rechercher_Abonnements(const MQTT_Table_Abonnements *table, MQTT_Vue topic);
+
+/*===============================================================================
+  FONCTION      : MQTT_Distribuer
+  DESCRIPTION   : Appelle la fonction de chaque abonnement correspondant
+                  au topic d'un paquet PUBLISH
+  PARAMETRES    : Table, paquet reçu
+  RETOUR        : Nombre d'abonnements correspondants
+===============================================================================*/
+uint8 MQTT_Distribuer(const MQTT_Table_Abonnements *table, const MQTT_Paquet *paquet);
+
+#endif
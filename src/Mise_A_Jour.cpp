@@ -0,0 +1,767 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Mise_A_Jour.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Mise à jour du programme par l'UART0, sans arrêter l'application
+ *  (voir Mise_A_Jour.h)
+ * =============================================================================================================================================
+ */
+
+#include "Mise_A_Jour.h"
+#include <string.h>
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+#define MAJ_MASQUE_RX (MAJ_TAILLE_RX - 1)
+#define MAJ_INT_RX ((1 << BIT_UART_INT_RXFIFO_FULL) | (1 << BIT_UART_INT_RXFIFO_TOUT) | (1 << BIT_UART_INT_RXFIFO_OVF))
+
+// Taille de l'en-tête d'une trame (commande, longueur, offset)
+#define MAJ_TAILLE_ENTETE 7
+
+// Mémoire RTC utilisateur (commande eboot)
+#define Registre_RTC_Utilisateur ((__Registre *) MAJ_EBOOT_ADRESSE)
+
+// Décodage d'une trame
+typedef enum{
+  TRAME_SYNC_1,
+  TRAME_SYNC_2,
+  TRAME_ENTETE,
+  TRAME_DONNEES,
+  TRAME_CRC
+}MAJ_Decodage;
+
+// Travail en flash en attente (une étape par appel de MAJ_Tache)
+typedef enum{
+  TRAVAIL_AUCUN,
+  TRAVAIL_SESSION_EFFACER,     // effacement du secteur de suivi (nouvelle session)
+  TRAVAIL_SESSION_ECRIRE,      // écriture de la session
+  TRAVAIL_CRC_REPRISE,         // reprise : CRC de la partie déjà écrite (un secteur par étape)
+  TRAVAIL_EFFACER,             // effacement du secteur qui reçoit le bloc
+  TRAVAIL_ECRIRE,              // écriture du bloc reçu
+  TRAVAIL_COPIE                // recopie depuis le programme en cours (MAJ_TAILLE_BLOC par étape)
+}MAJ_Travail;
+
+// Zones de flash
+MAJ_Zones Zones_MAJ;
+
+// Buffer de réception
+uint8 MAJ_RX[MAJ_TAILLE_RX];
+volatile uint16 maj_rx_ecriture = 0;
+volatile uint16 maj_rx_lecture = 0;
+
+// Trame en cours de décodage (données alignées pour la flash)
+MAJ_Decodage maj_decodage = TRAME_SYNC_1;
+uint16 maj_position = 0;
+uint8 Entete_Trame[MAJ_TAILLE_ENTETE];
+uint32 Bloc_MAJ[MAJ_TAILLE_BLOC / 4];
+uint8 Crc_Trame[4];
+uint8 maj_commande = 0;
+uint16 maj_longueur = 0;
+uint32 maj_offset_trame = 0;
+
+// Transfert
+MAJ_Etat maj_etat = MAJ_ETAT_INACTIF;
+MAJ_Session Session_MAJ;
+uint32 maj_offset = 0;                   // prochain octet de l'image attendu
+uint32 maj_crc = FLASH_CRC32_INIT;       // CRC de l'image relue jusqu'à maj_offset
+
+// Travail en attente
+MAJ_Travail maj_travail = TRAVAIL_AUCUN;
+MAJ_Travail maj_travail_suivant = TRAVAIL_AUCUN;
+uint32 maj_crc_position = 0;
+uint32 maj_copie_source = 0;
+uint32 maj_copie_reste = 0;
+uint32 Verification_MAJ[MAJ_TAILLE_BLOC / 4];
+
+MAJ_Statistiques Statistiques_MAJ;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Lire_Mot / Ecrire_Mot
+  DESCRIPTION   : Entier 32 bits en petit boutiste dans un buffer d'octets
+  PARAMETRES    : Buffer, (valeur)
+  RETOUR        : (valeur)
+===============================================================================*/
+static inline uint32 Lire_Mot(const uint8 *buffer)
+{
+    return (uint32)buffer[0] | ((uint32)buffer[1] << 8) | ((uint32)buffer[2] << 16) | ((uint32)buffer[3] << 24);
+}
+
+static inline void Ecrire_Mot(uint8 *buffer, uint32 valeur)
+{
+    buffer[0] = valeur & 0xFF;
+    buffer[1] = (valeur >> 8) & 0xFF;
+    buffer[2] = (valeur >> 16) & 0xFF;
+    buffer[3] = valeur >> 24;
+}
+
+/*===============================================================================
+  FONCTION      : Adresse_Suivi / Adresse_Reception
+  DESCRIPTION   : Adresses en flash du secteur de suivi, d'un octet de l'emplacement de réception
+  PARAMETRES    : rien / offset dans l'image
+  RETOUR        : Adresse
+===============================================================================*/
+static inline uint32 Adresse_Suivi()
+{
+    return (uint32)Zones_MAJ.secteur_config * FLASH_TAILLE_SECTEUR;
+}
+
+static inline uint32 Adresse_Reception(uint32 offset)
+{
+    return (uint32)Zones_MAJ.secteur_reception * FLASH_TAILLE_SECTEUR + offset;
+}
+
+/*===============================================================================
+  FONCTION      : CRC_Session
+  DESCRIPTION   : CRC 32 de la session (tous les champs sauf le CRC)
+  PARAMETRES    : Session
+  RETOUR        : CRC
+===============================================================================*/
+static uint32 CRC_Session(const MAJ_Session *session)
+{
+    return ~Flash_CRC32(FLASH_CRC32_INIT,session,sizeof(MAJ_Session) - 4);
+}
+
+/*===============================================================================
+  FONCTION      : CRC_Eboot
+  DESCRIPTION   : CRC d'une commande eboot (tous les champs sauf le CRC), calculé comme eboot :
+                  bit de poids fort en premier, initialisé à 0xFFFFFFFF, sans inversion finale
+  PARAMETRES    : Commande
+  RETOUR        : CRC
+===============================================================================*/
+static uint32 CRC_Eboot(const MAJ_Commande_Eboot *commande)
+{
+    const uint8 *octets = (const uint8 *)commande;
+    uint32 crc = 0xFFFFFFFF;
+
+    for (uint16 i = 0; i < sizeof(MAJ_Commande_Eboot) - 4; i++)
+    {
+        crc ^= (uint32)octets[i] << 24;
+        for (uint8 bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ MAJ_EBOOT_POLYNOME : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*===============================================================================
+  FONCTION      : Deposer_Commande_Eboot
+  DESCRIPTION   : Ecrit en mémoire RTC la commande de recopie de l'image reçue au début de la flash
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Deposer_Commande_Eboot()
+{
+    MAJ_Commande_Eboot commande;
+    const uint32 *mots = (const uint32 *)&commande;
+
+    memset(&commande,0,sizeof(MAJ_Commande_Eboot));
+    commande.magique = MAJ_EBOOT_MAGIQUE;
+    commande.action = MAJ_EBOOT_COPIE_BRUTE;
+    commande.arguments[0] = Adresse_Reception(0);
+    commande.arguments[1] = 0;
+    commande.arguments[2] = Session_MAJ.taille_image;
+    commande.crc = CRC_Eboot(&commande);
+
+    // La mémoire RTC n'accepte que des accès 32 bits
+    for (uint8 i = 0; i < sizeof(MAJ_Commande_Eboot) / 4; i++)
+    {
+        REGISTRE_ECRIRE(Registre_RTC_Utilisateur[i],mots[i]);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Secteurs_Termines
+  DESCRIPTION   : Compte les secteurs de l'image notés terminés dans le secteur de suivi
+  PARAMETRES    : Nombre maximal de secteurs
+  RETOUR        : Nombre de secteurs terminés consécutifs depuis le début de l'image
+===============================================================================*/
+static uint16 Secteurs_Termines(uint16 nb_max)
+{
+    uint16 nb = 0;
+    uint32 adresse = Adresse_Suivi() + MAJ_POSITION_SECTEURS;
+
+    while (nb < nb_max)
+    {
+        uint16 nb_mots = nb_max - nb;
+        if (nb_mots > MAJ_TAILLE_BLOC / 4) nb_mots = MAJ_TAILLE_BLOC / 4;
+        if (!Flash_Lire(adresse + 4 * nb,Verification_MAJ,4 * nb_mots)) break;
+        for (uint16 i = 0; i < nb_mots; i++)
+        {
+            if (Verification_MAJ[i] != 0) return nb;
+            nb++;
+        }
+    }
+    return nb;
+}
+
+/*===============================================================================
+  FONCTION      : Repondre
+  DESCRIPTION   : Envoie la réponse à une commande (offset = prochain octet attendu)
+  PARAMETRES    : Commande, statut
+  RETOUR        : rien
+===============================================================================*/
+static void Repondre(uint8 commande, MAJ_Statut statut)
+{
+    uint8 reponse[2 + MAJ_TAILLE_ENTETE + 1 + 4];
+
+    reponse[0] = MAJ_SYNC_1;
+    reponse[1] = MAJ_SYNC_2;
+    reponse[2] = commande | MAJ_REPONSE;
+    reponse[3] = 1;
+    reponse[4] = 0;
+    Ecrire_Mot(&reponse[5],maj_offset);
+    reponse[9] = statut;
+    Ecrire_Mot(&reponse[10],~Flash_CRC32(FLASH_CRC32_INIT,&reponse[2],MAJ_TAILLE_ENTETE + 1));
+
+    // Octets bruts (UART_WriteBuffer transformerait un 0x0A en "\r\n")
+    for (uint8 i = 0; i < sizeof(reponse); i++)
+    {
+        UART_send_tx(MAJ_UART,reponse[i]);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Ecrire_Bloc
+  DESCRIPTION   : Ecrit Bloc_MAJ à l'offset attendu de l'emplacement de réception, le relit,
+                  poursuit le CRC de l'image et note le secteur s'il est terminé
+                  (le bloc n'est accepté que si la note est écrite : sinon la reprise serait fausse)
+  PARAMETRES    : Nombre d'octets (MAJ_TAILLE_BLOC au plus)
+  RETOUR        : Statut
+===============================================================================*/
+static MAJ_Statut Ecrire_Bloc(uint16 taille)
+{
+    uint8 *octets = (uint8 *)Bloc_MAJ;
+    uint16 taille_alignee = FLASH_ALIGNER(taille);
+    uint32 adresse = Adresse_Reception(maj_offset);
+
+    // Fin de l'image : le dernier mot est complété comme de la flash effacée
+    for (uint16 i = taille; i < taille_alignee; i++) octets[i] = 0xFF;
+
+    if (!Flash_Ecrire(adresse,Bloc_MAJ,taille_alignee) ||
+        !Flash_Lire(adresse,Verification_MAJ,taille_alignee) ||
+        memcmp(Bloc_MAJ,Verification_MAJ,taille_alignee) != 0)
+    {
+        Statistiques_MAJ.nb_erreurs_flash++;
+        return MAJ_ERREUR_FLASH;
+    }
+    uint32 fin = maj_offset + taille;
+
+    // Secteur terminé : noté dans le secteur de suivi (un mot passé à 0, sans effacement)
+    if ((fin % FLASH_TAILLE_SECTEUR) == 0 || fin == Session_MAJ.taille_image)
+    {
+        uint32 zero = 0;
+        uint32 secteur = (fin - 1) / FLASH_TAILLE_SECTEUR;
+        if (!Flash_Ecrire(Adresse_Suivi() + MAJ_POSITION_SECTEURS + 4 * secteur,&zero,4))
+        {
+            // Bloc refusé : l'outil le renvoie, il est réécrit à l'identique
+            Statistiques_MAJ.nb_erreurs_flash++;
+            return MAJ_ERREUR_FLASH;
+        }
+    }
+    maj_crc = Flash_CRC32(maj_crc,Verification_MAJ,taille);
+    maj_offset = fin;
+    return MAJ_OK;
+}
+
+/*===============================================================================
+  FONCTION      : Verifier_Bloc
+  DESCRIPTION   : Vérifie qu'un bloc de l'image peut être écrit à l'offset attendu
+  PARAMETRES    : Offset du bloc, nombre d'octets
+  RETOUR        : Statut
+===============================================================================*/
+static MAJ_Statut Verifier_Bloc(uint32 offset, uint32 taille)
+{
+    if (maj_etat != MAJ_ETAT_RECEPTION) return MAJ_ERREUR_ETAT;
+    if (offset != maj_offset) return MAJ_ERREUR_OFFSET;
+
+    // Bloc non vide, dans un seul secteur, dans l'image, multiple de 4 octets (sauf le dernier)
+    if (taille == 0 || (offset % FLASH_TAILLE_SECTEUR) + taille > FLASH_TAILLE_SECTEUR ||
+        offset + taille > Session_MAJ.taille_image ||
+        ((taille & 3) != 0 && offset + taille != Session_MAJ.taille_image))
+    {
+        return MAJ_ERREUR_TAILLE;
+    }
+    return MAJ_OK;
+}
+
+/*===============================================================================
+  FONCTION      : Commencer_Bloc
+  DESCRIPTION   : Lance l'écriture d'un bloc (précédée de l'effacement en début de secteur)
+  PARAMETRES    : Travail d'écriture (TRAVAIL_ECRIRE ou TRAVAIL_COPIE)
+  RETOUR        : rien
+===============================================================================*/
+static void Commencer_Bloc(MAJ_Travail travail)
+{
+    if ((maj_offset % FLASH_TAILLE_SECTEUR) == 0)
+    {
+        maj_travail = TRAVAIL_EFFACER;
+        maj_travail_suivant = travail;
+    }
+    else
+    {
+        maj_travail = travail;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Commande_Debut
+  DESCRIPTION   : MAJ_DEBUT : ouvre une session, ou reprend la session de la même image
+  PARAMETRES    : rien (trame dans Entete_Trame / Bloc_MAJ)
+  RETOUR        : Statut (MAJ_OK : la réponse est envoyée à la fin du travail)
+===============================================================================*/
+static MAJ_Statut Commande_Debut()
+{
+    const uint8 *donnees = (const uint8 *)Bloc_MAJ;
+    MAJ_Session session;
+
+    if (maj_longueur != 8) return MAJ_ERREUR_TRAME;
+    if (maj_etat == MAJ_ETAT_TERMINEE) return MAJ_ERREUR_ETAT;
+
+    uint32 taille = Lire_Mot(&donnees[0]);
+    uint32 crc = Lire_Mot(&donnees[4]);
+    if (taille == 0 || taille > (uint32)Zones_MAJ.nb_secteurs * FLASH_TAILLE_SECTEUR) return MAJ_ERREUR_TAILLE;
+
+    maj_etat = MAJ_ETAT_RECEPTION;
+    maj_offset = 0;
+    maj_crc = FLASH_CRC32_INIT;
+
+    // Même image que la session en flash : reprise au premier secteur incomplet
+    if (Flash_Lire(Adresse_Suivi() + MAJ_POSITION_SESSION,&session,sizeof(MAJ_Session)) &&
+        session.magique == MAJ_MAGIQUE_SESSION && session.crc == CRC_Session(&session) &&
+        session.taille_image == taille && session.crc_image == crc)
+    {
+        Session_MAJ = session;
+        uint16 nb_secteurs = (taille + FLASH_TAILLE_SECTEUR - 1) / FLASH_TAILLE_SECTEUR;
+        uint32 reprise = (uint32)Secteurs_Termines(nb_secteurs) * FLASH_TAILLE_SECTEUR;
+        if (reprise > taille) reprise = taille;
+        if (reprise > 0) Statistiques_MAJ.nb_reprises++;
+
+        // Le CRC de la partie déjà écrite est recalculé sur la flash
+        maj_crc_position = 0;
+        maj_offset = reprise;
+        maj_travail = TRAVAIL_CRC_REPRISE;
+        return MAJ_OK;
+    }
+
+    // Nouvelle session : secteur de suivi effacé puis session écrite
+    Session_MAJ.magique = MAJ_MAGIQUE_SESSION;
+    Session_MAJ.taille_image = taille;
+    Session_MAJ.crc_image = crc;
+    Session_MAJ.crc = CRC_Session(&Session_MAJ);
+    maj_travail = TRAVAIL_SESSION_EFFACER;
+    return MAJ_OK;
+}
+
+/*===============================================================================
+  FONCTION      : Executer_Trame
+  DESCRIPTION   : Exécute la trame reçue : lance le travail en flash,
+                  ou répond immédiatement si la commande est refusée (ou sans travail)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Executer_Trame()
+{
+    const uint8 *donnees = (const uint8 *)Bloc_MAJ;
+    MAJ_Statut statut = MAJ_OK;
+
+    switch (maj_commande)
+    {
+        case MAJ_DEBUT :
+            statut = Commande_Debut();
+            break;
+
+        case MAJ_DONNEES :
+            statut = Verifier_Bloc(maj_offset_trame,maj_longueur);
+            if (statut == MAJ_OK) Commencer_Bloc(TRAVAIL_ECRIRE);
+            break;
+
+        case MAJ_COPIE :
+            if (maj_longueur != 8)
+            {
+                statut = MAJ_ERREUR_TRAME;
+                break;
+            }
+            maj_copie_source = Lire_Mot(&donnees[0]);
+            maj_copie_reste = Lire_Mot(&donnees[4]);
+            statut = Verifier_Bloc(maj_offset_trame,maj_copie_reste);
+            if (statut == MAJ_OK && ((maj_copie_source & 3) != 0 ||
+                maj_copie_source + maj_copie_reste > (uint32)Zones_MAJ.nb_secteurs * FLASH_TAILLE_SECTEUR))
+            {
+                statut = MAJ_ERREUR_TAILLE;
+            }
+            if (statut == MAJ_OK) Commencer_Bloc(TRAVAIL_COPIE);
+            break;
+
+        case MAJ_FIN :
+            if (maj_etat != MAJ_ETAT_RECEPTION) statut = MAJ_ERREUR_ETAT;
+            else if (maj_offset != Session_MAJ.taille_image) statut = MAJ_ERREUR_OFFSET;
+            else if (~maj_crc != Session_MAJ.crc_image)
+            {
+                // Image fausse : session invalidée (magique passé à 0, sans effacement),
+                // le prochain transfert repart du début
+                uint32 zero = 0;
+                Flash_Ecrire(Adresse_Suivi() + MAJ_POSITION_SESSION,&zero,4);
+                maj_etat = MAJ_ETAT_INACTIF;
+                statut = MAJ_ERREUR_IMAGE;
+            }
+            else
+            {
+                // Image complète : recopie par eboot au prochain redémarrage
+                Deposer_Commande_Eboot();
+                maj_etat = MAJ_ETAT_TERMINEE;
+            }
+            break;
+
+        case MAJ_ABANDON :
+            if (maj_etat == MAJ_ETAT_TERMINEE) statut = MAJ_ERREUR_ETAT;
+            else maj_etat = MAJ_ETAT_INACTIF;
+            break;
+
+        default :
+            statut = MAJ_ERREUR_TRAME;
+            break;
+    }
+
+    if (statut != MAJ_OK || maj_travail == TRAVAIL_AUCUN)
+    {
+        Repondre(maj_commande,statut);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Decoder_Octet
+  DESCRIPTION   : Avance le décodage d'une trame d'un octet
+  PARAMETRES    : Octet reçu
+  RETOUR        : true si une trame complète a été traitée
+===============================================================================*/
+static bool Decoder_Octet(uint8 octet)
+{
+    switch (maj_decodage)
+    {
+        case TRAME_SYNC_1 :
+            if (octet == MAJ_SYNC_1) maj_decodage = TRAME_SYNC_2;
+            return false;
+
+        case TRAME_SYNC_2 :
+            if (octet == MAJ_SYNC_2)
+            {
+                maj_decodage = TRAME_ENTETE;
+                maj_position = 0;
+            }
+            else if (octet != MAJ_SYNC_1)
+            {
+                maj_decodage = TRAME_SYNC_1;
+            }
+            return false;
+
+        case TRAME_ENTETE :
+            Entete_Trame[maj_position++] = octet;
+            if (maj_position == MAJ_TAILLE_ENTETE)
+            {
+                maj_commande = Entete_Trame[0];
+                maj_longueur = Entete_Trame[1] | (Entete_Trame[2] << 8);
+                maj_offset_trame = Lire_Mot(&Entete_Trame[3]);
+                maj_position = 0;
+                if (maj_longueur > MAJ_TAILLE_BLOC)
+                {
+                    // Longueur impossible : resynchronisation sur la trame suivante
+                    Statistiques_MAJ.nb_erreurs_trame++;
+                    maj_decodage = TRAME_SYNC_1;
+                }
+                else
+                {
+                    maj_decodage = (maj_longueur > 0) ? TRAME_DONNEES : TRAME_CRC;
+                }
+            }
+            return false;
+
+        case TRAME_DONNEES :
+            ((uint8 *)Bloc_MAJ)[maj_position++] = octet;
+            if (maj_position == maj_longueur)
+            {
+                maj_position = 0;
+                maj_decodage = TRAME_CRC;
+            }
+            return false;
+
+        case TRAME_CRC :
+        default :
+            Crc_Trame[maj_position++] = octet;
+            if (maj_position < 4) return false;
+            maj_decodage = TRAME_SYNC_1;
+
+            uint32 crc = Flash_CRC32(FLASH_CRC32_INIT,Entete_Trame,MAJ_TAILLE_ENTETE);
+            crc = ~Flash_CRC32(crc,Bloc_MAJ,maj_longueur);
+            if (crc != Lire_Mot(Crc_Trame))
+            {
+                Statistiques_MAJ.nb_erreurs_trame++;
+                Repondre(maj_commande,MAJ_ERREUR_TRAME);
+                return true;
+            }
+            Statistiques_MAJ.nb_trames++;
+            Executer_Trame();
+            return true;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Etape_Travail
+  DESCRIPTION   : Fait une étape du travail en flash en attente
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Etape_Travail()
+{
+    MAJ_Statut statut = MAJ_OK;
+
+    switch (maj_travail)
+    {
+        case TRAVAIL_SESSION_EFFACER :
+            if (!Flash_Effacer_Secteur(Zones_MAJ.secteur_config))
+            {
+                // Le transfert est à recommencer
+                Statistiques_MAJ.nb_erreurs_flash++;
+                maj_etat = MAJ_ETAT_INACTIF;
+                statut = MAJ_ERREUR_FLASH;
+                break;
+            }
+            Statistiques_MAJ.nb_effacements++;
+            maj_travail = TRAVAIL_SESSION_ECRIRE;
+            return;
+
+        case TRAVAIL_SESSION_ECRIRE :
+            if (!Flash_Ecrire(Adresse_Suivi() + MAJ_POSITION_SESSION,&Session_MAJ,sizeof(MAJ_Session)))
+            {
+                Statistiques_MAJ.nb_erreurs_flash++;
+                maj_etat = MAJ_ETAT_INACTIF;
+                statut = MAJ_ERREUR_FLASH;
+            }
+            break;
+
+        case TRAVAIL_CRC_REPRISE :
+        {
+            // Un secteur relu par étape
+            uint32 fin = maj_crc_position + FLASH_TAILLE_SECTEUR;
+            if (fin > maj_offset) fin = maj_offset;
+            while (maj_crc_position < fin)
+            {
+                uint32 taille = fin - maj_crc_position;
+                if (taille > MAJ_TAILLE_BLOC) taille = MAJ_TAILLE_BLOC;
+                if (!Flash_Lire(Adresse_Reception(maj_crc_position),Verification_MAJ,FLASH_ALIGNER(taille)))
+                {
+                    // Relecture impossible : le transfert repart du début
+                    maj_offset = maj_crc_position = 0;
+                    maj_crc = FLASH_CRC32_INIT;
+                    Statistiques_MAJ.nb_erreurs_flash++;
+                    break;
+                }
+                maj_crc = Flash_CRC32(maj_crc,Verification_MAJ,taille);
+                maj_crc_position += taille;
+            }
+            if (maj_crc_position < maj_offset) return;
+            break;
+        }
+
+        case TRAVAIL_EFFACER :
+            if (!Flash_Effacer_Secteur(Zones_MAJ.secteur_reception + maj_offset / FLASH_TAILLE_SECTEUR))
+            {
+                Statistiques_MAJ.nb_erreurs_flash++;
+                statut = MAJ_ERREUR_FLASH;
+                break;
+            }
+            Statistiques_MAJ.nb_effacements++;
+            maj_travail = maj_travail_suivant;
+            return;
+
+        case TRAVAIL_ECRIRE :
+            statut = Ecrire_Bloc(maj_longueur);
+            if (statut == MAJ_OK) Statistiques_MAJ.octets_recus += maj_longueur;
+            break;
+
+        case TRAVAIL_COPIE :
+        {
+            uint16 taille = (maj_copie_reste > MAJ_TAILLE_BLOC) ? MAJ_TAILLE_BLOC : maj_copie_reste;
+            if (!Flash_Lire(maj_copie_source,Bloc_MAJ,FLASH_ALIGNER(taille)))
+            {
+                Statistiques_MAJ.nb_erreurs_flash++;
+                statut = MAJ_ERREUR_FLASH;
+                break;
+            }
+            statut = Ecrire_Bloc(taille);
+            if (statut != MAJ_OK) break;
+            Statistiques_MAJ.octets_copies += taille;
+            maj_copie_source += taille;
+            maj_copie_reste -= taille;
+            if (maj_copie_reste > 0) return;
+            break;
+        }
+
+        case TRAVAIL_AUCUN :
+        default :
+            return;
+    }
+
+    // Travail terminé (ou en échec) : réponse à la commande
+    maj_travail = TRAVAIL_AUCUN;
+    Repondre(maj_commande,statut);
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS MISE A JOUR
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Mise_A_Jour
+  DESCRIPTION   : Prend l'UART0 (8N1) pour recevoir les trames
+  PARAMETRES    : Vitesse de communication (Bauds), zones de flash
+  RETOUR        : false si les zones sont invalides (taille nulle ou trop grande, zones qui se chevauchent)
+===============================================================================*/
+bool init_Mise_A_Jour(uint32 Bauds, const MAJ_Zones *zones)
+{
+    // Etape 1 : zones (le programme en cours occupe les nb_secteurs premiers secteurs)
+    if (zones->nb_secteurs == 0 || zones->nb_secteurs > MAJ_NB_SECTEURS_MAX) return false;
+    if (zones->secteur_reception < zones->nb_secteurs) return false;
+    if (zones->secteur_config < zones->secteur_reception + zones->nb_secteurs &&
+        (zones->secteur_config < zones->nb_secteurs || zones->secteur_config >= zones->secteur_reception)) return false;
+    Zones_MAJ = *zones;
+
+    maj_etat = MAJ_ETAT_INACTIF;
+    maj_travail = TRAVAIL_AUCUN;
+    maj_decodage = TRAME_SYNC_1;
+    maj_rx_ecriture = maj_rx_lecture = 0;
+    memset(&Statistiques_MAJ,0,sizeof(MAJ_Statistiques));
+
+    // Etape 2 : UART0 en 8N1, fifos vidées
+    init_UART(MAJ_UART,Bauds,DATA_8,NONE,STOP_1);
+    REGISTRE_CONFIG_OU(Registre_UART0->CONF0,(1 << BIT_UART_RXFIFO_RST) | (1 << BIT_UART_TXFIFO_RST));
+    REGISTRE_CONFIG_ET(Registre_UART0->CONF0,~((1 << BIT_UART_RXFIFO_RST) | (1 << BIT_UART_TXFIFO_RST)));
+
+    // Etape 3 : interruptions de réception
+    Set_buffer_to_Registre(&Registre_UART0->CONF1,BIT_UART_RXFIFO_FULL_THRHD,MAJ_SEUIL_RX,7);
+    Set_buffer_to_Registre(&Registre_UART0->CONF1,BIT_UART_RX_TOUT_THRHD,MAJ_TIMEOUT_RX,7);
+    REGISTRE_CONFIG_SET_BIT(Registre_UART0->CONF1,BIT_UART_RX_TOUT_EN);
+
+    UART_Desactiver_Interruption(MAJ_UART,0x1FF);
+    UART_Attacher_Interruption(MAJ_UART,Interruption_Mise_A_Jour);
+    ETS_UART_INTR_DISABLE();
+    UART_Activer_Interruption(MAJ_UART,MAJ_INT_RX);
+    ETS_UART_INTR_ENABLE();
+
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : MAJ_Tache
+  DESCRIPTION   : Avance d'une étape : traite les octets reçus jusqu'à une trame complète,
+                  ou fait une opération en flash (effacement d'un secteur, écriture d'un bloc)
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste du travail en attente
+===============================================================================*/
+bool MAJ_Tache()
+{
+    // Travail en cours : la trame suivante attend dans le buffer (l'outil attend la réponse)
+    if (maj_travail != TRAVAIL_AUCUN)
+    {
+        Etape_Travail();
+        return true;
+    }
+
+    while (maj_rx_lecture != maj_rx_ecriture)
+    {
+        uint8 octet = MAJ_RX[maj_rx_lecture & MAJ_MASQUE_RX];
+        maj_rx_lecture++;
+        if (Decoder_Octet(octet)) break;
+    }
+    return maj_travail != TRAVAIL_AUCUN || maj_rx_lecture != maj_rx_ecriture;
+}
+
+/*===============================================================================
+  FONCTION      : MAJ_Traiter_Octet
+  DESCRIPTION   : Ajoute un octet reçu au buffer de réception
+  (utilisée par l'interruption, utilisable pour une autre source d'octets)
+  PARAMETRES    : Octet
+  RETOUR        : false si le buffer est plein (octet perdu)
+===============================================================================*/
+bool ICACHE_RAM_ATTR MAJ_Traiter_Octet(uint8 octet)
+{
+    if ((uint16)(maj_rx_ecriture - maj_rx_lecture) >= MAJ_TAILLE_RX)
+    {
+        Statistiques_MAJ.nb_perdus_rx++;
+        return false;
+    }
+    MAJ_RX[maj_rx_ecriture & MAJ_MASQUE_RX] = octet;
+    maj_rx_ecriture++;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : MAJ_Lire_Etat
+  DESCRIPTION   : Etat de la mise à jour
+  PARAMETRES    : rien
+  RETOUR        : MAJ_ETAT_TERMINEE lorsque la commande eboot est déposée (redémarrer)
+===============================================================================*/
+MAJ_Etat MAJ_Lire_Etat()
+{
+    return maj_etat;
+}
+
+/*===============================================================================
+  FONCTION      : MAJ_Lire_Commande_Eboot
+  DESCRIPTION   : Lit la commande déposée en mémoire RTC pour eboot
+  PARAMETRES    : Commande lue
+  RETOUR        : true si une commande valide (magique et CRC) est en attente
+===============================================================================*/
+bool MAJ_Lire_Commande_Eboot(MAJ_Commande_Eboot *commande)
+{
+    uint32 *mots = (uint32 *)commande;
+
+    for (uint8 i = 0; i < sizeof(MAJ_Commande_Eboot) / 4; i++)
+    {
+        mots[i] = REGISTRE_LIRE(Registre_RTC_Utilisateur[i]);
+    }
+    return commande->magique == MAJ_EBOOT_MAGIQUE && commande->crc == CRC_Eboot(commande);
+}
+
+/*===============================================================================
+  FONCTION      : MAJ_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la mise à jour
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const MAJ_Statistiques *MAJ_Lire_Statistiques()
+{
+    return &Statistiques_MAJ;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Mise_A_Jour
+  DESCRIPTION   : Interruption UART0 : vide la fifo RX dans le buffer de réception
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Mise_A_Jour(uint8 UART, uint32 statut)
+{
+    if (READ_BIT(statut,BIT_UART_INT_RXFIFO_OVF))
+    {
+        Statistiques_MAJ.nb_perdus_rx++;
+    }
+    if (statut & MAJ_INT_RX)
+    {
+        uint8 nb_fifo = (REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_RXFIFO_CNT) & 0xFF;
+        while (nb_fifo--)
+        {
+            MAJ_Traiter_Octet(REGISTRE_LIRE(Registre_UART0->FIFO) & 0xFF);
+        }
+    }
+}
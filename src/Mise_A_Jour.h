@@ -0,0 +1,219 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Mise_A_Jour.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Mise à jour du programme par l'UART0, sans arrêter l'application
+ *
+ *  L'image reçue est écrite dans un emplacement de réception, hors du programme en cours d'exécution
+ *  (qui commence au secteur 0). A la fin du transfert, une commande de recopie est déposée pour le chargeur
+ *  de démarrage eboot (celui du SDK Arduino, au début de la flash) : au redémarrage suivant, eboot recopie
+ *  l'emplacement de réception au début de la flash puis démarre le nouveau programme.
+ *
+ *  Transfert : l'outil de la passerelle envoie des trames, une à la fois, et attend la réponse avant la suivante
+ *    trame   : 0xA5 0x5A | commande (1) | longueur (2) | offset (4) | données (longueur) | CRC 32 (4)
+ *    réponse : même format, commande | MAJ_REPONSE, offset = prochain octet attendu, données = statut (1 octet)
+ *    (entiers en petit boutiste, CRC 32 de zlib sur commande...données)
+ *  - MAJ_DEBUT   : données = taille et CRC 32 de l'image ; la réponse donne l'offset de reprise
+ *  - MAJ_DONNEES : bloc de l'image (MAJ_TAILLE_BLOC au plus) à l'offset attendu
+ *  - MAJ_COPIE   : données = offset source et longueur : bloc recopié depuis le programme en cours
+ *                  (image "delta" : l'outil n'envoie que les blocs modifiés)
+ *  - MAJ_FIN     : vérifie le CRC de l'image et dépose la commande de recopie pour eboot
+ *  - MAJ_ABANDON : abandonne le transfert (aucune commande déposée)
+ *  Une trame refusée (CRC, offset inattendu, erreur de flash) est simplement renvoyée par l'outil à l'offset
+ *  indiqué par la réponse.
+ *
+ *  Le travail en flash est fait par MAJ_Tache, une étape par appel (un effacement de secteur ou l'écriture d'un bloc),
+ *  appelée sur le temps libre du scheduler (Scheduler_Set_Tache_Fond) : les tâches 1ms et 1s continuent pendant le transfert.
+ *  - chaque bloc écrit est relu : le CRC 32 de l'image est calculé sur le contenu réel de la flash
+ *  - chaque secteur terminé est noté dans le secteur de suivi (un mot passé à 0, sans effacement) : après une coupure
+ *    (liaison ou alimentation), MAJ_DEBUT avec la même image reprend au premier secteur incomplet
+ *
+ *  Activation : la commande eboot (ACTION_COPY_RAW : source, destination 0, taille ; CRC 32) est écrite en mémoire RTC
+ *  utilisateur, qui est conservée par un redémarrage logiciel ; l'application redémarre lorsque MAJ_Lire_Etat()
+ *  vaut MAJ_ETAT_TERMINEE. Une coupure d'alimentation avant le redémarrage efface la commande : l'ancien programme
+ *  démarre, et MAJ_DEBUT puis MAJ_FIN avec la même image (déjà entièrement notée) la déposent à nouveau.
+ *  /!\ eboot ne reprend pas une recopie interrompue par une coupure d'alimentation (limite du chargeur)
+ *
+ *  /!\ La mise à jour prend l'interruption de l'UART0 (comme la console) : init_Mise_A_Jour est en général
+ *      appelée par une commande de la console, qui n'est plus utilisable ensuite
+ * =============================================================================================================================================
+ */
+
+#ifndef __MISE_A_JOUR_H__
+#define __MISE_A_JOUR_H__
+
+// Dépendances
+#include "Flash_esp8266.h"
+#include "UART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// UART utilisée
+#define MAJ_UART UART0
+
+// Taille maximale des données d'une trame (diviseur de FLASH_TAILLE_SECTEUR)
+#define MAJ_TAILLE_BLOC 256
+
+// Buffer de réception (puissance de 2, une trame complète au moins)
+#define MAJ_TAILLE_RX 512
+
+// Seuils des interruptions de l'UART
+#define MAJ_SEUIL_RX   64 // octets dans la fifo RX
+#define MAJ_TIMEOUT_RX 2  // durée d'un octet sans réception
+
+// Octets de synchronisation d'une trame
+#define MAJ_SYNC_1 0xA5
+#define MAJ_SYNC_2 0x5A
+
+// Bit ajouté à la commande dans une réponse
+#define MAJ_REPONSE 0x80
+
+// Identification de la session dans le secteur de suivi
+#define MAJ_MAGIQUE_SESSION 0x3153414D // "MAS1"
+
+// Commande du chargeur de démarrage eboot, en mémoire RTC utilisateur
+#define MAJ_EBOOT_ADRESSE      ADDR_RTCU
+#define MAJ_EBOOT_MAGIQUE      0xEB001000
+#define MAJ_EBOOT_COPIE_BRUTE  0x00000001 // ACTION_COPY_RAW : arguments = source, destination, taille (octets)
+#define MAJ_EBOOT_NB_ARGUMENTS 29
+#define MAJ_EBOOT_POLYNOME     0x04C11DB7 // CRC 32 bit de poids fort en premier, initialisé à 0xFFFFFFFF, non inversé
+
+// Commandes
+typedef enum{
+  MAJ_DEBUT = 1,
+  MAJ_DONNEES,
+  MAJ_COPIE,
+  MAJ_FIN,
+  MAJ_ABANDON
+}MAJ_Commande;
+
+// Statut renvoyé dans une réponse
+typedef enum{
+  MAJ_OK = 0,
+  MAJ_ERREUR_TRAME,            // CRC de trame faux ou commande inconnue
+  MAJ_ERREUR_OFFSET,           // offset inattendu (la réponse donne l'offset attendu)
+  MAJ_ERREUR_TAILLE,           // longueur invalide (image trop grande, bloc à cheval sur deux secteurs...)
+  MAJ_ERREUR_ETAT,             // commande impossible dans l'état courant
+  MAJ_ERREUR_FLASH,            // écriture ou relecture de la flash en échec
+  MAJ_ERREUR_IMAGE             // CRC de l'image faux (transfert à reprendre depuis le début)
+}MAJ_Statut;
+
+// Etat de la mise à jour
+typedef enum{
+  MAJ_ETAT_INACTIF = 0,
+  MAJ_ETAT_RECEPTION,
+  MAJ_ETAT_TERMINEE            // commande eboot déposée : redémarrer
+}MAJ_Etat;
+
+// Zones de flash (en secteurs)
+typedef struct{
+  uint16 secteur_reception;    // premier secteur de l'emplacement de réception
+  uint16 nb_secteurs;          // taille maximale de l'image (le programme en cours commence au secteur 0)
+  uint16 secteur_config;       // secteur de suivi du transfert (session, secteurs terminés)
+}MAJ_Zones;
+
+// Commande lue par eboot au démarrage
+typedef struct{
+  uint32 magique;
+  uint32 action;
+  uint32 arguments[MAJ_EBOOT_NB_ARGUMENTS];
+  uint32 crc;                  // CRC des champs précédents (MAJ_EBOOT_POLYNOME)
+}MAJ_Commande_Eboot;
+
+// Session de transfert (début du secteur de suivi ; puis un mot à 0 par secteur de l'image terminé)
+typedef struct{
+  uint32 magique;
+  uint32 taille_image;
+  uint32 crc_image;
+  uint32 crc;
+}MAJ_Session;
+
+// Position des enregistrements dans le secteur de suivi
+#define MAJ_POSITION_SESSION 0
+#define MAJ_POSITION_SECTEURS 32
+#define MAJ_NB_SECTEURS_MAX ((FLASH_TAILLE_SECTEUR - MAJ_POSITION_SECTEURS) / 4)
+
+// Statistiques
+typedef struct{
+  uint32 nb_trames;            // trames valides reçues
+  uint32 nb_erreurs_trame;     // trames rejetées (CRC, longueur)
+  uint32 nb_perdus_rx;         // octets perdus (buffer de réception plein)
+  uint32 octets_recus;         // octets de l'image reçus dans des trames MAJ_DONNEES
+  uint32 octets_copies;        // octets de l'image recopiés depuis le programme en cours (MAJ_COPIE)
+  uint32 nb_effacements;
+  uint32 nb_erreurs_flash;
+  uint32 nb_reprises;          // transferts repris après une interruption
+}MAJ_Statistiques;
+
+// ##########################################################################################################################
+//                                      FONCTIONS MISE A JOUR
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Mise_A_Jour
+  DESCRIPTION   : Prend l'UART0 (8N1) pour recevoir les trames
+  PARAMETRES    : Vitesse de communication (Bauds), zones de flash
+  RETOUR        : false si les zones sont invalides (taille nulle ou trop grande, zones qui se chevauchent)
+===============================================================================*/
+bool init_Mise_A_Jour(uint32 Bauds, const MAJ_Zones *zones);
+
+/*===============================================================================
+  FONCTION      : MAJ_Tache
+  DESCRIPTION   : Avance d'une étape : traite les octets reçus jusqu'à une trame complète,
+                  ou fait une opération en flash (effacement d'un secteur, écriture d'un bloc)
+  /!\ un effacement bloque plusieurs dizaines de ms, une écriture environ 1 ms :
+      appeler sur le temps libre (Scheduler_Set_Tache_Fond) ou depuis la boucle principale
+  PARAMETRES    : rien
+  RETOUR        : true s'il reste du travail en attente
+===============================================================================*/
+bool MAJ_Tache();
+
+/*===============================================================================
+  FONCTION      : MAJ_Traiter_Octet
+  DESCRIPTION   : Ajoute un octet reçu au buffer de réception
+  (utilisée par l'interruption, utilisable pour une autre source d'octets)
+  PARAMETRES    : Octet
+  RETOUR        : false si le buffer est plein (octet perdu)
+===============================================================================*/
+bool ICACHE_RAM_ATTR MAJ_Traiter_Octet(uint8 octet);
+
+/*===============================================================================
+  FONCTION      : MAJ_Lire_Etat
+  DESCRIPTION   : Etat de la mise à jour
+  PARAMETRES    : rien
+  RETOUR        : MAJ_ETAT_TERMINEE lorsque la commande eboot est déposée (redémarrer)
+===============================================================================*/
+MAJ_Etat MAJ_Lire_Etat();
+
+/*===============================================================================
+  FONCTION      : MAJ_Lire_Commande_Eboot
+  DESCRIPTION   : Lit la commande déposée en mémoire RTC pour eboot
+  PARAMETRES    : Commande lue
+  RETOUR        : true si une commande valide (magique et CRC) est en attente
+===============================================================================*/
+bool MAJ_Lire_Commande_Eboot(MAJ_Commande_Eboot *commande);
+
+/*===============================================================================
+  FONCTION      : MAJ_Lire_Statistiques
+  DESCRIPTION   : Compteurs de la mise à jour
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const MAJ_Statistiques *MAJ_Lire_Statistiques();
+
+/*===============================================================================
+  FONCTION      : Interruption_Mise_A_Jour
+  DESCRIPTION   : Interruption UART0 : vide la fifo RX dans le buffer de réception
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Mise_A_Jour(uint8 UART, uint32 statut);
+
+/* fin du fichier */
+#endif
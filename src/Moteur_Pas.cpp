@@ -0,0 +1,540 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Moteur_Pas.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Pilotage de moteurs pas à pas (drivers STEP / DIR) avec profils d'accélération trapézoïdaux ou en S
+ *  (voir Moteur_Pas.h)
+ * =============================================================================================================================================
+ */
+
+#include "Moteur_Pas.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+Moteur_Struct Moteur[NB_MOTEURS];
+
+// Clients du multiplexeur TIMER1 (communs à tous les moteurs)
+int8 client_moteurs_pas = -1;
+int8 client_moteurs_profil = -1;
+
+// Mise à jour des profils en cours, échéance de la prochaine mise à jour (cycles CPU)
+bool profil_moteurs_actif = false;
+uint32 echeance_profil_moteurs = 0;
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Racine_Carree
+  DESCRIPTION   : Racine carrée entière (arrondi inférieur)
+  PARAMETRES    : Valeur
+  RETOUR        : Racine
+===============================================================================*/
+static uint32 Racine_Carree(uint32 valeur)
+{
+    uint32 racine = 0;
+    uint32 bit = 1UL << 30;
+
+    while (bit > valeur) bit >>= 2;
+    while (bit != 0)
+    {
+        if (valeur >= racine + bit)
+        {
+            valeur -= racine + bit;
+            racine = (racine >> 1) + bit;
+        }
+        else
+        {
+            racine >>= 1;
+        }
+        bit >>= 2;
+    }
+    return racine;
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Intervalle
+  DESCRIPTION   : Intervalle entre deux pas pour une vitesse donnée, sans division :
+                  itérations de Newton sur l'inverse (c = c × (2 - v × c)),
+                  en partant de l'intervalle précédent
+  PARAMETRES    : Intervalle précédent (cycles CPU), vitesse (Q48 pas/cycle)
+  RETOUR        : Intervalle (cycles CPU)
+===============================================================================*/
+static uint32 ICACHE_RAM_ATTR Moteur_Intervalle(uint32 intervalle, uint64 vitesse)
+{
+    uint64 v = vitesse >> (MOTEUR_Q - 32);   // Q32
+    uint64 c = intervalle;
+
+    for (uint8 i = 0; i < 3; i++)
+    {
+        uint64 produit = v * c;              // ~ 2^32 lorsque c est juste
+
+        // point de départ trop grand (vitesse plus que doublée) : la méthode diverge
+        if (produit >= (2ULL << 32))
+        {
+            c >>= 1;
+            continue;
+        }
+        c = (c * ((2ULL << 32) - produit)) >> 32;
+    }
+    return (c > 0) ? (uint32)c : 1;
+}
+
+/*===============================================================================
+  FONCTION      : Moteurs_Planifier_Pas
+  DESCRIPTION   : Programme le client "pas" sur le prochain pas de tous les moteurs
+  (doit être appelée interruptions masquées ou depuis une interruption)
+  PARAMETRES    : instant présent (cycles CPU)
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR Moteurs_Planifier_Pas(uint32 maintenant)
+{
+    bool echeance_trouvee = false;
+    int32 delai_min = 0x7FFFFFFF;
+    int32 delai;
+
+    for (uint8 i = 0; i < NB_MOTEURS; i++)
+    {
+        if (!Moteur[i].actif) continue;
+
+        delai = (int32)(Moteur[i].echeance - maintenant);
+        if (delai < delai_min) delai_min = delai;
+        echeance_trouvee = true;
+    }
+
+    if (echeance_trouvee) TIMER1_Mux_Programmer(client_moteurs_pas,maintenant + delai_min);
+    else TIMER1_Mux_Annuler(client_moteurs_pas);
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Freinage
+  DESCRIPTION   : Distance de freinage à la vitesse courante, sans division :
+                  v² / 2a (+ v × durée d'une rampe de jerk / 2 pour le profil en S)
+  PARAMETRES    : Moteur
+  RETOUR        : Distance (pas)
+===============================================================================*/
+static uint64 ICACHE_RAM_ATTR Moteur_Freinage(Moteur_Struct *m)
+{
+    uint32 x = (uint32)(m->vitesse >> 20);
+
+    return ((((uint64)x * x) * m->coef_freinage) >> 32) + (((m->vitesse >> 16) * m->coef_jerk) >> 32);
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Profil
+  DESCRIPTION   : Met à jour la vitesse d'un moteur (une période de profil)
+  PARAMETRES    : Moteur
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR Moteur_Profil(Moteur_Struct *m)
+{
+    uint64 vitesse = m->vitesse;
+    uint64 pas_periode = (((vitesse >> 16) * MOTEUR_CYCLES_PROFIL) >> 32) + 1;
+    uint64 freinage = Moteur_Freinage(m) + pas_periode;
+    uint64 marge;
+    bool maintien = false;
+
+    // -------------------------
+    // Freinage : démarre lorsque les pas restants atteignent la distance de freinage
+    // (pas de la période en cours compris), puis suit cette distance : tant qu'il reste
+    // plus d'une période d'avance, la vitesse est maintenue (pas de longue fin à vitesse minimale)
+    // -------------------------
+    if (m->phase == MOTEUR_ACCELERATION)
+    {
+        if (m->arret || m->restants <= freinage)
+        {
+            if (m->arret && m->restants > freinage) m->restants = (uint32)freinage;
+            m->phase = MOTEUR_DECELERATION;
+            m->k = 0;
+        }
+    }
+    else if (m->restants > freinage + pas_periode)
+    {
+        maintien = true;
+    }
+
+    // -------------------------
+    // Accélération (k × increment) : montée jusqu'à k_max, puis descente pour arriver
+    // à la vitesse visée avec une accélération nulle (profil en S ; k_max = 1 : trapèze)
+    // -------------------------
+    marge = m->increment * (((uint32)m->k * (m->k + 1)) / 2);
+    if (m->phase == MOTEUR_ACCELERATION)
+    {
+        if (vitesse + marge >= m->vitesse_cible)
+        {
+            if (m->k > 0) m->k--;
+            if (m->k == 0) vitesse = m->vitesse_cible;
+        }
+        else if (m->k < m->k_max) m->k++;
+
+        vitesse += m->increment * m->k;
+        if (vitesse > m->vitesse_cible) vitesse = m->vitesse_cible;
+    }
+    else if (maintien)
+    {
+        if (m->k > 0) m->k--;
+        vitesse = (vitesse > m->vitesse_min + m->increment * m->k) ? vitesse - m->increment * m->k : m->vitesse_min;
+    }
+    else
+    {
+        if (vitesse <= m->vitesse_min + marge)
+        {
+            if (m->k > 0) m->k--;
+            if (m->k == 0) vitesse = m->vitesse_min;
+        }
+        else if (m->k < m->k_max) m->k++;
+
+        marge = m->increment * m->k;
+        vitesse = (vitesse > m->vitesse_min + marge) ? vitesse - marge : m->vitesse_min;
+    }
+
+    m->vitesse = vitesse;
+    m->intervalle = Moteur_Intervalle(m->intervalle,vitesse);
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS MOTEUR
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Moteur
+  DESCRIPTION   : initialise un moteur (GPIO STEP et DIR en sortie, position 0)
+                  et les clients du multiplexeur TIMER1 (au premier appel)
+  PARAMETRES    : N° du moteur, GPIO STEP, GPIO DIR, sens de rotation inversé
+  RETOUR        : false si le moteur n'existe pas ou si le TIMER1 n'a plus de client libre
+===============================================================================*/
+bool init_Moteur(uint8 moteur, uint8 gpio_pas, uint8 gpio_dir, bool inverse)
+{
+    if (moteur >= NB_MOTEURS) return false;
+
+    Moteur_Struct *m = &Moteur[moteur];
+
+    // Etape 1 : clients du multiplexeur TIMER1 (une seule fois pour tous les moteurs)
+    if (client_moteurs_pas < 0) client_moteurs_pas = TIMER1_Mux_Ajouter_Client(Interruption_Moteurs_Pas,NULL);
+    if (client_moteurs_profil < 0) client_moteurs_profil = TIMER1_Mux_Ajouter_Client(Interruption_Moteurs_Profil,NULL);
+    if (client_moteurs_pas < 0 || client_moteurs_profil < 0) return false;
+
+    // Etape 2 : GPIO
+    init_GPIO(gpio_pas,GPIO_OUTPUT);
+    init_GPIO(gpio_dir,GPIO_OUTPUT);
+
+    // Etape 3 : état du moteur
+    ETS_INTR_LOCK();
+    m->actif = false;
+    m->arret = false;
+    m->phase = MOTEUR_ARRET;
+    m->position = 0;
+    m->restants = 0;
+    ETS_INTR_UNLOCK();
+
+    m->gpio_pas = gpio_pas;
+    m->gpio_dir = gpio_dir;
+    m->inverse = inverse;
+    m->configure = true;
+    Moteur_Set_Profil(moteur,MOTEUR_VITESSE_DEFAUT,MOTEUR_ACCELERATION_DEFAUT,0);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Set_Profil
+  DESCRIPTION   : Définit le profil des prochains déplacements (bornes appliquées)
+  PARAMETRES    : N° du moteur, vitesse maximale (pas/s), accélération (pas/s²),
+                  jerk (pas/s³, 0 : profil trapézoïdal)
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Set_Profil(uint8 moteur, uint32 vitesse_max, uint32 acceleration, uint32 jerk)
+{
+    if (moteur >= NB_MOTEURS) return;
+
+    if (vitesse_max == 0) vitesse_max = 1;
+    if (vitesse_max > MOTEUR_VITESSE_MAX) vitesse_max = MOTEUR_VITESSE_MAX;
+    if (acceleration < MOTEUR_ACCELERATION_MIN) acceleration = MOTEUR_ACCELERATION_MIN;
+    if (acceleration > MOTEUR_ACCELERATION_MAX) acceleration = MOTEUR_ACCELERATION_MAX;
+    if (jerk > MOTEUR_JERK_MAX) jerk = MOTEUR_JERK_MAX;
+
+    Moteur[moteur].vitesse_max = vitesse_max;
+    Moteur[moteur].acceleration = acceleration;
+    Moteur[moteur].jerk = jerk;
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Preparer
+  DESCRIPTION   : Prépare un déplacement relatif sans le démarrer (voir Moteurs_Demarrer)
+  Les divisions nécessaires au profil sont faites ici, hors interruption
+  PARAMETRES    : N° du moteur, nombre de pas (signé)
+  RETOUR        : false si le moteur est déjà en mouvement
+===============================================================================*/
+bool Moteur_Preparer(uint8 moteur, int32 pas)
+{
+    if (moteur >= NB_MOTEURS || !Moteur[moteur].configure || Moteur[moteur].actif) return false;
+
+    Moteur_Struct *m = &Moteur[moteur];
+    uint32 vitesse_min;
+    uint64 acceleration;
+
+    m->sens = (pas < 0) ? -1 : 1;
+    m->restants = (pas < 0) ? (uint32)(-pas) : (uint32)pas;
+    m->arret = false;
+    m->k = 0;
+
+    // Vitesse de démarrage : vitesse atteinte après le premier pas (v² = 2a / 1 pas ~ a/2)
+    vitesse_min = Racine_Carree(m->acceleration / 2);
+    if (vitesse_min == 0) vitesse_min = 1;
+    if (vitesse_min > m->vitesse_max) vitesse_min = m->vitesse_max;
+
+    m->vitesse_min = ((uint64)vitesse_min << MOTEUR_Q) / ESP8266_CLOCK_FREQ;
+    m->vitesse_cible = ((uint64)m->vitesse_max << MOTEUR_Q) / ESP8266_CLOCK_FREQ;
+    m->vitesse = m->vitesse_min;
+    m->intervalle = ESP8266_CLOCK_FREQ / vitesse_min;
+
+    // Variation de vitesse par période de profil à l'accélération maximale (Q48)
+    acceleration = ((((uint64)m->acceleration << 40) / ESP8266_CLOCK_FREQ) << (MOTEUR_Q - 40)) * MOTEUR_PERIODE_PROFIL_US / 1000000;
+
+    if (m->jerk == 0)
+    {
+        m->k_max = 1;
+        m->increment = acceleration;
+    }
+    else
+    {
+        uint64 increment = ((((uint64)m->jerk << 40) / ESP8266_CLOCK_FREQ) << (MOTEUR_Q - 40))
+                         * MOTEUR_PERIODE_PROFIL_US * MOTEUR_PERIODE_PROFIL_US / 1000000000000ULL;
+        uint64 k_max = (increment > 0) ? acceleration / increment : MOTEUR_RAMPE_JERK_MAX;
+
+        if (k_max > MOTEUR_RAMPE_JERK_MAX) k_max = MOTEUR_RAMPE_JERK_MAX;
+        if (k_max < 1) k_max = 1;
+        m->k_max = (uint16)k_max;
+        m->increment = acceleration / k_max;
+    }
+
+    // Distance de freinage (pas) = v² / 2a, et durée des rampes de jerk
+    m->coef_freinage = (uint32)(((uint64)MOTEUR_CYCLES_PROFIL << 23) / (m->increment * m->k_max));
+    m->coef_jerk = (m->k_max > 1) ? (MOTEUR_CYCLES_PROFIL / 2) * m->k_max : 0;
+
+    m->phase = (m->restants > 0) ? MOTEUR_ACCELERATION : MOTEUR_ARRET;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Moteurs_Demarrer
+  DESCRIPTION   : Démarre ensemble les déplacements préparés
+                  (sens de tous les moteurs positionnés en deux écritures)
+  PARAMETRES    : Masque des moteurs (bit n : moteur n)
+  RETOUR        : rien
+===============================================================================*/
+void Moteurs_Demarrer(uint8 masque)
+{
+    uint32 dir_haut = 0;
+    uint32 dir_bas = 0;
+    uint32 maintenant;
+
+    // Etape 1 : sens de rotation
+    for (uint8 i = 0; i < NB_MOTEURS; i++)
+    {
+        Moteur_Struct *m = &Moteur[i];
+        if (!READ_BIT(masque,i) || !m->configure || m->actif || m->phase != MOTEUR_ACCELERATION) continue;
+
+        if ((m->sens > 0) != m->inverse) dir_haut |= (1 << m->gpio_dir);
+        else dir_bas |= (1 << m->gpio_dir);
+    }
+    if ((dir_haut | dir_bas) == 0) return;
+
+    ETS_INTR_LOCK();
+    REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,dir_haut);
+    REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,dir_bas);
+
+    // Etape 2 : premier pas de tous les moteurs au même instant
+    maintenant = Lire_Compteur_Cycles();
+    for (uint8 i = 0; i < NB_MOTEURS; i++)
+    {
+        Moteur_Struct *m = &Moteur[i];
+        if (!READ_BIT(masque,i) || !m->configure || m->actif || m->phase != MOTEUR_ACCELERATION) continue;
+
+        m->echeance = maintenant + MOTEUR_DELAI_DIR;
+        m->actif = true;
+    }
+    Moteurs_Planifier_Pas(maintenant);
+
+    // Etape 3 : mise à jour des profils
+    if (!profil_moteurs_actif)
+    {
+        echeance_profil_moteurs = maintenant + MOTEUR_CYCLES_PROFIL;
+        TIMER1_Mux_Programmer(client_moteurs_profil,echeance_profil_moteurs);
+        profil_moteurs_actif = true;
+    }
+    ETS_INTR_UNLOCK();
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Deplacer
+  DESCRIPTION   : Démarre un déplacement relatif
+  PARAMETRES    : N° du moteur, nombre de pas (signé)
+  RETOUR        : false si le moteur est déjà en mouvement
+===============================================================================*/
+bool Moteur_Deplacer(uint8 moteur, int32 pas)
+{
+    if (!Moteur_Preparer(moteur,pas)) return false;
+
+    Moteurs_Demarrer(1 << moteur);
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Aller_A
+  DESCRIPTION   : Démarre un déplacement vers une position absolue
+  PARAMETRES    : N° du moteur, position (pas)
+  RETOUR        : false si le moteur est déjà en mouvement
+===============================================================================*/
+bool Moteur_Aller_A(uint8 moteur, int32 position)
+{
+    if (moteur >= NB_MOTEURS) return false;
+
+    return Moteur_Deplacer(moteur,position - Moteur[moteur].position);
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Arreter
+  DESCRIPTION   : Arrête le moteur en décélérant
+  PARAMETRES    : N° du moteur
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Arreter(uint8 moteur)
+{
+    if (moteur >= NB_MOTEURS) return;
+
+    Moteur[moteur].arret = true;
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Arret_Urgence
+  DESCRIPTION   : Arrête le moteur immédiatement (sans décélération)
+  PARAMETRES    : N° du moteur
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Arret_Urgence(uint8 moteur)
+{
+    if (moteur >= NB_MOTEURS) return;
+
+    ETS_INTR_LOCK();
+    Moteur[moteur].actif = false;
+    Moteur[moteur].restants = 0;
+    Moteur[moteur].phase = MOTEUR_ARRET;
+    Moteurs_Planifier_Pas(Lire_Compteur_Cycles());
+    ETS_INTR_UNLOCK();
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_En_Mouvement
+  DESCRIPTION   : Indique si un déplacement est en cours
+  PARAMETRES    : N° du moteur
+  RETOUR        : true si le moteur tourne
+===============================================================================*/
+bool Moteur_En_Mouvement(uint8 moteur)
+{
+    return moteur < NB_MOTEURS && Moteur[moteur].actif;
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Position
+  DESCRIPTION   : Position courante du moteur
+  PARAMETRES    : N° du moteur
+  RETOUR        : Position (pas)
+===============================================================================*/
+int32 Moteur_Position(uint8 moteur)
+{
+    return (moteur < NB_MOTEURS) ? Moteur[moteur].position : 0;
+}
+
+/*===============================================================================
+  FONCTION      : Moteur_Set_Position
+  DESCRIPTION   : Redéfinit la position courante (prise d'origine), moteur arrêté
+  PARAMETRES    : N° du moteur, position (pas)
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Set_Position(uint8 moteur, int32 position)
+{
+    if (moteur >= NB_MOTEURS || Moteur[moteur].actif) return;
+
+    Moteur[moteur].position = position;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Moteurs_Pas
+  DESCRIPTION   : Client du multiplexeur TIMER1 : émet les pas arrivés à échéance
+                  (impulsions STEP de tous les moteurs concernés en une seule écriture)
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Moteurs_Pas(void *argument)
+{
+    uint32 maintenant = Lire_Compteur_Cycles();
+    uint32 masque = 0;
+    uint32 debut_impulsion;
+
+    for (uint8 i = 0; i < NB_MOTEURS; i++)
+    {
+        Moteur_Struct *m = &Moteur[i];
+        if (!m->actif || (int32)(m->echeance - maintenant) >= TIMER1_MUX_DELAI_MIN) continue;
+
+        masque |= (1 << m->gpio_pas);
+        m->position += m->sens;
+        m->restants--;
+
+        if (m->restants == 0)
+        {
+            m->actif = false;
+            m->phase = MOTEUR_ARRET;
+        }
+        else
+        {
+            m->echeance += m->intervalle;
+        }
+    }
+
+    // Front montant de tous les pas, prochaine échéance calculée pendant l'impulsion
+    REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,masque);
+    debut_impulsion = Lire_Compteur_Cycles();
+
+    Moteurs_Planifier_Pas(maintenant);
+
+    if (masque != 0)
+    {
+        while ((Lire_Compteur_Cycles() - debut_impulsion) < MOTEUR_LARGEUR_IMPULSION);
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,masque);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Moteurs_Profil
+  DESCRIPTION   : Client du multiplexeur TIMER1 : met à jour la vitesse des moteurs
+                  (toutes les MOTEUR_PERIODE_PROFIL_US)
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Moteurs_Profil(void *argument)
+{
+    bool moteur_actif = false;
+
+    for (uint8 i = 0; i < NB_MOTEURS; i++)
+    {
+        if (!Moteur[i].actif) continue;
+
+        Moteur_Profil(&Moteur[i]);
+        moteur_actif = true;
+    }
+
+    // Période suivante (sans dérive), tant qu'un moteur tourne
+    profil_moteurs_actif = moteur_actif;
+    if (moteur_actif)
+    {
+        echeance_profil_moteurs += MOTEUR_CYCLES_PROFIL;
+        TIMER1_Mux_Programmer(client_moteurs_profil,echeance_profil_moteurs);
+    }
+}
@@ -0,0 +1,214 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Moteur_Pas.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Pilotage de moteurs pas à pas (drivers STEP / DIR) avec profils d'accélération trapézoïdaux ou en S
+ *
+ *  Deux clients du multiplexeur TIMER1 (voir Multiplexeur_TIMER1.h) :
+ *  - Profil : toutes les MOTEUR_PERIODE_PROFIL_US, la vitesse de chaque moteur est mise à jour par additions
+ *    (accélération, ou jerk pour le profil en S) et l'intervalle entre deux pas est recalculé sans division
+ *    (itérations de Newton sur l'inverse de la vitesse, en virgule fixe)
+ *  - Pas : à chaque échéance, les impulsions STEP de tous les moteurs concernés sont émises ensemble
+ *    (une écriture OUT_W1TS, puis une écriture OUT_W1TC après la largeur d'impulsion)
+ *  La décélération démarre lorsque les pas restants atteignent la distance de freinage ;
+ *  le moteur s'arrête exactement sur la position demandée (fin à la vitesse de démarrage si besoin).
+ *
+ *  Vitesses en pas/s, accélérations en pas/s², jerk en pas/s³ (0 : profil trapézoïdal)
+ *  Calculs internes : vitesse en pas/cycle CPU, virgule fixe Q48
+ * =============================================================================================================================================
+ */
+
+#ifndef __MOTEUR_PAS_H__
+#define __MOTEUR_PAS_H__
+
+// Dépendance(s)
+#include "GPIO_esp8266.h"
+#include "Multiplexeur_TIMER1.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre de moteurs pilotés
+#define NB_MOTEURS 4
+
+// Période de mise à jour des profils de vitesse (us)
+#define MOTEUR_PERIODE_PROFIL_US 1000
+#define MOTEUR_CYCLES_PROFIL (MOTEUR_PERIODE_PROFIL_US * (ESP8266_CLOCK_FREQ / 1000000))
+
+// Largeur des impulsions STEP (cycles CPU : 2us)
+#define MOTEUR_LARGEUR_IMPULSION 160
+
+// Délai entre le positionnement de DIR et le premier pas (cycles CPU : 5us)
+#define MOTEUR_DELAI_DIR 400
+
+// Profil par défaut
+#define MOTEUR_VITESSE_DEFAUT      1000  // pas/s
+#define MOTEUR_ACCELERATION_DEFAUT 2000  // pas/s²
+
+// Limites des profils
+#define MOTEUR_VITESSE_MAX        20000    // pas/s
+#define MOTEUR_ACCELERATION_MIN   100      // pas/s²
+#define MOTEUR_ACCELERATION_MAX   1000000  // pas/s²
+#define MOTEUR_JERK_MAX           1000000  // pas/s³
+#define MOTEUR_RAMPE_JERK_MAX     4096     // nombre maximal de périodes de profil pour atteindre l'accélération
+
+// Virgule fixe des vitesses (pas/cycle CPU)
+#define MOTEUR_Q 48
+
+// Phases d'un déplacement
+typedef enum {MOTEUR_ARRET,MOTEUR_ACCELERATION,MOTEUR_DECELERATION} Moteur_Phase;
+
+// Etat d'un moteur
+typedef struct{
+  uint8 gpio_pas;
+  uint8 gpio_dir;
+  bool configure;
+  bool inverse;              // sens de rotation inversé
+
+  // Profil (unités utilisateur)
+  uint32 vitesse_max;        // pas/s
+  uint32 acceleration;       // pas/s²
+  uint32 jerk;               // pas/s³ (0 : trapézoïdal)
+
+  // Déplacement (modifié sous interruption)
+  volatile bool actif;
+  volatile bool arret;       // arrêt progressif demandé
+  uint8 phase;               // Moteur_Phase
+  int8 sens;                 // +1 / -1
+  volatile int32 position;   // pas
+  volatile uint32 restants;  // pas restants
+  uint32 echeance;           // prochain pas (cycles CPU)
+  uint32 intervalle;         // cycles CPU entre deux pas
+
+  // Profil (virgule fixe, calculé par Moteur_Preparer)
+  uint64 vitesse;            // Q48 pas/cycle
+  uint64 vitesse_min;
+  uint64 vitesse_cible;
+  uint64 increment;          // variation de vitesse par période (× k)
+  uint16 k;                  // accélération courante = k × increment
+  uint16 k_max;
+  uint32 coef_freinage;      // distance de freinage = vitesse² × coef
+  uint32 coef_jerk;          // distance supplémentaire du profil en S
+} Moteur_Struct;
+
+extern Moteur_Struct Moteur[NB_MOTEURS];
+
+// ##########################################################################################################################
+//                                      FONCTIONS MOTEUR
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Moteur
+  DESCRIPTION   : initialise un moteur (GPIO STEP et DIR en sortie, position 0)
+                  et les clients du multiplexeur TIMER1 (au premier appel)
+  PARAMETRES    : N° du moteur, GPIO STEP, GPIO DIR, sens de rotation inversé
+  RETOUR        : false si le moteur n'existe pas ou si le TIMER1 n'a plus de client libre
+===============================================================================*/
+bool init_Moteur(uint8 moteur, uint8 gpio_pas, uint8 gpio_dir, bool inverse);
+
+/*===============================================================================
+  FONCTION      : Moteur_Set_Profil
+  DESCRIPTION   : Définit le profil des prochains déplacements (bornes appliquées)
+  PARAMETRES    : N° du moteur, vitesse maximale (pas/s), accélération (pas/s²),
+                  jerk (pas/s³, 0 : profil trapézoïdal)
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Set_Profil(uint8 moteur, uint32 vitesse_max, uint32 acceleration, uint32 jerk);
+
+/*===============================================================================
+  FONCTION      : Moteur_Preparer
+  DESCRIPTION   : Prépare un déplacement relatif sans le démarrer (voir Moteurs_Demarrer)
+  PARAMETRES    : N° du moteur, nombre de pas (signé)
+  RETOUR        : false si le moteur est déjà en mouvement
+===============================================================================*/
+bool Moteur_Preparer(uint8 moteur, int32 pas);
+
+/*===============================================================================
+  FONCTION      : Moteurs_Demarrer
+  DESCRIPTION   : Démarre ensemble les déplacements préparés
+                  (sens de tous les moteurs positionnés en deux écritures)
+  PARAMETRES    : Masque des moteurs (bit n : moteur n)
+  RETOUR        : rien
+===============================================================================*/
+void Moteurs_Demarrer(uint8 masque);
+
+/*===============================================================================
+  FONCTION      : Moteur_Deplacer
+  DESCRIPTION   : Démarre un déplacement relatif
+  PARAMETRES    : N° du moteur, nombre de pas (signé)
+  RETOUR        : false si le moteur est déjà en mouvement
+===============================================================================*/
+bool Moteur_Deplacer(uint8 moteur, int32 pas);
+
+/*===============================================================================
+  FONCTION      : Moteur_Aller_A
+  DESCRIPTION   : Démarre un déplacement vers une position absolue
+  PARAMETRES    : N° du moteur, position (pas)
+  RETOUR        : false si le moteur est déjà en mouvement
+===============================================================================*/
+bool Moteur_Aller_A(uint8 moteur, int32 position);
+
+/*===============================================================================
+  FONCTION      : Moteur_Arreter
+  DESCRIPTION   : Arrête le moteur en décélérant
+  PARAMETRES    : N° du moteur
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Arreter(uint8 moteur);
+
+/*===============================================================================
+  FONCTION      : Moteur_Arret_Urgence
+  DESCRIPTION   : Arrête le moteur immédiatement (sans décélération)
+  PARAMETRES    : N° du moteur
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Arret_Urgence(uint8 moteur);
+
+/*===============================================================================
+  FONCTION      : Moteur_En_Mouvement
+  DESCRIPTION   : Indique si un déplacement est en cours
+  PARAMETRES    : N° du moteur
+  RETOUR        : true si le moteur tourne
+===============================================================================*/
+bool Moteur_En_Mouvement(uint8 moteur);
+
+/*===============================================================================
+  FONCTION      : Moteur_Position
+  DESCRIPTION   : Position courante du moteur
+  PARAMETRES    : N° du moteur
+  RETOUR        : Position (pas)
+===============================================================================*/
+int32 Moteur_Position(uint8 moteur);
+
+/*===============================================================================
+  FONCTION      : Moteur_Set_Position
+  DESCRIPTION   : Redéfinit la position courante (prise d'origine), moteur arrêté
+  PARAMETRES    : N° du moteur, position (pas)
+  RETOUR        : rien
+===============================================================================*/
+void Moteur_Set_Position(uint8 moteur, int32 position);
+
+/*===============================================================================
+  FONCTION      : Interruption_Moteurs_Pas
+  DESCRIPTION   : Client du multiplexeur TIMER1 : émet les pas arrivés à échéance
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Moteurs_Pas(void *argument);
+
+/*===============================================================================
+  FONCTION      : Interruption_Moteurs_Profil
+  DESCRIPTION   : Client du multiplexeur TIMER1 : met à jour la vitesse des moteurs
+                  (toutes les MOTEUR_PERIODE_PROFIL_US)
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Moteurs_Profil(void *argument);
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,259 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Multiplexeur_TIMER1.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Partage du TIMER1 entre plusieurs clients (Scheduler, UART logicielles, bus 1-Wire, ...)
+ *  (voir Multiplexeur_TIMER1.h)
+ * =============================================================================================================================================
+ */
+
+#include "Multiplexeur_TIMER1.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Fin de la file
+#define TIMER1_MUX_AUCUN 0xFF
+
+// Clients
+typedef struct{
+  TIMER1_Mux_Fonction fonction;   // NULL : emplacement libre
+  void *argument;
+  uint32 echeance;                // cycles CPU
+  uint8 suivant;                  // client suivant dans la file
+  bool programme;                 // le client est dans la file
+} TIMER1_Mux_Client;
+
+TIMER1_Mux_Client Clients_TIMER1[TIMER1_MUX_NB_CLIENTS];
+
+// File des échéances, triée de la plus proche à la plus lointaine
+uint8 tete_TIMER1_Mux = TIMER1_MUX_AUCUN;
+
+// Pendant l'appel des clients, le TIMER1 n'est réarmé qu'à la fin de l'interruption
+bool appels_TIMER1_Mux = false;
+
+bool flag_init_Multiplexeur_TIMER1 = false;
+
+TIMER1_Mux_Statistiques Statistiques_TIMER1_Mux;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Retirer
+  DESCRIPTION   : Retire un client de la file
+  PARAMETRES    : N° du client
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR TIMER1_Mux_Retirer(uint8 client)
+{
+    uint8 *lien = &tete_TIMER1_Mux;
+
+    if (!Clients_TIMER1[client].programme) return;
+
+    while (*lien != client) lien = &Clients_TIMER1[*lien].suivant;
+    *lien = Clients_TIMER1[client].suivant;
+    Clients_TIMER1[client].programme = false;
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Armer
+  DESCRIPTION   : Arme le TIMER1 sur l'échéance en tête de file
+                  (ou l'arrête si la file est vide)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR TIMER1_Mux_Armer()
+{
+    int32 delai;
+
+    if (tete_TIMER1_Mux == TIMER1_MUX_AUCUN)
+    {
+        REGISTRE_CLR_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN);
+        return;
+    }
+
+    delai = (int32)(Clients_TIMER1[tete_TIMER1_Mux].echeance - Lire_Compteur_Cycles());
+    if (delai < TIMER1_MUX_DELAI_MIN) delai = TIMER1_MUX_DELAI_MIN;
+    TIMER1_Armer((uint32)delai / TIMER1_MUX_CYCLES_PAR_TICK);
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS MULTIPLEXEUR
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Multiplexeur_TIMER1
+  DESCRIPTION   : initialise le TIMER1 (mode monocoup) et son interruption
+  (sans effet si le multiplexeur est déjà initialisé)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void init_Multiplexeur_TIMER1()
+{
+    if (flag_init_Multiplexeur_TIMER1) return;
+
+    for (uint8 i = 0; i < TIMER1_MUX_NB_CLIENTS; i++)
+    {
+        Clients_TIMER1[i].fonction = NULL;
+        Clients_TIMER1[i].programme = false;
+    }
+    tete_TIMER1_Mux = TIMER1_MUX_AUCUN;
+    TIMER1_Mux_RAZ_Statistiques();
+
+    init_TIMER1_MonoCoup(TIMER1_MUX_PREDIV);
+    ETS_FRC_TIMER1_INTR_ATTACH(Interruption_Multiplexeur_TIMER1,NULL);
+    ETS_FRC1_INTR_ENABLE();
+    flag_init_Multiplexeur_TIMER1 = true;
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Ajouter_Client
+  DESCRIPTION   : Enregistre un client du TIMER1 (initialise le multiplexeur si besoin)
+  PARAMETRES    : Fonction appelée à l'échéance, argument de la fonction
+  RETOUR        : N° du client, -1 si tous les emplacements sont pris
+===============================================================================*/
+int8 TIMER1_Mux_Ajouter_Client(TIMER1_Mux_Fonction fonction, void *argument)
+{
+    if (fonction == NULL) return -1;
+
+    init_Multiplexeur_TIMER1();
+
+    for (uint8 i = 0; i < TIMER1_MUX_NB_CLIENTS; i++)
+    {
+        if (Clients_TIMER1[i].fonction != NULL) continue;
+
+        Clients_TIMER1[i].argument = argument;
+        Clients_TIMER1[i].programme = false;
+        Clients_TIMER1[i].fonction = fonction;
+        return i;
+    }
+    return -1;
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Programmer
+  DESCRIPTION   : Programme (ou déplace) l'échéance d'un client
+  (doit être appelée interruptions masquées ou depuis une interruption,
+   y compris depuis la fonction du client)
+  PARAMETRES    : N° du client, échéance (cycles CPU, voir Lire_Compteur_Cycles)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR TIMER1_Mux_Programmer(uint8 client, uint32 echeance)
+{
+    uint8 *lien = &tete_TIMER1_Mux;
+
+    if (client >= TIMER1_MUX_NB_CLIENTS || Clients_TIMER1[client].fonction == NULL) return;
+
+    TIMER1_Mux_Retirer(client);
+
+    // Insertion triée (à échéance égale, après les clients déjà programmés)
+    while (*lien != TIMER1_MUX_AUCUN && (int32)(Clients_TIMER1[*lien].echeance - echeance) <= 0)
+    {
+        lien = &Clients_TIMER1[*lien].suivant;
+    }
+    Clients_TIMER1[client].echeance = echeance;
+    Clients_TIMER1[client].suivant = *lien;
+    Clients_TIMER1[client].programme = true;
+    *lien = client;
+
+    if (!appels_TIMER1_Mux && tete_TIMER1_Mux == client) TIMER1_Mux_Armer();
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Annuler
+  DESCRIPTION   : Annule l'échéance d'un client
+  (doit être appelée interruptions masquées ou depuis une interruption)
+  PARAMETRES    : N° du client
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR TIMER1_Mux_Annuler(uint8 client)
+{
+    bool en_tete;
+
+    if (client >= TIMER1_MUX_NB_CLIENTS || !Clients_TIMER1[client].programme) return;
+
+    en_tete = (tete_TIMER1_Mux == client);
+    TIMER1_Mux_Retirer(client);
+
+    if (!appels_TIMER1_Mux && en_tete) TIMER1_Mux_Armer();
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Lire_Statistiques
+  DESCRIPTION   : Latence et durée des interruptions du multiplexeur
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const TIMER1_Mux_Statistiques *TIMER1_Mux_Lire_Statistiques()
+{
+    return &Statistiques_TIMER1_Mux;
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_RAZ_Statistiques
+  DESCRIPTION   : Remet à zéro les statistiques
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void TIMER1_Mux_RAZ_Statistiques()
+{
+    ETS_INTR_LOCK();
+    Statistiques_TIMER1_Mux.nb_interruptions = 0;
+    Statistiques_TIMER1_Mux.nb_appels = 0;
+    Statistiques_TIMER1_Mux.latence_derniere = 0;
+    Statistiques_TIMER1_Mux.latence_max = 0;
+    Statistiques_TIMER1_Mux.duree_max = 0;
+    ETS_INTR_UNLOCK();
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_Multiplexeur_TIMER1
+  DESCRIPTION   : Interruption du TIMER1 : appelle les clients dont l'échéance
+                  est atteinte, puis réarme le TIMER1 sur l'échéance suivante
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Multiplexeur_TIMER1()
+{
+    uint32 debut = Lire_Compteur_Cycles();
+    uint32 maintenant = debut;
+    uint32 duree;
+    int32 retard;
+
+    Statistiques_TIMER1_Mux.nb_interruptions++;
+    appels_TIMER1_Mux = true;
+
+    for (uint8 n = 0; n < TIMER1_MUX_APPELS_MAX && tete_TIMER1_Mux != TIMER1_MUX_AUCUN; n++)
+    {
+        TIMER1_Mux_Client *client = &Clients_TIMER1[tete_TIMER1_Mux];
+
+        // Les échéances atteintes (ou très proches) sont traitées immédiatement
+        retard = (int32)(maintenant - client->echeance);
+        if (retard <= -TIMER1_MUX_DELAI_MIN) break;
+
+        // Le client est retiré de la file avant l'appel : il peut se reprogrammer
+        tete_TIMER1_Mux = client->suivant;
+        client->programme = false;
+
+        if (retard < 0) retard = 0;
+        Statistiques_TIMER1_Mux.latence_derniere = retard;
+        if ((uint32)retard > Statistiques_TIMER1_Mux.latence_max) Statistiques_TIMER1_Mux.latence_max = retard;
+        Statistiques_TIMER1_Mux.nb_appels++;
+
+        client->fonction(client->argument);
+        maintenant = Lire_Compteur_Cycles();
+    }
+
+    appels_TIMER1_Mux = false;
+    TIMER1_Mux_Armer();
+
+    duree = Lire_Compteur_Cycles() - debut;
+    if (duree > Statistiques_TIMER1_Mux.duree_max) Statistiques_TIMER1_Mux.duree_max = duree;
+}
@@ -0,0 +1,124 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Multiplexeur_TIMER1.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Partage du TIMER1 entre plusieurs clients (Scheduler, UART logicielles, bus 1-Wire, ...)
+ *
+ *  Chaque client programme une échéance absolue sur le compteur de cycles CPU (Lire_Compteur_Cycles).
+ *  Les échéances sont rangées dans une file triée : le TIMER1 (mode monocoup) est armé sur la plus proche.
+ *  L'interruption appelle, dans l'ordre, tous les clients dont l'échéance est atteinte, puis réarme le TIMER1.
+ *  Un client périodique reprogramme lui-même son échéance suivante depuis sa fonction (sans dérive).
+ *
+ *  - Les échéances doivent être à moins de 26s (2^31 cycles) dans le futur
+ *  - La latence (retard entre l'échéance et l'appel du client) est mesurée à chaque appel
+ * =============================================================================================================================================
+ */
+
+#ifndef __MULTIPLEXEUR_TIMER1_H__
+#define __MULTIPLEXEUR_TIMER1_H__
+
+// Dépendance(s)
+#include "TIMER_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre maximal de clients
+#define TIMER1_MUX_NB_CLIENTS 8
+
+// Paramètres du TIMER1 (5 ticks / us)
+#define TIMER1_MUX_PREDIV DIV16
+#define TIMER1_MUX_CYCLES_PAR_TICK 16
+
+// Délai minimal entre deux interruptions du TIMER1 (en cycles CPU : 1us)
+// Les échéances plus proches que ce délai sont traitées immédiatement
+#define TIMER1_MUX_DELAI_MIN 80
+
+// Nombre maximal d'appels de clients par interruption
+// (un client qui se reprogramme dans le passé ne peut pas bloquer l'interruption)
+#define TIMER1_MUX_APPELS_MAX 16
+
+// Fonction d'un client (appelée sous interruption, doit être en IRAM)
+typedef void (*TIMER1_Mux_Fonction)(void *argument);
+
+// Statistiques du multiplexeur (durées en cycles CPU)
+typedef struct{
+  uint32 nb_interruptions;
+  uint32 nb_appels;          // appels de clients
+  uint32 latence_derniere;   // retard du dernier appel par rapport à son échéance
+  uint32 latence_max;        // pire retard constaté
+  uint32 duree_max;          // durée maximale d'une interruption
+} TIMER1_Mux_Statistiques;
+
+// ##########################################################################################################################
+//                                      FONCTIONS MULTIPLEXEUR
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Multiplexeur_TIMER1
+  DESCRIPTION   : initialise le TIMER1 (mode monocoup) et son interruption
+  (sans effet si le multiplexeur est déjà initialisé)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void init_Multiplexeur_TIMER1();
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Ajouter_Client
+  DESCRIPTION   : Enregistre un client du TIMER1 (initialise le multiplexeur si besoin)
+  PARAMETRES    : Fonction appelée à l'échéance, argument de la fonction
+  RETOUR        : N° du client, -1 si tous les emplacements sont pris
+===============================================================================*/
+int8 TIMER1_Mux_Ajouter_Client(TIMER1_Mux_Fonction fonction, void *argument);
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Programmer
+  DESCRIPTION   : Programme (ou déplace) l'échéance d'un client
+  (doit être appelée interruptions masquées ou depuis une interruption,
+   y compris depuis la fonction du client)
+  PARAMETRES    : N° du client, échéance (cycles CPU, voir Lire_Compteur_Cycles)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR TIMER1_Mux_Programmer(uint8 client, uint32 echeance);
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Annuler
+  DESCRIPTION   : Annule l'échéance d'un client
+  (doit être appelée interruptions masquées ou depuis une interruption)
+  PARAMETRES    : N° du client
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR TIMER1_Mux_Annuler(uint8 client);
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_Lire_Statistiques
+  DESCRIPTION   : Latence et durée des interruptions du multiplexeur
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const TIMER1_Mux_Statistiques *TIMER1_Mux_Lire_Statistiques();
+
+/*===============================================================================
+  FONCTION      : TIMER1_Mux_RAZ_Statistiques
+  DESCRIPTION   : Remet à zéro les statistiques
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void TIMER1_Mux_RAZ_Statistiques();
+
+/*===============================================================================
+  FONCTION      : Interruption_Multiplexeur_TIMER1
+  DESCRIPTION   : Interruption du TIMER1 : appelle les clients dont l'échéance
+                  est atteinte, puis réarme le TIMER1 sur l'échéance suivante
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_Multiplexeur_TIMER1();
+
+/* fin du fichier */
+#endif
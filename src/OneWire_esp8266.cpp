@@ -0,0 +1,713 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : OneWire_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Gestion non bloquante des capteurs "1 fil" : bus 1-Wire (DS18B20, ...) et capteurs DHT11 / DHT22
+ *  Chaque échange est une machine d'état avancée par les interruptions du TIMER1 (une étape de slot par interruption) :
+ *  aucune attente active, les interruptions restent actives pendant toute la durée des échanges.
+ *  Les durées réellement obtenues sont mesurées sur le compteur de cycles : un slot rendu invalide par une
+ *  interruption trop tardive abandonne l'échange (ONEWIRE_ERREUR_DEPASSEMENT), l'application le relance.
+ *  La fin d'un échange est signalée par le statut du bus et, si demandé, par une fonction appelée sous interruption.
+ *
+ *  Les GPIO sont utilisées en drain ouvert (BIT_GPIO_DRIVER) : une résistance de tirage externe est nécessaire.
+ *  Le TIMER1 est partagé avec les autres modules (Scheduler, ...) par le multiplexeur (voir Multiplexeur_TIMER1.h)
+ * =============================================================================================================================================
+ */
+
+// Librairies
+#include "OneWire_esp8266.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+OneWire_Struct OneWire[NB_BUS_ONEWIRE];
+
+// Client du multiplexeur TIMER1 commun à tous les bus 1-Wire
+int8 client_timer_OneWire = -1;
+
+// Etapes des machines d'état (chaque étape est exécutée à son échéance)
+typedef enum {
+  ETAPE_RESET_DEBUT,      // ligne basse (impulsion de reset)
+  ETAPE_RESET_RELACHE,    // ligne relâchée
+  ETAPE_RESET_PRESENCE,   // échantillonnage de l'impulsion de présence
+  ETAPE_SLOT_DEBUT,       // début d'un slot (ligne basse)
+  ETAPE_SLOT_RELACHE,     // fin de la ligne basse d'un slot d'écriture à '0'
+  ETAPE_SLOT_COURT,       // fin de la ligne basse d'un slot de lecture ou d'écriture à '1'
+  ETAPE_SLOT_LECTURE,     // échantillonnage d'un slot de lecture
+  ETAPE_SLOT_SUIVANT,     // fin d'un slot
+  ETAPE_DHT_START,        // impulsion de démarrage DHT
+  ETAPE_DHT_RELACHE,      // ligne relâchée, attente de la réponse
+  ETAPE_DHT_TIMEOUT       // le capteur n'a pas répondu à temps
+} OneWire_Etape;
+
+// Types de slot
+typedef enum {SLOT_ECRITURE_0,SLOT_ECRITURE_1,SLOT_LECTURE,SLOT_ERREUR,SLOT_AUCUN} OneWire_Slot;
+
+// Conversion us -> cycles CPU
+#define US(t) ((uint32)(t) * ONEWIRE_CYCLES_PAR_US)
+
+// Commande de la ligne en drain ouvert (écriture directe des registres W1TS / W1TC)
+#define LIGNE_BASSE(gpio)   REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,(1 << (gpio)))
+#define LIGNE_RELACHEE(gpio) REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,(1 << (gpio)))
+
+// Interruption GPIO sur front descendant (présence, DHT)
+#define FRONTS_ACTIVES(gpio)   do { REGISTRE_ECRIRE(Registre_GPIO->STATUS_W1TC,(1 << (gpio))); \
+                                    REGISTRE_CONFIG_OU(Registre_GPIO->PIN[gpio],(FRONT_DESCENDANT << BIT_GPIO_INT_TYPE)); } while (0)
+#define FRONTS_DESACTIVES(gpio) REGISTRE_CONFIG_ET(Registre_GPIO->PIN[gpio],~(0x7 << BIT_GPIO_INT_TYPE))
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : OneWire_Planifier
+  DESCRIPTION   : Programme le TIMER1 (multiplexeur) sur l'échéance la plus proche parmi tous
+                  les bus (ou l'annule si aucun échange n'est en cours)
+  (doit être appelée interruptions masquées ou depuis une interruption)
+  PARAMETRES    : instant présent (cycles CPU)
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR OneWire_Planifier(uint32 maintenant)
+{
+    bool echeance_trouvee = false;
+    int32 delai_min = 0x7FFFFFFF;
+    int32 delai;
+
+    for (uint8 i = 0; i < NB_BUS_ONEWIRE; i++)
+    {
+        if (!OneWire[i].actif || !OneWire[i].en_attente) continue;
+
+        delai = (int32)(OneWire[i].echeance - maintenant);
+        if (delai < delai_min) delai_min = delai;
+        echeance_trouvee = true;
+    }
+
+    if (!echeance_trouvee)
+    {
+        TIMER1_Mux_Annuler(client_timer_OneWire);
+        return;
+    }
+
+    TIMER1_Mux_Programmer(client_timer_OneWire,maintenant + delai_min);
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Terminer
+  DESCRIPTION   : Termine l'échange en cours et prévient l'application
+  PARAMETRES    : N° du bus, statut final
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR OneWire_Terminer(uint8 bus, OneWire_Statut statut)
+{
+    OneWire_Struct *ow = &OneWire[bus];
+
+    LIGNE_RELACHEE(ow->gpio);
+    ow->en_attente = false;
+    ow->statut = statut;
+    if (ow->fin != NULL) ow->fin(bus,statut);
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Choisir_Slot
+  DESCRIPTION   : Détermine le type du slot courant
+  (pour la recherche ROM : choix de la direction à l'issue des deux lectures)
+  PARAMETRES    : bus concerné
+  RETOUR        : type de slot
+===============================================================================*/
+static uint8 ICACHE_RAM_ATTR OneWire_Choisir_Slot(OneWire_Struct *ow)
+{
+    uint16 bits_tx = 8 * ow->nb_tx;
+
+    // Octets à écrire (commande, adresse, données)
+    if (ow->bit < bits_tx)
+    {
+        return READ_BIT(ow->tx[ow->bit / 8],(ow->bit % 8)) ? SLOT_ECRITURE_1 : SLOT_ECRITURE_0;
+    }
+
+    if (ow->type != ONEWIRE_RECHERCHE) return SLOT_LECTURE;
+
+    // Recherche ROM : lecture du bit, lecture du complément, écriture de la direction
+    uint16 triplet = ow->bit - bits_tx;
+    if (triplet % 3 != 2) return SLOT_LECTURE;
+
+    uint8 numero = triplet / 3 + 1; // n° du bit de la ROM (1 à 64)
+    uint8 direction;
+
+    if (ow->bit_id && ow->bit_complement)
+    {
+        return SLOT_ERREUR; // aucun périphérique n'a répondu
+    }
+    else if (ow->bit_id != ow->bit_complement)
+    {
+        direction = ow->bit_id; // tous les périphériques restants ont le même bit
+    }
+    else
+    {
+        // Divergence : on suit le chemin de la recherche précédente, puis la branche '1', puis la branche '0'
+        if (numero < ow->derniere_divergence)
+        {
+            direction = READ_BIT(ow->rom_chemin[(numero - 1) / 8],((numero - 1) % 8));
+        }
+        else
+        {
+            direction = (numero == ow->derniere_divergence) ? 1 : 0;
+        }
+        if (direction == 0) ow->divergence_courante = numero;
+    }
+
+    if (direction)
+    {
+        SET_BIT(ow->rom[(numero - 1) / 8],((numero - 1) % 8));
+        return SLOT_ECRITURE_1;
+    }
+    CLR_BIT(ow->rom[(numero - 1) / 8],((numero - 1) % 8));
+    return SLOT_ECRITURE_0;
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Stocker_Bit
+  DESCRIPTION   : Range le bit lu lors d'un slot de lecture
+  PARAMETRES    : bus concerné, bit lu
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR OneWire_Stocker_Bit(OneWire_Struct *ow, uint8 valeur)
+{
+    uint16 index = ow->bit - 8 * ow->nb_tx;
+
+    if (ow->type == ONEWIRE_RECHERCHE)
+    {
+        if (index % 3 == 0) ow->bit_id = valeur;
+        else                ow->bit_complement = valeur;
+    }
+    else if (valeur)
+    {
+        SET_BIT(ow->rx[index / 8],(index % 8));
+    }
+    else
+    {
+        CLR_BIT(ow->rx[index / 8],(index % 8));
+    }
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Fin_Echange
+  DESCRIPTION   : Statut final d'un échange 1-Wire dont tous les slots sont terminés
+  (recherche ROM : l'état de la recherche n'avance que si le CRC de la ROM est correct,
+  une recherche perturbée peut donc être relancée sans sauter de périphérique)
+  PARAMETRES    : bus concerné
+  RETOUR        : statut final
+===============================================================================*/
+static OneWire_Statut ICACHE_RAM_ATTR OneWire_Fin_Echange(OneWire_Struct *ow)
+{
+    if (ow->type != ONEWIRE_RECHERCHE) return ONEWIRE_TERMINE;
+
+    if (OneWire_CRC8(ow->rom,8) != 0) return ONEWIRE_ERREUR_CRC;
+
+    for (uint8 i = 0; i < 8; i++) ow->rom_chemin[i] = ow->rom[i];
+    ow->derniere_divergence = ow->divergence_courante;
+    if (ow->derniere_divergence == 0) ow->dernier_peripherique = true;
+
+    return ONEWIRE_TERMINE;
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Avancer
+  DESCRIPTION   : Exécute l'étape courante de la machine d'état d'un bus
+                  et programme l'échéance de l'étape suivante
+  PARAMETRES    : N° du bus
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR OneWire_Avancer(uint8 bus)
+{
+    OneWire_Struct *ow = &OneWire[bus];
+    uint32 delai = 0;
+
+    switch (ow->etape)
+    {
+        // -------------------------
+        // Reset / présence
+        // -------------------------
+        case ETAPE_RESET_DEBUT :
+            LIGNE_BASSE(ow->gpio);
+            ow->etape = ETAPE_RESET_RELACHE;
+            delai = ONEWIRE_T_RESET_BAS;
+        break;
+
+        case ETAPE_RESET_RELACHE :
+            // L'impulsion de présence est mémorisée par l'interruption GPIO :
+            // un échantillonnage retardé ne la manque pas
+            ow->presence = false;
+            FRONTS_ACTIVES(ow->gpio);
+            LIGNE_RELACHEE(ow->gpio);
+            ow->etape = ETAPE_RESET_PRESENCE;
+            delai = ONEWIRE_T_RESET_PRESENCE;
+        break;
+
+        case ETAPE_RESET_PRESENCE :
+            // Un périphérique présent maintient la ligne à l'état bas
+            FRONTS_DESACTIVES(ow->gpio);
+            if (!ow->presence && REGISTRE_READ_BIT(Registre_GPIO->IN,ow->gpio))
+            {
+                OneWire_Terminer(bus,ONEWIRE_ERREUR_PRESENCE);
+                return;
+            }
+            ow->etape = ETAPE_SLOT_SUIVANT;
+            delai = ONEWIRE_T_RESET_FIN;
+        break;
+
+        // -------------------------
+        // Slots de lecture / écriture
+        // -------------------------
+        case ETAPE_SLOT_DEBUT :
+            ow->slot = OneWire_Choisir_Slot(ow);
+            if (ow->slot == SLOT_ERREUR)
+            {
+                OneWire_Terminer(bus,ONEWIRE_ERREUR_PRESENCE);
+                return;
+            }
+            LIGNE_BASSE(ow->gpio);
+            ow->debut_phase = Lire_Compteur_Cycles();
+            if (ow->slot == SLOT_ECRITURE_0)
+            {
+                ow->etape = ETAPE_SLOT_RELACHE;
+                delai = ONEWIRE_T_ECRITURE_0_BAS;
+            }
+            else
+            {
+                ow->etape = ETAPE_SLOT_COURT;
+                delai = ONEWIRE_T_SLOT_BAS;
+            }
+        break;
+
+        case ETAPE_SLOT_RELACHE :
+        {
+            // Au-delà de 120us, la ligne basse ne serait plus un '0' : l'échange est abandonné
+            uint32 duree = Lire_Compteur_Cycles() - ow->debut_phase;
+            LIGNE_RELACHEE(ow->gpio);
+            if (duree > US(ONEWIRE_T_ECRITURE_0_MAX))
+            {
+                OneWire_Terminer(bus,ONEWIRE_ERREUR_DEPASSEMENT);
+                return;
+            }
+            ow->etape = ETAPE_SLOT_SUIVANT;
+            delai = ONEWIRE_T_ECRITURE_0_FIN;
+        }
+        break;
+
+        case ETAPE_SLOT_COURT :
+        {
+            // Au-delà de 15us, la ligne basse serait lue comme un '0' par les périphériques
+            uint32 duree = Lire_Compteur_Cycles() - ow->debut_phase;
+            LIGNE_RELACHEE(ow->gpio);
+            if (duree > US(ONEWIRE_T_SLOT_BAS_MAX))
+            {
+                OneWire_Terminer(bus,ONEWIRE_ERREUR_DEPASSEMENT);
+                return;
+            }
+            if (ow->slot == SLOT_ECRITURE_1)
+            {
+                ow->etape = ETAPE_SLOT_SUIVANT;
+                delai = ONEWIRE_T_ECRITURE_1_FIN;
+                break;
+            }
+
+            // Echantillonnage compté depuis le début du slot : seule la latence de cette étape compte
+            ow->etape = ETAPE_SLOT_LECTURE;
+            ow->echeance = ow->debut_phase + US(ONEWIRE_T_ECHANTILLON);
+            ow->en_attente = true;
+        }
+        return;
+
+        case ETAPE_SLOT_LECTURE :
+        {
+            // Après 15us, le niveau imposé par le périphérique n'est plus garanti
+            uint8 valeur = REGISTRE_READ_BIT(Registre_GPIO->IN,ow->gpio);
+            if ((Lire_Compteur_Cycles() - ow->debut_phase) > US(ONEWIRE_T_ECHANTILLON_MAX))
+            {
+                OneWire_Terminer(bus,ONEWIRE_ERREUR_DEPASSEMENT);
+                return;
+            }
+            OneWire_Stocker_Bit(ow,valeur);
+            ow->etape = ETAPE_SLOT_SUIVANT;
+            delai = ONEWIRE_T_LECTURE_FIN;
+        }
+        break;
+
+        case ETAPE_SLOT_SUIVANT :
+            if (ow->slot != SLOT_AUCUN) ow->bit++;
+            if (ow->bit >= ow->nb_bits)
+            {
+                OneWire_Terminer(bus,OneWire_Fin_Echange(ow));
+                return;
+            }
+            ow->etape = ETAPE_SLOT_DEBUT;
+            OneWire_Avancer(bus); // le slot suivant commence immédiatement
+            return;
+
+        // -------------------------
+        // DHT
+        // -------------------------
+        case ETAPE_DHT_START :
+            LIGNE_BASSE(ow->gpio);
+            ow->etape = ETAPE_DHT_RELACHE;
+            delai = (ow->modele == DHT11) ? DHT11_T_START : DHT22_T_START;
+        break;
+
+        case ETAPE_DHT_RELACHE :
+            LIGNE_RELACHEE(ow->gpio);
+            ow->nb_fronts = 0;
+            ow->dernier_front = Lire_Compteur_Cycles();
+            FRONTS_ACTIVES(ow->gpio);
+            ow->etape = ETAPE_DHT_TIMEOUT;
+            delai = DHT_T_TIMEOUT;
+        break;
+
+        case ETAPE_DHT_TIMEOUT :
+        default :
+            FRONTS_DESACTIVES(ow->gpio);
+            OneWire_Terminer(bus,ONEWIRE_ERREUR_CAPTEUR);
+            return;
+    }
+
+    // Les durées sont comptées depuis l'action réellement effectuée :
+    // un retard d'interruption allonge une phase mais ne la raccourcit jamais
+    // (l'interruption traite les échéances jusqu'à ONEWIRE_DELAI_MIN en avance : la marge est ajoutée)
+    ow->echeance = Lire_Compteur_Cycles() + US(delai) + ONEWIRE_DELAI_MIN;
+    ow->en_attente = true;
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Demarrer
+  DESCRIPTION   : Démarre un échange sur un bus libre
+  PARAMETRES    : N° du bus, type d'échange, première étape, fonction de fin
+  RETOUR        : true si l'échange a démarré, false si le bus est occupé
+===============================================================================*/
+static bool OneWire_Demarrer(uint8 bus, OneWire_Type type, uint8 etape, OneWire_Callback fin)
+{
+    OneWire_Struct *ow = &OneWire[bus];
+    uint32 maintenant;
+
+    ETS_INTR_LOCK();
+    if (!ow->actif || ow->statut == ONEWIRE_EN_COURS)
+    {
+        ETS_INTR_UNLOCK();
+        return false;
+    }
+    maintenant = Lire_Compteur_Cycles();
+    ow->type = type;
+    ow->etape = etape;
+    ow->fin = fin;
+    ow->bit = 0;
+    ow->slot = SLOT_AUCUN;
+    ow->statut = ONEWIRE_EN_COURS;
+    ow->echeance = maintenant + ONEWIRE_DELAI_MIN;
+    ow->en_attente = true;
+    OneWire_Planifier(maintenant);
+    ETS_INTR_UNLOCK();
+
+    return true;
+}
+
+// ##########################################################################################################################
+//                                              FONCTIONS ONEWIRE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_OneWire
+  DESCRIPTION   : initialise un bus "1 fil" sur une GPIO (drain ouvert, ligne relâchée)
+  PARAMETRES    : N° du bus (0 à NB_BUS_ONEWIRE-1), N° de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void init_OneWire(uint8 bus, uint8 GPIO)
+{
+    if (bus >= NB_BUS_ONEWIRE) return;
+
+    OneWire_Struct *ow = &OneWire[bus];
+
+    // Etape 1 : enregistrement auprès du multiplexeur TIMER1 (une seule fois pour tous les bus)
+    if (client_timer_OneWire < 0)
+    {
+        client_timer_OneWire = TIMER1_Mux_Ajouter_Client(Interruption_OneWire_Timer,NULL);
+        if (client_timer_OneWire < 0) return;
+    }
+
+    // Etape 2 : GPIO en sortie drain ouvert, ligne relâchée
+    init_GPIO(GPIO,GPIO_OUTPUT);
+    REGISTRE_CONFIG_SET_BIT(Registre_GPIO->PIN[GPIO],BIT_GPIO_DRIVER); // On ouvre le drain
+    REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,(1 << GPIO));
+
+    // Etape 3 : la fonction d'interruption GPIO (présence, DHT) est associée mais reste inactive
+    GPIO_Attacher_Interruption(GPIO,INACTIF,Interruption_OneWire_DHT);
+
+    // Etape 4 : état du bus
+    ETS_INTR_LOCK();
+    ow->gpio = GPIO;
+    ow->statut = ONEWIRE_LIBRE;
+    ow->en_attente = false;
+    ow->fin = NULL;
+    ow->derniere_divergence = 0;
+    ow->dernier_peripherique = false;
+    ow->actif = true;
+    ETS_INTR_UNLOCK();
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Transaction
+  DESCRIPTION   : Démarre une transaction 1-Wire : reset (optionnel),
+                  écriture puis lecture d'octets
+  PARAMETRES    : N° du bus
+                  Reset préalable (true / false)
+                  Octets à écrire, nombre d'octets à écrire
+                  Nombre d'octets à lire (lisibles avec OneWire_Lire_Reception)
+                  Fonction appelée à la fin de la transaction (ou NULL)
+  RETOUR        : true si la transaction a démarré, false si le bus est occupé
+===============================================================================*/
+bool OneWire_Transaction(uint8 bus, bool reset, const uint8 *tx, uint8 nb_tx, uint8 nb_rx, OneWire_Callback fin)
+{
+    if (bus >= NB_BUS_ONEWIRE || nb_tx > ONEWIRE_TAILLE_BUFFER || nb_rx > ONEWIRE_TAILLE_BUFFER) return false;
+
+    OneWire_Struct *ow = &OneWire[bus];
+    if (ow->statut == ONEWIRE_EN_COURS) return false;
+
+    for (uint8 i = 0; i < nb_tx; i++) ow->tx[i] = tx[i];
+    ow->nb_tx = nb_tx;
+    ow->nb_rx = nb_rx;
+    ow->nb_bits = 8 * (nb_tx + nb_rx);
+
+    return OneWire_Demarrer(bus,ONEWIRE_TRANSACTION,reset ? ETAPE_RESET_DEBUT : ETAPE_SLOT_SUIVANT,fin);
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Rechercher_ROM
+  DESCRIPTION   : Démarre la recherche du prochain périphérique présent sur le bus
+                  (résultat lisible avec OneWire_Lire_ROM)
+  PARAMETRES    : N° du bus
+                  true pour reprendre la recherche depuis le premier périphérique
+                  Fonction appelée à la fin de la recherche (ou NULL)
+  RETOUR        : true si la recherche a démarré,
+                  false si le bus est occupé ou si tous les périphériques ont été trouvés
+===============================================================================*/
+bool OneWire_Rechercher_ROM(uint8 bus, bool nouvelle_recherche, OneWire_Callback fin)
+{
+    if (bus >= NB_BUS_ONEWIRE) return false;
+
+    OneWire_Struct *ow = &OneWire[bus];
+    if (ow->statut == ONEWIRE_EN_COURS) return false;
+
+    if (nouvelle_recherche)
+    {
+        ow->derniere_divergence = 0;
+        ow->dernier_peripherique = false;
+        for (uint8 i = 0; i < 8; i++) ow->rom[i] = ow->rom_chemin[i] = 0;
+    }
+    if (ow->dernier_peripherique) return false;
+
+    ow->tx[0] = ONEWIRE_CMD_SEARCH_ROM;
+    ow->nb_tx = 1;
+    ow->nb_rx = 0;
+    ow->nb_bits = 8 + 3 * 64; // commande + 64 triplets (bit, complément, direction)
+    ow->divergence_courante = 0;
+
+    return OneWire_Demarrer(bus,ONEWIRE_RECHERCHE,ETAPE_RESET_DEBUT,fin);
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Lire_DHT
+  DESCRIPTION   : Démarre la lecture d'un capteur DHT11 / DHT22
+                  (résultat lisible avec DHT_Temperature et DHT_Humidite)
+  PARAMETRES    : N° du bus, modèle du capteur,
+                  fonction appelée à la fin de la lecture (ou NULL)
+  RETOUR        : true si la lecture a démarré, false si le bus est occupé
+===============================================================================*/
+bool OneWire_Lire_DHT(uint8 bus, DHT_Modele modele, OneWire_Callback fin)
+{
+    if (bus >= NB_BUS_ONEWIRE) return false;
+
+    OneWire_Struct *ow = &OneWire[bus];
+    if (ow->statut == ONEWIRE_EN_COURS) return false;
+
+    ow->modele = modele;
+    for (uint8 i = 0; i < 5; i++) ow->dht[i] = 0;
+
+    return OneWire_Demarrer(bus,ONEWIRE_DHT,ETAPE_DHT_START,fin);
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Etat
+  DESCRIPTION   : Indique le statut du bus (échange en cours, terminé, erreur)
+  PARAMETRES    : N° du bus
+  RETOUR        : Statut du bus
+===============================================================================*/
+OneWire_Statut OneWire_Etat(uint8 bus)
+{
+    if (bus >= NB_BUS_ONEWIRE) return ONEWIRE_LIBRE;
+    return OneWire[bus].statut;
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Lire_Reception
+  DESCRIPTION   : Copie les octets lus lors de la dernière transaction
+  PARAMETRES    : N° du bus, buffer de destination, nombre d'octets voulus
+  RETOUR        : Nombre d'octets copiés
+===============================================================================*/
+uint8 OneWire_Lire_Reception(uint8 bus, uint8 *buffer, uint8 len)
+{
+    if (bus >= NB_BUS_ONEWIRE || OneWire[bus].statut != ONEWIRE_TERMINE) return 0;
+
+    if (len > OneWire[bus].nb_rx) len = OneWire[bus].nb_rx;
+    for (uint8 i = 0; i < len; i++) buffer[i] = OneWire[bus].rx[i];
+    return len;
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_Lire_ROM
+  DESCRIPTION   : Copie l'adresse ROM (8 octets) trouvée par la dernière recherche
+  PARAMETRES    : N° du bus, buffer de destination (8 octets)
+  RETOUR        : true si c'était le dernier périphérique du bus
+===============================================================================*/
+bool OneWire_Lire_ROM(uint8 bus, uint8 *rom)
+{
+    if (bus >= NB_BUS_ONEWIRE) return true;
+
+    for (uint8 i = 0; i < 8; i++) rom[i] = OneWire[bus].rom[i];
+    return OneWire[bus].dernier_peripherique;
+}
+
+/*===============================================================================
+  FONCTION      : DHT_Temperature
+  DESCRIPTION   : Température mesurée lors de la dernière lecture DHT
+  PARAMETRES    : N° du bus
+  RETOUR        : Température (dixièmes de °C)
+===============================================================================*/
+int16 DHT_Temperature(uint8 bus)
+{
+    if (bus >= NB_BUS_ONEWIRE) return 0;
+
+    uint8 *dht = OneWire[bus].dht;
+    if (OneWire[bus].modele == DHT11)
+    {
+        return 10 * dht[2] + dht[3];
+    }
+
+    int16 temperature = ((dht[2] & 0x7F) << 8) | dht[3];
+    return (dht[2] & 0x80) ? -temperature : temperature;
+}
+
+/*===============================================================================
+  FONCTION      : DHT_Humidite
+  DESCRIPTION   : Humidité mesurée lors de la dernière lecture DHT
+  PARAMETRES    : N° du bus
+  RETOUR        : Humidité relative (dixièmes de %)
+===============================================================================*/
+uint16 DHT_Humidite(uint8 bus)
+{
+    if (bus >= NB_BUS_ONEWIRE) return 0;
+
+    uint8 *dht = OneWire[bus].dht;
+    if (OneWire[bus].modele == DHT11)
+    {
+        return 10 * dht[0] + dht[1];
+    }
+    return (dht[0] << 8) | dht[1];
+}
+
+/*===============================================================================
+  FONCTION      : OneWire_CRC8
+  DESCRIPTION   : Calcule le CRC 8 bits Maxim (X^8 + X^5 + X^4 + 1)
+  PARAMETRES    : données, nombre d'octets
+  RETOUR        : CRC (0 si les données incluent un CRC valide)
+===============================================================================*/
+uint8 ICACHE_RAM_ATTR OneWire_CRC8(const uint8 *donnees, uint8 len)
+{
+    uint8 crc = 0;
+    while (len--)
+    {
+        uint8 octet = *donnees++;
+        for (uint8 i = 0; i < 8; i++)
+        {
+            uint8 melange = (crc ^ octet) & 0x01;
+            crc >>= 1;
+            if (melange) crc ^= 0x8C;
+            octet >>= 1;
+        }
+    }
+    return crc;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_OneWire_Timer
+  DESCRIPTION   : Interruption du TIMER1 : avance d'une étape tous les bus dont
+                  l'échéance est atteinte, puis reprogramme le TIMER1
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_OneWire_Timer(void *argument)
+{
+    uint32 maintenant = Lire_Compteur_Cycles();
+
+    for (uint8 i = 0; i < NB_BUS_ONEWIRE; i++)
+    {
+        OneWire_Struct *ow = &OneWire[i];
+        if (!ow->actif || !ow->en_attente) continue;
+
+        if ((int32)(ow->echeance - maintenant) < ONEWIRE_DELAI_MIN)
+        {
+            ow->en_attente = false;
+            OneWire_Avancer(i);
+        }
+    }
+
+    OneWire_Planifier(Lire_Compteur_Cycles());
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_OneWire_DHT
+  DESCRIPTION   : Interruption GPIO (front descendant) : impulsion de présence 1-Wire
+                  ou réponse d'un DHT
+  Chaque bit DHT est codé par la durée entre deux fronts descendants :
+  ~76us pour un '0', ~120us pour un '1'
+  PARAMETRES    : N° de la GPIO, état logique de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_OneWire_DHT(uint8 GPIO, uint8 etat)
+{
+    uint32 maintenant = Lire_Compteur_Cycles();
+
+    for (uint8 i = 0; i < NB_BUS_ONEWIRE; i++)
+    {
+        OneWire_Struct *ow = &OneWire[i];
+        if (!ow->actif || ow->gpio != GPIO || ow->statut != ONEWIRE_EN_COURS) continue;
+
+        if (ow->type != ONEWIRE_DHT)
+        {
+            if (ow->etape == ETAPE_RESET_PRESENCE) ow->presence = true;
+            continue;
+        }
+
+        // Fronts 0 et 1 : réponse du capteur, puis un bit par front
+        if (ow->nb_fronts >= 2)
+        {
+            uint8 index = ow->nb_fronts - 2;
+            if ((maintenant - ow->dernier_front) > US(DHT_T_SEUIL_BIT))
+            {
+                SET_BIT(ow->dht[index / 8],(7 - (index % 8)));
+            }
+        }
+        ow->dernier_front = maintenant;
+        ow->nb_fronts++;
+
+        if (ow->nb_fronts >= DHT_NB_FRONTS)
+        {
+            FRONTS_DESACTIVES(GPIO);
+
+            uint8 somme = ow->dht[0] + ow->dht[1] + ow->dht[2] + ow->dht[3];
+            OneWire_Terminer(i,(somme == ow->dht[4]) ? ONEWIRE_TERMINE : ONEWIRE_ERREUR_CRC);
+            OneWire_Planifier(maintenant);
+        }
+    }
+}
@@ -0,0 +1,251 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : OneWire_esp8266.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Gestion non bloquante des capteurs "1 fil" : bus 1-Wire (DS18B20, ...) et capteurs DHT11 / DHT22
+ *  Chaque échange est une machine d'état avancée par les interruptions du TIMER1 (une étape par interruption) :
+ *  aucune attente active, les interruptions ne sont jamais masquées (Scheduler, UART logicielles restent servis).
+ *  Les durées réellement obtenues sont mesurées sur le compteur de cycles :
+ * *  - slot de lecture ou d'écriture à '1' : ligne basse 2us au moins, relâchée, échantillonnage 10us après le début du slot.
+ *    Une interruption retardée de plus de 5us (ligne basse ou échantillonnage au-delà de 15us) abandonne l'échange
+ *  - impulsion de présence : détectée par l'interruption GPIO (front descendant), quel que soit le retard de l'échantillonnage
+ *  - slot d'écriture à '0' (60 à 120us) : si l'interruption qui relâche la ligne arrive trop tard,
+ *    l'échange est abandonné
+ *  Un échange abandonné se termine par ONEWIRE_ERREUR_DEPASSEMENT : l'application le relance (les données reçues
+ *  ne sont jamais fausses). Une interruption d'un autre module de plus de 5us provoque au plus un abandon.
+ *  La fin d'un échange est signalée par le statut du bus et, si demandé, par une fonction appelée sous interruption.
+ *
+ *  Les GPIO sont utilisées en drain ouvert (BIT_GPIO_DRIVER) : une résistance de tirage externe est nécessaire.
+ *  Le TIMER1 est partagé avec les autres modules (Scheduler, ...) par le multiplexeur (voir Multiplexeur_TIMER1.h)
+ *
+ *  Lien utile : https://www.maximintegrated.com/en/app-notes/index.mvp/id/126 (timings 1-Wire)
+ *               https://www.maximintegrated.com/en/app-notes/index.mvp/id/187 (recherche des ROM)
+ * =============================================================================================================================================
+ */
+
+#ifndef __ONEWIRE_ESP8266_H__
+#define __ONEWIRE_ESP8266_H__
+
+// Dépendances
+#include "registres_esp8266.h"
+#include "GPIO_esp8266.h"
+#include "Multiplexeur_TIMER1.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre de bus pouvant être gérés en même temps
+#define NB_BUS_ONEWIRE 4
+
+// Taille des buffers d'émission / réception d'une transaction (octets)
+#define ONEWIRE_TAILLE_BUFFER 16
+
+// Conversion des timings (us -> cycles CPU)
+#define ONEWIRE_CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+
+// Délai minimal entre deux interruptions du TIMER1 (en cycles CPU : 1us)
+#define ONEWIRE_DELAI_MIN 80
+
+// Timings 1-Wire (us) - vitesse standard (valeurs recommandées par la note Maxim AN126)
+#define ONEWIRE_T_RESET_BAS      480 // H : impulsion de reset
+#define ONEWIRE_T_RESET_PRESENCE 70  // I : échantillonnage de l'impulsion de présence
+#define ONEWIRE_T_RESET_FIN      410 // J : fin de la séquence de reset
+#define ONEWIRE_T_SLOT_BAS       2   // A : début d'un slot d'écriture à '1' ou de lecture (1us au moins)
+#define ONEWIRE_T_SLOT_BAS_MAX   15  // au-delà, la ligne basse serait lue comme un '0' par les périphériques
+#define ONEWIRE_T_ECHANTILLON    10  // A + E : échantillonnage, compté depuis le début du slot de lecture
+#define ONEWIRE_T_ECHANTILLON_MAX 15 // au-delà, le niveau imposé par le périphérique n'est plus garanti
+#define ONEWIRE_T_LECTURE_FIN    55  // F : fin du slot de lecture
+#define ONEWIRE_T_ECRITURE_1_FIN 64  // B : fin du slot d'écriture à '1'
+#define ONEWIRE_T_ECRITURE_0_BAS 60  // C : slot d'écriture à '0'
+#define ONEWIRE_T_ECRITURE_0_MAX 120 // durée maximale de la ligne basse d'un slot d'écriture à '0'
+#define ONEWIRE_T_ECRITURE_0_FIN 10  // D : récupération après écriture à '0'
+
+// Timings DHT (us)
+#define DHT11_T_START          18000 // impulsion de démarrage DHT11
+#define DHT22_T_START          1100  // impulsion de démarrage DHT22
+#define DHT_T_TIMEOUT          6000  // durée maximale de la réponse du capteur
+#define DHT_T_SEUIL_BIT        100   // période entre deux fronts descendants au-delà de laquelle le bit vaut '1'
+#define DHT_NB_FRONTS          42    // réponse du capteur + 40 bits + fin de trame
+
+// Commandes 1-Wire
+#define ONEWIRE_CMD_SEARCH_ROM 0xF0
+#define ONEWIRE_CMD_READ_ROM   0x33
+#define ONEWIRE_CMD_MATCH_ROM  0x55
+#define ONEWIRE_CMD_SKIP_ROM   0xCC
+
+// Statut d'un bus
+// (ONEWIRE_ERREUR_DEPASSEMENT : interruption trop tardive, un slot a dépassé sa durée maximale : échange à relancer)
+typedef enum {ONEWIRE_LIBRE,ONEWIRE_EN_COURS,ONEWIRE_TERMINE,ONEWIRE_ERREUR_PRESENCE,ONEWIRE_ERREUR_CAPTEUR,ONEWIRE_ERREUR_CRC,ONEWIRE_ERREUR_DEPASSEMENT} OneWire_Statut;
+
+// Type d'échange
+typedef enum {ONEWIRE_TRANSACTION,ONEWIRE_RECHERCHE,ONEWIRE_DHT} OneWire_Type;
+
+// Modèles de capteurs DHT
+typedef enum {DHT11,DHT22} DHT_Modele;
+
+// Fonction appelée (sous interruption) à la fin d'un échange : N° du bus, statut final
+typedef void (*OneWire_Callback)(uint8 bus, OneWire_Statut statut);
+
+// Etat d'un bus
+// Les échéances sont exprimées en cycles CPU (80 MHz, voir Lire_Compteur_Cycles)
+typedef struct {
+  bool actif;
+  uint8 gpio;
+  volatile OneWire_Statut statut;
+  OneWire_Callback fin;
+
+  // Echange en cours
+  OneWire_Type type;
+  uint8 etape;
+  uint32 echeance;
+  bool en_attente;           // une échéance TIMER1 est programmée
+  uint16 bit;                // index du bit (ou du slot) courant
+  uint16 nb_bits;            // nombre total de bits de l'échange
+  uint8 slot;                // type du slot courant (écriture '0', écriture '1', lecture)
+  uint32 debut_phase;        // instant où la ligne a été basculée (cycles CPU) : durées des slots vérifiées
+  volatile bool presence;    // front descendant détecté après le reset
+
+  // Transaction : reset éventuel, écriture de nb_tx octets puis lecture de nb_rx octets
+  uint8 tx[ONEWIRE_TAILLE_BUFFER];
+  uint8 nb_tx;
+  uint8 rx[ONEWIRE_TAILLE_BUFFER];
+  uint8 nb_rx;
+
+  // Recherche des ROM (algorithme Maxim AN187)
+  uint8 rom[8];
+  uint8 rom_chemin[8];       // dernière ROM valide (CRC correct) : chemin suivi par la recherche suivante
+  uint8 derniere_divergence;
+  uint8 divergence_courante;
+  bool dernier_peripherique;
+  uint8 bit_id;
+  uint8 bit_complement;
+
+  // DHT
+  DHT_Modele modele;
+  uint32 dernier_front;
+  uint8 nb_fronts;
+  uint8 dht[5];
+} OneWire_Struct;
+
+extern OneWire_Struct OneWire[NB_BUS_ONEWIRE];
+
+// ##########################################################################################################################
+//                                              FONCTIONS ONEWIRE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_OneWire
+  DESCRIPTION   : initialise un bus "1 fil" sur une GPIO (drain ouvert, ligne relâchée)
+  PARAMETRES    : N° du bus (0 à NB_BUS_ONEWIRE-1), N° de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void init_OneWire(uint8 bus, uint8 GPIO);
+
+/*===============================================================================
+  FONCTION      : OneWire_Transaction
+  DESCRIPTION   : Démarre une transaction 1-Wire : reset (optionnel),
+                  écriture puis lecture d'octets
+  PARAMETRES    : N° du bus
+                  Reset préalable (true / false)
+                  Octets à écrire, nombre d'octets à écrire
+                  Nombre d'octets à lire (lisibles avec OneWire_Lire_Reception)
+                  Fonction appelée à la fin de la transaction (ou NULL)
+  RETOUR        : true si la transaction a démarré, false si le bus est occupé
+===============================================================================*/
+bool OneWire_Transaction(uint8 bus, bool reset, const uint8 *tx, uint8 nb_tx, uint8 nb_rx, OneWire_Callback fin);
+
+/*===============================================================================
+  FONCTION      : OneWire_Rechercher_ROM
+  DESCRIPTION   : Démarre la recherche du prochain périphérique présent sur le bus
+                  (résultat lisible avec OneWire_Lire_ROM)
+  PARAMETRES    : N° du bus
+                  true pour reprendre la recherche depuis le premier périphérique
+                  Fonction appelée à la fin de la recherche (ou NULL)
+  RETOUR        : true si la recherche a démarré,
+                  false si le bus est occupé ou si tous les périphériques ont été trouvés
+===============================================================================*/
+bool OneWire_Rechercher_ROM(uint8 bus, bool nouvelle_recherche, OneWire_Callback fin);
+
+/*===============================================================================
+  FONCTION      : OneWire_Lire_DHT
+  DESCRIPTION   : Démarre la lecture d'un capteur DHT11 / DHT22
+                  (résultat lisible avec DHT_Temperature et DHT_Humidite)
+  PARAMETRES    : N° du bus, modèle du capteur,
+                  fonction appelée à la fin de la lecture (ou NULL)
+  RETOUR        : true si la lecture a démarré, false si le bus est occupé
+===============================================================================*/
+bool OneWire_Lire_DHT(uint8 bus, DHT_Modele modele, OneWire_Callback fin);
+
+/*===============================================================================
+  FONCTION      : OneWire_Etat
+  DESCRIPTION   : Indique le statut du bus (échange en cours, terminé, erreur)
+  PARAMETRES    : N° du bus
+  RETOUR        : Statut du bus
+===============================================================================*/
+OneWire_Statut OneWire_Etat(uint8 bus);
+
+/*===============================================================================
+  FONCTION      : OneWire_Lire_Reception
+  DESCRIPTION   : Copie les octets lus lors de la dernière transaction
+  PARAMETRES    : N° du bus, buffer de destination, nombre d'octets voulus
+  RETOUR        : Nombre d'octets copiés
+===============================================================================*/
+uint8 OneWire_Lire_Reception(uint8 bus, uint8 *buffer, uint8 len);
+
+/*===============================================================================
+  FONCTION      : OneWire_Lire_ROM
+  DESCRIPTION   : Copie l'adresse ROM (8 octets) trouvée par la dernière recherche
+  PARAMETRES    : N° du bus, buffer de destination (8 octets)
+  RETOUR        : true si c'était le dernier périphérique du bus
+===============================================================================*/
+bool OneWire_Lire_ROM(uint8 bus, uint8 *rom);
+
+/*===============================================================================
+  FONCTION      : DHT_Temperature
+  DESCRIPTION   : Température mesurée lors de la dernière lecture DHT
+  PARAMETRES    : N° du bus
+  RETOUR        : Température (dixièmes de °C)
+===============================================================================*/
+int16 DHT_Temperature(uint8 bus);
+
+/*===============================================================================
+  FONCTION      : DHT_Humidite
+  DESCRIPTION   : Humidité mesurée lors de la dernière lecture DHT
+  PARAMETRES    : N° du bus
+  RETOUR        : Humidité relative (dixièmes de %)
+===============================================================================*/
+uint16 DHT_Humidite(uint8 bus);
+
+/*===============================================================================
+  FONCTION      : OneWire_CRC8
+  DESCRIPTION   : Calcule le CRC 8 bits Maxim (X^8 + X^5 + X^4 + 1)
+  PARAMETRES    : données, nombre d'octets
+  RETOUR        : CRC (0 si les données incluent un CRC valide)
+===============================================================================*/
+uint8 OneWire_CRC8(const uint8 *donnees, uint8 len);
+
+/*===============================================================================
+  FONCTION      : Interruption_OneWire_Timer
+  DESCRIPTION   : Interruption du TIMER1 : avance d'une étape tous les bus dont
+                  l'échéance est atteinte, puis reprogramme le TIMER1
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_OneWire_Timer(void *argument);
+
+/*===============================================================================
+  FONCTION      : Interruption_OneWire_DHT
+  DESCRIPTION   : Interruption GPIO (front descendant) : impulsion de présence 1-Wire
+                  ou réponse d'un DHT
+  PARAMETRES    : N° de la GPIO, état logique de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_OneWire_DHT(uint8 GPIO, uint8 etat);
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,255 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Pool_Memoire.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Allocation mémoire déterministe sans utiliser le tas (malloc / new)
+ *  - Pool : blocs de taille fixe, allocation et libération en O(1)
+ *  - Arène : allocation séquentielle, libérée en une seule fois
+ * =============================================================================================================================================
+ */
+
+#include "Pool_Memoire.h"
+
+// ##########################################################################################################################
+//                                      FONCTIONS POOL
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Pool
+  DESCRIPTION   : Rend tous les blocs d'un pool libres et remet ses compteurs à zéro
+  PARAMETRES    : Pool (déclaré avec POOL_DECLARER)
+  RETOUR        : rien
+===============================================================================*/
+void init_Pool(Pool_Memoire *pool)
+{
+    uint32 etat = Masquer_Interruptions();
+
+    // chaînage des blocs dans l'ordre des adresses
+    pool->libres = NULL;
+    for (uint16 i = pool->nb_blocs; i > 0; i--)
+    {
+        Pool_Bloc *bloc = (Pool_Bloc *)(pool->memoire + (uint32)(i - 1) * pool->taille_bloc);
+        bloc->suivant = pool->libres;
+        pool->libres = bloc;
+    }
+    for (uint16 i = 0; i < (pool->nb_blocs + 31) / 32; i++) pool->occupes[i] = 0;
+    pool->nb_utilises = 0;
+    pool->max_utilises = 0;
+    pool->nb_echecs = 0;
+    pool->nb_erreurs = 0;
+
+    Restaurer_Interruptions(etat);
+}
+
+/*===============================================================================
+  FONCTION      : Pool_Allouer
+  DESCRIPTION   : Réserve un bloc du pool (O(1), utilisable sous interruption)
+  PARAMETRES    : Pool
+  RETOUR        : Adresse du bloc, NULL si le pool est vide
+===============================================================================*/
+void ICACHE_RAM_ATTR *Pool_Allouer(Pool_Memoire *pool)
+{
+    Pool_Bloc *bloc;
+    uint32 etat = Masquer_Interruptions();
+
+    bloc = pool->libres;
+    if (bloc != NULL)
+    {
+        uint32 index = ((uint8 *)bloc - pool->memoire) / pool->taille_bloc;
+
+        pool->libres = bloc->suivant;
+        pool->occupes[index / 32] |= (1UL << (index % 32));
+        pool->nb_utilises++;
+        if (pool->nb_utilises > pool->max_utilises) pool->max_utilises = pool->nb_utilises;
+    }
+    else
+    {
+        pool->nb_echecs++;
+    }
+
+    Restaurer_Interruptions(etat);
+    return bloc;
+}
+
+/*===============================================================================
+  FONCTION      : Pool_Liberer
+  DESCRIPTION   : Rend un bloc au pool (O(1), utilisable sous interruption)
+  Une adresse étrangère au pool ou un bloc déjà libre est refusé (compteur nb_erreurs).
+  PARAMETRES    : Pool, adresse du bloc (retournée par Pool_Allouer)
+  RETOUR        : false si l'adresse n'est pas un bloc alloué de ce pool
+===============================================================================*/
+bool ICACHE_RAM_ATTR Pool_Liberer(Pool_Memoire *pool, void *bloc)
+{
+    uint32 decalage = (uint8 *)bloc - pool->memoire;
+    uint32 index = decalage / pool->taille_bloc;
+    bool valide;
+    uint32 etat;
+
+    // l'adresse doit être le début d'un bloc du pool
+    valide = (bloc != NULL && (uint8 *)bloc >= pool->memoire
+              && decalage < (uint32)pool->nb_blocs * pool->taille_bloc && (decalage % pool->taille_bloc) == 0);
+
+    etat = Masquer_Interruptions();
+
+    // ... et ce bloc doit être alloué : une double libération rechaînerait le bloc deux fois
+    // dans la liste des libres, et deux Pool_Allouer rendraient ensuite la même adresse
+    if (valide && (pool->occupes[index / 32] & (1UL << (index % 32))) != 0)
+    {
+        pool->occupes[index / 32] &= ~(1UL << (index % 32));
+        ((Pool_Bloc *)bloc)->suivant = pool->libres;
+        pool->libres = (Pool_Bloc *)bloc;
+        pool->nb_utilises--;
+    }
+    else
+    {
+        valide = false;
+        pool->nb_erreurs++;
+    }
+
+    Restaurer_Interruptions(etat);
+    return valide;
+}
+
+/*===============================================================================
+  FONCTION      : Pool_Disponibles
+  DESCRIPTION   : Nombre de blocs libres d'un pool
+  PARAMETRES    : Pool
+  RETOUR        : Nombre de blocs libres
+===============================================================================*/
+uint16 Pool_Disponibles(Pool_Memoire *pool)
+{
+    return pool->nb_blocs - pool->nb_utilises;
+}
+
+/*===============================================================================
+  FONCTION      : Pool_Rapport
+  DESCRIPTION   : Envoie l'occupation d'un pool sur une UART
+  PARAMETRES    : N° de l'UART (0 ou 1), nom affiché, pool
+  RETOUR        : rien
+===============================================================================*/
+void Pool_Rapport(uint8 UART, const char *nom, Pool_Memoire *pool)
+{
+    UART_WriteString(UART,"pool ");
+    UART_WriteString(UART,nom);
+    UART_WriteString(UART," : blocs=");
+    UART_WriteNombre(UART,pool->nb_blocs);
+    UART_WriteString(UART,"x");
+    UART_WriteNombre(UART,pool->taille_bloc);
+    UART_WriteString(UART," utilises=");
+    UART_WriteNombre(UART,pool->nb_utilises);
+    UART_WriteString(UART," max=");
+    UART_WriteNombre(UART,pool->max_utilises);
+    UART_WriteString(UART," echecs=");
+    UART_WriteNombre(UART,pool->nb_echecs);
+    UART_WriteString(UART," erreurs=");
+    UART_WriteNombre(UART,pool->nb_erreurs);
+    UART_WriteString(UART,"\n");
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS ARENE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Arene
+  DESCRIPTION   : Vide une arène et remet ses compteurs à zéro
+  PARAMETRES    : Arène (déclarée avec ARENE_DECLARER)
+  RETOUR        : rien
+===============================================================================*/
+void init_Arene(Arene_Memoire *arene)
+{
+    arene->position = 0;
+    arene->max_position = 0;
+    arene->nb_echecs = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Arene_Allouer
+  DESCRIPTION   : Réserve une zone dans l'arène (O(1), utilisable sous interruption)
+  PARAMETRES    : Arène, taille (octets)
+  RETOUR        : Adresse de la zone (alignée), NULL si l'arène est pleine
+===============================================================================*/
+void ICACHE_RAM_ATTR *Arene_Allouer(Arene_Memoire *arene, uint32 taille)
+{
+    void *zone = NULL;
+
+    uint32 etat;
+
+    taille = POOL_TAILLE_BLOC(taille);
+
+    etat = Masquer_Interruptions();
+
+    if (taille <= arene->taille - arene->position)
+    {
+        zone = arene->memoire + arene->position;
+        arene->position += taille;
+        if (arene->position > arene->max_position) arene->max_position = arene->position;
+    }
+    else
+    {
+        arene->nb_echecs++;
+    }
+
+    Restaurer_Interruptions(etat);
+    return zone;
+}
+
+/*===============================================================================
+  FONCTION      : Arene_Marque
+  DESCRIPTION   : Mémorise le niveau actuel de l'arène
+  PARAMETRES    : Arène
+  RETOUR        : Marque (à passer à Arene_Restaurer)
+===============================================================================*/
+uint32 Arene_Marque(Arene_Memoire *arene)
+{
+    return arene->position;
+}
+
+/*===============================================================================
+  FONCTION      : Arene_Restaurer
+  DESCRIPTION   : Libère toutes les zones allouées depuis une marque
+  PARAMETRES    : Arène, marque (retournée par Arene_Marque)
+  RETOUR        : rien
+===============================================================================*/
+void Arene_Restaurer(Arene_Memoire *arene, uint32 marque)
+{
+    uint32 etat = Masquer_Interruptions();
+    if (marque < arene->position) arene->position = marque;
+    Restaurer_Interruptions(etat);
+}
+
+/*===============================================================================
+  FONCTION      : Arene_Vider
+  DESCRIPTION   : Libère toutes les zones de l'arène (les compteurs sont conservés)
+  PARAMETRES    : Arène
+  RETOUR        : rien
+===============================================================================*/
+void Arene_Vider(Arene_Memoire *arene)
+{
+    Arene_Restaurer(arene,0);
+}
+
+/*===============================================================================
+  FONCTION      : Arene_Rapport
+  DESCRIPTION   : Envoie l'occupation d'une arène sur une UART
+  PARAMETRES    : N° de l'UART (0 ou 1), nom affiché, arène
+  RETOUR        : rien
+===============================================================================*/
+void Arene_Rapport(uint8 UART, const char *nom, Arene_Memoire *arene)
+{
+    UART_WriteString(UART,"arene ");
+    UART_WriteString(UART,nom);
+    UART_WriteString(UART," : taille=");
+    UART_WriteNombre(UART,arene->taille);
+    UART_WriteString(UART," utilise=");
+    UART_WriteNombre(UART,arene->position);
+    UART_WriteString(UART," max=");
+    UART_WriteNombre(UART,arene->max_position);
+    UART_WriteString(UART," echecs=");
+    UART_WriteNombre(UART,arene->nb_echecs);
+    UART_WriteString(UART,"\n");
+}
@@ -0,0 +1,180 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Pool_Memoire.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Allocation mémoire déterministe sans utiliser le tas (malloc / new)
+ *  Sur les 80 Ko de tas de l'ESP8266, des allocations de tailles variables fragmentent la mémoire
+ *  au fil des jours de fonctionnement. Ce module propose deux allocateurs à mémoire statique :
+ *
+ *  - Pool : blocs de taille fixe, allocation et libération en O(1) (liste chaînée des blocs libres,
+ *    le lien est stocké dans le bloc libre lui-même), utilisables sous interruption.
+ *    Idéal pour les trames UART ou les messages capteurs d'une taille maximale connue.
+ *  - Arène : allocation séquentielle de tailles quelconques, libérée en une seule fois
+ *    (ou jusqu'à une marque). Idéale pour les données temporaires d'un traitement.
+ *
+ *  La taille des pools et des arènes est fixée à la compilation :
+ *      POOL_DECLARER(Pool_Trames,64,16);      // 16 blocs de 64 octets
+ *      ARENE_DECLARER(Arene_Calcul,1024);     // 1 Ko
+ *  puis init_Pool(&Pool_Trames) / init_Arene(&Arene_Calcul) au démarrage.
+ *
+ *  Les compteurs "max" (niveau le plus haut atteint) permettent d'ajuster les tailles au plus juste.
+ * =============================================================================================================================================
+ */
+
+#ifndef __POOL_MEMOIRE_H__
+#define __POOL_MEMOIRE_H__
+
+// Dépendance(s)
+#include "registres_esp8266.h"
+#include "UART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Alignement des blocs (taille d'un pointeur : permet de stocker le chaînage dans un bloc libre)
+#define POOL_ALIGNEMENT sizeof(void *)
+
+// Taille réelle d'un bloc (arrondie à l'alignement)
+#define POOL_TAILLE_BLOC(taille) ((((taille) + POOL_ALIGNEMENT - 1) / POOL_ALIGNEMENT) * POOL_ALIGNEMENT)
+
+// Bloc libre (chaînage)
+typedef struct Pool_Bloc {
+  struct Pool_Bloc *suivant;
+} Pool_Bloc;
+
+// Pool de blocs de taille fixe
+typedef struct{
+  uint8 *memoire;            // zone statique des blocs
+  uint16 taille_bloc;        // octets (multiple de POOL_ALIGNEMENT)
+  uint16 nb_blocs;
+  Pool_Bloc *libres;         // liste des blocs libres
+  uint32 *occupes;           // bit n à '1' : bloc n alloué (détection des doubles libérations)
+  uint16 nb_utilises;
+  uint16 max_utilises;       // niveau le plus haut atteint
+  uint32 nb_echecs;          // allocations refusées (pool vide)
+  uint32 nb_erreurs;         // libérations refusées (adresse étrangère ou bloc déjà libre)
+} Pool_Memoire;
+
+// Arène (allocation séquentielle)
+typedef struct{
+  uint8 *memoire;
+  uint32 taille;             // octets
+  uint32 position;           // octets utilisés
+  uint32 max_position;       // niveau le plus haut atteint
+  uint32 nb_echecs;          // allocations refusées (arène pleine)
+} Arene_Memoire;
+
+// Déclaration d'un pool de "nb" blocs de "taille" octets (mémoire statique)
+#define POOL_DECLARER(nom,taille,nb) \
+    static void *nom##_memoire[(POOL_TAILLE_BLOC(taille) / POOL_ALIGNEMENT) * (nb)]; \
+    static uint32 nom##_occupes[((nb) + 31) / 32]; \
+    Pool_Memoire nom = {(uint8 *)nom##_memoire, POOL_TAILLE_BLOC(taille), (nb), NULL, nom##_occupes, 0, 0, 0, 0}
+
+// Déclaration d'une arène de "taille" octets (mémoire statique)
+#define ARENE_DECLARER(nom,taille) \
+    static void *nom##_memoire[POOL_TAILLE_BLOC(taille) / POOL_ALIGNEMENT]; \
+    Arene_Memoire nom = {(uint8 *)nom##_memoire, POOL_TAILLE_BLOC(taille), 0, 0, 0}
+
+// ##########################################################################################################################
+//                                      FONCTIONS POOL
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Pool
+  DESCRIPTION   : Rend tous les blocs d'un pool libres et remet ses compteurs à zéro
+  PARAMETRES    : Pool (déclaré avec POOL_DECLARER)
+  RETOUR        : rien
+===============================================================================*/
+void init_Pool(Pool_Memoire *pool);
+
+/*===============================================================================
+  FONCTION      : Pool_Allouer
+  DESCRIPTION   : Réserve un bloc du pool (O(1), utilisable sous interruption)
+  PARAMETRES    : Pool
+  RETOUR        : Adresse du bloc, NULL si le pool est vide
+===============================================================================*/
+void ICACHE_RAM_ATTR *Pool_Allouer(Pool_Memoire *pool);
+
+/*===============================================================================
+  FONCTION      : Pool_Liberer
+  DESCRIPTION   : Rend un bloc au pool (O(1), utilisable sous interruption)
+  Une adresse étrangère au pool ou un bloc déjà libre est refusé (compteur nb_erreurs).
+  PARAMETRES    : Pool, adresse du bloc (retournée par Pool_Allouer)
+  RETOUR        : false si l'adresse n'est pas un bloc alloué de ce pool
+===============================================================================*/
+bool ICACHE_RAM_ATTR Pool_Liberer(Pool_Memoire *pool, void *bloc);
+
+/*===============================================================================
+  FONCTION      : Pool_Disponibles
+  DESCRIPTION   : Nombre de blocs libres d'un pool
+  PARAMETRES    : Pool
+  RETOUR        : Nombre de blocs libres
+===============================================================================*/
+uint16 Pool_Disponibles(Pool_Memoire *pool);
+
+/*===============================================================================
+  FONCTION      : Pool_Rapport
+  DESCRIPTION   : Envoie l'occupation d'un pool sur une UART
+  PARAMETRES    : N° de l'UART (0 ou 1), nom affiché, pool
+  RETOUR        : rien
+===============================================================================*/
+void Pool_Rapport(uint8 UART, const char *nom, Pool_Memoire *pool);
+
+// ##########################################################################################################################
+//                                      FONCTIONS ARENE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Arene
+  DESCRIPTION   : Vide une arène et remet ses compteurs à zéro
+  PARAMETRES    : Arène (déclarée avec ARENE_DECLARER)
+  RETOUR        : rien
+===============================================================================*/
+void init_Arene(Arene_Memoire *arene);
+
+/*===============================================================================
+  FONCTION      : Arene_Allouer
+  DESCRIPTION   : Réserve une zone dans l'arène (O(1), utilisable sous interruption)
+  PARAMETRES    : Arène, taille (octets)
+  RETOUR        : Adresse de la zone (alignée), NULL si l'arène est pleine
+===============================================================================*/
+void ICACHE_RAM_ATTR *Arene_Allouer(Arene_Memoire *arene, uint32 taille);
+
+/*===============================================================================
+  FONCTION      : Arene_Marque
+  DESCRIPTION   : Mémorise le niveau actuel de l'arène
+  PARAMETRES    : Arène
+  RETOUR        : Marque (à passer à Arene_Restaurer)
+===============================================================================*/
+uint32 Arene_Marque(Arene_Memoire *arene);
+
+/*===============================================================================
+  FONCTION      : Arene_Restaurer
+  DESCRIPTION   : Libère toutes les zones allouées depuis une marque
+  PARAMETRES    : Arène, marque (retournée par Arene_Marque)
+  RETOUR        : rien
+===============================================================================*/
+void Arene_Restaurer(Arene_Memoire *arene, uint32 marque);
+
+/*===============================================================================
+  FONCTION      : Arene_Vider
+  DESCRIPTION   : Libère toutes les zones de l'arène (les compteurs sont conservés)
+  PARAMETRES    : Arène
+  RETOUR        : rien
+===============================================================================*/
+void Arene_Vider(Arene_Memoire *arene);
+
+/*===============================================================================
+  FONCTION      : Arene_Rapport
+  DESCRIPTION   : Envoie l'occupation d'une arène sur une UART
+  PARAMETRES    : N° de l'UART (0 ou 1), nom affiché, arène
+  RETOUR        : rien
+===============================================================================*/
+void Arene_Rapport(uint8 UART, const char *nom, Arene_Memoire *arene);
+
+#endif
@@ -1,26 +1,26 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : Power_esp8266.h
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Ensemble des définitions nécessaires pour manipuler les modes de mise en veille de l'ESP8266
- * 
- *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
- * =============================================================================================================================================
- */
-#include "Power_esp8266.h"
-
-
-// ##########################################################################################################################
-//                                      FONCTIONS MISE EN VEILLE
-// ##########################################################################################################################
-
-/*===============================================================================
-  FONCTION      : enable_TIMER1
-  DESCRIPTION   : active le TIMER1
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : Power_esp8266.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Ensemble des définitions nécessaires pour manipuler les modes de mise en veille de l'ESP8266
+ * 
+ *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
+ * =============================================================================================================================================
+ */
+#include "Power_esp8266.h"
+
+
+// ##########################################################################################################################
+//                                      FONCTIONS MISE EN VEILLE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : enable_TIMER1
+  DESCRIPTION   : active le TIMER1
+  PARAMETRES    : aucun
+  RETOUR        : rien   
+===============================================================================*/
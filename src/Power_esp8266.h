@@ -1,38 +1,38 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : Power_esp8266.h
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Ensemble des définitions nécessaires pour manipuler les modes de mise en veille de l'ESP8266
- * 
- *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
- * =============================================================================================================================================
- */
-#ifndef __POWER_ESP8266_H__
-#define __POWER_ESP8266_H__
-
-#include "registres_esp8266.h"
-
-
-// ----------------------------------------------------------------------------------------------
-// Définition de constantes utiles
-// ----------------------------------------------------------------------------------------------
-
-
-// ##########################################################################################################################
-//                                      FONCTIONS MISE EN VEILLE
-// ##########################################################################################################################
-
-/*===============================================================================
-  FONCTION      : 
-  DESCRIPTION   : 
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
-
-
-
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : Power_esp8266.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Ensemble des définitions nécessaires pour manipuler les modes de mise en veille de l'ESP8266
+ * 
+ *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
+ * =============================================================================================================================================
+ */
+#ifndef __POWER_ESP8266_H__
+#define __POWER_ESP8266_H__
+
+#include "registres_esp8266.h"
+
+
+// ----------------------------------------------------------------------------------------------
+// Définition de constantes utiles
+// ----------------------------------------------------------------------------------------------
+
+
+// ##########################################################################################################################
+//                                      FONCTIONS MISE EN VEILLE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : 
+  DESCRIPTION   : 
+  PARAMETRES    : aucun
+  RETOUR        : rien   
+===============================================================================*/
+
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,423 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : RS485.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Maître d'un bus RS-485 half-duplex multipoint sur l'UART0, avec gestion automatique de la direction du transceiver
+ *  (voir RS485.h)
+ * =============================================================================================================================================
+ */
+
+#include "RS485.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Etats d'un échange
+typedef enum {RS485_LIBRE,RS485_EMISSION,RS485_ATTENTE,RS485_RECEPTION,RS485_TERMINE} RS485_Etat;
+
+// Interruptions de réception utilisées
+#define RS485_INTERRUPTIONS_RX ((1 << BIT_UART_INT_RXFIFO_FULL) | (1 << BIT_UART_INT_RXFIFO_TOUT) | (1 << BIT_UART_INT_RXFIFO_OVF) \
+                              | (1 << BIT_UART_INT_FRM_ERR) | (1 << BIT_UART_INT_PARITY_ERR))
+#define RS485_INTERRUPTIONS_ERREUR ((1 << BIT_UART_INT_RXFIFO_OVF) | (1 << BIT_UART_INT_FRM_ERR) | (1 << BIT_UART_INT_PARITY_ERR))
+
+// Esclaves
+typedef struct{
+  uint8 adresse;
+  uint32 timeout;      // cycles CPU
+} RS485_Esclave;
+
+RS485_Esclave Esclaves_RS485[RS485_NB_ESCLAVES];
+RS485_Statistiques Statistiques_RS485[RS485_NB_ESCLAVES];
+RS485_Statistiques_Maitre Statistiques_RS485_Maitre;
+uint8 rs485_nb_esclaves = 0;
+
+// Table d'interrogation
+uint8 Table_RS485[RS485_TAILLE_TABLE];
+uint8 rs485_taille_table = 0;
+uint8 rs485_index_table = 0;
+bool rs485_table_defaut = true;   // tourniquet sur les esclaves déclarés
+
+// Application
+RS485_Requete Fonction_Requete_RS485 = NULL;
+RS485_Reponse Fonction_Reponse_RS485 = NULL;
+
+// Ligne
+uint8 rs485_gpio_direction = 0;
+uint32 rs485_cycles_bit = 0;
+uint32 rs485_cycles_octet = 0;
+int8 client_RS485 = -1;
+
+// Echange en cours
+uint8 Trame_RS485_TX[RS485_TAILLE_TRAME];
+uint8 Trame_RS485_RX[RS485_TAILLE_TRAME];
+volatile uint8 rs485_longueur_rx = 0;
+volatile uint8 rs485_etat = RS485_LIBRE;
+volatile uint8 rs485_statut = RS485_OK;
+uint8 rs485_esclave = 0;
+volatile uint32 rs485_fin_emission = 0;    // fin de la requête (calculée, puis relâchement de DE)
+volatile uint32 rs485_premier_octet = 0;   // réception du premier octet de la réponse
+volatile uint32 rs485_fin_echange = 0;     // fin de la réponse ou du timeout
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : RS485_Seuil_RX
+  DESCRIPTION   : Modifie le seuil de l'interruption "fifo RX pleine"
+  PARAMETRES    : Seuil (octets)
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR RS485_Seuil_RX(uint8 seuil)
+{
+    REGISTRE_CONFIG_ECRIRE(Registre_UART0->CONF1,(REGISTRE_CONFIG_LIRE(Registre_UART0->CONF1) & ~(0x7F << BIT_UART_RXFIFO_FULL_THRHD))
+                                                 | ((uint32)seuil << BIT_UART_RXFIFO_FULL_THRHD));
+}
+
+/*===============================================================================
+  FONCTION      : RS485_Lire_Fifo
+  DESCRIPTION   : Vide la fifo RX dans la trame reçue
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR RS485_Lire_Fifo()
+{
+    uint8 nb_fifo = (REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_RXFIFO_CNT) & 0xFF;
+
+    while (nb_fifo--)
+    {
+        uint8 octet = REGISTRE_LIRE(Registre_UART0->FIFO) & 0xFF;
+        if (rs485_longueur_rx < RS485_TAILLE_TRAME)
+        {
+            Trame_RS485_RX[rs485_longueur_rx++] = octet;
+        }
+        else
+        {
+            rs485_statut = RS485_ERREUR;
+        }
+    }
+}
+
+/*===============================================================================
+  FONCTION      : RS485_Emettre
+  DESCRIPTION   : Envoie la requête préparée dans Trame_RS485_TX
+  PARAMETRES    : N° de l'esclave, longueur de la requête
+  RETOUR        : rien
+===============================================================================*/
+static void RS485_Emettre(uint8 esclave, uint8 longueur)
+{
+    uint32 debut;
+
+    rs485_esclave = esclave;
+    rs485_longueur_rx = 0;
+    rs485_statut = RS485_OK;
+    Statistiques_RS485[esclave].nb_requetes++;
+
+    // Etape 1 : prise de la ligne
+    GPIO_Write(rs485_gpio_direction,ETAT_HAUT);
+
+    // Etape 2 : requête complète dans la fifo TX, fin de l'émission calculée
+    ETS_INTR_LOCK();
+    debut = Lire_Compteur_Cycles();
+    for (uint8 i = 0; i < longueur; i++)
+    {
+        REGISTRE_ECRIRE(Registre_UART0->FIFO,Trame_RS485_TX[i]);
+    }
+    rs485_fin_emission = debut + longueur * rs485_cycles_octet;
+    rs485_etat = RS485_EMISSION;
+
+    // relâchement de DE une demi-durée de bit après le bit de stop du dernier octet
+    TIMER1_Mux_Programmer(client_RS485,rs485_fin_emission + rs485_cycles_bit / 2);
+    ETS_INTR_UNLOCK();
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS RS485
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_RS485
+  DESCRIPTION   : initialise le bus : UART0 en 8N1, GPIO de direction à l'état bas (réception)
+  PARAMETRES    : Vitesse (bauds), GPIO de direction (DE / RE),
+                  fonction de construction des requêtes, fonction de traitement des réponses
+  RETOUR        : false si le TIMER1 n'a plus de client libre
+===============================================================================*/
+bool init_RS485(uint32 Bauds, uint8 gpio_direction, RS485_Requete requete, RS485_Reponse reponse)
+{
+    if (client_RS485 < 0) client_RS485 = TIMER1_Mux_Ajouter_Client(Interruption_RS485_Timer,NULL);
+    if (client_RS485 < 0) return false;
+
+    Fonction_Requete_RS485 = requete;
+    Fonction_Reponse_RS485 = reponse;
+    rs485_nb_esclaves = 0;
+    rs485_taille_table = 0;
+    rs485_index_table = 0;
+    rs485_table_defaut = true;
+    rs485_etat = RS485_LIBRE;
+    Statistiques_RS485_Maitre.retard_direction_max = 0;
+    Statistiques_RS485_Maitre.nb_echanges = 0;
+
+    // Etape 1 : direction en réception
+    rs485_gpio_direction = gpio_direction;
+    init_GPIO(gpio_direction,GPIO_OUTPUT);
+
+    // Etape 2 : UART0 en 8N1, fifos vidées
+    rs485_cycles_bit = ESP8266_CLOCK_FREQ / Bauds;
+    rs485_cycles_octet = RS485_BITS_OCTET * rs485_cycles_bit;
+    init_UART(RS485_UART,Bauds,DATA_8,NONE,STOP_1);
+    REGISTRE_CONFIG_OU(Registre_UART0->CONF0,(1 << BIT_UART_RXFIFO_RST) | (1 << BIT_UART_TXFIFO_RST));
+    REGISTRE_CONFIG_ET(Registre_UART0->CONF0,~((1 << BIT_UART_RXFIFO_RST) | (1 << BIT_UART_TXFIFO_RST)));
+
+    // Etape 3 : fin de réponse sur timeout de réception
+    Set_buffer_to_Registre(&Registre_UART0->CONF1,BIT_UART_RX_TOUT_THRHD,RS485_TIMEOUT_RX,7);
+    REGISTRE_CONFIG_SET_BIT(Registre_UART0->CONF1,BIT_UART_RX_TOUT_EN);
+    RS485_Seuil_RX(1);
+
+    // Etape 4 : interruptions (la réception n'est activée que pendant l'attente d'une réponse)
+    UART_Desactiver_Interruption(RS485_UART,0x1FF);
+    UART_Attacher_Interruption(RS485_UART,Interruption_RS485_UART);
+
+    rs485_fin_echange = Lire_Compteur_Cycles();
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : RS485_Ajouter_Esclave
+  DESCRIPTION   : Déclare un esclave (ajouté à la fin de la table d'interrogation par défaut)
+  PARAMETRES    : Adresse de l'esclave, timeout de réponse (us)
+  RETOUR        : N° de l'esclave, -1 si tous les esclaves sont déclarés
+===============================================================================*/
+int8 RS485_Ajouter_Esclave(uint8 adresse, uint32 timeout_us)
+{
+    if (rs485_nb_esclaves >= RS485_NB_ESCLAVES) return -1;
+
+    uint8 esclave = rs485_nb_esclaves;
+    uint32 timeout_max = 0xFFFFFFFF / (ESP8266_CLOCK_FREQ / 1000000) / 2;
+
+    Esclaves_RS485[esclave].adresse = adresse;
+    Esclaves_RS485[esclave].timeout = ((timeout_us < timeout_max) ? timeout_us : timeout_max) * (ESP8266_CLOCK_FREQ / 1000000);
+
+    RS485_Statistiques *statistiques = &Statistiques_RS485[esclave];
+    statistiques->nb_requetes = 0;
+    statistiques->nb_reponses = 0;
+    statistiques->nb_timeouts = 0;
+    statistiques->nb_erreurs = 0;
+    statistiques->latence_derniere = 0;
+    statistiques->latence_max = 0;
+
+    if (rs485_table_defaut) Table_RS485[rs485_taille_table++] = esclave;
+    rs485_nb_esclaves++;
+    return esclave;
+}
+
+/*===============================================================================
+  FONCTION      : RS485_Set_Table
+  DESCRIPTION   : Définit l'ordre d'interrogation des esclaves
+                  (un esclave prioritaire peut apparaître plusieurs fois)
+  PARAMETRES    : Table des N° d'esclaves, taille de la table
+  RETOUR        : false si la table est trop grande ou contient un esclave inconnu
+===============================================================================*/
+bool RS485_Set_Table(const uint8 *table, uint8 taille)
+{
+    if (taille > RS485_TAILLE_TABLE) return false;
+    for (uint8 i = 0; i < taille; i++)
+    {
+        if (table[i] >= rs485_nb_esclaves) return false;
+    }
+
+    for (uint8 i = 0; i < taille; i++)
+    {
+        Table_RS485[i] = table[i];
+    }
+    rs485_taille_table = taille;
+    rs485_index_table = 0;
+    rs485_table_defaut = false;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : RS485_Tache
+  DESCRIPTION   : Traite la réponse reçue et envoie la requête suivante
+                  (à appeler dans la boucle principale)
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void RS485_Tache()
+{
+    uint8 etat = rs485_etat;
+    uint8 longueur = 0;
+    uint8 esclave = 0;
+
+    // -------------------------
+    // Echange terminé : statistiques et réponse transmise à l'application
+    // -------------------------
+    if (etat == RS485_TERMINE)
+    {
+        RS485_Statistiques *statistiques = &Statistiques_RS485[rs485_esclave];
+
+        // retournement : début du premier octet (interruption à la fin de son bit de stop)
+        if (rs485_longueur_rx > 0)
+        {
+            int32 retournement = (int32)(rs485_premier_octet - rs485_fin_emission - rs485_cycles_octet);
+            statistiques->latence_derniere = (retournement > 0) ? retournement / (ESP8266_CLOCK_FREQ / 1000000) : 0;
+            if (statistiques->latence_derniere > statistiques->latence_max) statistiques->latence_max = statistiques->latence_derniere;
+        }
+
+        switch (rs485_statut)
+        {
+            case RS485_OK      : statistiques->nb_reponses++; break;
+            case RS485_TIMEOUT : statistiques->nb_timeouts++; break;
+            default            : statistiques->nb_erreurs++;  break;
+        }
+        Statistiques_RS485_Maitre.nb_echanges++;
+
+        if (Fonction_Reponse_RS485 != NULL)
+        {
+            Fonction_Reponse_RS485(rs485_esclave,Trame_RS485_RX,rs485_longueur_rx,rs485_statut);
+        }
+        rs485_etat = etat = RS485_LIBRE;
+    }
+
+    // -------------------------
+    // Requête suivante, après le silence entre deux échanges
+    // -------------------------
+    if (etat != RS485_LIBRE || rs485_taille_table == 0 || Fonction_Requete_RS485 == NULL) return;
+    if ((uint32)(Lire_Compteur_Cycles() - rs485_fin_echange) < RS485_SILENCE_OCTETS * rs485_cycles_octet) return;
+
+    // au plus un tour de table pour trouver un esclave à interroger
+    for (uint8 essai = 0; essai < rs485_taille_table && longueur == 0; essai++)
+    {
+        esclave = Table_RS485[rs485_index_table];
+        rs485_index_table++;
+        if (rs485_index_table >= rs485_taille_table) rs485_index_table = 0;
+
+        longueur = Fonction_Requete_RS485(esclave,Esclaves_RS485[esclave].adresse,Trame_RS485_TX);
+    }
+    if (longueur == 0) return;
+    if (longueur > RS485_TAILLE_TRAME) longueur = RS485_TAILLE_TRAME;
+
+    RS485_Emettre(esclave,longueur);
+}
+
+/*===============================================================================
+  FONCTION      : RS485_Lire_Statistiques
+  DESCRIPTION   : Statistiques d'un esclave
+  PARAMETRES    : N° de l'esclave
+  RETOUR        : Statistiques, NULL si l'esclave n'existe pas
+===============================================================================*/
+const RS485_Statistiques *RS485_Lire_Statistiques(uint8 esclave)
+{
+    return (esclave < rs485_nb_esclaves) ? &Statistiques_RS485[esclave] : NULL;
+}
+
+/*===============================================================================
+  FONCTION      : RS485_Lire_Statistiques_Maitre
+  DESCRIPTION   : Statistiques du maître
+  PARAMETRES    : aucun
+  RETOUR        : Statistiques
+===============================================================================*/
+const RS485_Statistiques_Maitre *RS485_Lire_Statistiques_Maitre()
+{
+    return &Statistiques_RS485_Maitre;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_RS485_UART
+  DESCRIPTION   : Interruption UART0 : réception de la réponse
+                  (premier octet : datation et annulation du timeout,
+                  timeout de réception : fin de la réponse)
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_RS485_UART(uint8 UART, uint32 statut)
+{
+    uint32 maintenant = Lire_Compteur_Cycles();
+
+    if (rs485_etat != RS485_ATTENTE && rs485_etat != RS485_RECEPTION) return;
+
+    if (statut & RS485_INTERRUPTIONS_ERREUR) rs485_statut = RS485_ERREUR;
+
+    // Premier octet : l'octet reste dans la fifo (le timeout de réception ne se déclenche que sur une fifo non vide)
+    if (rs485_etat == RS485_ATTENTE)
+    {
+        rs485_premier_octet = maintenant;
+        rs485_etat = RS485_RECEPTION;
+        TIMER1_Mux_Annuler(client_RS485);
+        RS485_Seuil_RX(RS485_SEUIL_RX);
+        if (!READ_BIT(statut,BIT_UART_INT_RXFIFO_TOUT)) return;
+    }
+
+    if (statut & ((1 << BIT_UART_INT_RXFIFO_FULL) | (1 << BIT_UART_INT_RXFIFO_TOUT) | (1 << BIT_UART_INT_RXFIFO_OVF)))
+    {
+        RS485_Lire_Fifo();
+    }
+
+    // Fin de la réponse
+    if (READ_BIT(statut,BIT_UART_INT_RXFIFO_TOUT))
+    {
+        UART_Desactiver_Interruption(RS485_UART,RS485_INTERRUPTIONS_RX);
+        rs485_fin_echange = maintenant;
+        rs485_etat = RS485_TERMINE;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_RS485_Timer
+  DESCRIPTION   : Client du multiplexeur TIMER1 : fin de la requête (relâchement
+                  de DE) puis timeout de la réponse
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_RS485_Timer(void *argument)
+{
+    uint32 maintenant = Lire_Compteur_Cycles();
+
+    // -------------------------
+    // Fin de la requête : relâchement de DE
+    // -------------------------
+    if (rs485_etat == RS485_EMISSION)
+    {
+        uint8 nb_fifo = (REGISTRE_LIRE(Registre_UART0->STATUS) >> BIT_UART_TXFIFO_CNT) & 0xFF;
+        int32 retard;
+
+        // émission en retard sur le calcul : on attend les octets restants (et celui du registre à décalage)
+        if (nb_fifo != 0)
+        {
+            TIMER1_Mux_Programmer(client_RS485,maintenant + (nb_fifo + 1) * rs485_cycles_octet);
+            return;
+        }
+
+        // écriture directe (GPIO_Write est en flash, non utilisable sous interruption)
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,(1 << rs485_gpio_direction));
+
+        retard = (int32)(maintenant - rs485_fin_emission);
+        if (retard > 0 && (uint32)retard > Statistiques_RS485_Maitre.retard_direction_max) Statistiques_RS485_Maitre.retard_direction_max = retard;
+        rs485_fin_emission = maintenant;
+
+        // écho éventuel de la requête (RE non relié à DE) supprimé, premier octet de la réponse daté
+        REGISTRE_CONFIG_OU(Registre_UART0->CONF0,(1 << BIT_UART_RXFIFO_RST));
+        REGISTRE_CONFIG_ET(Registre_UART0->CONF0,~(1 << BIT_UART_RXFIFO_RST));
+        RS485_Seuil_RX(1);
+
+        rs485_etat = RS485_ATTENTE;
+        UART_Activer_Interruption(RS485_UART,RS485_INTERRUPTIONS_RX);
+        TIMER1_Mux_Programmer(client_RS485,maintenant + Esclaves_RS485[rs485_esclave].timeout);
+        return;
+    }
+
+    // -------------------------
+    // Aucune réponse de l'esclave
+    // -------------------------
+    if (rs485_etat == RS485_ATTENTE)
+    {
+        UART_Desactiver_Interruption(RS485_UART,RS485_INTERRUPTIONS_RX);
+        rs485_statut = RS485_TIMEOUT;
+        rs485_fin_echange = maintenant;
+        rs485_etat = RS485_TERMINE;
+    }
+}
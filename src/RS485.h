@@ -0,0 +1,171 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : RS485.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Maître d'un bus RS-485 half-duplex multipoint (jusqu'à 32 esclaves) sur l'UART0, avec gestion automatique
+ *  de la direction du transceiver (DE / RE)
+ *
+ *  - Une requête (au plus UART_TAILLE_FIFO octets) est écrite d'un bloc dans la fifo TX après passage de DE à l'état haut.
+ *    La fin de l'émission est calculée (nombre d'octets x durée d'un octet) et un client du multiplexeur TIMER1
+ *    relâche DE dès que le bit de stop du dernier octet est sorti du registre à décalage (pas de trame tronquée,
+ *    pas de temps mort : la ligne est rendue aux esclaves une demi-durée de bit après la fin de la trame).
+ *  - La fifo RX est vidée au relâchement de DE (écho éventuel de la requête), puis la réponse est reçue sous
+ *    interruption. Le premier octet reçu date le retournement de l'esclave ; la fin de la réponse est détectée
+ *    par le timeout de réception de l'UART (RS485_TIMEOUT_RX octets de silence).
+ *  - Chaque esclave a son timeout de réponse (client TIMER1).
+ *  - L'ordre d'interrogation est donné par une table (par défaut : tourniquet sur les esclaves déclarés) ;
+ *    un esclave prioritaire peut y apparaître plusieurs fois.
+ *  - Les requêtes sont construites et les réponses traitées dans RS485_Tache (boucle principale), par deux fonctions
+ *    de l'application.
+ *
+ *  Trames en 8N1 ; l'application ajoute et vérifie elle-même l'adresse et le CRC de son protocole (Modbus RTU...)
+ *
+ *  Exemple :
+ *      uint8 Requete(uint8 esclave, uint8 adresse, uint8 *trame) { trame[0] = adresse; ... return longueur; }
+ *      void Reponse(uint8 esclave, const uint8 *trame, uint8 longueur, uint8 statut) { ... }
+ *      setup : init_RS485(115200,GPIO5,Requete,Reponse); RS485_Ajouter_Esclave(1,5000); RS485_Ajouter_Esclave(2,5000);
+ *      loop  : RS485_Tache();
+ *
+ *  /!\ Le bus prend l'interruption de l'UART0 (incompatible avec la console) et un client du multiplexeur TIMER1
+ * =============================================================================================================================================
+ */
+
+#ifndef __RS485_H__
+#define __RS485_H__
+
+// Dépendance(s)
+#include "registres_esp8266.h"
+#include "GPIO_esp8266.h"
+#include "UART_esp8266.h"
+#include "Multiplexeur_TIMER1.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// UART utilisée
+#define RS485_UART UART0
+
+// Nombre maximal d'esclaves, taille maximale de la table d'interrogation
+#define RS485_NB_ESCLAVES 32
+#define RS485_TAILLE_TABLE 64
+
+// Taille maximale d'une trame (requête : une fifo TX complète)
+#define RS485_TAILLE_TRAME UART_TAILLE_FIFO
+
+// Bits par octet (8N1 : start + 8 données + stop)
+#define RS485_BITS_OCTET 10
+
+// Fin de réponse : silence de RS485_TIMEOUT_RX octets (timeout de réception de l'UART)
+#define RS485_TIMEOUT_RX 3
+
+// Silence minimal entre la fin d'un échange et la requête suivante (octets)
+#define RS485_SILENCE_OCTETS 4
+
+// Seuil de la fifo RX une fois le premier octet reçu
+#define RS485_SEUIL_RX 64
+
+// Statut d'un échange
+typedef enum {RS485_OK,RS485_TIMEOUT,RS485_ERREUR} RS485_Statut;
+
+// Fonction construisant la requête d'un esclave (N° de l'esclave, adresse, trame à remplir)
+// retourne la longueur de la requête (0 : pas de requête pour cet esclave à ce tour)
+typedef uint8 (*RS485_Requete)(uint8 esclave, uint8 adresse, uint8 *trame);
+
+// Fonction recevant la réponse d'un esclave (N° de l'esclave, trame, longueur, RS485_Statut)
+typedef void (*RS485_Reponse)(uint8 esclave, const uint8 *trame, uint8 longueur, uint8 statut);
+
+// Statistiques d'un esclave
+typedef struct{
+  uint32 nb_requetes;
+  uint32 nb_reponses;
+  uint32 nb_timeouts;
+  uint32 nb_erreurs;            // trame trop longue, erreur de trame ou de parité
+  uint32 latence_derniere;      // retournement de l'esclave : fin de la requête -> début de la réponse (us)
+  uint32 latence_max;
+} RS485_Statistiques;
+
+// Statistiques du maître
+typedef struct{
+  uint32 retard_direction_max;  // relâchement de DE après la fin calculée de la requête (cycles CPU)
+  uint32 nb_echanges;
+} RS485_Statistiques_Maitre;
+
+// ##########################################################################################################################
+//                                      FONCTIONS RS485
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_RS485
+  DESCRIPTION   : initialise le bus : UART0 en 8N1, GPIO de direction à l'état bas (réception)
+  PARAMETRES    : Vitesse (bauds), GPIO de direction (DE / RE),
+                  fonction de construction des requêtes, fonction de traitement des réponses
+  RETOUR        : false si le TIMER1 n'a plus de client libre
+===============================================================================*/
+bool init_RS485(uint32 Bauds, uint8 gpio_direction, RS485_Requete requete, RS485_Reponse reponse);
+
+/*===============================================================================
+  FONCTION      : RS485_Ajouter_Esclave
+  DESCRIPTION   : Déclare un esclave (ajouté à la fin de la table d'interrogation par défaut)
+  PARAMETRES    : Adresse de l'esclave, timeout de réponse (us)
+  RETOUR        : N° de l'esclave, -1 si tous les esclaves sont déclarés
+===============================================================================*/
+int8 RS485_Ajouter_Esclave(uint8 adresse, uint32 timeout_us);
+
+/*===============================================================================
+  FONCTION      : RS485_Set_Table
+  DESCRIPTION   : Définit l'ordre d'interrogation des esclaves
+                  (un esclave prioritaire peut apparaître plusieurs fois)
+  PARAMETRES    : Table des N° d'esclaves, taille de la table
+  RETOUR        : false si la table est trop grande ou contient un esclave inconnu
+===============================================================================*/
+bool RS485_Set_Table(const uint8 *table, uint8 taille);
+
+/*===============================================================================
+  FONCTION      : RS485_Tache
+  DESCRIPTION   : Traite la réponse reçue et envoie la requête suivante
+                  (à appeler dans la boucle principale)
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void RS485_Tache();
+
+/*===============================================================================
+  FONCTION      : RS485_Lire_Statistiques
+  DESCRIPTION   : Statistiques d'un esclave
+  PARAMETRES    : N° de l'esclave
+  RETOUR        : Statistiques, NULL si l'esclave n'existe pas
+===============================================================================*/
+const RS485_Statistiques *RS485_Lire_Statistiques(uint8 esclave);
+
+/*===============================================================================
+  FONCTION      : RS485_Lire_Statistiques_Maitre
+  DESCRIPTION   : Statistiques du maître
+  PARAMETRES    : aucun
+  RETOUR        : Statistiques
+===============================================================================*/
+const RS485_Statistiques_Maitre *RS485_Lire_Statistiques_Maitre();
+
+/*===============================================================================
+  FONCTION      : Interruption_RS485_UART
+  DESCRIPTION   : Interruption UART0 : réception de la réponse
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_RS485_UART(uint8 UART, uint32 statut);
+
+/*===============================================================================
+  FONCTION      : Interruption_RS485_Timer
+  DESCRIPTION   : Client du multiplexeur TIMER1 : fin de la requête (relâchement
+                  de DE) puis timeout de la réponse
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_RS485_Timer(void *argument);
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,290 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : SPI_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Envoi SPI maître asynchrone sur le HSPI (SPI1)
+ *  (voir SPI_esp8266.h)
+ * =============================================================================================================================================
+ */
+
+#include "SPI_esp8266.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// File des envois (écrite hors interruption, lue par l'interruption)
+SPI_Envoi File_SPI[SPI_TAILLE_FILE];
+volatile uint8 spi_ecriture = 0;
+volatile uint8 spi_lecture = 0;
+
+// Position dans l'envoi en tête de file
+uint16 spi_ligne = 0;
+uint16 spi_colonne = 0;
+
+// Transfert en cours sur le bus
+volatile bool spi_actif = false;
+
+uint8 spi_gpio_dc = SPI_SANS_DC;
+
+volatile SPI_Statistiques Statistiques_SPI;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Charger_Paquet
+  DESCRIPTION   : Copie jusqu'à 64 octets de l'envoi en tête de file dans W0..W15
+                  et démarre le transfert (un paquet ne mélange jamais deux envois : niveau D/C unique)
+  PARAMETRES    : rien
+  RETOUR        : false si la file est vide
+===============================================================================*/
+static bool ICACHE_RAM_ATTR Charger_Paquet()
+{
+    uint32 mots[SPI_TAILLE_PAQUET / 4];
+    uint8 *paquet = (uint8 *)mots;
+    uint8 nombre = 0;
+
+    if (spi_lecture == spi_ecriture) return false;
+
+    const SPI_Envoi *envoi = &File_SPI[spi_lecture & SPI_MASQUE_FILE];
+    const uint8 *source = (envoi->donnees != NULL) ? envoi->donnees : envoi->commande;
+
+    while (nombre < SPI_TAILLE_PAQUET && spi_ligne < envoi->nb_lignes)
+    {
+        const uint8 *ligne = source + (uint32)spi_ligne * envoi->pas;
+        while (nombre < SPI_TAILLE_PAQUET && spi_colonne < envoi->largeur)
+        {
+            paquet[nombre++] = ligne[spi_colonne++];
+        }
+        if (spi_colonne == envoi->largeur)
+        {
+            spi_colonne = 0;
+            spi_ligne++;
+        }
+    }
+
+    // Niveau D/C positionné avant le premier front d'horloge du paquet
+    if (spi_gpio_dc != SPI_SANS_DC)
+    {
+        if (envoi->dc) REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,(1 << spi_gpio_dc));
+        else REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,(1 << spi_gpio_dc));
+    }
+
+    // Envoi entièrement chargé : sa place (et son buffer) sont libérés
+    if (spi_ligne >= envoi->nb_lignes)
+    {
+        spi_ligne = spi_colonne = 0;
+        spi_lecture++;
+    }
+
+    for (uint8 i = 0; i < (nombre + 3) / 4; i++)
+    {
+        REGISTRE_ECRIRE(Registre_SPI1->W[i],mots[i]);
+    }
+    REGISTRE_ECRIRE(Registre_SPI1->USER1,(uint32)(nombre * 8 - 1) << BIT_SPI_USR_MOSI_BITLEN);
+    REGISTRE_ECRIRE(Registre_SPI1->CMD,(1 << BIT_SPI_USR));
+
+    Statistiques_SPI.octets_envoyes += nombre;
+    Statistiques_SPI.nb_paquets++;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Ajouter_Envoi
+  DESCRIPTION   : Valide le dernier envoi écrit dans la file et démarre le bus s'il est libre
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+static void Ajouter_Envoi()
+{
+    ETS_INTR_DISABLE(ETS_SPI_INUM);
+    spi_ecriture++;
+    Statistiques_SPI.nb_envois++;
+    if (!spi_actif)
+    {
+        spi_actif = Charger_Paquet();
+    }
+    ETS_INTR_ENABLE(ETS_SPI_INUM);
+}
+
+// ##########################################################################################################################
+//                                              FONCTIONS SPI
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_SPI
+  DESCRIPTION   : Initialise le HSPI en maître (envoi seul, bit de poids fort en premier)
+                  et son interruption
+  PARAMETRES    : Fréquence d'horloge voulue (Hz, arrondie à la fréquence possible inférieure),
+                  mode, GPIO donnée / commande (SPI_SANS_DC si aucune)
+  RETOUR        : Fréquence obtenue (Hz)
+===============================================================================*/
+uint32 init_SPI(uint32 frequence, SPI_Mode mode, uint8 gpio_dc)
+{
+    uint32 obtenue = 0;
+    uint32 horloge = 0;
+
+    ETS_INTR_DISABLE(ETS_SPI_INUM);
+    spi_ecriture = spi_lecture = 0;
+    spi_ligne = spi_colonne = 0;
+    spi_actif = false;
+    Statistiques_SPI.octets_envoyes = 0;
+    Statistiques_SPI.nb_paquets = 0;
+    Statistiques_SPI.nb_envois = 0;
+    Statistiques_SPI.nb_refus = 0;
+
+    // Etape 1 : broches du HSPI (fonction 3 : HSPID, HSPICLK, HSPICS), broche D/C en sortie
+    Choix_fonction_GPIO(SPI_GPIO_MOSI,GPIO_FONCTION_3);
+    Choix_fonction_GPIO(SPI_GPIO_CLK,GPIO_FONCTION_3);
+    Choix_fonction_GPIO(SPI_GPIO_CS,GPIO_FONCTION_3);
+    spi_gpio_dc = gpio_dc;
+    if (gpio_dc != SPI_SANS_DC) init_GPIO(gpio_dc,GPIO_OUTPUT);
+
+    // Etape 2 : horloge = 80 MHz / (prédiviseur x diviseur), fréquence possible la plus proche par défaut
+    if (frequence >= ESP8266_CLOCK_FREQ)
+    {
+        horloge = (1UL << BIT_SPI_CLK_EQU_SYSCLK);
+        obtenue = ESP8266_CLOCK_FREQ;
+    }
+    else
+    {
+        for (uint32 diviseur = 2; diviseur <= 64; diviseur++)
+        {
+            uint32 prediviseur = (ESP8266_CLOCK_FREQ + frequence * diviseur - 1) / (frequence * diviseur);
+            if (prediviseur == 0 || prediviseur > 8192) continue;
+            uint32 resultat = ESP8266_CLOCK_FREQ / (prediviseur * diviseur);
+            if (resultat > obtenue)
+            {
+                obtenue = resultat;
+                horloge = ((prediviseur - 1) << BIT_SPI_CLKDIV_PRE) | ((diviseur - 1) << BIT_SPI_CLKCNT_N) |
+                          ((diviseur / 2 - 1) << BIT_SPI_CLKCNT_H) | ((diviseur - 1) << BIT_SPI_CLKCNT_L);
+            }
+        }
+    }
+    REGISTRE_ECRIRE(Registre_SPI1->CLOCK,horloge);
+
+    // Etape 3 : maître, envoi seul, CS géré par le contrôleur, polarité et phase selon le mode
+    // (la phase est inversée par le contrôleur lorsque l'horloge est haute au repos)
+    bool polarite = (mode == SPI_MODE_2 || mode == SPI_MODE_3);
+    bool phase = (mode == SPI_MODE_1 || mode == SPI_MODE_3) != polarite;
+    REGISTRE_ECRIRE(Registre_SPI1->CTRL,0);
+    REGISTRE_ECRIRE(Registre_SPI1->USER,(1UL << BIT_SPI_USR_MOSI) | (1 << BIT_SPI_CS_SETUP) | (1 << BIT_SPI_CS_HOLD) |
+                                        (1 << BIT_SPI_DOUTDIN) | ((uint32)phase << BIT_SPI_CK_OUT_EDGE));
+    REGISTRE_ECRIRE(Registre_SPI1->USER1,0);
+    if (polarite) REGISTRE_SET_BIT(Registre_SPI1->PIN,BIT_SPI_IDLE_EDGE);
+    else REGISTRE_CLR_BIT(Registre_SPI1->PIN,BIT_SPI_IDLE_EDGE);
+
+    // Etape 4 : interruption "fin de transfert"
+    REGISTRE_ECRIRE(Registre_SPI1->SLAVE,(1 << BIT_SPI_TRANS_DONE_EN));
+    ets_isr_attach(ETS_SPI_INUM,(int_handler_t)Interruption_SPI,NULL);
+    ETS_INTR_ENABLE(ETS_SPI_INUM);
+
+    return obtenue;
+}
+
+/*===============================================================================
+  FONCTION      : SPI_Ajouter_Commande
+  DESCRIPTION   : Ajoute à la file quelques octets (copiés) et démarre l'envoi si le bus est libre
+  PARAMETRES    : Niveau D/C (0 : commande, 1 : donnée), octets, nombre (SPI_TAILLE_COMMANDE au plus)
+  RETOUR        : false si la file est pleine
+===============================================================================*/
+bool SPI_Ajouter_Commande(uint8 dc, const uint8 *octets, uint8 nombre)
+{
+    if (nombre == 0 || nombre > SPI_TAILLE_COMMANDE) return false;
+    if (SPI_Place_File() == 0)
+    {
+        Statistiques_SPI.nb_refus++;
+        return false;
+    }
+
+    SPI_Envoi *envoi = &File_SPI[spi_ecriture & SPI_MASQUE_FILE];
+    for (uint8 i = 0; i < nombre; i++) envoi->commande[i] = octets[i];
+    envoi->donnees = NULL;
+    envoi->largeur = nombre;
+    envoi->pas = 0;
+    envoi->nb_lignes = 1;
+    envoi->dc = dc;
+    Ajouter_Envoi();
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : SPI_Ajouter_Bloc
+  DESCRIPTION   : Ajoute à la file une zone d'un buffer (envoyée sans copie, ligne après ligne)
+                  et démarre l'envoi si le bus est libre
+  PARAMETRES    : Niveau D/C, première ligne, octets par ligne, écart entre deux lignes, nombre de lignes
+  RETOUR        : false si la file est pleine
+===============================================================================*/
+bool SPI_Ajouter_Bloc(uint8 dc, const uint8 *donnees, uint16 largeur, uint16 pas, uint16 nb_lignes)
+{
+    if (donnees == NULL || largeur == 0 || nb_lignes == 0) return false;
+    if (SPI_Place_File() == 0)
+    {
+        Statistiques_SPI.nb_refus++;
+        return false;
+    }
+
+    SPI_Envoi *envoi = &File_SPI[spi_ecriture & SPI_MASQUE_FILE];
+    envoi->donnees = donnees;
+    envoi->largeur = largeur;
+    envoi->pas = pas;
+    envoi->nb_lignes = nb_lignes;
+    envoi->dc = dc;
+    Ajouter_Envoi();
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : SPI_Place_File
+  DESCRIPTION   : Nombre d'envois pouvant encore être ajoutés à la file
+  PARAMETRES    : rien
+  RETOUR        : Places libres
+===============================================================================*/
+uint8 SPI_Place_File()
+{
+    return SPI_TAILLE_FILE - (uint8)(spi_ecriture - spi_lecture);
+}
+
+/*===============================================================================
+  FONCTION      : SPI_Occupe
+  DESCRIPTION   : Indique si des envois sont en cours ou en attente
+  PARAMETRES    : rien
+  RETOUR        : true si le bus est occupé
+===============================================================================*/
+bool SPI_Occupe()
+{
+    return spi_actif || spi_lecture != spi_ecriture;
+}
+
+/*===============================================================================
+  FONCTION      : SPI_Lire_Statistiques
+  DESCRIPTION   : Compteurs des envois
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const SPI_Statistiques *SPI_Lire_Statistiques()
+{
+    return (const SPI_Statistiques *)&Statistiques_SPI;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_SPI
+  DESCRIPTION   : Interruption "fin de transfert" du HSPI : envoie le paquet suivant
+  PARAMETRES    : argument (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_SPI(void *argument)
+{
+    // Interruption partagée : HSPI uniquement
+    if (!(REGISTRE_LIRE(Registre_SPI_INT_STATUS) & (1 << BIT_SPI_INT_HSPI))) return;
+    if (!REGISTRE_READ_BIT(Registre_SPI1->SLAVE,BIT_SPI_TRANS_DONE)) return;
+
+    REGISTRE_CLR_BIT(Registre_SPI1->SLAVE,BIT_SPI_TRANS_DONE);
+    spi_actif = Charger_Paquet();
+}
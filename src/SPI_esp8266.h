@@ -0,0 +1,219 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : SPI_esp8266.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Envoi SPI maître asynchrone sur le HSPI (SPI1) : écrans, registres à décalage...
+ *
+ *  Broches : GPIO13 MOSI, GPIO14 CLK, GPIO15 CS (géré par le contrôleur), plus une GPIO optionnelle
+ *  "donnée / commande" (D/C des contrôleurs d'écran, positionnée avant chaque paquet).
+ *
+ *  Les envois sont placés dans une file et partent sous interruption, par paquets de 64 octets
+ *  (taille des registres W0..W15 du contrôleur) : l'interruption "fin de transfert" recharge le paquet suivant,
+ *  le processeur reste libre pendant que le contrôleur décale les bits.
+ *  - SPI_Ajouter_Commande : quelques octets copiés dans la file
+ *  - SPI_Ajouter_Bloc     : zone rectangulaire d'un buffer (lignes de "largeur" octets espacées de "pas" octets),
+ *                           envoyée sans copie : le buffer doit rester valide jusqu'à la fin de l'envoi
+ *
+ *  /!\ L'interruption SPI (ETS_SPI_INUM) est partagée avec le SPI de la flash et l'I2S :
+ *      la routine vérifie la source (registre SPI_INT_STATUS) avant de traiter le HSPI
+ * =============================================================================================================================================
+ */
+
+#ifndef __SPI_ESP8266_H__
+#define __SPI_ESP8266_H__
+
+// Dépendances
+#include "registres_esp8266.h"
+#include "GPIO_esp8266.h"
+
+// ##########################################################################################################################
+//                                      REGISTRES SPI
+// ##########################################################################################################################
+// -------------------------------------------------
+// Structure du registre
+// -------------------------------------------------
+typedef struct {
+    __Registre CMD;
+    __Registre ADDR;
+    __Registre CTRL;
+    __Registre CTRL1;
+    __Registre RD_STATUS;
+    __Registre CTRL2;
+    __Registre CLOCK;
+    __Registre USER;
+    __Registre USER1;
+    __Registre USER2;
+    __Registre WR_STATUS;
+    __Registre PIN;
+    __Registre SLAVE;
+    __Registre SLAVE1;
+    __Registre SLAVE2;
+    __Registre SLAVE3;
+    __Registre W[16];        // buffer de données (64 octets)
+} SPI_Struct;
+
+// -------------------------------------------------
+// définition des registres
+// -------------------------------------------------
+#define Registre_SPI1 ((SPI_Struct*) ADDR_SPI1)
+
+// Source de l'interruption SPI partagée (bit 7 : HSPI)
+#define ADDR_SPI_INT_STATUS 0x3ff00020
+#define Registre_SPI_INT_STATUS (*(__Registre*) ADDR_SPI_INT_STATUS)
+#define BIT_SPI_INT_HSPI 7
+
+// N° d'interruption SPI (absent de certains en-têtes du SDK)
+#ifndef ETS_SPI_INUM
+#define ETS_SPI_INUM 2
+#endif
+
+// -------------------------------------------------
+// Bits utilisés
+// -------------------------------------------------
+// SPI->CMD
+#define BIT_SPI_USR 18 // Démarre un transfert (remis à 0 par le contrôleur à la fin)
+
+// SPI->CTRL
+#define BIT_SPI_WR_BIT_ORDER 26 // 1 : bit de poids faible en premier
+#define BIT_SPI_RD_BIT_ORDER 25
+
+// SPI->CLOCK
+#define BIT_SPI_CLK_EQU_SYSCLK 31 // horloge SPI = horloge système (80 MHz)
+#define BIT_SPI_CLKDIV_PRE     18 // [30:18] prédiviseur - 1
+#define BIT_SPI_CLKCNT_N       12 // [17:12] diviseur - 1
+#define BIT_SPI_CLKCNT_H       6  // [11:6] fin de l'état haut
+#define BIT_SPI_CLKCNT_L       0  // [5:0] fin de l'état bas
+
+// SPI->USER
+#define BIT_SPI_USR_COMMAND 31
+#define BIT_SPI_USR_ADDR    30
+#define BIT_SPI_USR_DUMMY   29
+#define BIT_SPI_USR_MISO    28
+#define BIT_SPI_USR_MOSI    27
+#define BIT_SPI_CK_OUT_EDGE 7  // phase de l'horloge
+#define BIT_SPI_CS_SETUP    5
+#define BIT_SPI_CS_HOLD     4
+#define BIT_SPI_DOUTDIN     0  // full duplex
+
+// SPI->USER1
+#define BIT_SPI_USR_MOSI_BITLEN 17 // [25:17] nombre de bits envoyés - 1
+
+// SPI->PIN
+#define BIT_SPI_IDLE_EDGE 29 // polarité de l'horloge au repos
+
+// SPI->SLAVE
+#define BIT_SPI_TRANS_DONE_EN 9 // interruption "fin de transfert"
+#define BIT_SPI_TRANS_DONE    4 // fin de transfert (à effacer)
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Broches du HSPI
+#define SPI_GPIO_MOSI GPIO13
+#define SPI_GPIO_CLK  GPIO14
+#define SPI_GPIO_CS   GPIO15
+
+// Pas de broche donnée / commande
+#define SPI_SANS_DC 0xFF
+
+// Taille d'un paquet (registres W0..W15)
+#define SPI_TAILLE_PAQUET 64
+
+// File des envois (puissance de 2)
+#define SPI_TAILLE_FILE 16
+#define SPI_MASQUE_FILE (SPI_TAILLE_FILE - 1)
+
+// Octets d'une commande copiés dans la file
+#define SPI_TAILLE_COMMANDE 8
+
+// Mode SPI (polarité / phase de l'horloge)
+typedef enum {SPI_MODE_0,SPI_MODE_1,SPI_MODE_2,SPI_MODE_3} SPI_Mode;
+
+// Envoi en file
+typedef struct{
+  const uint8 *donnees;        // bloc : première ligne (NULL : commande, octets copiés ci-dessous)
+  uint16 largeur;              // octets par ligne (commande : nombre d'octets)
+  uint16 pas;                  // écart entre deux lignes
+  uint16 nb_lignes;
+  uint8 dc;                    // niveau de la broche donnée / commande
+  uint8 commande[SPI_TAILLE_COMMANDE];
+} SPI_Envoi;
+
+// Statistiques
+typedef struct{
+  uint32 octets_envoyes;
+  uint32 nb_paquets;
+  uint32 nb_envois;
+  uint32 nb_refus;             // envois refusés (file pleine)
+} SPI_Statistiques;
+
+// ##########################################################################################################################
+//                                              FONCTIONS SPI
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_SPI
+  DESCRIPTION   : Initialise le HSPI en maître (envoi seul, bit de poids fort en premier)
+                  et son interruption
+  PARAMETRES    : Fréquence d'horloge voulue (Hz, arrondie à la fréquence possible inférieure),
+                  mode, GPIO donnée / commande (SPI_SANS_DC si aucune)
+  RETOUR        : Fréquence obtenue (Hz)
+===============================================================================*/
+uint32 init_SPI(uint32 frequence, SPI_Mode mode, uint8 gpio_dc);
+
+/*===============================================================================
+  FONCTION      : SPI_Ajouter_Commande
+  DESCRIPTION   : Ajoute à la file quelques octets (copiés) et démarre l'envoi si le bus est libre
+  PARAMETRES    : Niveau D/C (0 : commande, 1 : donnée), octets, nombre (SPI_TAILLE_COMMANDE au plus)
+  RETOUR        : false si la file est pleine
+===============================================================================*/
+bool SPI_Ajouter_Commande(uint8 dc, const uint8 *octets, uint8 nombre);
+
+/*===============================================================================
+  FONCTION      : SPI_Ajouter_Bloc
+  DESCRIPTION   : Ajoute à la file une zone d'un buffer (envoyée sans copie, ligne après ligne)
+                  et démarre l'envoi si le bus est libre
+  PARAMETRES    : Niveau D/C, première ligne, octets par ligne, écart entre deux lignes, nombre de lignes
+  RETOUR        : false si la file est pleine
+===============================================================================*/
+bool SPI_Ajouter_Bloc(uint8 dc, const uint8 *donnees, uint16 largeur, uint16 pas, uint16 nb_lignes);
+
+/*===============================================================================
+  FONCTION      : SPI_Place_File
+  DESCRIPTION   : Nombre d'envois pouvant encore être ajoutés à la file
+  PARAMETRES    : rien
+  RETOUR        : Places libres
+===============================================================================*/
+uint8 SPI_Place_File();
+
+/*===============================================================================
+  FONCTION      : SPI_Occupe
+  DESCRIPTION   : Indique si des envois sont en cours ou en attente
+  PARAMETRES    : rien
+  RETOUR        : true si le bus est occupé
+===============================================================================*/
+bool SPI_Occupe();
+
+/*===============================================================================
+  FONCTION      : SPI_Lire_Statistiques
+  DESCRIPTION   : Compteurs des envois
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const SPI_Statistiques *SPI_Lire_Statistiques();
+
+/*===============================================================================
+  FONCTION      : Interruption_SPI
+  DESCRIPTION   : Interruption "fin de transfert" du HSPI : envoie le paquet suivant
+  PARAMETRES    : argument (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_SPI(void *argument);
+
+/* fin du fichier */
+#endif
@@ -1,183 +1,495 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : Scheduler.cpp
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Permet d'utiliser le TIMER1 de l'ESP8266 pour générer des timers virtuels
- *  Ces timers seront utilisés pour cadencer des actions à des temps définis.
- *  Exemples : 10us, 1ms, 1s
- * =============================================================================================================================================
- */
-
-#include "Scheduler.h"
-
-// ##########################################################################################################################
-//                                     VARIABLES GLOBALES
-// ##########################################################################################################################
-
-// Flag d'acquittement
-volatile bool flag_tick_us = false;
-volatile bool flag_tick_ms = false;
-volatile bool flag_tick_s  = false;
-
-// Ticks de cadencement
-volatile uint32 tick_ms = TICK_MS_VALUE;
-volatile uint32 tick_s  = TICK_S_VALUE;
-
-Compteur_Virtuel Compteur_virtuel_us[NB_COMPTEUR_US];
-Compteur_Virtuel Compteur_virtuel_ms[NB_COMPTEUR_MS];
-Compteur_Virtuel Compteur_virtuel_s[NB_COMPTEUR_S];
-// ##########################################################################################################################
-//                                      FONCTIONS SCHEDULER
-// ##########################################################################################################################
-
-/*===============================================================================
-  FONCTION      : init_TIMER1_Scheduler
-  DESCRIPTION   : initialise le TIMER1 avec les paramètres requis pour faire le Scheduler : 
-                  - Fréquence = 100kHz
-                  - Prédiviseur = 16
-  Le Scheduler permettra de cadencer des actions à 10us , 1ms et 1s
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
-void init_TIMER1_Scheduler()
-{
-    // initialisation des variables
-    flag_tick_us = false;
-    flag_tick_ms = false;
-    flag_tick_s  = false;
-
-    tick_ms = TICK_MS_VALUE;
-    tick_s  = TICK_S_VALUE;
-
-    // initialisation du timer
-    init_TIMER1(FREQ_SCHEDULER,PREDIV_SCHEDULER);
-
-    // Interruption(s)
-    ETS_FRC_TIMER1_INTR_ATTACH(Interruption_SCHEDULER,NULL);
-    ETS_FRC1_INTR_ENABLE();
-}
-
-
-/*===============================================================================
-  FONCTION      : Interruption_SCHEDULER
-  DESCRIPTION   : Interruption déclenchée toute les 10us 
-  Utilisée pour cadencer les timers virtuels (1ms et 1s) du scheduler
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
-void ICACHE_RAM_ATTR Interruption_SCHEDULER()
-{ 
-        // décrémentation des compteurs
-        tick_ms--; // on décrémente le compteur 1ms
-        tick_s--; // on décrémente le compteur 1s
-        
-        // -------------------------
-        // Tâches toutes les 10us
-        // -------------------------
-        flag_tick_us = true;
-
-        // -------------------------
-        // Tâches toutes les 1ms
-        // -------------------------
-        if (tick_ms == 0)
-        {
-            tick_ms = TICK_MS_VALUE; // on reset la valeur du compteur
-            flag_tick_ms = true;
-        }
-
-        // -------------------------
-        // Tâches toutes les 1s
-        // -------------------------
-        if (tick_s == 0)
-        {
-            tick_s = TICK_S_VALUE; // on reset la valeur du compteur
-            flag_tick_s = true;
-        }
-}
-
-
-/*===============================================================================
-  FONCTION      : Scheduler
-  DESCRIPTION   : Routine permettant de gérer les actions à réaliser selon les timers virtuels
-  PARAMETRES    : 
-  * Fonction à exécuter toute les 10us
-  * Fonction à exécuter toute les 1ms
-  * Fonction à exécuter toute les 1s
-  RETOUR        : rien   
-===============================================================================*/
-void Scheduler(void (*Fonction_Task_10us)(void),void (*Fonction_Task_1ms)(void),void (*Fonction_Task_1s)(void))
-{   
-    // -------------------------
-    // Tâches toutes les 10us
-    // -------------------------
-    if(flag_tick_us)
-    {
-        flag_tick_us = false; // acquittement
-        // tâches à exécuter 
-        Fonction_Task_10us();
-    }
-
-    // -------------------------
-    // Tâches toutes les 1ms
-    // -------------------------
-    if(flag_tick_ms)
-    {
-        flag_tick_ms = false;// acquittement
-        // tâches à exécuter 
-        Fonction_Task_1ms();
-    }
-    
-    // -------------------------
-    // Tâches toutes les 1s
-    // -------------------------
-    if(flag_tick_s)
-    {
-        flag_tick_s = false; // acquittement 
-        // tâches à exécuter 
-        Fonction_Task_1s(); 
-    }
-}
-
-/*===============================================================================
-  FONCTION      : init_Compteurs_Virtuels
-  DESCRIPTION   : initialise tous les compteurs virtuels potentiellement utilisables
-  - Par défaut, les timers doivent tous être à 1 et avoir le mode delay désactivé
-  
-  PARAMETRES    : rien
-  RETOUR        : rien   
-===============================================================================*/
-void init_Compteurs_Virtuels()
-{
-    for (uint16 i = 0; i < NB_COMPTEUR_US; i++)
-    {
-        Compteur_virtuel_us[i].valeur = 1;
-        Compteur_virtuel_us[i].delay = false;
-    }
-    for (uint16 i = 0; i < NB_COMPTEUR_MS; i++)
-    {
-        Compteur_virtuel_ms[i].valeur = 1;
-        Compteur_virtuel_ms[i].delay = false;
-    }
-    for (uint16 i = 0; i < NB_COMPTEUR_S; i++)
-    {
-        Compteur_virtuel_s[i].valeur = 1;
-        Compteur_virtuel_s[i].delay = false;
-    }
-}
-
-/*===============================================================================
-  FONCTION      : Attente
-  DESCRIPTION   : active un compteur en mode attente (delay)
-  PARAMETRES    : - Compteur à mettre en attente
-                  - Temps d'attente  
-  RETOUR        : rien   
-===============================================================================*/
-void Attente(Compteur_Virtuel *mon_compteur, uint16 temps)
-{
-    mon_compteur->valeur = temps;
-    mon_compteur->delay = true;
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : Scheduler.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Permet d'utiliser le TIMER1 de l'ESP8266 pour générer des timers virtuels
+ *  (le TIMER1 est partagé avec les autres modules par le multiplexeur, voir Multiplexeur_TIMER1.h)
+ *  Ces timers seront utilisés pour cadencer des actions à des temps définis.
+ *  Exemples : 10us, 1ms, 1s
+ *
+ *  Surveillance des échéances :
+ *  - chaque tick non traité est compté (un tick perdu n'est plus confondu avec le suivant)
+ *  - la durée de chaque tâche est mesurée et comparée à sa période (dépassement)
+ *  - le dernier défaut (tâche, durée ou ticks perdus, date) est conservé et consultable par UART
+ *  - le watchdog n'est rafraîchi que si les tâches critiques ont respecté leurs échéances
+ *
+ *  Les périodes des tâches sont fixées à la compilation (Scheduler_Taches, voir Scheduler.h) :
+ *  l'interruption et les prédiviseurs sont générés pour la configuration, ce fichier contient la partie commune
+ *
+ *  Tâche de fond : exécutée sur le temps libre, lorsqu'aucune tâche de période supérieure ou égale à 1ms
+ *  n'est en attente
+ * =============================================================================================================================================
+ */
+
+#include "Scheduler.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Ticks en attente de traitement (incrémentés sous interruption)
+volatile uint32 ticks_en_attente[SCHEDULER_NB_TACHES_MAX];
+
+// Compteurs virtuels globaux de la configuration standard
+Compteur_Virtuel Compteur_virtuel_us[NB_COMPTEUR_US];
+Compteur_Virtuel Compteur_virtuel_ms[NB_COMPTEUR_MS];
+Compteur_Virtuel Compteur_virtuel_s[NB_COMPTEUR_S];
+
+// Temps écoulé (ms), et reste (us) de la tâche la plus rapide
+uint32 temps_ms = 0;
+uint32 temps_reste_us = 0;
+
+// Client du multiplexeur TIMER1, son interruption et échéance du prochain tick (cycles CPU)
+int8 client_scheduler = -1;
+TIMER1_Mux_Fonction Interruption_Scheduler = NULL;
+uint32 echeance_scheduler = 0;
+
+// Configuration : nombre de tâches, période de chaque tâche (us),
+// tâches prioritaires sur la tâche de fond
+uint8 nb_taches_scheduler = 0;
+const uint32 *Periode_Tache_us = NULL;
+uint8 taches_avant_fond = 0;
+
+// Ticks perdus à partir desquels chaque tâche est en famine
+uint32 seuil_famine[SCHEDULER_NB_TACHES_MAX];
+
+// Surveillance des échéances
+Scheduler_Statistiques Statistiques_Scheduler[SCHEDULER_NB_TACHES_MAX];
+Scheduler_Defaut Dernier_Defaut;
+
+// Tâche de fond (temps libre)
+bool (*Fonction_Fond_Scheduler)(void) = NULL;
+
+// Watchdog
+void (*Fonction_Watchdog_Scheduler)(void) = NULL;
+uint8 taches_critiques = 0;
+uint8 taches_executees = 0;   // tâches exécutées depuis le dernier rafraîchissement
+uint8 taches_en_defaut = 0;   // tâches en défaut depuis le dernier rafraîchissement
+
+// ##########################################################################################################################
+//                                      FONCTIONS SCHEDULER
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Scheduler_Demarrer
+  DESCRIPTION   : Enregistre le Scheduler auprès du multiplexeur du TIMER1 et programme le premier tick
+  (appelée par init_Scheduler, qui fournit les éléments générés pour la configuration)
+  PARAMETRES    : - Interruption de la configuration
+                  - Initialisation de ses prédiviseurs
+                  - Nombre de tâches, périodes (us)
+                  - Période du tick (cycles CPU)
+  RETOUR        : false si aucun client du multiplexeur n'est libre,
+                  ou si le Scheduler a déjà été démarré avec une autre configuration
+===============================================================================*/
+bool Scheduler_Demarrer(TIMER1_Mux_Fonction Interruption, void (*Initialiser_Prediviseurs)(void),
+                        uint8 nb_taches, const uint32 *periodes_us, uint32 cycles_par_tick)
+{
+    // enregistrement auprès du multiplexeur du TIMER1 (une seule fois : le client ne change pas de fonction)
+    if (client_scheduler >= 0 && Interruption != Interruption_Scheduler) return false;
+    if (client_scheduler < 0) client_scheduler = TIMER1_Mux_Ajouter_Client(Interruption,NULL);
+    if (client_scheduler < 0) return false;
+    Interruption_Scheduler = Interruption;
+
+    ETS_INTR_LOCK();
+    TIMER1_Mux_Annuler(client_scheduler);
+    ETS_INTR_UNLOCK();
+
+    // initialisation des variables
+    nb_taches_scheduler = nb_taches;
+    Periode_Tache_us = periodes_us;
+    taches_avant_fond = 0;
+    for (uint8 i = 0; i < nb_taches; i++)
+    {
+        ticks_en_attente[i] = 0;
+        if (periodes_us[i] >= SCHEDULER_PERIODE_FOND_US) taches_avant_fond |= (1 << i);
+
+        // famine : même retard (SCHEDULER_FAMINE_US) pour toutes les tâches rapides,
+        // au moins SCHEDULER_SEUIL_FAMINE périodes pour les lentes
+        seuil_famine[i] = SCHEDULER_FAMINE_US / periodes_us[i];
+        if (seuil_famine[i] < SCHEDULER_SEUIL_FAMINE) seuil_famine[i] = SCHEDULER_SEUIL_FAMINE;
+    }
+    Initialiser_Prediviseurs();
+
+    temps_ms = 0;
+    temps_reste_us = 0;
+    Scheduler_RAZ_Statistiques();
+
+    // premier tick
+    ETS_INTR_LOCK();
+    echeance_scheduler = Lire_Compteur_Cycles() + cycles_par_tick;
+    TIMER1_Mux_Programmer(client_scheduler,echeance_scheduler);
+    ETS_INTR_UNLOCK();
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : init_TIMER1_Scheduler
+  DESCRIPTION   : Démarre le Scheduler avec la configuration standard :
+                  un tick toutes les 10us (100kHz)
+  Le Scheduler permettra de cadencer des actions à 10us , 1ms et 1s
+  PARAMETRES    : aucun
+  RETOUR        : rien   
+===============================================================================*/
+void init_TIMER1_Scheduler()
+{
+    init_Scheduler<Scheduler_Standard>();
+}
+
+
+/*===============================================================================
+  FONCTION      : Prendre_Ticks
+  DESCRIPTION   : Récupère et acquitte les ticks en attente d'une tâche
+  PARAMETRES    : Tâche
+  RETOUR        : Nombre de ticks écoulés depuis la dernière exécution
+===============================================================================*/
+static uint32 Prendre_Ticks(uint8 tache)
+{
+    uint32 nb_ticks;
+
+    ETS_INTR_LOCK();
+    nb_ticks = ticks_en_attente[tache];
+    ticks_en_attente[tache] = 0;
+    ETS_INTR_UNLOCK();
+
+    return nb_ticks;
+}
+
+/*===============================================================================
+  FONCTION      : Enregistrer_Defaut
+  DESCRIPTION   : Mémorise un défaut d'échéance
+  PARAMETRES    : Type de défaut, tâche, durée (us) ou nombre de ticks perdus
+  RETOUR        : rien
+===============================================================================*/
+static void Enregistrer_Defaut(uint8 type, uint8 tache, uint32 valeur)
+{
+    Dernier_Defaut.type = type;
+    Dernier_Defaut.tache = tache;
+    Dernier_Defaut.valeur = valeur;
+    Dernier_Defaut.date = temps_ms;
+    Dernier_Defaut.nb_defauts++;
+
+    taches_en_defaut |= (1 << tache);
+}
+
+/*===============================================================================
+  FONCTION      : Executer_Tache
+  DESCRIPTION   : Exécute une tâche en mesurant sa durée et son retard
+  PARAMETRES    : Tâche, nombre de ticks écoulés, fonction de la tâche
+  RETOUR        : rien
+===============================================================================*/
+static void Executer_Tache(uint8 tache, uint32 nb_ticks, void (*Fonction_Task)(void))
+{
+    Scheduler_Statistiques *stats = &Statistiques_Scheduler[tache];
+    uint32 ticks_manques = nb_ticks - 1;
+    uint32 debut, duree;
+
+    // Retard : périodes perdues depuis la dernière exécution
+    if (ticks_manques > 0)
+    {
+        stats->nb_ticks_manques += ticks_manques;
+        taches_en_defaut |= (1 << tache);
+        if (ticks_manques >= seuil_famine[tache])
+        {
+            stats->nb_famines++;
+            Enregistrer_Defaut(DEFAUT_FAMINE,tache,ticks_manques);
+        }
+    }
+
+    // Exécution chronométrée
+    debut = Lire_Compteur_Cycles();
+    Fonction_Task();
+    duree = (Lire_Compteur_Cycles() - debut) / SCHEDULER_CYCLES_PAR_US;
+
+    stats->nb_executions++;
+    stats->duree_derniere = duree;
+    if (duree > stats->duree_max) stats->duree_max = duree;
+
+    // Dépassement : la tâche a duré plus longtemps que sa période
+    if (duree > Periode_Tache_us[tache])
+    {
+        stats->nb_depassements++;
+        Enregistrer_Defaut(DEFAUT_DEPASSEMENT,tache,duree);
+    }
+
+    taches_executees |= (1 << tache);
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_Executer
+  DESCRIPTION   : Routine permettant de gérer les actions à réaliser selon les timers virtuels
+  Une tâche en retard de plusieurs ticks n'est exécutée qu'une fois, mais les ticks perdus
+  sont comptabilisés (et le temps Scheduler_Millis reste exact)
+  PARAMETRES    : Fonctions des tâches, dans l'ordre des périodes de la configuration
+  RETOUR        : rien   
+===============================================================================*/
+void Scheduler_Executer(const Scheduler_Fonction *fonctions)
+{   
+    uint32 nb_ticks;
+
+    for (uint8 tache = 0; tache < nb_taches_scheduler; tache++)
+    {
+        nb_ticks = Prendre_Ticks(tache);
+        if (nb_ticks == 0) continue;
+
+        // temps écoulé, compté sur la tâche la plus rapide
+        if (tache == 0)
+        {
+            temps_reste_us += nb_ticks * Periode_Tache_us[0];
+            if (temps_reste_us >= 1000)
+            {
+                temps_ms += temps_reste_us / 1000;
+                temps_reste_us %= 1000;
+            }
+        }
+
+        // tâches à exécuter 
+        Executer_Tache(tache,nb_ticks,fonctions[tache]);
+    }
+
+    // -------------------------
+    // Watchdog
+    // -------------------------
+    if (Fonction_Watchdog_Scheduler != NULL && (taches_executees & taches_critiques) == taches_critiques)
+    {
+        // rafraîchi uniquement si aucune tâche critique n'a manqué son échéance
+        if ((taches_en_defaut & taches_critiques) == 0)
+        {
+            Fonction_Watchdog_Scheduler();
+        }
+        taches_executees = 0;
+        taches_en_defaut = 0;
+    }
+
+    // -------------------------
+    // Tâche de fond
+    // -------------------------
+    if (Fonction_Fond_Scheduler != NULL)
+    {
+        for (uint8 tache = 0; tache < nb_taches_scheduler; tache++)
+        {
+            if (((taches_avant_fond >> tache) & 1) && ticks_en_attente[tache] != 0) return;
+        }
+        Fonction_Fond_Scheduler();
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler
+  DESCRIPTION   : Scheduler_Executer pour la configuration standard (init_TIMER1_Scheduler)
+  PARAMETRES    : 
+  * Fonction à exécuter toute les 10us
+  * Fonction à exécuter toute les 1ms
+  * Fonction à exécuter toute les 1s
+  RETOUR        : rien   
+===============================================================================*/
+void Scheduler(void (*Fonction_Task_10us)(void),void (*Fonction_Task_1ms)(void),void (*Fonction_Task_1s)(void))
+{   
+    const Scheduler_Fonction fonctions[NB_TACHES_SCHEDULER] = {Fonction_Task_10us,Fonction_Task_1ms,Fonction_Task_1s};
+
+    Scheduler_Executer(fonctions);
+}
+
+/*===============================================================================
+  FONCTION      : init_Compteurs_Virtuels
+  DESCRIPTION   : initialise les compteurs virtuels déclarés par l'application
+  - Par défaut, les timers doivent tous être à 1 et avoir le mode delay désactivé
+  
+  PARAMETRES    : Compteurs, nombre de compteurs
+  RETOUR        : rien   
+===============================================================================*/
+void init_Compteurs_Virtuels(Compteur_Virtuel *compteurs, uint16 nb_compteurs)
+{
+    for (uint16 i = 0; i < nb_compteurs; i++)
+    {
+        compteurs[i].valeur = 1;
+        compteurs[i].delay = false;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : init_Compteurs_Virtuels
+  DESCRIPTION   : initialise les compteurs virtuels globaux de la configuration standard
+  PARAMETRES    : rien
+  RETOUR        : rien   
+===============================================================================*/
+void init_Compteurs_Virtuels()
+{
+    init_Compteurs_Virtuels(Compteur_virtuel_us,NB_COMPTEUR_US);
+    init_Compteurs_Virtuels(Compteur_virtuel_ms,NB_COMPTEUR_MS);
+    init_Compteurs_Virtuels(Compteur_virtuel_s,NB_COMPTEUR_S);
+}
+
+/*===============================================================================
+  FONCTION      : Attente
+  DESCRIPTION   : active un compteur en mode attente (delay)
+  PARAMETRES    : - Compteur à mettre en attente
+                  - Temps d'attente  
+  RETOUR        : rien   
+===============================================================================*/
+void Attente(Compteur_Virtuel *mon_compteur, uint16 temps)
+{
+    mon_compteur->valeur = temps;
+    mon_compteur->delay = true;
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_Millis
+  DESCRIPTION   : Temps écoulé depuis l'initialisation du scheduler
+                  (mis à jour par la routine Scheduler, à chaque exécution de la tâche la plus rapide)
+  PARAMETRES    : rien
+  RETOUR        : Temps écoulé (ms)
+===============================================================================*/
+uint32 Scheduler_Millis()
+{
+    return temps_ms;
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_Set_Watchdog
+  DESCRIPTION   : Associe un watchdog à la surveillance des échéances
+  Le watchdog est rafraîchi lorsque toutes les tâches critiques ont été exécutées,
+  sans dépassement ni tick perdu, depuis le rafraîchissement précédent.
+  Un défaut ponctuel retarde le rafraîchissement, un défaut persistant provoque le reset.
+  PARAMETRES    : - Fonction de rafraîchissement (ex : system_soft_wdt_feed), NULL pour désactiver
+                  - Masque des tâches critiques (bit n : tâche n, MASQUE_TACHE_xxx en configuration standard)
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_Set_Watchdog(void (*Fonction_Watchdog)(void), uint8 critiques)
+{
+    Fonction_Watchdog_Scheduler = Fonction_Watchdog;
+    taches_critiques = critiques;
+    taches_executees = 0;
+    taches_en_defaut = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_Set_Tache_Fond
+  DESCRIPTION   : Associe une tâche de fond, appelée par Scheduler sur le temps libre
+  (une fois par appel, lorsqu'aucune tâche de période supérieure ou égale à SCHEDULER_PERIODE_FOND_US
+   n'est en attente)
+  PARAMETRES    : Fonction de la tâche (ex : Journal_Tache, Stockage_Tache), NULL pour désactiver
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_Set_Tache_Fond(bool (*Fonction_Fond)(void))
+{
+    Fonction_Fond_Scheduler = Fonction_Fond;
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_Statistiques_Tache
+  DESCRIPTION   : Statistiques d'exécution d'une tâche
+  PARAMETRES    : N° de la tâche dans la configuration (TACHE_10US, TACHE_1MS ou TACHE_1S en configuration standard)
+  RETOUR        : Statistiques de la tâche
+===============================================================================*/
+const Scheduler_Statistiques *Scheduler_Statistiques_Tache(uint8 tache)
+{
+    return &Statistiques_Scheduler[tache];
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_Dernier_Defaut
+  DESCRIPTION   : Dernier défaut (dépassement ou famine) enregistré
+  PARAMETRES    : rien
+  RETOUR        : Dernier défaut
+===============================================================================*/
+const Scheduler_Defaut *Scheduler_Dernier_Defaut()
+{
+    return &Dernier_Defaut;
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_RAZ_Statistiques
+  DESCRIPTION   : Remet à zéro les statistiques et le dernier défaut
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_RAZ_Statistiques()
+{
+    for (uint8 i = 0; i < SCHEDULER_NB_TACHES_MAX; i++)
+    {
+        Statistiques_Scheduler[i].nb_executions = 0;
+        Statistiques_Scheduler[i].nb_ticks_manques = 0;
+        Statistiques_Scheduler[i].nb_depassements = 0;
+        Statistiques_Scheduler[i].nb_famines = 0;
+        Statistiques_Scheduler[i].duree_derniere = 0;
+        Statistiques_Scheduler[i].duree_max = 0;
+    }
+    Dernier_Defaut.type = DEFAUT_AUCUN;
+    Dernier_Defaut.tache = 0;
+    Dernier_Defaut.valeur = 0;
+    Dernier_Defaut.date = 0;
+    Dernier_Defaut.nb_defauts = 0;
+}
+
+/*===============================================================================
+  FONCTION      : Ecrire_Nom_Tache
+  DESCRIPTION   : Envoie le nom d'une tâche sur une UART : sa période (ex : 10us, 20ms, 1s)
+  PARAMETRES    : N° de l'UART (0 ou 1), tâche
+  RETOUR        : rien
+===============================================================================*/
+static void Ecrire_Nom_Tache(uint8 UART, uint8 tache)
+{
+    uint32 periode = Periode_Tache_us[tache];
+
+    if (periode % 1000000 == 0)
+    {
+        UART_WriteNombre(UART,periode / 1000000);
+        UART_WriteString(UART,"s");
+    }
+    else if (periode % 1000 == 0)
+    {
+        UART_WriteNombre(UART,periode / 1000);
+        UART_WriteString(UART,"ms");
+    }
+    else
+    {
+        UART_WriteNombre(UART,periode);
+        UART_WriteString(UART,"us");
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Scheduler_Rapport
+  DESCRIPTION   : Envoie les statistiques des tâches et le dernier défaut sur une UART
+  Format : une ligne par tâche, puis une ligne pour le dernier défaut
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_Rapport(uint8 UART)
+{
+    for (uint8 i = 0; i < nb_taches_scheduler; i++)
+    {
+        UART_WriteString(UART,"tache ");
+        Ecrire_Nom_Tache(UART,i);
+        UART_WriteString(UART," : executions=");
+        UART_WriteNombre(UART,Statistiques_Scheduler[i].nb_executions);
+        UART_WriteString(UART," ticks_manques=");
+        UART_WriteNombre(UART,Statistiques_Scheduler[i].nb_ticks_manques);
+        UART_WriteString(UART," depassements=");
+        UART_WriteNombre(UART,Statistiques_Scheduler[i].nb_depassements);
+        UART_WriteString(UART," famines=");
+        UART_WriteNombre(UART,Statistiques_Scheduler[i].nb_famines);
+        UART_WriteString(UART," duree_max=");
+        UART_WriteNombre(UART,Statistiques_Scheduler[i].duree_max);
+        UART_WriteString(UART,"us\n");
+    }
+
+    UART_WriteString(UART,"defauts=");
+    UART_WriteNombre(UART,Dernier_Defaut.nb_defauts);
+    if (Dernier_Defaut.type != DEFAUT_AUCUN)
+    {
+        UART_WriteString(UART,Dernier_Defaut.type == DEFAUT_DEPASSEMENT ? " dernier=depassement tache " : " dernier=famine tache ");
+        Ecrire_Nom_Tache(UART,Dernier_Defaut.tache);
+        UART_WriteString(UART," valeur=");
+        UART_WriteNombre(UART,Dernier_Defaut.valeur);
+        UART_WriteString(UART,Dernier_Defaut.type == DEFAUT_DEPASSEMENT ? "us" : "ticks");
+        UART_WriteString(UART," date=");
+        UART_WriteNombre(UART,Dernier_Defaut.date);
+        UART_WriteString(UART,"ms");
+    }
+    UART_WriteString(UART,"\n");
 }
\ No newline at end of file
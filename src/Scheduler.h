@@ -1,109 +1,458 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : Scheduler.h
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Permet d'utiliser le TIMER1 de l'ESP8266 pour générer des timers virtuels
- *  Ces timers seront utilisés pour cadencer des actions à des temps définis.
- *  Exemples : 10us, 1ms, 1s
- * =============================================================================================================================================
- */
-
-#ifndef __SCHEDULER_H__
-#define __SCHEDULER_H__
-
-// Dépendance(s)
-#include "TIMER_esp8266.h"
-#include "GPIO_esp8266.h"
-
-
-typedef struct{
-  uint16 valeur;
-  bool delay;
-} Compteur_Virtuel;
-
-
-
-
-// ##########################################################################################################################
-//                                     DEFINE ET VARIABLES GLOBALES
-// ##########################################################################################################################
-
-// Paramètres du scheduler
-#define FREQ_SCHEDULER 100000
-#define PREDIV_SCHEDULER DIV16
-#define VAL_PREDIV_SCHEDULER 16
-
-// Tick pour le scheduler
-// initial :  1 tick / 10us
-#define TICK_MS_VALUE 100 // 1 tick / 1ms
-#define TICK_S_VALUE  (1000 * TICK_MS_VALUE) // 1 tick / 1s
-
-// Nombre de timers programmés
-#define NB_COMPTEUR_US 10
-#define NB_COMPTEUR_MS 10
-#define NB_COMPTEUR_S 10
-
-// Création de compteurs virtuels
-extern Compteur_Virtuel Compteur_virtuel_us[NB_COMPTEUR_US];
-extern Compteur_Virtuel Compteur_virtuel_ms[NB_COMPTEUR_MS];
-extern Compteur_Virtuel Compteur_virtuel_s[NB_COMPTEUR_S];
-
-// ##########################################################################################################################
-//                                      FONCTIONS SCHEDULER
-// ##########################################################################################################################
-
-/*===============================================================================
-  FONCTION      : init_TIMER1_Scheduler
-  DESCRIPTION   : initialise le TIMER1 avec les paramètres requis pour faire le Scheduler : 
-                  - Fréquence = 100kHz
-                  - Prédiviseur = 16
-  Le Scheduler permettra de cadencer des actions à 10us , 1ms et 1s
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
-void init_TIMER1_Scheduler();
-
-
-/*===============================================================================
-  FONCTION      : Interruption_SCHEDULER
-  DESCRIPTION   : Interruption déclenchée toute les 10us 
-  Utilisée pour cadencer les timers virtuels (1ms et 1s) du scheduler
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
-void ICACHE_RAM_ATTR Interruption_SCHEDULER();
-
-
-/*===============================================================================
-  FONCTION      : Scheduler
-  DESCRIPTION   : Routine permettant de gérer les actions à réaliser selon les timers virtuels
-  PARAMETRES    : 
-  * Fonction à exécuter toute les 10us
-  * Fonction à exécuter toute les 1ms
-  * Fonction à exécuter toute les 1s
-  RETOUR        : rien   
-===============================================================================*/
-void Scheduler(void (*Fonction_Task_10us)(void),void (*Fonction_Task_1ms)(void),void (*Fonction_Task_1s)(void));
-
-/*===============================================================================
-  FONCTION      : init_Compteurs_Virtuels
-  DESCRIPTION   : initialise tous les compteurs virtuels potentiellement utilisables
-  PARAMETRES    : rien
-  RETOUR        : rien   
-===============================================================================*/
-void init_Compteurs_Virtuels();
-
-/*===============================================================================
-  FONCTION      : Attente
-  DESCRIPTION   : passe un compteur en mode attente
-  PARAMETRES    : - Compteur à mettre en attente
-                  - Temps d'attente  
-  RETOUR        : rien   
-===============================================================================*/
-void Attente(Compteur_Virtuel *mon_compteur, uint16 temps);
-
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : Scheduler.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Permet d'utiliser le TIMER1 de l'ESP8266 pour générer des timers virtuels
+ *  (le TIMER1 est partagé avec les autres modules par le multiplexeur, voir Multiplexeur_TIMER1.h)
+ *  Ces timers seront utilisés pour cadencer des actions à des temps définis.
+ *  Exemples : 10us, 1ms, 1s
+ *
+ *  Configuration à la compilation : l'application déclare les périodes de ses tâches (us, croissantes)
+ *  - le tick du scheduler est le PGCD des périodes : sans tâche 10us, l'interruption n'a lieu qu'une fois par ms
+ *  - chaque tâche a son prédiviseur, cadencé par la tâche précédente de plus longue période qui divise la sienne
+ *    (à défaut par le tick) : la tâche 1s ne décompte qu'à chaque tâche 1ms, pas à chaque tick.
+ *    Une tâche à la période du tick n'a pas de compteur
+ *  - l'interruption est générée pour la configuration (rapports de division constants, pas de boucle)
+ *  - les périodes inatteignables sont refusées à la compilation (static_assert) : tick trop court pour
+ *    l'interruption, échéance hors de portée du multiplexeur, périodes nulles ou non croissantes
+ *
+ *  Exemple :
+ *      typedef Scheduler_Taches<1000, 20000, 1000000> Taches;     // 1ms, 20ms, 1s : tick de 1ms
+ *      const Scheduler_Fonction Fonctions[] = {Tache_1ms, Tache_20ms, Tache_1s};
+ *      setup : init_Scheduler<Taches>();
+ *      loop  : Scheduler_Executer(Fonctions);
+ *  init_TIMER1_Scheduler et Scheduler(...) utilisent la configuration standard 10us, 1ms, 1s (Scheduler_Standard).
+ *  Les constantes FREQ_SCHEDULER, TICK_MS_VALUE, TICK_S_VALUE et les compteurs virtuels globaux
+ *  (Compteur_virtuel_us / ms / s, init_Compteurs_Virtuels()) sont déduits de cette configuration.
+ *  PREDIV_SCHEDULER / VAL_PREDIV_SCHEDULER restent définies mais ne sont plus utilisées (le multiplexeur compte en cycles CPU).
+ *  Une seule configuration par application : init_Scheduler<...> est appelée depuis un seul fichier.
+ *
+ *  Surveillance des échéances :
+ *  - chaque tick non traité est compté (un tick perdu n'est plus confondu avec le suivant)
+ *  - la durée de chaque tâche est mesurée et comparée à sa période (dépassement)
+ *  - le dernier défaut (tâche, durée ou ticks perdus, date) est conservé et consultable par UART
+ *  - le watchdog n'est rafraîchi que si les tâches critiques ont respecté leurs échéances
+ *
+ *  Tâche de fond : exécutée sur le temps libre, lorsqu'aucune tâche de période supérieure ou égale à 1ms
+ *  n'est en attente (écritures en flash du journal de mesures, ramasse-miettes du stockage...)
+ * =============================================================================================================================================
+ */
+
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+// Dépendance(s)
+#include "Multiplexeur_TIMER1.h"
+#include "GPIO_esp8266.h"
+#include "UART_esp8266.h"
+
+
+typedef struct{
+  uint16 valeur;
+  bool delay;
+} Compteur_Virtuel;
+
+
+
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre maximal de tâches d'une configuration (masques de 8 bits)
+#define SCHEDULER_NB_TACHES_MAX 8
+
+// Conversion de la durée d'une tâche (cycles CPU -> us)
+#define SCHEDULER_CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+
+// Tick minimal (us) : en dessous, l'interruption et le multiplexeur occupent l'essentiel du CPU
+#define SCHEDULER_TICK_MIN_US 10
+
+// Tick maximal (us) : échéance du multiplexeur à moins de 2^31 cycles
+#define SCHEDULER_TICK_MAX_US (0x7FFFFFFF / SCHEDULER_CYCLES_PAR_US)
+
+// Les tâches de période supérieure ou égale sont prioritaires sur la tâche de fond (us)
+#define SCHEDULER_PERIODE_FOND_US 1000
+
+// Prédiviseur cadencé directement par le tick
+#define SCHEDULER_AUCUNE 0xFF
+
+// Nombre de ticks perdus à partir duquel une tâche est considérée en famine
+#define SCHEDULER_SEUIL_FAMINE 10
+
+// Retard (us) à partir duquel une tâche rapide est considérée en famine : le seuil d'une tâche est
+// max(SCHEDULER_SEUIL_FAMINE, SCHEDULER_FAMINE_US / période), soit 1000 ticks pour la tâche 10us
+#define SCHEDULER_FAMINE_US 10000
+
+// Fonction d'une tâche
+typedef void (*Scheduler_Fonction)(void);
+
+// Tâches de la configuration standard (init_TIMER1_Scheduler)
+typedef enum {TACHE_10US,TACHE_1MS,TACHE_1S,NB_TACHES_SCHEDULER} Tache_Scheduler;
+
+// Masques des tâches (tâches critiques du watchdog) : bit n pour la tâche n de la configuration
+#define MASQUE_TACHE_10US (1 << TACHE_10US)
+#define MASQUE_TACHE_1MS  (1 << TACHE_1MS)
+#define MASQUE_TACHE_1S   (1 << TACHE_1S)
+
+// Types de défaut
+typedef enum {DEFAUT_AUCUN,DEFAUT_DEPASSEMENT,DEFAUT_FAMINE} Scheduler_Type_Defaut;
+
+// Statistiques d'une tâche
+typedef struct{
+  uint32 nb_executions;
+  uint32 nb_ticks_manques;   // périodes perdues (tâche exécutée en retard)
+  uint32 nb_depassements;    // exécutions plus longues que la période
+  uint32 nb_famines;         // retards d'au moins max(SCHEDULER_SEUIL_FAMINE, SCHEDULER_FAMINE_US / période) périodes
+  uint32 duree_derniere;     // us
+  uint32 duree_max;          // us
+} Scheduler_Statistiques;
+
+// Dernier défaut enregistré
+typedef struct{
+  uint8 type;                // Scheduler_Type_Defaut
+  uint8 tache;               // N° de la tâche
+  uint32 valeur;             // durée d'exécution (us) ou nombre de ticks perdus
+  uint32 date;               // ms (Scheduler_Millis)
+  uint32 nb_defauts;         // nombre total de défauts
+} Scheduler_Defaut;
+
+// Ticks en attente de traitement de chaque tâche (incrémentés sous interruption)
+extern volatile uint32 ticks_en_attente[SCHEDULER_NB_TACHES_MAX];
+
+// Client du multiplexeur TIMER1 et échéance du prochain tick (cycles CPU)
+extern int8 client_scheduler;
+extern uint32 echeance_scheduler;
+
+// ##########################################################################################################################
+//                                      CONFIGURATION GENEREE A LA COMPILATION
+// ##########################################################################################################################
+
+// Périodes des tâches (us, croissantes) : fonctions évaluées à la compilation
+template <uint32... PERIODES_US> struct Scheduler_Taches{
+  static_assert(sizeof...(PERIODES_US) >= 1 && sizeof...(PERIODES_US) <= SCHEDULER_NB_TACHES_MAX,
+                "nombre de tâches : 1 à SCHEDULER_NB_TACHES_MAX");
+  static const uint8 nb_taches = sizeof...(PERIODES_US);
+  static constexpr uint32 periodes_us[sizeof...(PERIODES_US)] = {PERIODES_US...};
+
+  static constexpr uint32 Periode(uint8 tache) { return periodes_us[tache]; }
+
+  // Périodes non nulles et strictement croissantes à partir de "tache"
+  static constexpr bool Croissantes(uint8 tache)
+  {
+      return (Periode(tache) > 0) && (tache + 1 >= nb_taches || (Periode(tache) < Periode(tache + 1) && Croissantes(tache + 1)));
+  }
+
+  // PGCD des périodes à partir de "tache" (Tick(0) : tick du scheduler)
+  static constexpr uint32 PGCD(uint32 a, uint32 b) { return (b == 0) ? a : PGCD(b,a % b); }
+  static constexpr uint32 Tick(uint8 tache) { return (tache >= nb_taches) ? 0 : PGCD(Periode(tache),Tick(tache + 1)); }
+
+  // Source du prédiviseur : tâche précédente de plus longue période qui divise celle de "tache" (recherche depuis "avant")
+  static constexpr uint8 Chercher_Source(uint8 tache, uint8 avant)
+  {
+      return (avant == 0) ? SCHEDULER_AUCUNE
+           : (Periode(tache) % Periode(avant - 1) == 0) ? (uint8)(avant - 1) : Chercher_Source(tache,avant - 1);
+  }
+  static constexpr uint8 Source(uint8 tache) { return Chercher_Source(tache,tache); }
+
+  // Rapport de division : ticks (ou exécutions de la source) par exécution de la tâche
+  static constexpr uint32 Division(uint8 tache)
+  {
+      return Periode(tache) / ((Source(tache) == SCHEDULER_AUCUNE) ? Tick(0) : Periode(Source(tache)));
+  }
+};
+template <uint32... PERIODES_US>
+constexpr uint32 Scheduler_Taches<PERIODES_US...>::periodes_us[sizeof...(PERIODES_US)];
+
+// Configuration standard : 10us, 1ms, 1s
+typedef Scheduler_Taches<10,1000,1000000> Scheduler_Standard;
+
+// Vérification de la configuration et tick
+template <typename TACHES> struct Scheduler_Configuration{
+  static_assert(TACHES::Croissantes(0), "périodes : non nulles et strictement croissantes");
+  static_assert(TACHES::Tick(0) >= SCHEDULER_TICK_MIN_US,
+                "période inatteignable : le PGCD des périodes (tick) est inférieur à SCHEDULER_TICK_MIN_US");
+  static_assert(TACHES::Tick(0) <= SCHEDULER_TICK_MAX_US,
+                "période inatteignable : le PGCD des périodes (tick) dépasse l'échéance maximale du multiplexeur");
+
+  static const uint32 tick_us = TACHES::Tick(0);
+  static const uint32 cycles_par_tick = TACHES::Tick(0) * SCHEDULER_CYCLES_PAR_US;
+};
+
+// Constantes de la configuration standard (applications existantes)
+#define FREQ_SCHEDULER (1000000 / Scheduler_Configuration<Scheduler_Standard>::tick_us)
+#define TICK_MS_VALUE  (Scheduler_Standard::Periode(TACHE_1MS) / Scheduler_Standard::Tick(0)) // 1 tick / 1ms
+#define TICK_S_VALUE   (Scheduler_Standard::Periode(TACHE_1S) / Scheduler_Standard::Tick(0))  // 1 tick / 1s
+
+// Prédiviseur historique du TIMER1 (applications existantes) : sans effet, le TIMER1 est programmé
+// par le multiplexeur en cycles CPU (voir Multiplexeur_TIMER1.h)
+#define PREDIV_SCHEDULER DIV16
+#define VAL_PREDIV_SCHEDULER 16
+
+// Compteurs virtuels globaux de la configuration standard (applications existantes)
+#define NB_COMPTEUR_US 10
+#define NB_COMPTEUR_MS 10
+#define NB_COMPTEUR_S 10
+
+extern Compteur_Virtuel Compteur_virtuel_us[NB_COMPTEUR_US];
+extern Compteur_Virtuel Compteur_virtuel_ms[NB_COMPTEUR_MS];
+extern Compteur_Virtuel Compteur_virtuel_s[NB_COMPTEUR_S];
+
+// Prédiviseur d'une tâche : exécutions de la source (ou ticks) restantes avant la sienne
+// Avancer : nombre d'exécutions de la tâche pour "n" exécutions de la source (n > 1 après un blocage)
+template <typename TACHES, uint8 TACHE, uint32 DIVISION = TACHES::Division(TACHE)> struct Scheduler_Prediviseur{
+  static uint32 compteur;
+  static inline void Initialiser() { compteur = DIVISION; }
+  static inline uint32 Avancer(uint32 n)
+  {
+      if (n < compteur)
+      {
+          compteur -= n;
+          return 0;
+      }
+      n -= compteur;
+      compteur = DIVISION - n % DIVISION;
+      return 1 + n / DIVISION;
+  }
+};
+template <typename TACHES, uint8 TACHE, uint32 DIVISION>
+uint32 Scheduler_Prediviseur<TACHES,TACHE,DIVISION>::compteur = DIVISION;
+
+// Période égale à celle de la source : pas de compteur
+template <typename TACHES, uint8 TACHE> struct Scheduler_Prediviseur<TACHES,TACHE,1>{
+  static inline void Initialiser() {}
+  static inline uint32 Avancer(uint32 n) { return n; }
+};
+
+// Initialisation des prédiviseurs des tâches à partir de TACHE
+template <typename TACHES, uint8 TACHE = 0, bool FIN = (TACHE >= TACHES::nb_taches)> struct Scheduler_Prediviseurs{
+  static void Initialiser()
+  {
+      Scheduler_Prediviseur<TACHES,TACHE>::Initialiser();
+      Scheduler_Prediviseurs<TACHES,TACHE + 1>::Initialiser();
+  }
+};
+template <typename TACHES, uint8 TACHE> struct Scheduler_Prediviseurs<TACHES,TACHE,true>{
+  static void Initialiser() {}
+};
+
+// Cascade : avance de "n" exécutions de SOURCE les prédiviseurs des tâches à partir de TACHE dont la source est SOURCE
+template <typename TACHES, uint8 SOURCE, uint8 TACHE, bool FIN = (TACHE >= TACHES::nb_taches)> struct Scheduler_Cascade;
+
+// Avance le prédiviseur d'une tâche (si elle est cadencée par la source en cours), puis ceux des tâches qu'elle cadence
+template <typename TACHES, uint8 TACHE, bool CADENCEE> struct Scheduler_Etape{
+  static inline void Avancer(uint32 n) {}
+};
+template <typename TACHES, uint8 TACHE> struct Scheduler_Etape<TACHES,TACHE,true>{
+  static inline void Avancer(uint32 n)
+  {
+      uint32 nb = Scheduler_Prediviseur<TACHES,TACHE>::Avancer(n);
+      if (nb != 0)
+      {
+          ticks_en_attente[TACHE] += nb;
+          Scheduler_Cascade<TACHES,TACHE,TACHE + 1>::Avancer(nb);
+      }
+  }
+};
+
+template <typename TACHES, uint8 SOURCE, uint8 TACHE, bool FIN> struct Scheduler_Cascade{
+  static inline void Avancer(uint32 n)
+  {
+      Scheduler_Etape<TACHES,TACHE,TACHES::Source(TACHE) == SOURCE>::Avancer(n);
+      Scheduler_Cascade<TACHES,SOURCE,TACHE + 1>::Avancer(n);
+  }
+};
+template <typename TACHES, uint8 SOURCE, uint8 TACHE> struct Scheduler_Cascade<TACHES,SOURCE,TACHE,true>{
+  static inline void Avancer(uint32 n) {}
+};
+
+// ##########################################################################################################################
+//                                      FONCTIONS SCHEDULER
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Scheduler_Demarrer
+  DESCRIPTION   : Enregistre le Scheduler auprès du multiplexeur du TIMER1 et programme le premier tick
+  (appelée par init_Scheduler, qui fournit les éléments générés pour la configuration)
+  PARAMETRES    : - Interruption de la configuration
+                  - Initialisation de ses prédiviseurs
+                  - Nombre de tâches, périodes (us)
+                  - Période du tick (cycles CPU)
+  RETOUR        : false si aucun client du multiplexeur n'est libre,
+                  ou si le Scheduler a déjà été démarré avec une autre configuration
+===============================================================================*/
+bool Scheduler_Demarrer(TIMER1_Mux_Fonction Interruption, void (*Initialiser_Prediviseurs)(void),
+                        uint8 nb_taches, const uint32 *periodes_us, uint32 cycles_par_tick);
+
+/*===============================================================================
+  FONCTION      : Interruption_SCHEDULER
+  DESCRIPTION   : Interruption déclenchée à chaque tick (client du multiplexeur TIMER1)
+  Programme le tick suivant puis avance les prédiviseurs des tâches : à chaque tick,
+  seuls les compteurs cadencés par le tick sont décrémentés.
+  Après un blocage de plus d'une période, les ticks sautés sont crédités aux tâches
+  (ticks perdus et famine détectés, Scheduler_Millis reste exact)
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien   
+===============================================================================*/
+template <typename TACHES>
+void ICACHE_RAM_ATTR Interruption_SCHEDULER(void *argument)
+{
+    typedef Scheduler_Configuration<TACHES> CONFIG;
+    uint32 maintenant = Lire_Compteur_Cycles();
+    uint32 nb_ticks = 1;
+
+    // échéance suivante, calculée depuis la précédente (pas de dérive)
+    echeance_scheduler += CONFIG::cycles_par_tick;
+    if ((int32)(echeance_scheduler - maintenant) < 0)
+    {
+        // blocage de plus d'une période : les ticks déjà échus sont comptés,
+        // l'échéance passe au premier tick futur sans perdre la phase
+        uint32 sautes = (maintenant - echeance_scheduler) / CONFIG::cycles_par_tick + 1;
+        nb_ticks += sautes;
+        echeance_scheduler += sautes * CONFIG::cycles_par_tick;
+    }
+    TIMER1_Mux_Programmer(client_scheduler,echeance_scheduler);
+
+    Scheduler_Cascade<TACHES,SCHEDULER_AUCUNE,0>::Avancer(nb_ticks);
+}
+
+/*===============================================================================
+  FONCTION      : init_Scheduler
+  DESCRIPTION   : Démarre le Scheduler avec une configuration de tâches
+  (les statistiques et le temps Scheduler_Millis repartent de 0)
+  PARAMETRES    : TACHES : configuration (Scheduler_Taches<périodes en us>)
+  RETOUR        : false si le Scheduler n'a pas pu être démarré (voir Scheduler_Demarrer)
+===============================================================================*/
+template <typename TACHES>
+inline bool init_Scheduler()
+{
+    return Scheduler_Demarrer(Interruption_SCHEDULER<TACHES>,Scheduler_Prediviseurs<TACHES>::Initialiser,
+                              TACHES::nb_taches,TACHES::periodes_us,Scheduler_Configuration<TACHES>::cycles_par_tick);
+}
+
+/*===============================================================================
+  FONCTION      : init_TIMER1_Scheduler
+  DESCRIPTION   : Démarre le Scheduler avec la configuration standard :
+                  un tick toutes les 10us (100kHz)
+  Le Scheduler permettra de cadencer des actions à 10us , 1ms et 1s
+  PARAMETRES    : aucun
+  RETOUR        : rien   
+===============================================================================*/
+void init_TIMER1_Scheduler();
+
+/*===============================================================================
+  FONCTION      : Scheduler_Executer
+  DESCRIPTION   : Routine permettant de gérer les actions à réaliser selon les timers virtuels
+  Une tâche en retard de plusieurs ticks n'est exécutée qu'une fois, mais les ticks perdus
+  sont comptabilisés (et le temps Scheduler_Millis reste exact)
+  PARAMETRES    : Fonctions des tâches, dans l'ordre des périodes de la configuration
+  RETOUR        : rien   
+===============================================================================*/
+void Scheduler_Executer(const Scheduler_Fonction *fonctions);
+
+/*===============================================================================
+  FONCTION      : Scheduler
+  DESCRIPTION   : Scheduler_Executer pour la configuration standard (init_TIMER1_Scheduler)
+  PARAMETRES    : 
+  * Fonction à exécuter toute les 10us
+  * Fonction à exécuter toute les 1ms
+  * Fonction à exécuter toute les 1s
+  RETOUR        : rien   
+===============================================================================*/
+void Scheduler(void (*Fonction_Task_10us)(void),void (*Fonction_Task_1ms)(void),void (*Fonction_Task_1s)(void));
+
+/*===============================================================================
+  FONCTION      : init_Compteurs_Virtuels
+  DESCRIPTION   : initialise les compteurs virtuels déclarés par l'application
+  PARAMETRES    : Compteurs, nombre de compteurs
+  RETOUR        : rien   
+===============================================================================*/
+void init_Compteurs_Virtuels(Compteur_Virtuel *compteurs, uint16 nb_compteurs);
+
+/*===============================================================================
+  FONCTION      : init_Compteurs_Virtuels
+  DESCRIPTION   : initialise les compteurs virtuels globaux de la configuration standard
+                  (Compteur_virtuel_us, Compteur_virtuel_ms, Compteur_virtuel_s)
+  PARAMETRES    : rien
+  RETOUR        : rien   
+===============================================================================*/
+void init_Compteurs_Virtuels();
+
+/*===============================================================================
+  FONCTION      : Attente
+  DESCRIPTION   : passe un compteur en mode attente
+  PARAMETRES    : - Compteur à mettre en attente
+                  - Temps d'attente  
+  RETOUR        : rien   
+===============================================================================*/
+void Attente(Compteur_Virtuel *mon_compteur, uint16 temps);
+
+/*===============================================================================
+  FONCTION      : Scheduler_Millis
+  DESCRIPTION   : Temps écoulé depuis l'initialisation du scheduler
+                  (mis à jour par la routine Scheduler, à chaque exécution de la tâche la plus rapide)
+  PARAMETRES    : rien
+  RETOUR        : Temps écoulé (ms)
+===============================================================================*/
+uint32 Scheduler_Millis();
+
+/*===============================================================================
+  FONCTION      : Scheduler_Set_Watchdog
+  DESCRIPTION   : Associe un watchdog à la surveillance des échéances
+  Le watchdog est rafraîchi lorsque toutes les tâches critiques ont été exécutées,
+  sans dépassement ni tick perdu, depuis le rafraîchissement précédent.
+  Un défaut ponctuel retarde le rafraîchissement, un défaut persistant provoque le reset.
+  PARAMETRES    : - Fonction de rafraîchissement (ex : system_soft_wdt_feed), NULL pour désactiver
+                  - Masque des tâches critiques (bit n : tâche n, MASQUE_TACHE_xxx en configuration standard)
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_Set_Watchdog(void (*Fonction_Watchdog)(void), uint8 critiques);
+
+/*===============================================================================
+  FONCTION      : Scheduler_Set_Tache_Fond
+  DESCRIPTION   : Associe une tâche de fond, appelée par Scheduler sur le temps libre
+  (une fois par appel, lorsqu'aucune tâche de période supérieure ou égale à SCHEDULER_PERIODE_FOND_US
+   n'est en attente).
+  Elle doit rendre la main rapidement : une étape de travail par appel
+  PARAMETRES    : Fonction de la tâche (ex : Journal_Tache, Stockage_Tache), NULL pour désactiver
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_Set_Tache_Fond(bool (*Fonction_Fond)(void));
+
+/*===============================================================================
+  FONCTION      : Scheduler_Statistiques_Tache
+  DESCRIPTION   : Statistiques d'exécution d'une tâche
+  PARAMETRES    : N° de la tâche dans la configuration (TACHE_10US, TACHE_1MS ou TACHE_1S en configuration standard)
+  RETOUR        : Statistiques de la tâche
+===============================================================================*/
+const Scheduler_Statistiques *Scheduler_Statistiques_Tache(uint8 tache);
+
+/*===============================================================================
+  FONCTION      : Scheduler_Dernier_Defaut
+  DESCRIPTION   : Dernier défaut (dépassement ou famine) enregistré
+  PARAMETRES    : rien
+  RETOUR        : Dernier défaut
+===============================================================================*/
+const Scheduler_Defaut *Scheduler_Dernier_Defaut();
+
+/*===============================================================================
+  FONCTION      : Scheduler_RAZ_Statistiques
+  DESCRIPTION   : Remet à zéro les statistiques et le dernier défaut
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_RAZ_Statistiques();
+
+/*===============================================================================
+  FONCTION      : Scheduler_Rapport
+  DESCRIPTION   : Envoie les statistiques des tâches et le dernier défaut sur une UART
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : rien
+===============================================================================*/
+void Scheduler_Rapport(uint8 UART);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,463 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : SoftUART_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  UART logicielles (RX + TX) sur n'importe quelle GPIO, cadencées par le TIMER1 et les interruptions GPIO
+ *  - Réception : détection du bit de start par front descendant, puis échantillonnage au milieu de chaque bit
+ *  - Emission  : chaque bit est positionné sur interruption du TIMER1
+ *  Les échéances sont calculées sur le compteur de cycles CPU : le TIMER1 ne sert qu'à déclencher l'interruption
+ *  Plusieurs UART logicielles peuvent fonctionner en même temps (jusqu'à 57600 bauds)
+ *
+ *  Le TIMER1 est partagé avec les autres modules (Scheduler, ...) par le multiplexeur (voir Multiplexeur_TIMER1.h)
+ * =============================================================================================================================================
+ */
+
+// Librairies
+#include "SoftUART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+SoftUART_Struct SoftUART[NB_SOFTUART];
+
+// Client du multiplexeur TIMER1 commun à toutes les UART logicielles
+int8 client_timer_SoftUART = -1;
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : SoftUART_Parite
+  DESCRIPTION   : Calcule le bit de parité d'une donnée
+  PARAMETRES    : donnée, parité voulue (EVEN ou ODD)
+  RETOUR        : bit de parité
+===============================================================================*/
+static inline uint8 ICACHE_RAM_ATTR SoftUART_Parite(uint16 donnee, uint8 parite)
+{
+    uint8 bit = 0;
+    while (donnee)
+    {
+        bit ^= (donnee & 1);
+        donnee >>= 1;
+    }
+    return (parite == ODD) ? (bit ^ 1) : bit;
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_Planifier
+  DESCRIPTION   : Programme le TIMER1 (multiplexeur) sur l'échéance la plus proche parmi toutes
+                  les UART logicielles (ou l'annule si aucune n'est active)
+  (doit être appelée interruptions masquées ou depuis l'interruption TIMER1)
+  PARAMETRES    : instant présent (cycles CPU)
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR SoftUART_Planifier(uint32 maintenant)
+{
+    bool echeance_trouvee = false;
+    int32 delai_min = 0x7FFFFFFF;
+    int32 delai;
+
+    for (uint8 i = 0; i < NB_SOFTUART; i++)
+    {
+        if (!SoftUART[i].actif) continue;
+
+        if (SoftUART[i].rx_en_cours)
+        {
+            delai = (int32)(SoftUART[i].rx_echeance - maintenant);
+            if (delai < delai_min) delai_min = delai;
+            echeance_trouvee = true;
+        }
+        if (SoftUART[i].tx_en_cours)
+        {
+            delai = (int32)(SoftUART[i].tx_echeance - maintenant);
+            if (delai < delai_min) delai_min = delai;
+            echeance_trouvee = true;
+        }
+    }
+
+    if (!echeance_trouvee)
+    {
+        TIMER1_Mux_Annuler(client_timer_SoftUART);
+        return;
+    }
+
+    TIMER1_Mux_Programmer(client_timer_SoftUART,maintenant + delai_min);
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_Echantillonner
+  DESCRIPTION   : Lit un bit sur la GPIO de réception
+  PARAMETRES    : UART logicielle concernée
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR SoftUART_Echantillonner(SoftUART_Struct *uart)
+{
+    uint8 bit = REGISTRE_READ_BIT(Registre_GPIO->IN,uart->gpio_rx);
+    uint8 nb_bits = uart->nb_data + (uart->parite ? 1 : 0);
+    bool trame_terminee = false;
+
+    if (uart->rx_bit == 0)
+    {
+        // Bit de start : s'il est déjà revenu à l'état haut, il s'agissait d'un parasite
+        if (bit != 0) trame_terminee = true;
+    }
+    else if (uart->rx_bit <= nb_bits)
+    {
+        // Bits de données puis parité
+        uart->rx_trame |= (bit << (uart->rx_bit - 1));
+    }
+    else
+    {
+        // Bit de stop : fin de la trame
+        uint8 donnee = uart->rx_trame & ((1 << uart->nb_data) - 1);
+        bool erreur = (bit == 0);
+
+        if (uart->parite && READ_BIT(uart->rx_trame,uart->nb_data) != SoftUART_Parite(donnee,uart->parite))
+        {
+            erreur = true;
+        }
+
+        if (erreur)
+        {
+            uart->erreurs_trame++;
+        }
+        else
+        {
+            uint16 suivant = (uart->rx.ecriture + 1) & (SOFTUART_TAILLE_BUFFER - 1);
+            if (suivant == uart->rx.lecture)
+            {
+                uart->debordements++;
+            }
+            else
+            {
+                uart->rx.donnees[uart->rx.ecriture] = donnee;
+                uart->rx.ecriture = suivant;
+            }
+        }
+        trame_terminee = true;
+    }
+
+    if (trame_terminee)
+    {
+        // On se remet en attente du prochain bit de start
+        uart->rx_en_cours = false;
+        REGISTRE_ECRIRE(Registre_GPIO->STATUS_W1TC,(1 << uart->gpio_rx));
+        REGISTRE_CONFIG_OU(Registre_GPIO->PIN[uart->gpio_rx],(FRONT_DESCENDANT << BIT_GPIO_INT_TYPE));
+    }
+    else
+    {
+        uart->rx_bit++;
+        uart->rx_echeance += uart->duree_bit;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_Charger_Octet
+  DESCRIPTION   : Prépare la trame du prochain octet à émettre
+  PARAMETRES    : UART logicielle concernée, instant de début du bit de start
+  RETOUR        : true si un octet a été chargé, false si le buffer TX est vide
+===============================================================================*/
+static bool ICACHE_RAM_ATTR SoftUART_Charger_Octet(SoftUART_Struct *uart, uint32 debut)
+{
+    if (uart->tx.lecture == uart->tx.ecriture) return false;
+
+    uint16 donnee = uart->tx.donnees[uart->tx.lecture] & ((1 << uart->nb_data) - 1);
+    uart->tx.lecture = (uart->tx.lecture + 1) & (SOFTUART_TAILLE_BUFFER - 1);
+
+    // Trame : start (0) | données | parité | stop (1)
+    uint8 nb_bits = uart->nb_data;
+    uart->tx_trame = donnee << 1;
+    if (uart->parite)
+    {
+        uart->tx_trame |= (SoftUART_Parite(donnee,uart->parite) << (nb_bits + 1));
+        nb_bits++;
+    }
+    uart->tx_trame |= (1 << (nb_bits + 1));
+
+    uart->tx_nb_bits = nb_bits + 2;
+    uart->tx_bit = 0;
+    uart->tx_echeance = debut;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_Emettre_Bit
+  DESCRIPTION   : Positionne la GPIO d'émission sur le bit courant de la trame
+  PARAMETRES    : UART logicielle concernée
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR SoftUART_Emettre_Bit(SoftUART_Struct *uart)
+{
+    // Fin du bit de stop : octet suivant ou fin d'émission
+    if (uart->tx_bit >= uart->tx_nb_bits)
+    {
+        if (!SoftUART_Charger_Octet(uart,uart->tx_echeance))
+        {
+            uart->tx_en_cours = false;
+            return;
+        }
+    }
+
+    // écriture directe des registres W1TS / W1TC
+    if (READ_BIT(uart->tx_trame,uart->tx_bit))
+    {
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TS,(1 << uart->gpio_tx));
+    }
+    else
+    {
+        REGISTRE_ECRIRE(Registre_GPIO->OUT_W1TC,(1 << uart->gpio_tx));
+    }
+
+    uart->tx_bit++;
+    uart->tx_echeance += (uart->tx_bit == uart->tx_nb_bits) ? uart->duree_stop : uart->duree_bit;
+}
+
+// ##########################################################################################################################
+//                                              FONCTIONS SOFT UART
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_SoftUART
+  DESCRIPTION   : initialise une UART logicielle
+  PARAMETRES    : N° de l'UART logicielle (0 à NB_SOFTUART-1)
+                  GPIO de réception (ou SOFTUART_AUCUNE_GPIO)
+                  GPIO d'émission (ou SOFTUART_AUCUNE_GPIO)
+                  Vitesse de communication (Bauds)
+                  Nombre de bits de données (5,6,7 ou 8)
+                  Parité (Aucune, Even, Odd)
+                  Nombre de bits de stop (1,1.5 ou 2)
+  RETOUR        : rien
+===============================================================================*/
+void init_SoftUART(uint8 SoftUART_n, uint8 GPIO_RX, uint8 GPIO_TX, uint32 Bauds, UART_BitData Nb_BitData, UART_Parite Parite, UART_BitStop Nb_BitStop)
+{
+    if (SoftUART_n >= NB_SOFTUART || Bauds == 0 || Bauds > SOFTUART_BAUDS_MAX) return;
+
+    SoftUART_Struct *uart = &SoftUART[SoftUART_n];
+
+    // Etape 1 : paramétrage de la com'
+    ETS_INTR_LOCK();
+    uart->actif = false;
+    uart->gpio_rx = GPIO_RX;
+    uart->gpio_tx = GPIO_TX;
+    uart->nb_data = 5 + Nb_BitData;
+    uart->parite = (Parite == NONE) ? 0 : Parite;
+    uart->duree_bit = (ESP8266_CLOCK_FREQ + Bauds / 2) / Bauds;
+    switch (Nb_BitStop)
+    {
+        case STOP_15 : uart->duree_stop = (3 * uart->duree_bit) / 2; break;
+        case STOP_2  : uart->duree_stop = 2 * uart->duree_bit;       break;
+        default      : uart->duree_stop = uart->duree_bit;           break; // 1 bit de stop minimum
+    }
+    uart->rx_en_cours = false;
+    uart->tx_en_cours = false;
+    uart->rx.ecriture = uart->rx.lecture = 0;
+    uart->tx.ecriture = uart->tx.lecture = 0;
+    uart->erreurs_trame = 0;
+    uart->debordements = 0;
+    ETS_INTR_UNLOCK();
+
+    // Etape 2 : enregistrement auprès du multiplexeur TIMER1 (une seule fois pour toutes les UART logicielles)
+    if (client_timer_SoftUART < 0)
+    {
+        client_timer_SoftUART = TIMER1_Mux_Ajouter_Client(Interruption_SoftUART_Timer,NULL);
+        if (client_timer_SoftUART < 0) return;
+    }
+
+    // Etape 3 : configuration des GPIO
+    if (GPIO_TX != SOFTUART_AUCUNE_GPIO)
+    {
+        init_GPIO(GPIO_TX,GPIO_OUTPUT);
+        GPIO_Write(GPIO_TX,ETAT_HAUT); // état de repos de la ligne
+    }
+
+    uart->actif = true;
+
+    if (GPIO_RX != SOFTUART_AUCUNE_GPIO)
+    {
+        init_GPIO(GPIO_RX,GPIO_INPUT);
+        REGISTRE_CONFIG_SET_BIT(Registre_IOMUX->GPIO[index_iomux(GPIO_RX)],BIT_IOMUX_PULLUP); // ligne au repos à l'état haut
+        GPIO_Attacher_Interruption(GPIO_RX,FRONT_DESCENDANT,Interruption_SoftUART_RX);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_send_tx
+  DESCRIPTION   : Place un caractère dans le buffer d'émission
+                  (attend si le buffer est plein)
+  PARAMETRES    : N° de l'UART logicielle
+                  Caractère à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_send_tx(uint8 SoftUART_n, uint8 caractere)
+{
+    if (SoftUART_n >= NB_SOFTUART) return;
+
+    SoftUART_Struct *uart = &SoftUART[SoftUART_n];
+    if (!uart->actif || uart->gpio_tx == SOFTUART_AUCUNE_GPIO) return;
+
+    // Tant que le buffer TX est plein, on ne peut pas écrire de nouveaux caractères
+    uint16 suivant = (uart->tx.ecriture + 1) & (SOFTUART_TAILLE_BUFFER - 1);
+    while (suivant == uart->tx.lecture);
+
+    uart->tx.donnees[uart->tx.ecriture] = caractere;
+    uart->tx.ecriture = suivant;
+
+    // Si aucune émission n'est en cours, on la démarre
+    ETS_INTR_LOCK();
+    if (!uart->tx_en_cours)
+    {
+        uint32 maintenant = Lire_Compteur_Cycles();
+        SoftUART_Charger_Octet(uart,maintenant + SOFTUART_DELAI_MIN);
+        uart->tx_en_cours = true;
+        SoftUART_Planifier(maintenant);
+    }
+    ETS_INTR_UNLOCK();
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_WriteChar
+  DESCRIPTION   : Envoie un caractère sur la liaison série
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART logicielle
+                  Caractère à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_WriteChar(uint8 SoftUART_n, uint8 Caractere)
+{
+    // Gestion du retour-chariot
+    if (Caractere == '\n')
+    {
+        SoftUART_send_tx(SoftUART_n,'\r');
+        SoftUART_send_tx(SoftUART_n,'\n');
+    }
+    else
+    {
+        SoftUART_send_tx(SoftUART_n,Caractere);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_WriteBuffer
+  DESCRIPTION   : Envoie un buffer sur la liaison série
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART logicielle
+                  buffer à envoyer
+                  taille du buffer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_WriteBuffer(uint8 SoftUART_n, uint8 *buffer, uint16 len)
+{
+    uint16 i;
+    for (i = 0; i < len; i++)
+    {
+        SoftUART_WriteChar(SoftUART_n,buffer[i]);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_WriteString
+  DESCRIPTION   : Envoie une chaîne de caractère sur la liaison série
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART logicielle
+                  chaîne de caractère à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_WriteString(uint8 SoftUART_n, const char *str)
+{
+    while(*str){
+        SoftUART_WriteChar(SoftUART_n,*str++);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_Available
+  DESCRIPTION   : Indique le nombre de caractères reçus en attente de lecture
+  PARAMETRES    : N° de l'UART logicielle
+  RETOUR        : Nombre de caractères disponibles
+===============================================================================*/
+uint16 SoftUART_Available(uint8 SoftUART_n)
+{
+    if (SoftUART_n >= NB_SOFTUART) return 0;
+    return (SoftUART[SoftUART_n].rx.ecriture - SoftUART[SoftUART_n].rx.lecture) & (SOFTUART_TAILLE_BUFFER - 1);
+}
+
+/*===============================================================================
+  FONCTION      : SoftUART_ReadChar
+  DESCRIPTION   : Lit un caractère reçu
+  PARAMETRES    : N° de l'UART logicielle
+  RETOUR        : Caractère lu (0 si aucun caractère disponible)
+===============================================================================*/
+uint8 SoftUART_ReadChar(uint8 SoftUART_n)
+{
+    if (SoftUART_Available(SoftUART_n) == 0) return 0;
+
+    SoftUART_Buffer *rx = &SoftUART[SoftUART_n].rx;
+    uint8 caractere = rx->donnees[rx->lecture];
+    rx->lecture = (rx->lecture + 1) & (SOFTUART_TAILLE_BUFFER - 1);
+    return caractere;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_SoftUART_Timer
+  DESCRIPTION   : Interruption du TIMER1 : échantillonne les bits reçus,
+                  émet les bits à envoyer, puis reprogramme le TIMER1 sur la
+                  prochaine échéance
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_SoftUART_Timer(void *argument)
+{
+    uint32 maintenant = Lire_Compteur_Cycles();
+
+    for (uint8 i = 0; i < NB_SOFTUART; i++)
+    {
+        SoftUART_Struct *uart = &SoftUART[i];
+        if (!uart->actif) continue;
+
+        // Les échéances atteintes (ou très proches) sont traitées immédiatement
+        if (uart->tx_en_cours && (int32)(uart->tx_echeance - maintenant) < SOFTUART_DELAI_MIN)
+        {
+            SoftUART_Emettre_Bit(uart);
+        }
+        if (uart->rx_en_cours && (int32)(uart->rx_echeance - maintenant) < SOFTUART_DELAI_MIN)
+        {
+            SoftUART_Echantillonner(uart);
+        }
+    }
+
+    SoftUART_Planifier(Lire_Compteur_Cycles());
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_SoftUART_RX
+  DESCRIPTION   : Interruption GPIO (front descendant) : détection d'un bit de start
+  Le premier échantillon est pris au milieu du bit de start pour vérifier
+  qu'il ne s'agit pas d'un parasite
+  PARAMETRES    : N° de la GPIO, état logique de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_SoftUART_RX(uint8 GPIO, uint8 etat)
+{
+    uint32 maintenant = Lire_Compteur_Cycles();
+
+    for (uint8 i = 0; i < NB_SOFTUART; i++)
+    {
+        SoftUART_Struct *uart = &SoftUART[i];
+        if (!uart->actif || uart->gpio_rx != GPIO || uart->rx_en_cours) continue;
+
+        // Les fronts suivants de la trame sont ignorés jusqu'au bit de stop
+        REGISTRE_CONFIG_ET(Registre_GPIO->PIN[GPIO],~(0x7 << BIT_GPIO_INT_TYPE));
+
+        uart->rx_bit = 0;
+        uart->rx_trame = 0;
+        uart->rx_echeance = maintenant + uart->duree_bit / 2;
+        uart->rx_en_cours = true;
+        SoftUART_Planifier(maintenant);
+    }
+}
@@ -0,0 +1,183 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : SoftUART_esp8266.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  UART logicielles (RX + TX) sur n'importe quelle GPIO, cadencées par le TIMER1 et les interruptions GPIO
+ *  - Réception : détection du bit de start par front descendant, puis échantillonnage au milieu de chaque bit
+ *  - Emission  : chaque bit est positionné sur interruption du TIMER1
+ *  Les échéances sont calculées sur le compteur de cycles CPU : le TIMER1 ne sert qu'à déclencher l'interruption
+ *  Plusieurs UART logicielles peuvent fonctionner en même temps (jusqu'à 57600 bauds)
+ *
+ *  Le TIMER1 est partagé avec les autres modules (Scheduler, ...) par le multiplexeur (voir Multiplexeur_TIMER1.h)
+ * =============================================================================================================================================
+ */
+
+#ifndef __SOFTUART_ESP8266_H__
+#define __SOFTUART_ESP8266_H__
+
+// Dépendances
+#include "registres_esp8266.h"
+#include "GPIO_esp8266.h"
+#include "Multiplexeur_TIMER1.h"
+#include "UART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre d'UART logicielles disponibles
+#define NB_SOFTUART 4
+
+// Taille des buffers circulaires RX et TX (puissance de 2)
+#define SOFTUART_TAILLE_BUFFER 64
+
+// Vitesse maximale supportée
+#define SOFTUART_BAUDS_MAX 57600
+
+// Délai minimal entre deux interruptions du TIMER1 (en cycles CPU : 1us)
+// Les échéances plus proches que ce délai sont traitées immédiatement : un front émis peut donc être en avance
+// de 1us au plus sur la grille des bits (5% d'un bit à 57600 bauds, sans cumul puisque les échéances restent exactes)
+#define SOFTUART_DELAI_MIN 80
+
+// Permet de n'utiliser qu'un sens de communication (RX ou TX)
+#define SOFTUART_AUCUNE_GPIO 0xFF
+
+// Buffer circulaire (une seule source, un seul consommateur)
+typedef struct {
+  volatile uint8 donnees[SOFTUART_TAILLE_BUFFER];
+  volatile uint16 ecriture;
+  volatile uint16 lecture;
+} SoftUART_Buffer;
+
+// Etat d'une UART logicielle
+// Les durées et échéances sont exprimées en cycles CPU (80 MHz, voir Lire_Compteur_Cycles)
+typedef struct {
+  bool actif;
+  uint8 gpio_rx;
+  uint8 gpio_tx;
+  uint8 nb_data;            // nombre de bits de données (5 à 8)
+  uint8 parite;             // 0 : aucune, sinon UART_Parite
+  uint32 duree_bit;         // durée d'un bit
+  uint32 duree_stop;        // durée du (des) bit(s) de stop
+
+  // Réception
+  volatile bool rx_en_cours;
+  uint8 rx_bit;             // 0 : bit de start, puis données, parité et stop
+  uint16 rx_trame;
+  uint32 rx_echeance;
+  SoftUART_Buffer rx;
+
+  // Emission
+  volatile bool tx_en_cours;
+  uint8 tx_bit;
+  uint8 tx_nb_bits;         // start + données + parité + stop
+  uint16 tx_trame;
+  uint32 tx_echeance;
+  SoftUART_Buffer tx;
+
+  // Diagnostic
+  uint32 erreurs_trame;     // bit de stop ou parité incorrect
+  uint32 debordements;      // octet reçu perdu (buffer RX plein)
+} SoftUART_Struct;
+
+extern SoftUART_Struct SoftUART[NB_SOFTUART];
+
+// ##########################################################################################################################
+//                                              FONCTIONS SOFT UART
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_SoftUART
+  DESCRIPTION   : initialise une UART logicielle
+  PARAMETRES    : N° de l'UART logicielle (0 à NB_SOFTUART-1)
+                  GPIO de réception (ou SOFTUART_AUCUNE_GPIO)
+                  GPIO d'émission (ou SOFTUART_AUCUNE_GPIO)
+                  Vitesse de communication (Bauds)
+                  Nombre de bits de données (5,6,7 ou 8)
+                  Parité (Aucune, Even, Odd)
+                  Nombre de bits de stop (1,1.5 ou 2)
+  RETOUR        : rien
+===============================================================================*/
+void init_SoftUART(uint8 SoftUART_n, uint8 GPIO_RX, uint8 GPIO_TX, uint32 Bauds, UART_BitData Nb_BitData, UART_Parite Parite, UART_BitStop Nb_BitStop);
+
+/*===============================================================================
+  FONCTION      : SoftUART_send_tx
+  DESCRIPTION   : Place un caractère dans le buffer d'émission
+                  (attend si le buffer est plein)
+  PARAMETRES    : N° de l'UART logicielle
+                  Caractère à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_send_tx(uint8 SoftUART_n, uint8 caractere);
+
+/*===============================================================================
+  FONCTION      : SoftUART_WriteChar
+  DESCRIPTION   : Envoie un caractère sur la liaison série
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART logicielle
+                  Caractère à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_WriteChar(uint8 SoftUART_n, uint8 Caractere);
+
+/*===============================================================================
+  FONCTION      : SoftUART_WriteBuffer
+  DESCRIPTION   : Envoie un buffer sur la liaison série
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART logicielle
+                  buffer à envoyer
+                  taille du buffer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_WriteBuffer(uint8 SoftUART_n, uint8 *buffer, uint16 len);
+
+/*===============================================================================
+  FONCTION      : SoftUART_WriteString
+  DESCRIPTION   : Envoie une chaîne de caractère sur la liaison série
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART logicielle
+                  chaîne de caractère à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void SoftUART_WriteString(uint8 SoftUART_n, const char *str);
+
+/*===============================================================================
+  FONCTION      : SoftUART_Available
+  DESCRIPTION   : Indique le nombre de caractères reçus en attente de lecture
+  PARAMETRES    : N° de l'UART logicielle
+  RETOUR        : Nombre de caractères disponibles
+===============================================================================*/
+uint16 SoftUART_Available(uint8 SoftUART_n);
+
+/*===============================================================================
+  FONCTION      : SoftUART_ReadChar
+  DESCRIPTION   : Lit un caractère reçu
+  PARAMETRES    : N° de l'UART logicielle
+  RETOUR        : Caractère lu (0 si aucun caractère disponible)
+===============================================================================*/
+uint8 SoftUART_ReadChar(uint8 SoftUART_n);
+
+/*===============================================================================
+  FONCTION      : Interruption_SoftUART_Timer
+  DESCRIPTION   : Interruption du TIMER1 : échantillonne les bits reçus,
+                  émet les bits à envoyer, puis reprogramme le TIMER1 sur la
+                  prochaine échéance
+  PARAMETRES    : argument du multiplexeur (inutilisé)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_SoftUART_Timer(void *argument);
+
+/*===============================================================================
+  FONCTION      : Interruption_SoftUART_RX
+  DESCRIPTION   : Interruption GPIO (front descendant) : détection d'un bit de start
+  PARAMETRES    : N° de la GPIO, état logique de la GPIO
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_SoftUART_RX(uint8 GPIO, uint8 etat);
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,500 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Stockage_Flash.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Stockage clé / valeur en flash, avec répartition de l'usure (configuration, données persistantes)
+ *  (voir Stockage_Flash.h)
+ * =============================================================================================================================================
+ */
+
+#include "Stockage_Flash.h"
+#include <string.h>
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Etats d'un secteur
+typedef enum {SECTEUR_LIBRE,SECTEUR_A_EFFACER,SECTEUR_UTILISE} Stockage_Etat_Secteur;
+
+// En-tête d'un secteur
+typedef struct{
+  uint32 magique;
+  uint32 sequence;   // ordre d'utilisation des secteurs
+} Stockage_Entete_Secteur;
+
+// En-tête d'un enregistrement
+typedef struct{
+  uint16 cle;
+  uint16 taille;     // taille des données | STOCKAGE_SUPPRESSION
+  uint32 crc;        // CRC 32 de la clé, de la taille et des données
+} Stockage_Entete;
+
+#define STOCKAGE_SUPPRESSION  0x8000
+#define STOCKAGE_MASQUE_TAILLE 0x7FFF
+#define STOCKAGE_AUCUN        0xFF
+#define STOCKAGE_VIDE         0xFFFF   // champ d'un en-tête jamais écrit
+
+// Zone de flash
+uint16 stockage_premier_secteur = 0;
+uint8 stockage_nb_secteurs = 0;
+
+// Secteurs
+uint8 Etat_Secteur[STOCKAGE_NB_SECTEURS_MAX];
+uint32 Sequence_Secteur[STOCKAGE_NB_SECTEURS_MAX];
+uint32 stockage_sequence = 0;            // séquence du prochain secteur ouvert
+uint8 stockage_actif = STOCKAGE_AUCUN;   // secteur où sont ajoutés les enregistrements
+uint16 stockage_position = 0;            // position d'écriture dans le secteur actif
+
+// Ramasse-miettes
+uint8 gc_secteur = STOCKAGE_AUCUN;
+uint16 gc_position = 0;
+
+// Index : adresse de la valeur courante de chaque clé (0 : pas de valeur)
+uint32 Index_Stockage[STOCKAGE_NB_CLES];
+
+// Buffer aligné d'un enregistrement
+uint32 Tampon_Stockage[(sizeof(Stockage_Entete) + STOCKAGE_TAILLE_MAX) / 4];
+
+Stockage_Statistiques Statistiques_Stockage;
+
+// ##########################################################################################################################
+//                                      FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Adresse_Secteur
+  DESCRIPTION   : Adresse en flash d'un secteur du stockage
+  PARAMETRES    : N° du secteur dans le stockage
+  RETOUR        : Adresse
+===============================================================================*/
+static inline uint32 Adresse_Secteur(uint8 secteur)
+{
+    return (uint32)(stockage_premier_secteur + secteur) * FLASH_TAILLE_SECTEUR;
+}
+
+/*===============================================================================
+  FONCTION      : Taille_Enregistrement
+  DESCRIPTION   : Place occupée en flash par un enregistrement
+  PARAMETRES    : Champ "taille" de l'en-tête
+  RETOUR        : Nombre d'octets (en-tête compris)
+===============================================================================*/
+static inline uint16 Taille_Enregistrement(uint16 taille)
+{
+    return sizeof(Stockage_Entete) + FLASH_ALIGNER(taille & STOCKAGE_MASQUE_TAILLE);
+}
+
+/*===============================================================================
+  FONCTION      : Stockage_CRC
+  DESCRIPTION   : CRC d'un enregistrement préparé dans le tampon
+  PARAMETRES    : rien
+  RETOUR        : CRC
+===============================================================================*/
+static uint32 Stockage_CRC()
+{
+    Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+    uint32 crc = FLASH_CRC32_INIT;
+
+    crc = Flash_CRC32(crc,&entete->cle,sizeof(entete->cle));
+    crc = Flash_CRC32(crc,&entete->taille,sizeof(entete->taille));
+    crc = Flash_CRC32(crc,entete + 1,entete->taille & STOCKAGE_MASQUE_TAILLE);
+    return ~crc;
+}
+
+/*===============================================================================
+  FONCTION      : Lire_Enregistrement
+  DESCRIPTION   : Lit un enregistrement complet dans le tampon et vérifie son CRC
+  PARAMETRES    : Adresse de l'enregistrement, fin de la zone lisible
+  RETOUR        : 1 si valide, 0 si la zone n'a jamais été écrite, -1 si corrompu
+===============================================================================*/
+static int8 Lire_Enregistrement(uint32 adresse, uint32 fin)
+{
+    Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+
+    if (adresse + sizeof(Stockage_Entete) > fin) return 0;
+    if (!Flash_Lire(adresse,entete,sizeof(Stockage_Entete))) return -1;
+    if (entete->cle == STOCKAGE_VIDE && entete->taille == STOCKAGE_VIDE) return 0;
+
+    uint16 taille = entete->taille & STOCKAGE_MASQUE_TAILLE;
+    if (entete->cle >= STOCKAGE_NB_CLES || taille > STOCKAGE_TAILLE_MAX) return -1;
+    if (adresse + Taille_Enregistrement(taille) > fin) return -1;
+    if (taille > 0 && !Flash_Lire(adresse + sizeof(Stockage_Entete),entete + 1,FLASH_ALIGNER(taille))) return -1;
+
+    return (Stockage_CRC() == entete->crc) ? 1 : -1;
+}
+
+/*===============================================================================
+  FONCTION      : Nb_Secteurs_Libres
+  DESCRIPTION   : Nombre de secteurs réutilisables (effacés ou à effacer)
+  PARAMETRES    : rien
+  RETOUR        : Nombre de secteurs
+===============================================================================*/
+static uint8 Nb_Secteurs_Libres()
+{
+    uint8 nb = 0;
+    for (uint8 i = 0; i < stockage_nb_secteurs; i++)
+    {
+        if (Etat_Secteur[i] != SECTEUR_UTILISE) nb++;
+    }
+    return nb;
+}
+
+/*===============================================================================
+  FONCTION      : Effacer_Secteur
+  DESCRIPTION   : Efface un secteur du stockage
+  PARAMETRES    : N° du secteur dans le stockage
+  RETOUR        : false en cas d'erreur flash
+===============================================================================*/
+static bool Effacer_Secteur(uint8 secteur)
+{
+    if (!Flash_Effacer_Secteur(stockage_premier_secteur + secteur)) return false;
+    Etat_Secteur[secteur] = SECTEUR_LIBRE;
+    Statistiques_Stockage.nb_effacements++;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Secteur_Vierge
+  DESCRIPTION   : Vérifie qu'un secteur est entièrement effacé
+  PARAMETRES    : N° du secteur dans le stockage
+  RETOUR        : true si tous les octets sont à 0xFF
+===============================================================================*/
+static bool Secteur_Vierge(uint8 secteur)
+{
+    for (uint32 position = 0; position < FLASH_TAILLE_SECTEUR; position += sizeof(Tampon_Stockage))
+    {
+        uint32 taille = FLASH_TAILLE_SECTEUR - position;
+        if (taille > sizeof(Tampon_Stockage)) taille = sizeof(Tampon_Stockage);
+        if (!Flash_Lire(Adresse_Secteur(secteur) + position,Tampon_Stockage,taille)) return false;
+
+        for (uint32 i = 0; i < taille / 4; i++)
+        {
+            if (Tampon_Stockage[i] != 0xFFFFFFFF) return false;
+        }
+    }
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Ouvrir_Secteur
+  DESCRIPTION   : Choisit le prochain secteur libre (à tour de rôle) et y écrit l'en-tête
+  PARAMETRES    : true pour autoriser l'utilisation du dernier secteur libre
+                  (réservé au ramasse-miettes)
+  RETOUR        : false si aucun secteur n'est disponible
+===============================================================================*/
+static bool Ouvrir_Secteur(bool reserve)
+{
+    Stockage_Entete_Secteur entete;
+    uint8 depart = (stockage_actif == STOCKAGE_AUCUN) ? 0 : stockage_actif + 1;
+
+    if (Nb_Secteurs_Libres() < (reserve ? 1 : 2)) return false;
+
+    for (uint8 n = 0; n < stockage_nb_secteurs; n++)
+    {
+        uint8 secteur = (depart + n) % stockage_nb_secteurs;
+        if (Etat_Secteur[secteur] == SECTEUR_UTILISE) continue;
+        if (Etat_Secteur[secteur] == SECTEUR_A_EFFACER && !Effacer_Secteur(secteur)) continue;
+
+        entete.magique = STOCKAGE_MAGIQUE;
+        entete.sequence = stockage_sequence++;
+        if (!Flash_Ecrire(Adresse_Secteur(secteur),&entete,sizeof(entete)))
+        {
+            Etat_Secteur[secteur] = SECTEUR_A_EFFACER;
+            continue;
+        }
+        Statistiques_Stockage.octets_ecrits += sizeof(entete);
+
+        Etat_Secteur[secteur] = SECTEUR_UTILISE;
+        Sequence_Secteur[secteur] = entete.sequence;
+        stockage_actif = secteur;
+        stockage_position = sizeof(entete);
+        return true;
+    }
+    return false;
+}
+
+/*===============================================================================
+  FONCTION      : Ajouter_Enregistrement
+  DESCRIPTION   : Ajoute au journal l'enregistrement préparé dans le tampon
+                  et met à jour l'index
+  PARAMETRES    : true pour autoriser l'utilisation du dernier secteur libre
+  RETOUR        : false si la flash est pleine ou en cas d'erreur flash
+===============================================================================*/
+static bool Ajouter_Enregistrement(bool reserve)
+{
+    Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+    uint16 taille = Taille_Enregistrement(entete->taille);
+    uint32 adresse;
+
+    if (stockage_actif == STOCKAGE_AUCUN || stockage_position + taille > FLASH_TAILLE_SECTEUR)
+    {
+        if (!Ouvrir_Secteur(reserve)) return false;
+    }
+
+    adresse = Adresse_Secteur(stockage_actif) + stockage_position;
+    if (!Flash_Ecrire(adresse,Tampon_Stockage,taille))
+    {
+        // zone inutilisable : le secteur est considéré comme plein
+        stockage_position = FLASH_TAILLE_SECTEUR;
+        return false;
+    }
+    stockage_position += taille;
+    Statistiques_Stockage.octets_ecrits += taille;
+
+    Index_Stockage[entete->cle] = (entete->taille & STOCKAGE_SUPPRESSION) ? 0 : adresse;
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Preparer_Enregistrement
+  DESCRIPTION   : Prépare un enregistrement dans le tampon
+  PARAMETRES    : Clé, champ taille, données, taille des données
+  RETOUR        : rien
+===============================================================================*/
+static void Preparer_Enregistrement(uint16 cle, uint16 champ_taille, const void *donnees, uint16 taille)
+{
+    Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+    uint8 *zone = (uint8 *)(entete + 1);
+
+    entete->cle = cle;
+    entete->taille = champ_taille;
+    if (taille > 0) memcpy(zone,donnees,taille);
+    memset(zone + taille,0xFF,FLASH_ALIGNER(taille) - taille);
+    entete->crc = Stockage_CRC();
+}
+
+// ##########################################################################################################################
+//                                      FONCTIONS STOCKAGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Stockage
+  DESCRIPTION   : Monte le stockage sur une zone de la flash : relit le journal
+                  et reconstruit l'index en RAM (une zone vierge est formatée au fil de l'eau)
+  PARAMETRES    : N° du premier secteur, nombre de secteurs (3 à STOCKAGE_NB_SECTEURS_MAX)
+  RETOUR        : false si les paramètres sont invalides ou en cas d'erreur flash
+===============================================================================*/
+bool init_Stockage(uint16 premier_secteur, uint8 nb_secteurs)
+{
+    uint8 ordre[STOCKAGE_NB_SECTEURS_MAX];
+    uint8 nb_utilises = 0;
+
+    if (nb_secteurs < STOCKAGE_SECTEURS_LIBRES_MIN + 1 || nb_secteurs > STOCKAGE_NB_SECTEURS_MAX) return false;
+
+    stockage_premier_secteur = premier_secteur;
+    stockage_nb_secteurs = nb_secteurs;
+    stockage_actif = STOCKAGE_AUCUN;
+    stockage_position = 0;
+    stockage_sequence = 0;
+    gc_secteur = STOCKAGE_AUCUN;
+    memset(Index_Stockage,0,sizeof(Index_Stockage));
+    memset(&Statistiques_Stockage,0,sizeof(Statistiques_Stockage));
+
+    // Etape 1 : état de chaque secteur, tri des secteurs utilisés par séquence
+    for (uint8 i = 0; i < nb_secteurs; i++)
+    {
+        Stockage_Entete_Secteur entete;
+        if (!Flash_Lire(Adresse_Secteur(i),&entete,sizeof(entete))) return false;
+
+        if (entete.magique == STOCKAGE_MAGIQUE && entete.sequence != 0xFFFFFFFF)
+        {
+            uint8 j = nb_utilises++;
+            Etat_Secteur[i] = SECTEUR_UTILISE;
+            Sequence_Secteur[i] = entete.sequence;
+            while (j > 0 && Sequence_Secteur[ordre[j - 1]] > entete.sequence)
+            {
+                ordre[j] = ordre[j - 1];
+                j--;
+            }
+            ordre[j] = i;
+            if (entete.sequence >= stockage_sequence) stockage_sequence = entete.sequence + 1;
+        }
+        else
+        {
+            // secteur vierge, ou effacement interrompu
+            Etat_Secteur[i] = Secteur_Vierge(i) ? SECTEUR_LIBRE : SECTEUR_A_EFFACER;
+        }
+    }
+
+    // Etape 2 : relecture du journal, du secteur le plus ancien au plus récent
+    for (uint8 n = 0; n < nb_utilises; n++)
+    {
+        uint8 secteur = ordre[n];
+        uint32 fin = Adresse_Secteur(secteur) + FLASH_TAILLE_SECTEUR;
+        uint16 position = sizeof(Stockage_Entete_Secteur);
+        int8 resultat;
+
+        while ((resultat = Lire_Enregistrement(Adresse_Secteur(secteur) + position,fin)) == 1)
+        {
+            Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+            Index_Stockage[entete->cle] = (entete->taille & STOCKAGE_SUPPRESSION) ? 0 : Adresse_Secteur(secteur) + position;
+            position += Taille_Enregistrement(entete->taille);
+        }
+
+        // enregistrement corrompu (coupure pendant une écriture) : la suite du secteur n'est plus utilisée
+        if (resultat < 0)
+        {
+            Statistiques_Stockage.nb_erreurs_crc++;
+            position = FLASH_TAILLE_SECTEUR;
+        }
+
+        // le secteur le plus récent reste le secteur actif
+        stockage_actif = secteur;
+        stockage_position = position;
+    }
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Stockage_Ecrire
+  DESCRIPTION   : Enregistre la valeur d'une clé
+  (une valeur identique à la valeur courante n'est pas réécrite)
+  PARAMETRES    : Clé, données, taille (STOCKAGE_TAILLE_MAX au maximum)
+  RETOUR        : false si la clé est invalide, si la flash est pleine
+                  (appeler Stockage_Tache) ou en cas d'erreur flash
+===============================================================================*/
+bool Stockage_Ecrire(uint16 cle, const void *donnees, uint16 taille)
+{
+    if (cle >= STOCKAGE_NB_CLES || taille > STOCKAGE_TAILLE_MAX || stockage_nb_secteurs == 0) return false;
+
+    // valeur inchangée : aucune écriture
+    if (Index_Stockage[cle] != 0 && Lire_Enregistrement(Index_Stockage[cle],Index_Stockage[cle] + Taille_Enregistrement(STOCKAGE_TAILLE_MAX)) == 1)
+    {
+        Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+        if (entete->taille == taille && memcmp(entete + 1,donnees,taille) == 0)
+        {
+            Statistiques_Stockage.nb_ecritures_evitees++;
+            return true;
+        }
+    }
+
+    Statistiques_Stockage.octets_demandes += taille;
+    Preparer_Enregistrement(cle,taille,donnees,taille);
+    return Ajouter_Enregistrement(false);
+}
+
+/*===============================================================================
+  FONCTION      : Stockage_Lire
+  DESCRIPTION   : Lit la valeur courante d'une clé
+  PARAMETRES    : Clé, buffer, taille du buffer
+  RETOUR        : Taille de la valeur, -1 si la clé n'existe pas ou si la valeur est corrompue
+                  (seuls les "taille du buffer" premiers octets sont copiés)
+===============================================================================*/
+int16 Stockage_Lire(uint16 cle, void *buffer, uint16 taille_buffer)
+{
+    Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+    uint32 adresse;
+
+    if (cle >= STOCKAGE_NB_CLES || Index_Stockage[cle] == 0) return -1;
+
+    adresse = Index_Stockage[cle];
+    if (Lire_Enregistrement(adresse,adresse + Taille_Enregistrement(STOCKAGE_TAILLE_MAX)) != 1) return -1;
+
+    memcpy(buffer,entete + 1,(entete->taille < taille_buffer) ? entete->taille : taille_buffer);
+    return entete->taille;
+}
+
+/*===============================================================================
+  FONCTION      : Stockage_Existe
+  DESCRIPTION   : Indique si une clé a une valeur (O(1), sans accès à la flash)
+  PARAMETRES    : Clé
+  RETOUR        : true si la clé existe
+===============================================================================*/
+bool Stockage_Existe(uint16 cle)
+{
+    return cle < STOCKAGE_NB_CLES && Index_Stockage[cle] != 0;
+}
+
+/*===============================================================================
+  FONCTION      : Stockage_Supprimer
+  DESCRIPTION   : Supprime une clé
+  PARAMETRES    : Clé
+  RETOUR        : false si la flash est pleine ou en cas d'erreur flash
+===============================================================================*/
+bool Stockage_Supprimer(uint16 cle)
+{
+    if (!Stockage_Existe(cle)) return true;
+
+    Preparer_Enregistrement(cle,STOCKAGE_SUPPRESSION,NULL,0);
+    return Ajouter_Enregistrement(false);
+}
+
+/*===============================================================================
+  FONCTION      : Stockage_Tache
+  DESCRIPTION   : Fait avancer le ramasse-miettes d'une étape
+                  (recopie de quelques enregistrements, ou effacement d'un secteur)
+  /!\ l'étape d'effacement bloque plusieurs dizaines de ms : appeler hors des tâches à temps critique
+  PARAMETRES    : rien
+  RETOUR        : true si le ramasse-miettes est en cours
+===============================================================================*/
+bool Stockage_Tache()
+{
+    if (stockage_nb_secteurs == 0) return false;
+
+    // -------------------------
+    // Démarrage : secteurs à effacer, puis secteur le plus ancien
+    // -------------------------
+    if (gc_secteur == STOCKAGE_AUCUN)
+    {
+        for (uint8 i = 0; i < stockage_nb_secteurs; i++)
+        {
+            if (Etat_Secteur[i] == SECTEUR_A_EFFACER)
+            {
+                Effacer_Secteur(i);
+                return true;
+            }
+        }
+
+        if (Nb_Secteurs_Libres() >= STOCKAGE_SECTEURS_LIBRES_MIN) return false;
+
+        for (uint8 i = 0; i < stockage_nb_secteurs; i++)
+        {
+            if (Etat_Secteur[i] != SECTEUR_UTILISE || i == stockage_actif) continue;
+            if (gc_secteur == STOCKAGE_AUCUN || Sequence_Secteur[i] < Sequence_Secteur[gc_secteur]) gc_secteur = i;
+        }
+        gc_position = sizeof(Stockage_Entete_Secteur);
+        return gc_secteur != STOCKAGE_AUCUN;
+    }
+
+    // -------------------------
+    // Recopie des valeurs courantes du secteur
+    // -------------------------
+    for (uint8 n = 0; n < STOCKAGE_ENREGISTREMENTS_PAR_ETAPE; n++)
+    {
+        uint32 adresse = Adresse_Secteur(gc_secteur) + gc_position;
+        Stockage_Entete *entete = (Stockage_Entete *)Tampon_Stockage;
+
+        if (Lire_Enregistrement(adresse,Adresse_Secteur(gc_secteur) + FLASH_TAILLE_SECTEUR) != 1)
+        {
+            // fin du secteur : toutes les valeurs courantes ont été recopiées
+            Effacer_Secteur(gc_secteur);
+            gc_secteur = STOCKAGE_AUCUN;
+            return true;
+        }
+
+        // seule la valeur courante d'une clé est recopiée
+        // (une suppression du secteur le plus ancien n'a plus de valeur plus ancienne à masquer)
+        if (Index_Stockage[entete->cle] == adresse)
+        {
+            if (!Ajouter_Enregistrement(true)) return true; // flash pleine : nouvel essai à l'étape suivante
+            Statistiques_Stockage.nb_recopies++;
+        }
+        gc_position += Taille_Enregistrement(entete->taille);
+    }
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : Stockage_Lire_Statistiques
+  DESCRIPTION   : Compteurs d'usure et d'amplification d'écriture
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Stockage_Statistiques *Stockage_Lire_Statistiques()
+{
+    return &Statistiques_Stockage;
+}
@@ -0,0 +1,132 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Stockage_Flash.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Stockage clé / valeur en flash, avec répartition de l'usure (configuration, données persistantes)
+ *
+ *  Au lieu de réécrire un secteur complet à chaque modification, chaque valeur est ajoutée à la suite
+ *  d'un journal réparti sur plusieurs secteurs :
+ *  - un enregistrement = en-tête (clé, taille, CRC 32) + données, aligné sur 4 octets
+ *  - la dernière version d'une clé est la valeur courante (une suppression est un enregistrement vide)
+ *  - un index en RAM donne l'adresse de la valeur courante de chaque clé : lecture en O(1)
+ *  - le ramasse-miettes recopie les valeurs encore valides du secteur le plus ancien puis l'efface ;
+ *    il avance par petites étapes (Stockage_Tache), appelées depuis la boucle principale ou le scheduler
+ *  - tous les secteurs sont utilisés à tour de rôle : l'usure est répartie
+ *
+ *  Coupure d'alimentation : un enregistrement incomplet a un CRC faux et est ignoré au démarrage ;
+ *  un secteur dont l'effacement a été interrompu est effacé à nouveau avant d'être réutilisé.
+ *
+ *  /!\ Les clés sont des numéros (0 à STOCKAGE_NB_CLES - 1), à définir par l'application
+ *  /!\ La zone de flash utilisée ne doit contenir ni le programme ni le système de fichiers
+ * =============================================================================================================================================
+ */
+
+#ifndef __STOCKAGE_FLASH_H__
+#define __STOCKAGE_FLASH_H__
+
+// Dépendance(s)
+#include "Flash_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre de clés (taille de l'index en RAM : 4 octets par clé)
+#define STOCKAGE_NB_CLES 128
+
+// Taille maximale d'une valeur (octets)
+#define STOCKAGE_TAILLE_MAX 256
+
+// Nombre maximal de secteurs gérés
+#define STOCKAGE_NB_SECTEURS_MAX 16
+
+// Nombre de secteurs effacés à conserver (le ramasse-miettes démarre en dessous)
+#define STOCKAGE_SECTEURS_LIBRES_MIN 2
+
+// Nombre d'enregistrements traités par étape du ramasse-miettes
+#define STOCKAGE_ENREGISTREMENTS_PAR_ETAPE 4
+
+// Identification d'un secteur du stockage
+#define STOCKAGE_MAGIQUE 0x3153564B // "KVS1"
+
+// Statistiques (usure et amplification d'écriture)
+typedef struct{
+  uint32 octets_demandes;      // octets de données écrits par l'application
+  uint32 octets_ecrits;        // octets réellement écrits en flash (en-têtes et recopies inclus)
+  uint32 nb_effacements;       // secteurs effacés
+  uint32 nb_ecritures_evitees; // écritures d'une valeur identique à la valeur courante
+  uint32 nb_recopies;          // enregistrements recopiés par le ramasse-miettes
+  uint32 nb_erreurs_crc;       // enregistrements corrompus ignorés au démarrage
+} Stockage_Statistiques;
+
+// ##########################################################################################################################
+//                                      FONCTIONS STOCKAGE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_Stockage
+  DESCRIPTION   : Monte le stockage sur une zone de la flash : relit le journal
+                  et reconstruit l'index en RAM (une zone vierge est formatée au fil de l'eau)
+  PARAMETRES    : N° du premier secteur, nombre de secteurs (3 à STOCKAGE_NB_SECTEURS_MAX)
+  RETOUR        : false si les paramètres sont invalides ou en cas d'erreur flash
+===============================================================================*/
+bool init_Stockage(uint16 premier_secteur, uint8 nb_secteurs);
+
+/*===============================================================================
+  FONCTION      : Stockage_Ecrire
+  DESCRIPTION   : Enregistre la valeur d'une clé
+  (une valeur identique à la valeur courante n'est pas réécrite)
+  PARAMETRES    : Clé, données, taille (STOCKAGE_TAILLE_MAX au maximum)
+  RETOUR        : false si la clé est invalide, si la flash est pleine
+                  (appeler Stockage_Tache) ou en cas d'erreur flash
+===============================================================================*/
+bool Stockage_Ecrire(uint16 cle, const void *donnees, uint16 taille);
+
+/*===============================================================================
+  FONCTION      : Stockage_Lire
+  DESCRIPTION   : Lit la valeur courante d'une clé
+  PARAMETRES    : Clé, buffer, taille du buffer
+  RETOUR        : Taille de la valeur, -1 si la clé n'existe pas ou si la valeur est corrompue
+                  (seuls les "taille du buffer" premiers octets sont copiés)
+===============================================================================*/
+int16 Stockage_Lire(uint16 cle, void *buffer, uint16 taille_buffer);
+
+/*===============================================================================
+  FONCTION      : Stockage_Existe
+  DESCRIPTION   : Indique si une clé a une valeur (O(1), sans accès à la flash)
+  PARAMETRES    : Clé
+  RETOUR        : true si la clé existe
+===============================================================================*/
+bool Stockage_Existe(uint16 cle);
+
+/*===============================================================================
+  FONCTION      : Stockage_Supprimer
+  DESCRIPTION   : Supprime une clé
+  PARAMETRES    : Clé
+  RETOUR        : false si la flash est pleine ou en cas d'erreur flash
+===============================================================================*/
+bool Stockage_Supprimer(uint16 cle);
+
+/*===============================================================================
+  FONCTION      : Stockage_Tache
+  DESCRIPTION   : Fait avancer le ramasse-miettes d'une étape
+                  (recopie de quelques enregistrements, ou effacement d'un secteur)
+  /!\ l'étape d'effacement bloque plusieurs dizaines de ms : appeler hors des tâches à temps critique
+  PARAMETRES    : rien
+  RETOUR        : true si le ramasse-miettes est en cours
+===============================================================================*/
+bool Stockage_Tache();
+
+/*===============================================================================
+  FONCTION      : Stockage_Lire_Statistiques
+  DESCRIPTION   : Compteurs d'usure et d'amplification d'écriture
+  PARAMETRES    : rien
+  RETOUR        : Statistiques
+===============================================================================*/
+const Stockage_Statistiques *Stockage_Lire_Statistiques();
+
+#endif
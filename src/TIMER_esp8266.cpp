@@ -1,76 +1,128 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : TIMER_esp8266.cpp
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Ensemble des définitions nécessaires pour manipuler les TIMER des ESP8266
- * 
- *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
- * =============================================================================================================================================
- */
-#include "TIMER_esp8266.h"
-
-/*===============================================================================
-  FONCTION      : init_TIMER1
-  DESCRIPTION   : initialise le TIMER1
-  PARAMETRES    : Fréquence du Timer voulue, Prédivision requise (1,16 ou 256)
-  RETOUR        : rien   
-===============================================================================*/
-void init_TIMER1(uint32 Frequence_Hz,TIMER_ClkDiv Prediviseur)
-{
-    uint16 Val_Prediviseur;
-    uint32 Val_Compteur;
-
-    // Avant toute chose, on s'assure que le timer est désactivé
-    disable_TIMER1();
-
-    // 1 - Choix du prédiviseur à appliquer
-    switch(Prediviseur)
-    {
-        case DIV1   : Val_Prediviseur = 1  ; break; //80MHz (80 ticks/us - 104857.588 us max)
-        case DIV16  : Val_Prediviseur = 16 ; break; //5MHz (5 ticks/us - 1677721.4 us max)
-        case DIV256 : Val_Prediviseur = 256; break; //312.5Khz (1 tick = 3.2us - 26843542.4 us max)
-        default :     Val_Prediviseur = 1  ; break; // par défaut, pas de prédivision
-    }
-    Set_buffer_to_Registre(&Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_DIV, Prediviseur,2);
-
-    //Activation du timer
-    enable_TIMER1();
-
-    //Activation du mode AutoReload
-    SET_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_RELOAD);
-
-    // Définition de la valeur de départ du compteur (calculée selon la fréquence voulue)
-    Val_Compteur = (ESP8266_CLOCK_FREQ / (Val_Prediviseur*Frequence_Hz)) ;
-    Set_buffer_to_Registre(&Registre_TIMER1->LOAD_ADDRESS,0,Val_Compteur,23);
-
-    //Activation des paramètres liés à l'interruption du timer
-    CLR_BIT(Registre_TIMER1->INT_ADDRESS,BIT_TIMER_INT_CLR);
-    SET_BIT(Registre_TIMER1_INT->EDGE_ENABLE,1); // Activation de l'interruption type Edge
-}
-
-/*===============================================================================
-  FONCTION      : enable_TIMER1
-  DESCRIPTION   : active le TIMER1
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
-void enable_TIMER1()
-{
-    SET_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN);
-}
-
-/*===============================================================================
-  FONCTION      : enable_TIMER1
-  DESCRIPTION   : active le TIMER1
-  PARAMETRES    : aucun
-  RETOUR        : rien   
-===============================================================================*/
-void disable_TIMER1()
-{
-    CLR_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN);
-}
-
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : TIMER_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Ensemble des définitions nécessaires pour manipuler les TIMER des ESP8266
+ * 
+ *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
+ * =============================================================================================================================================
+ */
+#include "TIMER_esp8266.h"
+
+/*===============================================================================
+  FONCTION      : init_TIMER1
+  DESCRIPTION   : initialise le TIMER1
+  PARAMETRES    : Fréquence du Timer voulue, Prédivision requise (1,16 ou 256)
+  RETOUR        : rien   
+===============================================================================*/
+void init_TIMER1(uint32 Frequence_Hz,TIMER_ClkDiv Prediviseur)
+{
+    uint16 Val_Prediviseur;
+    uint32 Val_Compteur;
+
+    // Avant toute chose, on s'assure que le timer est désactivé
+    disable_TIMER1();
+
+    // 1 - Choix du prédiviseur à appliquer
+    switch(Prediviseur)
+    {
+        case DIV1   : Val_Prediviseur = 1  ; break; //80MHz (80 ticks/us - 104857.588 us max)
+        case DIV16  : Val_Prediviseur = 16 ; break; //5MHz (5 ticks/us - 1677721.4 us max)
+        case DIV256 : Val_Prediviseur = 256; break; //312.5Khz (1 tick = 3.2us - 26843542.4 us max)
+        default :     Val_Prediviseur = 1  ; break; // par défaut, pas de prédivision
+    }
+    Set_buffer_to_Registre(&Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_DIV, Prediviseur,2);
+
+    //Activation du timer
+    enable_TIMER1();
+
+    //Activation du mode AutoReload
+    REGISTRE_SET_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_RELOAD);
+
+    // Définition de la valeur de départ du compteur (calculée selon la fréquence voulue)
+    Val_Compteur = (ESP8266_CLOCK_FREQ / (Val_Prediviseur*Frequence_Hz)) ;
+    Set_buffer_to_Registre(&Registre_TIMER1->LOAD_ADDRESS,0,Val_Compteur,23);
+
+    //Activation des paramètres liés à l'interruption du timer
+    REGISTRE_CLR_BIT(Registre_TIMER1->INT_ADDRESS,BIT_TIMER_INT_CLR);
+    REGISTRE_SET_BIT(Registre_TIMER1_INT->EDGE_ENABLE,BIT_TIMER1_EDGE); // Activation de l'interruption type Edge
+}
+
+/*===============================================================================
+  FONCTION      : init_TIMER1_MonoCoup
+  DESCRIPTION   : initialise le TIMER1 en mode "monocoup" (sans rechargement automatique)
+  Le timer reste arrêté jusqu'au premier appel de TIMER1_Armer
+  PARAMETRES    : Prédivision requise (1,16 ou 256)
+  RETOUR        : rien   
+===============================================================================*/
+void init_TIMER1_MonoCoup(TIMER_ClkDiv Prediviseur)
+{
+    // Avant toute chose, on s'assure que le timer est désactivé
+    disable_TIMER1();
+
+    // Choix du prédiviseur à appliquer
+    Set_buffer_to_Registre(&Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_DIV, Prediviseur,2);
+
+    // Désactivation du mode AutoReload
+    REGISTRE_CLR_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_RELOAD);
+
+    //Activation des paramètres liés à l'interruption du timer
+    REGISTRE_CLR_BIT(Registre_TIMER1->INT_ADDRESS,BIT_TIMER_INT_CLR);
+    REGISTRE_SET_BIT(Registre_TIMER1_INT->EDGE_ENABLE,BIT_TIMER1_EDGE); // Activation de l'interruption type Edge
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Armer
+  DESCRIPTION   : (re)charge le TIMER1 : l'interruption se déclenchera 
+                  après le nombre de ticks indiqué
+  (écriture directe du registre : fonction appelée depuis les interruptions)
+  PARAMETRES    : Nombre de ticks avant l'interruption (1 à TIMER1_MAX_TICKS)
+  RETOUR        : rien   
+===============================================================================*/
+void ICACHE_RAM_ATTR TIMER1_Armer(uint32 Nb_ticks)
+{
+    if (Nb_ticks == 0) Nb_ticks = 1;
+    if (Nb_ticks > TIMER1_MAX_TICKS) Nb_ticks = TIMER1_MAX_TICKS;
+
+    // L'écriture de LOAD_ADDRESS recharge immédiatement le compteur
+    REGISTRE_ECRIRE(Registre_TIMER1->LOAD_ADDRESS,Nb_ticks);
+    REGISTRE_SET_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN);
+}
+
+/*===============================================================================
+  FONCTION      : TIMER1_Lire_Compteur
+  DESCRIPTION   : Lit la valeur courante du TIMER1 (compteur décrémental)
+  PARAMETRES    : aucun
+  RETOUR        : Valeur du compteur (23 bits)
+===============================================================================*/
+uint32 ICACHE_RAM_ATTR TIMER1_Lire_Compteur()
+{
+    return REGISTRE_LIRE(Registre_TIMER1->COUNT_ADDRESS) & TIMER1_MAX_TICKS;
+}
+
+/*===============================================================================
+  FONCTION      : enable_TIMER1
+  DESCRIPTION   : active le TIMER1
+  PARAMETRES    : aucun
+  RETOUR        : rien   
+===============================================================================*/
+void enable_TIMER1()
+{
+    REGISTRE_SET_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN);
+}
+
+/*===============================================================================
+  FONCTION      : enable_TIMER1
+  DESCRIPTION   : active le TIMER1
+  PARAMETRES    : aucun
+  RETOUR        : rien   
+===============================================================================*/
+void disable_TIMER1()
+{
+    REGISTRE_CLR_BIT(Registre_TIMER1->CTRL_ADDRESS,BIT_TIMER_EN);
+}
+
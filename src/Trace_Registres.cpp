@@ -0,0 +1,187 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Trace_Registres.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Traçage des accès aux registres matériels, pour profiler les drivers
+ *  (voir Trace_Registres.h pour le format de la trace)
+ * =============================================================================================================================================
+ */
+
+#include "Trace_Registres.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+Trace_Entree Trace_Registres[NB_TRACE_REGISTRES];
+volatile uint16 trace_nb_entrees = 0;
+volatile uint32 trace_nb_perdues = 0;     // accès non enregistrés (trace pleine)
+volatile bool trace_active = false;
+uint32 trace_date_precedente = 0;         // cycles CPU
+
+// ##########################################################################################################################
+//                                      FONCTIONS TRACE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Trace_Enregistrer
+  DESCRIPTION   : Ajoute un accès à la trace
+  PARAMETRES    : Registre, valeur, true pour une écriture
+  RETOUR        : rien
+===============================================================================*/
+static void ICACHE_RAM_ATTR Trace_Enregistrer(__Registre *Registre, uint32 valeur, bool ecriture)
+{
+    uint32 adresse = (uint32)(uintptr_t)Registre;
+    uint32 maintenant, delai, etat;
+
+    if (!trace_active) return;
+
+    // les drivers accèdent aux registres sous interruption : section critique imbricable
+    // (ETS_INTR_UNLOCK rétablirait les interruptions au milieu de l'interruption tracée)
+    etat = Masquer_Interruptions();
+
+    if (trace_nb_entrees >= NB_TRACE_REGISTRES)
+    {
+        trace_nb_perdues++;
+        Restaurer_Interruptions(etat);
+        return;
+    }
+
+    maintenant = Lire_Compteur_Cycles();
+    delai = (maintenant - trace_date_precedente) / (ESP8266_CLOCK_FREQ / 1000000);
+    trace_date_precedente = maintenant;
+
+    Trace_Entree *entree = &Trace_Registres[trace_nb_entrees++];
+    entree->registre = (adresse & TRACE_MASQUE_DECALAGE)
+                     | (((adresse & 0xFFF00000) == TRACE_ZONE_DPORT) << BIT_TRACE_DPORT)
+                     | (ecriture << BIT_TRACE_ECRITURE);
+    entree->delai = (delai > 0xFFFF) ? 0xFFFF : delai;
+    entree->valeur = valeur;
+
+    Restaurer_Interruptions(etat);
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Lecture_Registre
+  DESCRIPTION   : Lit un registre et enregistre l'accès dans la trace
+  (utilisée par REGISTRE_LIRE lorsque TRACE_REGISTRES est défini)
+  PARAMETRES    : Registre ciblé
+  RETOUR        : Valeur lue
+===============================================================================*/
+uint32 ICACHE_RAM_ATTR Trace_Lecture_Registre(__Registre *Registre)
+{
+    uint32 valeur = *(volatile __Registre *)Registre;
+    Trace_Enregistrer(Registre,valeur,false);
+    return valeur;
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Ecriture_Registre
+  DESCRIPTION   : Ecrit un registre et enregistre l'accès dans la trace
+  (utilisée par REGISTRE_ECRIRE lorsque TRACE_REGISTRES est défini)
+  PARAMETRES    : Registre ciblé, valeur à écrire
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Trace_Ecriture_Registre(__Registre *Registre, uint32 valeur)
+{
+    *(volatile __Registre *)Registre = valeur;
+    Trace_Enregistrer(Registre,valeur,true);
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Demarrer
+  DESCRIPTION   : Vide la trace et démarre l'enregistrement
+  (l'enregistrement s'arrête lorsque la trace est pleine)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Trace_Registres_Demarrer()
+{
+    uint32 etat = Masquer_Interruptions();
+    trace_nb_entrees = 0;
+    trace_nb_perdues = 0;
+    trace_date_precedente = Lire_Compteur_Cycles();
+    trace_active = true;
+    Restaurer_Interruptions(etat);
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Arreter
+  DESCRIPTION   : Arrête l'enregistrement (la trace est conservée)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Trace_Registres_Arreter()
+{
+    trace_active = false;
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Nombre
+  DESCRIPTION   : Nombre d'entrées enregistrées
+  PARAMETRES    : rien
+  RETOUR        : Nombre d'entrées
+===============================================================================*/
+uint16 Trace_Registres_Nombre()
+{
+    return trace_nb_entrees;
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Entree
+  DESCRIPTION   : Accès à une entrée de la trace
+  PARAMETRES    : N° de l'entrée
+  RETOUR        : Entrée, NULL si le n° est hors de la trace
+===============================================================================*/
+const Trace_Entree *Trace_Registres_Entree(uint16 index)
+{
+    if (index >= trace_nb_entrees) return NULL;
+    return &Trace_Registres[index];
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Envoyer_Octets
+  DESCRIPTION   : Envoie des octets bruts (sans traitement des retours à la ligne)
+  PARAMETRES    : N° de l'UART, données, nombre d'octets
+  RETOUR        : rien
+===============================================================================*/
+static void Trace_Envoyer_Octets(uint8 UART, const void *donnees, uint32 taille)
+{
+    const uint8 *octets = (const uint8 *)donnees;
+    for (uint32 i = 0; i < taille; i++)
+    {
+        UART_send_tx(UART,octets[i]);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Envoyer
+  DESCRIPTION   : Envoie la trace (format binaire) sur une UART
+  L'enregistrement est suspendu pendant l'envoi (les accès à l'UART ne sont pas tracés)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : rien
+===============================================================================*/
+void Trace_Registres_Envoyer(uint8 UART)
+{
+    bool etait_active = trace_active;
+    uint16 nb_entrees = trace_nb_entrees;
+    uint16 reserve = 0;
+    uint32 nb_perdues = trace_nb_perdues;
+
+    trace_active = false;
+
+    // En-tête (little endian, comme l'ESP8266)
+    Trace_Envoyer_Octets(UART,"TRG1",4);
+    Trace_Envoyer_Octets(UART,&nb_entrees,sizeof(nb_entrees));
+    Trace_Envoyer_Octets(UART,&reserve,sizeof(reserve));
+    Trace_Envoyer_Octets(UART,&nb_perdues,sizeof(nb_perdues));
+
+    // Entrées
+    Trace_Envoyer_Octets(UART,Trace_Registres,(uint32)nb_entrees * sizeof(Trace_Entree));
+
+    trace_active = etait_active;
+}
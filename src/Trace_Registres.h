@@ -0,0 +1,112 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : Trace_Registres.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Traçage des accès aux registres matériels, pour profiler les drivers
+ *
+ *  Avec l'option de compilation TRACE_REGISTRES (-DTRACE_REGISTRES, pour toute la librairie),
+ *  chaque accès fait avec les macros REGISTRE_xxx (et donc par Set_buffer_to_Registre / Get_buffer_from_Registre)
+ *  est enregistré : adresse, valeur, lecture ou écriture, date.
+ *  Sans l'option, les macros sont des accès directs et ce module n'enregistre rien.
+ *
+ *  /!\ Le traçage ralentit chaque accès (~1us) : les protocoles à temps critique
+ *      (SoftUART, 1-Wire, WS2812) peuvent ne plus fonctionner pendant une capture.
+ *
+ *  Format d'une entrée (8 octets, little endian) :
+ *      uint16 registre : bits 0-12 : décalage dans la zone (0x60000000 ou 0x3FF00000)
+ *                        bit 13    : zone 0x3FF00000
+ *                        bit 15    : écriture (0 : lecture)
+ *      uint16 delai    : temps écoulé depuis l'entrée précédente (us, saturé à 65535)
+ *      uint32 valeur   : valeur lue ou écrite
+ *
+ *  Format de la trace envoyée par UART (Trace_Registres_Envoyer) :
+ *      "TRG1", uint16 nombre d'entrées, uint16 réservé (0), uint32 nombre d'entrées perdues, entrées
+ *
+ *  L'outil extras/trace_registres (à compiler sur PC) résume une trace (registres les plus utilisés,
+ *  écritures redondantes) et la rejoue sur un modèle des registres pour comparer deux captures.
+ * =============================================================================================================================================
+ */
+
+#ifndef __TRACE_REGISTRES_H__
+#define __TRACE_REGISTRES_H__
+
+// Dépendance(s)
+#include "registres_esp8266.h"
+#include "UART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre d'entrées de la trace (8 octets chacune)
+#ifndef NB_TRACE_REGISTRES
+  #define NB_TRACE_REGISTRES 1024
+#endif
+
+// Zones d'adresses des registres
+#define TRACE_ZONE_PERIPH     0x60000000
+#define TRACE_ZONE_DPORT      0x3FF00000
+#define TRACE_MASQUE_DECALAGE 0x1FFF
+
+// Champ "registre" d'une entrée
+#define BIT_TRACE_DPORT    13
+#define BIT_TRACE_ECRITURE 15
+
+// Entrée de la trace
+typedef struct{
+  uint16 registre;
+  uint16 delai;
+  uint32 valeur;
+} Trace_Entree;
+
+// ##########################################################################################################################
+//                                      FONCTIONS TRACE
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Demarrer
+  DESCRIPTION   : Vide la trace et démarre l'enregistrement
+  (l'enregistrement s'arrête lorsque la trace est pleine)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Trace_Registres_Demarrer();
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Arreter
+  DESCRIPTION   : Arrête l'enregistrement (la trace est conservée)
+  PARAMETRES    : rien
+  RETOUR        : rien
+===============================================================================*/
+void Trace_Registres_Arreter();
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Nombre
+  DESCRIPTION   : Nombre d'entrées enregistrées
+  PARAMETRES    : rien
+  RETOUR        : Nombre d'entrées
+===============================================================================*/
+uint16 Trace_Registres_Nombre();
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Entree
+  DESCRIPTION   : Accès à une entrée de la trace
+  PARAMETRES    : N° de l'entrée
+  RETOUR        : Entrée, NULL si le n° est hors de la trace
+===============================================================================*/
+const Trace_Entree *Trace_Registres_Entree(uint16 index);
+
+/*===============================================================================
+  FONCTION      : Trace_Registres_Envoyer
+  DESCRIPTION   : Envoie la trace (format binaire) sur une UART
+  L'enregistrement est suspendu pendant l'envoi (les accès à l'UART ne sont pas tracés)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : rien
+===============================================================================*/
+void Trace_Registres_Envoyer(uint8 UART);
+
+#endif
@@ -1,157 +1,418 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : UART_esp8266.cpp
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Ensemble des définitions nécessaires pour manipuler les liaisons UART des ESP8266
- * 
- *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
- * =============================================================================================================================================
- */
-
-// Librairies
-#include "UART_esp8266.h"
-
-/*===============================================================================
-  FONCTION      : init_UART
-  DESCRIPTION   : initialise la liaison série UART voulue
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  Vitesse de communication (Bauds)
-                  Nombre de bits de données (5,6,7 ou 8)
-                  Parité (Aucune, Even, Odd)
-                  Nombre de bits de stop (0,1,1.5 ou 2)
-  RETOUR        : rien   
-===============================================================================*/
-void init_UART(uint8 UART, uint32 Bauds,UART_BitData Nb_BitData, UART_Parite Parite, UART_BitStop Nb_BitStop)
-{
-    uint32 clk_div = ESP8266_CLOCK_FREQ / Bauds ;
-    switch(UART)
-    {
-        case UART0 :
-            // Etape 1 : choix des fonctions uart
-            Choix_fonction_GPIO(GPIO1,GPIO_FONCTION_1); // TX
-            Choix_fonction_GPIO(GPIO3,GPIO_FONCTION_1); // RX 
-
-            // Etape 2 : paramétrage de la com'
-            // Parité
-            Set_buffer_to_Registre(&Registre_UART0->CONF0,BIT_UART_PARITY,Parite,2);
-
-            // Nombre de données
-            Set_buffer_to_Registre(&Registre_UART0->CONF0,BIT_UART_NBDATA,Nb_BitData,2);
-
-            // Nombre de bits de Stop
-            Set_buffer_to_Registre(&Registre_UART0->CONF0,BIT_UART_STOPBIT,Nb_BitStop,2);
-
-            // Vitesse de communication
-            Set_buffer_to_Registre(&Registre_UART0->CLKDIV,0,clk_div,20);
-            
-        break;
-
-        case UART1 :
-            // Etape 1 : choix des fonctions uart (TX uniquement pour UART1 !)
-            Choix_fonction_GPIO(GPIO2,GPIO_FONCTION_3); // TX
-
-            // Etape 2 : paramétrage de la com'
-            // Parité
-            Set_buffer_to_Registre(&Registre_UART1->CONF0,BIT_UART_PARITY,Parite,2);
-
-            // Nombre de données
-            Set_buffer_to_Registre(&Registre_UART1->CONF0,BIT_UART_NBDATA,Nb_BitData,2);
-
-            // Nombre de bits de Stop
-            Set_buffer_to_Registre(&Registre_UART1->CONF0,BIT_UART_STOPBIT,Nb_BitStop,2);
-
-            // Vitesse de communication
-            Set_buffer_to_Registre(&Registre_UART1->CLKDIV,0,clk_div,20);
-        break;
-
-        default:break;
-    }
-}
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie un caractère sur la liaison série
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  Caractère à envoyer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_send_tx(uint8 UART,uint8 caractere)
-{
-    switch(UART)
-    {
-        case UART0 :
-            // Tant que la FIFO TX est pleine, on ne peut pas écrire de nouveaux caractères
-            while(Get_buffer_from_Registre(&Registre_UART0->STATUS,BIT_UART_TXFIFO_CNT,8) == 0xFF);
-            // Dès que la fifo a un espace libre, on peut envoyer le caractère : 
-            Set_buffer_to_Registre(&Registre_UART0->FIFO,0,caractere,8);
-        break;
-
-        case UART1 : 
-            // Tant que la FIFO TX est pleine, on ne peut pas écrire de nouveaux caractères
-            while(Get_buffer_from_Registre(&Registre_UART1->STATUS,BIT_UART_TXFIFO_CNT,8) == 0xFF);
-            // Dès que la fifo a un espace libre, on peut envoyer le caractère : 
-            Set_buffer_to_Registre(&Registre_UART1->FIFO,8,caractere,8);
-        break;
-    }
-    
-    
-}
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie un caractère sur la liaison série 
-                  (en prenant en compte les cas spéciaux)
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  Caractère à envoyer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_WriteChar(uint8 UART, uint8 Caractere)
-{
-    // Gestion du retour-chariot
-    if (Caractere == '\n')
-    {
-        UART_send_tx(UART,'\r');
-        UART_send_tx(UART,'\n');
-    }
-    else
-    {
-        UART_send_tx(UART,Caractere);
-    }
-}
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie un buffer sur la liaison série 
-                  (en prenant en compte les cas spéciaux)
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  buffer à envoyer
-                  taille du buffer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_WriteBuffer(uint8 UART, uint8 *buffer, uint16 len)
-{
-    uint16 i;
-    for (i = 0; i < len; i++)
-    {
-        UART_WriteChar(UART,buffer[i]);
-    }
-}
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie une chaîne de caractère sur la liaison série 
-                  (en prenant en compte les cas spéciaux)
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  chaîne de caractère à envoyer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_WriteString(uint8 UART,const char *str)
-{
-    while(*str){
-        UART_WriteChar(UART,*str++);
-    }
-}
\ No newline at end of file
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : UART_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Ensemble des définitions nécessaires pour manipuler les liaisons UART des ESP8266
+ * 
+ *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
+ * =============================================================================================================================================
+ */
+
+// Librairies
+#include "UART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Fonctions associées aux interruptions des UART
+UART_Callback Callback_UART[2] = {NULL, NULL};
+
+// Indique si la routine d'interruption commune a déjà été attachée
+bool flag_interruption_UART = false;
+
+// Contrôle de flux : statistiques et blocages en cours (date de début en cycles CPU)
+UART_Statistiques_Flux Statistiques_Flux_UART[2];
+bool pause_rx_UART[2] = {false, false};
+bool blocage_tx_UART[2] = {false, false};
+uint32 debut_pause_rx_UART[2];
+uint32 debut_blocage_tx_UART[2];
+
+#define UART_CYCLES_PAR_US (ESP8266_CLOCK_FREQ / 1000000)
+
+// Accès aux registres selon le N° de l'UART
+#define REGISTRE_UART(n) (((n) == UART0) ? Registre_UART0 : Registre_UART1)
+
+/*===============================================================================
+  FONCTION      : init_UART
+  DESCRIPTION   : initialise la liaison série UART voulue
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Vitesse de communication (Bauds)
+                  Nombre de bits de données (5,6,7 ou 8)
+                  Parité (Aucune, Even, Odd)
+                  Nombre de bits de stop (0,1,1.5 ou 2)
+  RETOUR        : rien   
+===============================================================================*/
+void init_UART(uint8 UART, uint32 Bauds,UART_BitData Nb_BitData, UART_Parite Parite, UART_BitStop Nb_BitStop)
+{
+    uint32 clk_div = ESP8266_CLOCK_FREQ / Bauds ;
+    switch(UART)
+    {
+        case UART0 :
+            // Etape 1 : choix des fonctions uart
+            Choix_fonction_GPIO(GPIO1,GPIO_FONCTION_1); // TX
+            Choix_fonction_GPIO(GPIO3,GPIO_FONCTION_1); // RX 
+
+            // Etape 2 : paramétrage de la com'
+            // Parité
+            Set_buffer_to_Registre(&Registre_UART0->CONF0,BIT_UART_PARITY,Parite,2);
+
+            // Nombre de données
+            Set_buffer_to_Registre(&Registre_UART0->CONF0,BIT_UART_NBDATA,Nb_BitData,2);
+
+            // Nombre de bits de Stop
+            Set_buffer_to_Registre(&Registre_UART0->CONF0,BIT_UART_STOPBIT,Nb_BitStop,2);
+
+            // Vitesse de communication
+            Set_buffer_to_Registre(&Registre_UART0->CLKDIV,0,clk_div,20);
+            
+        break;
+
+        case UART1 :
+            // Etape 1 : choix des fonctions uart (TX uniquement pour UART1 !)
+            Choix_fonction_GPIO(GPIO2,GPIO_FONCTION_3); // TX
+
+            // Etape 2 : paramétrage de la com'
+            // Parité
+            Set_buffer_to_Registre(&Registre_UART1->CONF0,BIT_UART_PARITY,Parite,2);
+
+            // Nombre de données
+            Set_buffer_to_Registre(&Registre_UART1->CONF0,BIT_UART_NBDATA,Nb_BitData,2);
+
+            // Nombre de bits de Stop
+            Set_buffer_to_Registre(&Registre_UART1->CONF0,BIT_UART_STOPBIT,Nb_BitStop,2);
+
+            // Vitesse de communication
+            Set_buffer_to_Registre(&Registre_UART1->CLKDIV,0,clk_div,20);
+        break;
+
+        default:break;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie un caractère sur la liaison série
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Caractère à envoyer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_send_tx(uint8 UART,uint8 caractere)
+{
+    switch(UART)
+    {
+        case UART0 :
+            // Tant que la FIFO TX est pleine, on ne peut pas écrire de nouveaux caractères
+            while(Get_buffer_from_Registre(&Registre_UART0->STATUS,BIT_UART_TXFIFO_CNT,8) == 0xFF);
+            // Dès que la fifo a un espace libre, on peut envoyer le caractère : 
+            Set_buffer_to_Registre(&Registre_UART0->FIFO,0,caractere,8);
+        break;
+
+        case UART1 : 
+            // Tant que la FIFO TX est pleine, on ne peut pas écrire de nouveaux caractères
+            while(Get_buffer_from_Registre(&Registre_UART1->STATUS,BIT_UART_TXFIFO_CNT,8) == 0xFF);
+            // Dès que la fifo a un espace libre, on peut envoyer le caractère : 
+            Set_buffer_to_Registre(&Registre_UART1->FIFO,8,caractere,8);
+        break;
+    }
+    
+    
+}
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie un caractère sur la liaison série 
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Caractère à envoyer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_WriteChar(uint8 UART, uint8 Caractere)
+{
+    // Gestion du retour-chariot
+    if (Caractere == '\n')
+    {
+        UART_send_tx(UART,'\r');
+        UART_send_tx(UART,'\n');
+    }
+    else
+    {
+        UART_send_tx(UART,Caractere);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie un buffer sur la liaison série 
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  buffer à envoyer
+                  taille du buffer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_WriteBuffer(uint8 UART, uint8 *buffer, uint16 len)
+{
+    uint16 i;
+    for (i = 0; i < len; i++)
+    {
+        UART_WriteChar(UART,buffer[i]);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie une chaîne de caractère sur la liaison série 
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  chaîne de caractère à envoyer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_WriteString(uint8 UART,const char *str)
+{
+    while(*str){
+        UART_WriteChar(UART,*str++);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : UART_WriteNombre
+  DESCRIPTION   : Envoie un nombre entier non signé, en décimal, sur la liaison série
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  nombre à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void UART_WriteNombre(uint8 UART, uint32 nombre)
+{
+    char chiffres[10];
+    uint8 nb = 0;
+
+    // chiffres obtenus du poids faible au poids fort
+    do
+    {
+        chiffres[nb++] = '0' + (nombre % 10);
+        nombre /= 10;
+    } while (nombre != 0);
+
+    while (nb > 0)
+    {
+        UART_send_tx(UART,chiffres[--nb]);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : UART_Attacher_Interruption
+  DESCRIPTION   : Associe une fonction aux interruptions d'une UART
+  (la routine d'interruption est commune aux deux UART : elle appelle la fonction
+  de chaque UART concernée, puis acquitte les interruptions traitées)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  fonction à appeler (exécutée sous interruption : ICACHE_RAM_ATTR)
+  RETOUR        : rien
+===============================================================================*/
+void UART_Attacher_Interruption(uint8 UART, UART_Callback fonction)
+{
+    if (UART > UART1) return;
+
+    ETS_UART_INTR_DISABLE();
+
+    // La routine commune n'est attachée qu'une seule fois
+    if (!flag_interruption_UART)
+    {
+        ETS_UART_INTR_ATTACH(Interruption_UART,NULL);
+        flag_interruption_UART = true;
+    }
+    Callback_UART[UART] = fonction;
+
+    ETS_UART_INTR_ENABLE();
+}
+
+/*===============================================================================
+  FONCTION      : UART_Activer_Interruption
+  DESCRIPTION   : Active une ou plusieurs interruptions d'une UART
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Masque des interruptions (bits BIT_UART_INT_*)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Activer_Interruption(uint8 UART, uint32 masque)
+{
+    if (UART > UART1) return;
+    REGISTRE_ECRIRE(REGISTRE_UART(UART)->INT_CLR,masque);
+    REGISTRE_OU(REGISTRE_UART(UART)->INT_ENA,masque);
+}
+
+/*===============================================================================
+  FONCTION      : UART_Desactiver_Interruption
+  DESCRIPTION   : Désactive une ou plusieurs interruptions d'une UART
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Masque des interruptions (bits BIT_UART_INT_*)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Desactiver_Interruption(uint8 UART, uint32 masque)
+{
+    if (UART > UART1) return;
+    REGISTRE_ET(REGISTRE_UART(UART)->INT_ENA,~masque);
+    REGISTRE_ECRIRE(REGISTRE_UART(UART)->INT_CLR,masque);
+}
+
+/*===============================================================================
+  FONCTION      : UART_Set_Controle_Flux
+  DESCRIPTION   : Active ou désactive le contrôle de flux matériel RTS / CTS
+                  (fonctions U0RTS / U0CTS sur GPIO15 / GPIO13, seuil RTS dans CONF1)
+                  Le suivi de CTS (statistiques) utilise l'interruption CTS_CHG
+  PARAMETRES    : N° de l'UART (UART0 uniquement)
+                  Contrôle de flux en réception (RTS), en émission (CTS)
+                  Seuil de la fifo RX au-delà duquel RTS est relâché (1 à 127)
+  RETOUR        : false si l'UART ou le seuil ne conviennent pas
+===============================================================================*/
+bool UART_Set_Controle_Flux(uint8 UART, bool rts, bool cts, uint8 seuil_rts)
+{
+    // Les lignes RTS / CTS de l'UART1 ne sont pas sorties sur les broches
+    if (UART != UART0) return false;
+    if (rts && (seuil_rts == 0 || seuil_rts >= UART_TAILLE_FIFO)) return false;
+
+    Statistiques_Flux_UART[UART].nb_pauses_rx = 0;
+    Statistiques_Flux_UART[UART].duree_pauses_rx = 0;
+    Statistiques_Flux_UART[UART].nb_blocages_tx = 0;
+    Statistiques_Flux_UART[UART].duree_blocages_tx = 0;
+    pause_rx_UART[UART] = false;
+
+    // Réception : l'UART relâche RTS dès que la fifo RX atteint le seuil
+    if (rts)
+    {
+        Choix_fonction_GPIO(UART_GPIO_RTS,GPIO_FONCTION_5); // U0RTS
+        Set_buffer_to_Registre(&Registre_UART0->CONF1,BIT_UART_RX_FLOW_THRHD,seuil_rts,7);
+        REGISTRE_CONFIG_SET_BIT(Registre_UART0->CONF1,BIT_UART_RX_FLOW_EN);
+    }
+    else
+    {
+        REGISTRE_CONFIG_CLR_BIT(Registre_UART0->CONF1,BIT_UART_RX_FLOW_EN);
+    }
+
+    // Emission : la fifo TX n'est vidée que lorsque le correspondant maintient CTS
+    ETS_UART_INTR_DISABLE();
+    if (cts)
+    {
+        Choix_fonction_GPIO(UART_GPIO_CTS,GPIO_FONCTION_5); // U0CTS
+        REGISTRE_CONFIG_SET_BIT(Registre_UART0->CONF0,BIT_UART_TX_FLOW_EN);
+
+        // Suivi des changements d'état de CTS par la routine commune
+        if (!flag_interruption_UART)
+        {
+            ETS_UART_INTR_ATTACH(Interruption_UART,NULL);
+            flag_interruption_UART = true;
+        }
+        blocage_tx_UART[UART] = false;
+        UART_Activer_Interruption(UART,(1 << BIT_UART_INT_CTS_CHG));
+        UART_Suivi_CTS(UART);
+    }
+    else
+    {
+        UART_Desactiver_Interruption(UART,(1 << BIT_UART_INT_CTS_CHG));
+        REGISTRE_CONFIG_CLR_BIT(Registre_UART0->CONF0,BIT_UART_TX_FLOW_EN);
+        blocage_tx_UART[UART] = false;
+    }
+    ETS_UART_INTR_ENABLE();
+
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : UART_Controle_Flux_Actif
+  DESCRIPTION   : Indique si le contrôle de flux en réception (RTS) est actif
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : true si RTS est géré par l'UART
+===============================================================================*/
+bool ICACHE_RAM_ATTR UART_Controle_Flux_Actif(uint8 UART)
+{
+    if (UART != UART0) return false;
+    return READ_BIT(REGISTRE_CONFIG_LIRE(Registre_UART0->CONF1),BIT_UART_RX_FLOW_EN);
+}
+
+/*===============================================================================
+  FONCTION      : UART_Pause_Reception
+  DESCRIPTION   : Signale qu'un module suspend (ou reprend) la lecture de la fifo RX
+                  parce que son buffer est plein (décompte du temps de blocage)
+  PARAMETRES    : N° de l'UART (0 ou 1), true : suspension, false : reprise
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Pause_Reception(uint8 UART, bool pause)
+{
+    if (UART > UART1 || pause == pause_rx_UART[UART]) return;
+
+    pause_rx_UART[UART] = pause;
+    if (pause)
+    {
+        debut_pause_rx_UART[UART] = Lire_Compteur_Cycles();
+        Statistiques_Flux_UART[UART].nb_pauses_rx++;
+    }
+    else
+    {
+        Statistiques_Flux_UART[UART].duree_pauses_rx += (Lire_Compteur_Cycles() - debut_pause_rx_UART[UART]) / UART_CYCLES_PAR_US;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : UART_Suivi_CTS
+  DESCRIPTION   : Relève l'état de la ligne CTS (début ou fin d'un blocage de l'émission)
+  PARAMETRES    : N° de l'UART
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Suivi_CTS(uint8 UART)
+{
+    bool bloque = READ_BIT(REGISTRE_LIRE(REGISTRE_UART(UART)->STATUS),BIT_UART_LEVEL_CTSN);
+    if (bloque == blocage_tx_UART[UART]) return;
+
+    blocage_tx_UART[UART] = bloque;
+    if (bloque)
+    {
+        debut_blocage_tx_UART[UART] = Lire_Compteur_Cycles();
+        Statistiques_Flux_UART[UART].nb_blocages_tx++;
+    }
+    else
+    {
+        Statistiques_Flux_UART[UART].duree_blocages_tx += (Lire_Compteur_Cycles() - debut_blocage_tx_UART[UART]) / UART_CYCLES_PAR_US;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : UART_Lire_Statistiques_Flux
+  DESCRIPTION   : Statistiques du contrôle de flux
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : Pointeur vers les statistiques
+===============================================================================*/
+const UART_Statistiques_Flux *UART_Lire_Statistiques_Flux(uint8 UART)
+{
+    return &Statistiques_Flux_UART[(UART == UART0) ? UART0 : UART1];
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_UART
+  DESCRIPTION   : Routine d'interruption commune aux deux UART
+  L'acquittement est fait après l'appel de la fonction : une interruption 
+  "fifo TX vide" ne se redéclenche pas si la fonction a rempli la fifo
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_UART()
+{
+    for (uint8 uart = UART0; uart <= UART1; uart++)
+    {
+        uint32 statut = REGISTRE_LIRE(REGISTRE_UART(uart)->INT_ST);
+        if (statut == 0) continue;
+
+        // Contrôle de flux : début ou fin d'un blocage de l'émission par CTS
+        if (READ_BIT(statut,BIT_UART_INT_CTS_CHG))
+        {
+            UART_Suivi_CTS(uart);
+        }
+
+        if (Callback_UART[uart] != NULL)
+        {
+            Callback_UART[uart](uart,statut);
+        }
+        REGISTRE_ECRIRE(REGISTRE_UART(uart)->INT_CLR,statut);
+    }
+}
@@ -1,169 +1,311 @@
-/* 
- *  =============================================================================================================================================
- *  Titre    : UART_esp8266.cpp
- *  Auteur   : Thomas Broussard
- *  Projet   : Industrialisation ESP8266
- *  Création : Octobre 2018
- *  ---------------------------------------------------------------------------------------------------------------------------------------------
- *  Description :
- *  Ensemble des définitions nécessaires pour manipuler les liaisons UART des ESP8266
- * 
- *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
- * =============================================================================================================================================
- */
- 
-#ifndef __UART_ESP8266_H__
-#define __UART_ESP8266_H__
-
-// Dépendances
-#include "registres_esp8266.h"
-#include "GPIO_esp8266.h"
-
-// Intéressant, à creuser :  https://github.com/scottjgibson/esp8266/blob/master/esp_iot_sdk_v0.6/ld/eagle.rom.addr.v6.ld
-/*
-PROVIDE ( uartAttach = 0x4000383c );
-PROVIDE ( uart_baudrate_detect = 0x40003924 );
-PROVIDE ( uart_buff_switch = 0x400038a4 );
-PROVIDE ( uart_div_modify = 0x400039d8 );
-PROVIDE ( uart_rx_intr_handler = 0x40003bbc );
-PROVIDE ( uart_rx_one_char = 0x40003b8c );
-PROVIDE ( uart_rx_one_char_block = 0x40003b64 );
-PROVIDE ( uart_rx_readbuff = 0x40003ec8 );
-PROVIDE ( uart_tx_one_char = 0x40003b30 );
-*/
-
-// ##########################################################################################################################
-//                                      REGISTRES UART
-// ##########################################################################################################################
-// -------------------------------------------------
-// Structure du registre
-// -------------------------------------------------
-typedef struct {
-    __Registre FIFO;
-
-    __Registre INT_RAW;
-    __Registre INT_ST;
-    __Registre INT_ENA;
-    __Registre INT_CLR;
-
-    __Registre CLKDIV;
-    __Registre AUTOBAUD;
-    __Registre STATUS;
-
-    __Registre CONF0;
-    __Registre CONF1;
-
-    __Registre LOWPULSE;
-    __Registre HIGHPULSE;
-
-    __Registre RXD_CNT;
-    __Registre DATE;
-    __Registre ID;
-}UART_Struct;
-
-// -------------------------------------------------
-// définition des registres
-// -------------------------------------------------
-#define Registre_UART0 ((UART_Struct*) ADDR_UART0)
-#define Registre_UART1 ((UART_Struct*) ADDR_UART1)
-
-// -------------------------------------------------
-// Bits utilisés
-// -------------------------------------------------
-// UART->STATUS
-#define BIT_UART_LEVEL_TXD      31 // Etat de la pin TX
-#define BIT_UART_LEVEL_RXD      15 // Etat de la pin RX
-#define BIT_UART_TXFIFO_CNT     16 // [23:16] : nombre de données dans la fifo TX
-
-// UART->CONF0
-#define BIT_UART_TXFIFO_RST		18 // Mettre à '1' pour faire un reset de la fifo TX
-#define BIT_UART_RXFIFO_RST		17 // Mettre à '1' pour faire un reset de la fifo RX
-
-#define BIT_UART_STOPBIT 		4 // [5:4] choix du nombre de bit de stop (0:aucun 1:1bit 2:1.5bits 3:2bits)
-#define BIT_UART_NBDATA			2 // [3:2] choix du nombre de données (0:5bits 1:6bits 2:7bits 3:8bits)
-#define BIT_UART_PARITY_EN		1 // [1] active la parité (0:inactif 1:actif)
-#define BIT_UART_PARITY			0 // [0] défini la parité (0:even 1:odd)
-
-// ----------------------------------------------------------------------------------------------
-// Définition de constantes utiles
-// ----------------------------------------------------------------------------------------------
-
-// Parité
-typedef enum {NONE=0x0,EVEN=0x2,ODD=0x3} UART_Parite;
-
-// Bits de stop
-typedef enum {STOP_0,STOP_1,STOP_15,STOP_2} UART_BitStop; // Remarque : STOP_15 signifie 1.5bits de stop
-
-// Nombre de données
-typedef enum{DATA_5,DATA_6,DATA_7,DATA_8} UART_BitData;
-
-// Types d'interruption
-typedef enum {RX_FULL,RX_OVERFLOW,RX_TIMEOUT,TX_EMPTY_FIFO,TX_ERROR,TX_FLOW_CONTROL} UART_Interrupt;
-
-// UART utilisé
-#ifndef UART0
-  #define UART0 0x00
-#endif
-#ifndef UART1
-  #define UART1 0x01
-#endif
-
-
-// ##########################################################################################################################
-//                                              FONCTIONS UART
-// ##########################################################################################################################
-
-/*===============================================================================
-  FONCTION      : init_UART
-  DESCRIPTION   : initialise la liaison série UART voulue
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  Vitesse de communication (Bauds)
-                  Nombre de bits de données (5,6,7 ou 8)
-                  Parité (Aucune, Even, Odd)
-                  Nombre de bits de stop (0,1,1.5 ou 2)
-  RETOUR        : rien   
-===============================================================================*/
-void init_UART(uint8 UART, uint32 Bauds,UART_BitData Nb_BitData, UART_Parite Parite, UART_BitStop Nb_BitStop);
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie un caractère sur la liaison série
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  Caractère à envoyer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_send_tx(uint8 UART,uint8 caractere);
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie un caractère sur la liaison série 
-                  (en prenant en compte les cas spéciaux)
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  Caractère à envoyer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_WriteChar(uint8 UART, uint8 Caractere);
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie un buffer sur la liaison série 
-                  (en prenant en compte les cas spéciaux)
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  buffer à envoyer
-                  taille du buffer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_WriteBuffer(uint8 UART, uint8 *buffer, uint16 len);
-
-/*===============================================================================
-  FONCTION      : UART_send_tx
-  DESCRIPTION   : Envoie une chaîne de caractère sur la liaison série 
-                  (en prenant en compte les cas spéciaux)
-  PARAMETRES    : N° de l'UART (0 ou 1)
-                  chaîne de caractère à envoyer
-  RETOUR        : rien   
-===============================================================================*/
-void UART_WriteString(uint8 UART,const char *str);
-
-/* fin du fichier */
-#endif
+/* 
+ *  =============================================================================================================================================
+ *  Titre    : UART_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Ensemble des définitions nécessaires pour manipuler les liaisons UART des ESP8266
+ * 
+ *  Lien utile : https://github.com/esp8266/esp8266-wiki/wiki/Memory-Map
+ * =============================================================================================================================================
+ */
+ 
+#ifndef __UART_ESP8266_H__
+#define __UART_ESP8266_H__
+
+// Dépendances
+#include "registres_esp8266.h"
+#include "GPIO_esp8266.h"
+
+// Intéressant, à creuser :  https://github.com/scottjgibson/esp8266/blob/master/esp_iot_sdk_v0.6/ld/eagle.rom.addr.v6.ld
+/*
+PROVIDE ( uartAttach = 0x4000383c );
+PROVIDE ( uart_baudrate_detect = 0x40003924 );
+PROVIDE ( uart_buff_switch = 0x400038a4 );
+PROVIDE ( uart_div_modify = 0x400039d8 );
+PROVIDE ( uart_rx_intr_handler = 0x40003bbc );
+PROVIDE ( uart_rx_one_char = 0x40003b8c );
+PROVIDE ( uart_rx_one_char_block = 0x40003b64 );
+PROVIDE ( uart_rx_readbuff = 0x40003ec8 );
+PROVIDE ( uart_tx_one_char = 0x40003b30 );
+*/
+
+// ##########################################################################################################################
+//                                      REGISTRES UART
+// ##########################################################################################################################
+// -------------------------------------------------
+// Structure du registre
+// -------------------------------------------------
+typedef struct {
+    __Registre FIFO;
+
+    __Registre INT_RAW;
+    __Registre INT_ST;
+    __Registre INT_ENA;
+    __Registre INT_CLR;
+
+    __Registre CLKDIV;
+    __Registre AUTOBAUD;
+    __Registre STATUS;
+
+    __Registre CONF0;
+    __Registre CONF1;
+
+    __Registre LOWPULSE;
+    __Registre HIGHPULSE;
+
+    __Registre RXD_CNT;
+    __Registre DATE;
+    __Registre ID;
+}UART_Struct;
+
+// -------------------------------------------------
+// définition des registres
+// -------------------------------------------------
+#define Registre_UART0 ((UART_Struct*) ADDR_UART0)
+#define Registre_UART1 ((UART_Struct*) ADDR_UART1)
+
+// -------------------------------------------------
+// Bits utilisés
+// -------------------------------------------------
+// UART->STATUS
+#define BIT_UART_LEVEL_TXD      31 // Etat de la pin TX
+#define BIT_UART_LEVEL_RTSN     30 // Etat de la pin RTS
+#define BIT_UART_LEVEL_RXD      15 // Etat de la pin RX
+#define BIT_UART_LEVEL_CTSN     14 // Etat de la pin CTS (1 : le correspondant bloque l'envoi)
+#define BIT_UART_TXFIFO_CNT     16 // [23:16] : nombre de données dans la fifo TX
+#define BIT_UART_RXFIFO_CNT     0  // [7:0] : nombre de données dans la fifo RX
+
+// UART->INT_RAW / INT_ST / INT_ENA / INT_CLR
+#define BIT_UART_INT_RXFIFO_FULL   0 // La fifo RX a atteint le seuil RXFIFO_FULL_THRHD
+#define BIT_UART_INT_TXFIFO_EMPTY  1 // La fifo TX est passée sous le seuil TXFIFO_EMPTY_THRHD
+#define BIT_UART_INT_PARITY_ERR    2 // Erreur de parité
+#define BIT_UART_INT_FRM_ERR       3 // Erreur de trame
+#define BIT_UART_INT_RXFIFO_OVF    4 // Débordement de la fifo RX
+#define BIT_UART_INT_DSR_CHG       5 // Changement d'état de la ligne DSR
+#define BIT_UART_INT_CTS_CHG       6 // Changement d'état de la ligne CTS
+#define BIT_UART_INT_BRK_DET       7 // Détection d'un "break"
+#define BIT_UART_INT_RXFIFO_TOUT   8 // Timeout de réception
+
+// UART->CONF0
+#define BIT_UART_TXD_INV        22 // Inversion de la sortie TX
+#define BIT_UART_TX_FLOW_EN     15 // Activation du contrôle de flux en émission (CTS)
+#define BIT_UART_TXFIFO_RST		18 // Mettre à '1' pour faire un reset de la fifo TX
+#define BIT_UART_RXFIFO_RST		17 // Mettre à '1' pour faire un reset de la fifo RX
+
+#define BIT_UART_STOPBIT 		4 // [5:4] choix du nombre de bit de stop (0:aucun 1:1bit 2:1.5bits 3:2bits)
+#define BIT_UART_NBDATA			2 // [3:2] choix du nombre de données (0:5bits 1:6bits 2:7bits 3:8bits)
+#define BIT_UART_PARITY_EN		1 // [1] active la parité (0:inactif 1:actif)
+#define BIT_UART_PARITY			0 // [0] défini la parité (0:even 1:odd)
+
+// UART->CONF1
+#define BIT_UART_RX_TOUT_EN          31 // Activation du timeout de réception
+#define BIT_UART_RX_TOUT_THRHD       24 // [30:24] seuil du timeout de réception (durée d'un octet)
+#define BIT_UART_RX_FLOW_EN          23 // Activation du contrôle de flux en réception (RTS)
+#define BIT_UART_RX_FLOW_THRHD       16 // [22:16] seuil de la fifo RX pour le contrôle de flux
+#define BIT_UART_TXFIFO_EMPTY_THRHD  8  // [14:8] seuil de l'interruption "fifo TX vide"
+#define BIT_UART_RXFIFO_FULL_THRHD   0  // [6:0] seuil de l'interruption "fifo RX pleine"
+
+// ----------------------------------------------------------------------------------------------
+// Définition de constantes utiles
+// ----------------------------------------------------------------------------------------------
+
+// Parité
+typedef enum {NONE=0x0,EVEN=0x2,ODD=0x3} UART_Parite;
+
+// Bits de stop
+typedef enum {STOP_0,STOP_1,STOP_15,STOP_2} UART_BitStop; // Remarque : STOP_15 signifie 1.5bits de stop
+
+// Nombre de données
+typedef enum{DATA_5,DATA_6,DATA_7,DATA_8} UART_BitData;
+
+// Types d'interruption
+typedef enum {RX_FULL,RX_OVERFLOW,RX_TIMEOUT,TX_EMPTY_FIFO,TX_ERROR,TX_FLOW_CONTROL} UART_Interrupt;
+
+// Taille des fifo matérielles (octets)
+#define UART_TAILLE_FIFO 128
+
+// Contrôle de flux matériel (UART0 uniquement : CTS sur GPIO13, RTS sur GPIO15)
+// RTS est relâché par l'UART dès que la fifo RX atteint le seuil : la marge restante
+// (UART_TAILLE_FIFO - seuil) doit couvrir les octets que le correspondant envoie encore
+// après le changement d'état (1 octet pour une UART, jusqu'à 16 ou 32 pour certains adaptateurs USB)
+#define UART_SEUIL_RTS_DEFAUT 96
+#define UART_GPIO_CTS GPIO13
+#define UART_GPIO_RTS GPIO15
+
+// Statistiques du contrôle de flux (durées en us)
+typedef struct{
+  uint32 nb_pauses_rx;         // réceptions suspendues (buffer logiciel plein : RTS relâché par la fifo)
+  uint32 duree_pauses_rx;
+  uint32 nb_blocages_tx;       // émissions bloquées par le correspondant (CTS)
+  uint32 duree_blocages_tx;
+} UART_Statistiques_Flux;
+
+// Fonction appelée lors d'une interruption UART (N° de l'UART, interruptions actives : registre INT_ST)
+typedef void (*UART_Callback)(uint8 UART, uint32 statut);
+
+// UART utilisé
+#ifndef UART0
+  #define UART0 0x00
+#endif
+#ifndef UART1
+  #define UART1 0x01
+#endif
+
+
+// ##########################################################################################################################
+//                                              FONCTIONS UART
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_UART
+  DESCRIPTION   : initialise la liaison série UART voulue
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Vitesse de communication (Bauds)
+                  Nombre de bits de données (5,6,7 ou 8)
+                  Parité (Aucune, Even, Odd)
+                  Nombre de bits de stop (0,1,1.5 ou 2)
+  RETOUR        : rien   
+===============================================================================*/
+void init_UART(uint8 UART, uint32 Bauds,UART_BitData Nb_BitData, UART_Parite Parite, UART_BitStop Nb_BitStop);
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie un caractère sur la liaison série
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Caractère à envoyer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_send_tx(uint8 UART,uint8 caractere);
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie un caractère sur la liaison série 
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Caractère à envoyer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_WriteChar(uint8 UART, uint8 Caractere);
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie un buffer sur la liaison série 
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  buffer à envoyer
+                  taille du buffer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_WriteBuffer(uint8 UART, uint8 *buffer, uint16 len);
+
+/*===============================================================================
+  FONCTION      : UART_send_tx
+  DESCRIPTION   : Envoie une chaîne de caractère sur la liaison série 
+                  (en prenant en compte les cas spéciaux)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  chaîne de caractère à envoyer
+  RETOUR        : rien   
+===============================================================================*/
+void UART_WriteString(uint8 UART,const char *str);
+
+/*===============================================================================
+  FONCTION      : UART_WriteNombre
+  DESCRIPTION   : Envoie un nombre entier non signé, en décimal, sur la liaison série
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  nombre à envoyer
+  RETOUR        : rien
+===============================================================================*/
+void UART_WriteNombre(uint8 UART, uint32 nombre);
+
+/*===============================================================================
+  FONCTION      : UART_Attacher_Interruption
+  DESCRIPTION   : Associe une fonction aux interruptions d'une UART
+  (la routine d'interruption est commune aux deux UART : elle appelle la fonction
+  de chaque UART concernée, puis acquitte les interruptions traitées)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  fonction à appeler (exécutée sous interruption : ICACHE_RAM_ATTR)
+  RETOUR        : rien
+===============================================================================*/
+void UART_Attacher_Interruption(uint8 UART, UART_Callback fonction);
+
+/*===============================================================================
+  FONCTION      : UART_Activer_Interruption
+  DESCRIPTION   : Active une ou plusieurs interruptions d'une UART
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Masque des interruptions (bits BIT_UART_INT_*)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Activer_Interruption(uint8 UART, uint32 masque);
+
+/*===============================================================================
+  FONCTION      : UART_Desactiver_Interruption
+  DESCRIPTION   : Désactive une ou plusieurs interruptions d'une UART
+  PARAMETRES    : N° de l'UART (0 ou 1)
+                  Masque des interruptions (bits BIT_UART_INT_*)
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Desactiver_Interruption(uint8 UART, uint32 masque);
+
+/*===============================================================================
+  FONCTION      : UART_Set_Controle_Flux
+  DESCRIPTION   : Active ou désactive le contrôle de flux matériel RTS / CTS
+                  (fonctions U0RTS / U0CTS sur GPIO15 / GPIO13, seuil RTS dans CONF1)
+                  Le suivi de CTS (statistiques) utilise l'interruption CTS_CHG
+  PARAMETRES    : N° de l'UART (UART0 uniquement)
+                  Contrôle de flux en réception (RTS), en émission (CTS)
+                  Seuil de la fifo RX au-delà duquel RTS est relâché (1 à 127)
+  RETOUR        : false si l'UART ou le seuil ne conviennent pas
+===============================================================================*/
+bool UART_Set_Controle_Flux(uint8 UART, bool rts, bool cts, uint8 seuil_rts);
+
+/*===============================================================================
+  FONCTION      : UART_Controle_Flux_Actif
+  DESCRIPTION   : Indique si le contrôle de flux en réception (RTS) est actif
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : true si RTS est géré par l'UART
+===============================================================================*/
+bool ICACHE_RAM_ATTR UART_Controle_Flux_Actif(uint8 UART);
+
+/*===============================================================================
+  FONCTION      : UART_Pause_Reception
+  DESCRIPTION   : Signale qu'un module suspend (ou reprend) la lecture de la fifo RX
+                  parce que son buffer est plein : la fifo se remplit, l'UART relâche RTS
+                  et le correspondant s'arrête avant tout débordement.
+                  Sert au décompte du temps de blocage (à appeler sous interruption ou
+                  interruptions masquées)
+  PARAMETRES    : N° de l'UART (0 ou 1), true : suspension, false : reprise
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Pause_Reception(uint8 UART, bool pause);
+
+/*===============================================================================
+  FONCTION      : UART_Suivi_CTS
+  DESCRIPTION   : Relève l'état de la ligne CTS (début ou fin d'un blocage de l'émission)
+                  (appelée par Interruption_UART sur l'interruption CTS_CHG)
+  PARAMETRES    : N° de l'UART
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR UART_Suivi_CTS(uint8 UART);
+
+/*===============================================================================
+  FONCTION      : UART_Lire_Statistiques_Flux
+  DESCRIPTION   : Statistiques du contrôle de flux
+                  (les blocages en cours ne sont comptés qu'à leur fin)
+  PARAMETRES    : N° de l'UART (0 ou 1)
+  RETOUR        : Pointeur vers les statistiques
+===============================================================================*/
+const UART_Statistiques_Flux *UART_Lire_Statistiques_Flux(uint8 UART);
+
+/*===============================================================================
+  FONCTION      : Interruption_UART
+  DESCRIPTION   : Routine d'interruption commune aux deux UART
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_UART();
+
+/* fin du fichier */
+#endif
@@ -0,0 +1,257 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : WS2812_esp8266.cpp
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Pilotage des rubans de LED adressables WS2812 par la sortie TX de l'UART1 (GPIO2)
+ *
+ *  L'UART1 est configurée à 3.2 Mbauds, 6 bits de données, sortie TX inversée :
+ *  une trame UART (start + 6 bits + stop = 8 x 312.5ns) code exactement 2 bits WS2812 (2 x 1.25us).
+ *  Chaque paire de bits est traduite en un octet UART par une table de 4 valeurs.
+ *  Les octets sont fournis à la fifo TX par l'interruption "fifo TX vide" : l'envoi d'une trame
+ *  ne coûte presque aucun temps processeur et ne masque jamais les interruptions.
+ * =============================================================================================================================================
+ */
+
+// Librairies
+#include "WS2812_esp8266.h"
+
+// ##########################################################################################################################
+//                                     VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Image du ruban (ordre d'envoi WS2812 : vert, rouge, bleu)
+uint8 WS2812_Pixels[3 * WS2812_NB_LEDS_MAX];
+uint16 WS2812_Nb_Leds = 0;
+
+// Table de correction (gamma + luminosité) appliquée à chaque composante lors de l'envoi
+uint8 WS2812_Correction[256];
+uint8 WS2812_Luminosite = 255;
+bool WS2812_Gamma = true;
+
+// Envoi en cours
+volatile bool WS2812_Envoi_En_Cours = false;
+volatile uint16 WS2812_Octet_Courant = 0;
+volatile uint32 WS2812_Fin_Reset = 0;
+
+// Codage de 2 bits WS2812 (poids fort en premier) en un octet UART 6 bits, sortie inversée :
+// '0' = 312ns haut + 937ns bas / '1' = 937ns haut + 312ns bas
+const uint8 WS2812_Codage[4] = {0b110111, 0b000111, 0b110100, 0b000100};
+
+// Correction gamma 2.8
+const uint8 WS2812_Table_Gamma[256] = {
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,
+      1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,
+      2,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  5,  5,  5,
+      5,  6,  6,  6,  6,  7,  7,  7,  7,  8,  8,  8,  9,  9,  9, 10,
+     10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15, 16, 16,
+     17, 17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 24, 24, 25,
+     25, 26, 27, 27, 28, 29, 29, 30, 31, 32, 32, 33, 34, 35, 35, 36,
+     37, 38, 39, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 50,
+     51, 52, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 66, 67, 68,
+     69, 70, 72, 73, 74, 75, 77, 78, 79, 81, 82, 83, 85, 86, 87, 89,
+     90, 92, 93, 95, 96, 98, 99,101,102,104,105,107,109,110,112,114,
+    115,117,119,120,122,124,126,127,129,131,133,135,137,138,140,142,
+    144,146,148,150,152,154,156,158,160,162,164,167,169,171,173,175,
+    177,180,182,184,186,189,191,193,196,198,200,203,205,208,210,213,
+    215,218,220,223,225,228,231,233,236,239,241,244,247,249,252,255
+};
+
+// ##########################################################################################################################
+//                                     FONCTIONS INTERNES
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : WS2812_Calculer_Correction
+  DESCRIPTION   : Recalcule la table de correction (gamma puis luminosité)
+  PARAMETRES    : aucun
+  RETOUR        : rien
+===============================================================================*/
+static void WS2812_Calculer_Correction()
+{
+    for (uint16 i = 0; i < 256; i++)
+    {
+        uint16 valeur = WS2812_Gamma ? WS2812_Table_Gamma[i] : i;
+        WS2812_Correction[i] = (valeur * (WS2812_Luminosite + 1)) >> 8;
+    }
+}
+
+/*===============================================================================
+  FONCTION      : WS2812_Remplir_Fifo
+  DESCRIPTION   : Code les octets suivants de l'image dans la fifo TX
+                  (4 octets UART par octet de l'image)
+  PARAMETRES    : aucun
+  RETOUR        : Nombre d'octets présents dans la fifo après remplissage
+===============================================================================*/
+static uint16 ICACHE_RAM_ATTR WS2812_Remplir_Fifo()
+{
+    uint16 nb_fifo = (REGISTRE_LIRE(Registre_UART1->STATUS) >> BIT_UART_TXFIFO_CNT) & 0xFF;
+    uint16 libre = (UART_TAILLE_FIFO - nb_fifo) / 4;
+    uint16 octet = WS2812_Octet_Courant;
+    uint16 fin = 3 * WS2812_Nb_Leds;
+
+    while (libre-- && octet < fin)
+    {
+        uint8 valeur = WS2812_Correction[WS2812_Pixels[octet++]];
+        REGISTRE_ECRIRE(Registre_UART1->FIFO,WS2812_Codage[(valeur >> 6) & 0x3]);
+        REGISTRE_ECRIRE(Registre_UART1->FIFO,WS2812_Codage[(valeur >> 4) & 0x3]);
+        REGISTRE_ECRIRE(Registre_UART1->FIFO,WS2812_Codage[(valeur >> 2) & 0x3]);
+        REGISTRE_ECRIRE(Registre_UART1->FIFO,WS2812_Codage[valeur & 0x3]);
+        nb_fifo += 4;
+    }
+
+    WS2812_Octet_Courant = octet;
+    return nb_fifo;
+}
+
+// ##########################################################################################################################
+//                                              FONCTIONS WS2812
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_WS2812
+  DESCRIPTION   : initialise l'UART1 pour piloter un ruban de LED WS2812 sur GPIO2
+                  (toutes les LED sont éteintes, luminosité maximale, correction gamma active)
+  PARAMETRES    : Nombre de LED du ruban (WS2812_NB_LEDS_MAX au maximum)
+  RETOUR        : rien
+===============================================================================*/
+void init_WS2812(uint16 nb_leds)
+{
+    // Etape 1 : image et table de correction
+    WS2812_Nb_Leds = (nb_leds > WS2812_NB_LEDS_MAX) ? WS2812_NB_LEDS_MAX : nb_leds;
+    WS2812_Remplir(0,0,0);
+    WS2812_Luminosite = 255;
+    WS2812_Gamma = true;
+    WS2812_Calculer_Correction();
+    WS2812_Envoi_En_Cours = false;
+    WS2812_Fin_Reset = Lire_Compteur_Cycles();
+
+    // Etape 2 : UART1 à 3.2 Mbauds, 6N1, sortie inversée (ligne au repos à l'état bas)
+    init_UART(UART1,WS2812_BAUDS,DATA_6,NONE,STOP_1);
+    REGISTRE_CONFIG_SET_BIT(Registre_UART1->CONF0,BIT_UART_TXD_INV);
+    Set_buffer_to_Registre(&Registre_UART1->CONF1,BIT_UART_TXFIFO_EMPTY_THRHD,WS2812_SEUIL_FIFO,7);
+
+    // Etape 3 : interruption "fifo TX vide" (activée uniquement pendant un envoi)
+    UART_Desactiver_Interruption(UART1,(1 << BIT_UART_INT_TXFIFO_EMPTY));
+    UART_Attacher_Interruption(UART1,Interruption_WS2812);
+}
+
+/*===============================================================================
+  FONCTION      : WS2812_Set_Pixel
+  DESCRIPTION   : Modifie la couleur d'une LED dans l'image en mémoire
+                  (prise en compte au prochain appel de WS2812_Afficher)
+  PARAMETRES    : N° de la LED, composantes rouge, verte et bleue (0 à 255)
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Set_Pixel(uint16 index, uint8 rouge, uint8 vert, uint8 bleu)
+{
+    if (index >= WS2812_Nb_Leds) return;
+
+    WS2812_Pixels[3 * index]     = vert;
+    WS2812_Pixels[3 * index + 1] = rouge;
+    WS2812_Pixels[3 * index + 2] = bleu;
+}
+
+/*===============================================================================
+  FONCTION      : WS2812_Remplir
+  DESCRIPTION   : Applique la même couleur à toutes les LED de l'image en mémoire
+  PARAMETRES    : composantes rouge, verte et bleue (0 à 255)
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Remplir(uint8 rouge, uint8 vert, uint8 bleu)
+{
+    for (uint16 i = 0; i < WS2812_Nb_Leds; i++)
+    {
+        WS2812_Set_Pixel(i,rouge,vert,bleu);
+    }
+}
+
+/*===============================================================================
+  FONCTION      : WS2812_Set_Luminosite
+  DESCRIPTION   : Définit la luminosité globale du ruban
+                  (recalcule la table de correction appliquée à chaque composante)
+  PARAMETRES    : Luminosité (0 à 255)
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Set_Luminosite(uint8 luminosite)
+{
+    WS2812_Luminosite = luminosite;
+    WS2812_Calculer_Correction();
+}
+
+/*===============================================================================
+  FONCTION      : WS2812_Set_Gamma
+  DESCRIPTION   : Active ou désactive la correction gamma (2.8)
+  PARAMETRES    : true pour activer la correction
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Set_Gamma(bool gamma)
+{
+    WS2812_Gamma = gamma;
+    WS2812_Calculer_Correction();
+}
+
+/*===============================================================================
+  FONCTION      : WS2812_Afficher
+  DESCRIPTION   : Démarre l'envoi de l'image en mémoire vers le ruban
+                  (l'envoi se poursuit sous interruption)
+  PARAMETRES    : aucun
+  RETOUR        : true si l'envoi a démarré, false si la trame précédente
+                  n'est pas terminée
+===============================================================================*/
+bool WS2812_Afficher()
+{
+    if (!WS2812_Pret()) return false;
+
+    WS2812_Octet_Courant = 0;
+    WS2812_Envoi_En_Cours = true;
+
+    // La fifo est remplie une première fois, l'interruption prend le relais
+    ETS_UART_INTR_DISABLE();
+    WS2812_Remplir_Fifo();
+    UART_Activer_Interruption(UART1,(1 << BIT_UART_INT_TXFIFO_EMPTY));
+    ETS_UART_INTR_ENABLE();
+
+    return true;
+}
+
+/*===============================================================================
+  FONCTION      : WS2812_Pret
+  DESCRIPTION   : Indique si une nouvelle trame peut être envoyée
+                  (trame précédente transmise et temps de reset écoulé)
+  PARAMETRES    : aucun
+  RETOUR        : true si le ruban est prêt
+===============================================================================*/
+bool WS2812_Pret()
+{
+    if (WS2812_Envoi_En_Cours) return false;
+    return (int32)(Lire_Compteur_Cycles() - WS2812_Fin_Reset) >= 0;
+}
+
+/*===============================================================================
+  FONCTION      : Interruption_WS2812
+  DESCRIPTION   : Interruption UART1 "fifo TX vide" : complète la fifo
+  Une fois toute l'image transmise à la fifo, l'interruption est désactivée
+  et l'instant de fin du reset (fifo vidée + WS2812_T_RESET) est calculé
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_WS2812(uint8 UART, uint32 statut)
+{
+    if (!READ_BIT(statut,BIT_UART_INT_TXFIFO_EMPTY) || !WS2812_Envoi_En_Cours) return;
+
+    uint16 nb_fifo = WS2812_Remplir_Fifo();
+
+    if (WS2812_Octet_Courant >= 3 * WS2812_Nb_Leds)
+    {
+        UART_Desactiver_Interruption(UART1,(1 << BIT_UART_INT_TXFIFO_EMPTY));
+        // + 1 : octet en cours d'émission (déjà sorti de la fifo)
+        WS2812_Fin_Reset = Lire_Compteur_Cycles() + (nb_fifo + 1) * WS2812_CYCLES_PAR_OCTET_UART
+                         + WS2812_T_RESET * (ESP8266_CLOCK_FREQ / 1000000);
+        WS2812_Envoi_En_Cours = false;
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ *  =============================================================================================================================================
+ *  Titre    : WS2812_esp8266.h
+ *  Auteur   : Thomas Broussard
+ *  Projet   : Industrialisation ESP8266
+ *  Création : Octobre 2018
+ *  ---------------------------------------------------------------------------------------------------------------------------------------------
+ *  Description :
+ *  Pilotage des rubans de LED adressables WS2812 par la sortie TX de l'UART1 (GPIO2)
+ *
+ *  L'UART1 est configurée à 3.2 Mbauds, 6 bits de données, sortie TX inversée :
+ *  une trame UART (start + 6 bits + stop = 8 x 312.5ns) code exactement 2 bits WS2812 (2 x 1.25us).
+ *  Chaque paire de bits est traduite en un octet UART par une table de 4 valeurs.
+ *  Les octets sont fournis à la fifo TX par l'interruption "fifo TX vide" : l'envoi d'une trame
+ *  ne coûte presque aucun temps processeur et ne masque jamais les interruptions.
+ *
+ *  Lien utile : https://github.com/Makuna/NeoPixelBus (méthode "UART")
+ * =============================================================================================================================================
+ */
+
+#ifndef __WS2812_ESP8266_H__
+#define __WS2812_ESP8266_H__
+
+// Dépendances
+#include "registres_esp8266.h"
+#include "UART_esp8266.h"
+
+// ##########################################################################################################################
+//                                     DEFINE ET VARIABLES GLOBALES
+// ##########################################################################################################################
+
+// Nombre maximal de LED pilotées
+#define WS2812_NB_LEDS_MAX 300
+
+// Paramètres de l'UART1
+#define WS2812_BAUDS 3200000
+#define WS2812_CYCLES_PAR_OCTET_UART 200 // 8 bits UART à 3.2 Mbauds = 2.5us
+
+// Seuil de l'interruption "fifo TX vide" (octets restants dans la fifo)
+#define WS2812_SEUIL_FIFO 32
+
+// Durée minimale de la ligne à l'état bas pour valider une trame (us)
+#define WS2812_T_RESET 300
+
+// ##########################################################################################################################
+//                                              FONCTIONS WS2812
+// ##########################################################################################################################
+
+/*===============================================================================
+  FONCTION      : init_WS2812
+  DESCRIPTION   : initialise l'UART1 pour piloter un ruban de LED WS2812 sur GPIO2
+                  (toutes les LED sont éteintes, luminosité maximale, correction gamma active)
+  PARAMETRES    : Nombre de LED du ruban (WS2812_NB_LEDS_MAX au maximum)
+  RETOUR        : rien
+===============================================================================*/
+void init_WS2812(uint16 nb_leds);
+
+/*===============================================================================
+  FONCTION      : WS2812_Set_Pixel
+  DESCRIPTION   : Modifie la couleur d'une LED dans l'image en mémoire
+                  (prise en compte au prochain appel de WS2812_Afficher)
+  PARAMETRES    : N° de la LED, composantes rouge, verte et bleue (0 à 255)
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Set_Pixel(uint16 index, uint8 rouge, uint8 vert, uint8 bleu);
+
+/*===============================================================================
+  FONCTION      : WS2812_Remplir
+  DESCRIPTION   : Applique la même couleur à toutes les LED de l'image en mémoire
+  PARAMETRES    : composantes rouge, verte et bleue (0 à 255)
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Remplir(uint8 rouge, uint8 vert, uint8 bleu);
+
+/*===============================================================================
+  FONCTION      : WS2812_Set_Luminosite
+  DESCRIPTION   : Définit la luminosité globale du ruban
+                  (recalcule la table de correction appliquée à chaque composante)
+  PARAMETRES    : Luminosité (0 à 255)
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Set_Luminosite(uint8 luminosite);
+
+/*===============================================================================
+  FONCTION      : WS2812_Set_Gamma
+  DESCRIPTION   : Active ou désactive la correction gamma (2.8)
+  PARAMETRES    : true pour activer la correction
+  RETOUR        : rien
+===============================================================================*/
+void WS2812_Set_Gamma(bool gamma);
+
+/*===============================================================================
+  FONCTION      : WS2812_Afficher
+  DESCRIPTION   : Démarre l'envoi de l'image en mémoire vers le ruban
+                  (l'envoi se poursuit sous interruption)
+  PARAMETRES    : aucun
+  RETOUR        : true si l'envoi a démarré, false si la trame précédente
+                  n'est pas terminée
+===============================================================================*/
+bool WS2812_Afficher();
+
+/*===============================================================================
+  FONCTION      : WS2812_Pret
+  DESCRIPTION   : Indique si une nouvelle trame peut être envoyée
+                  (trame précédente transmise et temps de reset écoulé)
+  PARAMETRES    : aucun
+  RETOUR        : true si le ruban est prêt
+===============================================================================*/
+bool WS2812_Pret();
+
+/*===============================================================================
+  FONCTION      : Interruption_WS2812
+  DESCRIPTION   : Interruption UART1 "fifo TX vide" : complète la fifo
+  PARAMETRES    : N° de l'UART, interruptions actives
+  RETOUR        : rien
+===============================================================================*/
+void ICACHE_RAM_ATTR Interruption_WS2812(uint8 UART, uint32 statut);
+
+/* fin du fichier */
+#endif